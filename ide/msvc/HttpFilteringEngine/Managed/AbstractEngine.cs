@@ -38,6 +38,38 @@ namespace HttpFilteringEngine.Managed
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         protected delegate void NativeHttpMessageEndCallback([In()] [MarshalAs(UnmanagedType.LPStr)] string requestHeaders, uint requestHeadersLength, [In()] IntPtr requestBody, uint requestBodyLength, [In()] [MarshalAs(UnmanagedType.LPStr)] string responseHeaders, uint responseHeadersLength, [In()] IntPtr responseBody, uint responseBodyLength, ref bool shouldBlock, NativeCustomResponseStreamWriter customBlockResponseStreamWriter);
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        protected delegate void NativeHttpMessageChunkCallback([In()] [MarshalAs(UnmanagedType.LPStr)] string requestHeaders, uint requestHeadersLength, [In()] [MarshalAs(UnmanagedType.LPStr)] string responseHeaders, uint responseHeadersLength, [In()] IntPtr chunk, uint chunkLength, [MarshalAs(UnmanagedType.I1)] bool isFinalChunk, ref uint nextAction, NativeCustomResponseStreamWriter customBlockResponseStreamWriter);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        protected delegate void NativeCustomResponseBufferRelease(IntPtr data, uint dataLength);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        protected delegate void NativeHttpMessageBeginCallbackV2(IntPtr context, ref uint nextAction);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        protected delegate void NativeHttpMessageEndCallbackV2(IntPtr context, [MarshalAs(UnmanagedType.I1)] ref bool shouldBlock);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        protected delegate void NativeHttpMessageChunkCallbackV2(IntPtr context, [In()] IntPtr chunk, uint chunkLength, [MarshalAs(UnmanagedType.I1)] bool isFinalChunk, ref uint nextAction);
+
+        /// <summary>
+        /// Mirrors HttpFilteringRule, as passed to fe_ctl_load_rules. The strings are not null
+        /// terminated, and must stay pinned for the duration of the call.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        protected struct NativeHttpFilteringRule
+        {
+            public uint action;
+            public IntPtr hostSuffix;
+            public uint hostSuffixLength;
+            public IntPtr method;
+            public uint methodLength;
+            public uint mediaKinds;
+            public ulong minContentLength;
+            public ulong maxContentLength;
+        }
+
         public static AbstractEngine Create(string caBundleAbsPath, ushort preferredHttpListeningPort = 0, ushort preferredHttpsListeningPort = 0)
         {            
             if(Environment.OSVersion.Platform == PlatformID.Win32NT)
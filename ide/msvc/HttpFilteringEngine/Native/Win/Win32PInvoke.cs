@@ -103,6 +103,137 @@ namespace HttpFilteringEngine.Native.Win
             public static extern IntPtr fe_ctl_create([MarshalAs(UnmanagedType.FunctionPtr)] NativeFirewallCheckCallback firewallCb, [In()] [MarshalAs(UnmanagedType.LPStr)] string caBundleAbsolutePath, uint caBundleAbsolutePathLength, ushort httpListenerPort, ushort httpsListenerPort, uint numThreads, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageBeginCallback onMessageBegin, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageEndCallback onMessageEnd, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onInfo, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onWarn, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onError);
 
 
+            /// Return Type: PVOID->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_create_ex", CallingConvention = CallingConvention.Cdecl)]
+            public static extern IntPtr fe_ctl_create_ex([MarshalAs(UnmanagedType.FunctionPtr)] NativeFirewallCheckCallback firewallCb, [In()] [MarshalAs(UnmanagedType.LPStr)] string caBundleAbsolutePath, uint caBundleAbsolutePathLength, ushort httpListenerPort, ushort httpsListenerPort, uint numThreads, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageBeginCallback onMessageBegin, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageEndCallback onMessageEnd, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageChunkCallback onMessageChunk, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onInfo, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onWarn, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onError);
+
+
+            /// Return Type: PVOID->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_create_v2", CallingConvention = CallingConvention.Cdecl)]
+            public static extern IntPtr fe_ctl_create_v2([MarshalAs(UnmanagedType.FunctionPtr)] NativeFirewallCheckCallback firewallCb, [In()] [MarshalAs(UnmanagedType.LPStr)] string caBundleAbsolutePath, uint caBundleAbsolutePathLength, ushort httpListenerPort, ushort httpsListenerPort, uint numThreads, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageBeginCallbackV2 onMessageBegin, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageEndCallbackV2 onMessageEnd, [MarshalAs(UnmanagedType.FunctionPtr)] NativeHttpMessageChunkCallbackV2 onMessageChunk, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onInfo, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onWarn, [MarshalAs(UnmanagedType.FunctionPtr)] NativeReportMessageCallback onError);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///method: char**
+            ///methodLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_method", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_method(IntPtr context, ref IntPtr method, ref uint methodLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///host: char**
+            ///hostLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_host", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_host(IntPtr context, ref IntPtr host, ref uint hostLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///path: char**
+            ///pathLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_path", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_path(IntPtr context, ref IntPtr path, ref uint pathLength);
+
+
+            /// Return Type: boolean
+            ///context: HttpTransactionContext->void*
+            ///name: char*
+            ///nameLength: uint32_t
+            ///value: char**
+            ///valueLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_request_header", CallingConvention = CallingConvention.Cdecl)]
+            [return: MarshalAs(UnmanagedType.I1)]
+            public static extern bool fe_ctx_get_request_header(IntPtr context, [In()] [MarshalAs(UnmanagedType.LPStr)] string name, uint nameLength, ref IntPtr value, ref uint valueLength);
+
+
+            /// Return Type: boolean
+            ///context: HttpTransactionContext->void*
+            ///name: char*
+            ///nameLength: uint32_t
+            ///value: char**
+            ///valueLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_response_header", CallingConvention = CallingConvention.Cdecl)]
+            [return: MarshalAs(UnmanagedType.I1)]
+            public static extern bool fe_ctx_get_response_header(IntPtr context, [In()] [MarshalAs(UnmanagedType.LPStr)] string name, uint nameLength, ref IntPtr value, ref uint valueLength);
+
+
+            /// Return Type: uint32_t->unsigned int
+            ///context: HttpTransactionContext->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_media_kinds", CallingConvention = CallingConvention.Cdecl)]
+            public static extern uint fe_ctx_get_media_kinds(IntPtr context);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///payload: char**
+            ///payloadLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_request_payload", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_request_payload(IntPtr context, ref IntPtr payload, ref uint payloadLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///payload: char**
+            ///payloadLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_response_payload", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_response_payload(IntPtr context, ref IntPtr payload, ref uint payloadLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///headers: char**
+            ///headersLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_request_headers", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_request_headers(IntPtr context, ref IntPtr headers, ref uint headersLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///headers: char**
+            ///headersLength: uint32_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_get_response_headers", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_get_response_headers(IntPtr context, ref IntPtr headers, ref uint headersLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///data: char*
+            ///dataLength: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_write_block_response", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_write_block_response(IntPtr context, [In()] byte[] data, uint dataLength);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///capacity: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_reserve_block_response", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_reserve_block_response(IntPtr context, uint capacity);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///data: char*
+            ///dataLength: uint32_t
+            ///release: CustomResponseBufferRelease
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_give_block_response", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_give_block_response(IntPtr context, IntPtr data, uint dataLength, [MarshalAs(UnmanagedType.FunctionPtr)] NativeCustomResponseBufferRelease release);
+
+
+            /// Return Type: uint64_t->unsigned long long
+            ///context: HttpTransactionContext->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_defer_verdict", CallingConvention = CallingConvention.Cdecl)]
+            public static extern ulong fe_ctx_defer_verdict(IntPtr context);
+
+
+            /// Return Type: void
+            ///context: HttpTransactionContext->void*
+            ///ttlMilliseconds: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctx_cache_verdict", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctx_cache_verdict(IntPtr context, uint ttlMilliseconds);
+
+
             /// Return Type: void
             ///ptr: PVOID*
             [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_destroy", CallingConvention = CallingConvention.Cdecl)]
@@ -153,6 +284,122 @@ namespace HttpFilteringEngine.Native.Win
             ///bufferSize: size_t*
             [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_get_rootca_pem", CallingConvention = CallingConvention.Cdecl)]
             public static extern void fe_ctl_get_rootca_pem(IntPtr ptr, ref IntPtr bufferPP, ref uint bufferSize);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///perThread: boolean
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_io_service_per_thread", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_io_service_per_thread(IntPtr ptr, [MarshalAs(UnmanagedType.I1)] bool perThread);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///minimumSeverity: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_minimum_event_severity", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_minimum_event_severity(IntPtr ptr, uint minimumSeverity);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///bufferPP: char**
+            ///bufferSize: size_t*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_get_stats_snapshot", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_get_stats_snapshot(IntPtr ptr, ref IntPtr bufferPP, ref UIntPtr bufferSize);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_clear_firewall_verdicts", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_clear_firewall_verdicts(IntPtr ptr);
+
+
+            /// Return Type: boolean
+            ///ptr: PVOID->void*
+            ///token: uint64_t
+            ///verdict: uint32_t
+            ///blockResponse: char*
+            ///blockResponseLength: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_complete_verdict", CallingConvention = CallingConvention.Cdecl)]
+            [return: MarshalAs(UnmanagedType.I1)]
+            public static extern bool fe_ctl_complete_verdict(IntPtr ptr, ulong token, uint verdict, [In()] byte[] blockResponse, uint blockResponseLength);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///maxPending: uint32_t
+            ///timeoutMilliseconds: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_deferred_verdict_limits", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_deferred_verdict_limits(IntPtr ptr, uint maxPending, uint timeoutMilliseconds);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_clear_verdict_cache", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_clear_verdict_cache(IntPtr ptr);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///host: char*
+            ///hostLength: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_invalidate_cached_verdicts", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_invalidate_cached_verdicts(IntPtr ptr, [In()] [MarshalAs(UnmanagedType.LPStr)] string host, uint hostLength);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///maxEntries: uint32_t
+            ///keyByMethod: boolean
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_verdict_cache_limits", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_verdict_cache_limits(IntPtr ptr, uint maxEntries, [MarshalAs(UnmanagedType.I1)] bool keyByMethod);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///spillThreshold: uint32_t
+            ///maxBytesInMemory: uint64_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_payload_spill_limits", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_payload_spill_limits(IntPtr ptr, uint spillThreshold, ulong maxBytesInMemory);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///level: int32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_compression_level", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_compression_level(IntPtr ptr, int level);
+
+
+            /// Return Type: boolean
+            ///ptr: PVOID->void*
+            ///rules: HttpFilteringRule*
+            ///ruleCount: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_load_rules", CallingConvention = CallingConvention.Cdecl)]
+            [return: MarshalAs(UnmanagedType.I1)]
+            public static extern bool fe_ctl_load_rules(IntPtr ptr, [In()] NativeHttpFilteringRule[] rules, uint ruleCount);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///hosts: char*
+            ///hostsLength: uint32_t
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_sni_exemptions", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_sni_exemptions(IntPtr ptr, [In()] [MarshalAs(UnmanagedType.LPStr)] string hosts, uint hostsLength);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///enabled: boolean
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_port_independent_diversion", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_port_independent_diversion(IntPtr ptr, [MarshalAs(UnmanagedType.I1)] bool enabled);
+
+
+            /// Return Type: void
+            ///ptr: PVOID->void*
+            ///enabled: boolean
+            [DllImport(@"x86\HttpFilteringEngine.dll", EntryPoint = "fe_ctl_set_http2_enabled", CallingConvention = CallingConvention.Cdecl)]
+            public static extern void fe_ctl_set_http2_enabled(IntPtr ptr, [MarshalAs(UnmanagedType.I1)] bool enabled);
+
         }
     }
 }
@@ -0,0 +1,1010 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Replays recorded traffic through the parts of the engine that every flow pays
+// for, without diverting anything, so that changes to them can be measured
+// offline. Usage:
+//
+//     HttpFilteringEngineBenchmark.exe [corpus directory] [passes]
+//
+// The corpus directory holds one message per file. Files ending in .request and
+// .response hold a raw HTTP/1.x message, headers and payload exactly as they were
+// received. Files ending in .hello hold the first bytes a TLS client sent,
+// starting at the record header. Files ending in .pem hold an upstream
+// certificate to spoof. Kinds the directory has none of, or all of them when no
+// directory is given, are replaced by a built in synthetic corpus.
+//
+// Every corpus entry is replayed once per pass. For each operation, the wall
+// time, the bytes fed to it and the allocations made during it are recorded.
+// Allocations are those made through operator new and through OpenSSL's
+// allocator; http_parser and the CRT allocate with malloc and aren't seen.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+// The engine is built with BOOST_ASIO_SEPARATE_COMPILATION, so the asio sources
+// have to be built exactly once in this program too. See the same includes in
+// HttpFilteringEngineControl.cpp.
+#include <boost/asio/impl/src.hpp>
+#include <boost/asio/ssl/impl/src.hpp>
+
+#include "../httpengine/mitm/http/HttpRequest.hpp"
+#include "../httpengine/mitm/http/HttpResponse.hpp"
+#include "../httpengine/mitm/secure/WindowsInMemoryCertificateStore.hpp"
+#include "../httpengine/util/tls/ClientHello.hpp"
+
+#include <windows.h>
+
+namespace
+{
+	std::atomic<uint64_t> s_allocations{ 0 };
+
+	std::atomic<uint64_t> s_allocatedBytes{ 0 };
+
+	inline void* CountedMalloc(const size_t size)
+	{
+		++s_allocations;
+		s_allocatedBytes += size;
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* CountedCryptoMalloc(size_t size)
+	{
+		return CountedMalloc(size);
+	}
+
+	void* CountedCryptoRealloc(void* ptr, size_t size)
+	{
+		++s_allocations;
+		s_allocatedBytes += size;
+		return std::realloc(ptr, size);
+	}
+
+	void CountedCryptoFree(void* ptr)
+	{
+		std::free(ptr);
+	}
+
+	/// <summary>
+	/// OpenSSL only takes an allocator before it has allocated anything, and the
+	/// asio ssl sources included above initialize OpenSSL from a static object. This
+	/// is put in the lib segment so that it's constructed before that one.
+	/// </summary>
+	struct CryptoAllocatorInstaller
+	{
+		CryptoAllocatorInstaller()
+		{
+			Installed = CRYPTO_set_mem_functions(&CountedCryptoMalloc, &CountedCryptoRealloc, &CountedCryptoFree) != 0;
+		}
+
+		bool Installed = false;
+	};
+
+	#ifdef _MSC_VER
+		#pragma warning(push)
+		#pragma warning(disable:4073)
+		#pragma init_seg(lib)
+	#endif
+
+	CryptoAllocatorInstaller s_cryptoAllocator;
+
+	#ifdef _MSC_VER
+		#pragma warning(pop)
+	#endif
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = CountedMalloc(size);
+
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace bench
+		{
+
+			namespace
+			{
+				/// <summary>
+				/// Exposes the conversion that the response does for itself once the whole
+				/// of a consumed payload has arrived, so that it can be measured on its own.
+				/// </summary>
+				class ReplayedResponse : public mitm::http::HttpResponse
+				{
+
+				public:
+
+					using mitm::http::BaseHttpTransaction::ConvertPayloadFromChunkedToFixedLength;
+
+				};
+
+				/// <summary>
+				/// What was measured for a single operation over every pass.
+				/// </summary>
+				struct BenchmarkResult
+				{
+					std::string Name;
+
+					uint64_t Operations = 0;
+
+					uint64_t Failures = 0;
+
+					uint64_t Bytes = 0;
+
+					uint64_t Allocations = 0;
+
+					uint64_t AllocatedBytes = 0;
+
+					std::chrono::nanoseconds Elapsed{ 0 };
+				};
+
+				/// <summary>
+				/// Everything the benchmarks replay.
+				/// </summary>
+				struct Corpus
+				{
+					std::vector<std::vector<char>> Requests;
+
+					std::vector<std::vector<char>> Responses;
+
+					std::vector<std::vector<char>> ClientHellos;
+
+					std::vector<std::vector<char>> Certificates;
+				};
+
+				/// <summary>
+				/// Runs the supplied operation once, adding its time, size and allocations
+				/// to the supplied result.
+				/// </summary>
+				/// <param name="result">
+				/// The result to add to.
+				/// </param>
+				/// <param name="bytes">
+				/// The number of bytes the operation works through.
+				/// </param>
+				/// <param name="operation">
+				/// The operation, returning true on success.
+				/// </param>
+				template<typename Operation>
+				void Measure(BenchmarkResult& result, const size_t bytes, Operation&& operation)
+				{
+					const uint64_t allocations = s_allocations;
+					const uint64_t allocatedBytes = s_allocatedBytes;
+					const auto started = std::chrono::steady_clock::now();
+
+					const bool succeeded = operation();
+
+					result.Elapsed += std::chrono::steady_clock::now() - started;
+					result.Allocations += s_allocations - allocations;
+					result.AllocatedBytes += s_allocatedBytes - allocatedBytes;
+					result.Bytes += bytes;
+					++result.Operations;
+
+					if (!succeeded)
+					{
+						++result.Failures;
+					}
+				}
+
+				void PrintResults(const std::vector<BenchmarkResult>& results)
+				{
+					std::cout << std::left << std::setw(64) << "operation"
+						<< std::right << std::setw(10) << "ops"
+						<< std::setw(8) << "failed"
+						<< std::setw(12) << "ns/op"
+						<< std::setw(10) << "MB/s"
+						<< std::setw(12) << "allocs/op"
+						<< std::setw(12) << "bytes/op" << std::endl;
+
+					for (const auto& result : results)
+					{
+						if (result.Operations == 0)
+						{
+							continue;
+						}
+
+						const double nanoseconds = static_cast<double>(result.Elapsed.count());
+						const double operations = static_cast<double>(result.Operations);
+						const double megabytesPerSecond = nanoseconds > 0 ? (static_cast<double>(result.Bytes) / 1048576.0) / (nanoseconds / 1e9) : 0;
+
+						std::cout << std::left << std::setw(64) << result.Name
+							<< std::right << std::setw(10) << result.Operations
+							<< std::setw(8) << result.Failures
+							<< std::fixed << std::setprecision(0) << std::setw(12) << (nanoseconds / operations)
+							<< std::setprecision(1) << std::setw(10) << megabytesPerSecond
+							<< std::setprecision(2) << std::setw(12) << (static_cast<double>(result.Allocations) / operations)
+							<< std::setprecision(0) << std::setw(12) << (static_cast<double>(result.AllocatedBytes) / operations)
+							<< std::endl;
+					}
+				}
+
+				const bool EndsWith(const std::string& value, const std::string& suffix)
+				{
+					return value.size() >= suffix.size() && std::equal(suffix.rbegin(), suffix.rend(), value.rbegin(), [](const char a, const char b)
+					{
+						return ::tolower(static_cast<unsigned char>(a)) == ::tolower(static_cast<unsigned char>(b));
+					});
+				}
+
+				std::vector<char> ReadFile(const std::string& path)
+				{
+					std::ifstream file(path, std::ios::binary);
+
+					if (!file)
+					{
+						throw std::runtime_error(u8"In ReadFile(const std::string&) - Failed to open " + path);
+					}
+
+					return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+				}
+
+				void LoadCorpus(const std::string& directory, Corpus& corpus)
+				{
+					WIN32_FIND_DATAA found;
+
+					HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &found);
+
+					if (search == INVALID_HANDLE_VALUE)
+					{
+						throw std::runtime_error(u8"In LoadCorpus(const std::string&, Corpus&) - Failed to list " + directory);
+					}
+
+					do
+					{
+						if ((found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+						{
+							continue;
+						}
+
+						const std::string name(found.cFileName);
+						const std::string path = directory + "\\" + name;
+
+						if (EndsWith(name, ".request"))
+						{
+							corpus.Requests.push_back(ReadFile(path));
+						}
+						else if (EndsWith(name, ".response"))
+						{
+							corpus.Responses.push_back(ReadFile(path));
+						}
+						else if (EndsWith(name, ".hello"))
+						{
+							corpus.ClientHellos.push_back(ReadFile(path));
+						}
+						else if (EndsWith(name, ".pem"))
+						{
+							corpus.Certificates.push_back(ReadFile(path));
+						}
+					} while (FindNextFileA(search, &found));
+
+					FindClose(search);
+				}
+
+				void Append(std::vector<char>& message, const std::string& value)
+				{
+					message.insert(message.end(), value.begin(), value.end());
+				}
+
+				std::vector<char> Gzip(const std::string& payload)
+				{
+					std::vector<char> compressed;
+
+					{
+						boost::iostreams::filtering_ostream compressor;
+						compressor.push(boost::iostreams::gzip_compressor());
+						compressor.push(boost::iostreams::back_inserter(compressed));
+						compressor.write(payload.data(), payload.size());
+					}
+
+					return compressed;
+				}
+
+				std::vector<char> Chunk(const std::vector<char>& payload, const size_t chunkSize)
+				{
+					std::vector<char> chunked;
+
+					for (size_t offset = 0; offset < payload.size(); offset += chunkSize)
+					{
+						const size_t length = (std::min)(chunkSize, payload.size() - offset);
+
+						char header[32];
+						std::snprintf(header, sizeof(header), "%zx\r\n", length);
+						Append(chunked, header);
+						chunked.insert(chunked.end(), payload.begin() + offset, payload.begin() + offset + length);
+						Append(chunked, "\r\n");
+					}
+
+					Append(chunked, "0\r\n\r\n");
+
+					return chunked;
+				}
+
+				std::vector<char> MakeResponse(const std::string& headers, const std::vector<char>& payload)
+				{
+					std::vector<char> response;
+
+					Append(response, headers);
+					response.insert(response.end(), payload.begin(), payload.end());
+
+					return response;
+				}
+
+				void PutUint8(std::vector<char>& hello, const uint8_t value)
+				{
+					hello.push_back(static_cast<char>(value));
+				}
+
+				void PutUint16(std::vector<char>& hello, const uint16_t value)
+				{
+					PutUint8(hello, static_cast<uint8_t>(value >> 8));
+					PutUint8(hello, static_cast<uint8_t>(value));
+				}
+
+				/// <summary>
+				/// Reserves a big-endian length of the supplied width, to be filled in by
+				/// ::EndLength(...) once what it covers has been written.
+				/// </summary>
+				const size_t BeginLength(std::vector<char>& hello, const size_t width)
+				{
+					hello.insert(hello.end(), width, 0);
+					return hello.size();
+				}
+
+				void EndLength(std::vector<char>& hello, const size_t start, const size_t width)
+				{
+					size_t length = hello.size() - start;
+
+					for (size_t i = 0; i < width; ++i)
+					{
+						hello[start - 1 - i] = static_cast<char>(length & 0xFF);
+						length >>= 8;
+					}
+				}
+
+				std::vector<char> MakeClientHello(const std::string& serverName, const size_t paddingLength)
+				{
+					std::vector<char> hello;
+
+					// Record header.
+					PutUint8(hello, 22);
+					PutUint16(hello, 0x0301);
+					const size_t record = BeginLength(hello, 2);
+
+					// Handshake header.
+					PutUint8(hello, 1);
+					const size_t handshake = BeginLength(hello, 3);
+
+					PutUint16(hello, 0x0303);
+					hello.insert(hello.end(), 32, 0x5A);
+
+					PutUint8(hello, 32);
+					hello.insert(hello.end(), 32, 0x3C);
+
+					static const uint16_t CipherSuites[] = {
+						0x1301, 0x1302, 0x1303, 0xC02B, 0xC02F, 0xC02C, 0xC030, 0xCCA9,
+						0xCCA8, 0xC013, 0xC014, 0x009C, 0x009D, 0x002F, 0x0035, 0x000A
+					};
+
+					PutUint16(hello, static_cast<uint16_t>(sizeof(CipherSuites)));
+
+					for (const auto suite : CipherSuites)
+					{
+						PutUint16(hello, suite);
+					}
+
+					PutUint8(hello, 1);
+					PutUint8(hello, 0);
+
+					const size_t extensions = BeginLength(hello, 2);
+
+					// Things a browser sends ahead of the server name, so that finding it
+					// takes a walk over them.
+					PutUint16(hello, 0xFF01);
+					PutUint16(hello, 1);
+					PutUint8(hello, 0);
+
+					PutUint16(hello, 0x000A);
+					PutUint16(hello, 8);
+					PutUint16(hello, 6);
+					PutUint16(hello, 0x001D);
+					PutUint16(hello, 0x0017);
+					PutUint16(hello, 0x0018);
+
+					PutUint16(hello, 0x000B);
+					PutUint16(hello, 2);
+					PutUint8(hello, 1);
+					PutUint8(hello, 0);
+
+					// Server name, as per RFC 6066 section 3.
+					PutUint16(hello, 0x0000);
+					const size_t serverNameExtension = BeginLength(hello, 2);
+					const size_t serverNameList = BeginLength(hello, 2);
+					PutUint8(hello, 0);
+					PutUint16(hello, static_cast<uint16_t>(serverName.size()));
+					Append(hello, serverName);
+					EndLength(hello, serverNameList, 2);
+					EndLength(hello, serverNameExtension, 2);
+
+					// ALPN, as per RFC 7301.
+					PutUint16(hello, 0x0010);
+					const size_t alpnExtension = BeginLength(hello, 2);
+					const size_t alpnList = BeginLength(hello, 2);
+					PutUint8(hello, 2);
+					Append(hello, "h2");
+					PutUint8(hello, 8);
+					Append(hello, "http/1.1");
+					EndLength(hello, alpnList, 2);
+					EndLength(hello, alpnExtension, 2);
+
+					PutUint16(hello, 0x000D);
+					PutUint16(hello, 10);
+					PutUint16(hello, 8);
+					PutUint16(hello, 0x0403);
+					PutUint16(hello, 0x0804);
+					PutUint16(hello, 0x0401);
+					PutUint16(hello, 0x0503);
+
+					if (paddingLength > 0)
+					{
+						PutUint16(hello, 0x0015);
+						PutUint16(hello, static_cast<uint16_t>(paddingLength));
+						hello.insert(hello.end(), paddingLength, 0);
+					}
+
+					EndLength(hello, extensions, 2);
+					EndLength(hello, handshake, 3);
+					EndLength(hello, record, 2);
+
+					return hello;
+				}
+
+				void AddSyntheticRequests(Corpus& corpus)
+				{
+					static const std::string BrowserHeaders =
+						u8"Host: www.example.com\r\n"
+						u8"User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/61.0.3163.100 Safari/537.36\r\n"
+						u8"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,image/apng,*/*;q=0.8\r\n"
+						u8"Accept-Encoding: gzip, deflate, br\r\n"
+						u8"Accept-Language: en-US,en;q=0.8\r\n"
+						u8"Cookie: session=6f1d2c9a0b7e4f3a8c5d; preferences=theme%3Ddark%26lang%3Den; _ga=GA1.2.1234567890.1508000000\r\n"
+						u8"Referer: https://www.example.com/articles/index.html\r\n"
+						u8"Connection: keep-alive\r\n";
+
+					std::vector<char> get;
+					Append(get, u8"GET /articles/2017/10/benchmarking.html?utm_source=feed&utm_medium=rss HTTP/1.1\r\n");
+					Append(get, BrowserHeaders);
+					Append(get, u8"Upgrade-Insecure-Requests: 1\r\n\r\n");
+					corpus.Requests.push_back(std::move(get));
+
+					const std::string json = u8"{\"query\":\"http filtering engine\",\"page\":2,\"filters\":[\"news\",\"video\"],\"safe\":true}";
+
+					std::vector<char> post;
+					Append(post, u8"POST /api/search HTTP/1.1\r\n");
+					Append(post, BrowserHeaders);
+					Append(post, u8"Content-Type: application/json\r\n");
+					Append(post, u8"Content-Length: " + std::to_string(json.size()) + u8"\r\n\r\n");
+					Append(post, json);
+					corpus.Requests.push_back(std::move(post));
+				}
+
+				void AddSyntheticResponses(Corpus& corpus)
+				{
+					std::string html = u8"<!DOCTYPE html><html><head><title>Benchmark</title></head><body>";
+
+					while (html.size() < 65536)
+					{
+						html.append(u8"<p class=\"article\">The quick brown fox jumps over the lazy dog, while the proxy reads every byte of it.</p>\n");
+					}
+
+					html.append(u8"</body></html>");
+
+					const std::vector<char> plain(html.begin(), html.end());
+					const std::vector<char> compressed = Gzip(html);
+
+					static const std::string CommonHeaders =
+						u8"HTTP/1.1 200 OK\r\n"
+						u8"Date: Sat, 14 Oct 2017 12:00:00 GMT\r\n"
+						u8"Server: nginx\r\n"
+						u8"Content-Type: text/html; charset=utf-8\r\n"
+						u8"Cache-Control: private, max-age=0\r\n"
+						u8"Set-Cookie: session=6f1d2c9a0b7e4f3a8c5d; Path=/; HttpOnly\r\n"
+						u8"Vary: Accept-Encoding\r\n"
+						u8"Connection: keep-alive\r\n";
+
+					corpus.Responses.push_back(MakeResponse(CommonHeaders + u8"Content-Length: " + std::to_string(plain.size()) + u8"\r\n\r\n", plain));
+
+					corpus.Responses.push_back(MakeResponse(CommonHeaders + u8"Transfer-Encoding: chunked\r\n\r\n", Chunk(plain, 8192)));
+
+					corpus.Responses.push_back(MakeResponse(CommonHeaders + u8"Content-Encoding: gzip\r\nContent-Length: " + std::to_string(compressed.size()) + u8"\r\n\r\n", compressed));
+
+					corpus.Responses.push_back(MakeResponse(CommonHeaders + u8"Content-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n", Chunk(compressed, 4096)));
+
+					corpus.Responses.push_back(MakeResponse(u8"HTTP/1.1 304 Not Modified\r\nDate: Sat, 14 Oct 2017 12:00:00 GMT\r\nETag: \"5a0c-55b\"\r\nConnection: keep-alive\r\n\r\n", std::vector<char>()));
+				}
+
+				void AddSyntheticClientHellos(Corpus& corpus)
+				{
+					corpus.ClientHellos.push_back(MakeClientHello(u8"www.example.com", 0));
+
+					// Chrome pads its hello out past 512 bytes.
+					corpus.ClientHellos.push_back(MakeClientHello(u8"static.assets.cdn.example-content-delivery.net", 283));
+				}
+
+				/// <summary>
+				/// Makes a self signed certificate shaped like what a site presents, with a
+				/// handful of subject alt names to copy.
+				/// </summary>
+				X509* MakeUpstreamCertificate()
+				{
+					std::unique_ptr<EC_KEY, decltype(&EC_KEY_free)> ecKey(EC_KEY_new_by_curve_name(NID_X9_62_prime256v1), &EC_KEY_free);
+
+					if (ecKey == nullptr || EC_KEY_generate_key(ecKey.get()) != 1)
+					{
+						throw std::runtime_error(u8"In MakeUpstreamCertificate() - Failed to generate EC key.");
+					}
+
+					std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> keyPair(EVP_PKEY_new(), &EVP_PKEY_free);
+
+					if (keyPair == nullptr || EVP_PKEY_assign_EC_KEY(keyPair.get(), ecKey.get()) != 1)
+					{
+						throw std::runtime_error(u8"In MakeUpstreamCertificate() - Failed to assign EC key.");
+					}
+
+					// Owned by the keypair now.
+					ecKey.release();
+
+					X509* certificate = X509_new();
+
+					if (certificate == nullptr)
+					{
+						throw std::runtime_error(u8"In MakeUpstreamCertificate() - Failed to allocate X509.");
+					}
+
+					X509_set_version(certificate, 2);
+					ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+					X509_gmtime_adj(X509_get_notBefore(certificate), 0);
+					X509_gmtime_adj(X509_get_notAfter(certificate), 31536000L);
+					X509_set_pubkey(certificate, keyPair.get());
+
+					X509_NAME* name = X509_get_subject_name(certificate);
+					X509_NAME_add_entry_by_txt(name, "C", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("US"), -1, -1, 0);
+					X509_NAME_add_entry_by_txt(name, "O", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("Example Inc"), -1, -1, 0);
+					X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("www.example.com"), -1, -1, 0);
+					X509_set_issuer_name(certificate, name);
+
+					char altNames[] = "DNS:www.example.com,DNS:example.com,DNS:static.example.com,DNS:api.example.com,DNS:*.cdn.example.com";
+
+					X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name, altNames);
+
+					if (extension == nullptr || X509_add_ext(certificate, extension, -1) != 1)
+					{
+						X509_EXTENSION_free(extension);
+						X509_free(certificate);
+						throw std::runtime_error(u8"In MakeUpstreamCertificate() - Failed to add subject alt names.");
+					}
+
+					X509_EXTENSION_free(extension);
+
+					if (X509_sign(certificate, keyPair.get(), EVP_sha256()) == 0)
+					{
+						X509_free(certificate);
+						throw std::runtime_error(u8"In MakeUpstreamCertificate() - Failed to sign certificate.");
+					}
+
+					return certificate;
+				}
+
+				X509* ReadCertificate(const std::vector<char>& pem)
+				{
+					BIO* bio = BIO_new_mem_buf(const_cast<char*>(pem.data()), static_cast<int>(pem.size()));
+
+					if (bio == nullptr)
+					{
+						throw std::runtime_error(u8"In ReadCertificate(const std::vector<char>&) - Failed to allocate BIO.");
+					}
+
+					X509* certificate = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
+
+					BIO_free(bio);
+
+					if (certificate == nullptr)
+					{
+						throw std::runtime_error(u8"In ReadCertificate(const std::vector<char>&) - Failed to read PEM certificate.");
+					}
+
+					return certificate;
+				}
+
+				/// <summary>
+				/// Feeds the supplied message to the supplied transaction the way a bridge
+				/// does, one read buffer at a time. The headers are fed in a read of their
+				/// own, as peers usually flush them ahead of the payload. When consuming all,
+				/// that is asked for once the headers are complete, which is where the
+				/// engine's callbacks ask for it.
+				/// </summary>
+				const bool Replay(mitm::http::BaseHttpTransaction& transaction, const std::vector<char>& message, const bool consumeAll)
+				{
+					static const char Terminator[] = { '\r', '\n', '\r', '\n' };
+
+					transaction.Reset();
+
+					const auto headersEnd = std::search(message.begin(), message.end(), std::begin(Terminator), std::end(Terminator));
+
+					size_t readEnd = headersEnd == message.end() ? message.size() : static_cast<size_t>(headersEnd - message.begin()) + sizeof(Terminator);
+
+					size_t offset = 0;
+
+					while (offset < message.size())
+					{
+						auto buffer = transaction.GetReadBuffer();
+
+						if (offset == readEnd)
+						{
+							readEnd = message.size();
+						}
+
+						const size_t length = (std::min)(boost::asio::buffer_size(buffer), readEnd - offset);
+
+						std::memcpy(boost::asio::buffer_cast<char*>(buffer), message.data() + offset, length);
+						offset += length;
+
+						const bool hadHeaders = transaction.HeadersComplete();
+
+						if (!transaction.Parse(length))
+						{
+							return false;
+						}
+
+						if (consumeAll && !hadHeaders && transaction.HeadersComplete())
+						{
+							transaction.SetConsumeAllBeforeSending(true);
+						}
+
+						if (transaction.IsPayloadComplete())
+						{
+							return true;
+						}
+					}
+
+					return transaction.IsPayloadComplete();
+				}
+
+				/// <summary>
+				/// Parses the whole of the supplied message in a single read, so that the
+				/// payload is held complete and as received, ready to be converted or
+				/// decompressed.
+				/// </summary>
+				const bool ParseWhole(mitm::http::BaseHttpTransaction& transaction, const std::vector<char>& message)
+				{
+					transaction.Reset();
+
+					auto buffer = util::mem::BufferPool::Shared().Acquire(message.size());
+					std::copy(message.begin(), message.end(), buffer->data());
+
+					transaction.AdoptReadBuffer(std::move(buffer));
+
+					return transaction.Parse(message.size()) && transaction.IsPayloadComplete();
+				}
+
+				void BenchmarkRequests(const Corpus& corpus, const uint32_t passes, std::vector<BenchmarkResult>& results)
+				{
+					BenchmarkResult parse;
+					parse.Name = u8"HttpRequest::Parse";
+
+					BenchmarkResult headers;
+					headers.Name = u8"HttpRequest::HeadersToVector";
+
+					mitm::http::HttpRequest request;
+
+					for (uint32_t pass = 0; pass < passes; ++pass)
+					{
+						for (const auto& message : corpus.Requests)
+						{
+							Measure(parse, message.size(), [&]()
+							{
+								return Replay(request, message, false);
+							});
+
+							size_t headersLength = 0;
+
+							Measure(headers, 0, [&]()
+							{
+								auto vector = request.HeadersToVector();
+								headersLength = vector.size();
+								return headersLength > 0;
+							});
+
+							headers.Bytes += headersLength;
+						}
+					}
+
+					results.push_back(parse);
+					results.push_back(headers);
+				}
+
+				void BenchmarkResponses(const Corpus& corpus, const uint32_t passes, std::vector<BenchmarkResult>& results)
+				{
+					BenchmarkResult parse;
+					parse.Name = u8"HttpResponse::Parse";
+
+					BenchmarkResult consume;
+					consume.Name = u8"HttpResponse::Parse, consuming all (inflate or dechunk)";
+
+					BenchmarkResult headers;
+					headers.Name = u8"HttpResponse::HeadersToVector";
+
+					BenchmarkResult decompress;
+					decompress.Name = u8"BaseHttpTransaction::DecompressPayload";
+
+					BenchmarkResult convert;
+					convert.Name = u8"BaseHttpTransaction::ConvertPayloadFromChunkedToFixedLength";
+
+					ReplayedResponse response;
+
+					for (uint32_t pass = 0; pass < passes; ++pass)
+					{
+						for (const auto& message : corpus.Responses)
+						{
+							Measure(parse, message.size(), [&]()
+							{
+								return Replay(response, message, false);
+							});
+
+							size_t headersLength = 0;
+
+							Measure(headers, 0, [&]()
+							{
+								auto vector = response.HeadersToVector();
+								headersLength = vector.size();
+								return headersLength > 0;
+							});
+
+							headers.Bytes += headersLength;
+
+							Measure(consume, message.size(), [&]()
+							{
+								return Replay(response, message, true);
+							});
+
+							// The payload of a chunked message is held with its framing, which
+							// only the conversion knows to take off, decompressing on the way if
+							// need be. Anything else compressed is decompressed as it is.
+							if (!ParseWhole(response, message))
+							{
+								continue;
+							}
+
+							const size_t payloadLength = response.GetPayload().size();
+
+							if (response.IsPayloadChunked())
+							{
+								Measure(convert, payloadLength, [&]()
+								{
+									return response.ConvertPayloadFromChunkedToFixedLength();
+								});
+							}
+							else if (response.IsPayloadCompressed())
+							{
+								Measure(decompress, payloadLength, [&]()
+								{
+									return response.DecompressPayload();
+								});
+							}
+						}
+					}
+
+					results.push_back(parse);
+					results.push_back(headers);
+					results.push_back(consume);
+					results.push_back(decompress);
+					results.push_back(convert);
+				}
+
+				void BenchmarkClientHellos(const Corpus& corpus, const uint32_t passes, std::vector<BenchmarkResult>& results)
+				{
+					BenchmarkResult find;
+					find.Name = u8"util::tls::FindServerName";
+
+					for (uint32_t pass = 0; pass < passes; ++pass)
+					{
+						for (const auto& hello : corpus.ClientHellos)
+						{
+							Measure(find, hello.size(), [&]()
+							{
+								boost::string_ref serverName;
+								return util::tls::FindServerName(hello.data(), hello.size(), serverName) == util::tls::ClientHelloStatus::ServerNameFound;
+							});
+						}
+					}
+
+					results.push_back(find);
+				}
+
+				void BenchmarkCertificates(const Corpus& corpus, const uint32_t passes, std::vector<BenchmarkResult>& results)
+				{
+					BenchmarkResult mint;
+					mint.Name = u8"BaseInMemoryCertificateStore::GetServerContext, minting";
+
+					BenchmarkResult cached;
+					cached.Name = u8"BaseInMemoryCertificateStore::GetServerContext, cached";
+
+					std::vector<X509*> certificates;
+
+					if (corpus.Certificates.empty())
+					{
+						certificates.push_back(MakeUpstreamCertificate());
+					}
+
+					for (const auto& pem : corpus.Certificates)
+					{
+						certificates.push_back(ReadCertificate(pem));
+					}
+
+					{
+						mitm::secure::WindowsInMemoryCertificateStore store;
+
+						// Without the pool, every mint pays for its own keypair, which is the
+						// worst case on the request path.
+						store.SetKeyPoolDepth(0);
+
+						uint64_t host = 0;
+
+						for (uint32_t pass = 0; pass < passes; ++pass)
+						{
+							for (const auto certificate : certificates)
+							{
+								// A host we haven't spoofed before is a miss, whatever the
+								// certificate names.
+								const std::string hostname = u8"host" + std::to_string(host++) + u8".benchmark.invalid";
+
+								Measure(mint, 0, [&]()
+								{
+									return store.GetServerContext(hostname, certificate) != nullptr;
+								});
+							}
+						}
+
+						const std::string hostname = u8"host0.benchmark.invalid";
+
+						for (uint32_t pass = 0; pass < passes; ++pass)
+						{
+							Measure(cached, 0, [&]()
+							{
+								return store.GetServerContext(hostname, certificates.front()) != nullptr;
+							});
+						}
+					}
+
+					for (const auto certificate : certificates)
+					{
+						X509_free(certificate);
+					}
+
+					results.push_back(mint);
+					results.push_back(cached);
+				}
+
+			} /* anonymous namespace */
+
+		} /* namespace bench */
+	} /* namespace httpengine */
+} /* namespace te */
+
+int main(int argc, char* argv[])
+{
+	using namespace te::httpengine::bench;
+
+	try
+	{
+		Corpus corpus;
+
+		uint32_t passes = 1000;
+
+		if (argc > 1)
+		{
+			LoadCorpus(argv[1], corpus);
+		}
+
+		if (argc > 2)
+		{
+			passes = static_cast<uint32_t>((std::max)(1, std::atoi(argv[2])));
+		}
+
+		if (corpus.Requests.empty())
+		{
+			AddSyntheticRequests(corpus);
+		}
+
+		if (corpus.Responses.empty())
+		{
+			AddSyntheticResponses(corpus);
+		}
+
+		if (corpus.ClientHellos.empty())
+		{
+			AddSyntheticClientHellos(corpus);
+		}
+
+		std::cout << corpus.Requests.size() << " requests, "
+			<< corpus.Responses.size() << " responses, "
+			<< corpus.ClientHellos.size() << " client hellos, "
+			<< (corpus.Certificates.empty() ? 1 : corpus.Certificates.size()) << " certificates, "
+			<< passes << " passes." << std::endl;
+
+		if (!s_cryptoAllocator.Installed)
+		{
+			std::cout << "OpenSSL was initialized before its allocator could be replaced, its allocations aren't counted." << std::endl;
+		}
+
+		std::cout << std::endl;
+
+		std::vector<BenchmarkResult> results;
+
+		BenchmarkRequests(corpus, passes, results);
+		BenchmarkResponses(corpus, passes, results);
+		BenchmarkClientHellos(corpus, passes, results);
+		BenchmarkCertificates(corpus, passes, results);
+
+		PrintResults(results);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
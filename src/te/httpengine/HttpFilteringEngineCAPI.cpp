@@ -9,7 +9,9 @@
 
 #include "HttpFilteringEngineCAPI.h"
 #include "HttpFilteringEngineControl.hpp"
+#include "util/cb/TransactionContext.hpp"
 #include <iostream>
+#include <boost/algorithm/string.hpp>
 
 #include <boost/predef.h>
 
@@ -18,15 +20,20 @@
 #endif
 
 
-PVOID fe_ctl_create(
+/// <summary>
+/// Does the work of fe_ctl_create_ex(...) and fe_ctl_create_v2(...), once the message callbacks are
+/// in the shape the Engine invokes them in.
+/// </summary>
+static PVOID CreateControl(
 	FirewallCheckCallback firewallCb,
 	const char* caBundleAbsolutePath,
 	uint32_t caBundleAbsolutePathLength,
 	uint16_t httpListenerPort,
 	uint16_t httpsListenerPort,
-	uint32_t numThread,	
-	HttpMessageBeginCallback onMessageBegin,
-	HttpMessageEndCallback onMessageEnd,
+	uint32_t numThread,
+	te::httpengine::util::cb::HttpMessageBeginCheckFunction onMessageBegin,
+	te::httpengine::util::cb::HttpMessageEndCheckFunction onMessageEnd,
+	te::httpengine::util::cb::HttpMessageChunkCheckFunction onMessageChunk,
 	ReportMessageCallback onInfo,
 	ReportMessageCallback onWarn,
 	ReportMessageCallback onError
@@ -75,6 +82,7 @@ PVOID fe_ctl_create(
 			numThread,
 			onMessageBegin,
 			onMessageEnd,
+			onMessageChunk,
 			onInfo,
 			onWarn,
 			onError
@@ -96,202 +104,1097 @@ PVOID fe_ctl_create(
 	return inst;
 }
 
-void fe_ctl_destroy(PVOID* ptr)
-{	
-	te::httpengine::HttpFilteringEngineControl* cppPtr = static_cast<te::httpengine::HttpFilteringEngineControl*>(*ptr);
+PVOID fe_ctl_create(
+	FirewallCheckCallback firewallCb,
+	const char* caBundleAbsolutePath,
+	uint32_t caBundleAbsolutePathLength,
+	uint16_t httpListenerPort,
+	uint16_t httpsListenerPort,
+	uint32_t numThread,	
+	HttpMessageBeginCallback onMessageBegin,
+	HttpMessageEndCallback onMessageEnd,
+	ReportMessageCallback onInfo,
+	ReportMessageCallback onWarn,
+	ReportMessageCallback onError
+	)
+{
+	return fe_ctl_create_ex(
+		firewallCb,
+		caBundleAbsolutePath,
+		caBundleAbsolutePathLength,
+		httpListenerPort,
+		httpsListenerPort,
+		numThread,
+		onMessageBegin,
+		onMessageEnd,
+		nullptr,
+		onInfo,
+		onWarn,
+		onError
+		);
+}
 
-	if (cppPtr != nullptr)
-	{		
+PVOID fe_ctl_create_ex(
+	FirewallCheckCallback firewallCb,
+	const char* caBundleAbsolutePath,
+	uint32_t caBundleAbsolutePathLength,
+	uint16_t httpListenerPort,
+	uint16_t httpsListenerPort,
+	uint32_t numThread,
+	HttpMessageBeginCallback onMessageBegin,
+	HttpMessageEndCallback onMessageEnd,
+	HttpMessageChunkCallback onMessageChunk,
+	ReportMessageCallback onInfo,
+	ReportMessageCallback onWarn,
+	ReportMessageCallback onError
+	)
+{
+	using te::httpengine::util::cb::TransactionContext;
 
-		delete cppPtr;
+	// The original callbacks are handed everything up front, so the headers are formatted for
+	// them here. They're also given a writer that takes no context, so they're run with their
+	// context made current on the calling thread, which is where that writer finds it.
+	te::httpengine::util::cb::HttpMessageBeginCheckFunction onMessageBeginFn = nullptr;
+	te::httpengine::util::cb::HttpMessageEndCheckFunction onMessageEndFn = nullptr;
+	te::httpengine::util::cb::HttpMessageChunkCheckFunction onMessageChunkFn = nullptr;
+
+	if (onMessageBegin != nullptr)
+	{
+		onMessageBeginFn = [onMessageBegin](HttpTransactionContext context, uint32_t* nextAction)
+		{
+			auto ctx = static_cast<TransactionContext*>(context);
+			TransactionContext::CurrentScope current(ctx);
+
+			const auto& requestHeaders = ctx->GetRequestHeaders();
+			const auto& responseHeaders = ctx->GetResponseHeaders();
+
+			onMessageBegin(
+				requestHeaders.c_str(), static_cast<uint32_t>(requestHeaders.size()), nullptr, 0,
+				responseHeaders.c_str(), static_cast<uint32_t>(responseHeaders.size()), nullptr, 0,
+				nextAction, &TransactionContext::WriteToCurrent
+				);
+		};
 	}
 
-	*ptr = nullptr;
+	if (onMessageEnd != nullptr)
+	{
+		onMessageEndFn = [onMessageEnd](HttpTransactionContext context, bool* shouldBlock)
+		{
+			auto ctx = static_cast<TransactionContext*>(context);
+			TransactionContext::CurrentScope current(ctx);
 
-	#if BOOST_OS_WINDOWS
-		WSACleanup();
-	#endif
+			const auto& requestHeaders = ctx->GetRequestHeaders();
+			const auto& responseHeaders = ctx->GetResponseHeaders();
+			auto requestBody = ctx->GetRequestPayload();
+			auto responseBody = ctx->GetResponsePayload();
+
+			onMessageEnd(
+				requestHeaders.c_str(), static_cast<uint32_t>(requestHeaders.size()), requestBody.data(), static_cast<uint32_t>(requestBody.size()),
+				responseHeaders.c_str(), static_cast<uint32_t>(responseHeaders.size()), responseBody.data(), static_cast<uint32_t>(responseBody.size()),
+				shouldBlock, &TransactionContext::WriteToCurrent
+				);
+		};
+	}
+
+	if (onMessageChunk != nullptr)
+	{
+		onMessageChunkFn = [onMessageChunk](
+			HttpTransactionContext context,
+			const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+			uint32_t* nextAction
+			)
+		{
+			auto ctx = static_cast<TransactionContext*>(context);
+			TransactionContext::CurrentScope current(ctx);
+
+			const auto& requestHeaders = ctx->GetRequestHeaders();
+			const auto& responseHeaders = ctx->GetResponseHeaders();
+
+			onMessageChunk(
+				requestHeaders.c_str(), static_cast<uint32_t>(requestHeaders.size()),
+				responseHeaders.c_str(), static_cast<uint32_t>(responseHeaders.size()),
+				chunk, chunkLength, isFinalChunk,
+				nextAction, &TransactionContext::WriteToCurrent
+				);
+		};
+	}
+
+	return CreateControl(
+		firewallCb,
+		caBundleAbsolutePath,
+		caBundleAbsolutePathLength,
+		httpListenerPort,
+		httpsListenerPort,
+		numThread,
+		onMessageBeginFn,
+		onMessageEndFn,
+		onMessageChunkFn,
+		onInfo,
+		onWarn,
+		onError
+		);
 }
 
-void fe_ctl_destroy_unsafe(PVOID ptr)
+PVOID fe_ctl_create_v2(
+	FirewallCheckCallback firewallCb,
+	const char* caBundleAbsolutePath,
+	uint32_t caBundleAbsolutePathLength,
+	uint16_t httpListenerPort,
+	uint16_t httpsListenerPort,
+	uint32_t numThread,
+	HttpMessageBeginCallbackV2 onMessageBegin,
+	HttpMessageEndCallbackV2 onMessageEnd,
+	HttpMessageChunkCallbackV2 onMessageChunk,
+	ReportMessageCallback onInfo,
+	ReportMessageCallback onWarn,
+	ReportMessageCallback onError
+	)
 {
-	te::httpengine::HttpFilteringEngineControl* cppPtr = static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr);
+	// Null callbacks have to stay empty, so that the Engine substitutes its own.
+	te::httpengine::util::cb::HttpMessageBeginCheckFunction onMessageBeginFn = nullptr;
+	te::httpengine::util::cb::HttpMessageEndCheckFunction onMessageEndFn = nullptr;
+	te::httpengine::util::cb::HttpMessageChunkCheckFunction onMessageChunkFn = nullptr;
 
-	if (cppPtr != nullptr)
+	if (onMessageBegin != nullptr)
 	{
+		onMessageBeginFn = onMessageBegin;
+	}
 
-		if (cppPtr->IsRunning())
-		{
-			cppPtr->Stop();
-		}
+	if (onMessageEnd != nullptr)
+	{
+		onMessageEndFn = onMessageEnd;
+	}
 
-		delete cppPtr;
+	if (onMessageChunk != nullptr)
+	{
+		onMessageChunkFn = onMessageChunk;
 	}
 
-	#if BOOST_OS_WINDOWS
-		WSACleanup();
+	return CreateControl(
+		firewallCb,
+		caBundleAbsolutePath,
+		caBundleAbsolutePathLength,
+		httpListenerPort,
+		httpsListenerPort,
+		numThread,
+		onMessageBeginFn,
+		onMessageEndFn,
+		onMessageChunkFn,
+		onInfo,
+		onWarn,
+		onError
+		);
+}
+
+/// <summary>
+/// Supplies the fe_ctx_get_* out parameters with the supplied value.
+/// </summary>
+static void SetOutString(const boost::string_ref value, const char** data, uint32_t* dataLength)
+{
+	if (data != nullptr)
+	{
+		*data = value.data();
+	}
+
+	if (dataLength != nullptr)
+	{
+		*dataLength = static_cast<uint32_t>(value.size());
+	}
+}
+
+void fe_ctx_get_method(HttpTransactionContext context, const char** method, uint32_t* methodLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_get_method(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
 	#endif
+
+	SetOutString(context != nullptr ? static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetMethod() : boost::string_ref(), method, methodLength);
 }
 
-const bool fe_ctl_start(PVOID ptr)
+void fe_ctx_get_host(HttpTransactionContext context, const char** host, uint32_t* hostLength)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_start(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_get_host(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	SetOutString(context != nullptr ? static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetHost() : boost::string_ref(), host, hostLength);
+}
+
+void fe_ctx_get_path(HttpTransactionContext context, const char** path, uint32_t* pathLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_get_path(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	SetOutString(context != nullptr ? static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetPath() : boost::string_ref(), path, pathLength);
+}
+
+const bool fe_ctx_get_request_header(HttpTransactionContext context, const char* name, const uint32_t nameLength, const char** value, uint32_t* valueLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_get_request_header(HttpTransactionContext, const char*, const uint32_t, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
+	boost::string_ref found;
+
 	bool success = false;
 
-	if (ptr != nullptr)
+	if (context != nullptr && name != nullptr)
 	{
 		try
 		{
-			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->Start();
-
-			success = true;
+			success = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetRequestHeader(boost::string_ref(name, nameLength), found);
 		}
 		catch (std::exception& e)
 		{
-			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+			std::cout << "error: " << e.what() << std::endl;
 		}
 	}
 
-	assert(success == true && u8"In fe_ctl_start(PVOID) - Caught exception and failed to start.");
+	SetOutString(found, value, valueLength);
 
 	return success;
 }
 
-void fe_ctl_stop(PVOID ptr)
+const bool fe_ctx_get_response_header(HttpTransactionContext context, const char* name, const uint32_t nameLength, const char** value, uint32_t* valueLength)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_stop(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_get_response_header(HttpTransactionContext, const char*, const uint32_t, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
+	boost::string_ref found;
+
 	bool success = false;
 
-	try
+	if (context != nullptr && name != nullptr)
 	{
-		if (ptr != nullptr)
+		try
 		{
-			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->Stop();
-
-			success = true;
-		}		
-	}
-	catch (std::exception& e)
-	{		
-		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+			success = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetResponseHeader(boost::string_ref(name, nameLength), found);
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
 	}
 
-	assert(success == true && u8"In fe_ctl_stop(PVOID) - Caught exception and failed to stop.");
+	SetOutString(found, value, valueLength);
+
+	return success;
 }
 
-const bool fe_ctl_is_running(PVOID ptr)
+uint32_t fe_ctx_get_media_kinds(HttpTransactionContext context)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_is_running(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_get_media_kinds(HttpTransactionContext) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
-	bool success = false;
+	uint32_t kinds = 0;
 
-	try
+	if (context != nullptr)
 	{
-		if (ptr != nullptr)
+		try
 		{
-			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->IsRunning();
-		}		
-	}
-	catch (std::exception& e)
-	{
-		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+			kinds = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetMediaKinds();
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
 	}
 
-	assert(success == true && u8"In fe_ctl_is_running(PVOID) - Caught exception and failed to check status.");
+	return kinds;
+}
 
-	return success;
+void fe_ctx_get_request_payload(HttpTransactionContext context, const char** payload, uint32_t* payloadLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_get_request_payload(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	SetOutString(context != nullptr ? static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetRequestPayload() : boost::string_ref(), payload, payloadLength);
 }
 
-uint16_t fe_ctl_get_http_listener_port(PVOID ptr)
+void fe_ctx_get_response_payload(HttpTransactionContext context, const char** payload, uint32_t* payloadLength)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_get_http_listener_port(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_get_response_payload(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
-	bool success = false;
+	SetOutString(context != nullptr ? static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetResponsePayload() : boost::string_ref(), payload, payloadLength);
+}
 
-	try
+void fe_ctx_get_request_headers(HttpTransactionContext context, const char** headers, uint32_t* headersLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_get_request_headers(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	boost::string_ref formatted;
+
+	if (context != nullptr)
 	{
-		if (ptr != nullptr)
+		try
 		{
-			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetHttpListenerPort();
-		}		
-	}
-	catch (std::exception& e)
-	{
-		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+			formatted = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetRequestHeaders();
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
 	}
 
-	assert(success == true && u8"In fe_ctl_get_http_listener_port(PVOID) - Caught exception and failed to get HTTP listener port.");
-
-	return 0;
+	SetOutString(formatted, headers, headersLength);
 }
 
-uint16_t fe_ctl_get_https_listener_port(PVOID ptr)
+void fe_ctx_get_response_headers(HttpTransactionContext context, const char** headers, uint32_t* headersLength)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_get_https_listener_port(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_get_response_headers(HttpTransactionContext, const char**, uint32_t*) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
-	bool success = false;
+	boost::string_ref formatted;
 
-	try
+	if (context != nullptr)
 	{
-		if (ptr != nullptr)
+		try
 		{
-			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetHttpsListenerPort();
+			formatted = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->GetResponseHeaders();
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
 		}
 	}
-	catch (std::exception& e)
+
+	SetOutString(formatted, headers, headersLength);
+}
+
+void fe_ctx_write_block_response(HttpTransactionContext context, const char* data, const uint32_t dataLength)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_write_block_response(HttpTransactionContext, const char*, const uint32_t) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	if (context != nullptr)
 	{
-		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+		try
+		{
+			static_cast<te::httpengine::util::cb::TransactionContext*>(context)->Write(data, dataLength);
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
 	}
+}
 
-	assert(success == true && u8"In fe_ctl_get_https_listener_port(PVOID) - Caught exception and failed to get HTTPs listener port.");
+void fe_ctx_reserve_block_response(HttpTransactionContext context, const uint32_t capacity)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_reserve_block_response(HttpTransactionContext, const uint32_t) - Supplied HttpTransactionContext is nullptr!");
+	#endif
 
-	return 0;
+	if (context != nullptr)
+	{
+		try
+		{
+			static_cast<te::httpengine::util::cb::TransactionContext*>(context)->Reserve(capacity);
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
+	}
 }
 
-void fe_ctl_get_rootca_pem(PVOID ptr, char** bufferPP, size_t* bufferSize)
+void fe_ctx_give_block_response(HttpTransactionContext context, const char* data, const uint32_t dataLength, CustomResponseBufferRelease release)
 {
 	#ifndef NDEBUG
-		assert(ptr != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied PVOID ptr is nullptr!");
-		assert(bufferPP != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied buffer pointer-to-pointer is nullptr!");
-		assert(bufferSize != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied buffer size pointer is nullptr!");
+		assert(context != nullptr && u8"In fe_ctx_give_block_response(HttpTransactionContext, const char*, const uint32_t, CustomResponseBufferRelease) - Supplied HttpTransactionContext is nullptr!");
 	#endif
 
-	bool callSuccess = false;
-
-	if (ptr && bufferPP && bufferSize)
+	if (context != nullptr)
 	{
 		try
 		{
-			auto ret = static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetRootCertificatePEM();
+			static_cast<te::httpengine::util::cb::TransactionContext*>(context)->Give(data, dataLength, release);
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
+	}
+}
 
-			*bufferSize = ret.size();
+uint64_t fe_ctx_defer_verdict(HttpTransactionContext context)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_defer_verdict(HttpTransactionContext) - Supplied HttpTransactionContext is nullptr!");
+	#endif
 
-			if (*bufferSize > 0)
-			{
-				if ((*bufferPP = static_cast<char*>(malloc(sizeof(ret[0]) * (*bufferSize)))) != nullptr)
-				{
-					std::copy(ret.begin(), ret.end(), (*bufferPP));
-					callSuccess = true;
-				}				
-			}			
+	uint64_t token = 0;
+
+	if (context != nullptr)
+	{
+		try
+		{
+			token = static_cast<te::httpengine::util::cb::TransactionContext*>(context)->Defer();
 		}
 		catch (std::exception& e)
 		{
-			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+			std::cout << "error: " << e.what() << std::endl;
 		}
 	}
 
-	assert(callSuccess == true && u8"In fe_ctl_get_rootca_pem(...) - Caught exception and failed to fetch root CA certificate.");
+	return token;
+}
+
+void fe_ctx_cache_verdict(HttpTransactionContext context, uint32_t ttlMilliseconds)
+{
+	#ifndef NDEBUG
+		assert(context != nullptr && u8"In fe_ctx_cache_verdict(HttpTransactionContext, uint32_t) - Supplied HttpTransactionContext is nullptr!");
+	#endif
+
+	if (context != nullptr)
+	{
+		try
+		{
+			static_cast<te::httpengine::util::cb::TransactionContext*>(context)->CacheVerdict(ttlMilliseconds);
+		}
+		catch (std::exception& e)
+		{
+			std::cout << "error: " << e.what() << std::endl;
+		}
+	}
+}
+
+void fe_ctl_destroy(PVOID* ptr)
+{	
+	te::httpengine::HttpFilteringEngineControl* cppPtr = static_cast<te::httpengine::HttpFilteringEngineControl*>(*ptr);
+
+	if (cppPtr != nullptr)
+	{		
+
+		delete cppPtr;
+	}
+
+	*ptr = nullptr;
+
+	#if BOOST_OS_WINDOWS
+		WSACleanup();
+	#endif
+}
+
+void fe_ctl_destroy_unsafe(PVOID ptr)
+{
+	te::httpengine::HttpFilteringEngineControl* cppPtr = static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr);
+
+	if (cppPtr != nullptr)
+	{
+
+		if (cppPtr->IsRunning())
+		{
+			cppPtr->Stop();
+		}
+
+		delete cppPtr;
+	}
+
+	#if BOOST_OS_WINDOWS
+		WSACleanup();
+	#endif
+}
+
+const bool fe_ctl_start(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_start(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	if (ptr != nullptr)
+	{
+		try
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->Start();
+
+			success = true;
+		}
+		catch (std::exception& e)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+		}
+	}
+
+	assert(success == true && u8"In fe_ctl_start(PVOID) - Caught exception and failed to start.");
+
+	return success;
+}
+
+void fe_ctl_stop(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_stop(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->Stop();
+
+			success = true;
+		}		
+	}
+	catch (std::exception& e)
+	{		
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_stop(PVOID) - Caught exception and failed to stop.");
+}
+
+void fe_ctl_set_io_service_per_thread(PVOID ptr, bool perThread)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_io_service_per_thread(PVOID, bool) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetIoServicePerThread(perThread);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_io_service_per_thread(PVOID, bool) - Caught exception and failed to set io_service mode.");
+}
+
+void fe_ctl_set_minimum_event_severity(PVOID ptr, uint32_t minimumSeverity)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_minimum_event_severity(PVOID, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetMinimumEventSeverity(minimumSeverity);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_minimum_event_severity(PVOID, uint32_t) - Caught exception and failed to set minimum event severity.");
+}
+
+const bool fe_ctl_is_running(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_is_running(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->IsRunning();
+		}		
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_is_running(PVOID) - Caught exception and failed to check status.");
+
+	return success;
+}
+
+uint16_t fe_ctl_get_http_listener_port(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_get_http_listener_port(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetHttpListenerPort();
+		}		
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_get_http_listener_port(PVOID) - Caught exception and failed to get HTTP listener port.");
+
+	return 0;
+}
+
+uint16_t fe_ctl_get_https_listener_port(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_get_https_listener_port(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetHttpsListenerPort();
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_get_https_listener_port(PVOID) - Caught exception and failed to get HTTPs listener port.");
+
+	return 0;
+}
+
+void fe_ctl_get_rootca_pem(PVOID ptr, char** bufferPP, size_t* bufferSize)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied PVOID ptr is nullptr!");
+		assert(bufferPP != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied buffer pointer-to-pointer is nullptr!");
+		assert(bufferSize != nullptr && u8"In fe_ctl_get_rootca_pem(char**, size_t*) - Supplied buffer size pointer is nullptr!");
+	#endif
+
+	bool callSuccess = false;
+
+	if (ptr && bufferPP && bufferSize)
+	{
+		try
+		{
+			auto ret = static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetRootCertificatePEM();
+
+			*bufferSize = ret.size();
+
+			if (*bufferSize > 0)
+			{
+				if ((*bufferPP = static_cast<char*>(malloc(sizeof(ret[0]) * (*bufferSize)))) != nullptr)
+				{
+					std::copy(ret.begin(), ret.end(), (*bufferPP));
+					callSuccess = true;
+				}				
+			}			
+		}
+		catch (std::exception& e)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+		}
+	}
+
+	assert(callSuccess == true && u8"In fe_ctl_get_rootca_pem(...) - Caught exception and failed to fetch root CA certificate.");
+}
+
+void fe_ctl_get_stats_snapshot(PVOID ptr, char** bufferPP, size_t* bufferSize)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_get_stats_snapshot(char**, size_t*) - Supplied PVOID ptr is nullptr!");
+		assert(bufferPP != nullptr && u8"In fe_ctl_get_stats_snapshot(char**, size_t*) - Supplied buffer pointer-to-pointer is nullptr!");
+		assert(bufferSize != nullptr && u8"In fe_ctl_get_stats_snapshot(char**, size_t*) - Supplied buffer size pointer is nullptr!");
+	#endif
+
+	bool callSuccess = false;
+
+	if (ptr && bufferPP && bufferSize)
+	{
+		*bufferSize = 0;
+
+		try
+		{
+			auto ret = static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->GetStatsSnapshot();
+
+			if (ret.size() > 0)
+			{
+				if ((*bufferPP = static_cast<char*>(malloc(sizeof(ret[0]) * ret.size()))) != nullptr)
+				{
+					std::copy(ret.begin(), ret.end(), (*bufferPP));
+					*bufferSize = ret.size();
+					callSuccess = true;
+				}
+			}
+		}
+		catch (std::exception& e)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+		}
+	}
+
+	assert(callSuccess == true && u8"In fe_ctl_get_stats_snapshot(...) - Caught exception and failed to fetch stats snapshot.");
+}
+
+void fe_ctl_clear_firewall_verdicts(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_clear_firewall_verdicts(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ClearFirewallVerdicts();
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_clear_firewall_verdicts(PVOID) - Caught exception and failed to clear firewall verdicts.");
+}
+
+const bool fe_ctl_complete_verdict(PVOID ptr, uint64_t token, uint32_t verdict, const char* blockResponse, uint32_t blockResponseLength)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_complete_verdict(PVOID, uint64_t, uint32_t, const char*, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			return static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->CompleteDeferredVerdict(token, verdict, blockResponse, blockResponseLength);
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	return false;
+}
+
+void fe_ctl_set_deferred_verdict_limits(PVOID ptr, uint32_t maxPending, uint32_t timeoutMilliseconds)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_deferred_verdict_limits(PVOID, uint32_t, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetDeferredVerdictLimits(maxPending, timeoutMilliseconds);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_deferred_verdict_limits(PVOID, uint32_t, uint32_t) - Caught exception and failed to set deferred verdict limits.");
+}
+
+void fe_ctl_clear_verdict_cache(PVOID ptr)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_clear_verdict_cache(PVOID) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ClearVerdictCache();
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_clear_verdict_cache(PVOID) - Caught exception and failed to clear verdict cache.");
+}
+
+void fe_ctl_invalidate_cached_verdicts(PVOID ptr, const char* host, uint32_t hostLength)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_invalidate_cached_verdicts(PVOID, const char*, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->InvalidateCachedVerdicts(std::string(host != nullptr ? host : u8"", host != nullptr ? hostLength : 0));
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_invalidate_cached_verdicts(PVOID, const char*, uint32_t) - Caught exception and failed to invalidate cached verdicts.");
+}
+
+void fe_ctl_set_verdict_cache_limits(PVOID ptr, uint32_t maxEntries, bool keyByMethod)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_verdict_cache_limits(PVOID, uint32_t, bool) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetVerdictCacheLimits(maxEntries, keyByMethod);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_verdict_cache_limits(PVOID, uint32_t, bool) - Caught exception and failed to set verdict cache limits.");
+}
+
+void fe_ctl_set_payload_spill_limits(PVOID ptr, uint32_t spillThreshold, uint64_t maxBytesInMemory)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_payload_spill_limits(PVOID, uint32_t, uint64_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetPayloadSpillLimits(spillThreshold, maxBytesInMemory);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_payload_spill_limits(PVOID, uint32_t, uint64_t) - Caught exception and failed to set payload spill limits.");
+}
+
+void fe_ctl_set_compression_level(PVOID ptr, int32_t level)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_compression_level(PVOID, int32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetCompressionLevel(level);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_compression_level(PVOID, int32_t) - Caught exception and failed to set compression level.");
+}
+
+const bool fe_ctl_load_rules(PVOID ptr, const HttpFilteringRule* rules, uint32_t ruleCount)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_load_rules(PVOID, const HttpFilteringRule*, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr && (rules != nullptr || ruleCount == 0))
+		{
+			std::vector<te::httpengine::util::cb::Rule> loaded;
+			loaded.reserve(ruleCount);
+
+			for (uint32_t i = 0; i < ruleCount; ++i)
+			{
+				const auto& supplied = rules[i];
+
+				if (supplied.action > static_cast<uint32_t>(te::httpengine::util::cb::RuleAction::CallBack))
+				{
+					throw std::runtime_error(u8"In fe_ctl_load_rules(PVOID, const HttpFilteringRule*, uint32_t) - Supplied rule has an unknown action.");
+				}
+
+				te::httpengine::util::cb::Rule rule;
+
+				rule.Action = static_cast<te::httpengine::util::cb::RuleAction>(supplied.action);
+
+				if (supplied.hostSuffix != nullptr)
+				{
+					rule.HostSuffix.assign(supplied.hostSuffix, supplied.hostSuffixLength);
+				}
+
+				if (supplied.method != nullptr)
+				{
+					rule.Method.assign(supplied.method, supplied.methodLength);
+				}
+
+				rule.MediaKinds = te::httpengine::util::http::MediaKindSet(static_cast<unsigned long>(supplied.mediaKinds));
+				rule.MinContentLength = supplied.minContentLength;
+				rule.MaxContentLength = supplied.maxContentLength;
+
+				loaded.push_back(std::move(rule));
+			}
+
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->LoadRules(loaded);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	return success;
+}
+
+void fe_ctl_set_sni_exemptions(PVOID ptr, const char* hosts, uint32_t hostsLength)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_sni_exemptions(PVOID, const char*, uint32_t) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr && (hosts != nullptr || hostsLength == 0))
+		{
+			std::vector<std::string> exemptions;
+
+			if (hostsLength > 0)
+			{
+				const std::string supplied(hosts, hostsLength);
+
+				boost::algorithm::split(exemptions, supplied, boost::algorithm::is_any_of(u8"\r\n"), boost::algorithm::token_compress_on);
+
+				for (auto& host : exemptions)
+				{
+					boost::algorithm::trim(host);
+				}
+			}
+
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetSniExemptions(exemptions);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_sni_exemptions(PVOID, const char*, uint32_t) - Caught exception and failed to set SNI exemptions.");
+}
+
+void fe_ctl_set_port_independent_diversion(PVOID ptr, bool enabled)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_port_independent_diversion(PVOID, bool) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetPortIndependentDiversion(enabled);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_port_independent_diversion(PVOID, bool) - Caught exception and failed to set port independent diversion.");
+}
+
+void fe_ctl_set_http2_enabled(PVOID ptr, bool enabled)
+{
+	#ifndef NDEBUG
+		assert(ptr != nullptr && u8"In fe_ctl_set_http2_enabled(PVOID, bool) - Supplied HttpFilteringEngineCtl ptr is nullptr!");
+	#endif
+
+	bool success = false;
+
+	try
+	{
+		if (ptr != nullptr)
+		{
+			static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->SetHttp2Enabled(enabled);
+
+			success = true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		static_cast<te::httpengine::HttpFilteringEngineControl*>(ptr)->ReportError(e.what());
+	}
+
+	assert(success == true && u8"In fe_ctl_set_http2_enabled(PVOID, bool) - Caught exception and failed to set whether HTTP/2 is enabled.");
 }
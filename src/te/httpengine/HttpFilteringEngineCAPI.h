@@ -104,6 +104,281 @@ extern "C" {
 		ReportMessageCallback onError
 		);
 
+	/// <summary>
+	/// Same as fe_ctl_create(...), with the addition of the callback for streaming content
+	/// inspection. It has its own entry point so that the signature of fe_ctl_create(...), which
+	/// existing callers are bound to, stays as it is.
+	/// </summary>
+	/// <param name="onMessageChunk">
+	/// Called with each piece of payload of a HTTP transaction that was flagged for streaming
+	/// content inspection, as it is read. Optional, may be nullptr.
+	/// </param>
+	/// <returns>
+	/// A valid pointer to the created instance if the call succeeded, nullptr otherwise.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API PVOID fe_ctl_create_ex(
+		FirewallCheckCallback firewallCb,
+		const char* caBundleAbsolutePath,
+		uint32_t caBundleAbsolutePathLength,
+		uint16_t httpListenerPort,
+		uint16_t httpsListenerPort,
+		uint32_t numThreads,
+		HttpMessageBeginCallback onMessageBegin,
+		HttpMessageEndCallback onMessageEnd,
+		HttpMessageChunkCallback onMessageChunk,
+		ReportMessageCallback onInfo,
+		ReportMessageCallback onWarn,
+		ReportMessageCallback onError
+		);
+
+	/// <summary>
+	/// Same as fe_ctl_create(...), except that the message callbacks are the v2 versions. Rather
+	/// than the formatted headers, payloads and a writer, they're supplied a context for the
+	/// transaction. The parts of the transaction the callback needs are read through the
+	/// fe_ctx_get_* functions, straight from the Engine's own storage. A custom block response is
+	/// written with fe_ctx_write_block_response(...), or handed over whole with
+	/// fe_ctx_give_block_response(...).
+	///
+	/// Callbacks that take long to come to a verdict should defer it with
+	/// fe_ctx_defer_verdict(...) and deliver it later with fe_ctl_complete_verdict(...), rather
+	/// than hold up one of the threads that drive every connection.
+	/// </summary>
+	/// <returns>
+	/// A valid pointer to the created instance if the call succeeded, nullptr otherwise.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API PVOID fe_ctl_create_v2(
+		FirewallCheckCallback firewallCb,
+		const char* caBundleAbsolutePath,
+		uint32_t caBundleAbsolutePathLength,
+		uint16_t httpListenerPort,
+		uint16_t httpsListenerPort,
+		uint32_t numThreads,
+		HttpMessageBeginCallbackV2 onMessageBegin,
+		HttpMessageEndCallbackV2 onMessageEnd,
+		HttpMessageChunkCallbackV2 onMessageChunk,
+		ReportMessageCallback onInfo,
+		ReportMessageCallback onWarn,
+		ReportMessageCallback onError
+		);
+
+	/// <summary>
+	/// Gets the method of the request of the transaction that a v2 callback is being invoked for.
+	/// Like everything fetched through a context, the string is not null terminated, and is only
+	/// valid for the duration of the callback.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="method">
+	/// Set to the method, as it appears in the request line.
+	/// </param>
+	/// <param name="methodLength">
+	/// Set to the length of the method.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_method(HttpTransactionContext context, const char** method, uint32_t* methodLength);
+
+	/// <summary>
+	/// Gets the host the request of the transaction that a v2 callback is being invoked for is
+	/// addressed to, from its host header, without the port.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="host">
+	/// Set to the host. Empty if the request has no host header.
+	/// </param>
+	/// <param name="hostLength">
+	/// Set to the length of the host.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_host(HttpTransactionContext context, const char** host, uint32_t* hostLength);
+
+	/// <summary>
+	/// Gets the path, query included, of the request of the transaction that a v2 callback is
+	/// being invoked for. When the request line has an absolute URI, the scheme and authority are
+	/// skipped.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="path">
+	/// Set to the path.
+	/// </param>
+	/// <param name="pathLength">
+	/// Set to the length of the path.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_path(HttpTransactionContext context, const char** path, uint32_t* pathLength);
+
+	/// <summary>
+	/// Gets the value of the first request header with the supplied name, for the transaction
+	/// that a v2 callback is being invoked for.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="name">
+	/// The name of the header. Case insensitive.
+	/// </param>
+	/// <param name="nameLength">
+	/// The length of the name.
+	/// </param>
+	/// <param name="value">
+	/// Set to the value of the header. Empty if there is no such header.
+	/// </param>
+	/// <param name="valueLength">
+	/// Set to the length of the value.
+	/// </param>
+	/// <returns>
+	/// True if the header was found, false otherwise.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API const bool fe_ctx_get_request_header(HttpTransactionContext context, const char* name, const uint32_t nameLength, const char** value, uint32_t* valueLength);
+
+	/// <summary>
+	/// Same as fe_ctx_get_request_header(...), for the response. Never finds anything when the
+	/// callback is invoked before there is a response.
+	/// </summary>
+	extern HTTP_FILTERING_ENGINE_API const bool fe_ctx_get_response_header(HttpTransactionContext context, const char* name, const uint32_t nameLength, const char** value, uint32_t* valueLength);
+
+	/// <summary>
+	/// Gets the kinds of media that the payload of the transaction that a v2 callback is being
+	/// invoked for is, as classified from its content type. That's the response payload once
+	/// there is a response, the request payload before.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <returns>
+	/// A mask of the kinds that apply, where 1 is text, 2 is HTML, 4 is JSON, 8 is an image, 16 is
+	/// CSS and 32 is Javascript. A payload may be of several kinds, as text/html is both text and
+	/// HTML.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API uint32_t fe_ctx_get_media_kinds(HttpTransactionContext context);
+
+	/// <summary>
+	/// Gets the request payload of the transaction that a v2 callback is being invoked for. Only
+	/// available when the payload was held back in full for inspection, as it is for the message
+	/// end callback.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="payload">
+	/// Set to the payload. Empty if it isn't available.
+	/// </param>
+	/// <param name="payloadLength">
+	/// Set to the length of the payload.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_request_payload(HttpTransactionContext context, const char** payload, uint32_t* payloadLength);
+
+	/// <summary>
+	/// Same as fe_ctx_get_request_payload(...), for the response.
+	/// </summary>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_response_payload(HttpTransactionContext context, const char** payload, uint32_t* payloadLength);
+
+	/// <summary>
+	/// Gets the complete request headers, start line included, of the transaction that a v2
+	/// callback is being invoked for, formatted as they are handed to the original callbacks.
+	/// They're only formatted when first asked for.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="headers">
+	/// Set to the formatted headers.
+	/// </param>
+	/// <param name="headersLength">
+	/// Set to the length of the formatted headers.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_request_headers(HttpTransactionContext context, const char** headers, uint32_t* headersLength);
+
+	/// <summary>
+	/// Same as fe_ctx_get_request_headers(...), for the response. Empty when the callback is invoked
+	/// before there is a response.
+	/// </summary>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_get_response_headers(HttpTransactionContext context, const char** headers, uint32_t* headersLength);
+
+	/// <summary>
+	/// Appends the supplied data to the custom block response of the transaction that a v2
+	/// callback is being invoked for. The data is copied, all at once.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="data">
+	/// The data to append.
+	/// </param>
+	/// <param name="dataLength">
+	/// The length of the data to append.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_write_block_response(HttpTransactionContext context, const char* data, const uint32_t dataLength);
+
+	/// <summary>
+	/// Makes room in the custom block response of the transaction that a v2 callback is being
+	/// invoked for, so that a response written in several pieces is allocated only once.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="capacity">
+	/// The number of bytes about to be written.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_reserve_block_response(HttpTransactionContext context, const uint32_t capacity);
+
+	/// <summary>
+	/// Hands a buffer owned by the caller over to the Engine as the custom block response of the
+	/// transaction that a v2 callback is being invoked for, replacing anything written so far.
+	/// The buffer is sent from where it is, without being copied, so it must hold the complete
+	/// response, headers included, and stay valid and unchanged until it's released.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="data">
+	/// The complete block response.
+	/// </param>
+	/// <param name="dataLength">
+	/// The length of the block response.
+	/// </param>
+	/// <param name="release">
+	/// Called with the buffer once the Engine is done with it. May be nullptr, in which case the
+	/// buffer must stay valid for as long as the Engine runs, as a constant block page would.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_give_block_response(HttpTransactionContext context, const char* data, const uint32_t dataLength, CustomResponseBufferRelease release);
+
+	/// <summary>
+	/// Defers the verdict of the v2 begin or end callback being invoked. The callback returns
+	/// right away, and whatever it set or wrote is ignored. The transaction is parked without
+	/// holding a thread until the verdict is delivered with fe_ctl_complete_verdict(...), from
+	/// any thread. If it isn't delivered within the timeout set with
+	/// fe_ctl_set_deferred_verdict_limits(...), the transaction is allowed, as though the next
+	/// action was zero, or the end callback didn't block.
+	///
+	/// The chunk callback can't defer.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <returns>
+	/// The token to deliver the verdict with. Zero if the verdict can't be deferred, because it's
+	/// the chunk callback, or because as many verdicts as allowed are already pending, in which
+	/// case the callback must answer as usual.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API uint64_t fe_ctx_defer_verdict(HttpTransactionContext context);
+
+	/// <summary>
+	/// Asks for the next action set by the v2 begin callback being invoked for the headers of a
+	/// request to be cached, along with the custom block response if it blocks. Later requests
+	/// for the same host and path, query included, are then answered by the Engine without
+	/// invoking the callback, until the verdict expires or is invalidated. Ignored when called
+	/// from any other callback, or when the verdict is deferred.
+	/// </summary>
+	/// <param name="context">
+	/// The context supplied to the callback.
+	/// </param>
+	/// <param name="ttlMilliseconds">
+	/// The number of milliseconds to keep the verdict. Zero for the default of one minute.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctx_cache_verdict(HttpTransactionContext context, uint32_t ttlMilliseconds);
+
 	/// <summary>
 	/// Destroys an existing Engine instance. If the Engine is running, it will be correctly shut
 	/// down. Regardless of its state, the Engine instance pointed to will be destroyed and the
@@ -143,6 +418,39 @@ extern "C" {
 	/// </param>
 	extern HTTP_FILTERING_ENGINE_API void fe_ctl_stop(PVOID ptr);
 
+	/// <summary>
+	/// Sets whether each of the threads driving the Engine runs an event loop of its own, pinned
+	/// to a core, with every connection living on one thread from start to finish, rather than
+	/// all of the threads sharing one event loop. Off by default. Takes effect the next time the
+	/// Engine is started. Callbacks are then invoked on whichever thread owns the connection, as
+	/// they always were, so they must still be thread safe.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="perThread">
+	/// Whether each thread runs an event loop of its own.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_io_service_per_thread(PVOID ptr, bool perThread);
+
+	/// <summary>
+	/// Sets the minimum severity of the events handed to the info, warning and error callbacks.
+	/// Events below it are dropped as soon as they're reported. Can be called at any time.
+	///
+	/// Events are delivered to the callbacks from a single thread belonging to the Engine, never
+	/// from the threads that report them, and are cut short past 240 bytes. Should the callbacks
+	/// fall far enough behind, events are dropped rather than the Engine being held up, and a
+	/// warning saying how many is delivered once they catch up.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="minimumSeverity">
+	/// The minimum severity, from 0 for informational messages, 1 for warnings and 2 for errors.
+	/// Anything greater silences every event.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_minimum_event_severity(PVOID ptr, uint32_t minimumSeverity);
+
 	/// <summary>
 	/// Checks if the Engine is actively diverting and filtering HTTP/S traffic or not.
 	/// </summary>
@@ -194,6 +502,222 @@ extern "C" {
 	/// </param>
 	extern HTTP_FILTERING_ENGINE_API void fe_ctl_get_rootca_pem(PVOID ptr, char** bufferPP, size_t* bufferSize);
 
+	/// <summary>
+	/// Gets a snapshot of every counter and latency histogram of the Engine, as text. Memory is
+	/// allocated inside the function and the corresponding pointer is assigned to the bufferPP
+	/// parameter. The user must call free() on the buffer in the event that the bufferSize
+	/// parameter has a value greater than zero after the call.
+	///
+	/// The text is not null terminated. Each line is a name, a single space and a value, such as
+	/// "dns_cache.hits 42". Latency histograms, named "latency.<stage>", are given as a count, a
+	/// total, a maximum and the 50th, 90th and 99th percentiles in microseconds, followed by
+	/// their raw buckets as a comma separated list. The first bucket counts samples of zero
+	/// microseconds, and each bucket i after it counts samples of at least 2^(i-1) and less than
+	/// 2^i microseconds. Names are only ever added, never changed, so unknown ones should be
+	/// skipped.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="bufferPP">
+	/// A pointer to a char pointer to be populated by the operation.
+	/// </param>
+	/// <param name="bufferSize">
+	/// A pointer to a size_t object that will hold the total number of elements in the populated
+	/// array.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_get_stats_snapshot(PVOID ptr, char** bufferPP, size_t* bufferSize);
+
+	/// <summary>
+	/// Drops all cached firewall check verdicts. The Engine remembers the verdict given by the
+	/// firewall check callback for each running process, so the callback is normally invoked
+	/// only once per process. Call this whenever the rules behind the callback change, so
+	/// that running processes are checked against the new rules.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_clear_firewall_verdicts(PVOID ptr);
+
+	/// <summary>
+	/// Delivers a verdict deferred with fe_ctx_defer_verdict(...). May be called from any thread.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="token">
+	/// The token returned by fe_ctx_defer_verdict(...).
+	/// </param>
+	/// <param name="verdict">
+	/// For a deferred begin callback, the next action it would have set. For a deferred end
+	/// callback, nonzero to block.
+	/// </param>
+	/// <param name="blockResponse">
+	/// A complete custom block response, headers included, for a blocked transaction. Copied, so
+	/// the buffer may be reused as soon as this returns. May be nullptr, in which case a 204 is
+	/// sent.
+	/// </param>
+	/// <param name="blockResponseLength">
+	/// The length of the block response.
+	/// </param>
+	/// <returns>
+	/// True if the verdict was delivered. False if the token is unknown, or the verdict was already
+	/// delivered or timed out.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API const bool fe_ctl_complete_verdict(PVOID ptr, uint64_t token, uint32_t verdict, const char* blockResponse, uint32_t blockResponseLength);
+
+	/// <summary>
+	/// Sets the limits of verdict deferral. May be called at any time, and the limits are kept
+	/// across restarts of the Engine. By default, 256 verdicts may be pending, for 30 seconds each.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="maxPending">
+	/// The maximum number of verdicts pending at once. Zero disables deferral.
+	/// </param>
+	/// <param name="timeoutMilliseconds">
+	/// The number of milliseconds a transaction waits for its verdict before it's allowed.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_deferred_verdict_limits(PVOID ptr, uint32_t maxPending, uint32_t timeoutMilliseconds);
+
+	/// <summary>
+	/// Drops every verdict cached with fe_ctx_cache_verdict(...). Call this whenever the rules
+	/// behind the begin callback change.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_clear_verdict_cache(PVOID ptr);
+
+	/// <summary>
+	/// Drops every verdict cached with fe_ctx_cache_verdict(...) for the supplied host.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="host">
+	/// The host, without the port. Compared without regard to case.
+	/// </param>
+	/// <param name="hostLength">
+	/// The length of the host.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_invalidate_cached_verdicts(PVOID ptr, const char* host, uint32_t hostLength);
+
+	/// <summary>
+	/// Sets the limits of the verdict cache. May be called at any time, and the limits are kept
+	/// across restarts of the Engine. By default, 4096 verdicts are kept, keyed by host and path.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="maxEntries">
+	/// The maximum number of verdicts kept. Zero disables the cache.
+	/// </param>
+	/// <param name="keyByMethod">
+	/// Whether the method of the request is part of the key as well. Changing this drops every
+	/// cached verdict.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_verdict_cache_limits(PVOID ptr, uint32_t maxEntries, bool keyByMethod);
+
+	/// <summary>
+	/// Sets when payloads held back for inspection move from memory to memory mapped temp
+	/// files. May be called at any time. By default, payloads move to disk past 4MB, or earlier
+	/// once payloads together hold 256MB of memory.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="spillThreshold">
+	/// The size in bytes past which a payload moves to disk. Zero keeps every payload in memory.
+	/// </param>
+	/// <param name="maxBytesInMemory">
+	/// The limit on the payload bytes held in memory by every transaction together. Past it,
+	/// growing payloads of 64KB or more move to disk early.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_payload_spill_limits(PVOID ptr, uint32_t spillThreshold, uint64_t maxBytesInMemory);
+
+	/// <summary>
+	/// Sets the zlib compression level used whenever a payload has to be compressed again. May
+	/// be called at any time. Payloads that were decoded for inspection but not changed are
+	/// always written as they were received, so this only ever costs anything for payloads that
+	/// were changed.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="level">
+	/// The compression level, from 0 for none to 9 for the best, or -1 for the zlib default,
+	/// which is also the default here. Values outside of that range are clamped to it.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_compression_level(PVOID ptr, int32_t level);
+
+	/// <summary>
+	/// Replaces the rules checked ahead of the begin callback, for both the request and the
+	/// response headers. Rules are checked in the order supplied, and the first to match decides.
+	/// A message decided by a rule costs no callback. May be called at any time, and the rules
+	/// are kept across restarts of the Engine.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="rules">
+	/// The rules, copied before this returns.
+	/// </param>
+	/// <param name="ruleCount">
+	/// The number of rules. Zero drops every rule.
+	/// </param>
+	/// <returns>
+	/// True if the rules were loaded, false if any of them was invalid, in which case the rules
+	/// are left as they were.
+	/// </returns>
+	extern HTTP_FILTERING_ENGINE_API const bool fe_ctl_load_rules(PVOID ptr, const HttpFilteringRule* rules, uint32_t ruleCount);
+
+	/// <summary>
+	/// Replaces the hosts whose TLS connections are never diverted to the Engine, by the server
+	/// name their clients send. Each host matches itself and any host under it. Connections are
+	/// told apart by address and port, so the first connection to an exempted host at a given
+	/// address may still be filtered, and hosts sharing that address with it are exempted along
+	/// with it until a connection for one of them is seen. May be called at any time, and the
+	/// hosts are kept across restarts of the Engine.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="hosts">
+	/// The hosts, one per line, copied before this returns.
+	/// </param>
+	/// <param name="hostsLength">
+	/// The length of the hosts. Zero drops every exemption.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_sni_exemptions(PVOID ptr, const char* hosts, uint32_t hostsLength);
+
+	/// <summary>
+	/// Sets whether HTTP requests and TLS connections offering HTTP, on ports other than 80 and
+	/// 443, are diverted to the Engine. Such a port is only diverted for an address once a
+	/// connection to it has been seen to carry HTTP. On by default.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="enabled">
+	/// True to divert HTTP on any port, false for ports 80 and 443 only.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_port_independent_diversion(PVOID ptr, bool enabled);
+
+	/// <summary>
+	/// Sets whether TLS clients may negotiate HTTP/2 with the Engine. Each such client's
+	/// requests are then filtered one at a time, over a single HTTP/1.1 connection to the
+	/// upstream server. Off by default.
+	/// </summary>
+	/// <param name="ptr">
+	/// A valid pointer to an existing Engine instance.
+	/// </param>
+	/// <param name="enabled">
+	/// True to select h2 whenever a client offers it, false for http/1.1 only.
+	/// </param>
+	extern HTTP_FILTERING_ENGINE_API void fe_ctl_set_http2_enabled(PVOID ptr, bool enabled);
+
 #ifdef __cplusplus
 };
 #endif // __cplusplus
\ No newline at end of file
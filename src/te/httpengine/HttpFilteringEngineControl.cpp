@@ -6,7 +6,9 @@
 */
 
 #include "HttpFilteringEngineControl.hpp"
+#include "util/metrics/EngineMetrics.hpp"
 #include <functional>
+#include <sstream>
 #include <boost/predef.h>
 
 // Because we're using ::asio inside a library, and it's a header only library,
@@ -50,6 +52,7 @@
 #endif
 
 #include "mitm/diversion/DiversionControl.hpp"
+#include "mitm/diversion/BaseDiverter.hpp"
 
 namespace te
 {
@@ -64,6 +67,7 @@ namespace te
 			uint32_t proxyNumThreads,
 			util::cb::HttpMessageBeginCheckFunction onMessageBegin,
 			util::cb::HttpMessageEndCheckFunction onMessageEnd,
+			util::cb::HttpMessageChunkCheckFunction onMessageChunk,
 			util::cb::MessageFunction onInfo,
 			util::cb::MessageFunction onWarn,
 			util::cb::MessageFunction onError
@@ -75,10 +79,22 @@ namespace te
 			m_httpListenerPort(httpListenerPort),
 			m_httpsListenerPort(httpsListenerPort),
 			m_proxyNumThreads(proxyNumThreads),
+			m_upstreamPoolMaxIdlePerHost(static_cast<uint32_t>(mitm::secure::UpstreamConnectionPool<network::TlsSocket>::DefaultMaxIdlePerHost)),
+			m_upstreamPoolMaxIdle(static_cast<uint32_t>(mitm::secure::UpstreamConnectionPool<network::TlsSocket>::DefaultMaxIdle)),
+			m_upstreamPoolIdleTimeout(mitm::secure::UpstreamConnectionPool<network::TlsSocket>::DefaultIdleTimeoutSeconds),
 			m_isRunning(false),
 			m_onMessageBegin(onMessageBegin),
-			m_onMessageEnd(onMessageEnd)
+			m_onMessageEnd(onMessageEnd),
+			m_onMessageChunk(onMessageChunk)
 		{
+			// Everything handed our callbacks from here on reports through the pipeline, never
+			// straight to the host.
+			m_eventPipeline.reset(new util::cb::EventPipeline(onInfo, onWarn, onError));
+
+			SetOnInfo(m_eventPipeline->MakeReporter(util::cb::EventPipeline::Severity::Info));
+			SetOnWarning(m_eventPipeline->MakeReporter(util::cb::EventPipeline::Severity::Warning));
+			SetOnError(m_eventPipeline->MakeReporter(util::cb::EventPipeline::Severity::Error));
+
 			if (m_store == nullptr)
 			{
 				// XXX TODO - Make a factory for cert store so we don't have this horrible mess everywhere.
@@ -98,12 +114,17 @@ namespace te
 
 			if (!m_onMessageBegin)
 			{
-				m_onMessageBegin = std::bind(&HttpFilteringEngineControl::DummyOnMessageBeginCallback, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
+				m_onMessageBegin = std::bind(&HttpFilteringEngineControl::DummyOnMessageBeginCallback, std::placeholders::_1, std::placeholders::_2);
 			}
 
 			if (!m_onMessageEnd)
 			{
-				m_onMessageEnd = std::bind(&HttpFilteringEngineControl::DummyOnMessageEndCallback, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
+				m_onMessageEnd = std::bind(&HttpFilteringEngineControl::DummyOnMessageEndCallback, std::placeholders::_1, std::placeholders::_2);
+			}
+
+			if (!m_onMessageChunk)
+			{
+				m_onMessageChunk = std::bind(&HttpFilteringEngineControl::DummyOnMessageChunkCallback, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5);
 			}
 		}
 
@@ -138,14 +159,59 @@ namespace te
 					m_service->reset();
 				}				
 
+				if (m_timerWheels.empty())
+				{
+					m_timerWheels.emplace_back(new network::TimerWheel(*m_service));
+				}
+
+				m_timerWheels[0]->Start();
+
+				// The io_services that bridges are handed to in turn, one per thread, and the
+				// timer wheels they drive. Left empty when every thread runs m_service.
+				std::vector<boost::asio::io_service*> bridgeServices;
+				std::vector<network::TimerWheel*> bridgeTimerWheels;
+
+				if (m_ioServicePerThread)
+				{
+					const uint32_t numWorkers = m_proxyNumThreads > 0 ? m_proxyNumThreads : 1;
+
+					while (m_workerServices.size() + 1 < numWorkers)
+					{
+						m_workerServices.emplace_back(new boost::asio::io_service(1));
+						m_timerWheels.emplace_back(new network::TimerWheel(*m_workerServices.back()));
+					}
+
+					bridgeServices.push_back(m_service.get());
+					bridgeTimerWheels.push_back(m_timerWheels[0].get());
+
+					for (uint32_t i = 1; i < numWorkers; ++i)
+					{
+						m_workerServices[i - 1]->reset();
+						m_timerWheels[i]->Start();
+						bridgeServices.push_back(m_workerServices[i - 1].get());
+						bridgeTimerWheels.push_back(m_timerWheels[i].get());
+					}
+
+					for (auto service : bridgeServices)
+					{
+						m_workerWork.emplace_back(new boost::asio::io_service::work(*service));
+					}
+				}
+
 				m_httpAcceptor.reset(
 					new mitm::secure::TcpAcceptor(
 						m_service.get(),
 						m_httpListenerPort,
 						m_caBundleAbsolutePath,
 						nullptr,
+						&m_dnsCache,
+						&m_deferredVerdicts,
+						&m_verdictCache,
+						&m_rules,
+						m_timerWheels[0].get(),
 						m_onMessageBegin,
 						m_onMessageEnd,
+						m_onMessageChunk,
 						m_onInfo,
 						m_onWarning,
 						m_onError
@@ -162,19 +228,33 @@ namespace te
 						m_httpsListenerPort,
 						m_caBundleAbsolutePath,
 						m_store.get(),
+						&m_dnsCache,
+						&m_deferredVerdicts,
+						&m_verdictCache,
+						&m_rules,
+						m_timerWheels[0].get(),
 						m_onMessageBegin,
 						m_onMessageEnd,
+						m_onMessageChunk,
 						m_onInfo,
 						m_onWarning,
 						m_onError
 						)
 					);
 
+				m_httpAcceptor->SetUpstreamPoolLimits(m_upstreamPoolMaxIdlePerHost, m_upstreamPoolMaxIdle, m_upstreamPoolIdleTimeout);
+
+				m_httpsAcceptor->SetUpstreamPoolLimits(m_upstreamPoolMaxIdlePerHost, m_upstreamPoolMaxIdle, m_upstreamPoolIdleTimeout);
+
+				m_httpAcceptor->SetBridgeServices(bridgeServices, bridgeTimerWheels);
+
+				m_httpsAcceptor->SetBridgeServices(bridgeServices, bridgeTimerWheels);
+
 				m_httpAcceptor->AcceptConnections();
 
 				m_httpsAcceptor->AcceptConnections();
 
-				m_diversionControl.reset(new mitm::diversion::DiversionControl(m_firewallCheckCb, m_onInfo, m_onWarning, m_onError));
+				m_diversionControl.reset(new mitm::diversion::DiversionControl(m_firewallCheckCb, &m_flowClassifier, m_onInfo, m_onWarning, m_onError));
 
 				m_diversionControl->SetHttpListenerPort(m_httpAcceptor->GetListenerPort());
 
@@ -182,17 +262,48 @@ namespace te
 
 				m_diversionControl->Run();
 
-				for (uint32_t i = 0; i < m_proxyNumThreads; ++i)
+				if (bridgeServices.size() > 0)
 				{
-					m_proxyServiceThreads.emplace_back(
-						std::thread
-							{ 
-								std::bind(
-								static_cast<size_t(boost::asio::io_service::*)()>(&boost::asio::io_service::run), 
-									std::ref(*m_service.get())
-									) 
+					const uint32_t numCores = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+					for (size_t i = 0; i < bridgeServices.size(); ++i)
+					{
+						m_proxyServiceThreads.emplace_back(
+							std::thread
+								{ 
+									std::bind(
+									static_cast<size_t(boost::asio::io_service::*)()>(&boost::asio::io_service::run), 
+										std::ref(*bridgeServices[i])
+										) 
+								}
+						);
+
+						#if BOOST_OS_WINDOWS
+							// Pinned, so that the bridges of each thread stay in the caches of
+							// one core. Failing that is no reason not to run.
+							const auto core = (i % numCores) % (sizeof(DWORD_PTR) * 8);
+
+							if (SetThreadAffinityMask(m_proxyServiceThreads.back().native_handle(), static_cast<DWORD_PTR>(1) << core) == 0)
+							{
+								ReportWarning(u8"In HttpFilteringEngineControl::Start() - Failed to pin proxy thread to core.");
 							}
-					);
+						#endif
+					}
+				}
+				else
+				{
+					for (uint32_t i = 0; i < m_proxyNumThreads; ++i)
+					{
+						m_proxyServiceThreads.emplace_back(
+							std::thread
+								{ 
+									std::bind(
+									static_cast<size_t(boost::asio::io_service::*)()>(&boost::asio::io_service::run), 
+										std::ref(*m_service.get())
+										) 
+								}
+						);
+					}
 				}
 
 				m_isRunning = true;
@@ -210,6 +321,11 @@ namespace te
 				m_diversionControl->Stop();
 				m_service->stop();
 
+				for (auto& service : m_workerServices)
+				{
+					service->stop();
+				}
+
 				for (auto& t : m_proxyServiceThreads)
 				{
 					t.join();
@@ -217,6 +333,11 @@ namespace te
 
 				m_proxyServiceThreads.clear();
 
+				m_workerWork.clear();
+
+				// Nothing is left to pick parked transactions up again, so let go of them.
+				m_deferredVerdicts.Clear();
+
 				m_isRunning = false;
 			}
 		}
@@ -256,23 +377,357 @@ namespace te
 			return{};
 		}
 
+		mitm::diversion::DiversionStats HttpFilteringEngineControl::GetDiversionStats() const
+		{
+			if (m_isRunning && m_diversionControl != nullptr)
+			{
+				return m_diversionControl->GetStats();
+			}
+
+			return{};
+		}
+
+		void HttpFilteringEngineControl::ClearFirewallVerdicts()
+		{
+			std::lock_guard<std::mutex> lock(m_ctlMutex);
+
+			if (m_diversionControl != nullptr)
+			{
+				m_diversionControl->ClearFirewallVerdicts();
+			}
+		}
+
+		void HttpFilteringEngineControl::SetKeyPoolDepth(const uint32_t depth)
+		{
+			if (m_store != nullptr)
+			{
+				m_store->SetKeyPoolDepth(depth);
+			}
+		}
+
+		mitm::secure::CertificateStoreStats HttpFilteringEngineControl::GetCertificateStoreStats() const
+		{
+			if (m_store != nullptr)
+			{
+				return m_store->GetStats();
+			}
+
+			return{};
+		}
+
+		void HttpFilteringEngineControl::SetCertificateCacheLimits(const uint32_t maxContexts, const uint64_t maxBytes)
+		{
+			if (m_store != nullptr)
+			{
+				m_store->SetContextCacheLimits(maxContexts, maxBytes);
+			}
+		}
+
+		mitm::secure::TlsSessionStats HttpFilteringEngineControl::GetTlsSessionStats() const
+		{
+			if (m_isRunning && m_httpsAcceptor != nullptr)
+			{
+				return m_httpsAcceptor->GetSessionStats();
+			}
+
+			return{};
+		}
+
+		mitm::secure::ApplicationProtocolStats HttpFilteringEngineControl::GetApplicationProtocolStats() const
+		{
+			return mitm::secure::ApplicationProtocols::GetStats();
+		}
+
+		mitm::secure::UpstreamPoolStats HttpFilteringEngineControl::GetUpstreamPoolStats() const
+		{
+			mitm::secure::UpstreamPoolStats stats;
+
+			if (m_isRunning && m_httpAcceptor != nullptr && m_httpsAcceptor != nullptr)
+			{
+				auto httpStats = m_httpAcceptor->GetUpstreamPoolStats();
+				auto httpsStats = m_httpsAcceptor->GetUpstreamPoolStats();
+
+				stats.Reused = httpStats.Reused + httpsStats.Reused;
+				stats.Misses = httpStats.Misses + httpsStats.Misses;
+				stats.Released = httpStats.Released + httpsStats.Released;
+				stats.Discarded = httpStats.Discarded + httpsStats.Discarded;
+				stats.Idle = httpStats.Idle + httpsStats.Idle;
+			}
+
+			return stats;
+		}
+
+		network::DnsCacheStats HttpFilteringEngineControl::GetDnsCacheStats() const
+		{
+			return m_dnsCache.GetStats();
+		}
+
+		util::mem::BufferPoolStats HttpFilteringEngineControl::GetBufferPoolStats() const
+		{
+			return util::mem::BufferPool::Shared().GetStats();
+		}
+
+		void HttpFilteringEngineControl::SetPayloadSpillLimits(const uint32_t spillThreshold, const uint64_t maxBytesInMemory)
+		{
+			util::mem::SpillBuffer::SetLimits(spillThreshold, maxBytesInMemory);
+		}
+
+		util::mem::SpillBufferStats HttpFilteringEngineControl::GetPayloadStorageStats() const
+		{
+			return util::mem::SpillBuffer::GetStats();
+		}
+
+		void HttpFilteringEngineControl::SetCompressionLevel(const int32_t level)
+		{
+			mitm::http::BaseHttpTransaction::SetCompressionLevel(level);
+		}
+
+		util::cb::EventPipelineStats HttpFilteringEngineControl::GetEventPipelineStats() const
+		{
+			return m_eventPipeline->GetStats();
+		}
+
+		std::string HttpFilteringEngineControl::GetStatsSnapshot() const
+		{
+			std::ostringstream snapshot;
+
+			snapshot.setf(std::ios::fixed);
+			snapshot.precision(2);
+
+			auto diversion = GetDiversionStats();
+
+			{
+				std::lock_guard<std::mutex> lock(m_snapshotMutex);
+
+				mitm::diversion::BaseDiverter::CalculateRates(diversion, m_lastSnapshotDiversion);
+				m_lastSnapshotDiversion = diversion;
+			}
+
+			snapshot << u8"diversion.packets_received " << diversion.PacketsReceived << '\n';
+			snapshot << u8"diversion.packets_modified " << diversion.PacketsModified << '\n';
+			snapshot << u8"diversion.packets_sent " << diversion.PacketsSent << '\n';
+			snapshot << u8"diversion.packets_dropped " << diversion.PacketsDropped << '\n';
+			snapshot << u8"diversion.receive_batches " << diversion.ReceiveBatches << '\n';
+			snapshot << u8"diversion.received_per_second " << diversion.ReceivedPerSecond << '\n';
+			snapshot << u8"diversion.sent_per_second " << diversion.SentPerSecond << '\n';
+			snapshot << u8"diversion.verdict_cache_hits " << diversion.VerdictCacheHits << '\n';
+			snapshot << u8"diversion.verdict_cache_misses " << diversion.VerdictCacheMisses << '\n';
+
+			const auto flows = GetFlowClassifierStats();
+			snapshot << u8"flows.bypassed " << flows.FlowsBypassed << '\n';
+			snapshot << u8"flows.redirected " << flows.FlowsRedirected << '\n';
+			snapshot << u8"flows.endpoints_learned " << flows.EndpointsLearned << '\n';
+
+			const auto store = GetCertificateStoreStats();
+			snapshot << u8"certificate.key_pool_depth " << store.KeyPoolDepth << '\n';
+			snapshot << u8"certificate.key_pool_available " << store.KeyPoolAvailable << '\n';
+			snapshot << u8"certificate.key_pool_hits " << store.KeyPoolHits << '\n';
+			snapshot << u8"certificate.key_pool_stalls " << store.KeyPoolStalls << '\n';
+			snapshot << u8"certificate.context_entries " << store.ContextEntries << '\n';
+			snapshot << u8"certificate.context_names " << store.ContextNames << '\n';
+			snapshot << u8"certificate.context_bytes " << store.ContextBytes << '\n';
+			snapshot << u8"certificate.context_evictions " << store.ContextEvictions << '\n';
+
+			const auto sessions = GetTlsSessionStats();
+			snapshot << u8"tls.server_handshakes " << sessions.ServerHandshakes << '\n';
+			snapshot << u8"tls.server_resumptions " << sessions.ServerResumptions << '\n';
+			snapshot << u8"tls.server_resumption_rate " << sessions.ServerResumptionRate << '\n';
+			snapshot << u8"tls.client_handshakes " << sessions.ClientHandshakes << '\n';
+			snapshot << u8"tls.client_resumptions " << sessions.ClientResumptions << '\n';
+			snapshot << u8"tls.client_resumption_rate " << sessions.ClientResumptionRate << '\n';
+			snapshot << u8"tls.client_sessions_cached " << sessions.ClientSessionsCached << '\n';
+
+			const auto protocols = GetApplicationProtocolStats();
+			snapshot << u8"alpn.http11_selected " << protocols.Http11Selected << '\n';
+			snapshot << u8"alpn.h2_offered " << protocols.Http2Offered << '\n';
+			snapshot << u8"alpn.h2_selected " << protocols.Http2Selected << '\n';
+			snapshot << u8"alpn.no_overlap " << protocols.NoOverlap << '\n';
+
+			const auto pool = GetUpstreamPoolStats();
+			snapshot << u8"upstream_pool.reused " << pool.Reused << '\n';
+			snapshot << u8"upstream_pool.misses " << pool.Misses << '\n';
+			snapshot << u8"upstream_pool.released " << pool.Released << '\n';
+			snapshot << u8"upstream_pool.discarded " << pool.Discarded << '\n';
+			snapshot << u8"upstream_pool.idle " << pool.Idle << '\n';
+
+			const auto dns = GetDnsCacheStats();
+			snapshot << u8"dns_cache.hits " << dns.Hits << '\n';
+			snapshot << u8"dns_cache.misses " << dns.Misses << '\n';
+			snapshot << u8"dns_cache.entries " << dns.Entries << '\n';
+
+			const auto verdicts = GetVerdictCacheStats();
+			snapshot << u8"verdict_cache.hits " << verdicts.Hits << '\n';
+			snapshot << u8"verdict_cache.misses " << verdicts.Misses << '\n';
+			snapshot << u8"verdict_cache.entries " << verdicts.Entries << '\n';
+
+			snapshot << u8"rules.loaded " << m_rules.GetRuleCount() << '\n';
+
+			const auto buffers = GetBufferPoolStats();
+			snapshot << u8"buffer_pool.acquired " << buffers.Acquired << '\n';
+			snapshot << u8"buffer_pool.reused " << buffers.Reused << '\n';
+			snapshot << u8"buffer_pool.buffers_in_use " << buffers.BuffersInUse << '\n';
+			snapshot << u8"buffer_pool.bytes_in_use " << buffers.BytesInUse << '\n';
+			snapshot << u8"buffer_pool.buffers_pooled " << buffers.BuffersPooled << '\n';
+			snapshot << u8"buffer_pool.bytes_pooled " << buffers.BytesPooled << '\n';
+
+			const auto payloads = GetPayloadStorageStats();
+			snapshot << u8"payload.bytes_in_memory " << payloads.BytesInMemory << '\n';
+			snapshot << u8"payload.bytes_on_disk " << payloads.BytesOnDisk << '\n';
+			snapshot << u8"payload.spills " << payloads.Spills << '\n';
+			snapshot << u8"payload.spill_failures " << payloads.SpillFailures << '\n';
+
+			const auto events = GetEventPipelineStats();
+			snapshot << u8"events.delivered " << events.Delivered << '\n';
+			snapshot << u8"events.dropped " << events.Dropped << '\n';
+			snapshot << u8"events.truncated " << events.Truncated << '\n';
+
+			const auto metrics = util::metrics::EngineMetrics::Shared().GetSnapshot();
+
+			for (size_t i = 0; i < util::metrics::CounterCount; ++i)
+			{
+				snapshot << u8"engine." << util::metrics::EngineMetrics::GetCounterName(static_cast<util::metrics::Counter>(i)) << ' ' << metrics.Counters[i] << '\n';
+			}
+
+			const uint64_t opened = metrics.Counters[static_cast<size_t>(util::metrics::Counter::BridgesOpened)];
+			const uint64_t closed = metrics.Counters[static_cast<size_t>(util::metrics::Counter::BridgesClosed)];
+			snapshot << u8"engine.bridges_active " << (opened > closed ? opened - closed : 0) << '\n';
+
+			for (size_t i = 0; i < util::metrics::StageCount; ++i)
+			{
+				const auto& histogram = metrics.Stages[i];
+				const std::string name = std::string(u8"latency.") + util::metrics::EngineMetrics::GetStageName(static_cast<util::metrics::Stage>(i));
+
+				snapshot << name << u8".count " << histogram.Count << '\n';
+				snapshot << name << u8".total_us " << histogram.TotalMicroseconds << '\n';
+				snapshot << name << u8".max_us " << histogram.MaxMicroseconds << '\n';
+				snapshot << name << u8".p50_us " << histogram.GetPercentile(50.0) << '\n';
+				snapshot << name << u8".p90_us " << histogram.GetPercentile(90.0) << '\n';
+				snapshot << name << u8".p99_us " << histogram.GetPercentile(99.0) << '\n';
+				snapshot << name << u8".buckets ";
+
+				for (size_t bucket = 0; bucket < util::metrics::HistogramBucketCount; ++bucket)
+				{
+					snapshot << (bucket > 0 ? u8"," : u8"") << histogram.Buckets[bucket];
+				}
+
+				snapshot << '\n';
+			}
+
+			return snapshot.str();
+		}
+
+		void HttpFilteringEngineControl::SetUpstreamPoolLimits(const uint32_t maxIdlePerHost, const uint32_t maxIdle, const uint32_t idleTimeoutSeconds)
+		{
+			std::lock_guard<std::mutex> lock(m_ctlMutex);
+
+			m_upstreamPoolMaxIdlePerHost = maxIdlePerHost;
+			m_upstreamPoolMaxIdle = maxIdle;
+			m_upstreamPoolIdleTimeout = idleTimeoutSeconds;
+
+			if (m_isRunning)
+			{
+				m_httpAcceptor->SetUpstreamPoolLimits(maxIdlePerHost, maxIdle, idleTimeoutSeconds);
+				m_httpsAcceptor->SetUpstreamPoolLimits(maxIdlePerHost, maxIdle, idleTimeoutSeconds);
+			}
+		}
+
+		void HttpFilteringEngineControl::SetIoServicePerThread(const bool perThread)
+		{
+			std::lock_guard<std::mutex> lock(m_ctlMutex);
+
+			m_ioServicePerThread = perThread;
+		}
+
+		void HttpFilteringEngineControl::SetMinimumEventSeverity(const uint32_t minimumSeverity)
+		{
+			m_eventPipeline->SetMinimumSeverity(minimumSeverity);
+		}
+
+		const bool HttpFilteringEngineControl::CompleteDeferredVerdict(const uint64_t token, const uint32_t verdict, const char* blockResponse, const uint32_t blockResponseLength)
+		{
+			return m_deferredVerdicts.Complete(token, verdict, blockResponse, blockResponseLength);
+		}
+
+		void HttpFilteringEngineControl::SetDeferredVerdictLimits(const uint32_t maxPending, const uint32_t timeoutMilliseconds)
+		{
+			m_deferredVerdicts.SetLimits(maxPending, timeoutMilliseconds);
+		}
+
+		void HttpFilteringEngineControl::ClearVerdictCache()
+		{
+			m_verdictCache.Clear();
+		}
+
+		void HttpFilteringEngineControl::InvalidateCachedVerdicts(const std::string& host)
+		{
+			m_verdictCache.Invalidate(host);
+		}
+
+		void HttpFilteringEngineControl::SetVerdictCacheLimits(const uint32_t maxEntries, const bool keyByMethod)
+		{
+			m_verdictCache.SetLimits(maxEntries, keyByMethod);
+		}
+
+		util::cb::VerdictCacheStats HttpFilteringEngineControl::GetVerdictCacheStats() const
+		{
+			return m_verdictCache.GetStats();
+		}
+
+		void HttpFilteringEngineControl::LoadRules(const std::vector<util::cb::Rule>& rules)
+		{
+			m_rules.Load(rules);
+		}
+
+		void HttpFilteringEngineControl::ClearRules()
+		{
+			m_rules.Clear();
+		}
+
+		void HttpFilteringEngineControl::SetSniExemptions(const std::vector<std::string>& hosts)
+		{
+			m_flowClassifier.SetSniExemptions(hosts);
+		}
+
+		void HttpFilteringEngineControl::SetPortIndependentDiversion(const bool enabled)
+		{
+			m_flowClassifier.SetPortIndependentDiversion(enabled);
+		}
+
+		void HttpFilteringEngineControl::SetHttp2Enabled(const bool enabled)
+		{
+			mitm::secure::ApplicationProtocols::SetHttp2Enabled(enabled);
+		}
+
+		mitm::diversion::FlowClassifierStats HttpFilteringEngineControl::GetFlowClassifierStats() const
+		{
+			return m_flowClassifier.GetStats();
+		}
+
 		void HttpFilteringEngineControl::DummyOnMessageBeginCallback(
-			const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-			const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-			uint32_t* nextAction, CustomResponseStreamWriter responseWriter
+			HttpTransactionContext context,
+			uint32_t* nextAction
 		)
 		{
 			// Do nothing, say nothing, tell no one.
 		}
 
 		void HttpFilteringEngineControl::DummyOnMessageEndCallback(
-			const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-			const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-			bool* shouldBlock, CustomResponseStreamWriter responseWriter
+			HttpTransactionContext context,
+			bool* shouldBlock
 		)
 		{
 			// Do nothing, say nothing, tell no one.
 		}
 
+		void HttpFilteringEngineControl::DummyOnMessageChunkCallback(
+			HttpTransactionContext context,
+			const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+			uint32_t* nextAction
+		)
+		{
+			// Nobody is listening, so stop asking.
+			*nextAction = 1;
+		}
+
 	} /* namespace httpengine */
 } /* namespace te */
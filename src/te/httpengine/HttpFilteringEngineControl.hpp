@@ -15,6 +15,12 @@
 #include <cstdint>
 
 #include "util/cb/EventReporter.hpp"
+#include "util/cb/EventPipeline.hpp"
+#include "util/cb/DeferredVerdictRegistry.hpp"
+#include "util/cb/VerdictCache.hpp"
+#include "util/cb/RuleTable.hpp"
+#include "mitm/diversion/BaseDiverter.hpp"
+#include "mitm/diversion/FlowClassifier.hpp"
 #include "mitm/secure/TlsCapableHttpAcceptor.hpp"
 
 namespace te
@@ -27,6 +33,13 @@ namespace te
 			{
 				class DiversionControl;
 			} /* namespace diversion */
+
+			namespace secure
+			{
+				struct CertificateStoreStats;
+				struct TlsSessionStats;
+				struct UpstreamPoolStats;
+			} /* namespace secure */
 		} /* namespace mitm */
 	} /* namespace httpengine */
 } /* namespace te */
@@ -89,6 +102,10 @@ namespace te
 			/// <param name="onMessageEnd">
 			/// Called when a HTTP transaction that was flagged for content inspection has completed.
 			/// </param>
+			/// <param name="onMessageChunk">
+			/// Called with each piece of payload of a HTTP transaction that was flagged for streaming
+			/// content inspection, as it is read.
+			/// </param>
 			/// <param name="onInfo">
 			/// A function that can accept string informational data generated by the underlying
 			/// Engine. Default is nullptr. This callback cannot be supplied post-construction.
@@ -109,6 +126,7 @@ namespace te
 				uint32_t proxyNumThreads = std::thread::hardware_concurrency(),
 				util::cb::HttpMessageBeginCheckFunction onMessageBegin = nullptr,
 				util::cb::HttpMessageEndCheckFunction onMessageEnd = nullptr,
+				util::cb::HttpMessageChunkCheckFunction onMessageChunk = nullptr,
 				util::cb::MessageFunction onInfo = nullptr,
 				util::cb::MessageFunction onWarn = nullptr,
 				util::cb::MessageFunction onError = nullptr
@@ -176,8 +194,337 @@ namespace te
 			/// </returns>
 			std::vector<char> GetRootCertificatePEM() const;
 
+			/// <summary>
+			/// Gets a snapshot of the packet diversion counters. Rates are left at zero, see
+			/// mitm::diversion::BaseDiverter::CalculateRates(...) for getting them.
+			/// </summary>
+			/// <returns>
+			/// If the Engine is running, the current diversion counters. A zeroed snapshot
+			/// otherwise.
+			/// </returns>
+			mitm::diversion::DiversionStats GetDiversionStats() const;
+
+			/// <summary>
+			/// Drops every cached firewall verdict, so that each process is checked against
+			/// the firewall check callback again on its next new connection. Must be called
+			/// whenever the rules behind the firewall check callback change.
+			/// </summary>
+			void ClearFirewallVerdicts();
+
+			/// <summary>
+			/// Sets the number of EC keypairs the certificate store keeps generated ahead of
+			/// time for spoofing certificates of hosts not seen before. Can be called at any
+			/// time. Zero disables the pool.
+			/// </summary>
+			/// <param name="depth">
+			/// The number of keypairs to keep available.
+			/// </param>
+			void SetKeyPoolDepth(const uint32_t depth);
+
+			/// <summary>
+			/// Gets a snapshot of the certificate store counters.
+			/// </summary>
+			/// <returns>
+			/// The current certificate store counters.
+			/// </returns>
+			mitm::secure::CertificateStoreStats GetCertificateStoreStats() const;
+
+			/// <summary>
+			/// Sets the limits for the cache of spoofed server contexts. When either limit is
+			/// exceeded, the least recently used contexts are evicted. Connections still using
+			/// an evicted context are unaffected. Can be called at any time.
+			/// </summary>
+			/// <param name="maxContexts">
+			/// The maximum number of contexts to cache. Zero for no limit.
+			/// </param>
+			/// <param name="maxBytes">
+			/// The maximum approximate number of bytes the cached contexts may hold. Zero for no
+			/// limit.
+			/// </param>
+			void SetCertificateCacheLimits(const uint32_t maxContexts, const uint64_t maxBytes);
+
+			/// <summary>
+			/// Gets a snapshot of the TLS handshake counters for both legs of bridged secure
+			/// connections, including the rate at which handshakes resumed a previous session.
+			/// </summary>
+			/// <returns>
+			/// If the Engine is running, the current TLS handshake counters. A zeroed snapshot
+			/// otherwise.
+			/// </returns>
+			mitm::secure::TlsSessionStats GetTlsSessionStats() const;
+
+			/// <summary>
+			/// Gets a snapshot of what downstream clients have offered over ALPN, including
+			/// how many of them offered HTTP/2.
+			/// </summary>
+			/// <returns>
+			/// The current ALPN counters. Shared by the whole process, so valid even when the
+			/// Engine isn't running.
+			/// </returns>
+			mitm::secure::ApplicationProtocolStats GetApplicationProtocolStats() const;
+
+			/// <summary>
+			/// Gets a snapshot of the counters of the pools of idle upstream connections,
+			/// summed over the HTTP and HTTPS listeners.
+			/// </summary>
+			/// <returns>
+			/// If the Engine is running, the current upstream connection pool counters. A
+			/// zeroed snapshot otherwise.
+			/// </returns>
+			mitm::secure::UpstreamPoolStats GetUpstreamPoolStats() const;
+
+			/// <summary>
+			/// Sets the limits of the pools of idle upstream connections. Each listener has
+			/// its own pool, and both are given these limits. Can be called at any time, and
+			/// the limits are kept across restarts of the Engine.
+			/// </summary>
+			/// <param name="maxIdlePerHost">
+			/// The maximum number of idle connections kept per host. Zero disables pooling.
+			/// </param>
+			/// <param name="maxIdle">
+			/// The maximum number of idle connections kept in total. Zero disables pooling.
+			/// </param>
+			/// <param name="idleTimeoutSeconds">
+			/// The number of seconds an idle connection is kept.
+			/// </param>
+			void SetUpstreamPoolLimits(const uint32_t maxIdlePerHost, const uint32_t maxIdle, const uint32_t idleTimeoutSeconds);
+
+			/// <summary>
+			/// Sets whether each of the proxy threads runs an io_service of its own, pinned to a
+			/// core, rather than all of them running one shared io_service. Every accepted client
+			/// is handed to the next thread in turn, and its bridge lives on that thread alone,
+			/// so its handlers run without strands and its buffers stay in the caches of one
+			/// core. Off by default. Takes effect the next time the Engine is started.
+			/// </summary>
+			/// <param name="perThread">
+			/// Whether each proxy thread runs an io_service of its own.
+			/// </param>
+			void SetIoServicePerThread(const bool perThread);
+
+			/// <summary>
+			/// Sets the minimum severity of the events handed to the host callbacks. Events
+			/// below it are dropped where they're reported, before any copying. Can be called at
+			/// any time.
+			/// </summary>
+			/// <param name="minimumSeverity">
+			/// The minimum severity, from 0 for informational messages, 1 for warnings and 2 for
+			/// errors. Anything greater silences every event.
+			/// </param>
+			void SetMinimumEventSeverity(const uint32_t minimumSeverity);
+
+			/// <summary>
+			/// Delivers a verdict that a callback deferred. Safe to call from any thread. The
+			/// transaction is picked up again on one of the threads driving the Engine.
+			/// </summary>
+			/// <param name="token">
+			/// The token the callback was given when it deferred the verdict.
+			/// </param>
+			/// <param name="verdict">
+			/// The verdict. For a deferred begin callback, one of the values it would have set
+			/// as the next action. For a deferred end callback, nonzero to block.
+			/// </param>
+			/// <param name="blockResponse">
+			/// A complete custom block response, headers included, to answer the blocked
+			/// transaction with. Copied. May be nullptr, in which case a 204 is sent.
+			/// </param>
+			/// <param name="blockResponseLength">
+			/// The length of the block response.
+			/// </param>
+			/// <returns>
+			/// True if the verdict was still pending, false if the token is unknown, was
+			/// already completed or timed out.
+			/// </returns>
+			const bool CompleteDeferredVerdict(const uint64_t token, const uint32_t verdict, const char* blockResponse, const uint32_t blockResponseLength);
+
+			/// <summary>
+			/// Sets the limits of verdict deferral. Can be called at any time, and the limits
+			/// are kept across restarts of the Engine.
+			/// </summary>
+			/// <param name="maxPending">
+			/// The maximum number of verdicts pending at once. Beyond that, callbacks can't
+			/// defer and must answer right away. Zero disables deferral.
+			/// </param>
+			/// <param name="timeoutMilliseconds">
+			/// The number of milliseconds a transaction waits for its verdict before it is
+			/// allowed.
+			/// </param>
+			void SetDeferredVerdictLimits(const uint32_t maxPending, const uint32_t timeoutMilliseconds);
+
+			/// <summary>
+			/// Drops every verdict cached at the request of the begin callback. Should be called
+			/// whenever the rules behind the callback change.
+			/// </summary>
+			void ClearVerdictCache();
+
+			/// <summary>
+			/// Drops every verdict cached for the supplied host.
+			/// </summary>
+			/// <param name="host">
+			/// The host, without the port.
+			/// </param>
+			void InvalidateCachedVerdicts(const std::string& host);
+
+			/// <summary>
+			/// Sets the limits of the verdict cache. Can be called at any time, and the limits
+			/// are kept across restarts of the Engine, as are the cached verdicts.
+			/// </summary>
+			/// <param name="maxEntries">
+			/// The maximum number of verdicts kept. Zero disables the cache.
+			/// </param>
+			/// <param name="keyByMethod">
+			/// Whether the method of the request is part of the key, along with the host and
+			/// the path. Changing this drops every cached verdict.
+			/// </param>
+			void SetVerdictCacheLimits(const uint32_t maxEntries, const bool keyByMethod);
+
+			/// <summary>
+			/// Gets a snapshot of the counters of the verdict cache.
+			/// </summary>
+			/// <returns>
+			/// The current verdict cache counters. The cache is kept across restarts of the
+			/// Engine, so these are valid even when it isn't running.
+			/// </returns>
+			util::cb::VerdictCacheStats GetVerdictCacheStats() const;
+
+			/// <summary>
+			/// Replaces the rules checked ahead of the begin callback. A message matched by a
+			/// rule is passed or blocked right away, without a callback. Can be called at any
+			/// time, and the rules are kept across restarts of the Engine.
+			/// </summary>
+			/// <param name="rules">
+			/// The rules, in the order they are to be checked. The first to match decides.
+			/// </param>
+			void LoadRules(const std::vector<util::cb::Rule>& rules);
+
+			/// <summary>
+			/// Drops every rule, so that every message goes to the callbacks again.
+			/// </summary>
+			void ClearRules();
+
+			/// <summary>
+			/// Replaces the hosts whose TLS flows are kept away from the proxy altogether, by
+			/// the server name their clients ask for. Matched just like the host suffix of a
+			/// rule. Can be called at any time, and the hosts are kept across restarts of the
+			/// Engine. See mitm::diversion::FlowClassifier::SetSniExemptions(...).
+			/// </summary>
+			/// <param name="hosts">
+			/// The exempted hosts.
+			/// </param>
+			void SetSniExemptions(const std::vector<std::string>& hosts);
+
+			/// <summary>
+			/// Sets whether HTTP and TLS flows on ports other than 80 and 443 are diverted
+			/// once seen for what they are. On by default.
+			/// </summary>
+			/// <param name="enabled">
+			/// True to divert HTTP and TLS on any port, false for the standard ports only.
+			/// </param>
+			void SetPortIndependentDiversion(const bool enabled);
+
+			/// <summary>
+			/// Sets whether bridged TLS clients may negotiate HTTP/2. Their streams are then
+			/// answered one at a time over a single HTTP/1.1 connection upstream. Off by
+			/// default, in which case only http/1.1 is ever selected.
+			/// </summary>
+			/// <param name="enabled">
+			/// True to select h2 whenever a client offers it, false for http/1.1 only.
+			/// </param>
+			void SetHttp2Enabled(const bool enabled);
+
+			/// <summary>
+			/// Gets a snapshot of the counters of the diverter's flow classifier.
+			/// </summary>
+			/// <returns>
+			/// The current flow classifier counters. The classifier is kept across restarts
+			/// of the Engine, so these are valid even when it isn't running.
+			/// </returns>
+			mitm::diversion::FlowClassifierStats GetFlowClassifierStats() const;
+
+			/// <summary>
+			/// Gets a snapshot of the counters of the cache of resolved upstream hosts. The
+			/// cache is only consulted when a bridge can't connect straight to the address its
+			/// client was originally headed for.
+			/// </summary>
+			/// <returns>
+			/// The current DNS cache counters. The cache is kept across restarts of the
+			/// Engine, so these are valid even when it isn't running.
+			/// </returns>
+			network::DnsCacheStats GetDnsCacheStats() const;
+
+			/// <summary>
+			/// Gets a snapshot of the occupancy of the pool of I/O buffers used by bridges and
+			/// transactions.
+			/// </summary>
+			/// <returns>
+			/// The current buffer pool occupancy. The pool is shared by the whole process, so
+			/// this is valid even when the Engine isn't running.
+			/// </returns>
+			util::mem::BufferPoolStats GetBufferPoolStats() const;
+
+			/// <summary>
+			/// Sets when payloads held back for inspection move from memory to memory mapped
+			/// temp files. Applies to the whole process, and to every payload from its next
+			/// growth on.
+			/// </summary>
+			/// <param name="spillThreshold">
+			/// The size past which a payload moves to disk. Zero keeps every payload in memory.
+			/// </param>
+			/// <param name="maxBytesInMemory">
+			/// The limit on the payload bytes held in memory by every transaction together.
+			/// Past it, growing payloads move to disk early.
+			/// </param>
+			void SetPayloadSpillLimits(const uint32_t spillThreshold, const uint64_t maxBytesInMemory);
+
+			/// <summary>
+			/// Gets a snapshot of the payload bytes held in memory and on disk.
+			/// </summary>
+			/// <returns>
+			/// The current payload storage totals. Shared by the whole process, so valid even
+			/// when the Engine isn't running.
+			/// </returns>
+			util::mem::SpillBufferStats GetPayloadStorageStats() const;
+
+			/// <summary>
+			/// Sets the zlib compression level used whenever a payload has to be compressed
+			/// again. Applies to the whole process. Payloads that were only inspected are
+			/// written as they were received, and are never compressed again.
+			/// </summary>
+			/// <param name="level">
+			/// The compression level, from 0 for none to 9 for the best, or -1 for the zlib
+			/// default. Values outside of that range are clamped to it.
+			/// </param>
+			void SetCompressionLevel(const int32_t level);
+
+			/// <summary>
+			/// Gets a snapshot of the counters of the pipeline that delivers events to the host
+			/// callbacks.
+			/// </summary>
+			/// <returns>
+			/// The current event pipeline counters.
+			/// </returns>
+			util::cb::EventPipelineStats GetEventPipelineStats() const;
+
+			/// <summary>
+			/// Gets every counter of the Engine, and a summary of every latency histogram, as
+			/// text. Each line is a name, a space and a value. Latency histograms are kept
+			/// per thread and only summed here, so this is fine to call periodically while
+			/// the Engine is busy.
+			/// </summary>
+			/// <returns>
+			/// The snapshot. Counters of components that only exist while running read zero
+			/// when the Engine isn't.
+			/// </returns>
+			std::string GetStatsSnapshot() const;
+
 		private:
 
+			/// <summary>
+			/// Delivers every event reported by the Engine to the host callbacks, from a thread
+			/// of its own. Declared first so that it's destroyed last, after everything that
+			/// could still report through it.
+			/// </summary>
+			std::unique_ptr<util::cb::EventPipeline> m_eventPipeline;
+
 			/// <summary>
 			/// If defined, called whenever a packet flow is being considered for diversion to the
 			/// proxy, but the binary responsible for sending or receiving the flow has not yet been
@@ -225,21 +572,85 @@ namespace te
 			/// </summary>
 			uint32_t m_proxyNumThreads;
 
+			/// <summary>
+			/// Whether each proxy thread runs an io_service of its own. Read on every ::Start().
+			/// </summary>
+			bool m_ioServicePerThread = false;
+
+			/// <summary>
+			/// The limits given to the upstream connection pools of the acceptors. Held here
+			/// because the acceptors are recreated on every ::Start().
+			/// </summary>
+			uint32_t m_upstreamPoolMaxIdlePerHost;
+			uint32_t m_upstreamPoolMaxIdle;
+			uint32_t m_upstreamPoolIdleTimeout;
+
 			/// <summary>
 			/// Container for the threads driving the io_service.
 			/// </summary>
 			std::vector<std::thread> m_proxyServiceThreads;
 
 			/// <summary>
-			/// The io_service that will drive the proxy.
+			/// When each proxy thread runs an io_service of its own, the io_services of every
+			/// thread but the first, which runs m_service. Kept across restarts, like m_service,
+			/// and declared before it, since handlers left in m_service may hold bridges driven
+			/// by these.
+			/// </summary>
+			std::vector<std::unique_ptr<boost::asio::io_service>> m_workerServices;
+
+			/// <summary>
+			/// Keeps the worker io_services running while they have no bridges to drive.
+			/// </summary>
+			std::vector<std::unique_ptr<boost::asio::io_service::work>> m_workerWork;
+
+			/// <summary>
+			/// The io_service that will drive the proxy. When each proxy thread runs an
+			/// io_service of its own, it drives the acceptors, and the bridges handed to the
+			/// first thread.
 			/// </summary>
 			std::unique_ptr<boost::asio::io_service> m_service = nullptr;
 
+			/// <summary>
+			/// The timer wheels keeping the stream timeouts of bridges, one per io_service. The
+			/// first is driven by m_service, the rest by m_workerServices, in order. Declared
+			/// after both, so that they go before the io_services driving them.
+			/// </summary>
+			std::vector<std::unique_ptr<network::TimerWheel>> m_timerWheels;
+
 			/// <summary>
 			/// The certificate store that will be used for secure clients.
 			/// </summary>
 			std::unique_ptr<mitm::secure::BaseInMemoryCertificateStore> m_store = nullptr;
 
+			/// <summary>
+			/// The cache of resolved upstream hosts shared by the HTTP and HTTPS listeners.
+			/// </summary>
+			network::DnsCache m_dnsCache;
+
+			/// <summary>
+			/// The verdicts deferred by the callbacks, pending delivery by the host. Shared by
+			/// the HTTP and HTTPS listeners.
+			/// </summary>
+			util::cb::DeferredVerdictRegistry m_deferredVerdicts;
+
+			/// <summary>
+			/// The begin callback verdicts cached at the request of the host. Shared by the HTTP
+			/// and HTTPS listeners.
+			/// </summary>
+			util::cb::VerdictCache m_verdictCache;
+
+			/// <summary>
+			/// The rules checked ahead of the begin callback. Shared by the HTTP and HTTPS
+			/// listeners.
+			/// </summary>
+			util::cb::RuleTable m_rules;
+
+			/// <summary>
+			/// Decides which flows the diverter sends to the HTTP and HTTPS listeners. Kept
+			/// across restarts, and declared before m_diversionControl, which uses it.
+			/// </summary>
+			mitm::diversion::FlowClassifier m_flowClassifier;
+
 			/// <summary>
 			/// The diversion class that is responsible for diverting HTTP and HTTPS flows to the
 			/// HTTP and HTTPS listeners for filtering.
@@ -261,6 +672,17 @@ namespace te
 			/// </summary>
 			std::mutex m_ctlMutex;
 
+			/// <summary>
+			/// Guards m_lastSnapshotDiversion.
+			/// </summary>
+			mutable std::mutex m_snapshotMutex;
+
+			/// <summary>
+			/// The diversion counters as of the last call to ::GetStatsSnapshot(), which the
+			/// rates in the next one are taken over.
+			/// </summary>
+			mutable mitm::diversion::DiversionStats m_lastSnapshotDiversion;
+
 			/// <summary>
 			/// Used to indicate if all compontents were initialized and started correctly, and are
 			/// currently handling the process of diverting HTTP and HTTPS clients to the proxy to
@@ -270,17 +692,22 @@ namespace te
 
 			util::cb::HttpMessageBeginCheckFunction m_onMessageBegin;
 			util::cb::HttpMessageEndCheckFunction m_onMessageEnd;
+			util::cb::HttpMessageChunkCheckFunction m_onMessageChunk;
 
 			static void DummyOnMessageBeginCallback(
-				const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-				const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-				uint32_t* nextAction, CustomResponseStreamWriter responseWriter
+				HttpTransactionContext context,
+				uint32_t* nextAction
 			);
 
 			static void DummyOnMessageEndCallback(
-				const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-				const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-				bool* shouldBlock, CustomResponseStreamWriter responseWriter
+				HttpTransactionContext context,
+				bool* shouldBlock
+			);
+
+			static void DummyOnMessageChunkCallback(
+				HttpTransactionContext context,
+				const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+				uint32_t* nextAction
 			);
 
 		};
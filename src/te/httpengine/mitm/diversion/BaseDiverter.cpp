@@ -20,16 +20,24 @@ namespace te
 
 				BaseDiverter::BaseDiverter(
 					util::cb::FirewallCheckFunction firewallCheckCb,
+					FlowClassifier* flowClassifier,
 					util::cb::MessageFunction onInfo,
 					util::cb::MessageFunction onWarning,
 					util::cb::MessageFunction onError
 					) :
 					util::cb::EventReporter(onInfo,	onWarning, onError),
-					m_firewallCheckCb(firewallCheckCb)
+					m_firewallCheckCb(firewallCheckCb),
+					m_flowClassifier(flowClassifier)
 				{
 					m_httpListenerPort = 0;
 					m_httpsListenerPort = 0;
 					m_running = false;
+
+					m_packetsReceived = 0;
+					m_packetsModified = 0;
+					m_packetsSent = 0;
+					m_packetsDropped = 0;
+					m_receiveBatches = 0;
 				}
 
 				BaseDiverter::~BaseDiverter()
@@ -57,6 +65,44 @@ namespace te
 					m_httpsListenerPort = port;
 				}
 
+				DiversionStats BaseDiverter::GetStats()
+				{
+					DiversionStats stats;
+
+					stats.PacketsReceived = m_packetsReceived.load(std::memory_order_relaxed);
+					stats.PacketsModified = m_packetsModified.load(std::memory_order_relaxed);
+					stats.PacketsSent = m_packetsSent.load(std::memory_order_relaxed);
+					stats.PacketsDropped = m_packetsDropped.load(std::memory_order_relaxed);
+					stats.ReceiveBatches = m_receiveBatches.load(std::memory_order_relaxed);
+					stats.SampledAt = std::chrono::steady_clock::now();
+
+					return stats;
+				}
+
+				void BaseDiverter::CalculateRates(DiversionStats& current, const DiversionStats& previous)
+				{
+					current.ReceivedPerSecond = 0.0;
+					current.SentPerSecond = 0.0;
+
+					if (previous.SampledAt == std::chrono::steady_clock::time_point())
+					{
+						return;
+					}
+
+					std::chrono::duration<double> elapsed = current.SampledAt - previous.SampledAt;
+
+					if (elapsed.count() > 0.0 && current.PacketsReceived >= previous.PacketsReceived && current.PacketsSent >= previous.PacketsSent)
+					{
+						current.ReceivedPerSecond = static_cast<double>(current.PacketsReceived - previous.PacketsReceived) / elapsed.count();
+						current.SentPerSecond = static_cast<double>(current.PacketsSent - previous.PacketsSent) / elapsed.count();
+					}
+				}
+
+				void BaseDiverter::ClearFirewallVerdicts()
+				{
+
+				}
+
 				const bool BaseDiverter::IsV4AddressPrivate(const std::array<uint8_t, 4> bytes) const
 				{
 					switch (bytes[0])
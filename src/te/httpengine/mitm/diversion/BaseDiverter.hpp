@@ -9,7 +9,10 @@
 
 #include <atomic>
 #include <array>
+#include <chrono>
+#include <mutex>
 #include "../../util/cb/EventReporter.hpp"
+#include "FlowClassifier.hpp"
 
 namespace te
 {
@@ -20,13 +23,81 @@ namespace te
 			namespace diversion
 			{
 
+				/// <summary>
+				/// Point in time snapshot of the packet counters kept by a diverter. The totals
+				/// are cumulative for the lifetime of the diverter. The per second rates are
+				/// only filled in by BaseDiverter::CalculateRates(...), against an earlier
+				/// snapshot the caller kept, so that every consumer gets rates over its own
+				/// interval.
+				/// </summary>
+				struct DiversionStats
+				{
+					/// <summary>
+					/// Total number of packets read from the diversion mechanism.
+					/// </summary>
+					uint64_t PacketsReceived = 0;
+
+					/// <summary>
+					/// Total number of packets that were rewritten, aka diverted to or from the
+					/// proxy.
+					/// </summary>
+					uint64_t PacketsModified = 0;
+
+					/// <summary>
+					/// Total number of packets that were successfully reinjected.
+					/// </summary>
+					uint64_t PacketsSent = 0;
+
+					/// <summary>
+					/// Total number of packets that were either deliberately dropped or failed
+					/// to be reinjected.
+					/// </summary>
+					uint64_t PacketsDropped = 0;
+
+					/// <summary>
+					/// Total number of receive batches processed. PacketsReceived divided by this
+					/// value gives the average batch size.
+					/// </summary>
+					uint64_t ReceiveBatches = 0;
+
+					/// <summary>
+					/// When the snapshot was taken.
+					/// </summary>
+					std::chrono::steady_clock::time_point SampledAt;
+
+					/// <summary>
+					/// Packets received per second since the previous snapshot.
+					/// </summary>
+					double ReceivedPerSecond = 0.0;
+
+					/// <summary>
+					/// Packets reinjected per second since the previous snapshot.
+					/// </summary>
+					double SentPerSecond = 0.0;
+
+					/// <summary>
+					/// Total number of new connections whose firewall verdict was served from
+					/// the diverter's verdict cache. Zero for diverters that don't cache.
+					/// </summary>
+					uint64_t VerdictCacheHits = 0;
+
+					/// <summary>
+					/// Total number of new connections that required the firewall check
+					/// callback to be invoked.
+					/// </summary>
+					uint64_t VerdictCacheMisses = 0;
+				};
+
 				/// <summary>
 				/// The BaseDiverter serves as the base class for all platform dependent packet
 				/// diversion mechanisms. For each supported platform, a specialized diversion class
 				/// must be created and must inherit from this.
 				/// 
-				/// XXX TODO - Need port-independent protocol mapping for plain HTTP and TLS traffic,
-				/// along with a flow tracking mechanism to properly support such a mechanism.
+				/// Which flows are diverted, and to which listener, is up to the FlowClassifier
+				/// supplied, if any. Implementations track flows by local port, hand it the first
+				/// payload of each flow it asks to see, and record the original port of each
+				/// diverted flow in network::OriginalPortTable. Without a FlowClassifier, flows
+				/// to the standard HTTP and HTTPS ports are diverted, and nothing else.
 				/// </summary>
 				class BaseDiverter : public util::cb::EventReporter
 				{
@@ -110,10 +181,42 @@ namespace te
 					/// </returns>
 					virtual const bool IsRunning() const = 0;
 
+					/// <summary>
+					/// Gets a snapshot of the packet counters for this diverter. Rates are left at
+					/// zero. Consumers wanting them keep their previous snapshot and pass both to
+					/// ::CalculateRates(...), so that any number of them can poll at their own
+					/// intervals without disturbing each other.
+					/// </summary>
+					/// <returns>
+					/// A snapshot of the current packet counters.
+					/// </returns>
+					virtual DiversionStats GetStats();
+
+					/// <summary>
+					/// Fills in the per second rates of the supplied snapshot, over the interval
+					/// since the supplied previous snapshot of the same diverter.
+					/// </summary>
+					/// <param name="current">
+					/// The snapshot to fill in the rates of.
+					/// </param>
+					/// <param name="previous">
+					/// An earlier snapshot. If it was never taken, or isn't earlier, the rates are
+					/// left at zero.
+					/// </param>
+					static void CalculateRates(DiversionStats& current, const DiversionStats& previous);
+
+					/// <summary>
+					/// Drops any firewall verdicts the diverter has cached. Must be called when
+					/// the rules behind the firewall check callback change. The default
+					/// implementation does nothing, for diverters that don't cache verdicts.
+					/// </summary>
+					virtual void ClearFirewallVerdicts();
+
 				protected:
 
 					BaseDiverter(
 						util::cb::FirewallCheckFunction firewallCheckCb = nullptr,
+						FlowClassifier* flowClassifier = nullptr,
 						util::cb::MessageFunction onInfo = nullptr,
 						util::cb::MessageFunction onWarning = nullptr,
 						util::cb::MessageFunction onError = nullptr
@@ -171,6 +274,38 @@ namespace te
 					/// </summary>
 					util::cb::FirewallCheckFunction m_firewallCheckCb;
 
+					/// <summary>
+					/// Decides where new flows go. Owned by the Engine, which keeps it across
+					/// restarts of the diverter. May be null.
+					/// </summary>
+					FlowClassifier* m_flowClassifier;
+
+					/// <summary>
+					/// Total packets read from the diversion mechanism. Implementations are
+					/// responsible for incrementing this and the following counters.
+					/// </summary>
+					std::atomic_uint64_t m_packetsReceived;
+
+					/// <summary>
+					/// Total packets rewritten to or from the proxy.
+					/// </summary>
+					std::atomic_uint64_t m_packetsModified;
+
+					/// <summary>
+					/// Total packets successfully reinjected.
+					/// </summary>
+					std::atomic_uint64_t m_packetsSent;
+
+					/// <summary>
+					/// Total packets dropped, either deliberately or due to reinjection failure.
+					/// </summary>
+					std::atomic_uint64_t m_packetsDropped;
+
+					/// <summary>
+					/// Total receive batches processed.
+					/// </summary>
+					std::atomic_uint64_t m_receiveBatches;
+
 				};
 
 			} /* namespace diversion */
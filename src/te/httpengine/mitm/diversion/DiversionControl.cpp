@@ -6,6 +6,7 @@
 */
 
 #include "DiversionControl.hpp"
+#include "BaseDiverter.hpp"
 
 #include <boost/predef/os.h>
 
@@ -29,6 +30,7 @@ namespace te
 
 				DiversionControl::DiversionControl(
 					util::cb::FirewallCheckFunction firewallCheckCb,
+					FlowClassifier* flowClassifier,
 					util::cb::MessageFunction onInfo,
 					util::cb::MessageFunction onWarning,
 					util::cb::MessageFunction onError
@@ -40,7 +42,7 @@ namespace te
 						)
 				{
 					#if BOOST_OS_WINDOWS
-						m_diverter.reset(new WinDiverter(firewallCheckCb, onInfo, onWarning, onError));
+						m_diverter.reset(new WinDiverter(firewallCheckCb, flowClassifier, onInfo, onWarning, onError));
 					#elif BOOST_OS_ANDROID
 						m_diverter.reset(new AndroidDiverter(onInfo, onWarning, onError));
 					#endif	
@@ -95,6 +97,16 @@ namespace te
 					return m_diverter->IsRunning();
 				}
 
+				DiversionStats DiversionControl::GetStats()
+				{
+					return m_diverter->GetStats();
+				}
+
+				void DiversionControl::ClearFirewallVerdicts()
+				{
+					m_diverter->ClearFirewallVerdicts();
+				}
+
 			} /* namespace diversion */
 		}/* namespace mitm */
 	}/* namespace httpengine */
@@ -25,6 +25,16 @@ namespace te
 				/// </summary>
 				class BaseDiverter;
 
+				/// <summary>
+				/// Forward decl DiversionStats.
+				/// </summary>
+				struct DiversionStats;
+
+				/// <summary>
+				/// Forward decl FlowClassifier.
+				/// </summary>
+				class FlowClassifier;
+
 				/// <summary>
 				/// The DiversionControl class is meant to serve as the static interface to
 				/// polymorphic platform specific implementations of packet diversion capabilities,
@@ -53,6 +63,10 @@ namespace te
 					/// to be sent outbound from the device. Needed on most platforms for most
 					/// implementations, so a valid function pointer is required here.
 					/// </param>
+					/// <param name="flowClassifier">
+					/// Decides which flows are diverted, and to which listener. Must outlive this
+					/// object. Optional, for diverting only the standard HTTP and HTTPS ports.
+					/// </param>
 					/// <param name="onInfo">
 					/// Optional callback to receive informational messages regarding non-critical events.
 					/// </param>
@@ -66,6 +80,7 @@ namespace te
 					/// </param>
 					DiversionControl(
 						util::cb::FirewallCheckFunction firewallCheckCb,
+						FlowClassifier* flowClassifier = nullptr,
 						util::cb::MessageFunction onInfo = nullptr,
 						util::cb::MessageFunction onWarning = nullptr,
 						util::cb::MessageFunction onError = nullptr
@@ -139,6 +154,21 @@ namespace te
 					/// </returns>
 					const bool IsRunning() const;
 
+					/// <summary>
+					/// Gets a snapshot of the packet counters kept by the underlying diverter.
+					/// See BaseDiverter::CalculateRates(...) for how to get rates from it.
+					/// </summary>
+					/// <returns>
+					/// A snapshot of the current packet counters.
+					/// </returns>
+					DiversionStats GetStats();
+
+					/// <summary>
+					/// Drops any firewall verdicts cached by the underlying diverter. See
+					/// BaseDiverter::ClearFirewallVerdicts().
+					/// </summary>
+					void ClearFirewallVerdicts();
+
 				private:
 
 					std::unique_ptr<BaseDiverter> m_diverter;
@@ -0,0 +1,369 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "FlowClassifier.hpp"
+
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include "../secure/ApplicationProtocols.hpp"
+#include "../../util/tls/ClientHello.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				namespace
+				{
+					static constexpr uint16_t StandardHttpPort = 80;
+
+					static constexpr uint16_t StandardHttpsPort = 443;
+
+					static constexpr uint8_t HandshakeContentType = 22;
+
+					/// <summary>
+					/// The methods a request straight to a server is expected to start with.
+					/// CONNECT is left out on purpose, since it's only ever sent to a proxy.
+					/// </summary>
+					static const boost::string_ref HttpMethods[] =
+					{
+						u8"GET", u8"POST", u8"HEAD", u8"PUT", u8"DELETE", u8"OPTIONS", u8"PATCH", u8"TRACE"
+					};
+
+					inline const bool IsStandardPort(const uint16_t port)
+					{
+						return port == StandardHttpPort || port == StandardHttpsPort;
+					}
+
+					inline const bool IsProxyRoute(const FlowRoute route)
+					{
+						return route == FlowRoute::HttpProxy || route == FlowRoute::HttpsProxy;
+					}
+				}
+
+				size_t FlowClassifier::FlowEndpointHash::operator()(const FlowEndpoint& endpoint) const
+				{
+					std::size_t seed = 0;
+					boost::hash_combine(seed, endpoint.Address[0]);
+					boost::hash_combine(seed, endpoint.Address[1]);
+					boost::hash_combine(seed, endpoint.Address[2]);
+					boost::hash_combine(seed, endpoint.Address[3]);
+					boost::hash_combine(seed, endpoint.Port);
+					boost::hash_combine(seed, endpoint.V6);
+					return seed;
+				}
+
+				const FlowProtocol FlowClassifier::ClassifyPayload(const uint8_t* payload, const size_t payloadSize)
+				{
+					if (payload == nullptr || payloadSize == 0)
+					{
+						return FlowProtocol::Unknown;
+					}
+
+					if (payload[0] == HandshakeContentType)
+					{
+						if (payloadSize < 3)
+						{
+							return FlowProtocol::Unknown;
+						}
+
+						if (payload[1] != 3)
+						{
+							return FlowProtocol::Other;
+						}
+
+						const char* hello = reinterpret_cast<const char*>(payload);
+
+						if (util::tls::OffersProtocol(hello, payloadSize, u8"http/1.1"))
+						{
+							return FlowProtocol::HttpOverTls;
+						}
+
+						// An h2 only client can be bridged too, but only while the HTTP/2 layer is
+						// switched on.
+						if (secure::ApplicationProtocols::IsHttp2Enabled() && util::tls::OffersProtocol(hello, payloadSize, u8"h2"))
+						{
+							return FlowProtocol::HttpOverTls;
+						}
+
+						return util::tls::OffersOtherProtocolsOnly(hello, payloadSize, u8"http/1.1") ? FlowProtocol::OtherOverTls : FlowProtocol::Tls;
+					}
+
+					const boost::string_ref data(reinterpret_cast<const char*>(payload), payloadSize);
+
+					bool couldBeHttp = false;
+
+					for (const auto& method : HttpMethods)
+					{
+						if (data.substr(0, method.size()) != method.substr(0, data.size()))
+						{
+							continue;
+						}
+
+						// The method, a space, and the first character of the target.
+						if (data.size() < method.size() + 2)
+						{
+							couldBeHttp = true;
+							continue;
+						}
+
+						if (data[method.size()] != ' ')
+						{
+							continue;
+						}
+
+						// A request straight to a server names its target by path, or as "*".
+						// Absolute and authority forms are for proxies, which we have no
+						// business standing in for.
+						const char target = data[method.size() + 1];
+
+						return (target == '/' || target == '*') ? FlowProtocol::Http : FlowProtocol::Other;
+					}
+
+					return couldBeHttp ? FlowProtocol::Unknown : FlowProtocol::Other;
+				}
+
+				FlowClassifier::FlowClassifier()
+				{
+					m_portIndependent = true;
+					m_flowsBypassed = 0;
+					m_flowsRedirected = 0;
+				}
+
+				FlowClassifier::~FlowClassifier()
+				{
+
+				}
+
+				const FlowRoute FlowClassifier::GetRoute(const FlowEndpoint& destination)
+				{
+					if (!IsStandardPort(destination.Port) && !m_portIndependent)
+					{
+						return FlowRoute::Direct;
+					}
+
+					const FlowRoute defaultRoute = GetDefaultRoute(destination.Port);
+					FlowRoute route = defaultRoute;
+
+					{
+						std::lock_guard<std::mutex> lock(m_endpointsMutex);
+
+						auto it = m_endpoints.find(destination);
+
+						if (it != m_endpoints.end())
+						{
+							if (it->second.expires <= std::chrono::steady_clock::now())
+							{
+								m_endpoints.erase(it);
+							}
+							else
+							{
+								route = it->second.route;
+							}
+						}
+					}
+
+					if (route != defaultRoute)
+					{
+						if (IsProxyRoute(route))
+						{
+							++m_flowsRedirected;
+						}
+						else
+						{
+							++m_flowsBypassed;
+						}
+					}
+
+					return route;
+				}
+
+				void FlowClassifier::OnFirstPayload(const FlowEndpoint& destination, const FlowRoute route, const uint8_t* payload, const size_t payloadSize)
+				{
+					if (route == FlowRoute::Direct)
+					{
+						return;
+					}
+
+					const FlowProtocol protocol = Classify(payload, payloadSize);
+
+					if (protocol == FlowProtocol::Unknown)
+					{
+						return;
+					}
+
+					const FlowRoute wanted = GetWantedRoute(destination.Port, protocol);
+
+					if (wanted == route)
+					{
+						return;
+					}
+
+					std::lock_guard<std::mutex> lock(m_endpointsMutex);
+
+					if (wanted == GetDefaultRoute(destination.Port))
+					{
+						m_endpoints.erase(destination);
+						return;
+					}
+
+					Learn(destination, wanted);
+				}
+
+				const FlowProtocol FlowClassifier::Classify(const uint8_t* payload, const size_t payloadSize) const
+				{
+					const FlowProtocol protocol = ClassifyPayload(payload, payloadSize);
+
+					if ((protocol == FlowProtocol::Tls || protocol == FlowProtocol::HttpOverTls) && m_sniExemptions.GetRuleCount() > 0)
+					{
+						boost::string_ref serverName;
+
+						if (util::tls::FindServerName(reinterpret_cast<const char*>(payload), payloadSize, serverName) == util::tls::ClientHelloStatus::ServerNameFound)
+						{
+							util::cb::RuleAction action;
+
+							if (m_sniExemptions.Match(serverName, boost::string_ref(), util::http::MediaKindSet(), false, 0, action))
+							{
+								return FlowProtocol::Exempt;
+							}
+						}
+					}
+
+					return protocol;
+				}
+
+				void FlowClassifier::SetSniExemptions(const std::vector<std::string>& hosts)
+				{
+					std::vector<util::cb::Rule> rules;
+					rules.reserve(hosts.size());
+
+					for (const auto& host : hosts)
+					{
+						if (host.size() == 0)
+						{
+							// An empty suffix would match every host.
+							continue;
+						}
+
+						util::cb::Rule rule;
+						rule.Action = util::cb::RuleAction::PassWithoutInspect;
+						rule.HostSuffix = host;
+
+						rules.push_back(std::move(rule));
+					}
+
+					m_sniExemptions.Load(rules);
+
+					Clear();
+				}
+
+				void FlowClassifier::SetPortIndependentDiversion(const bool enabled)
+				{
+					m_portIndependent = enabled;
+				}
+
+				void FlowClassifier::Clear()
+				{
+					std::lock_guard<std::mutex> lock(m_endpointsMutex);
+					m_endpoints.clear();
+				}
+
+				FlowClassifierStats FlowClassifier::GetStats() const
+				{
+					FlowClassifierStats stats;
+
+					stats.FlowsBypassed = m_flowsBypassed;
+					stats.FlowsRedirected = m_flowsRedirected;
+
+					std::lock_guard<std::mutex> lock(m_endpointsMutex);
+					stats.EndpointsLearned = static_cast<uint32_t>(m_endpoints.size());
+
+					return stats;
+				}
+
+				const FlowRoute FlowClassifier::GetDefaultRoute(const uint16_t port) const
+				{
+					switch (port)
+					{
+						case StandardHttpPort:
+						{
+							return FlowRoute::HttpProxy;
+						}
+
+						case StandardHttpsPort:
+						{
+							return FlowRoute::HttpsProxy;
+						}
+
+						default:
+						{
+							return m_portIndependent ? FlowRoute::Observe : FlowRoute::Direct;
+						}
+					}
+				}
+
+				const FlowRoute FlowClassifier::GetWantedRoute(const uint16_t port, const FlowProtocol protocol)
+				{
+					switch (protocol)
+					{
+						case FlowProtocol::Http:
+						{
+							return FlowRoute::HttpProxy;
+						}
+
+						case FlowProtocol::Tls:
+						{
+							// Without ALPN to go by, TLS is only taken to be HTTPS on its own port.
+							// Elsewhere, it may just as well be mail, or anything else.
+							return port == StandardHttpsPort ? FlowRoute::HttpsProxy : FlowRoute::Observe;
+						}
+
+						case FlowProtocol::HttpOverTls:
+						{
+							return FlowRoute::HttpsProxy;
+						}
+
+						default:
+						{
+							return FlowRoute::Observe;
+						}
+					}
+				}
+
+				void FlowClassifier::Learn(const FlowEndpoint& destination, const FlowRoute route)
+				{
+					const auto now = std::chrono::steady_clock::now();
+
+					if (m_endpoints.size() >= MaxEndpoints && m_endpoints.find(destination) == m_endpoints.end())
+					{
+						for (auto it = m_endpoints.begin(); it != m_endpoints.end();)
+						{
+							it = it->second.expires <= now ? m_endpoints.erase(it) : std::next(it);
+						}
+
+						if (m_endpoints.size() >= MaxEndpoints)
+						{
+							// Forgetting is always safe, it only sends flows where their port
+							// implies until they're learned again.
+							m_endpoints.clear();
+						}
+					}
+
+					Entry& entry = m_endpoints[destination];
+					entry.route = route;
+					entry.expires = now + std::chrono::seconds(static_cast<std::chrono::seconds::rep>(EndpointLifetimeSeconds));
+				}
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
@@ -0,0 +1,347 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../util/cb/RuleTable.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				/// <summary>
+				/// What the first payload of a flow looks like.
+				/// </summary>
+				enum class FlowProtocol : uint8_t
+				{
+					/// <summary>
+					/// Too little of the payload to tell.
+					/// </summary>
+					Unknown = 0,
+
+					/// <summary>
+					/// An HTTP request in origin form, as sent straight to a server.
+					/// </summary>
+					Http,
+
+					/// <summary>
+					/// A TLS client hello that doesn't offer HTTP over ALPN.
+					/// </summary>
+					Tls,
+
+					/// <summary>
+					/// A TLS client hello offering HTTP over ALPN.
+					/// </summary>
+					HttpOverTls,
+
+					/// <summary>
+					/// A TLS client hello offering only protocols other than HTTP/1.1 over ALPN,
+					/// such as an HTTP/2 only client. The bridge can't speak any of them.
+					/// </summary>
+					OtherOverTls,
+
+					/// <summary>
+					/// A TLS client hello for a host exempted from filtering.
+					/// </summary>
+					Exempt,
+
+					/// <summary>
+					/// Anything else. That includes HTTP requests meant for a proxy, which are
+					/// in absolute or authority form.
+					/// </summary>
+					Other
+				};
+
+				/// <summary>
+				/// Where the packets of a flow go.
+				/// </summary>
+				enum class FlowRoute : uint8_t
+				{
+					/// <summary>
+					/// Sent on unmodified, and not looked at again.
+					/// </summary>
+					Direct = 0,
+
+					/// <summary>
+					/// Sent on unmodified, but the first payload is to be handed to
+					/// FlowClassifier::OnFirstPayload(...).
+					/// </summary>
+					Observe,
+
+					/// <summary>
+					/// Diverted to the HTTP listener.
+					/// </summary>
+					HttpProxy,
+
+					/// <summary>
+					/// Diverted to the HTTPS listener.
+					/// </summary>
+					HttpsProxy
+				};
+
+				/// <summary>
+				/// The address and port a flow is headed for.
+				/// </summary>
+				struct FlowEndpoint
+				{
+					/// <summary>
+					/// The address, as it appears in the packet. IPV4 addresses only use the
+					/// first element.
+					/// </summary>
+					std::array<uint32_t, 4> Address = {};
+
+					/// <summary>
+					/// The port, in host order.
+					/// </summary>
+					uint16_t Port = 0;
+
+					bool V6 = false;
+
+					const bool operator==(const FlowEndpoint& other) const
+					{
+						return Port == other.Port && V6 == other.V6 && Address == other.Address;
+					}
+				};
+
+				/// <summary>
+				/// Point in time snapshot of the flow classifier counters.
+				/// </summary>
+				struct FlowClassifierStats
+				{
+					/// <summary>
+					/// Total number of new flows on the standard HTTP and HTTPS ports that were
+					/// sent on unmodified, because earlier flows to the same endpoint turned out
+					/// not to be HTTP or TLS, or to be exempted.
+					/// </summary>
+					uint64_t FlowsBypassed = 0;
+
+					/// <summary>
+					/// Total number of new flows that were diverted somewhere other than their
+					/// port implies, mostly flows on other ports, because earlier flows to the
+					/// same endpoint turned out to be HTTP or TLS.
+					/// </summary>
+					uint64_t FlowsRedirected = 0;
+
+					/// <summary>
+					/// The number of endpoints presently remembered.
+					/// </summary>
+					uint32_t EndpointsLearned = 0;
+				};
+
+				/// <summary>
+				/// The FlowClassifier decides where new flows go from what the first payloads of
+				/// earlier flows to the same endpoint looked like. It is shared by every diversion
+				/// thread, kept across restarts of the diverter, and is safe to use from any
+				/// thread.
+				///
+				/// A flow is only ever diverted, or not, with its first packet. By the time its
+				/// first payload shows up, its handshake has gone either to a listener or to the
+				/// server, and there's no moving it. So the first payload of a flow decides for
+				/// the flows that follow it to the same address and port instead. Flows on the
+				/// standard ports are diverted until one to their endpoint turns out not to be
+				/// HTTP or TLS, to be TLS offering only protocols the bridge can't speak, or to
+				/// be for an exempted host. Flows on other ports are sent on,
+				/// and watched, until one to their endpoint turns out to be HTTP, or TLS
+				/// offering HTTP. Only endpoints that differ from what their port implies are
+				/// remembered, for a limited time.
+				///
+				/// The first payload is only ever a single packet, so a client hello spread
+				/// over more than one may not show its server name, or what it offers over ALPN.
+				/// Such a flow decides nothing about exemptions, and is taken to be TLS that
+				/// doesn't say what it offers.
+				/// </summary>
+				class FlowClassifier
+				{
+
+				public:
+
+					/// <summary>
+					/// The largest number of endpoints remembered at once.
+					/// </summary>
+					static constexpr size_t MaxEndpoints = 16384;
+
+					/// <summary>
+					/// The number of seconds an endpoint is remembered for.
+					/// </summary>
+					static constexpr uint32_t EndpointLifetimeSeconds = 600;
+
+					/// <summary>
+					/// Classifies the supplied payload without regard to exemptions.
+					/// </summary>
+					/// <param name="payload">
+					/// The payload of the first packet of the flow to carry one.
+					/// </param>
+					/// <param name="payloadSize">
+					/// The size of the payload.
+					/// </param>
+					/// <returns>
+					/// What the payload looks like. Never FlowProtocol::Exempt.
+					/// </returns>
+					static const FlowProtocol ClassifyPayload(const uint8_t* payload, const size_t payloadSize);
+
+					/// <summary>
+					/// Constructs a new FlowClassifier, with no exemptions, which diverts flows
+					/// on any port once they're seen to be HTTP or TLS.
+					/// </summary>
+					FlowClassifier();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					FlowClassifier(const FlowClassifier&) = delete;
+					FlowClassifier(FlowClassifier&&) = delete;
+					FlowClassifier& operator=(const FlowClassifier&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~FlowClassifier();
+
+					/// <summary>
+					/// Gets the route for a new flow to the supplied endpoint.
+					/// </summary>
+					/// <param name="destination">
+					/// Where the flow is headed.
+					/// </param>
+					/// <returns>
+					/// The route the flow is to take.
+					/// </returns>
+					const FlowRoute GetRoute(const FlowEndpoint& destination);
+
+					/// <summary>
+					/// Learns from the first payload of a flow, for the flows that follow it to
+					/// the same endpoint.
+					/// </summary>
+					/// <param name="destination">
+					/// Where the flow is headed.
+					/// </param>
+					/// <param name="route">
+					/// The route the flow was given by ::GetRoute(...).
+					/// </param>
+					/// <param name="payload">
+					/// The payload of the first packet of the flow to carry one.
+					/// </param>
+					/// <param name="payloadSize">
+					/// The size of the payload.
+					/// </param>
+					void OnFirstPayload(const FlowEndpoint& destination, const FlowRoute route, const uint8_t* payload, const size_t payloadSize);
+
+					/// <summary>
+					/// Classifies the supplied payload, reporting TLS flows for exempted hosts
+					/// as such.
+					/// </summary>
+					const FlowProtocol Classify(const uint8_t* payload, const size_t payloadSize) const;
+
+					/// <summary>
+					/// Replaces the hosts whose TLS flows are never diverted. Each matches the
+					/// host itself and any host under it, as with the host suffix of a rule.
+					/// Since flows are told apart by endpoint, every host served from the
+					/// address and port of an exempted host is exempted along with it, until a
+					/// flow for one that isn't is seen there. Forgets every endpoint, since what
+					/// was learned under the old exemptions no longer holds.
+					/// </summary>
+					/// <param name="hosts">
+					/// The exempted hosts.
+					/// </param>
+					void SetSniExemptions(const std::vector<std::string>& hosts);
+
+					/// <summary>
+					/// Sets whether flows on ports other than the standard HTTP and HTTPS ports
+					/// are watched, and diverted once seen to be HTTP or TLS.
+					/// </summary>
+					/// <param name="enabled">
+					/// True to divert HTTP and TLS on any port, false for the standard ports only.
+					/// </param>
+					void SetPortIndependentDiversion(const bool enabled);
+
+					/// <summary>
+					/// Forgets every endpoint, so that new flows go wherever their port implies
+					/// again.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Gets a snapshot of the counters of the classifier.
+					/// </summary>
+					FlowClassifierStats GetStats() const;
+
+				private:
+
+					/// <summary>
+					/// Hash implementation for FlowEndpoint.
+					/// </summary>
+					struct FlowEndpointHash
+					{
+						size_t operator()(const FlowEndpoint& endpoint) const;
+					};
+
+					struct Entry
+					{
+						FlowRoute route;
+
+						std::chrono::steady_clock::time_point expires;
+					};
+
+					/// <summary>
+					/// The route a new flow takes to an endpoint that isn't remembered.
+					/// </summary>
+					const FlowRoute GetDefaultRoute(const uint16_t port) const;
+
+					/// <summary>
+					/// The route that flows of the supplied protocol to the supplied port should
+					/// take.
+					/// </summary>
+					static const FlowRoute GetWantedRoute(const uint16_t port, const FlowProtocol protocol);
+
+					/// <summary>
+					/// Remembers the supplied route for an endpoint. Must be called with
+					/// m_endpointsMutex held.
+					/// </summary>
+					void Learn(const FlowEndpoint& destination, const FlowRoute route);
+
+					/// <summary>
+					/// The hosts whose TLS flows are never diverted, as the host suffixes of
+					/// rules, so that they're matched just the same.
+					/// </summary>
+					util::cb::RuleTable m_sniExemptions;
+
+					std::atomic_bool m_portIndependent;
+
+					/// <summary>
+					/// Guards m_endpoints.
+					/// </summary>
+					mutable std::mutex m_endpointsMutex;
+
+					/// <summary>
+					/// The endpoints whose flows go somewhere other than their port implies.
+					/// </summary>
+					std::unordered_map<FlowEndpoint, Entry, FlowEndpointHash> m_endpoints;
+
+					std::atomic_uint64_t m_flowsBypassed;
+
+					std::atomic_uint64_t m_flowsRedirected;
+
+				};
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
@@ -0,0 +1,192 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "ProcessVerdictCache.hpp"
+
+#include <stdexcept>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				ProcessVerdictCache::ProcessVerdictCache(
+					util::cb::FirewallCheckFunction firewallCheckCb,
+					util::cb::MessageFunction onInfo,
+					util::cb::MessageFunction onWarning,
+					util::cb::MessageFunction onError
+					) :
+					util::cb::EventReporter(onInfo, onWarning, onError),
+					m_firewallCheckCb(firewallCheckCb)
+				{
+					if (!m_firewallCheckCb)
+					{
+						throw std::runtime_error(u8"In ProcessVerdictCache::ProcessVerdictCache(...) - No valid firewall check callback was supplied.");
+					}
+
+					m_clearGeneration = 0;
+					m_hits = 0;
+					m_misses = 0;
+				}
+
+				ProcessVerdictCache::~ProcessVerdictCache()
+				{
+					Clear();
+				}
+
+				bool ProcessVerdictCache::ShouldFilter(const DWORD processId)
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+						auto it = m_cache.find(processId);
+						if (it != m_cache.end())
+						{
+							if (!HasExited(it->second.processHandle))
+							{
+								++m_hits;
+								return it->second.shouldFilter;
+							}
+
+							// The process we cached is gone, so this ID now belongs to
+							// someone else, or is about to.
+							CloseHandle(it->second.processHandle);
+							m_cache.erase(it);
+						}
+					}
+
+					++m_misses;
+
+					const uint64_t seenGeneration = m_clearGeneration.load();
+
+					// SYNCHRONIZE is what lets us poll the handle for exit later on.
+					HANDLE processHandle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, processId);
+
+					if (processHandle == nullptr || processHandle == INVALID_HANDLE_VALUE)
+					{
+						#ifndef NDEBUG
+						std::string err(u8"In ProcessVerdictCache::ShouldFilter(const DWORD) - Failed to open process to query binary path using pid ");
+						err.append(std::to_string(processId)).append(u8".");
+						ReportError(err);
+						#endif
+
+						// This is something we couldn't get a handle on. Since we can't do that
+						// that's probably a bad sign (SYSTEM process maybe?), don't filter it.
+						return false;
+					}
+
+					CachedProcess entry;
+					entry.processHandle = processHandle;
+					entry.binaryPath = QueryBinaryPath(processHandle, processId);
+
+					if (entry.binaryPath.size() == 0)
+					{
+						CloseHandle(processHandle);
+						return false;
+					}
+
+					// Deliberately not holding the lock here. This calls out to user code,
+					// and there's no reason for every other new connection to wait on it.
+					entry.shouldFilter = m_firewallCheckCb(entry.binaryPath.c_str(), entry.binaryPath.size());
+
+					const bool shouldFilter = entry.shouldFilter;
+
+					std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+					if (m_clearGeneration.load() != seenGeneration)
+					{
+						// Rules changed while we were asking. Don't cache a stale answer.
+						CloseHandle(processHandle);
+						return shouldFilter;
+					}
+
+					auto inserted = m_cache.emplace(processId, std::move(entry));
+					if (!inserted.second)
+					{
+						// Another thread resolved the same process while we were. Keep theirs.
+						CloseHandle(processHandle);
+					}
+					else if (++m_insertsSinceSweep >= SweepInterval)
+					{
+						SweepExited();
+						m_insertsSinceSweep = 0;
+					}
+
+					return shouldFilter;
+				}
+
+				void ProcessVerdictCache::Clear()
+				{
+					std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+					++m_clearGeneration;
+
+					for (auto& entry : m_cache)
+					{
+						CloseHandle(entry.second.processHandle);
+					}
+
+					m_cache.clear();
+					m_insertsSinceSweep = 0;
+				}
+
+				const uint64_t ProcessVerdictCache::GetHits() const
+				{
+					return m_hits;
+				}
+
+				const uint64_t ProcessVerdictCache::GetMisses() const
+				{
+					return m_misses;
+				}
+
+				std::string ProcessVerdictCache::QueryBinaryPath(HANDLE processHandle, const DWORD processId)
+				{
+					DWORD resSize = MAX_PATH;
+					char filename[MAX_PATH];
+
+					if (QueryFullProcessImageNameA(processHandle, 0, filename, &resSize) == 0)
+					{
+						std::string err(u8"In ProcessVerdictCache::QueryBinaryPath(HANDLE, const DWORD) - Failed to get binary path using pid ");
+						err.append(std::to_string(processId)).append(u8".");
+						ReportError(err);
+
+						return std::string();
+					}
+
+					return std::string(filename, resSize);
+				}
+
+				void ProcessVerdictCache::SweepExited()
+				{
+					for (auto it = m_cache.begin(); it != m_cache.end();)
+					{
+						if (HasExited(it->second.processHandle))
+						{
+							CloseHandle(it->second.processHandle);
+							it = m_cache.erase(it);
+						}
+						else
+						{
+							++it;
+						}
+					}
+				}
+
+				bool ProcessVerdictCache::HasExited(HANDLE processHandle)
+				{
+					return WaitForSingleObject(processHandle, 0) != WAIT_TIMEOUT;
+				}
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
@@ -0,0 +1,192 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../../../../util/cb/EventReporter.hpp"
+
+#include <windows.h>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				/// <summary>
+				/// The ProcessVerdictCache remembers, per process ID, the full path of the
+				/// process binary and the verdict the firewall check callback gave for it. A
+				/// browser will open dozens of connections per page, and without this every
+				/// single one of them would open the process, query its image name and call
+				/// out to the user's firewall callback, which is typically managed code.
+				///
+				/// Each entry holds an open handle to its process. As long as we hold that
+				/// handle, the process object stays alive and the OS can't hand its ID out to
+				/// a new process, so an entry can't be confused by PID reuse. On every hit the
+				/// handle is polled, and if the process has exited, the entry is dropped and
+				/// the new owner of the ID, if any, is looked up fresh.
+				/// </summary>
+				class ProcessVerdictCache : public util::cb::EventReporter
+				{
+
+				public:
+
+					/// <summary>
+					/// Constructs a new, empty ProcessVerdictCache.
+					/// </summary>
+					/// <param name="firewallCheckCb">
+					/// Callback used to determine if traffic from a given binary should be
+					/// filtered. Required.
+					/// </param>
+					/// <param name="onInfo">
+					/// Optional callback to receive informational messages regarding non-critical events.
+					/// </param>
+					/// <param name="onWarning">
+					/// Optional callback to receive informational messages regarding potentially
+					/// critical, but handled events.
+					/// </param>
+					/// <param name="onError">
+					/// Optional callback to receive informational messages regarding critical, but
+					/// handled events.
+					/// </param>
+					ProcessVerdictCache(
+						util::cb::FirewallCheckFunction firewallCheckCb,
+						util::cb::MessageFunction onInfo = nullptr,
+						util::cb::MessageFunction onWarning = nullptr,
+						util::cb::MessageFunction onError = nullptr
+						);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					ProcessVerdictCache(const ProcessVerdictCache&) = delete;
+					ProcessVerdictCache(ProcessVerdictCache&&) = delete;
+					ProcessVerdictCache& operator=(const ProcessVerdictCache&) = delete;
+
+					/// <summary>
+					/// Default destructor. Closes all held process handles.
+					/// </summary>
+					~ProcessVerdictCache();
+
+					/// <summary>
+					/// Determines if traffic from the supplied process should be filtered. Served
+					/// from the cache if possible, otherwise the process binary path is queried
+					/// and handed to the firewall check callback, and the result is cached.
+					/// </summary>
+					/// <param name="processId">
+					/// The ID of the process to check.
+					/// </param>
+					/// <returns>
+					/// True if traffic from the process should be filtered, false otherwise. If
+					/// the process could not be opened or its binary path could not be read, false.
+					/// </returns>
+					bool ShouldFilter(const DWORD processId);
+
+					/// <summary>
+					/// Drops every cached verdict. Must be called whenever the rules behind the
+					/// firewall check callback change, otherwise running processes will keep
+					/// the verdict they were first given.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Gets the number of checks that were answered from the cache.
+					/// </summary>
+					/// <returns>
+					/// The number of cache hits.
+					/// </returns>
+					const uint64_t GetHits() const;
+
+					/// <summary>
+					/// Gets the number of checks that required querying the process and calling
+					/// the firewall check callback.
+					/// </summary>
+					/// <returns>
+					/// The number of cache misses.
+					/// </returns>
+					const uint64_t GetMisses() const;
+
+				private:
+
+					/// <summary>
+					/// A cached verdict, along with the handle that pins the process.
+					/// </summary>
+					struct CachedProcess
+					{
+						HANDLE processHandle = nullptr;
+						std::string binaryPath;
+						bool shouldFilter = false;
+					};
+
+					/// <summary>
+					/// Every this many insertions, the cache is swept for processes that have
+					/// exited, so that idle entries don't hold dead process objects forever.
+					/// </summary>
+					static constexpr size_t SweepInterval = 64;
+
+					/// <summary>
+					/// Reads the full path of the binary for the supplied open process.
+					/// </summary>
+					/// <param name="processHandle">
+					/// A handle to the process opened with at least
+					/// PROCESS_QUERY_LIMITED_INFORMATION access.
+					/// </param>
+					/// <param name="processId">
+					/// The ID of the process, used for error reporting.
+					/// </param>
+					/// <returns>
+					/// The binary path on success, an empty string otherwise.
+					/// </returns>
+					std::string QueryBinaryPath(HANDLE processHandle, const DWORD processId);
+
+					/// <summary>
+					/// Removes every entry whose process has exited. Caller must hold
+					/// m_cacheMutex.
+					/// </summary>
+					void SweepExited();
+
+					/// <summary>
+					/// Determines if the supplied process handle is signaled, aka the process has
+					/// exited.
+					/// </summary>
+					static bool HasExited(HANDLE processHandle);
+
+					util::cb::FirewallCheckFunction m_firewallCheckCb;
+
+					/// <summary>
+					/// Guards m_cache and m_insertsSinceSweep.
+					/// </summary>
+					std::mutex m_cacheMutex;
+
+					std::unordered_map<DWORD, CachedProcess> m_cache;
+
+					size_t m_insertsSinceSweep = 0;
+
+					/// <summary>
+					/// Incremented by every ::Clear(). A miss resolved while a clear happened
+					/// was resolved against the old rules, so it is returned but not cached.
+					/// </summary>
+					std::atomic_uint64_t m_clearGeneration;
+
+					std::atomic_uint64_t m_hits;
+
+					std::atomic_uint64_t m_misses;
+
+				};
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
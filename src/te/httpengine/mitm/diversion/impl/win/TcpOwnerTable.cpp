@@ -0,0 +1,326 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "TcpOwnerTable.hpp"
+
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <boost/functional/hash.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				size_t TcpOwnerTable::V6KeyHash::operator()(const V6Key& key) const
+				{
+					std::size_t seed = 0;
+					boost::hash_combine(seed, key.address[0]);
+					boost::hash_combine(seed, key.address[1]);
+					boost::hash_combine(seed, key.address[2]);
+					boost::hash_combine(seed, key.address[3]);
+					boost::hash_combine(seed, key.port);
+					return seed;
+				}
+
+				TcpOwnerTable::TcpOwnerTable(
+					util::cb::MessageFunction onInfo,
+					util::cb::MessageFunction onWarning,
+					util::cb::MessageFunction onError
+					) :
+					util::cb::EventReporter(onInfo, onWarning, onError)
+				{
+					m_v4Generation = 0;
+					m_v6Generation = 0;
+					m_v4Started = 0;
+					m_v6Started = 0;
+					m_refreshCount = 0;
+				}
+
+				TcpOwnerTable::~TcpOwnerTable()
+				{
+					if (m_v4Table != nullptr)
+					{
+						free(m_v4Table);
+						m_v4Table = nullptr;
+					}
+
+					if (m_v6Table != nullptr)
+					{
+						free(m_v6Table);
+						m_v6Table = nullptr;
+					}
+				}
+
+				bool TcpOwnerTable::GetOwner(const uint32_t localV4Address, const uint16_t localPort, DWORD& processId)
+				{
+					const uint64_t key = MakeV4Key(localV4Address, localPort);
+
+					// A snapshot started before now may predate the socket this endpoint belongs
+					// to, and still hold the row of one that was closed, so only a newer one will do.
+					const uint64_t requiredGeneration = m_v4Started.load() + 1;
+
+					{
+						std::lock_guard<std::mutex> lock(m_indexMutex);
+						auto it = m_v4Owners.find(key);
+						if (it != m_v4Owners.end() && it->second.generation >= requiredGeneration)
+						{
+							processId = it->second.processId;
+							return true;
+						}
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_refreshMutex);
+
+						// If someone else refreshed while we were waiting on the lock, their
+						// snapshot was started after our lookup, so it's as good as our own would be.
+						if (m_v4Generation.load() < requiredGeneration)
+						{
+							RefreshV4();
+						}
+					}
+
+					std::lock_guard<std::mutex> lock(m_indexMutex);
+					auto it = m_v4Owners.find(key);
+					if (it != m_v4Owners.end())
+					{
+						processId = it->second.processId;
+						return true;
+					}
+
+					return false;
+				}
+
+				bool TcpOwnerTable::GetOwner(const uint32_t* localV6Address, const uint16_t localPort, DWORD& processId)
+				{
+					if (localV6Address == nullptr)
+					{
+						ReportError(u8"In TcpOwnerTable::GetOwner(const uint32_t*, const uint16_t, DWORD&) - Expected uint32_t array with length of four for localV6Address, got nullptr!");
+						return false;
+					}
+
+					V6Key key;
+					std::memcpy(key.address.data(), localV6Address, sizeof(uint32_t) * 4);
+					key.port = localPort;
+
+					const uint64_t requiredGeneration = m_v6Started.load() + 1;
+
+					{
+						std::lock_guard<std::mutex> lock(m_indexMutex);
+						auto it = m_v6Owners.find(key);
+						if (it != m_v6Owners.end() && it->second.generation >= requiredGeneration)
+						{
+							processId = it->second.processId;
+							return true;
+						}
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_refreshMutex);
+
+						if (m_v6Generation.load() < requiredGeneration)
+						{
+							RefreshV6();
+						}
+					}
+
+					std::lock_guard<std::mutex> lock(m_indexMutex);
+					auto it = m_v6Owners.find(key);
+					if (it != m_v6Owners.end())
+					{
+						processId = it->second.processId;
+						return true;
+					}
+
+					return false;
+				}
+
+				const uint64_t TcpOwnerTable::GetRefreshCount() const
+				{
+					return m_refreshCount;
+				}
+
+				void TcpOwnerTable::RefreshV4()
+				{
+					if (m_v4TableSize == 0)
+					{
+						m_v4TableSize = sizeof(MIB_TCPTABLE2);
+						m_v4Table = static_cast<PMIB_TCPTABLE2>(malloc(m_v4TableSize));
+					}
+
+					if (m_v4Table == nullptr)
+					{
+						m_v4TableSize = 0;
+						ReportError(u8"In TcpOwnerTable::RefreshV4() - Failed to initialize table.");
+						return;
+					}
+
+					const uint64_t generation = m_v4Started.load() + 1;
+					m_v4Started = generation;
+
+					DWORD dwRetVal = 0;
+
+					// The table can grow between the size query and the fetch, so we give it a
+					// few attempts before giving up.
+					for (int attempt = 0; attempt < 3; ++attempt)
+					{
+						if ((dwRetVal = GetTcpTable2(m_v4Table, &m_v4TableSize, FALSE)) != ERROR_INSUFFICIENT_BUFFER)
+						{
+							break;
+						}
+
+						free(m_v4Table);
+						m_v4Table = static_cast<PMIB_TCPTABLE2>(malloc(m_v4TableSize));
+
+						if (m_v4Table == nullptr)
+						{
+							m_v4TableSize = 0;
+							ReportError(u8"In TcpOwnerTable::RefreshV4() - Failed to resize table.");
+							return;
+						}
+					}
+
+					if (dwRetVal != NO_ERROR)
+					{
+						ReportError(u8"In TcpOwnerTable::RefreshV4() - Failed to populate table.");
+						return;
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_indexMutex);
+
+						// Table members, spare things like dwOwningPid, are in network order aka big endian.
+						for (DWORD i = 0; i < m_v4Table->dwNumEntries; ++i)
+						{
+							// See https://msdn.microsoft.com/en-us/library/windows/desktop/aa366909(v=vs.85).aspx
+							// Upper bits may contain junk data.
+							const auto& row = m_v4Table->table[i];
+
+							// A socket in TIME_WAIT belongs to no process anymore, and its endpoint
+							// may already have been taken by a new one, so it must not shadow it.
+							if (row.dwState == MIB_TCP_STATE_TIME_WAIT)
+							{
+								continue;
+							}
+
+							auto& entry = m_v4Owners[MakeV4Key(row.dwLocalAddr, static_cast<uint16_t>(row.dwLocalPort & 0xFFFF))];
+							entry.processId = row.dwOwningPid;
+							entry.generation = generation;
+						}
+
+						// Anything not seen in this snapshot has been closed.
+						for (auto it = m_v4Owners.begin(); it != m_v4Owners.end();)
+						{
+							if (it->second.generation != generation)
+							{
+								it = m_v4Owners.erase(it);
+							}
+							else
+							{
+								++it;
+							}
+						}
+					}
+
+					m_v4Generation = generation;
+					++m_refreshCount;
+				}
+
+				void TcpOwnerTable::RefreshV6()
+				{
+					if (m_v6TableSize == 0)
+					{
+						m_v6TableSize = sizeof(MIB_TCP6TABLE2);
+						m_v6Table = static_cast<PMIB_TCP6TABLE2>(malloc(m_v6TableSize));
+					}
+
+					if (m_v6Table == nullptr)
+					{
+						m_v6TableSize = 0;
+						ReportError(u8"In TcpOwnerTable::RefreshV6() - Failed to initialize table.");
+						return;
+					}
+
+					const uint64_t generation = m_v6Started.load() + 1;
+					m_v6Started = generation;
+
+					DWORD dwRetVal = 0;
+
+					for (int attempt = 0; attempt < 3; ++attempt)
+					{
+						if ((dwRetVal = GetTcp6Table2(m_v6Table, &m_v6TableSize, FALSE)) != ERROR_INSUFFICIENT_BUFFER)
+						{
+							break;
+						}
+
+						free(m_v6Table);
+						m_v6Table = static_cast<PMIB_TCP6TABLE2>(malloc(m_v6TableSize));
+
+						if (m_v6Table == nullptr)
+						{
+							m_v6TableSize = 0;
+							ReportError(u8"In TcpOwnerTable::RefreshV6() - Failed to resize table.");
+							return;
+						}
+					}
+
+					if (dwRetVal != NO_ERROR)
+					{
+						ReportError(u8"In TcpOwnerTable::RefreshV6() - Failed to populate table.");
+						return;
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_indexMutex);
+
+						V6Key key;
+
+						for (DWORD i = 0; i < m_v6Table->dwNumEntries; ++i)
+						{
+							const auto& row = m_v6Table->table[i];
+
+							if (row.State == MIB_TCP_STATE_TIME_WAIT)
+							{
+								continue;
+							}
+
+							// Compare the full 16 byte address. We used to only compare the first four.
+							std::memcpy(key.address.data(), row.LocalAddr.u.Byte, sizeof(uint32_t) * 4);
+							key.port = static_cast<uint16_t>(row.dwLocalPort & 0xFFFF);
+
+							auto& entry = m_v6Owners[key];
+							entry.processId = row.dwOwningPid;
+							entry.generation = generation;
+						}
+
+						for (auto it = m_v6Owners.begin(); it != m_v6Owners.end();)
+						{
+							if (it->second.generation != generation)
+							{
+								it = m_v6Owners.erase(it);
+							}
+							else
+							{
+								++it;
+							}
+						}
+					}
+
+					m_v6Generation = generation;
+					++m_refreshCount;
+				}
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
@@ -0,0 +1,240 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "../../../../util/cb/EventReporter.hpp"
+
+#include <WS2tcpip.h>
+#include <ws2def.h>
+#include <ws2ipdef.h>
+#include <Iphlpapi.h>
+#include <tcpmib.h>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace diversion
+			{
+
+				/// <summary>
+				/// The TcpOwnerTable maintains an index of local TCP endpoints, keyed by local
+				/// address and port, to the ID of the process that owns them. A single instance
+				/// is shared by every diversion thread.
+				///
+				/// Lookups are served from the index, but only from a snapshot of the system TCP
+				/// table that was started after the lookup was. Anything older may be a row of a
+				/// socket that has since been closed, and whose local endpoint has been reused by
+				/// the very connection being looked up. Otherwise the table is fetched, and that
+				/// single snapshot is merged into the index in place, so it serves every other
+				/// thread that was waiting on it at the same time. This matters because a browser
+				/// will typically open a burst of connections at once, and previously every single
+				/// SYN in that burst paid for its own full GetTcpTable2 call and linear scan.
+				///
+				/// Note that the WinDivert flow and socket layers would let us track this
+				/// without polling at all, but those only exist in WinDivert 2.x.
+				/// </summary>
+				class TcpOwnerTable : public util::cb::EventReporter
+				{
+
+				public:
+
+					/// <summary>
+					/// Constructs a new, empty TcpOwnerTable.
+					/// </summary>
+					/// <param name="onInfo">
+					/// Optional callback to receive informational messages regarding non-critical events.
+					/// </param>
+					/// <param name="onWarning">
+					/// Optional callback to receive informational messages regarding potentially
+					/// critical, but handled events.
+					/// </param>
+					/// <param name="onError">
+					/// Optional callback to receive informational messages regarding critical, but
+					/// handled events.
+					/// </param>
+					TcpOwnerTable(
+						util::cb::MessageFunction onInfo = nullptr,
+						util::cb::MessageFunction onWarning = nullptr,
+						util::cb::MessageFunction onError = nullptr
+						);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					TcpOwnerTable(const TcpOwnerTable&) = delete;
+					TcpOwnerTable(TcpOwnerTable&&) = delete;
+					TcpOwnerTable& operator=(const TcpOwnerTable&) = delete;
+
+					/// <summary>
+					/// Default destructor. Frees the recycled system table buffers.
+					/// </summary>
+					~TcpOwnerTable();
+
+					/// <summary>
+					/// Gets the ID of the process that owns the supplied local IPV4 endpoint. Meant
+					/// to be called for the SYN of a new connection, once the endpoint is bound.
+					/// </summary>
+					/// <param name="localV4Address">
+					/// The local address, in network order.
+					/// </param>
+					/// <param name="localPort">
+					/// The local port, in network order.
+					/// </param>
+					/// <param name="processId">
+					/// On success, the owning process ID.
+					/// </param>
+					/// <returns>
+					/// True if an owner was found, false otherwise.
+					/// </returns>
+					bool GetOwner(const uint32_t localV4Address, const uint16_t localPort, DWORD& processId);
+
+					/// <summary>
+					/// Gets the ID of the process that owns the supplied local IPV6 endpoint. Meant
+					/// to be called for the SYN of a new connection, once the endpoint is bound.
+					/// </summary>
+					/// <param name="localV6Address">
+					/// The local address, as an array of 32 bit unsigned integers with a length of
+					/// four, in network order. No bounds checks are done.
+					/// </param>
+					/// <param name="localPort">
+					/// The local port, in network order.
+					/// </param>
+					/// <param name="processId">
+					/// On success, the owning process ID.
+					/// </param>
+					/// <returns>
+					/// True if an owner was found, false otherwise.
+					/// </returns>
+					bool GetOwner(const uint32_t* localV6Address, const uint16_t localPort, DWORD& processId);
+
+					/// <summary>
+					/// Gets the number of times the system TCP tables have been fetched and merged
+					/// into the index.
+					/// </summary>
+					/// <returns>
+					/// The number of refreshes performed.
+					/// </returns>
+					const uint64_t GetRefreshCount() const;
+
+				private:
+
+					/// <summary>
+					/// Key for the IPV6 index. Address and port, both in network order.
+					/// </summary>
+					struct V6Key
+					{
+						std::array<uint32_t, 4> address;
+						uint16_t port;
+
+						bool operator==(const V6Key& other) const
+						{
+							return port == other.port && address == other.address;
+						}
+					};
+
+					/// <summary>
+					/// Hash implementation for V6Key.
+					/// </summary>
+					struct V6KeyHash
+					{
+						size_t operator()(const V6Key& key) const;
+					};
+
+					/// <summary>
+					/// An index entry. The generation is the refresh in which this endpoint was last
+					/// seen, used to sweep out endpoints that have since been closed.
+					/// </summary>
+					struct OwnerEntry
+					{
+						DWORD processId;
+						uint64_t generation;
+					};
+
+					/// <summary>
+					/// Builds the IPV4 index key from the supplied address and port.
+					/// </summary>
+					static inline uint64_t MakeV4Key(const uint32_t address, const uint16_t port)
+					{
+						return (static_cast<uint64_t>(address) << 16) | port;
+					}
+
+					/// <summary>
+					/// Fetches the system IPV4 TCP table and merges it into the index.
+					/// </summary>
+					void RefreshV4();
+
+					/// <summary>
+					/// Fetches the system IPV6 TCP table and merges it into the index.
+					/// </summary>
+					void RefreshV6();
+
+					/// <summary>
+					/// Guards the two indices.
+					/// </summary>
+					std::mutex m_indexMutex;
+
+					/// <summary>
+					/// Serializes refreshes, and guards the recycled system table buffers. Held
+					/// while calling into the kernel, so it must never be taken while holding
+					/// m_indexMutex.
+					/// </summary>
+					std::mutex m_refreshMutex;
+
+					std::unordered_map<uint64_t, OwnerEntry> m_v4Owners;
+
+					std::unordered_map<V6Key, OwnerEntry, V6KeyHash> m_v6Owners;
+
+					/// <summary>
+					/// The generation of the last refresh of the respective table that was merged
+					/// into the index. A lookup needs a generation newer than the last one started
+					/// when it began. If, after acquiring m_refreshMutex, it finds that another
+					/// thread already merged one, it simply looks again rather than fetch again.
+					/// </summary>
+					std::atomic_uint64_t m_v4Generation;
+					std::atomic_uint64_t m_v6Generation;
+
+					/// <summary>
+					/// The generation of the last refresh of the respective table that was started,
+					/// which is set before the system table is fetched.
+					/// </summary>
+					std::atomic_uint64_t m_v4Started;
+					std::atomic_uint64_t m_v6Started;
+
+					/// <summary>
+					/// Total refreshes performed across both tables.
+					/// </summary>
+					std::atomic_uint64_t m_refreshCount;
+
+					/// <summary>
+					/// Recycled buffer for the IPV4 system table. We deliberately never free this
+					/// until destruction. Eventually, this table will reach a size where
+					/// reallocations don't happen anymore.
+					/// </summary>
+					PMIB_TCPTABLE2 m_v4Table = nullptr;
+					DWORD m_v4TableSize = 0;
+
+					/// <summary>
+					/// Recycled buffer for the IPV6 system table.
+					/// </summary>
+					PMIB_TCP6TABLE2 m_v6Table = nullptr;
+					DWORD m_v6TableSize = 0;
+
+				};
+
+			} /* namespace diversion */
+		}/* namespace mitm */
+	}/* namespace httpengine */
+}/* namespace te */
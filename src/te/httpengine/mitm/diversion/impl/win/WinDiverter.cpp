@@ -6,6 +6,7 @@
 */
 
 #include "WinDiverter.hpp"
+#include "../../../../network/OriginalPortTable.hpp"
 
 #include <stdexcept>
 #include <unordered_map>
@@ -24,16 +25,20 @@ namespace te
 
 				WinDiverter::WinDiverter(
 					util::cb::FirewallCheckFunction firewallCheckCb,
+					FlowClassifier* flowClassifier,
 					util::cb::MessageFunction onInfo,
 					util::cb::MessageFunction onWarning,
 					util::cb::MessageFunction onError
 				) :
 					BaseDiverter(
 						firewallCheckCb,
+						flowClassifier,
 						onInfo,
 						onWarning,
 						onError
-					)
+					),
+					m_tcpOwners(onInfo, onWarning, onError),
+					m_processVerdicts(firewallCheckCb, onInfo, onWarning, onError)
 				{
 					m_thisPid = GetCurrentProcessId();
 
@@ -51,6 +56,14 @@ namespace te
 						m_v4Shouldfilter[i] = false;
 						m_v6Shouldfilter[i] = false;
 					}
+
+					for (size_t i = 0; i < m_v4Routes.size(); ++i)
+					{
+						m_v4Routes[i] = static_cast<uint8_t>(FlowRoute::Direct);
+						m_v6Routes[i] = static_cast<uint8_t>(FlowRoute::Direct);
+						m_v4AwaitingPayload[i] = false;
+						m_v6AwaitingPayload[i] = false;
+					}
 				}
 
 				WinDiverter::~WinDiverter()
@@ -181,322 +194,597 @@ namespace te
 					return m_running;
 				}
 
-				void WinDiverter::RunDiversion(LPVOID diversionHandlePtr)
+				DiversionStats WinDiverter::GetStats()
 				{
-					HANDLE divertHandle = static_cast<HANDLE>(diversionHandlePtr);
+					auto stats = BaseDiverter::GetStats();
 
-					WINDIVERT_ADDRESS addr;
-					PacketBuffer readBuffer;
-					PVOID payloadBuffer = nullptr;
-					uint32_t payloadLength = 0;
+					stats.VerdictCacheHits = m_processVerdicts.GetHits();
+					stats.VerdictCacheMisses = m_processVerdicts.GetMisses();
 
-					uint32_t recvLength = 0;
+					return stats;
+				}
 
-					PWINDIVERT_IPHDR ipV4Header = nullptr;
-					PWINDIVERT_IPV6HDR ipV6Header = nullptr;
-					PWINDIVERT_TCPHDR tcpHeader = nullptr;
+				void WinDiverter::ClearFirewallVerdicts()
+				{
+					m_processVerdicts.Clear();
+				}
 
-					PMIB_TCPTABLE2 ipv4TcpTable = nullptr;
-					DWORD ipv4TcpTableSize = 0;
+				void WinDiverter::RunDiversion(LPVOID diversionHandlePtr)
+				{
+					HANDLE divertHandle = static_cast<HANDLE>(diversionHandlePtr);
 
-					PMIB_TCP6TABLE2 ipv6TcpTable = nullptr;
-					DWORD ipv6TcpTableSize = 0;
+#ifdef HTTP_FILTERING_ENGINE_USE_EX
+					// Every thread keeps DiversionBatchSize overlapped receives posted against the
+					// handle at all times. The slots, including the event for each of them, are
+					// created exactly once here and recycled for the lifetime of the thread, so we
+					// no longer take the hit of creating and destroying an event for every single
+					// packet. When the oldest receive completes, we sweep forward and collect
+					// every other receive that has also completed, then classify, rewrite and
+					// reinject all of them together before reposting the whole lot.
+					std::vector<DiversionSlot> slots(DiversionBatchSize);
+
+					for (auto& slot : slots)
+					{
+						memset(&slot.overlapped, 0, sizeof(OVERLAPPED));
 
-					std::array<uint8_t, 4> ipv4Copy;
+						// Manual reset. Starting the overlapped operation resets the event for us.
+						slot.overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
 
-					bool modifiedPacket = false;
+						if (slot.overlapped.hEvent == nullptr)
+						{
+							std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - While creating RecvEx event, got error:\t");
+							errMessage.append(std::to_string(GetLastError()));
+							errMessage.append(". Falling back to blocking receives.");
+							ReportError(errMessage);
 
-#ifdef HTTP_FILTERING_ENGINE_USE_EX
-					OVERLAPPED recvOverlapped;
-					HANDLE recvEvent = nullptr;
-					DWORD recvAsyncIoLen;
-#endif
+							// Nothing has been posted yet, so the events made so far can just go.
+							// A slot without an event would never be waited on, which would have
+							// the thread spin instead.
+							for (auto& created : slots)
+							{
+								if (created.overlapped.hEvent != nullptr)
+								{
+									CloseHandle(created.overlapped.hEvent);
+									created.overlapped.hEvent = nullptr;
+								}
+							}
 
-					bool isLocalIpv4 = false;
+							RunBlockingDiversion(divertHandle);
+							return;
+						}
+					}
+
+					for (auto& slot : slots)
+					{
+						PostReceive(divertHandle, slot);
+					}
+
+					uint32_t head = 0;
+					uint32_t failedPosts = 0;
+					std::array<DiversionSlot*, DiversionBatchSize> batch;
 
 					while (m_running)
 					{
-						recvLength = 0;
-						memset(&addr, 0, sizeof(addr));
-						modifiedPacket = false;
-					
-#ifdef HTTP_FILTERING_ENGINE_USE_EX
+						DiversionSlot& first = slots[head];
+
+						if (!first.pending)
+						{
+							// The last attempt to post a receive on this slot failed. Try again and
+							// move along.
+							if (!PostReceive(divertHandle, first))
+							{
+								head = (head + 1) % DiversionBatchSize;
 
-						recvAsyncIoLen = 0;
-						memset(&recvOverlapped, 0, sizeof(OVERLAPPED));
-						recvEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+								// Once every slot has failed in a row, nothing is posted that could
+								// be waited on, so back off rather than spin until the handle
+								// either recovers or is closed.
+								if (++failedPosts >= DiversionBatchSize)
+								{
+									failedPosts = 0;
+									Sleep(100);
+								}
 
-						if (recvEvent == nullptr)
+								continue;
+							}
+						}
+
+						failedPosts = 0;
+
+						if (WaitForSingleObject(first.overlapped.hEvent, 1000) != WAIT_OBJECT_0)
 						{
-							std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - While creating RecvEx event, got error:\t");
-							errMessage.append(std::to_string(GetLastError()));
-							ReportError(errMessage);
+							// Timeout. Go back around so we observe changes to m_running.
 							continue;
 						}
 
-						recvOverlapped.hEvent = recvEvent;
-
-						if (!WinDivertRecvEx(divertHandle, readBuffer.data(), PacketBufferLength, 0, &addr, &recvLength, &recvOverlapped))
+						// Collect the head and every consecutive slot whose receive has also
+						// completed. HasOverlappedIoCompleted is just a read of the OVERLAPPED
+						// status, so the sweep costs no additional trips into the kernel.
+						uint32_t batchCount = 0;
+						for (uint32_t i = 0; i < DiversionBatchSize; ++i)
 						{
-							auto err = GetLastError();
-							if (err != ERROR_IO_PENDING)
+							DiversionSlot& slot = slots[(head + i) % DiversionBatchSize];
+
+							if (!slot.pending || (i > 0 && !HasOverlappedIoCompleted(&slot.overlapped)))
 							{
-								std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - During call to WinDivert RecvEx, got error:\t");
-								errMessage.append(std::to_string(err));
-								ReportError(errMessage);
-								continue;
+								break;
 							}
 
-							
-							while (WaitForSingleObject(recvEvent, 1000) == WAIT_TIMEOUT);
+							DWORD recvAsyncIoLen = 0;
+							slot.pending = false;
 
-							if (!GetOverlappedResult(divertHandle, &recvOverlapped, &recvAsyncIoLen, FALSE))
+							if (!GetOverlappedResult(divertHandle, &slot.overlapped, &recvAsyncIoLen, FALSE))
 							{
 								std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - During call to WinDivert RecvEx, while fetching overlapped result, got error:\t");
 								errMessage.append(std::to_string(GetLastError()));
 								ReportError(errMessage);
 
-								CloseHandle(recvEvent);
+								recvAsyncIoLen = 0;
+							}
+
+							slot.recvLength = recvAsyncIoLen;
+							batch[batchCount++] = &slot;
+						}
+
+						++m_receiveBatches;
+
+						for (uint32_t i = 0; i < batchCount; ++i)
+						{
+							DiversionSlot* slot = batch[i];
+
+							if (slot->recvLength == 0)
+							{
+								slot->reinject = false;
 								continue;
 							}
 
-							recvLength = recvAsyncIoLen;
-							CloseHandle(recvEvent);
+							++m_packetsReceived;
+
+							slot->reinject = ProcessPacket(slot->buffer.data(), slot->recvLength, slot->addr);
+						}
+
+						// WinDivert 1.x has no vectored send, so reinjection of the batch is one
+						// WinDivertSendEx per packet, done back to back once the whole batch has
+						// been classified.
+						for (uint32_t i = 0; i < batchCount; ++i)
+						{
+							DiversionSlot* slot = batch[i];
+
+							if (slot->reinject)
+							{
+								Reinject(divertHandle, slot->buffer.data(), slot->recvLength, slot->addr);
+							}
+							else if (slot->recvLength > 0)
+							{
+								++m_packetsDropped;
+							}
+
+							PostReceive(divertHandle, *slot);
+						}
+
+						head = (head + batchCount) % DiversionBatchSize;
+					}// while (m_running)
+
+					// We must not let the slot memory go while the driver may still write to it.
+					for (auto& slot : slots)
+					{
+						if (slot.pending)
+						{
+							DWORD ignored = 0;
+							CancelIoEx(divertHandle, &slot.overlapped);
+							GetOverlappedResult(divertHandle, &slot.overlapped, &ignored, TRUE);
+						}
+
+						if (slot.overlapped.hEvent != nullptr)
+						{
+							CloseHandle(slot.overlapped.hEvent);
+							slot.overlapped.hEvent = nullptr;
 						}
+					}
 #else
+					RunBlockingDiversion(divertHandle);
+#endif // #ifdef HTTP_FILTERING_ENGINE_USE_EX
+				}
+
+				void WinDiverter::RunBlockingDiversion(HANDLE divertHandle)
+				{
+					WINDIVERT_ADDRESS addr;
+					std::unique_ptr<PacketBuffer> readBuffer(new PacketBuffer());
+					uint32_t recvLength = 0;
+
+					while (m_running)
+					{
+						recvLength = 0;
+						memset(&addr, 0, sizeof(addr));
 
-						if (!WinDivertRecv(divertHandle, readBuffer.data(), PacketBufferLength, &addr, &recvLength))
+						if (!WinDivertRecv(divertHandle, readBuffer->data(), PacketBufferLength, &addr, &recvLength))
 						{
-							std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - During call to WinDivert Recv, got error:\t");
+							std::string errMessage("In WinDiverter::RunBlockingDiversion(HANDLE) - During call to WinDivert Recv, got error:\t");
 							errMessage.append(std::to_string(GetLastError()));
 							ReportError(errMessage);
 							continue;
 						}
 
+						++m_receiveBatches;
+						++m_packetsReceived;
+
+						if (ProcessPacket(readBuffer->data(), recvLength, addr))
+						{
+							Reinject(divertHandle, readBuffer->data(), recvLength, addr);
+						}
+						else
+						{
+							++m_packetsDropped;
+						}
+					}// while (m_running)
+				}
+
+#ifdef HTTP_FILTERING_ENGINE_USE_EX
+				bool WinDiverter::PostReceive(HANDLE divertHandle, DiversionSlot& slot)
+				{
+					HANDLE recvEvent = slot.overlapped.hEvent;
+					memset(&slot.overlapped, 0, sizeof(OVERLAPPED));
+					slot.overlapped.hEvent = recvEvent;
+
+					memset(&slot.addr, 0, sizeof(slot.addr));
+					slot.recvLength = 0;
+					slot.reinject = false;
+
+					if (!WinDivertRecvEx(divertHandle, slot.buffer.data(), PacketBufferLength, 0, &slot.addr, &slot.recvLength, &slot.overlapped))
+					{
+						auto err = GetLastError();
+						if (err != ERROR_IO_PENDING)
+						{
+							std::string errMessage("In WinDiverter::PostReceive(HANDLE, DiversionSlot&) - During call to WinDivert RecvEx, got error:\t");
+							errMessage.append(std::to_string(err));
+							ReportError(errMessage);
+
+							slot.pending = false;
+							return false;
+						}
+					}
+
+					// Whether the receive completed immediately or is pending, the result is
+					// collected the same way through the OVERLAPPED structure.
+					slot.pending = true;
+					return true;
+				}
 #endif // #ifdef HTTP_FILTERING_ENGINE_USE_EX
 
-						// Since our filter is set to be outbound and TCP only, we don't really need to check this
-						// at all. But, in case the filter is modified later, it doesn't hurt.
-						if (addr.Direction == WINDIVERT_DIRECTION_OUTBOUND)
-						{	
-							// We don't care what the return value is. False can be a valid return value
-							// according to the docs. So we just fire it and check the validity of our
-							// pointers after, and that's where we get our verification that this call
-							// succeeded.
-							WinDivertHelperParsePacket(readBuffer.data(), recvLength, &ipV4Header, &ipV6Header, nullptr, nullptr, &tcpHeader, nullptr, &payloadBuffer, &payloadLength);
-
-							if (tcpHeader != nullptr && tcpHeader->Syn > 0)
+				void WinDiverter::Reinject(HANDLE divertHandle, unsigned char* packet, const uint32_t packetLength, WINDIVERT_ADDRESS& addr)
+				{
+					if (!WinDivertSendEx(divertHandle, packet, packetLength, 0, &addr, nullptr, nullptr))
+					{
+						// XXX TODO - Perhaps report warning instead? This isn't exactly critical. Maybe a single
+						// packet gets lost, maybe it completes under the hood. Either way we can do nothing, and
+						// this should be expected to happen at least once.
+						//
+						// Update - Disabling this but leaving it here. This floods our logs when we block internet
+						// on purpose. We do count these though, so they show up in our stats.
+						/*
+						std::string errMessage("In WinDiverter::Reinject(HANDLE, unsigned char*, const uint32_t, WINDIVERT_ADDRESS&) - During call to WinDivert SendEx, got error:\t");
+						errMessage.append(std::to_string(GetLastError()));
+						ReportError(errMessage);
+						*/
+						++m_packetsDropped;
+						return;
+					}
+
+					++m_packetsSent;
+				}
+
+				bool WinDiverter::ProcessPacket(unsigned char* packet, const uint32_t packetLength, WINDIVERT_ADDRESS& addr)
+				{
+					PVOID payloadBuffer = nullptr;
+					uint32_t payloadLength = 0;
+
+					PWINDIVERT_IPHDR ipV4Header = nullptr;
+					PWINDIVERT_IPV6HDR ipV6Header = nullptr;
+					PWINDIVERT_TCPHDR tcpHeader = nullptr;
+
+					std::array<uint8_t, 4> ipv4Copy;
+
+					bool modifiedPacket = false;
+
+					bool isLocalIpv4 = false;
+
+					// Since our filter is set to be outbound and TCP only, we don't really need to check this
+					// at all. But, in case the filter is modified later, it doesn't hurt.
+					if (addr.Direction == WINDIVERT_DIRECTION_OUTBOUND)
+					{	
+						// We don't care what the return value is. False can be a valid return value
+						// according to the docs. So we just fire it and check the validity of our
+						// pointers after, and that's where we get our verification that this call
+						// succeeded.
+						WinDivertHelperParsePacket(packet, packetLength, &ipV4Header, &ipV6Header, nullptr, nullptr, &tcpHeader, nullptr, &payloadBuffer, &payloadLength);
+
+						if (tcpHeader != nullptr && tcpHeader->Syn > 0)
+						{
+							// Brand new outbound connection. Grab the PID of the process
+							// holding this port and map it.								
+							if (ipV4Header != nullptr)
 							{
-								// Brand new outbound connection. Grab the PID of the process
-								// holding this port and map it.								
-								if (ipV4Header != nullptr)
-								{
-									m_v4pidMap[tcpHeader->SrcPort] = GetPacketProcess(tcpHeader->SrcPort, ipV4Header->SrcAddr, &ipv4TcpTable, ipv4TcpTableSize);
+								m_v4pidMap[tcpHeader->SrcPort] = GetPacketProcess(tcpHeader->SrcPort, ipV4Header->SrcAddr);
 
-									if (m_v4pidMap[tcpHeader->SrcPort] == m_thisPid)
+								if (m_v4pidMap[tcpHeader->SrcPort] == m_thisPid)
+								{
+									// System process. Don't even bother.
+									m_v4Shouldfilter[tcpHeader->SrcPort] = false;
+								}
+								else
+								{
+									if (m_v4pidMap[tcpHeader->SrcPort] == 4)
 									{
-										// System process. Don't even bother.
 										m_v4Shouldfilter[tcpHeader->SrcPort] = false;
 									}
 									else
 									{
-										if (m_v4pidMap[tcpHeader->SrcPort] == 4)
-										{
-											m_v4Shouldfilter[tcpHeader->SrcPort] = false;
-										}
-										else
-										{
-											auto procPath = GetPacketProcessBinaryPath(m_v4pidMap[tcpHeader->SrcPort].load());
-
-											if (procPath.size() == 0)
-											{
-												// This is something we couldn't get a handle on. Since we can't do that
-												// that's probably a bad sign (SYSTEM process maybe?), don't filter it.
-												m_v4Shouldfilter[tcpHeader->SrcPort] = false;
-											}
-											else
-											{
-												m_v4Shouldfilter[tcpHeader->SrcPort] = m_firewallCheckCb(procPath.c_str(), procPath.size());
-											}
-										}
+										m_v4Shouldfilter[tcpHeader->SrcPort] = m_processVerdicts.ShouldFilter(static_cast<DWORD>(m_v4pidMap[tcpHeader->SrcPort].load()));
 									}
 								}
 
-								if (ipV6Header != nullptr)
+								FlowRoute route = FlowRoute::Direct;
+
+								if (m_v4Shouldfilter[tcpHeader->SrcPort])
 								{
-									m_v6pidMap[tcpHeader->SrcPort] = GetPacketProcess(tcpHeader->SrcPort, ipV6Header->SrcAddr, &ipv6TcpTable, ipv6TcpTableSize);
+									ipv4Copy[0] = ipV4Header->DstAddr & 0xFF;
+									ipv4Copy[1] = (ipV4Header->DstAddr >> 8) & 0xFF;
+									ipv4Copy[2] = (ipV4Header->DstAddr >> 16) & 0xFF;
+									ipv4Copy[3] = (ipV4Header->DstAddr >> 24) & 0xFF;
 
-									if (m_v6pidMap[tcpHeader->SrcPort] == m_thisPid)
+									// Private destinations are never diverted, see below.
+									if (!IsV4AddressPrivate(ipv4Copy))
+									{
+										FlowEndpoint destination;
+										destination.Address[0] = ipV4Header->DstAddr;
+										destination.Port = ntohs(tcpHeader->DstPort);
+
+										route = RouteNewFlow(destination, tcpHeader->SrcPort);
+									}
+								}
+
+								m_v4Routes[tcpHeader->SrcPort] = static_cast<uint8_t>(route);
+								m_v4AwaitingPayload[tcpHeader->SrcPort] = m_flowClassifier != nullptr && route != FlowRoute::Direct;
+							}
+
+							if (ipV6Header != nullptr)
+							{
+								m_v6pidMap[tcpHeader->SrcPort] = GetPacketProcess(tcpHeader->SrcPort, ipV6Header->SrcAddr);
+
+								if (m_v6pidMap[tcpHeader->SrcPort] == m_thisPid)
+								{	
+									m_v6Shouldfilter[tcpHeader->SrcPort] = false;
+								}
+								else
+								{
+									if (m_v6pidMap[tcpHeader->SrcPort] == 4)
 									{	
+										// System process. Don't even bother.
 										m_v6Shouldfilter[tcpHeader->SrcPort] = false;
 									}
 									else
 									{
-										if (m_v6pidMap[tcpHeader->SrcPort] == 4)
-										{	
-											// System process. Don't even bother.
-											m_v6Shouldfilter[tcpHeader->SrcPort] = false;
-										}
-										else
-										{
-											auto procPath = GetPacketProcessBinaryPath(m_v6pidMap[tcpHeader->SrcPort].load());
-
-											if (procPath.size() == 0)
-											{
-												// This is something we couldn't get a handle on. Since we can't do that
-												// that's probably a bad sign (SYSTEM process maybe?), don't filter it.
-												m_v6Shouldfilter[tcpHeader->SrcPort] = false;
-											}
-											else
-											{	
-												m_v6Shouldfilter[tcpHeader->SrcPort] = m_firewallCheckCb(procPath.c_str(), procPath.size());
-											}
-										}
-										
+										m_v6Shouldfilter[tcpHeader->SrcPort] = m_processVerdicts.ShouldFilter(static_cast<DWORD>(m_v6pidMap[tcpHeader->SrcPort].load()));
 									}
+									
 								}
+
+								FlowRoute route = FlowRoute::Direct;
+
+								if (m_v6Shouldfilter[tcpHeader->SrcPort])
+								{
+									FlowEndpoint destination;
+									std::copy(ipV6Header->DstAddr, ipV6Header->DstAddr + 4, destination.Address.begin());
+									destination.Port = ntohs(tcpHeader->DstPort);
+									destination.V6 = true;
+
+									route = RouteNewFlow(destination, tcpHeader->SrcPort);
+								}
+
+								m_v6Routes[tcpHeader->SrcPort] = static_cast<uint8_t>(route);
+								m_v6AwaitingPayload[tcpHeader->SrcPort] = m_flowClassifier != nullptr && route != FlowRoute::Direct;
 							}
+						}
 
 
-							// I put the checks for ipv4 and ipv6 as a double if statement rather
-							// than an else if because I'm not sure how that would affect dual-mode
-							// sockets. Perhaps it's possible for both headers to be defined.
-							// Probably not, but since I don't know, I err on the side of awesome,
-							// or uhh, something like that.
+						// I put the checks for ipv4 and ipv6 as a double if statement rather
+						// than an else if because I'm not sure how that would affect dual-mode
+						// sockets. Perhaps it's possible for both headers to be defined.
+						// Probably not, but since I don't know, I err on the side of awesome,
+						// or uhh, something like that.
 
-							// We check local packets for TOR/SOCKS packets here. However, if
-							// we don't find something we want to block on local addresses, then
-							// we want to skip these for the rest of the filtering and just
-							// let them through.
-							isLocalIpv4 = false;
-							
-							if (ipV4Header != nullptr && tcpHeader != nullptr)
+						// We check local packets for TOR/SOCKS packets here. However, if
+						// we don't find something we want to block on local addresses, then
+						// we want to skip these for the rest of the filtering and just
+						// let them through.
+						isLocalIpv4 = false;
+						
+						if (ipV4Header != nullptr && tcpHeader != nullptr)
+						{
+							// Let's explain the weird arcane logic here. First, we check if the current flow
+							// should even be filtered. We do this, because there's a good chance that
+							// this flow belongs to our proxy's connections, which we never
+							// want to filter. If we didn't check this, then we would end up setting
+							// the isLocalIpv4 flag to true on every single one of our proxy's
+							// connections, and clients would never get packets ever because with
+							// that flag set, the direction of the packets wouldn't be sorted.
+							//
+							// So, we check this, ensure it's actually something we want to filter.
+							// Then, we check if the packet is destined for a local address. We
+							// set the flag accordingly, and if true, then we will allow these packets
+							// to go out uninterrupted.
+							//
+							// If false, who cares. Regardless of true or false, we check to see if this
+							// is a TOR/SOCKS4/5 proxy CONNECT, and drop it if it is.
+							//
+							// Also note, by letting local/private address destined packets go, we
+							// also solve the problem of private TLS connections using private TLS
+							// self signed certs, such as logging into one's router. If we didn't
+							// do this check and let these through, we would break such connections.
+							if (m_v4Shouldfilter[tcpHeader->SrcPort])
 							{
-								// Let's explain the weird arcane logic here. First, we check if the current flow
-								// should even be filtered. We do this, because there's a good chance that
-								// this flow belongs to our proxy's connections, which we never
-								// want to filter. If we didn't check this, then we would end up setting
-								// the isLocalIpv4 flag to true on every single one of our proxy's
-								// connections, and clients would never get packets ever because with
-								// that flag set, the direction of the packets wouldn't be sorted.
-								//
-								// So, we check this, ensure it's actually something we want to filter.
-								// Then, we check if the packet is destined for a local address. We
-								// set the flag accordingly, and if true, then we will allow these packets
-								// to go out uninterrupted.
-								//
-								// If false, who cares. Regardless of true or false, we check to see if this
-								// is a TOR/SOCKS4/5 proxy CONNECT, and drop it if it is.
-								//
-								// Also note, by letting local/private address destined packets go, we
-								// also solve the problem of private TLS connections using private TLS
-								// self signed certs, such as logging into one's router. If we didn't
-								// do this check and let these through, we would break such connections.
-								if (m_v4Shouldfilter[tcpHeader->SrcPort])
-								{
-									modifiedPacket = true;
+								modifiedPacket = true;
 
-									ipv4Copy[0] = ipV4Header->DstAddr & 0xFF;
-									ipv4Copy[1] = (ipV4Header->DstAddr >> 8) & 0xFF;
-									ipv4Copy[2] = (ipV4Header->DstAddr >> 16) & 0xFF;
-									ipv4Copy[3] = (ipV4Header->DstAddr >> 24) & 0xFF;
+								ipv4Copy[0] = ipV4Header->DstAddr & 0xFF;
+								ipv4Copy[1] = (ipV4Header->DstAddr >> 8) & 0xFF;
+								ipv4Copy[2] = (ipV4Header->DstAddr >> 16) & 0xFF;
+								ipv4Copy[3] = (ipV4Header->DstAddr >> 24) & 0xFF;
 
-									isLocalIpv4 = IsV4AddressPrivate(ipv4Copy);
+								isLocalIpv4 = IsV4AddressPrivate(ipv4Copy);
 
-									if (isLocalIpv4)
+								if (isLocalIpv4)
+								{
+									#ifdef HTTP_FE_BLOCK_TOR
+									if (payloadBuffer != nullptr)
 									{
-										#ifdef HTTP_FE_BLOCK_TOR
-										if (payloadBuffer != nullptr)
-										{
 
-											if (IsSocksProxyConnect(static_cast<uint8_t*>(payloadBuffer), payloadLength))
-											{
-												// Skip past this packet all together. We refuse to allow
-												// any other proxy to function because this is our castle.
-												ReportInfo(u8"Blocking SOCKS proxy.");
-												payloadBuffer = nullptr;
-												payloadLength = 0;
-												continue;
-											}
+										if (IsSocksProxyConnect(static_cast<uint8_t*>(payloadBuffer), payloadLength))
+										{
+											// Skip past this packet all together. We refuse to allow
+											// any other proxy to function because this is our castle.
+											ReportInfo(u8"Blocking SOCKS proxy.");
+											return false;
 										}
-										#endif
 									}
+									#endif
 								}
 							}
+						}
 
-							if (!isLocalIpv4)							
+						if (!isLocalIpv4)							
+						{
+							if (ipV4Header != nullptr && tcpHeader != nullptr)
 							{
-								if (ipV4Header != nullptr && tcpHeader != nullptr)
+								if (tcpHeader->SrcPort == m_httpListenerPort || tcpHeader->SrcPort == m_httpsListenerPort)
 								{
-									if (tcpHeader->SrcPort == m_httpListenerPort || tcpHeader->SrcPort == m_httpsListenerPort)
+									modifiedPacket = true;
+
+									// Means that the data is originating from our proxy in response
+									// to a client's request, which means it was originally meant to
+									// go somewhere else. We need to reorder the data such as the
+									// src and destination ports and addresses and divert it back
+									// inbound, so it appears to be an inbound response from the
+									// original external server.
+									//
+									// Flows aren't only diverted from the standard ports, so the
+									// port the client connected to is looked up by the client's own
+									// port. A flow diverted before it was recorded can only have
+									// come from the standard port of its listener.
+
+									uint32_t dstAddr = ipV4Header->DstAddr;
+									ipV4Header->DstAddr = ipV4Header->SrcAddr;
+									ipV4Header->SrcAddr = dstAddr;
+
+									const uint16_t originalPort = network::OriginalPortTable::Shared().Get(false, ntohs(tcpHeader->DstPort));
+
+									if (originalPort != 0)
+									{
+										tcpHeader->SrcPort = htons(originalPort);
+									}
+									else
+									{
+										tcpHeader->SrcPort = (tcpHeader->SrcPort == m_httpListenerPort) ? StandardHttpPort : StandardHttpsPort;
+									}
+
+									addr.Direction = WINDIVERT_DIRECTION_INBOUND;
+								}
+								else
+								{
+									// This means outbound traffic has been captured that we know for sure is
+									// not coming from our proxy in response to a client, but we don't know that it
+									// isn't the upstream portion of our proxy trying to fetch a response on behalf
+									// of a connected client. So, we need to check if we have a cached result for
+									// information about the binary generating the outbound traffic for two reasons.
+									//
+									// First, we need to ensure that it's not us, obviously. Secondly, we need to
+									// ensure that the binary has been granted firewall access to generate outbound
+									// traffic. Both were settled when the flow was opened, along with its route.
+									const FlowRoute route = static_cast<FlowRoute>(m_v4Routes[tcpHeader->SrcPort].load());
+
+									if (payloadBuffer != nullptr && payloadLength > 0 && route != FlowRoute::Direct)
+									{
+										FlowEndpoint destination;
+										destination.Address[0] = ipV4Header->DstAddr;
+										destination.Port = ntohs(tcpHeader->DstPort);
+
+										ObservePayload(destination, tcpHeader->SrcPort, payloadBuffer, payloadLength);
+									}
+
+									if (route == FlowRoute::HttpProxy || route == FlowRoute::HttpsProxy)
 									{
 										modifiedPacket = true;
 
-										// Means that the data is originating from our proxy in response
-										// to a client's request, which means it was originally meant to
-										// go somewhere else. We need to reorder the data such as the
-										// src and destination ports and addresses and divert it back
-										// inbound, so it appears to be an inbound response from the
-										// original external server.
-										//
-										// In our case, this is very easy to figure out, because we are
-										// not yet doing any port independent protocol mapping and thus
-										// are only diverting port 80 traffic to m_httpListenerPort, and
-										// port 443 traffic to m_httpsListenerPort. However, XXX TODO -
-										// When we start doing these things, we'll need a mechanism by
-										// which to store the original port before we changed it. This
-										// would have to be part of a proper flow tracking system.
-
-										uint32_t dstAddr = ipV4Header->DstAddr;
-										ipV4Header->DstAddr = ipV4Header->SrcAddr;
-										ipV4Header->SrcAddr = dstAddr;
+										// If the process was identified as a process that is permitted to access the
+										// internet, and is not a system process or ourselves, then we divert its packets
+										// back inbound to the local machine, changing the destination port appropriately.
+										uint32_t dstAddress = ipV4Header->DstAddr;
 
-										tcpHeader->SrcPort = (tcpHeader->SrcPort == m_httpListenerPort) ? StandardHttpPort : StandardHttpsPort;
+										ipV4Header->DstAddr = ipV4Header->SrcAddr;
+										ipV4Header->SrcAddr = dstAddress;
 
 										addr.Direction = WINDIVERT_DIRECTION_INBOUND;
+
+										tcpHeader->DstPort = (route == FlowRoute::HttpProxy) ? m_httpListenerPort : m_httpsListenerPort;
 									}
-									else if (tcpHeader->DstPort == StandardHttpPort || tcpHeader->DstPort == StandardHttpsPort)
-									{
-										
-
-										// This means outbound traffic has been captured that we know for sure is
-										// not coming from our proxy in response to a client, but we don't know that it
-										// isn't the upstream portion of our proxy trying to fetch a response on behalf
-										// of a connected client. So, we need to check if we have a cached result for
-										// information about the binary generating the outbound traffic for two reasons.
-										//
-										// First, we need to ensure that it's not us, obviously. Secondly, we need to
-										// ensure that the binary has been granted firewall access to generate outbound
-										// traffic.
-
-										if (m_v4Shouldfilter[tcpHeader->SrcPort])
-										{
-                                            modifiedPacket = true;
+								}
+							}
 
-											// If the process was identified as a process that is permitted to access the
-											// internet, and is not a system process or ourselves, then we divert its packets
-											// back inbound to the local machine, changing the destination port appropriately.
-											uint32_t dstAddress = ipV4Header->DstAddr;
+							// The ipV6 version works exactly the same, just with larger storage for the larger
+							// addresses. Look at the ipv4 version notes for clarification on anything.
+							if (ipV6Header != nullptr && tcpHeader != nullptr)
+							{
+								if (tcpHeader->SrcPort == m_httpListenerPort || tcpHeader->SrcPort == m_httpsListenerPort)
+								{
+									modifiedPacket = true;
 
-											ipV4Header->DstAddr = ipV4Header->SrcAddr;
-											ipV4Header->SrcAddr = dstAddress;
+									uint32_t dstAddr[4];
+									dstAddr[0] = ipV6Header->DstAddr[0];
+									dstAddr[1] = ipV6Header->DstAddr[1];
+									dstAddr[2] = ipV6Header->DstAddr[2];
+									dstAddr[3] = ipV6Header->DstAddr[3];
 
-											addr.Direction = WINDIVERT_DIRECTION_INBOUND;
+									ipV6Header->DstAddr[0] = ipV6Header->SrcAddr[0];
+									ipV6Header->DstAddr[1] = ipV6Header->SrcAddr[1];
+									ipV6Header->DstAddr[2] = ipV6Header->SrcAddr[2];
+									ipV6Header->DstAddr[3] = ipV6Header->SrcAddr[3];
 
-											tcpHeader->DstPort = (tcpHeader->DstPort == StandardHttpPort) ? m_httpListenerPort : m_httpsListenerPort;
-										}
+									ipV6Header->SrcAddr[0] = dstAddr[0];
+									ipV6Header->SrcAddr[1] = dstAddr[1];
+									ipV6Header->SrcAddr[2] = dstAddr[2];
+									ipV6Header->SrcAddr[3] = dstAddr[3];
+
+									const uint16_t originalPort = network::OriginalPortTable::Shared().Get(true, ntohs(tcpHeader->DstPort));
+
+									if (originalPort != 0)
+									{
+										tcpHeader->SrcPort = htons(originalPort);
+									}
+									else
+									{
+										tcpHeader->SrcPort = (tcpHeader->SrcPort == m_httpListenerPort) ? StandardHttpPort : StandardHttpsPort;
 									}
-								}
 
-								// The ipV6 version works exactly the same, just with larger storage for the larger
-								// addresses. Look at the ipv4 version notes for clarification on anything.
-								if (ipV6Header != nullptr && tcpHeader != nullptr)
+									addr.Direction = WINDIVERT_DIRECTION_INBOUND;
+								}
+								else
 								{
-									if (tcpHeader->SrcPort == m_httpListenerPort || tcpHeader->SrcPort == m_httpsListenerPort)
+									const FlowRoute route = static_cast<FlowRoute>(m_v6Routes[tcpHeader->SrcPort].load());
+
+									if (payloadBuffer != nullptr && payloadLength > 0 && route != FlowRoute::Direct)
+									{
+										FlowEndpoint destination;
+										std::copy(ipV6Header->DstAddr, ipV6Header->DstAddr + 4, destination.Address.begin());
+										destination.Port = ntohs(tcpHeader->DstPort);
+										destination.V6 = true;
+
+										ObservePayload(destination, tcpHeader->SrcPort, payloadBuffer, payloadLength);
+									}
+
+									if (route == FlowRoute::HttpProxy || route == FlowRoute::HttpsProxy)
 									{
 										modifiedPacket = true;
 
 										uint32_t dstAddr[4];
+
 										dstAddr[0] = ipV6Header->DstAddr[0];
 										dstAddr[1] = ipV6Header->DstAddr[1];
 										dstAddr[2] = ipV6Header->DstAddr[2];
@@ -512,278 +800,92 @@ namespace te
 										ipV6Header->SrcAddr[2] = dstAddr[2];
 										ipV6Header->SrcAddr[3] = dstAddr[3];
 
-										tcpHeader->SrcPort = (tcpHeader->SrcPort == m_httpListenerPort) ? StandardHttpPort : StandardHttpsPort;
-
 										addr.Direction = WINDIVERT_DIRECTION_INBOUND;
-									}
-									else if (tcpHeader->DstPort == StandardHttpPort || tcpHeader->DstPort == StandardHttpsPort)
-									{
-										if (m_v6Shouldfilter[tcpHeader->SrcPort])
-										{
-											modifiedPacket = true;
-
-											uint32_t dstAddr[4];
-
-											dstAddr[0] = ipV6Header->DstAddr[0];
-											dstAddr[1] = ipV6Header->DstAddr[1];
-											dstAddr[2] = ipV6Header->DstAddr[2];
-											dstAddr[3] = ipV6Header->DstAddr[3];
 
-											ipV6Header->DstAddr[0] = ipV6Header->SrcAddr[0];
-											ipV6Header->DstAddr[1] = ipV6Header->SrcAddr[1];
-											ipV6Header->DstAddr[2] = ipV6Header->SrcAddr[2];
-											ipV6Header->DstAddr[3] = ipV6Header->SrcAddr[3];
-
-											ipV6Header->SrcAddr[0] = dstAddr[0];
-											ipV6Header->SrcAddr[1] = dstAddr[1];
-											ipV6Header->SrcAddr[2] = dstAddr[2];
-											ipV6Header->SrcAddr[3] = dstAddr[3];
-
-											addr.Direction = WINDIVERT_DIRECTION_INBOUND;
-
-											tcpHeader->DstPort = (tcpHeader->DstPort == StandardHttpPort) ? m_httpListenerPort : m_httpsListenerPort;
-										}
+										tcpHeader->DstPort = (route == FlowRoute::HttpProxy) ? m_httpListenerPort : m_httpsListenerPort;
 									}
 								}
-							} // if(!isLocalIpv4)
-						} // if (addr.Direction == WINDIVERT_DIRECTION_OUTBOUND)
-
-						payloadBuffer = nullptr;
-						payloadLength = 0;
-
-						if (modifiedPacket)
-						{
-							WinDivertHelperCalcChecksums(readBuffer.data(), recvLength, 0);
-						}
-						else
-						{
-							WinDivertHelperCalcChecksums(readBuffer.data(), recvLength, WINDIVERT_HELPER_NO_REPLACE);
-						}
-						
-
-						if (!WinDivertSendEx(divertHandle, readBuffer.data(), recvLength, 0, &addr, nullptr, nullptr))
-						{
-							// XXX TODO - Perhaps report warning instead? This isn't exactly critical. Maybe a single
-							// packet gets lost, maybe it completes under the hood. Either way we can do nothing, and
-							// this should be expected to happen at least once.
-							//
-							// Update - Disabling this but leaving it here. This floods our logs when we block internet
-							// on purpose.
-							/*
-							std::string errMessage("In WinDiverter::RunDiversion(LPVOID) - During call to WinDivert SendEx, got error:\t");
-							errMessage.append(std::to_string(GetLastError()));
-							ReportError(errMessage);
-							*/
-						}
-					}// while (m_running)
+							}
+						} // if(!isLocalIpv4)
+					} // if (addr.Direction == WINDIVERT_DIRECTION_OUTBOUND)
 
-					if (ipv4TcpTable != nullptr)
+					if (modifiedPacket)
 					{
-						free(ipv4TcpTable);
+						++m_packetsModified;
+						WinDivertHelperCalcChecksums(packet, packetLength, 0);
 					}
-
-					if (ipv6TcpTable != nullptr)
+					else
 					{
-						free(ipv6TcpTable);
+						WinDivertHelperCalcChecksums(packet, packetLength, WINDIVERT_HELPER_NO_REPLACE);
 					}
+
+					return true;
 				}
 
-				std::string WinDiverter::GetPacketProcessBinaryPath(const unsigned long processId) const
+				const FlowRoute WinDiverter::RouteNewFlow(const FlowEndpoint& destination, const uint16_t localPort)
 				{
-					if (processId == 4)
+					FlowRoute route = FlowRoute::Direct;
+
+					if (m_flowClassifier != nullptr)
 					{
-						// OS process.
-						return std::string(u8"SYSTEM");
+						route = m_flowClassifier->GetRoute(destination);
 					}
-
-					HANDLE processHandle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
-
-					if (processHandle != nullptr && processHandle != INVALID_HANDLE_VALUE)
+					else if (destination.Port == ntohs(StandardHttpPort))
 					{
-						DWORD resSize = MAX_PATH;
-						char filename[MAX_PATH];
-
-						if (QueryFullProcessImageNameA(processHandle, 0, filename, &resSize) == 0)
-						{
-							std::string err(u8"In WinDiverter::GetPacketProcessBinaryPath(const unsigned long) - Failed to get binary path using pid ");
-							err.append(std::to_string(processId)).append(u8".");
-							ReportError(err);
-
-							return std::string();
-						}
-						else
-						{
-							CloseHandle(processHandle);
-							return std::string(filename);
-						}
+						route = FlowRoute::HttpProxy;
 					}
-					else
+					else if (destination.Port == ntohs(StandardHttpsPort))
 					{
-						#ifndef NDEBUG
-						std::string err(u8"In WinDiverter::GetPacketProcessBinaryPath(const unsigned long) - Failed to open process to query binary path using pid ");
-						err.append(std::to_string(processId)).append(u8".");
-						ReportError(err);
-						#endif
+						route = FlowRoute::HttpsProxy;
 					}
 
-					return std::string();
+					// Whatever was recorded for this port belonged to an earlier flow, so it's
+					// replaced either way.
+					const bool diverted = route == FlowRoute::HttpProxy || route == FlowRoute::HttpsProxy;
+					network::OriginalPortTable::Shared().Set(destination.V6, ntohs(localPort), diverted ? destination.Port : 0);
+
+					return route;
 				}
 
-				DWORD WinDiverter::GetPacketProcess(uint16_t localPort, uint32_t localV4Address, PMIB_TCPTABLE2* table, DWORD& currentTableSize)
+				void WinDiverter::ObservePayload(const FlowEndpoint& destination, const uint16_t localPort, const void* payload, const uint32_t payloadLength)
 				{
-					// We deliberately never permanently free the table on purpose. Eventually, this table will
-					// reach a size where reallocations don't happen anymore, and we can recycle it.
+					auto& awaiting = destination.V6 ? m_v6AwaitingPayload[localPort] : m_v4AwaitingPayload[localPort];
 
-					if (currentTableSize == 0)
+					// Packets of the same flow can be handled by more than one diversion thread
+					// at once, so only whoever clears the flag gets to look.
+					if (m_flowClassifier == nullptr || !awaiting.exchange(false))
 					{
-						currentTableSize = sizeof(MIB_TCPTABLE2);
-						*table = static_cast<PMIB_TCPTABLE2>(malloc(currentTableSize));
+						return;
 					}
 
-					if (*table == nullptr)
-					{
-						currentTableSize = 0;
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t, PMIB_TCPTABLE2, DWORD&) - Failed to initialize table.");
-						return 0;
-					}
+					const auto route = static_cast<FlowRoute>(destination.V6 ? m_v6Routes[localPort].load() : m_v4Routes[localPort].load());
 
-					DWORD dwRetVal = 0;
-
-					if ((dwRetVal = GetTcpTable2(*table, &currentTableSize, FALSE)) == ERROR_INSUFFICIENT_BUFFER)
-					{
-						free(*table);
-						*table = nullptr;
-
-						*table = static_cast<PMIB_TCPTABLE2>(malloc(currentTableSize));
-
-						if (*table == nullptr)
-						{
-							currentTableSize = 0;
-							ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t, PMIB_TCPTABLE2, DWORD&) - Failed to resize table.");
-							return 0;
-						}
+					m_flowClassifier->OnFirstPayload(destination, route, static_cast<const uint8_t*>(payload), payloadLength);
+				}
 
-						dwRetVal = GetTcpTable2(*table, &currentTableSize, FALSE);
-					}
+				DWORD WinDiverter::GetPacketProcess(uint16_t localPort, uint32_t localV4Address)
+				{
+					DWORD processId = 0;
 
-					if (dwRetVal == NO_ERROR)
+					if (m_tcpOwners.GetOwner(localV4Address, localPort, processId))
 					{
-						// Table members, spare things like dwOwningPid, are in network order aka big endian.
-						for (DWORD i = 0; i < (*table)->dwNumEntries; ++i)
-						{
-							// The reason why we accept zero as the address is that it is equal to "0.0.0.0:PORT", so
-							// it counts.
-							if ((*table)->table[i].dwLocalAddr == localV4Address) // (*table)->table[i].dwLocalAddr == 0 && localV4Address == 0 || 
-							{
-								// See https://msdn.microsoft.com/en-us/library/windows/desktop/aa366909(v=vs.85).aspx
-								// Upper bits may contain junk data.
-								if (((*table)->table[i].dwLocalPort & 0xFFFF) == localPort)
-								{
-									return (*table)->table[i].dwOwningPid;
-								}
-							}
-						}
-					}
-					else
-					{
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t, PMIB_TCPTABLE2, DWORD&) - Failed to populate table.");
-
-						if (*table != nullptr)
-						{
-							free(*table);
-							*table = nullptr;
-						}
-
-						currentTableSize = 0;
+						return processId;
 					}
 
 					// We consider 4 to always be a system process. So, let's default to
 					// 4 here. If we didn't get an error somewhere along the way, then
 					// lets assume it's the SYSTEM.
-					ReportWarning("In WinDiverter::GetPacketProcess(uint16_t, uint32_t, PMIB_TCPTABLE2, DWORD&) - Was unable to process to port matching. Assuming SYSTEM process.");
+					ReportWarning("In WinDiverter::GetPacketProcess(uint16_t, uint32_t) - Was unable to process to port matching. Assuming SYSTEM process.");
 					return 4;
 				}
 
-				DWORD WinDiverter::GetPacketProcess(uint16_t localPort, uint32_t* localV6Address, PMIB_TCP6TABLE2* table, DWORD& currentTableSize)
+				DWORD WinDiverter::GetPacketProcess(uint16_t localPort, uint32_t* localV6Address)
 				{
-					// We deliberately never permanently free the table on purpose. Eventually, this table will
-					// reach a size where reallocations don't happen anymore, and we can recycle it.
-
-					if (!table)
-					{
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t[4], PMIB_TCP6TABLE2, DWORD&) - Expected pointer to TABLE structure, got nullptr!");
-						return 0;
-					}
-
-					if (localV6Address == nullptr)
-					{
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t[4], PMIB_TCP6TABLE2, DWORD&) - Expected uint32_t array with length of four for localV6Address, got nullptr!");
-						return 0;
-					}
-
-					if (currentTableSize == 0)
-					{
-						currentTableSize = sizeof(MIB_TCP6TABLE2);
-						*table = static_cast<PMIB_TCP6TABLE2>(malloc(currentTableSize));
-					}
-
-					if (*table == nullptr)
-					{
-						currentTableSize = 0;
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t[4], PMIB_TCP6TABLE2, DWORD&) - Failed to initialize table.");
-						return 0;
-					}
-
-					DWORD dwRetVal = 0;
-
-					if ((dwRetVal = GetTcp6Table2(*table, &currentTableSize, FALSE)) == ERROR_INSUFFICIENT_BUFFER)
-					{
-						free(*table);
-						*table = nullptr;
-
-						*table = static_cast<PMIB_TCP6TABLE2>(malloc(currentTableSize));
-
-						if (table == nullptr)
-						{
-							currentTableSize = 0;
-							ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t[4], PMIB_TCP6TABLE2, DWORD&) - Failed to resize table.");
-							return 0;
-						}
+					DWORD processId = 0;
 
-						dwRetVal = GetTcp6Table2(*table, &currentTableSize, FALSE);
-					}
-
-					if (dwRetVal == NO_ERROR)
+					if (m_tcpOwners.GetOwner(localV6Address, localPort, processId))
 					{
-						// Table members, spare things like dwOwningPid, are in network order aka big endian.
-						for (DWORD i = 0; i < (*table)->dwNumEntries; ++i)
-						{
-							auto oPtr = (uint32_t*)((*table)->table[i].LocalAddr.u.Byte);
-
-							// The reason why we accept zero as the address is that it is equal to "[::]:PORT", so
-							// it counts.
-							if (std::memcmp(localV6Address, oPtr, 4) == 0)
-							{
-								// See https://msdn.microsoft.com/en-us/library/windows/desktop/aa366909(v=vs.85).aspx
-								// Upper bits may contain junk data.
-								if (((*table)->table[i].dwLocalPort & 0xFFFF) == localPort)
-								{	
-									return (*table)->table[i].dwOwningPid;
-								}
-							}
-						}
-					}
-					else
-					{
-						ReportError(u8"In WinDiverter::GetPacketProcess(uint16_t, uint32_t[4], PMIB_TCP6TABLE2, DWORD&) - Failed to populate table.");
-
-						if (*table != nullptr)
-						{
-							free(*table);
-							*table = nullptr;
-						}
-
-						currentTableSize = 0;
+						return processId;
 					}
 
 					return 0;
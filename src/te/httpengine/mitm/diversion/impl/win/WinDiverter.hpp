@@ -32,11 +32,14 @@
 #pragma once
 
 #include "../../BaseDiverter.hpp"
+#include "TcpOwnerTable.hpp"
+#include "ProcessVerdictCache.hpp"
 
 #include <cstdint>
 #include <climits>
 #include <array>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -167,6 +170,21 @@ namespace te
 					/// </returns>
 					virtual const bool IsRunning() const;
 
+					/// <summary>
+					/// Gets a snapshot of the packet counters for this diverter, including the
+					/// hit and miss counts of the process verdict cache.
+					/// </summary>
+					/// <returns>
+					/// A snapshot of the current packet counters and rates.
+					/// </returns>
+					virtual DiversionStats GetStats();
+
+					/// <summary>
+					/// Drops all cached firewall verdicts, so that every process is checked
+					/// against the firewall check callback again on its next new connection.
+					/// </summary>
+					virtual void ClearFirewallVerdicts();
+
 				protected:
 
 					// These will track process ID's and the full process name
@@ -182,6 +200,20 @@ namespace te
 					std::array<std::atomic_bool, (std::numeric_limits<uint16_t>::max)()> m_v4Shouldfilter = {};
 					std::array<std::atomic_bool, (std::numeric_limits<uint16_t>::max)()> m_v6Shouldfilter = {};
 
+					/// <summary>
+					/// The FlowRoute of each flow, by local port in network order, decided when
+					/// the flow is opened.
+					/// </summary>
+					std::array<std::atomic_uint8_t, 65536> m_v4Routes = {};
+					std::array<std::atomic_uint8_t, 65536> m_v6Routes = {};
+
+					/// <summary>
+					/// Whether the first payload of each flow is still to be handed to the flow
+					/// classifier, by local port in network order.
+					/// </summary>
+					std::array<std::atomic_bool, 65536> m_v4AwaitingPayload = {};
+					std::array<std::atomic_bool, 65536> m_v6AwaitingPayload = {};
+
 					/// <summary>
 					/// Constructs a new WinDiverter used for diverting network traffic on Windows
 					/// Vista and later. This constructor should be expected to throw a
@@ -194,6 +226,9 @@ namespace te
 					/// that traffic intercepted from specific machine local binaries is permitted
 					/// to be sent outbound from the device. Required.
 					/// </param>
+					/// <param name="flowClassifier">
+					/// Decides which flows are diverted, and to which listener. Optional.
+					/// </param>
 					/// <param name="onInfo">
 					/// Optional callback to receive informational messages regarding non-critical events.
 					/// </param>
@@ -207,6 +242,7 @@ namespace te
 					/// </param>
 					WinDiverter(
 						util::cb::FirewallCheckFunction firewallCheckCb,
+						FlowClassifier* flowClassifier = nullptr,
 						util::cb::MessageFunction onInfo = nullptr,
 						util::cb::MessageFunction onWarning = nullptr,
 						util::cb::MessageFunction onError = nullptr
@@ -217,6 +253,14 @@ namespace te
 					/// </summary>
 					static constexpr uint32_t PacketBufferLength = 65535;
 
+					/// <summary>
+					/// The number of overlapped receives that each diversion thread keeps posted
+					/// against the WinDivert handle, which is also the largest number of packets
+					/// that will be classified and reinjected together in a single batch. Only
+					/// applies when HTTP_FILTERING_ENGINE_USE_EX is defined.
+					/// </summary>
+					static constexpr uint32_t DiversionBatchSize = 16;
+
 					/// <summary>
 					/// Standard HTTP port, aka port 80. Stored in network order aka big endian so
 					/// that no conversion is required in equality tests.
@@ -258,6 +302,21 @@ namespace te
 					using PacketBuffer = std::array<unsigned char, PacketBufferLength>;
 					using ProcessNfo = std::tuple<unsigned long, bool, std::chrono::high_resolution_clock::time_point>;
 
+					/// <summary>
+					/// One entry in the per thread receive ring. Holds everything a single
+					/// overlapped receive needs, including its event, which is created once and
+					/// reused for every receive posted on the slot.
+					/// </summary>
+					struct DiversionSlot
+					{
+						PacketBuffer buffer;
+						WINDIVERT_ADDRESS addr;
+						OVERLAPPED overlapped;
+						uint32_t recvLength = 0;
+						bool pending = false;
+						bool reinject = false;
+					};
+
 					/// <summary>
 					/// This method is the one that generated threads for running the diversion
 					/// invoke. This is where all the work is really done.
@@ -268,24 +327,106 @@ namespace te
 					void RunDiversion(LPVOID diversionHandlePtr);
 
 					/// <summary>
-					/// Attempts to get limited read permission for the process identified by the
-					/// supplied process ID, then attempts to read the full path of the binary
-					/// latched to the process ID and return it.
+					/// Diverts with one blocking receive at a time. This is how every thread
+					/// diverts when HTTP_FILTERING_ENGINE_USE_EX isn't defined, and how a thread
+					/// falls back to diverting when it can't set up its receive ring.
+					/// </summary>
+					/// <param name="divertHandle">
+					/// A valid WinDivert handle.
+					/// </param>
+					void RunBlockingDiversion(HANDLE divertHandle);
+
+					/// <summary>
+					/// Classifies and, where required, rewrites a single captured packet in place.
+					/// Checksums are recalculated here, so the packet is ready for reinjection when
+					/// this method returns true.
+					/// </summary>
+					/// <param name="packet">
+					/// The raw packet data.
+					/// </param>
+					/// <param name="packetLength">
+					/// The length of the raw packet data.
+					/// </param>
+					/// <param name="addr">
+					/// The WinDivert address captured with the packet. The direction will be
+					/// modified if the packet is diverted.
+					/// </param>
+					/// <returns>
+					/// True if the packet should be reinjected, false if it should be dropped.
+					/// </returns>
+					bool ProcessPacket(unsigned char* packet, const uint32_t packetLength, WINDIVERT_ADDRESS& addr);
+
+					/// <summary>
+					/// Reinjects the supplied packet and updates the sent or dropped counters
+					/// accordingly.
+					/// </summary>
+					/// <param name="divertHandle">
+					/// The WinDivert handle to send the packet on.
+					/// </param>
+					/// <param name="packet">
+					/// The raw packet data.
+					/// </param>
+					/// <param name="packetLength">
+					/// The length of the raw packet data.
+					/// </param>
+					/// <param name="addr">
+					/// The WinDivert address for the packet.
+					/// </param>
+					void Reinject(HANDLE divertHandle, unsigned char* packet, const uint32_t packetLength, WINDIVERT_ADDRESS& addr);
+
+					/// <summary>
+					/// Decides the route of a new flow from a process that is to be filtered, and
+					/// records its original port in network::OriginalPortTable if it's diverted.
 					/// </summary>
-					/// <param name="processId">
-					/// The process to attempt to read.
+					/// <param name="destination">
+					/// Where the flow is headed.
+					/// </param>
+					/// <param name="localPort">
+					/// The local port of the flow, in network order.
 					/// </param>
 					/// <returns>
-					/// A string with a ::size() greater than zero if the process image name, aka
-					/// the full path of the executable latched to the process ID, was successfully
-					/// read. A string with a ::size() of zero if the read failed.
+					/// The route the flow is to take.
 					/// </returns>
-					std::string GetPacketProcessBinaryPath(const unsigned long processId) const;
+					const FlowRoute RouteNewFlow(const FlowEndpoint& destination, const uint16_t localPort);
 
 					/// <summary>
-					/// Given the supplied port, ip address and table information, attempts to
-					/// return the process ID for the process bound to the supplied port and
-					/// address.
+					/// Hands the supplied payload to the flow classifier, if it's the first of a
+					/// flow that the classifier asked to see.
+					/// </summary>
+					/// <param name="destination">
+					/// Where the flow is headed.
+					/// </param>
+					/// <param name="localPort">
+					/// The local port of the flow, in network order.
+					/// </param>
+					/// <param name="payload">
+					/// The payload of the packet.
+					/// </param>
+					/// <param name="payloadLength">
+					/// The length of the payload.
+					/// </param>
+					void ObservePayload(const FlowEndpoint& destination, const uint16_t localPort, const void* payload, const uint32_t payloadLength);
+
+#ifdef HTTP_FILTERING_ENGINE_USE_EX
+					/// <summary>
+					/// Posts an overlapped receive on the supplied slot, reusing its event.
+					/// </summary>
+					/// <param name="divertHandle">
+					/// The WinDivert handle to receive on.
+					/// </param>
+					/// <param name="slot">
+					/// The slot to receive into.
+					/// </param>
+					/// <returns>
+					/// True if the receive was posted or completed immediately, false on error.
+					/// </returns>
+					bool PostReceive(HANDLE divertHandle, DiversionSlot& slot);
+#endif // #ifdef HTTP_FILTERING_ENGINE_USE_EX
+
+					/// <summary>
+					/// Given the supplied port and ip address, attempts to return the process ID
+					/// for the process bound to the supplied port and address, using the shared
+					/// TCP owner index.
 					/// </summary>
 					/// <param name="localPort">
 					/// The port number to be used to determine the process ID for the machine local
@@ -295,28 +436,18 @@ namespace te
 					/// The address of the interface to be used to determine the process ID for the
 					/// machine local binary bound to the supplied port, if it's in use.
 					/// </param>
-					/// <param name="table">
-					/// A pointer to a pointer of a MIB_TCPTABLE2 structure to be allocated,
-					/// reallocated (resizing), and used for fetching the TCP table from the kernel.
-					/// This object can and will be reallocated to accomodate entries that exceed
-					/// the present storage capacity. The currentTableSize parameter will be updated
-					/// if the table is resized.
-					/// </param>
-					/// <param name="currentTableSize">
-					/// The current size allocated to the supplied MIB_TCPTABLE2 structure. Will be
-					/// updated in the event that the supplied MIB_TCPTABLE2 structure is resized.
-					/// </param>
 					/// <returns>
 					/// A non-zero value if a process was found bound to the interface address and
-					/// port combination. A value of zero otherwise. A value of four indicates that
-					/// a protected operating system process has control of the port.
+					/// port combination. A value of four indicates that a protected operating
+					/// system process has control of the port, which is also what we assume when
+					/// no owner could be found at all.
 					/// </returns>
-					DWORD GetPacketProcess(uint16_t localPort, uint32_t localV4Address, PMIB_TCPTABLE2* table, DWORD& currentTableSize);
+					DWORD GetPacketProcess(uint16_t localPort, uint32_t localV4Address);
 
 					/// <summary>
-					/// Given the supplied port, ip address and table information, attempts to
-					/// return the process ID for the process bound to the supplied port and
-					/// address.
+					/// Given the supplied port and ip address, attempts to return the process ID
+					/// for the process bound to the supplied port and address, using the shared
+					/// TCP owner index.
 					/// </summary>
 					/// <param name="localPort">
 					/// The port number to be used to determine the process ID for the machine local
@@ -329,23 +460,23 @@ namespace te
 					/// length of four. No bounds checks are done. Burden is on the user to pass
 					/// correct data.
 					/// </param>
-					/// <param name="table">
-					/// A pointer to a pointer of a MIB_TCP6TABLE2 structure to be allocated,
-					/// reallocated (resizing), and used for fetching the TCP table from the kernel.
-					/// This object can and will be reallocated to accomodate entries that exceed
-					/// the present storage capacity. The currentTableSize parameter will be updated
-					/// if the table is resized.
-					/// </param>
-					/// <param name="currentTableSize">
-					/// The current size allocated to the supplied MIB_TCP6TABLE2 structure. Will be
-					/// updated in the event that the supplied MIB_TCP6TABLE2 structure is resized.
-					/// </param>
 					/// <returns>
 					/// A non-zero value if a process was found bound to the interface address and
 					/// port combination. A value of zero otherwise. A value of four indicates that
 					/// a protected operating system process has control of the port.
 					/// </returns>
-					DWORD GetPacketProcess(uint16_t localPort, uint32_t* localV6Address, PMIB_TCP6TABLE2* table, DWORD& currentTableSize);
+					DWORD GetPacketProcess(uint16_t localPort, uint32_t* localV6Address);
+
+					/// <summary>
+					/// Index of local TCP endpoints to owning process IDs, shared by every
+					/// diversion thread.
+					/// </summary>
+					TcpOwnerTable m_tcpOwners;
+
+					/// <summary>
+					/// Cache of firewall verdicts per process, shared by every diversion thread.
+					/// </summary>
+					ProcessVerdictCache m_processVerdicts;
 
 				};
 
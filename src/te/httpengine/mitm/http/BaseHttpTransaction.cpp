@@ -43,7 +43,23 @@ namespace te
 
 				const boost::string_ref BaseHttpTransaction::ContentTypeJavascript = u8"javascript";
 
-				BaseHttpTransaction::BaseHttpTransaction()
+				std::atomic<int32_t> BaseHttpTransaction::s_compressionLevel{ boost::iostreams::zlib::default_compression };
+
+				void BaseHttpTransaction::SetCompressionLevel(const int32_t level)
+				{
+					s_compressionLevel = (std::min)((std::max)(level, static_cast<int32_t>(boost::iostreams::zlib::default_compression)), static_cast<int32_t>(boost::iostreams::zlib::best_compression));
+				}
+
+				const int32_t BaseHttpTransaction::GetCompressionLevel()
+				{
+					return s_compressionLevel;
+				}
+
+				BaseHttpTransaction::BaseHttpTransaction(std::shared_ptr<util::mem::Arena> arena)
+					:
+					m_arena(std::move(arena)),
+					m_headers(m_arena.get()),
+					m_payloadChunks(util::mem::ArenaAllocator<std::pair<size_t, size_t>>(m_arena.get()))
 				{					
 					m_httpParserSettings.on_body = &OnBody;
 					m_httpParserSettings.on_chunk_complete = &OnChunkComplete;
@@ -57,12 +73,23 @@ namespace te
 
 				BaseHttpTransaction::~BaseHttpTransaction()
 				{
-					if (m_httpParser != nullptr)
+					// Parsers taken from the arena go when the arena does.
+					if (m_httpParser != nullptr && m_arena == nullptr)
 					{
 						free(m_httpParser);
 					}
 				}
 
+				http_parser* BaseHttpTransaction::AllocateParser()
+				{
+					if (m_arena != nullptr)
+					{
+						return static_cast<http_parser*>(m_arena->Allocate(sizeof(http_parser), alignof(http_parser)));
+					}
+
+					return static_cast<http_parser*>(malloc(sizeof(http_parser)));
+				}
+
 				const HttpProtocolVersion BaseHttpTransaction::GetHttpVersion() const
 				{
 					return m_httpVersion;
@@ -75,70 +102,77 @@ namespace te
 
 				void BaseHttpTransaction::AddHeader(const std::string& name, std::string value, const bool replaceIfExists)
 				{
-					std::string headerNameCopy = name;
+					AddHeaderWithHash(name, util::http::headers::HashName(name.data(), name.size()), value, replaceIfExists);
+				}
+
+				void BaseHttpTransaction::AddHeader(const util::http::headers::KnownHeader& name, std::string value, const bool replaceIfExists)
+				{
+					AddHeaderWithHash(name.Name(), name.Hash(), value, replaceIfExists);
+				}
 
-					auto matchRange = m_headers.equal_range(headerNameCopy);
+				void BaseHttpTransaction::AddHeaderWithHash(const boost::string_ref name, const uint32_t hash, const boost::string_ref value, const bool replaceIfExists)
+				{
+					m_mediaKindsKnown = false;
+					DiscardEncodedPayload();
 
 					if (replaceIfExists)
 					{
 						// Since replaceIfExists is true, we want to remove all headers that have the same
 						// name before inserting the new header value.
-						while (matchRange.first != matchRange.second)
-						{
-							m_headers.erase(matchRange.first++);
-						}
-
-						m_headers.insert(std::make_pair(headerNameCopy, value));
-
+						m_headers.Remove(name, hash);
+						m_headers.Add(name, hash, value);
 						return;
 					}
-					else
+
+					auto matchRange = m_headers.EqualRange(name, hash);
+
+					while (matchRange.first != matchRange.second)
 					{
-						auto it = matchRange.first;
-						while (it != matchRange.second)
+						// If the exact same header and value exist, we clearly don't want to add
+						// another.
+						if (util::hash::ICaseEquals(matchRange.first->second, value))
 						{
-							// If the exact same header and value exist, we clearly don't want to add
-							// another.
-							if (boost::iequals(it->second, value))
-							{
-								//Exists already, both name and value
-								return;
-							}
-
-							++it;
+							//Exists already, both name and value
+							return;
 						}
 
-						m_headers.insert(std::make_pair(headerNameCopy, value));
+						++matchRange.first;
 					}
+
+					m_headers.Add(name, hash, value);
 				}
 
 				void BaseHttpTransaction::RemoveHeader(const std::string& name, const std::string& value)
 				{
-					auto matchRange = m_headers.equal_range(name);
+					m_mediaKindsKnown = false;
+					DiscardEncodedPayload();
 
-					while (matchRange.first != matchRange.second)
-					{
-						// Must match exactly both key and value to qualify for removal
-						if (boost::iequals(matchRange.first->second.c_str(), value.c_str()))
-						{
-							m_headers.erase(matchRange.first++);
-						}
-					}
+					// Must match exactly both key and value to qualify for removal
+					m_headers.Remove(name, util::http::headers::HashName(name.data(), name.size()), value);
 				}
 
 				void BaseHttpTransaction::RemoveHeader(const std::string& name)
 				{
-					auto matchRange = m_headers.equal_range(name);
+					m_mediaKindsKnown = false;
+					DiscardEncodedPayload();
+					m_headers.Remove(name, util::http::headers::HashName(name.data(), name.size()));
+				}
 
-					while (matchRange.first != matchRange.second)
-					{
-						m_headers.erase(matchRange.first++);
-					}
+				void BaseHttpTransaction::RemoveHeader(const util::http::headers::KnownHeader& name)
+				{
+					m_mediaKindsKnown = false;
+					DiscardEncodedPayload();
+					m_headers.Remove(name.Name(), name.Hash());
 				}
 
-				const HttpHeaderRangeMatch BaseHttpTransaction::GetHeader(const std::string& header) const
+				const HttpHeaderRangeMatch BaseHttpTransaction::GetHeader(boost::string_ref header) const
 				{					
-					return m_headers.equal_range(header);
+					return m_headers.EqualRange(header, util::http::headers::HashName(header.data(), header.size()));
+				}
+
+				const HttpHeaderRangeMatch BaseHttpTransaction::GetHeader(const util::http::headers::KnownHeader& header) const
+				{
+					return m_headers.EqualRange(header.Name(), header.Hash());
 				}
 
 				const bool BaseHttpTransaction::HeadersComplete() const
@@ -146,9 +180,46 @@ namespace te
 					return m_headersComplete;
 				}
 
+				const bool BaseHttpTransaction::HeadersSent() const
+				{
+					return m_headersSent;
+				}
+
 				const bool BaseHttpTransaction::Parse(const size_t bytesReceived)
 				{
-					auto nparsed = http_parser_execute(m_httpParser, &m_httpParserSettings, m_buffer.data(), bytesReceived);
+					if (m_buffer == nullptr)
+					{
+						ReportError(u8"In BaseHttpTransaction::Parse(const size_t&) - No data has been read.");
+						return false;
+					}
+
+					// A full buffer means there was probably more waiting, so read more next time.
+					if (bytesReceived >= m_buffer->size())
+					{
+						m_readBufferSize = (std::min)(m_readBufferSize * 2, static_cast<size_t>(PayloadBufferReadSize));
+					}
+
+					if (!m_headersComplete)
+					{
+						// The headers are kept as slices of what we received, so keep it.
+						m_headers.BeginParse(m_buffer->data(), bytesReceived);
+					}
+
+					m_pipelinedOffset = 0;
+					m_pipelinedLength = 0;
+
+					auto nparsed = http_parser_execute(m_httpParser, &m_httpParserSettings, m_buffer->data(), bytesReceived);
+
+					if (HTTP_PARSER_ERRNO(m_httpParser) == HPE_PAUSED)
+					{
+						// ::OnMessageComplete() stopped the parser, so that whatever follows
+						// the message is left for the next one.
+						http_parser_pause(m_httpParser, 0);
+
+						m_pipelinedOffset = nparsed;
+						m_pipelinedLength = bytesReceived - nparsed;
+						nparsed = bytesReceived;
+					}
 
 					if (m_httpParser->upgrade == 1)
 					{
@@ -173,55 +244,172 @@ namespace te
 					return true;
 				}
 
+				const size_t BaseHttpTransaction::GetPipelinedLength() const
+				{
+					return m_pipelinedLength;
+				}
+
+				void BaseHttpTransaction::Reset()
+				{
+					const auto parserType = static_cast<http_parser_type>(m_httpParser->type);
+
+					if (m_arena != nullptr)
+					{
+						// Nothing may point into the arena once it's reset, so everything that
+						// was allocated from it goes first, and the parser is taken anew after.
+						m_headers.Release();
+						PayloadChunkList(m_payloadChunks.get_allocator()).swap(m_payloadChunks);
+
+						m_arena->Reset();
+
+						m_httpParser = AllocateParser();
+
+						if (m_httpParser == nullptr)
+						{
+							throw std::runtime_error(u8"In BaseHttpTransaction::Reset() - Failed to initialize http_parser.");
+						}
+					}
+					else
+					{
+						m_headers.Reset();
+						m_payloadChunks.clear();
+					}
+
+					http_parser_init(m_httpParser, parserType);
+					m_httpParser->data = this;
+
+					m_mediaKindsKnown = false;
+					m_payload.clear();
+					m_formattedHeaders.clear();
+					DiscardEncodedPayload();
+					m_inflater.reset();
+					m_rawMessage.reset();
+					m_rawMessageLength = 0;
+
+					m_headersComplete = false;
+					m_headersSent = false;
+					m_startLineModified = false;
+					m_payloadComplete = false;
+					m_shouldBlock = 0;
+					m_consumeAllBeforeSending = false;
+					m_inspectPayloadChunks = false;
+					m_decodeFailed = false;
+
+					if (m_pipelinedLength > 0 && m_buffer != nullptr)
+					{
+						std::memmove(m_buffer->data(), m_buffer->data() + m_pipelinedOffset, m_pipelinedLength);
+					}
+
+					m_pipelinedOffset = 0;
+				}
+
+				void BaseHttpTransaction::DiscardEncodedPayload()
+				{
+					if (m_hasEncodedPayload)
+					{
+						m_hasEncodedPayload = false;
+						m_encodedHeaders.clear();
+						m_encodedPayload.clear();
+					}
+				}
+
+				void BaseHttpTransaction::AdoptReadBuffer(util::mem::SharedBuffer buffer)
+				{
+					m_buffer = std::move(buffer);
+					m_pipelinedOffset = 0;
+					m_pipelinedLength = 0;
+				}
+
 				boost::asio::mutable_buffers_1 BaseHttpTransaction::GetReadBuffer()
 				{	
-					if (m_buffer.size() < PayloadBufferReadSize)
+					m_pipelinedOffset = 0;
+					m_pipelinedLength = 0;
+
+					if (m_buffer == nullptr || m_buffer->size() < m_readBufferSize)
 					{
-						m_buffer.resize(PayloadBufferReadSize);
+						m_buffer = util::mem::BufferPool::Shared().Acquire(m_readBufferSize);
 					}
 
 					if (m_headersComplete && !m_consumeAllBeforeSending)
 					{
 						m_payload.clear();
+						m_payloadChunks.clear();
+						m_rawMessage.reset();
+						m_rawMessageLength = 0;
+
+						if (m_inflater)
+						{
+							m_inflater->Clear();
+						}
 					}
 
-					return boost::asio::mutable_buffers_1(m_buffer.data(), PayloadBufferReadSize);
+					return boost::asio::mutable_buffers_1(m_buffer->data(), m_buffer->size());
 				}
 
-				boost::asio::const_buffers_1 BaseHttpTransaction::GetWriteBuffer()
+				HttpWriteBuffers BaseHttpTransaction::GetWriteBuffer()
 				{
+					boost::asio::const_buffer headers;
+
+					if (m_hasEncodedPayload && !m_headersSent)
+					{
+						// Inspected, but left as it was, so it goes out as it came in.
+						m_headersSent = true;
+
+						util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::EncodedPayloadsForwarded);
+
+						return HttpWriteBuffers{ {
+							boost::asio::const_buffer(m_encodedHeaders.data(), m_encodedHeaders.size()),
+							boost::asio::const_buffer(m_encodedPayload.data(), m_encodedPayload.size())
+						} };
+					}
+
 					if (!m_headersSent)
 					{
-						auto headersVector = HeadersToVector();				
-						auto newSize = headersVector.size() + m_payload.size();
-						headersVector.reserve(newSize);
+						boost::string_ref original;
 
-						if (m_payload.size() > 0)
-						{	
-							headersVector.insert(headersVector.end(), m_payload.begin(), m_payload.end());
+						if (!m_startLineModified && m_headers.GetOriginalBytes(original))
+						{
+							// Nothing has changed, so what we received is exactly what we'd
+							// format.
+							headers = boost::asio::const_buffer(original.data(), original.size());
+						}
+						else
+						{
+							m_formattedHeaders = HeadersToString();
+							headers = boost::asio::const_buffer(m_formattedHeaders.data(), m_formattedHeaders.size());
 						}
-
-						m_payload = std::move(headersVector);
 
 						m_headersSent = true;
 					}
 
-					return boost::asio::const_buffers_1(m_payload.data(), m_payload.size());
+					if (m_rawMessage != nullptr)
+					{
+						return HttpWriteBuffers{ { headers, boost::asio::const_buffer(m_rawMessage.get(), m_rawMessageLength) } };
+					}
+
+					return HttpWriteBuffers{ { headers, boost::asio::const_buffer(m_payload.data(), m_payload.size()) } };
 				}
 
-				const std::vector<char>& BaseHttpTransaction::GetPayload() const
+				const util::mem::SpillBuffer& BaseHttpTransaction::GetPayload() const
 				{
 					return m_payload;
 				}
 
 				void BaseHttpTransaction::SetPayload(std::vector<char>&& payload, const bool includesHeaders)
 				{
+					DiscardEncodedPayload();
+
 					m_payload = std::move(payload);
+					m_payloadChunks.clear();
+					m_inflater.reset();
+					m_rawMessage.reset();
+					m_rawMessageLength = 0;
 					m_payloadComplete = true;
 
 					if (includesHeaders)
 					{
-						m_headers.clear();
+						m_headers.Clear();
+						m_mediaKindsKnown = false;
 						m_headersSent = true;
 						m_headersComplete = true;
 					}
@@ -240,12 +428,19 @@ namespace te
 
 				void BaseHttpTransaction::SetPayload(const std::vector<char>& payload, const bool includesHeaders)
 				{
-					m_payload = payload;
+					DiscardEncodedPayload();
+
+					m_payload.assign(payload.data(), payload.data() + payload.size());
+					m_payloadChunks.clear();
+					m_inflater.reset();
+					m_rawMessage.reset();
+					m_rawMessageLength = 0;
 					m_payloadComplete = true;
 
 					if (includesHeaders)
 					{
-						m_headers.clear();
+						m_headers.Clear();
+						m_mediaKindsKnown = false;
 						m_headersSent = true;
 						m_headersComplete = true;
 					}
@@ -262,6 +457,23 @@ namespace te
 					}
 				}
 
+				void BaseHttpTransaction::SetRawMessage(std::shared_ptr<const char> message, const size_t messageLength)
+				{
+					DiscardEncodedPayload();
+
+					m_payload.clear();
+					m_payloadChunks.clear();
+					m_inflater.reset();
+					m_rawMessage = std::move(message);
+					m_rawMessageLength = m_rawMessage != nullptr ? messageLength : 0;
+					m_payloadComplete = true;
+
+					m_headers.Clear();
+					m_mediaKindsKnown = false;
+					m_headersSent = true;
+					m_headersComplete = true;
+				}
+
 				const bool BaseHttpTransaction::IsPayloadComplete() const
 				{
 					return m_payloadComplete;
@@ -314,11 +526,21 @@ namespace te
 
 					std::string fs = os.str();
 
-					m_payload.clear();
+					DiscardEncodedPayload();
+
+					m_payload.assign(fs.data(), fs.data() + fs.size());
+
+					m_payloadChunks.clear();
+
+					m_inflater.reset();
+
+					m_rawMessage.reset();
 
-					m_payload.assign(fs.begin(), fs.end());
+					m_rawMessageLength = 0;
 
-					m_headers.clear();
+					m_headers.Clear();
+
+					m_mediaKindsKnown = false;
 
 					m_headersSent = true;
 					m_headersComplete = true;
@@ -333,6 +555,110 @@ namespace te
 				void BaseHttpTransaction::SetConsumeAllBeforeSending(const bool value)
 				{
 					m_consumeAllBeforeSending = value;
+
+					// There's only an end to be had from decompressing as we go if there's more
+					// payload still to come.
+					if (value && !m_payloadComplete)
+					{
+						StartDecoding();
+					}
+					else
+					{
+						StopDecodingIfUnwanted();
+					}
+				}
+
+				const bool BaseHttpTransaction::GetInspectPayloadChunks() const
+				{
+					return m_inspectPayloadChunks;
+				}
+
+				void BaseHttpTransaction::SetInspectPayloadChunks(const bool value)
+				{
+					m_inspectPayloadChunks = value;
+
+					if (value)
+					{
+						StartDecoding();
+					}
+					else
+					{
+						StopDecodingIfUnwanted();
+					}
+				}
+
+				const BaseHttpTransaction::PayloadChunkList& BaseHttpTransaction::GetPayloadChunks() const
+				{
+					return m_payloadChunks;
+				}
+
+				const bool BaseHttpTransaction::IsPayloadDecoding() const
+				{
+					return m_inflater != nullptr;
+				}
+
+				boost::string_ref BaseHttpTransaction::GetDecodedPayload() const
+				{
+					if (m_inflater)
+					{
+						return m_inflater->GetOutput();
+					}
+
+					return boost::string_ref();
+				}
+
+				void BaseHttpTransaction::StartDecoding()
+				{
+					if (m_inflater || m_decodeFailed || !m_headersComplete)
+					{
+						return;
+					}
+
+					const auto contentEncoding = GetHeader(util::http::headers::ContentEncoding);
+
+					if (contentEncoding.first == contentEncoding.second)
+					{
+						return;
+					}
+
+					if (util::hash::ICaseEquals(contentEncoding.first->second, u8"gzip"))
+					{
+						m_inflater.reset(new PayloadInflater(PayloadInflater::Format::Gzip));
+					}
+					else if (util::hash::ICaseEquals(contentEncoding.first->second, u8"deflate"))
+					{
+						m_inflater.reset(new PayloadInflater(PayloadInflater::Format::Deflate));
+					}
+					else
+					{
+						// Nothing we can decode, the payload will be handed on as it is.
+						return;
+					}
+
+					// Catch up on what was parsed before anyone asked for this.
+					for (const auto& chunk : m_payloadChunks)
+					{
+						if (!m_inflater->Write(m_payload.data() + chunk.first, chunk.second))
+						{
+							ReportWarning(u8"In BaseHttpTransaction::StartDecoding() - Failed to decompress payload, it will be handed on as received.");
+							m_inflater.reset();
+							m_decodeFailed = true;
+							return;
+						}
+					}
+
+					if (m_payloadComplete && !m_inflater->Finish())
+					{
+						ReportWarning(u8"In BaseHttpTransaction::StartDecoding() - Compressed payload ended prematurely.");
+					}
+				}
+
+				void BaseHttpTransaction::StopDecodingIfUnwanted()
+				{
+					if (!m_consumeAllBeforeSending && !m_inspectPayloadChunks)
+					{
+						m_inflater.reset();
+					}
 				}
 
 				const bool BaseHttpTransaction::IsPayloadChunked() const
@@ -341,7 +667,7 @@ namespace te
 
 					if (contentEncoding.first != contentEncoding.second)
 					{
-						if (boost::iequals(contentEncoding.first->second, u8"chunked"))
+						if (util::hash::ICaseEquals(contentEncoding.first->second, u8"chunked"))
 						{
 							return true;
 						}
@@ -364,46 +690,57 @@ namespace te
 
 				const bool BaseHttpTransaction::IsPayloadJson() const
 				{
-					return DoesContentTypeContain(ContentTypeJson);
+					return GetMediaKinds().test(static_cast<size_t>(util::http::MediaKind::Json));
 				}
 
 				const bool BaseHttpTransaction::IsPayloadHtml() const
 				{
-					return DoesContentTypeContain(ContentTypeHtml);
+					return GetMediaKinds().test(static_cast<size_t>(util::http::MediaKind::Html));
 				}
 
 				const bool BaseHttpTransaction::IsPayloadText() const
 				{
 					// We treat JSON, HTML, text/ as text as well.
-					if (DoesContentTypeContain(ContentTypeText))
-					{
-						return true;
-					}
-					else if (DoesContentTypeContain(ContentTypeHtml))
-					{
-						return true;
-					}
-					else if(DoesContentTypeContain(ContentTypeJson))
-					{
-						return true;
-					}
+					const auto& kinds = GetMediaKinds();
 
-					return false;
+					return kinds.test(static_cast<size_t>(util::http::MediaKind::Text)) ||
+						kinds.test(static_cast<size_t>(util::http::MediaKind::Html)) ||
+						kinds.test(static_cast<size_t>(util::http::MediaKind::Json));
 				}
 
 				const bool BaseHttpTransaction::IsPayloadImage() const
 				{
-					return DoesContentTypeContain(ContentTypeImage);
+					return GetMediaKinds().test(static_cast<size_t>(util::http::MediaKind::Image));
 				}
 
 				const bool BaseHttpTransaction::IsPayloadCss() const
 				{
-					return DoesContentTypeContain(ContentTypeCss);
+					return GetMediaKinds().test(static_cast<size_t>(util::http::MediaKind::Css));
 				}
 
 				const bool BaseHttpTransaction::IsPayloadJavascript() const
 				{
-					return DoesContentTypeContain(ContentTypeJavascript);
+					return GetMediaKinds().test(static_cast<size_t>(util::http::MediaKind::Javascript));
+				}
+
+				const util::http::MediaKindSet& BaseHttpTransaction::GetMediaKinds() const
+				{
+					if (!m_mediaKindsKnown)
+					{
+						m_mediaKinds.reset();
+
+						auto contentTypeHeader = GetHeader(util::http::headers::ContentType);
+
+						while (contentTypeHeader.first != contentTypeHeader.second)
+						{
+							m_mediaKinds |= util::http::ClassifyContentType(contentTypeHeader.first->second);
+							++contentTypeHeader.first;
+						}
+
+						m_mediaKindsKnown = true;
+					}
+
+					return m_mediaKinds;
 				}
 
 				const bool BaseHttpTransaction::DoesContentTypeMatch(const boost::string_ref type) const
@@ -414,7 +751,7 @@ namespace te
 					{
 						while (contentTypeHeader.first != contentTypeHeader.second)
 						{							
-							if (boost::iequals(contentTypeHeader.first->second, type))
+							if (util::hash::ICaseEquals(contentTypeHeader.first->second, type))
 							{
 								return true;
 							}
@@ -459,7 +796,7 @@ namespace te
 					{
 						boost::iostreams::filtering_ostream os;
 
-						os.push(boost::iostreams::gzip_compressor());
+						os.push(boost::iostreams::gzip_compressor(boost::iostreams::gzip_params(s_compressionLevel)));
 						os.push(boost::iostreams::back_inserter(compressed));
 
 						boost::iostreams::write(os, m_payload.data(), m_payload.size());
@@ -495,7 +832,7 @@ namespace te
 					{
 						boost::iostreams::filtering_ostream os;
 
-						os.push(boost::iostreams::zlib_compressor());
+						os.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(s_compressionLevel)));
 						os.push(boost::iostreams::back_inserter(compressed));
 
 						boost::iostreams::write(os, m_payload.data(), m_payload.size());
@@ -550,7 +887,7 @@ namespace te
 						}
 						else
 						{
-							ReportError("In BaseHttpTransaction::DecompressPayload() - Unknown Content-Encoding, cannot decompress: " + contentEncoding.first->second);
+							ReportError("In BaseHttpTransaction::DecompressPayload() - Unknown Content-Encoding, cannot decompress: " + contentEncoding.first->second.to_string());
 							return false;							
 						}
 					}
@@ -607,6 +944,8 @@ namespace te
 					std::vector<char> decompressed;
 					decompressed.reserve(m_payload.size());
 
+					util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::PayloadDecompression);
+
 					try
 					{
 						// For some reason, all the example code that boost gives, and all the examples
@@ -648,6 +987,8 @@ namespace te
 					std::vector<char> decompressed;
 					decompressed.reserve(m_payload.size());
 
+					util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::PayloadDecompression);
+
 					try
 					{
 						/*
@@ -815,13 +1156,15 @@ namespace te
 						
 						trans->m_payloadComplete = false;						
 						trans->m_consumeAllBeforeSending = false;
+						trans->m_inspectPayloadChunks = false;
+						trans->m_payloadChunks.clear();
+						trans->m_inflater.reset();
+						trans->m_decodeFailed = false;
 						trans->m_shouldBlock = 0;
-						trans->m_headers.clear();
+						trans->m_headers.Clear();
+						trans->m_mediaKindsKnown = false;
 						trans->m_headersSent = false;
 						trans->m_headersComplete = false;
-						trans->m_lastHeader = std::string("");
-						trans->m_lastHeaderValueFresh = false;
-						trans->m_lastHeaderFieldFresh = false;
 						
 					}
 					else
@@ -847,7 +1190,11 @@ namespace te
 						}
 
 						trans->m_headersComplete = true;
+						trans->m_headersCompleted = util::metrics::EngineMetrics::Clock::now();
 						trans->m_headersSent = false;
+						trans->m_startLineModified = false;
+						trans->m_mediaKindsKnown = false;
+						trans->m_headers.EndParse();
 
 					}
 					else
@@ -874,11 +1221,77 @@ namespace te
 
 						trans->m_payloadComplete = true;
 
-						// When the payload is complete, and we want to consume it all, we need to convert it
-						// from chunked encoding to a fixed length payload.
+						// Stop here, rather than carry on into whatever follows in the same read.
+						// Another message there would begin over the top of this one.
+						http_parser_pause(parser, 1);
+
 						if (trans->GetConsumeAllBeforeSending())
+						{
+							util::metrics::EngineMetrics::Shared().RecordSince(util::metrics::Stage::PayloadBuffering, trans->m_headersCompleted);
+						}
+
+						if (trans->m_inflater && !trans->m_inflater->Finish())
+						{
+							trans->ReportWarning(u8"In BaseHttpTransaction::OnMessageComplete() - Compressed payload ended prematurely.");
+
+							if (trans->GetConsumeAllBeforeSending())
+							{
+								// Let the conversion below have a go at it, and report on it.
+								trans->m_inflater.reset();
+								trans->m_decodeFailed = true;
+							}
+						}
+
+						// When the payload is complete, and we want to consume it all, we need it as a
+						// fixed length payload. If it was decompressed as it came in, that's already
+						// been done, less the copy. Otherwise, we need to convert it from chunked
+						// encoding, decompressing it on the way.
+						//
+						// Should nothing change once the payload has been inspected, the message is
+						// written as it was received, so keep that aside first. There's nothing to
+						// keep when there's nothing to decode.
+						const bool keepEncoded = trans->GetConsumeAllBeforeSending() && (trans->IsPayloadChunked() || trans->IsPayloadCompressed());
+
+						std::string encodedHeaders;
+						util::mem::SpillBuffer encodedPayload;
+
+						if (keepEncoded)
+						{
+							boost::string_ref original;
+
+							if (!trans->m_startLineModified && trans->m_headers.GetOriginalBytes(original))
+							{
+								encodedHeaders.assign(original.data(), original.size());
+							}
+							else
+							{
+								encodedHeaders = trans->HeadersToString();
+							}
+						}
+
+						bool decoded = false;
+
+						if (trans->GetConsumeAllBeforeSending() && trans->m_inflater)
+						{
+							// The decoded payload comes from the inflater, so the received one can
+							// simply be taken rather than copied.
+							if (keepEncoded)
+							{
+								encodedPayload.swap(trans->m_payload);
+							}
+
+							auto output = trans->m_inflater->GetOutput();
+							trans->SetPayload(std::vector<char>(output.begin(), output.end()));
+							decoded = true;
+						}
+						else if (trans->GetConsumeAllBeforeSending())
 						{	
-							trans->ConvertPayloadFromChunkedToFixedLength();
+							if (keepEncoded)
+							{
+								encodedPayload.assign(trans->m_payload.begin(), trans->m_payload.end());
+							}
+
+							decoded = trans->ConvertPayloadFromChunkedToFixedLength();
 							/*
 							if (trans->IsPayloadChunked())
 							{
@@ -890,6 +1303,13 @@ namespace te
 							}
 							*/
 						}
+
+						if (keepEncoded && decoded)
+						{
+							trans->m_encodedHeaders = std::move(encodedHeaders);
+							trans->m_encodedPayload.swap(encodedPayload);
+							trans->m_hasEncodedPayload = true;
+						}
 					}
 					else
 					{
@@ -920,7 +1340,7 @@ namespace te
 						chunkHeaderSs << std::hex << parser->content_length;
 						chunkHeaderSs << u8"\r\n";
 						std::string chunkHeader(chunkHeaderSs.str());
-						trans->m_payload.insert(trans->m_payload.end(), chunkHeader.begin(), chunkHeader.end());
+						trans->m_payload.append(chunkHeader.data(), chunkHeader.size());
 					}
 					else
 					{
@@ -971,17 +1391,9 @@ namespace te
 							throw std::runtime_error(u8"In BaseHttpTransaction::OnHeaderField() - http_parser->data is nullptr when it should contain a pointer the http_parser's owning BaseHttpTransaction object.");
 						}
 						
-						if (trans->m_lastHeaderFieldFresh)
-						{
-							trans->m_lastHeader = std::string(at, length);
-							trans->m_lastHeaderFieldFresh = false;
-						}
-						else
-						{
-							trans->m_lastHeader.append(std::string(at, length));
-						}
-						
-						trans->m_lastHeaderValueFresh = true;
+						// The table knows whether this continues the last name, since we're not
+						// guaranteed to be given all of our header data in one shot.
+						trans->m_headers.OnField(at, length);
 
 						if (length == 0)
 						{
@@ -1011,35 +1423,12 @@ namespace te
 							throw std::runtime_error(u8"In BaseHttpTransaction::OnHeaderValue() - http_parser->data is nullptr when it should contain a pointer the http_parser's owning BaseHttpTransaction object.");
 						}
 
-						trans->m_lastHeaderFieldFresh = true;
-
-						if (trans->m_lastHeader.length() > 0)
-						{	
-							if (trans->m_lastHeaderValueFresh)
-							{
-								std::string headerValue(at, length);
-								trans->AddHeader(trans->m_lastHeader, headerValue, false);			
-								trans->m_lastHeaderValueFresh = false;
-							}
-							else
-							{
-								// Since we're not guaranteed to be given all of our header data
-								// in one shot, we must assume that this data is meant to be appended
-								// to the last entered header.
-								auto range = trans->m_headers.equal_range(trans->m_lastHeader); 
-								
-								if (range.first != range.second)
-								{	
-									auto appender = std::prev(range.second);
-									
-									// Ordering is supposed to be guaranteed. This must be it.
-									appender->second.append(std::string(at, length));
-								}
-							}
-						}
-						else
+						// Since we're not guaranteed to be given all of our header data in one
+						// shot, the table appends this to the last value if that's what it was
+						// handed last.
+						if (!trans->m_headers.OnValue(at, length))
 						{
-							trans->ReportError(std::string(u8"In BaseHttpTransaction::OnHeaderValue() - OnHeaderValue called while BaseHttpTransaction::m_lastHeader was empty."));
+							trans->ReportError(std::string(u8"In BaseHttpTransaction::OnHeaderValue() - OnHeaderValue called before any header name was read."));
 							return -1;							
 						}
 					}
@@ -1067,8 +1456,20 @@ namespace te
 							throw std::runtime_error(u8"In BaseHttpTransaction::OnBody() - http_parser->data is nullptr when it should contain a pointer the http_parser's owning BaseHttpTransaction object.");
 						}
 
-						trans->m_payload.reserve(trans->m_payload.capacity() + length);
-						std::copy(at, at + length, std::back_inserter(trans->m_payload));
+						if (!trans->m_consumeAllBeforeSending)
+						{
+							trans->m_payloadChunks.emplace_back(trans->m_payload.size(), length);
+						}
+
+						if (trans->m_inflater && !trans->m_inflater->Write(at, length))
+						{
+							trans->ReportWarning(u8"In BaseHttpTransaction::OnBody() - Failed to decompress payload, it will be handed on as received.");
+							trans->m_inflater.reset();
+							trans->m_decodeFailed = true;
+						}
+
+						// Grows geometrically, rather than by exactly what each callback hands us.
+						trans->m_payload.append(at, length);
 					}
 					else
 					{
@@ -7,14 +7,28 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <memory>
 #include <string>
-#include <map>
+#include <utility>
+#include <vector>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
 #include <boost/asio/streambuf.hpp>
 #include <boost/utility/string_ref.hpp>
 #include "http_parser.h"
 #include "../../util/cb/EventReporter.hpp"
+#include "../../util/hash/StringHashUtils.hpp"
+#include "../../util/http/MediaTypes.hpp"
+#include "../../util/mem/Arena.hpp"
+#include "../../util/mem/BufferPool.hpp"
+#include "../../util/mem/SpillBuffer.hpp"
+#include "../../util/metrics/EngineMetrics.hpp"
+#include "../../../util/http/KnownHttpHeaders.hpp"
+#include "HttpHeaderTable.hpp"
+#include "PayloadInflater.hpp"
 
 #ifdef _MSC_VER 
 	#define strncasecmp _strnicmp
@@ -42,36 +56,25 @@ namespace te
 				};
 
 				/// <summary>
-				/// Binary predicate for case insensitive lookups in std::multimap.
+				/// Shorthand header table constant iterator type. Dereferences to a name and value
+				/// pair of boost::string_ref.
 				/// </summary>
-				struct CaseInsensitiveComparer : public std::binary_function<std::string,
-					std::string, bool>
-				{
-					bool operator()(const std::string &strOne, const std::string &strTwo) const
-					{
-						return strcasecmp(strOne.c_str(), strTwo.c_str()) < 0;
-					}
-				};
-
-				/// <summary>
-				/// Basic string/string multimap for storing the headers with case insensitive key
-				/// comparison.
-				/// </summary>
-				typedef std::multimap<std::string, std::string, CaseInsensitiveComparer> HttpHeaderMap;
-
-				/// <summary>
-				/// Shorthand map constant iterator type.
-				/// </summary>
-				typedef HttpHeaderMap::const_iterator HttpHeaderConstIterator;
+				typedef HttpHeaderTable::ConstIterator HttpHeaderConstIterator;
 
 				/// <summary>
 				/// We need to be able to support multiple header entries by the same name, since
-				/// this is legal according to the spec. So, all methods that query against the map,
+				/// this is legal according to the spec. So, all methods that query against the table,
 				/// looking for a specific entry, will return a range based match, rather than a
 				/// single string value.
 				/// </summary>					
 				typedef std::pair<HttpHeaderConstIterator, HttpHeaderConstIterator> HttpHeaderRangeMatch;
 
+				/// <summary>
+				/// The buffers to write a transaction outbound with, the headers followed by the
+				/// payload. Either may be empty.
+				/// </summary>
+				typedef std::array<boost::asio::const_buffer, 2> HttpWriteBuffers;
+
 				/// <summary>
 				/// Abstract base class for HTTP Requests and Responses. This class is meant to
 				/// parse, contain and manage the headers for the transaction as well as the
@@ -90,10 +93,43 @@ namespace te
 				{
 				public:
 
-					BaseHttpTransaction();
+					/// <summary>
+					/// The offset and length within the payload of each piece of body parsed by
+					/// the last read. See ::GetPayloadChunks().
+					/// </summary>
+					using PayloadChunkList = util::mem::ArenaVector<std::pair<size_t, size_t>>;
+
+					/// <summary>
+					/// Constructs a new transaction.
+					/// </summary>
+					/// <param name="arena">
+					/// The arena that the parse state of the transaction is allocated from, such
+					/// as the parser, the header table and the payload chunk list. It must belong
+					/// to this transaction alone, since ::Reset() resets it, and with it, whatever
+					/// else was allocated from it. May be null, in which case the general heap is
+					/// used.
+					/// </param>
+					BaseHttpTransaction(std::shared_ptr<util::mem::Arena> arena = nullptr);
 					
 					virtual ~BaseHttpTransaction();
 
+					/// <summary>
+					/// Sets the zlib compression level used by ::CompressGzip() and
+					/// ::CompressDeflate(), for every transaction. Values outside of the range
+					/// zlib accepts are clamped to it.
+					/// </summary>
+					/// <param name="level">
+					/// The compression level, from 0 for none to 9 for the best, or -1 for the zlib
+					/// default.
+					/// </param>
+					static void SetCompressionLevel(const int32_t level);
+
+					/// <summary>
+					/// Gets the zlib compression level used by ::CompressGzip() and
+					/// ::CompressDeflate().
+					/// </summary>
+					static const int32_t GetCompressionLevel();
+
 					/// <summary>
 					/// Fetches the value of the defined HTTP Protocol Version for the transaction.
 					/// </summary>
@@ -134,6 +170,12 @@ namespace te
 					/// </param>
 					void AddHeader(const std::string& name, std::string value, const bool replaceIfExists = true);
 
+					/// <summary>
+					/// Same as ::AddHeader(const std::string&, std::string, const bool), for well
+					/// known headers, which don't need their name hashed.
+					/// </summary>
+					void AddHeader(const util::http::headers::KnownHeader& name, std::string value, const bool replaceIfExists = true);
+
 					/// <summary>
 					/// Will remove a header that matches exactly the provided name and value, case
 					/// insensitive. Note that removing headers after the transaction has begun
@@ -169,12 +211,20 @@ namespace te
 					/// </param>
 					void RemoveHeader(const std::string& name);
 
+					/// <summary>
+					/// Same as ::RemoveHeader(const std::string&), for well known headers, which
+					/// don't need their name hashed.
+					/// </summary>
+					void RemoveHeader(const util::http::headers::KnownHeader& name);
+
 					/// <summary>
 					/// Check for the existence of a header by the specified header name. Lookups
 					/// are case insensitive.
 					/// 
-					/// Since the storage mechanism for the headers is a multimap, a range is
-					/// returned, which may contain zero or more entries.
+					/// Since the same header may appear more than once, a range is returned, which
+					/// may contain zero or more entries, in the order they appear in the
+					/// transaction. The names and values in the range refer to storage within the
+					/// transaction, and are only valid until its headers are next changed.
 					/// </summary>
 					/// <param name="header">
 					/// The name of the HTTP header to lookup. Example: "Content-Type" 
@@ -182,7 +232,13 @@ namespace te
 					/// <returns>
 					/// A constant range based iterator which may contain zero or more entries. 
 					/// </returns>
-					const HttpHeaderRangeMatch GetHeader(const std::string& header) const;
+					const HttpHeaderRangeMatch GetHeader(boost::string_ref header) const;
+
+					/// <summary>
+					/// Same as ::GetHeader(boost::string_ref), for well known headers, which don't
+					/// need their name hashed.
+					/// </summary>
+					const HttpHeaderRangeMatch GetHeader(const util::http::headers::KnownHeader& header) const;
 
 					/// <summary>
 					/// Check to see if all headers for the transaction have successfully been
@@ -193,6 +249,15 @@ namespace te
 					/// </returns>
 					const bool HeadersComplete() const;
 
+					/// <summary>
+					/// Check to see if the headers for the transaction have already been written
+					/// outbound, as part of a buffer returned by ::GetWriteBuffer().
+					/// </summary>
+					/// <returns>
+					/// True if the headers have been sent, false if not.
+					/// </returns>
+					const bool HeadersSent() const;
+
 					/// <summary>
 					/// Convenience function for formatting the transaction headers into a
 					/// std::string container.
@@ -218,11 +283,11 @@ namespace te
 					/// called immediately following any completed read operations using this
 					/// object.
 					/// 
-					/// This object owns two different objects which are used as buffers for reading
-					/// the content of HTTP transactions. The first is a boost::asio::streambuf,
-					/// which is used for reading the header content of a transaction in
-					/// asio::async_read_until(...) operations. The second is a vector of char
-					/// elements which holds the raw payload of the transaction, if any.
+					/// Every read, headers included, is done into the buffer supplied by
+					/// ::GetReadBuffer() and handed to the http_parser as is. While the headers are
+					/// incomplete, the bytes up to the blank line ending them are also kept by the
+					/// header table, which the parsed names and values refer to. Payload bytes are
+					/// held in a separate vector of char elements.
 					/// 
 					/// Conversion from chunked to fixed-length content and decompression will be
 					/// done entirely manually by this objects own conversion implementation, thus
@@ -233,19 +298,51 @@ namespace te
 					/// <param name="bytes_transferred">
 					/// The number of bytes_transferred indicated in the asio::async_read* handler
 					/// that this function should always be called from within. This absolutely must
-					/// be accurate and unomodified, as for example the asio::async_read_until(...)
-					/// operations will very often read beyond the specified completion condition.
-					/// 
-					/// This means in the case of this software, that it is highly likely that the
-					/// internal boost::asio::streambuf used for header reads will contain body data
-					/// as well. The value of this parameter is the key to successfully determining
-					/// this and acting accordingly.
+					/// be accurate and unomodified. A read of the headers will very often contain
+					/// the start of the payload as well, and the parser relies on this value to
+					/// see all of it.
 					/// </param>
 					/// <returns>
 					/// True of the parsing operation was a success, false otherwise.
 					/// </returns>
 					const bool Parse(const size_t bytes_transferred);
 
+					/// <summary>
+					/// Gets how many of the bytes supplied to the last ::Parse(...) followed the
+					/// end of the message, such as a pipelined request sent right behind the one
+					/// just parsed. Parsing stops at the end of every message, so that these bytes
+					/// are left for the next. After ::Reset(), they're at the start of the read
+					/// buffer, ready to be parsed with ::Parse(::GetPipelinedLength()). Zero once
+					/// ::GetReadBuffer() has been called, since the next read overwrites them.
+					/// </summary>
+					/// <returns>
+					/// The number of bytes read past the end of the message.
+					/// </returns>
+					const size_t GetPipelinedLength() const;
+
+					/// <summary>
+					/// Puts the transaction back in the state it was constructed in, so that it
+					/// can carry the next message on the same connection. With an arena, the
+					/// parse state is released and the arena reset, so one long lived connection
+					/// doesn't pile up every allocation of every message it carried. The arena
+					/// keeps its first block, which usually serves the next message on its own.
+					/// Without one, containers are cleared rather than freed. Either way, the read
+					/// buffer is kept. Bytes read past the end of the last message are kept too,
+					/// see ::GetPipelinedLength().
+					/// </summary>
+					virtual void Reset();
+
+					/// <summary>
+					/// Makes the supplied buffer the read buffer, as though the bytes in it had
+					/// just been read into it. Used when bytes were read before the transaction
+					/// was ready for them, such as when peeking at what a client sends first.
+					/// ::Parse(...) must be called next, with the number of bytes read.
+					/// </summary>
+					/// <param name="buffer">
+					/// The buffer holding the bytes read.
+					/// </param>
+					void AdoptReadBuffer(util::mem::SharedBuffer buffer);
+
 					/// <summary>
 					/// Gets the internal transaction buffer wrapped in a
 					/// boost::asio::mutable_buffers_1 object for use in asio::async_read(...)
@@ -270,21 +367,25 @@ namespace te
 					boost::asio::mutable_buffers_1 GetReadBuffer();
 
 					/// <summary>
-					/// Retrieve a boost::asio::const_buffers_1 object which wraps the internal
-					/// transaction payload. Call this method when you intend to write the entire
-					/// contents of the transaction outbound from the proxy.
+					/// Retrieve the buffers which wrap the transaction headers, if they have not
+					/// yet been sent, and the internal transaction payload. Call this method when
+					/// you intend to write the entire contents of the transaction outbound from the
+					/// proxy.
 					/// 
-					/// Note that this method lacks a right-hand const declaration. The internal
-					/// state of the object will be irreversibly altered once this method is called,
-					/// as if the headers have not yet been set, the headers must be merged into the
-					/// final, separated payload storage before being supplied as a single buffer
-					/// for writing.
+					/// If neither the headers nor the start line have been changed since they were
+					/// parsed, the header buffer refers to the bytes exactly as they were received.
+					/// Otherwise the headers are formatted once, into storage held by this object.
+					/// Either way, nothing is copied into the payload, so the buffers are only
+					/// valid until this object is next read into or modified.
+					///
+					/// Note that this method lacks a right-hand const declaration. Once this method
+					/// is called, the headers are considered sent, and subsequent calls supply an
+					/// empty header buffer.
 					/// </summary>
 					/// <returns>
-					/// A boost::asio::const_buffers_1 object wrapping the internal transaction
-					/// payload data.
+					/// The header and payload buffers, to be written in order.
 					/// </returns>
-					boost::asio::const_buffers_1 GetWriteBuffer();
+					HttpWriteBuffers GetWriteBuffer();
 
 					/// <summary>
 					/// Fetch the raw payload data. In the event that ::ConsumeAllBeforeSending() is
@@ -297,12 +398,14 @@ namespace te
 					/// chunked content is automatically converted to a fixed-length response
 					/// (content-length header present).
 					/// 
-					/// This data is exposed purely for analysis.
+					/// This data is exposed purely for analysis. A large payload may be held in a
+					/// memory mapped temp file rather than in memory, but is addressed the same
+					/// way either way.
 					/// </summary>
 					/// <returns>
 					/// The transaction payload, aka the body. May or may not be compressed. 
 					/// </returns>
-					const std::vector<char>& GetPayload() const;
+					const util::mem::SpillBuffer& GetPayload() const;
 
 					/// <summary>
 					/// Moves the supplied payload to the internal transaction payload buffer. Sets
@@ -346,6 +449,24 @@ namespace te
 					/// </param>
 					void SetPayload(const std::vector<char>& payload, const bool includesHeaders = false);
 
+					/// <summary>
+					/// Replaces the entire transaction, headers included, with the supplied
+					/// message, without copying it. The state of the transaction is modified just
+					/// as ::SetPayload(std::vector<char>&&, true) would, except that the message is
+					/// written from where it is. ::GetPayload() is empty afterwards.
+					///
+					/// This is how a custom block response is put in place, since it may be a
+					/// buffer handed over by the user of the library.
+					/// </summary>
+					/// <param name="message">
+					/// The complete message to be written in place of this transaction. The
+					/// pointer is held until this object is destroyed or given another payload.
+					/// </param>
+					/// <param name="messageLength">
+					/// The length of the message.
+					/// </param>
+					void SetRawMessage(std::shared_ptr<const char> message, const size_t messageLength);
+
 					/// <summary>
 					/// Check to see if the transaction payload has been fully received. This will
 					/// return true only when the http_parser has flagged that either all chunked
@@ -463,6 +584,61 @@ namespace te
 					/// </param>
 					void SetConsumeAllBeforeSending(const bool value);
 
+					/// <summary>
+					/// Check to see if the transaction has been configured so that the payload
+					/// (body) is handed to the user one piece at a time, as it is read, rather than
+					/// all at once after it has been consumed.
+					/// </summary>
+					/// <returns>
+					/// True if the option is set, false if not.
+					/// </returns>
+					const bool GetInspectPayloadChunks() const;
+
+					/// <summary>
+					/// Set whether or not the payload (body) of the transaction should be handed to
+					/// the user one piece at a time, as it is read. Unlike
+					/// ::SetConsumeAllBeforeSending(...), this does not hold back the payload, so
+					/// each piece is forwarded as soon as it has been inspected, and the transaction
+					/// is left exactly as the peer sent it. A compressed payload is decompressed
+					/// alongside, see ::GetDecodedPayload().
+					/// </summary>
+					/// <param name="value">
+					/// </param>
+					void SetInspectPayloadChunks(const bool value);
+
+					/// <summary>
+					/// Gets the pieces of the payload (body) parsed since the last call to
+					/// ::GetReadBuffer(), as offset and length pairs into ::GetPayload(). Chunked
+					/// transfer framing is not included in any piece. Only populated when
+					/// ::GetConsumeAllBeforeSending() is false.
+					/// </summary>
+					/// <returns>
+					/// The offset and length of each piece of payload parsed by the last read.
+					/// </returns>
+					const PayloadChunkList& GetPayloadChunks() const;
+
+					/// <summary>
+					/// Check to see if the payload is being decompressed as it is parsed. This is
+					/// the case when the payload is gzip or deflate encoded and either
+					/// ::GetConsumeAllBeforeSending() or ::GetInspectPayloadChunks() is true, unless
+					/// decompression has failed.
+					/// </summary>
+					/// <returns>
+					/// True if the payload is being decompressed, false if not.
+					/// </returns>
+					const bool IsPayloadDecoding() const;
+
+					/// <summary>
+					/// Gets the decompressed payload produced since the last call to
+					/// ::GetReadBuffer(), or, when ::GetConsumeAllBeforeSending() is true, so far.
+					/// Empty if ::IsPayloadDecoding() is false.
+					/// </summary>
+					/// <returns>
+					/// The decompressed payload. Only valid until the next call to ::Parse(...) or
+					/// ::GetReadBuffer().
+					/// </returns>
+					boost::string_ref GetDecodedPayload() const;
+
 					/// <summary>
 					/// Determine if the payload is chunked or not. Looks for the transfer-encoding header.
 					/// </summary>
@@ -607,6 +783,12 @@ namespace te
 					/// </returns>
 					const bool DecompressPayload();
 
+					/// <summary>
+					/// Gets the kinds of media the Content-Type headers name, classifying them the
+					/// first time this is called after the headers change.
+					/// </summary>
+					const util::http::MediaKindSet& GetMediaKinds() const;
+
 				protected:
 					
 					/// <summary>
@@ -646,21 +828,51 @@ namespace te
 					static const boost::string_ref ContentTypeJavascript;
 
 					/// <summary>
-					/// Increments by which the payload buffer will be resized, also the initial
-					/// reserved size.
+					/// The largest size the read buffer will grow to.
 					/// </summary>
 					static constexpr uint32_t PayloadBufferReadSize = 131072;
 
 					/// <summary>
-					/// Maximum size that the payload buffer can be resized to.
+					/// The size of the first read buffer. Every read that fills the buffer doubles
+					/// the size of the next one, up to PayloadBufferReadSize.
+					/// </summary>
+					static constexpr uint32_t InitialBufferReadSize = 16384;
+
+					/// <summary>
+					/// See ::SetCompressionLevel(const int32_t).
+					/// </summary>
+					static std::atomic<int32_t> s_compressionLevel;
+
+					/// <summary>
+					/// Drops the payload kept as it was received, once anything about the message
+					/// changes, so that the changed message is written instead. Derived classes
+					/// must call this whenever they change the start line.
+					/// </summary>
+					void DiscardEncodedPayload();
+
+					/// <summary>
+					/// The arena that the parse state of the transaction is allocated from. Held
+					/// here so that it outlives everything allocated from it, and reset by
+					/// ::Reset(). May be null.
 					/// </summary>
-					static constexpr uint32_t MaxPayloadResize = 10485760;
+					std::shared_ptr<util::mem::Arena> m_arena;
 
 					/// <summary>
 					/// The http_parser object that gets stuck with doing all of the hard work.
+					/// Allocated with ::AllocateParser().
 					/// </summary>
 					http_parser* m_httpParser = nullptr;
 
+					/// <summary>
+					/// Allocates an uninitialized http_parser from the arena, or from the general
+					/// heap when there is no arena. Freed along with the transaction, or for the
+					/// arena, when it is reset.
+					/// </summary>
+					/// <returns>
+					/// The parser, or null if it couldn't be allocated.
+					/// </returns>
+					http_parser* AllocateParser();
+
 					/// <summary>
 					/// Configuration settings for the http_parser* member m_httpParser.
 					/// </summary>
@@ -672,28 +884,59 @@ namespace te
 					HttpProtocolVersion m_httpVersion;
 
 					/// <summary>
-					/// Case insensitive multimap for storing the http header fields and values
-					/// read during the transaction.
+					/// Case insensitive table of the http header fields and values read during the
+					/// transaction.
+					/// </summary>
+					HttpHeaderTable m_headers;
+
+					/// <summary>
+					/// Inserts the header, with the hash of its name already known. See
+					/// ::AddHeader(const std::string&, std::string, const bool).
 					/// </summary>
-					HttpHeaderMap m_headers;
+					void AddHeaderWithHash(const boost::string_ref name, const uint32_t hash, const boost::string_ref value, const bool replaceIfExists);
 
 					/// <summary>
-					/// Due to the nature of the protocol and specifically how the http_parser
-					/// processes data, a reference to the last header read by the parser has
-					/// to be kept during the header parsing process. When the OnHeaderValue(...)
-					/// method is called, this should be set to the last header name read, at
-					/// which time the complete header can be inserted and this variable reset
-					/// to be empty.
+					/// Cached result of ::GetMediaKinds(). Only valid while m_mediaKindsKnown is
+					/// true, which is reset whenever the headers change.
 					/// </summary>
-					std::string m_lastHeader;
+					mutable util::http::MediaKindSet m_mediaKinds;
 
-					bool m_lastHeaderValueFresh = false;
+					mutable bool m_mediaKindsKnown = false;
 
-					bool m_lastHeaderFieldFresh = false;
+					/// <summary>
+					/// The buffer reads are done into. Taken from the shared pool on demand, and
+					/// given back when the transaction is destroyed.
+					/// </summary>
+					util::mem::SharedBuffer m_buffer;
 
-					std::vector<char> m_buffer;
+					/// <summary>
+					/// The size of buffer the next read should be given.
+					/// </summary>
+					size_t m_readBufferSize = InitialBufferReadSize;
+
+					/// <summary>
+					/// Where the bytes read past the end of the last message start in m_buffer, and
+					/// how many there are. See ::GetPipelinedLength().
+					/// </summary>
+					size_t m_pipelinedOffset = 0;
+
+					size_t m_pipelinedLength = 0;
+
+					/// <summary>
+					/// The payload. Moves to disk once it grows large, see util::mem::SpillBuffer.
+					/// </summary>
+					util::mem::SpillBuffer m_payload;
+
+					/// <summary>
+					/// The message supplied to ::SetRawMessage(...), if any, which is written out
+					/// in place of both m_payload and the headers.
+					/// </summary>
+					std::shared_ptr<const char> m_rawMessage;
 
-					std::vector<char> m_payload;
+					/// <summary>
+					/// The length of m_rawMessage.
+					/// </summary>
+					size_t m_rawMessageLength = 0;
 
 					/// <summary>
 					/// Flag used to indicate if the headers for the transaction have been fully
@@ -706,10 +949,42 @@ namespace te
 					/// for the transaction. This is required because the headers and the actualy
 					/// payload are stored in two different containers and, when m_headersSent is
 					/// false and the payload is requested for writing, the headers must be
-					/// prepended to the payload, of course.
+					/// written ahead of the payload, of course.
 					/// </summary>
 					bool m_headersSent = false;
 
+					/// <summary>
+					/// Set by derived classes when the start line is changed after it was parsed,
+					/// so that the headers are formatted again rather than forwarded exactly as
+					/// they were received.
+					/// </summary>
+					bool m_startLineModified = false;
+
+					/// <summary>
+					/// The formatted headers last supplied by ::GetWriteBuffer(), kept here for the
+					/// duration of the write.
+					/// </summary>
+					std::string m_formattedHeaders;
+
+					/// <summary>
+					/// When a payload consumed before sending had to be decoded for inspection,
+					/// the headers as they were before decoding. See m_encodedPayload.
+					/// </summary>
+					std::string m_encodedHeaders;
+
+					/// <summary>
+					/// When a payload consumed before sending had to be decoded for inspection,
+					/// the payload as it was before decoding. So long as nothing about the message
+					/// changes, it's written in place of the decoded payload, sparing the peer the
+					/// decoded size and us the cost of compressing it again.
+					/// </summary>
+					util::mem::SpillBuffer m_encodedPayload;
+
+					/// <summary>
+					/// Whether m_encodedHeaders and m_encodedPayload are what gets written.
+					/// </summary>
+					bool m_hasEncodedPayload = false;
+
 					/// <summary>
 					/// Flag used to indicate if the payload for the transaction has been fully
 					/// read from the client/remote peer.
@@ -732,6 +1007,49 @@ namespace te
 					/// </summary>
 					bool m_consumeAllBeforeSending = false;
 
+					/// <summary>
+					/// Flag used to determine if the payload (body) should be handed to the user
+					/// piece by piece as it is read.
+					/// </summary>
+					bool m_inspectPayloadChunks = false;
+
+					/// <summary>
+					/// The offset and length within m_payload of each piece of body handed to us by
+					/// the parser since m_payload was last cleared.
+					/// </summary>
+					PayloadChunkList m_payloadChunks;
+
+					/// <summary>
+					/// Decompresses the payload as it is parsed, when that's wanted. See
+					/// ::IsPayloadDecoding().
+					/// </summary>
+					std::unique_ptr<PayloadInflater> m_inflater;
+
+					/// <summary>
+					/// Set when decompressing the payload as it is parsed failed, so that it isn't
+					/// attempted again for this transaction.
+					/// </summary>
+					bool m_decodeFailed = false;
+
+					/// <summary>
+					/// When the headers of the message were last completed, to time how long the
+					/// payload is held back for when it is consumed before sending.
+					/// </summary>
+					util::metrics::EngineMetrics::Clock::time_point m_headersCompleted;
+
+					/// <summary>
+					/// Begins decompressing the payload as it is parsed, if it is compressed in a
+					/// format we know and this isn't already happening. Whatever of the payload was
+					/// parsed before this is decompressed immediately.
+					/// </summary>
+					void StartDecoding();
+
+					/// <summary>
+					/// Stops decompressing the payload as it is parsed, if neither streaming
+					/// inspection nor consuming the entire payload calls for it anymore.
+					/// </summary>
+					void StopDecodingIfUnwanted();
+
 					/// <summary>
 					/// Decompress the payload contents, expecting gzip format.
 					/// </summary>
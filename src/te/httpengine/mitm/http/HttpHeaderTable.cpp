@@ -0,0 +1,413 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include "HttpHeaderTable.hpp"
+#include "../../../util/http/KnownHttpHeaders.hpp"
+#include "../../util/hash/StringHashUtils.hpp"
+#include "../../util/http/HeaderTerminator.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http
+			{
+
+				HttpHeaderTable::ConstIterator::ConstIterator()
+				{
+
+				}
+
+				HttpHeaderTable::ConstIterator::ConstIterator(const HttpHeaderTable* table, const size_t index, const bool matchName, const size_t firstMatch, const uint32_t hash)
+					:
+					m_table(table),
+					m_index(index),
+					m_matchName(matchName),
+					m_firstMatch(firstMatch),
+					m_hash(hash)
+				{
+					Settle();
+				}
+
+				HttpHeaderTable::ConstIterator::reference HttpHeaderTable::ConstIterator::operator*() const
+				{
+					const auto& entry = m_table->m_entries[m_index];
+					m_current = Header(m_table->NameOf(entry), m_table->ValueOf(entry));
+					return m_current;
+				}
+
+				HttpHeaderTable::ConstIterator::pointer HttpHeaderTable::ConstIterator::operator->() const
+				{
+					return &(operator*());
+				}
+
+				HttpHeaderTable::ConstIterator& HttpHeaderTable::ConstIterator::operator++()
+				{
+					++m_index;
+					Settle();
+					return *this;
+				}
+
+				HttpHeaderTable::ConstIterator HttpHeaderTable::ConstIterator::operator++(int)
+				{
+					ConstIterator previous = *this;
+					++(*this);
+					return previous;
+				}
+
+				bool HttpHeaderTable::ConstIterator::operator==(const ConstIterator& other) const
+				{
+					return m_table == other.m_table && m_index == other.m_index;
+				}
+
+				bool HttpHeaderTable::ConstIterator::operator!=(const ConstIterator& other) const
+				{
+					return !(*this == other);
+				}
+
+				void HttpHeaderTable::ConstIterator::Settle()
+				{
+					if (m_table == nullptr || !m_matchName)
+					{
+						return;
+					}
+
+					const auto& entries = m_table->m_entries;
+
+					if (m_firstMatch >= entries.size())
+					{
+						m_index = entries.size();
+						return;
+					}
+
+					const auto name = m_table->NameOf(entries[m_firstMatch]);
+
+					while (m_index < entries.size() && !m_table->Matches(entries[m_index], name, m_hash))
+					{
+						++m_index;
+					}
+				}
+
+				HttpHeaderTable::HttpHeaderTable(util::mem::Arena* arena)
+					:
+					m_received(util::mem::ArenaAllocator<char>(arena)),
+					m_entries(util::mem::ArenaAllocator<Entry>(arena))
+				{
+
+				}
+
+				HttpHeaderTable::~HttpHeaderTable()
+				{
+
+				}
+
+				void HttpHeaderTable::BeginParse(const char* data, const size_t length)
+				{
+					// If the headers end in these bytes, whatever follows is payload, so don't
+					// bother keeping it. A terminator split across two reads isn't found here,
+					// but ::EndParse() will trim the excess then.
+					const size_t headersEnd = util::http::FindHeadersEnd(data, length);
+					const size_t keep = headersEnd > 0 ? headersEnd : length;
+
+					m_parseData = data;
+					m_parseLength = keep;
+					m_parseOffset = m_received.size();
+
+					m_received.insert(m_received.end(), data, data + keep);
+				}
+
+				void HttpHeaderTable::EndParse()
+				{
+					if (m_parseData == nullptr)
+					{
+						return;
+					}
+
+					m_parseData = nullptr;
+					m_parseLength = 0;
+
+					// Whatever followed the headers in the last read is payload, which we don't
+					// need to hold on to. Look for the blank line after the last thing we kept.
+					size_t headersEnd = 0;
+
+					for (const auto& entry : m_entries)
+					{
+						if (!entry.owned)
+						{
+							headersEnd = (std::max)(headersEnd, static_cast<size_t>((std::max)(entry.name.offset + entry.name.length, entry.value.offset + entry.value.length)));
+						}
+					}
+
+					if (headersEnd > m_received.size())
+					{
+						return;
+					}
+
+					const size_t found = util::http::FindHeadersEnd(m_received.data() + headersEnd, m_received.size() - headersEnd);
+
+					if (found == 0)
+					{
+						return;
+					}
+
+					const size_t blockEnd = headersEnd + found;
+
+					m_received.resize(blockEnd);
+
+					// The start line is the line before the first header, or before the blank
+					// line if there are no headers. Whatever is before it belongs to something
+					// else, such as the tail of a previous message in the same read. The blank
+					// line is "\n\n" or "\n\r\n", so step back to its first line feed.
+					size_t lineStart = m_received[blockEnd - 2] == '\n' ? blockEnd - 2 : blockEnd - 3;
+
+					if (m_entries.size() > 0 && !m_entries.front().owned)
+					{
+						lineStart = m_entries.front().name.offset;
+
+						if (lineStart > 0 && m_received[lineStart - 1] == '\n')
+						{
+							--lineStart;
+						}
+					}
+
+					while (lineStart > 0 && m_received[lineStart - 1] != '\n')
+					{
+						--lineStart;
+					}
+
+					m_blockStart = lineStart;
+					m_blockEnd = m_received.size();
+				}
+
+				void HttpHeaderTable::OnField(const char* at, const size_t length)
+				{
+					if (m_lastWasValue || m_entries.size() == 0)
+					{
+						m_entries.emplace_back();
+					}
+
+					m_lastWasValue = false;
+
+					auto& entry = m_entries.back();
+
+					Extend(entry, true, at, length);
+
+					const auto name = NameOf(entry);
+					entry.hash = util::http::headers::HashName(name.data(), name.size());
+				}
+
+				const bool HttpHeaderTable::OnValue(const char* at, const size_t length)
+				{
+					if (m_entries.size() == 0)
+					{
+						return false;
+					}
+
+					m_lastWasValue = true;
+
+					Extend(m_entries.back(), false, at, length);
+
+					return true;
+				}
+
+				void HttpHeaderTable::Add(const boost::string_ref name, const uint32_t hash, const boost::string_ref value)
+				{
+					m_entries.emplace_back();
+
+					auto& entry = m_entries.back();
+
+					entry.hash = hash;
+					entry.owned = true;
+					entry.ownedName = name.to_string();
+					entry.ownedValue = value.to_string();
+
+					m_lastWasValue = true;
+					m_modified = true;
+				}
+
+				void HttpHeaderTable::Remove(const boost::string_ref name, const uint32_t hash)
+				{
+					auto removed = std::remove_if(m_entries.begin(), m_entries.end(), [this, name, hash](const Entry& entry)
+					{
+						return Matches(entry, name, hash);
+					});
+
+					if (removed != m_entries.end())
+					{
+						m_entries.erase(removed, m_entries.end());
+						m_modified = true;
+					}
+				}
+
+				void HttpHeaderTable::Remove(const boost::string_ref name, const uint32_t hash, const boost::string_ref value)
+				{
+					auto removed = std::remove_if(m_entries.begin(), m_entries.end(), [this, name, hash, value](const Entry& entry)
+					{
+						return Matches(entry, name, hash) && util::hash::ICaseEquals(ValueOf(entry), value);
+					});
+
+					if (removed != m_entries.end())
+					{
+						m_entries.erase(removed, m_entries.end());
+						m_modified = true;
+					}
+				}
+
+				void HttpHeaderTable::Clear()
+				{
+					m_entries.clear();
+					m_lastWasValue = true;
+					m_modified = false;
+					m_blockStart = 0;
+					m_blockEnd = 0;
+
+					if (m_parseData == nullptr)
+					{
+						m_received.clear();
+					}
+					else
+					{
+						// We're being cleared in the middle of a parse, because a new message
+						// began. It began somewhere in the bytes being parsed, so keep those.
+						m_received.erase(m_received.begin(), m_received.begin() + m_parseOffset);
+						m_parseOffset = 0;
+					}
+				}
+
+				void HttpHeaderTable::Reset()
+				{
+					m_parseData = nullptr;
+					m_parseLength = 0;
+					m_parseOffset = 0;
+
+					Clear();
+				}
+
+				void HttpHeaderTable::Release()
+				{
+					Reset();
+
+					util::mem::ArenaVector<char>(m_received.get_allocator()).swap(m_received);
+					util::mem::ArenaVector<Entry>(m_entries.get_allocator()).swap(m_entries);
+				}
+
+				const bool HttpHeaderTable::GetOriginalBytes(boost::string_ref& bytes) const
+				{
+					if (m_modified || m_blockEnd == 0)
+					{
+						return false;
+					}
+
+					for (const auto& entry : m_entries)
+					{
+						if (entry.owned)
+						{
+							return false;
+						}
+					}
+
+					bytes = boost::string_ref(m_received.data() + m_blockStart, m_blockEnd - m_blockStart);
+					return true;
+				}
+
+				std::pair<HttpHeaderTable::ConstIterator, HttpHeaderTable::ConstIterator> HttpHeaderTable::EqualRange(const boost::string_ref name, const uint32_t hash) const
+				{
+					size_t first = 0;
+
+					while (first < m_entries.size() && !Matches(m_entries[first], name, hash))
+					{
+						++first;
+					}
+
+					return std::make_pair(
+						ConstIterator(this, first, true, first, hash),
+						ConstIterator(this, m_entries.size(), true, first, hash)
+						);
+				}
+
+				HttpHeaderTable::ConstIterator HttpHeaderTable::begin() const
+				{
+					return ConstIterator(this, 0, false, 0, 0);
+				}
+
+				HttpHeaderTable::ConstIterator HttpHeaderTable::end() const
+				{
+					return ConstIterator(this, m_entries.size(), false, 0, 0);
+				}
+
+				boost::string_ref HttpHeaderTable::NameOf(const Entry& entry) const
+				{
+					if (entry.owned)
+					{
+						return boost::string_ref(entry.ownedName);
+					}
+
+					return boost::string_ref(m_received.data() + entry.name.offset, entry.name.length);
+				}
+
+				boost::string_ref HttpHeaderTable::ValueOf(const Entry& entry) const
+				{
+					if (entry.owned)
+					{
+						return boost::string_ref(entry.ownedValue);
+					}
+
+					return boost::string_ref(m_received.data() + entry.value.offset, entry.value.length);
+				}
+
+				const bool HttpHeaderTable::Matches(const Entry& entry, const boost::string_ref name, const uint32_t hash) const
+				{
+					return entry.hash == hash && util::hash::ICaseEquals(NameOf(entry), name);
+				}
+
+				const bool HttpHeaderTable::ReceivedOffset(const char* at, const size_t length, uint32_t& offset) const
+				{
+					if (m_parseData == nullptr || at < m_parseData || at + length > m_parseData + m_parseLength)
+					{
+						return false;
+					}
+
+					offset = static_cast<uint32_t>(m_parseOffset + (at - m_parseData));
+					return true;
+				}
+
+				void HttpHeaderTable::Extend(Entry& entry, const bool isName, const char* at, const size_t length)
+				{
+					if (!entry.owned)
+					{
+						Slice& slice = isName ? entry.name : entry.value;
+
+						uint32_t offset = 0;
+
+						if (ReceivedOffset(at, length, offset) && (slice.length == 0 || slice.offset + slice.length == offset))
+						{
+							if (slice.length == 0)
+							{
+								slice.offset = offset;
+							}
+
+							slice.length += static_cast<uint32_t>(length);
+							return;
+						}
+
+						// Can't be a slice of what we've kept, so it has to be a copy.
+						entry.ownedName = NameOf(entry).to_string();
+						entry.ownedValue = ValueOf(entry).to_string();
+						entry.owned = true;
+					}
+
+					(isName ? entry.ownedName : entry.ownedValue).append(at, length);
+				}
+
+			} /* namespace http */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,314 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "../../util/mem/Arena.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http
+			{
+
+				/// <summary>
+				/// The HttpHeaderTable holds the headers of a transaction in the order they were
+				/// received. Rather than copying every name and value into strings of their own,
+				/// the table keeps one copy of the received header bytes and refers to slices of
+				/// it. Only headers added after parsing own their storage.
+				///
+				/// Names are matched case insensitively, by comparing a precomputed hash first, so
+				/// a lookup is a short scan over a small vector, with a full compare only on a
+				/// likely match.
+				/// </summary>
+				class HttpHeaderTable
+				{
+
+				public:
+
+					/// <summary>
+					/// A header as it is handed out, name then value. Only valid until the table is
+					/// next changed.
+					/// </summary>
+					typedef std::pair<boost::string_ref, boost::string_ref> Header;
+
+				private:
+
+					struct Slice
+					{
+						uint32_t offset = 0;
+						uint32_t length = 0;
+					};
+
+					struct Entry
+					{
+						uint32_t hash = 0;
+
+						/// <summary>
+						/// When false, name and value are slices of the received header bytes.
+						/// When true, they are held in ownedName and ownedValue.
+						/// </summary>
+						bool owned = false;
+
+						Slice name;
+
+						Slice value;
+
+						std::string ownedName;
+
+						std::string ownedValue;
+					};
+
+				public:
+
+					/// <summary>
+					/// Iterates over the headers of a table, either all of them, or only those with
+					/// a given name.
+					/// </summary>
+					class ConstIterator
+					{
+
+					public:
+
+						typedef std::forward_iterator_tag iterator_category;
+						typedef Header value_type;
+						typedef std::ptrdiff_t difference_type;
+						typedef const Header* pointer;
+						typedef const Header& reference;
+
+						ConstIterator();
+
+						reference operator*() const;
+
+						pointer operator->() const;
+
+						ConstIterator& operator++();
+
+						ConstIterator operator++(int);
+
+						bool operator==(const ConstIterator& other) const;
+
+						bool operator!=(const ConstIterator& other) const;
+
+					private:
+
+						friend class HttpHeaderTable;
+
+						ConstIterator(const HttpHeaderTable* table, const size_t index, const bool matchName, const size_t firstMatch, const uint32_t hash);
+
+						/// <summary>
+						/// Moves forward from m_index to the first header that we're iterating over.
+						/// </summary>
+						void Settle();
+
+						const HttpHeaderTable* m_table = nullptr;
+
+						size_t m_index = 0;
+
+						bool m_matchName = false;
+
+						/// <summary>
+						/// When matching names, the first header that matched, whose name the rest
+						/// are compared against.
+						/// </summary>
+						size_t m_firstMatch = 0;
+
+						uint32_t m_hash = 0;
+
+						mutable Header m_current;
+
+					};
+
+					/// <summary>
+					/// Constructs an empty table.
+					/// </summary>
+					/// <param name="arena">
+					/// The arena to keep the received bytes and the entries in. May be null, in
+					/// which case the general heap is used.
+					/// </param>
+					HttpHeaderTable(util::mem::Arena* arena = nullptr);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					HttpHeaderTable(const HttpHeaderTable&) = delete;
+					HttpHeaderTable(HttpHeaderTable&&) = delete;
+					HttpHeaderTable& operator=(const HttpHeaderTable&) = delete;
+
+					~HttpHeaderTable();
+
+					/// <summary>
+					/// Keeps a copy of the supplied bytes, which are about to be handed to the
+					/// parser, so that the header names and values the parser finds in them can be
+					/// kept as slices of the copy. Must be called before each parse until
+					/// ::EndParse() is called.
+					/// </summary>
+					/// <param name="data">
+					/// The bytes about to be parsed.
+					/// </param>
+					/// <param name="length">
+					/// The number of bytes about to be parsed.
+					/// </param>
+					void BeginParse(const char* data, const size_t length);
+
+					/// <summary>
+					/// Stops keeping received bytes, and drops whatever was kept beyond the end of
+					/// the headers. Headers found after this, such as trailers, are copied.
+					/// </summary>
+					void EndParse();
+
+					/// <summary>
+					/// Takes a header name, or part of one, found by the parser.
+					/// </summary>
+					/// <param name="at">
+					/// The name, as handed to us by the parser.
+					/// </param>
+					/// <param name="length">
+					/// The length of the name.
+					/// </param>
+					void OnField(const char* at, const size_t length);
+
+					/// <summary>
+					/// Takes a header value, or part of one, found by the parser.
+					/// </summary>
+					/// <param name="at">
+					/// The value, as handed to us by the parser.
+					/// </param>
+					/// <param name="length">
+					/// The length of the value.
+					/// </param>
+					/// <returns>
+					/// True if the value was taken, false if no name was seen before it.
+					/// </returns>
+					const bool OnValue(const char* at, const size_t length);
+
+					/// <summary>
+					/// Adds a header after all existing ones.
+					/// </summary>
+					void Add(const boost::string_ref name, const uint32_t hash, const boost::string_ref value);
+
+					/// <summary>
+					/// Removes every header with the supplied name.
+					/// </summary>
+					void Remove(const boost::string_ref name, const uint32_t hash);
+
+					/// <summary>
+					/// Removes every header with the supplied name and value, both matched case
+					/// insensitively.
+					/// </summary>
+					void Remove(const boost::string_ref name, const uint32_t hash, const boost::string_ref value);
+
+					/// <summary>
+					/// Removes every header.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Empties the table as though it were just constructed, abandoning any parse
+					/// in progress. Storage keeps its capacity.
+					/// </summary>
+					void Reset();
+
+					/// <summary>
+					/// Empties the table like ::Reset(), and gives up its storage as well. For when
+					/// the arena the storage came from is about to be reset.
+					/// </summary>
+					void Release();
+
+					/// <summary>
+					/// Gets the header block exactly as it was received, from the start line to the
+					/// blank line ending it, provided that no header has been added, removed or
+					/// copied out of the received bytes since.
+					/// </summary>
+					/// <param name="bytes">
+					/// Set to the received header block, which is valid until the table is next
+					/// cleared.
+					/// </param>
+					/// <returns>
+					/// True if the headers are unmodified and the block was found, false otherwise.
+					/// </returns>
+					const bool GetOriginalBytes(boost::string_ref& bytes) const;
+
+					/// <summary>
+					/// Gets every header with the supplied name, in the order they were added.
+					/// </summary>
+					std::pair<ConstIterator, ConstIterator> EqualRange(const boost::string_ref name, const uint32_t hash) const;
+
+					ConstIterator begin() const;
+
+					ConstIterator end() const;
+
+				private:
+
+					boost::string_ref NameOf(const Entry& entry) const;
+
+					boost::string_ref ValueOf(const Entry& entry) const;
+
+					const bool Matches(const Entry& entry, const boost::string_ref name, const uint32_t hash) const;
+
+					/// <summary>
+					/// Gets the position in m_received of the supplied pointer into the bytes
+					/// last supplied to ::BeginParse(...), or false if it isn't in them.
+					/// </summary>
+					const bool ReceivedOffset(const char* at, const size_t length, uint32_t& offset) const;
+
+					/// <summary>
+					/// Appends the supplied piece to a slice, or to the owned string if the piece
+					/// doesn't directly follow the slice.
+					/// </summary>
+					void Extend(Entry& entry, const bool isName, const char* at, const size_t length);
+
+					/// <summary>
+					/// Copy of the received header bytes, which our slices refer to.
+					/// </summary>
+					util::mem::ArenaVector<char> m_received;
+
+					/// <summary>
+					/// The bytes last supplied to ::BeginParse(...), and where they start in
+					/// m_received. Null once ::EndParse() has been called.
+					/// </summary>
+					const char* m_parseData = nullptr;
+
+					size_t m_parseLength = 0;
+
+					size_t m_parseOffset = 0;
+
+					util::mem::ArenaVector<Entry> m_entries;
+
+					/// <summary>
+					/// Whether the last thing the parser handed us was a value, so that we know if
+					/// the next name or value continues the last one or starts a new one.
+					/// </summary>
+					bool m_lastWasValue = true;
+
+					/// <summary>
+					/// Whether a header has been added or removed since the headers were parsed.
+					/// </summary>
+					bool m_modified = false;
+
+					/// <summary>
+					/// Where the header block, start line included, begins and ends in m_received.
+					/// Both are zero until ::EndParse() finds the end of the block.
+					/// </summary>
+					size_t m_blockStart = 0;
+					size_t m_blockEnd = 0;
+
+				};
+
+			} /* namespace http */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
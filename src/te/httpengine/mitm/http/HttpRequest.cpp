@@ -15,7 +15,9 @@ namespace te
 		{
 			namespace http
 			{
-				HttpRequest::HttpRequest()
+				HttpRequest::HttpRequest(std::shared_ptr<util::mem::Arena> arena)
+					:
+					BaseHttpTransaction(std::move(arena))
 				{
 					m_httpParserSettings.on_url = &OnUrl;
 
@@ -28,7 +30,7 @@ namespace te
 						return 0;
 					};
 
-					m_httpParser = static_cast<http_parser*>(malloc(sizeof(http_parser)));
+					m_httpParser = AllocateParser();
 
 					if (m_httpParser == nullptr)
 					{
@@ -47,7 +49,8 @@ namespace te
 					os.write(data, length);
 					os.flush();
 					*/
-					std::copy(data, data + length, std::back_inserter(m_buffer));
+					m_buffer = util::mem::BufferPool::Shared().Acquire(length);
+					std::copy(data, data + length, m_buffer->data());
 				}
 
 				HttpRequest::~HttpRequest()
@@ -55,6 +58,13 @@ namespace te
 
 				}
 
+				void HttpRequest::Reset()
+				{
+					BaseHttpTransaction::Reset();
+
+					m_requestURI.clear();
+				}
+
 				const std::string& HttpRequest::RequestURI() const
 				{
 					return m_requestURI;
@@ -63,6 +73,8 @@ namespace te
 				void HttpRequest::RequestURI(const std::string& value)
 				{
 					m_requestURI = value;
+					m_startLineModified = true;
+					DiscardEncodedPayload();
 				}
 
 				const HttpRequest::HttpRequestMethod HttpRequest::Method() const
@@ -73,6 +85,8 @@ namespace te
 				void HttpRequest::Method(const HttpRequestMethod method)
 				{
 					m_requestMethod = method;
+					m_startLineModified = true;
+					DiscardEncodedPayload();
 				}
 
 				std::string HttpRequest::HeadersToString()
@@ -108,7 +122,7 @@ namespace te
 
 					for (auto header = m_headers.begin(); header != m_headers.end(); ++header)
 					{
-						ret.append(u8"\r\n").append(header->first).append(u8": ").append(header->second);
+						ret.append(u8"\r\n").append(header->first.data(), header->first.size()).append(u8": ").append(header->second.data(), header->second.size());
 					}
 
 					ret.append(u8"\r\n\r\n");
@@ -37,7 +37,11 @@ namespace te
 					/// http_parser callbacks are largely ignored, as the HttpResponse already holds
 					/// the payoad buffer.
 					/// </summary>
-					HttpRequest();
+					/// <param name="arena">
+					/// The arena to allocate the parse state from. May be null, in which case the
+					/// general heap is used.
+					/// </param>
+					HttpRequest(std::shared_ptr<util::mem::Arena> arena = nullptr);
 
 					/// <summary>
 					/// Constructs a request with the initial given payload. The payload is placed
@@ -113,6 +117,11 @@ namespace te
 					/// </returns>
 					virtual std::vector<char> HeadersToVector();
 
+					/// <summary>
+					/// See BaseHttpTransaction::Reset().
+					/// </summary>
+					virtual void Reset();
+
 				protected:
 
 					/// <summary>
@@ -18,7 +18,9 @@ namespace te
 			namespace http
 			{
 
-				HttpResponse::HttpResponse()
+				HttpResponse::HttpResponse(std::shared_ptr<util::mem::Arena> arena)
+					:
+					BaseHttpTransaction(std::move(arena))
 				{
 					std::cout << "HttpResponse() " << std::endl;
 
@@ -34,7 +36,7 @@ namespace te
 						return 0; 
 					};
 
-					m_httpParser = static_cast<http_parser*>(malloc(sizeof(http_parser)));
+					m_httpParser = AllocateParser();
 
 					if (m_httpParser == nullptr)
 					{
@@ -53,7 +55,8 @@ namespace te
 					os.write(data, length);
 					os.flush();
 					*/
-					std::copy(data, data + length, std::back_inserter(m_buffer));
+					m_buffer = util::mem::BufferPool::Shared().Acquire(length);
+					std::copy(data, data + length, m_buffer->data());
 				}
 
 				HttpResponse::~HttpResponse()
@@ -61,6 +64,13 @@ namespace te
 
 				}
 
+				void HttpResponse::Reset()
+				{
+					BaseHttpTransaction::Reset();
+
+					m_statusString.clear();
+				}
+
 				const uint16_t HttpResponse::StatusCode() const
 				{
 					return m_statusCode;
@@ -96,6 +106,9 @@ namespace te
 
 					m_statusString.append(std::to_string(code));
 					m_statusString.append(u8" ").append(StatusCodeToMessage(code));
+
+					m_startLineModified = true;
+					DiscardEncodedPayload();
 				}
 
 				const std::string& HttpResponse::StatusString() const
@@ -106,6 +119,8 @@ namespace te
 				void HttpResponse::StatusString(const std::string& status)
 				{
 					m_statusString = status;
+					m_startLineModified = true;
+					DiscardEncodedPayload();
 				}
 
 				std::string HttpResponse::HeadersToString()
@@ -129,7 +144,7 @@ namespace te
 					for (auto header = m_headers.begin(); header != m_headers.end(); ++header)
 					{
 						
-						ret.append(u8"\r\n").append(header->first).append(u8": ").append(header->second);
+						ret.append(u8"\r\n").append(header->first.data(), header->first.size()).append(u8": ").append(header->second.data(), header->second.size());
 					}
 
 					ret.append(u8"\r\n\r\n");
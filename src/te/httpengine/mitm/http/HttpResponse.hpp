@@ -35,7 +35,11 @@ namespace te
 					/// http_parser callbacks are largely ignored, as the HttpResponse already holds
 					/// the payoad buffer.
 					/// </summary>
-					HttpResponse();
+					/// <param name="arena">
+					/// The arena to allocate the parse state from. May be null, in which case the
+					/// general heap is used.
+					/// </param>
+					HttpResponse(std::shared_ptr<util::mem::Arena> arena = nullptr);
 
 					/// <summary>
 					/// Constructs a response with the initial given payload. The payload is placed
@@ -138,6 +142,11 @@ namespace te
 					/// </returns>
 					virtual std::vector<char> HeadersToVector();
 
+					/// <summary>
+					/// See BaseHttpTransaction::Reset().
+					/// </summary>
+					virtual void Reset();
+
 				protected:
 
 					/// <summary>
@@ -0,0 +1,183 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include "PayloadInflater.hpp"
+#include "../../util/metrics/EngineMetrics.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http
+			{
+
+				struct PayloadInflater::OutputSink
+				{
+					typedef char char_type;
+					typedef boost::iostreams::sink_tag category;
+
+					PayloadInflater* owner;
+
+					std::streamsize write(const char* s, std::streamsize n)
+					{
+						owner->Append(s, static_cast<size_t>(n));
+						return n;
+					}
+				};
+
+				struct PayloadInflater::Decompressor
+				{
+					/// <summary>
+					/// Small, so that little output is held back between pieces.
+					/// </summary>
+					static constexpr std::streamsize FilterBufferSize = 4096;
+
+					std::unique_ptr<boost::iostreams::gzip_decompressor> gzip;
+
+					std::unique_ptr<boost::iostreams::zlib_decompressor> zlib;
+				};
+
+				PayloadInflater::PayloadInflater(const Format format)
+					:
+					m_decompressor(new Decompressor())
+				{
+					switch (format)
+					{
+						case Format::Gzip:
+						{
+							m_decompressor->gzip.reset(new boost::iostreams::gzip_decompressor(boost::iostreams::zlib::default_window_bits, Decompressor::FilterBufferSize));
+						}
+						break;
+
+						case Format::Deflate:
+						{
+							m_decompressor->zlib.reset(new boost::iostreams::zlib_decompressor(boost::iostreams::zlib::default_window_bits, Decompressor::FilterBufferSize));
+						}
+						break;
+					}
+				}
+
+				PayloadInflater::~PayloadInflater()
+				{
+
+				}
+
+				const bool PayloadInflater::Write(const char* data, const size_t length)
+				{
+					if (m_finished)
+					{
+						return false;
+					}
+
+					if (length == 0)
+					{
+						return true;
+					}
+
+					util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::PayloadDecompression);
+
+					OutputSink sink{ this };
+
+					try
+					{
+						if (m_decompressor->gzip)
+						{
+							m_decompressor->gzip->write(sink, data, static_cast<std::streamsize>(length));
+						}
+						else
+						{
+							m_decompressor->zlib->write(sink, data, static_cast<std::streamsize>(length));
+						}
+					}
+					catch (std::exception&)
+					{
+						m_finished = true;
+						return false;
+					}
+
+					return true;
+				}
+
+				const bool PayloadInflater::Finish()
+				{
+					if (m_finished)
+					{
+						return true;
+					}
+
+					m_finished = true;
+
+					util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::PayloadDecompression);
+
+					OutputSink sink{ this };
+
+					try
+					{
+						if (m_decompressor->gzip)
+						{
+							m_decompressor->gzip->close(sink, std::ios_base::out);
+						}
+						else
+						{
+							m_decompressor->zlib->close(sink, std::ios_base::out);
+						}
+					}
+					catch (std::exception&)
+					{
+						return false;
+					}
+
+					return true;
+				}
+
+				boost::string_ref PayloadInflater::GetOutput() const
+				{
+					if (m_output == nullptr)
+					{
+						return boost::string_ref();
+					}
+
+					return boost::string_ref(m_output->data(), m_outputSize);
+				}
+
+				void PayloadInflater::Clear()
+				{
+					m_outputSize = 0;
+				}
+
+				void PayloadInflater::Append(const char* data, const size_t length)
+				{
+					if (m_output == nullptr || m_outputSize + length > m_output->size())
+					{
+						const size_t currentSize = m_output != nullptr ? m_output->size() : 0;
+
+						auto bigger = util::mem::BufferPool::Shared().Acquire((std::max)(currentSize * 2, m_outputSize + length));
+
+						if (m_outputSize > 0)
+						{
+							std::memcpy(bigger->data(), m_output->data(), m_outputSize);
+						}
+
+						m_output = std::move(bigger);
+					}
+
+					std::memcpy(m_output->data() + m_outputSize, data, length);
+					m_outputSize += length;
+				}
+
+			} /* namespace http */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
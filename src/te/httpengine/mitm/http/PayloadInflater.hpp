@@ -0,0 +1,134 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <boost/utility/string_ref.hpp>
+#include "../../util/mem/BufferPool.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http
+			{
+
+				/// <summary>
+				/// The PayloadInflater decompresses a gzip or deflate encoded payload a piece at a
+				/// time, as the pieces are parsed, rather than all at once after the whole payload has
+				/// been read. Decompressed output accumulates in a buffer from the shared pool, which
+				/// the owner can drop once it has been handed on.
+				///
+				/// The decompressor holds back a little output internally until it has enough to
+				/// fill its own buffer, so the output of a piece may only appear after a later piece,
+				/// and the last of it only appears at ::Finish().
+				/// </summary>
+				class PayloadInflater
+				{
+
+				public:
+
+					enum class Format
+					{
+						Gzip,
+						Deflate
+					};
+
+					/// <summary>
+					/// Constructs a new PayloadInflater for the supplied format.
+					/// </summary>
+					/// <param name="format">
+					/// The encoding of the payload.
+					/// </param>
+					PayloadInflater(const Format format);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					PayloadInflater(const PayloadInflater&) = delete;
+					PayloadInflater(PayloadInflater&&) = delete;
+					PayloadInflater& operator=(const PayloadInflater&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~PayloadInflater();
+
+					/// <summary>
+					/// Decompresses the next piece of the payload.
+					/// </summary>
+					/// <param name="data">
+					/// The compressed data.
+					/// </param>
+					/// <param name="length">
+					/// The length of the compressed data.
+					/// </param>
+					/// <returns>
+					/// True if the data was decompressed, false if it is not valid for the format or
+					/// the payload was already finished.
+					/// </returns>
+					const bool Write(const char* data, const size_t length);
+
+					/// <summary>
+					/// Flushes the remaining output and verifies that the payload ended properly.
+					/// Nothing can be written afterwards. Calling this more than once is harmless.
+					/// </summary>
+					/// <returns>
+					/// True if the payload was complete and valid, false otherwise.
+					/// </returns>
+					const bool Finish();
+
+					/// <summary>
+					/// Gets the output decompressed since construction, or since the last call to
+					/// ::Clear().
+					/// </summary>
+					/// <returns>
+					/// The decompressed output. Only valid until the next call to any other member.
+					/// </returns>
+					boost::string_ref GetOutput() const;
+
+					/// <summary>
+					/// Drops the output decompressed so far, keeping the state of the stream.
+					/// </summary>
+					void Clear();
+
+				private:
+
+					/// <summary>
+					/// Sink handed to the decompressor, which appends to our output.
+					/// </summary>
+					struct OutputSink;
+
+					/// <summary>
+					/// Hides the particular boost::iostreams filter in use.
+					/// </summary>
+					struct Decompressor;
+
+					/// <summary>
+					/// Appends the supplied data to the output, moving to a bigger pooled buffer if
+					/// the current one is full.
+					/// </summary>
+					void Append(const char* data, const size_t length);
+
+					std::unique_ptr<Decompressor> m_decompressor;
+
+					util::mem::SharedBuffer m_output;
+
+					size_t m_outputSize = 0;
+
+					bool m_finished = false;
+
+				};
+
+			} /* namespace http */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
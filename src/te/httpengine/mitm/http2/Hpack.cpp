@@ -0,0 +1,603 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "Hpack.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				namespace
+				{
+					/// <summary>
+					/// The static table, as per RFC 7541 appendix A. Index 1 is the first entry.
+					/// </summary>
+					static const char* const StaticTable[][2] = {
+						{ ":authority", "" }, { ":method", "GET" }, { ":method", "POST" }, { ":path", "/" },
+						{ ":path", "/index.html" }, { ":scheme", "http" }, { ":scheme", "https" }, { ":status", "200" },
+						{ ":status", "204" }, { ":status", "206" }, { ":status", "304" }, { ":status", "400" },
+						{ ":status", "404" }, { ":status", "500" }, { "accept-charset", "" }, { "accept-encoding", "gzip, deflate" },
+						{ "accept-language", "" }, { "accept-ranges", "" }, { "accept", "" }, { "access-control-allow-origin", "" },
+						{ "age", "" }, { "allow", "" }, { "authorization", "" }, { "cache-control", "" },
+						{ "content-disposition", "" }, { "content-encoding", "" }, { "content-language", "" }, { "content-length", "" },
+						{ "content-location", "" }, { "content-range", "" }, { "content-type", "" }, { "cookie", "" },
+						{ "date", "" }, { "etag", "" }, { "expect", "" }, { "expires", "" },
+						{ "from", "" }, { "host", "" }, { "if-match", "" }, { "if-modified-since", "" },
+						{ "if-none-match", "" }, { "if-range", "" }, { "if-unmodified-since", "" }, { "last-modified", "" },
+						{ "link", "" }, { "location", "" }, { "max-forwards", "" }, { "proxy-authenticate", "" },
+						{ "proxy-authorization", "" }, { "range", "" }, { "referer", "" }, { "refresh", "" },
+						{ "retry-after", "" }, { "server", "" }, { "set-cookie", "" }, { "strict-transport-security", "" },
+						{ "transfer-encoding", "" }, { "user-agent", "" }, { "vary", "" }, { "via", "" },
+						{ "www-authenticate", "" }
+					};
+
+					static constexpr size_t StaticTableLength = sizeof(StaticTable) / sizeof(StaticTable[0]);
+
+					/// <summary>
+					/// Every entry in the dynamic table costs this much on top of its name and
+					/// value, as per RFC 7541 section 4.1.
+					/// </summary>
+					static constexpr size_t EntryOverhead = 32;
+
+					/// <summary>
+					/// The Huffman code, as per RFC 7541 appendix B. The code of each symbol, right
+					/// aligned, and its length in bits. Symbol 256 is EOS.
+					/// </summary>
+					static const struct { uint32_t Code; uint8_t Length; } HuffmanCodes[257] = {
+						{ 0x1ff8, 13 }, { 0x7fffd8, 23 }, { 0xfffffe2, 28 }, { 0xfffffe3, 28 },
+						{ 0xfffffe4, 28 }, { 0xfffffe5, 28 }, { 0xfffffe6, 28 }, { 0xfffffe7, 28 },
+						{ 0xfffffe8, 28 }, { 0xffffea, 24 }, { 0x3ffffffc, 30 }, { 0xfffffe9, 28 },
+						{ 0xfffffea, 28 }, { 0x3ffffffd, 30 }, { 0xfffffeb, 28 }, { 0xfffffec, 28 },
+						{ 0xfffffed, 28 }, { 0xfffffee, 28 }, { 0xfffffef, 28 }, { 0xffffff0, 28 },
+						{ 0xffffff1, 28 }, { 0xffffff2, 28 }, { 0x3ffffffe, 30 }, { 0xffffff3, 28 },
+						{ 0xffffff4, 28 }, { 0xffffff5, 28 }, { 0xffffff6, 28 }, { 0xffffff7, 28 },
+						{ 0xffffff8, 28 }, { 0xffffff9, 28 }, { 0xffffffa, 28 }, { 0xffffffb, 28 },
+						{ 0x14, 6 }, { 0x3f8, 10 }, { 0x3f9, 10 }, { 0xffa, 12 },
+						{ 0x1ff9, 13 }, { 0x15, 6 }, { 0xf8, 8 }, { 0x7fa, 11 },
+						{ 0x3fa, 10 }, { 0x3fb, 10 }, { 0xf9, 8 }, { 0x7fb, 11 },
+						{ 0xfa, 8 }, { 0x16, 6 }, { 0x17, 6 }, { 0x18, 6 },
+						{ 0x0, 5 }, { 0x1, 5 }, { 0x2, 5 }, { 0x19, 6 },
+						{ 0x1a, 6 }, { 0x1b, 6 }, { 0x1c, 6 }, { 0x1d, 6 },
+						{ 0x1e, 6 }, { 0x1f, 6 }, { 0x5c, 7 }, { 0xfb, 8 },
+						{ 0x7ffc, 15 }, { 0x20, 6 }, { 0xffb, 12 }, { 0x3fc, 10 },
+						{ 0x1ffa, 13 }, { 0x21, 6 }, { 0x5d, 7 }, { 0x5e, 7 },
+						{ 0x5f, 7 }, { 0x60, 7 }, { 0x61, 7 }, { 0x62, 7 },
+						{ 0x63, 7 }, { 0x64, 7 }, { 0x65, 7 }, { 0x66, 7 },
+						{ 0x67, 7 }, { 0x68, 7 }, { 0x69, 7 }, { 0x6a, 7 },
+						{ 0x6b, 7 }, { 0x6c, 7 }, { 0x6d, 7 }, { 0x6e, 7 },
+						{ 0x6f, 7 }, { 0x70, 7 }, { 0x71, 7 }, { 0x72, 7 },
+						{ 0xfc, 8 }, { 0x73, 7 }, { 0xfd, 8 }, { 0x1ffb, 13 },
+						{ 0x7fff0, 19 }, { 0x1ffc, 13 }, { 0x3ffc, 14 }, { 0x22, 6 },
+						{ 0x7ffd, 15 }, { 0x3, 5 }, { 0x23, 6 }, { 0x4, 5 },
+						{ 0x24, 6 }, { 0x5, 5 }, { 0x25, 6 }, { 0x26, 6 },
+						{ 0x27, 6 }, { 0x6, 5 }, { 0x74, 7 }, { 0x75, 7 },
+						{ 0x28, 6 }, { 0x29, 6 }, { 0x2a, 6 }, { 0x7, 5 },
+						{ 0x2b, 6 }, { 0x76, 7 }, { 0x2c, 6 }, { 0x8, 5 },
+						{ 0x9, 5 }, { 0x2d, 6 }, { 0x77, 7 }, { 0x78, 7 },
+						{ 0x79, 7 }, { 0x7a, 7 }, { 0x7b, 7 }, { 0x7ffe, 15 },
+						{ 0x7fc, 11 }, { 0x3ffd, 14 }, { 0x1ffd, 13 }, { 0xffffffc, 28 },
+						{ 0xfffe6, 20 }, { 0x3fffd2, 22 }, { 0xfffe7, 20 }, { 0xfffe8, 20 },
+						{ 0x3fffd3, 22 }, { 0x3fffd4, 22 }, { 0x3fffd5, 22 }, { 0x7fffd9, 23 },
+						{ 0x3fffd6, 22 }, { 0x7fffda, 23 }, { 0x7fffdb, 23 }, { 0x7fffdc, 23 },
+						{ 0x7fffdd, 23 }, { 0x7fffde, 23 }, { 0xffffeb, 24 }, { 0x7fffdf, 23 },
+						{ 0xffffec, 24 }, { 0xffffed, 24 }, { 0x3fffd7, 22 }, { 0x7fffe0, 23 },
+						{ 0xffffee, 24 }, { 0x7fffe1, 23 }, { 0x7fffe2, 23 }, { 0x7fffe3, 23 },
+						{ 0x7fffe4, 23 }, { 0x1fffdc, 21 }, { 0x3fffd8, 22 }, { 0x7fffe5, 23 },
+						{ 0x3fffd9, 22 }, { 0x7fffe6, 23 }, { 0x7fffe7, 23 }, { 0xffffef, 24 },
+						{ 0x3fffda, 22 }, { 0x1fffdd, 21 }, { 0xfffe9, 20 }, { 0x3fffdb, 22 },
+						{ 0x3fffdc, 22 }, { 0x7fffe8, 23 }, { 0x7fffe9, 23 }, { 0x1fffde, 21 },
+						{ 0x7fffea, 23 }, { 0x3fffdd, 22 }, { 0x3fffde, 22 }, { 0xfffff0, 24 },
+						{ 0x1fffdf, 21 }, { 0x3fffdf, 22 }, { 0x7fffeb, 23 }, { 0x7fffec, 23 },
+						{ 0x1fffe0, 21 }, { 0x1fffe1, 21 }, { 0x3fffe0, 22 }, { 0x1fffe2, 21 },
+						{ 0x7fffed, 23 }, { 0x3fffe1, 22 }, { 0x7fffee, 23 }, { 0x7fffef, 23 },
+						{ 0xfffea, 20 }, { 0x3fffe2, 22 }, { 0x3fffe3, 22 }, { 0x3fffe4, 22 },
+						{ 0x7ffff0, 23 }, { 0x3fffe5, 22 }, { 0x3fffe6, 22 }, { 0x7ffff1, 23 },
+						{ 0x3ffffe0, 26 }, { 0x3ffffe1, 26 }, { 0xfffeb, 20 }, { 0x7fff1, 19 },
+						{ 0x3fffe7, 22 }, { 0x7ffff2, 23 }, { 0x3fffe8, 22 }, { 0x1ffffec, 25 },
+						{ 0x3ffffe2, 26 }, { 0x3ffffe3, 26 }, { 0x3ffffe4, 26 }, { 0x7ffffde, 27 },
+						{ 0x7ffffdf, 27 }, { 0x3ffffe5, 26 }, { 0xfffff1, 24 }, { 0x1ffffed, 25 },
+						{ 0x7fff2, 19 }, { 0x1fffe3, 21 }, { 0x3ffffe6, 26 }, { 0x7ffffe0, 27 },
+						{ 0x7ffffe1, 27 }, { 0x3ffffe7, 26 }, { 0x7ffffe2, 27 }, { 0xfffff2, 24 },
+						{ 0x1fffe4, 21 }, { 0x1fffe5, 21 }, { 0x3ffffe8, 26 }, { 0x3ffffe9, 26 },
+						{ 0xffffffd, 28 }, { 0x7ffffe3, 27 }, { 0x7ffffe4, 27 }, { 0x7ffffe5, 27 },
+						{ 0xfffec, 20 }, { 0xfffff3, 24 }, { 0xfffed, 20 }, { 0x1fffe6, 21 },
+						{ 0x3fffe9, 22 }, { 0x1fffe7, 21 }, { 0x1fffe8, 21 }, { 0x7ffff3, 23 },
+						{ 0x3fffea, 22 }, { 0x3fffeb, 22 }, { 0x1ffffee, 25 }, { 0x1ffffef, 25 },
+						{ 0xfffff4, 24 }, { 0xfffff5, 24 }, { 0x3ffffea, 26 }, { 0x7ffff4, 23 },
+						{ 0x3ffffeb, 26 }, { 0x7ffffe6, 27 }, { 0x3ffffec, 26 }, { 0x3ffffed, 26 },
+						{ 0x7ffffe7, 27 }, { 0x7ffffe8, 27 }, { 0x7ffffe9, 27 }, { 0x7ffffea, 27 },
+						{ 0x7ffffeb, 27 }, { 0xffffffe, 28 }, { 0x7ffffec, 27 }, { 0x7ffffed, 27 },
+						{ 0x7ffffee, 27 }, { 0x7ffffef, 27 }, { 0x7fffff0, 27 }, { 0x3ffffee, 26 },
+						{ 0x3fffffff, 30 }
+					};
+
+					/// <summary>
+					/// The Huffman code as a binary tree, for decoding a bit at a time. Built from
+					/// the code table on first use.
+					/// </summary>
+					class HuffmanTree
+					{
+
+					public:
+
+						HuffmanTree()
+						{
+							m_nodes.reserve(2 * 257);
+							m_nodes.push_back(Node());
+
+							for (uint32_t symbol = 0; symbol < 257; ++symbol)
+							{
+								int32_t node = 0;
+
+								for (int32_t bit = HuffmanCodes[symbol].Length - 1; bit >= 0; --bit)
+								{
+									const uint32_t branch = (HuffmanCodes[symbol].Code >> bit) & 1;
+
+									if (m_nodes[node].Children[branch] == 0)
+									{
+										m_nodes[node].Children[branch] = static_cast<int32_t>(m_nodes.size());
+										m_nodes.push_back(Node());
+									}
+
+									node = m_nodes[node].Children[branch];
+								}
+
+								m_nodes[node].Symbol = static_cast<int32_t>(symbol);
+							}
+						}
+
+						/// <summary>
+						/// Decodes a Huffman coded string, appending it to the supplied one.
+						/// </summary>
+						/// <returns>
+						/// False if the string holds EOS, or is padded with anything other than the
+						/// start of EOS, as per RFC 7541 section 5.2.
+						/// </returns>
+						const bool Decode(const unsigned char* data, const size_t length, std::string& out) const
+						{
+							int32_t node = 0;
+							uint32_t padding = 0;
+							bool allOnes = true;
+
+							for (size_t i = 0; i < length; ++i)
+							{
+								for (int32_t bit = 7; bit >= 0; --bit)
+								{
+									const uint32_t branch = (data[i] >> bit) & 1;
+
+									node = m_nodes[node].Children[branch];
+
+									++padding;
+									allOnes = allOnes && branch == 1;
+
+									if (m_nodes[node].Symbol >= 0)
+									{
+										if (m_nodes[node].Symbol == 256)
+										{
+											return false;
+										}
+
+										out.push_back(static_cast<char>(m_nodes[node].Symbol));
+
+										node = 0;
+										padding = 0;
+										allOnes = true;
+									}
+								}
+							}
+
+							return padding < 8 && allOnes;
+						}
+
+					private:
+
+						struct Node
+						{
+							/// <summary>
+							/// Zero where there's no child. The root is never anyone's child.
+							/// </summary>
+							int32_t Children[2] = { 0, 0 };
+
+							/// <summary>
+							/// The symbol of a leaf, -1 for every other node.
+							/// </summary>
+							int32_t Symbol = -1;
+						};
+
+						std::vector<Node> m_nodes;
+
+					};
+
+					const HuffmanTree& GetHuffmanTree()
+					{
+						static const HuffmanTree tree;
+						return tree;
+					}
+
+					/// <summary>
+					/// Decodes an integer with an N bit prefix, as per RFC 7541 section 5.1.
+					/// Anything beyond what any sane length or index can be is rejected, so that
+					/// the value can't overflow.
+					/// </summary>
+					const bool DecodeInteger(const unsigned char*& position, const unsigned char* end, const uint32_t prefixBits, uint64_t& value)
+					{
+						if (position >= end)
+						{
+							return false;
+						}
+
+						const uint32_t prefixMax = (1u << prefixBits) - 1;
+
+						value = *position & prefixMax;
+						++position;
+
+						if (value < prefixMax)
+						{
+							return true;
+						}
+
+						uint32_t shift = 0;
+
+						while (position < end)
+						{
+							const unsigned char byte = *position;
+							++position;
+
+							value += static_cast<uint64_t>(byte & 0x7f) << shift;
+
+							if ((byte & 0x80) == 0)
+							{
+								return true;
+							}
+
+							shift += 7;
+
+							if (shift > 28)
+							{
+								return false;
+							}
+						}
+
+						return false;
+					}
+
+					/// <summary>
+					/// Decodes a string literal, as per RFC 7541 section 5.2.
+					/// </summary>
+					const bool DecodeString(const unsigned char*& position, const unsigned char* end, std::string& out)
+					{
+						if (position >= end)
+						{
+							return false;
+						}
+
+						const bool huffman = (*position & 0x80) != 0;
+
+						uint64_t length = 0;
+
+						if (!DecodeInteger(position, end, 7, length) || length > static_cast<uint64_t>(end - position))
+						{
+							return false;
+						}
+
+						out.clear();
+
+						if (huffman)
+						{
+							if (!GetHuffmanTree().Decode(position, static_cast<size_t>(length), out))
+							{
+								return false;
+							}
+						}
+						else
+						{
+							out.assign(reinterpret_cast<const char*>(position), static_cast<size_t>(length));
+						}
+
+						position += length;
+
+						return true;
+					}
+
+					/// <summary>
+					/// Encodes an integer with an N bit prefix, the bits above the prefix in the
+					/// first byte being the supplied ones.
+					/// </summary>
+					void EncodeInteger(std::string& out, const unsigned char firstByteBits, const uint32_t prefixBits, uint64_t value)
+					{
+						const uint32_t prefixMax = (1u << prefixBits) - 1;
+
+						if (value < prefixMax)
+						{
+							out.push_back(static_cast<char>(firstByteBits | static_cast<unsigned char>(value)));
+							return;
+						}
+
+						out.push_back(static_cast<char>(firstByteBits | prefixMax));
+
+						value -= prefixMax;
+
+						while (value >= 0x80)
+						{
+							out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+							value >>= 7;
+						}
+
+						out.push_back(static_cast<char>(value));
+					}
+
+					/// <summary>
+					/// Encodes a string literal, Huffman coded if that makes it any shorter.
+					/// </summary>
+					void EncodeString(std::string& out, const std::string& value)
+					{
+						uint64_t huffmanBits = 0;
+
+						for (const char c : value)
+						{
+							huffmanBits += HuffmanCodes[static_cast<unsigned char>(c)].Length;
+						}
+
+						const uint64_t huffmanLength = (huffmanBits + 7) / 8;
+
+						if (huffmanLength >= value.size())
+						{
+							EncodeInteger(out, 0x00, 7, value.size());
+							out.append(value);
+							return;
+						}
+
+						EncodeInteger(out, 0x80, 7, huffmanLength);
+
+						uint64_t pending = 0;
+						uint32_t pendingBits = 0;
+
+						for (const char c : value)
+						{
+							const auto& code = HuffmanCodes[static_cast<unsigned char>(c)];
+
+							pending = (pending << code.Length) | code.Code;
+							pendingBits += code.Length;
+
+							while (pendingBits >= 8)
+							{
+								pendingBits -= 8;
+								out.push_back(static_cast<char>((pending >> pendingBits) & 0xff));
+							}
+						}
+
+						if (pendingBits > 0)
+						{
+							// Padded with the most significant bits of EOS, which are all ones.
+							out.push_back(static_cast<char>(((pending << (8 - pendingBits)) | (0xff >> pendingBits)) & 0xff));
+						}
+					}
+
+					/// <summary>
+					/// Finds the static table entry with the supplied name, and with the supplied
+					/// value too if there's one.
+					/// </summary>
+					/// <param name="fullMatch">
+					/// Set to whether the value matches as well.
+					/// </param>
+					/// <returns>
+					/// The index of the entry, zero if there's none with the name.
+					/// </returns>
+					const size_t FindStatic(const std::string& name, const std::string& value, bool& fullMatch)
+					{
+						size_t nameIndex = 0;
+
+						fullMatch = false;
+
+						for (size_t i = 0; i < StaticTableLength; ++i)
+						{
+							if (name.compare(StaticTable[i][0]) != 0)
+							{
+								continue;
+							}
+
+							if (value.compare(StaticTable[i][1]) == 0)
+							{
+								fullMatch = true;
+								return i + 1;
+							}
+
+							if (nameIndex == 0)
+							{
+								nameIndex = i + 1;
+							}
+						}
+
+						return nameIndex;
+					}
+				}
+
+				HpackDecoder::HpackDecoder(const size_t maxTableSize, const size_t maxHeaderListSize)
+					:
+					m_currentMaxTableSize(maxTableSize),
+					m_maxTableSize(maxTableSize),
+					m_maxHeaderListSize(maxHeaderListSize)
+				{
+
+				}
+
+				const bool HpackDecoder::Decode(const char* data, const size_t length, HeaderList& headers)
+				{
+					const unsigned char* position = reinterpret_cast<const unsigned char*>(data);
+					const unsigned char* end = position + length;
+
+					size_t listSize = 0;
+					bool headerSeen = false;
+
+					std::string name;
+					std::string value;
+
+					while (position < end)
+					{
+						const unsigned char first = *position;
+
+						if ((first & 0x80) != 0)
+						{
+							// Indexed header field.
+							uint64_t index = 0;
+
+							if (!DecodeInteger(position, end, 7, index) || !Lookup(index, name, value))
+							{
+								return false;
+							}
+						}
+						else if ((first & 0xe0) == 0x20)
+						{
+							// Dynamic table size update. Only ever at the start of a block.
+							uint64_t size = 0;
+
+							if (headerSeen || !DecodeInteger(position, end, 5, size) || size > m_maxTableSize)
+							{
+								return false;
+							}
+
+							m_currentMaxTableSize = static_cast<size_t>(size);
+							EvictTo(m_currentMaxTableSize);
+							continue;
+						}
+						else
+						{
+							// Literal header field, with incremental indexing if the 01 pattern, and
+							// without indexing or never indexed otherwise. Either way, the name is
+							// either indexed or a literal of its own.
+							const bool incremental = (first & 0xc0) == 0x40;
+
+							uint64_t index = 0;
+
+							if (!DecodeInteger(position, end, incremental ? 6 : 4, index))
+							{
+								return false;
+							}
+
+							if (index == 0)
+							{
+								if (!DecodeString(position, end, name))
+								{
+									return false;
+								}
+							}
+							else if (!Lookup(index, name, value))
+							{
+								return false;
+							}
+
+							if (!DecodeString(position, end, value))
+							{
+								return false;
+							}
+
+							if (incremental)
+							{
+								Insert(name, value);
+							}
+						}
+
+						headerSeen = true;
+
+						listSize += name.size() + value.size() + EntryOverhead;
+
+						if (listSize > m_maxHeaderListSize)
+						{
+							return false;
+						}
+
+						headers.emplace_back(name, value);
+					}
+
+					return true;
+				}
+
+				const bool HpackDecoder::Lookup(const uint64_t index, std::string& name, std::string& value) const
+				{
+					if (index == 0)
+					{
+						return false;
+					}
+
+					if (index <= StaticTableLength)
+					{
+						name.assign(StaticTable[index - 1][0]);
+						value.assign(StaticTable[index - 1][1]);
+						return true;
+					}
+
+					const uint64_t dynamicIndex = index - StaticTableLength - 1;
+
+					if (dynamicIndex >= m_table.size())
+					{
+						return false;
+					}
+
+					name = m_table[static_cast<size_t>(dynamicIndex)].first;
+					value = m_table[static_cast<size_t>(dynamicIndex)].second;
+
+					return true;
+				}
+
+				void HpackDecoder::Insert(std::string name, std::string value)
+				{
+					const size_t entrySize = name.size() + value.size() + EntryOverhead;
+
+					if (entrySize > m_currentMaxTableSize)
+					{
+						// Not an error. The table just ends up empty, as per RFC 7541 section 4.4.
+						EvictTo(0);
+						return;
+					}
+
+					EvictTo(m_currentMaxTableSize - entrySize);
+
+					m_table.emplace_front(std::move(name), std::move(value));
+					m_tableSize += entrySize;
+				}
+
+				void HpackDecoder::EvictTo(const size_t size)
+				{
+					while (m_tableSize > size && !m_table.empty())
+					{
+						m_tableSize -= m_table.back().first.size() + m_table.back().second.size() + EntryOverhead;
+						m_table.pop_back();
+					}
+				}
+
+				void HpackEncoder::Encode(const std::string& name, const std::string& value, std::string& block)
+				{
+					bool fullMatch = false;
+
+					const size_t index = FindStatic(name, value, fullMatch);
+
+					if (fullMatch)
+					{
+						EncodeInteger(block, 0x80, 7, index);
+						return;
+					}
+
+					// Literal without indexing, as per RFC 7541 section 6.2.2.
+					EncodeInteger(block, 0x00, 4, index);
+
+					if (index == 0)
+					{
+						EncodeString(block, name);
+					}
+
+					EncodeString(block, value);
+				}
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,162 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				/// <summary>
+				/// A decoded header list, names and values in the order they appeared in the block.
+				/// </summary>
+				using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+				/// <summary>
+				/// The size of the dynamic table either end starts with, and the largest we ever
+				/// let a client's encoder use.
+				/// </summary>
+				static constexpr size_t DefaultHeaderTableSize = 4096;
+
+				/// <summary>
+				/// The HpackDecoder decodes the header blocks of a single connection, as per RFC
+				/// 7541. Blocks must be decoded in the order they were received, every one of them,
+				/// including those of streams that are refused or reset, since each of them may
+				/// change the dynamic table that the ones after it refer to.
+				/// </summary>
+				class HpackDecoder
+				{
+
+				public:
+
+					/// <summary>
+					/// Constructs a new HpackDecoder.
+					/// </summary>
+					/// <param name="maxTableSize">
+					/// The largest dynamic table the encoder of the peer is allowed to use, which
+					/// is what was advertised as SETTINGS_HEADER_TABLE_SIZE.
+					/// </param>
+					/// <param name="maxHeaderListSize">
+					/// The largest decoded header list accepted, counted as per RFC 7540 section
+					/// 6.5.2, so that a small block can't expand into a huge list.
+					/// </param>
+					HpackDecoder(const size_t maxTableSize, const size_t maxHeaderListSize);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					HpackDecoder(const HpackDecoder&) = delete;
+					HpackDecoder(HpackDecoder&&) = delete;
+					HpackDecoder& operator=(const HpackDecoder&) = delete;
+
+					/// <summary>
+					/// Decodes a complete header block, appending every header in it to the
+					/// supplied list.
+					/// </summary>
+					/// <param name="data">
+					/// The header block, which is the fragments of a HEADERS frame and its
+					/// CONTINUATION frames, put together.
+					/// </param>
+					/// <param name="length">
+					/// The length of the header block.
+					/// </param>
+					/// <param name="headers">
+					/// The list the headers are appended to.
+					/// </param>
+					/// <returns>
+					/// True if the block was decoded, false if it was malformed or too large. The
+					/// state of the decoder is then unknown, and the connection can't go on.
+					/// </returns>
+					const bool Decode(const char* data, const size_t length, HeaderList& headers);
+
+				private:
+
+					/// <summary>
+					/// Gets the entry at the supplied index, which is into the static table
+					/// followed by the dynamic table, as per RFC 7541 section 2.3.3.
+					/// </summary>
+					const bool Lookup(const uint64_t index, std::string& name, std::string& value) const;
+
+					/// <summary>
+					/// Inserts an entry at the front of the dynamic table, evicting as many of the
+					/// oldest entries as it takes to stay within the table size.
+					/// </summary>
+					void Insert(std::string name, std::string value);
+
+					/// <summary>
+					/// Evicts entries until the table fits in the supplied size.
+					/// </summary>
+					void EvictTo(const size_t size);
+
+					/// <summary>
+					/// The dynamic table, newest entry at the front.
+					/// </summary>
+					std::deque<std::pair<std::string, std::string>> m_table;
+
+					/// <summary>
+					/// The size of the dynamic table, counted as per RFC 7541 section 4.1.
+					/// </summary>
+					size_t m_tableSize = 0;
+
+					/// <summary>
+					/// The size the encoder of the peer last set the table to.
+					/// </summary>
+					size_t m_currentMaxTableSize;
+
+					/// <summary>
+					/// The size the encoder of the peer may set the table to, at most.
+					/// </summary>
+					size_t m_maxTableSize;
+
+					size_t m_maxHeaderListSize;
+
+				};
+
+				/// <summary>
+				/// The HpackEncoder encodes the header blocks of a single connection. It never
+				/// adds to the dynamic table of the peer, so whatever table size the peer sets,
+				/// there's no state to keep. Headers are encoded as literals, with the name taken
+				/// from the static table where it's there, and strings are Huffman coded whenever
+				/// that's shorter.
+				/// </summary>
+				class HpackEncoder
+				{
+
+				public:
+
+					/// <summary>
+					/// Appends a single header to a header block.
+					/// </summary>
+					/// <param name="name">
+					/// The header name, which must already be in lower case.
+					/// </param>
+					/// <param name="value">
+					/// The header value.
+					/// </param>
+					/// <param name="block">
+					/// The header block being built.
+					/// </param>
+					static void Encode(const std::string& name, const std::string& value, std::string& block);
+
+				};
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,468 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "Http2Session.hpp"
+#include "../../network/OptionalStrand.hpp"
+#include "../../util/cb/EventReporter.hpp"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				/// <summary>
+				/// The Http2Connection puts an Http2Session on the downstream socket of a bridge,
+				/// and in turn stands in for that socket, so that the bridge can go on reading
+				/// HTTP/1.1 requests and writing HTTP/1.1 responses with the asio composed
+				/// operations it already uses, one transaction at a time, while HTTP/2 is spoken
+				/// with the client.
+				///
+				/// Reads complete with the request of the stream the session hands out next,
+				/// writes with the response being accepted into the session. The connection
+				/// reads from and writes to the socket on its own the whole time, so PING,
+				/// SETTINGS and WINDOW_UPDATE are answered, and new streams queued, whatever the
+				/// bridge is doing.
+				///
+				/// Everything is serialized through the strand of the downstream socket, which
+				/// must be the strand every other downstream handler of the bridge runs in.
+				/// </summary>
+				template<class SocketType>
+				class Http2Connection : public std::enable_shared_from_this< Http2Connection<SocketType> >, public util::cb::EventReporter
+				{
+
+				public:
+
+					/// <summary>
+					/// How much framed data may be waiting to go out to the client before a write
+					/// of the bridge is held back. Keeps a fast upstream from piling up responses
+					/// in memory behind a slow client.
+					/// </summary>
+					static constexpr size_t MaxBufferedOutput = 262144;
+
+					/// <summary>
+					/// Constructs a new Http2Connection.
+					/// </summary>
+					/// <param name="socket">
+					/// The downstream socket, over which HTTP/2 has been agreed on. Must outlive
+					/// every operation on the connection, which is ensured by the owner.
+					/// </param>
+					/// <param name="strand">
+					/// The strand of the downstream socket.
+					/// </param>
+					/// <param name="owner">
+					/// Whatever keeps the socket alive, which is the bridge. Every operation the
+					/// connection has pending on the socket holds on to it.
+					/// </param>
+					/// <param name="host">
+					/// The host the client connected for. See Http2Session.
+					/// </param>
+					Http2Connection(
+						SocketType& socket,
+						network::OptionalStrand& strand,
+						std::weak_ptr<void> owner,
+						const std::string& host,
+						util::cb::MessageFunction onInfoCb = nullptr,
+						util::cb::MessageFunction onWarnCb = nullptr,
+						util::cb::MessageFunction onErrorCb = nullptr
+						)
+						:
+						util::cb::EventReporter(
+							onInfoCb,
+							onWarnCb,
+							onErrorCb
+							),
+						m_socket(socket),
+						m_strand(strand),
+						m_owner(owner),
+						m_session(host)
+					{
+
+					}
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					Http2Connection(const Http2Connection&) = delete;
+					Http2Connection(Http2Connection&&) = delete;
+					Http2Connection& operator=(const Http2Connection&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~Http2Connection()
+					{
+
+					}
+
+					/// <summary>
+					/// Sends our connection preface and starts reading from the client. Must be
+					/// called from the strand.
+					/// </summary>
+					void Start()
+					{
+						Flush();
+						Read();
+					}
+
+					/// <summary>
+					/// Reads part of the next request, in place of async_read_some(...) on the
+					/// socket. Completes with eof once the client is gone or the session is
+					/// over, and with connection_reset if the client reset the request before it
+					/// was all read.
+					/// </summary>
+					template<typename MutableBufferSequence, typename ReadHandler>
+					void async_read_some(const MutableBufferSequence& buffers, ReadHandler handler)
+					{
+						auto self(this->shared_from_this());
+
+						boost::asio::mutable_buffer buffer = FirstBuffer<boost::asio::mutable_buffer>(buffers);
+
+						boost::asio::io_service& service = get_io_service();
+
+						m_strand.dispatch(
+							[this, self, buffer, handler, &service]()
+							{
+								if (m_readHandler)
+								{
+									// The bridge never has more than one read pending. If it did,
+									// there'd be no telling which request goes where.
+									service.post(boost::asio::detail::bind_handler(handler, boost::system::error_code(boost::asio::error::in_progress), static_cast<size_t>(0)));
+									return;
+								}
+
+								m_readBuffer = buffer;
+
+								m_readHandler = [handler, &service](const boost::system::error_code& error, const size_t bytesTransferred)
+								{
+									service.post(boost::asio::detail::bind_handler(handler, error, bytesTransferred));
+								};
+
+								Service();
+							}
+							);
+					}
+
+					/// <summary>
+					/// Writes part of the response, in place of async_write_some(...) on the
+					/// socket. The data is always taken whole, so the write completes with all of
+					/// it, once the session has framed it and it has mostly gone out, or with
+					/// connection_reset if the stream can't take a response anymore.
+					/// </summary>
+					template<typename ConstBufferSequence, typename WriteHandler>
+					void async_write_some(const ConstBufferSequence& buffers, WriteHandler handler)
+					{
+						auto self(this->shared_from_this());
+
+						boost::asio::io_service& service = get_io_service();
+
+						m_strand.dispatch(
+							[this, self, buffers, handler, &service]()
+							{
+								if (m_writeHandler)
+								{
+									service.post(boost::asio::detail::bind_handler(handler, boost::system::error_code(boost::asio::error::in_progress), static_cast<size_t>(0)));
+									return;
+								}
+
+								size_t taken = 0;
+								bool accepted = true;
+
+								for (auto it = buffers.begin(); it != buffers.end(); ++it)
+								{
+									boost::asio::const_buffer buffer(*it);
+
+									const size_t size = boost::asio::buffer_size(buffer);
+
+									if (size == 0)
+									{
+										continue;
+									}
+
+									if (!m_session.WriteResponse(boost::asio::buffer_cast<const char*>(buffer), size))
+									{
+										accepted = false;
+										break;
+									}
+
+									taken += size;
+								}
+
+								Flush();
+
+								if (!accepted)
+								{
+									service.post(boost::asio::detail::bind_handler(handler, boost::system::error_code(boost::asio::error::connection_reset), static_cast<size_t>(0)));
+									return;
+								}
+
+								m_writeSize = taken;
+
+								m_writeHandler = [handler, &service](const boost::system::error_code& error, const size_t bytesTransferred)
+								{
+									service.post(boost::asio::detail::bind_handler(handler, error, bytesTransferred));
+								};
+
+								Service();
+							}
+							);
+					}
+
+					/// <summary>
+					/// Gets the io_service completion handlers are posted to.
+					/// </summary>
+					boost::asio::io_service& get_io_service()
+					{
+						return m_strand.get_io_service();
+					}
+
+					/// <summary>
+					/// Ends the response to the request read last, moving on to the next stream.
+					/// Must be called from the strand, with no write pending.
+					/// </summary>
+					void EndResponse()
+					{
+						m_session.EndResponse();
+
+						Flush();
+						Service();
+					}
+
+					/// <summary>
+					/// Gets whether the connection can still carry requests, which is as long as
+					/// the client is there and the session isn't over. Must be called from the
+					/// strand.
+					/// </summary>
+					const bool IsOpen() const
+					{
+						return !m_socketFailed && !m_session.IsClosed();
+					}
+
+				private:
+
+					/// <summary>
+					/// Gets the first non-empty buffer of a sequence, which is all a single read
+					/// ever fills, just the same as with a socket.
+					/// </summary>
+					template<typename BufferType, typename BufferSequence>
+					static BufferType FirstBuffer(const BufferSequence& buffers)
+					{
+						for (auto it = buffers.begin(); it != buffers.end(); ++it)
+						{
+							BufferType buffer(*it);
+
+							if (boost::asio::buffer_size(buffer) > 0)
+							{
+								return buffer;
+							}
+						}
+
+						return BufferType();
+					}
+
+					/// <summary>
+					/// Reads whatever the client sends next.
+					/// </summary>
+					void Read()
+					{
+						auto self(this->shared_from_this());
+						auto owner = m_owner.lock();
+
+						if (owner == nullptr)
+						{
+							return;
+						}
+
+						m_socket.async_read_some(
+							boost::asio::buffer(m_receiveBuffer),
+							m_strand.wrap(
+								[this, self, owner](const boost::system::error_code& error, const size_t bytesTransferred)
+								{
+									OnRead(error, bytesTransferred);
+								}
+								)
+							);
+					}
+
+					void OnRead(const boost::system::error_code& error, const size_t bytesTransferred)
+					{
+						if (error)
+						{
+							m_socketFailed = true;
+							Service();
+							return;
+						}
+
+						if (!m_session.Receive(m_receiveBuffer.data(), bytesTransferred))
+						{
+							std::string errMessage(u8"In Http2Connection<SocketType>::OnRead(const boost::system::error_code&, const size_t) - Closing session:\t");
+							errMessage.append(m_session.GetError());
+							ReportWarning(errMessage);
+						}
+
+						Flush();
+						Service();
+
+						if (!m_session.IsClosed())
+						{
+							Read();
+						}
+					}
+
+					/// <summary>
+					/// Sends whatever the session has for the client, unless a send is already
+					/// underway, in which case it'll be sent once that one is done.
+					/// </summary>
+					void Flush()
+					{
+						if (m_sending || m_socketFailed || m_session.GetOutputSize() == 0)
+						{
+							return;
+						}
+
+						auto self(this->shared_from_this());
+						auto owner = m_owner.lock();
+
+						if (owner == nullptr)
+						{
+							return;
+						}
+
+						m_sendBuffer.clear();
+						m_session.TakeOutput(m_sendBuffer);
+
+						m_sending = true;
+
+						boost::asio::async_write(
+							m_socket,
+							boost::asio::buffer(m_sendBuffer),
+							boost::asio::transfer_all(),
+							m_strand.wrap(
+								[this, self, owner](const boost::system::error_code& error, const size_t)
+								{
+									m_sending = false;
+
+									if (error)
+									{
+										m_socketFailed = true;
+									}
+
+									Flush();
+									Service();
+								}
+								)
+							);
+					}
+
+					/// <summary>
+					/// Completes whichever of the pending read and write of the bridge can be
+					/// completed by now.
+					/// </summary>
+					void Service()
+					{
+						if (m_readHandler)
+						{
+							const size_t read = m_socketFailed ? 0 : m_session.ReadRequest(boost::asio::buffer_cast<char*>(m_readBuffer), boost::asio::buffer_size(m_readBuffer));
+
+							if (read > 0)
+							{
+								// Reading may have opened a window.
+								Flush();
+								Complete(m_readHandler, boost::system::error_code(), read);
+							}
+							else if (m_session.IsRequestAborted())
+							{
+								Complete(m_readHandler, boost::asio::error::connection_reset, 0);
+							}
+							else if (m_socketFailed || (m_session.IsClosed() && !m_sending))
+							{
+								// Either way, there are no more requests coming.
+								Complete(m_readHandler, boost::asio::error::eof, 0);
+							}
+						}
+
+						if (m_writeHandler)
+						{
+							if (m_socketFailed || m_session.IsClosed())
+							{
+								Complete(m_writeHandler, boost::asio::error::connection_reset, 0);
+							}
+							else if (m_session.IsResponseDrained() && m_session.GetOutputSize() + (m_sending ? m_sendBuffer.size() : 0) < MaxBufferedOutput)
+							{
+								Complete(m_writeHandler, boost::system::error_code(), m_writeSize);
+							}
+						}
+					}
+
+					/// <summary>
+					/// Completes a pending operation. The handler is cleared before it's posted,
+					/// so that the bridge may start another operation right away.
+					/// </summary>
+					static void Complete(std::function<void(const boost::system::error_code&, const size_t)>& pending, const boost::system::error_code& error, const size_t bytesTransferred)
+					{
+						auto handler = std::move(pending);
+						pending = nullptr;
+						handler(error, bytesTransferred);
+					}
+
+					SocketType& m_socket;
+
+					network::OptionalStrand& m_strand;
+
+					std::weak_ptr<void> m_owner;
+
+					Http2Session m_session;
+
+					/// <summary>
+					/// What is read from the client goes here, and straight into the session.
+					/// </summary>
+					std::array<char, 16384> m_receiveBuffer;
+
+					/// <summary>
+					/// The output of the session on its way to the client.
+					/// </summary>
+					std::string m_sendBuffer;
+
+					bool m_sending = false;
+
+					/// <summary>
+					/// Set once reading from or writing to the socket has failed, which is how we
+					/// learn that the client is gone, or that the bridge closed the socket.
+					/// </summary>
+					bool m_socketFailed = false;
+
+					/// <summary>
+					/// The read of the bridge, if one is pending, and the buffer it's for.
+					/// </summary>
+					std::function<void(const boost::system::error_code&, const size_t)> m_readHandler;
+
+					boost::asio::mutable_buffer m_readBuffer;
+
+					/// <summary>
+					/// The write of the bridge, if one is pending, and how much it wrote.
+					/// </summary>
+					std::function<void(const boost::system::error_code&, const size_t)> m_writeHandler;
+
+					size_t m_writeSize = 0;
+
+				};
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
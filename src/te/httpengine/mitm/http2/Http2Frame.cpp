@@ -0,0 +1,141 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "Http2Frame.hpp"
+
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				namespace
+				{
+					inline void AppendUInt16(std::string& out, const uint16_t value)
+					{
+						out.push_back(static_cast<char>((value >> 8) & 0xff));
+						out.push_back(static_cast<char>(value & 0xff));
+					}
+
+					inline void AppendUInt32(std::string& out, const uint32_t value)
+					{
+						out.push_back(static_cast<char>((value >> 24) & 0xff));
+						out.push_back(static_cast<char>((value >> 16) & 0xff));
+						out.push_back(static_cast<char>((value >> 8) & 0xff));
+						out.push_back(static_cast<char>(value & 0xff));
+					}
+				}
+
+				const char ConnectionPreface[ConnectionPrefaceLength] = { 'P', 'R', 'I', ' ', '*', ' ', 'H', 'T', 'T', 'P', '/', '2', '.', '0', '\r', '\n', '\r', '\n', 'S', 'M', '\r', '\n', '\r', '\n' };
+
+				const FrameHeader ReadFrameHeader(const char* data)
+				{
+					const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+					FrameHeader header;
+
+					header.Length = (static_cast<uint32_t>(bytes[0]) << 16) | (static_cast<uint32_t>(bytes[1]) << 8) | static_cast<uint32_t>(bytes[2]);
+					header.Type = bytes[3];
+					header.Flags = bytes[4];
+					header.StreamId = ReadUInt32(data + 5) & 0x7fffffff;
+
+					return header;
+				}
+
+				void AppendFrameHeader(std::string& out, const uint32_t length, const FrameType type, const uint8_t flags, const uint32_t streamId)
+				{
+					out.push_back(static_cast<char>((length >> 16) & 0xff));
+					out.push_back(static_cast<char>((length >> 8) & 0xff));
+					out.push_back(static_cast<char>(length & 0xff));
+					out.push_back(static_cast<char>(type));
+					out.push_back(static_cast<char>(flags));
+					AppendUInt32(out, streamId & 0x7fffffff);
+				}
+
+				void AppendSettings(std::string& out, const std::vector<std::pair<SettingsId, uint32_t>>& settings)
+				{
+					AppendFrameHeader(out, static_cast<uint32_t>(settings.size() * 6), FrameType::Settings, 0, 0);
+
+					for (const auto& setting : settings)
+					{
+						AppendUInt16(out, static_cast<uint16_t>(setting.first));
+						AppendUInt32(out, setting.second);
+					}
+				}
+
+				void AppendSettingsAck(std::string& out)
+				{
+					AppendFrameHeader(out, 0, FrameType::Settings, FrameFlags::Ack, 0);
+				}
+
+				void AppendPingAck(std::string& out, const char* opaque)
+				{
+					AppendFrameHeader(out, 8, FrameType::Ping, FrameFlags::Ack, 0);
+					out.append(opaque, 8);
+				}
+
+				void AppendGoAway(std::string& out, const uint32_t lastStreamId, const ErrorCode error)
+				{
+					AppendFrameHeader(out, 8, FrameType::GoAway, 0, 0);
+					AppendUInt32(out, lastStreamId & 0x7fffffff);
+					AppendUInt32(out, static_cast<uint32_t>(error));
+				}
+
+				void AppendRstStream(std::string& out, const uint32_t streamId, const ErrorCode error)
+				{
+					AppendFrameHeader(out, 4, FrameType::RstStream, 0, streamId);
+					AppendUInt32(out, static_cast<uint32_t>(error));
+				}
+
+				void AppendWindowUpdate(std::string& out, const uint32_t streamId, const uint32_t increment)
+				{
+					AppendFrameHeader(out, 4, FrameType::WindowUpdate, 0, streamId);
+					AppendUInt32(out, increment & 0x7fffffff);
+				}
+
+				void AppendData(std::string& out, const uint32_t streamId, const char* data, const size_t length, const bool endStream)
+				{
+					AppendFrameHeader(out, static_cast<uint32_t>(length), FrameType::Data, endStream ? FrameFlags::EndStream : 0, streamId);
+					out.append(data, length);
+				}
+
+				void AppendHeaders(std::string& out, const uint32_t streamId, const std::string& block, const bool endStream, const uint32_t maxFrameSize)
+				{
+					size_t position = 0;
+					bool first = true;
+
+					// An empty block still takes its one HEADERS frame.
+					do
+					{
+						const size_t length = (std::min)(block.size() - position, static_cast<size_t>(maxFrameSize));
+						const bool last = position + length == block.size();
+
+						uint8_t flags = last ? FrameFlags::EndHeaders : 0;
+
+						if (first && endStream)
+						{
+							// END_STREAM goes on the HEADERS frame, even when CONTINUATION frames follow.
+							flags |= FrameFlags::EndStream;
+						}
+
+						AppendFrameHeader(out, static_cast<uint32_t>(length), first ? FrameType::Headers : FrameType::Continuation, flags, streamId);
+						out.append(block, position, length);
+
+						position += length;
+						first = false;
+					} while (position < block.size());
+				}
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,231 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				/// <summary>
+				/// The length of the header every frame starts with, as per RFC 7540 section 4.1.
+				/// </summary>
+				static constexpr size_t FrameHeaderLength = 9;
+
+				/// <summary>
+				/// The length of the connection preface every client starts with, as per RFC 7540
+				/// section 3.5.
+				/// </summary>
+				static constexpr size_t ConnectionPrefaceLength = 24;
+
+				/// <summary>
+				/// The connection preface, "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n".
+				/// </summary>
+				extern const char ConnectionPreface[ConnectionPrefaceLength];
+
+				/// <summary>
+				/// The largest frame payload either end has to accept, until told otherwise.
+				/// </summary>
+				static constexpr uint32_t DefaultMaxFrameSize = 16384;
+
+				/// <summary>
+				/// The largest frame payload either end may ever allow.
+				/// </summary>
+				static constexpr uint32_t MaxAllowedFrameSize = 16777215;
+
+				/// <summary>
+				/// The flow control window every stream and the connection start with.
+				/// </summary>
+				static constexpr int64_t DefaultWindowSize = 65535;
+
+				/// <summary>
+				/// The largest a flow control window may ever grow to.
+				/// </summary>
+				static constexpr int64_t MaxWindowSize = 2147483647;
+
+				/// <summary>
+				/// Frame types, as per RFC 7540 section 6.
+				/// </summary>
+				enum class FrameType : uint8_t
+				{
+					Data = 0x0,
+					Headers = 0x1,
+					Priority = 0x2,
+					RstStream = 0x3,
+					Settings = 0x4,
+					PushPromise = 0x5,
+					Ping = 0x6,
+					GoAway = 0x7,
+					WindowUpdate = 0x8,
+					Continuation = 0x9
+				};
+
+				/// <summary>
+				/// Frame flags. Which of them apply depends on the type of the frame.
+				/// </summary>
+				struct FrameFlags
+				{
+					static constexpr uint8_t EndStream = 0x1;
+					static constexpr uint8_t Ack = 0x1;
+					static constexpr uint8_t EndHeaders = 0x4;
+					static constexpr uint8_t Padded = 0x8;
+					static constexpr uint8_t Priority = 0x20;
+				};
+
+				/// <summary>
+				/// Error codes carried by RST_STREAM and GOAWAY frames, as per RFC 7540 section 7.
+				/// </summary>
+				enum class ErrorCode : uint32_t
+				{
+					NoError = 0x0,
+					ProtocolError = 0x1,
+					InternalError = 0x2,
+					FlowControlError = 0x3,
+					SettingsTimeout = 0x4,
+					StreamClosed = 0x5,
+					FrameSizeError = 0x6,
+					RefusedStream = 0x7,
+					Cancel = 0x8,
+					CompressionError = 0x9,
+					ConnectError = 0xa,
+					EnhanceYourCalm = 0xb,
+					InadequateSecurity = 0xc,
+					Http11Required = 0xd
+				};
+
+				/// <summary>
+				/// Settings identifiers, as per RFC 7540 section 6.5.2.
+				/// </summary>
+				enum class SettingsId : uint16_t
+				{
+					HeaderTableSize = 0x1,
+					EnablePush = 0x2,
+					MaxConcurrentStreams = 0x3,
+					InitialWindowSize = 0x4,
+					MaxFrameSize = 0x5,
+					MaxHeaderListSize = 0x6
+				};
+
+				/// <summary>
+				/// The header of a frame.
+				/// </summary>
+				struct FrameHeader
+				{
+					/// <summary>
+					/// The length of the payload that follows the header.
+					/// </summary>
+					uint32_t Length = 0;
+
+					/// <summary>
+					/// The type of the frame. Kept as it was received, since frames of unknown
+					/// types must be ignored rather than rejected.
+					/// </summary>
+					uint8_t Type = 0;
+
+					uint8_t Flags = 0;
+
+					/// <summary>
+					/// The stream the frame belongs to, with the reserved bit cleared. Zero for
+					/// frames that apply to the connection as a whole.
+					/// </summary>
+					uint32_t StreamId = 0;
+				};
+
+				/// <summary>
+				/// Reads a big-endian 32 bit number.
+				/// </summary>
+				inline const uint32_t ReadUInt32(const char* data)
+				{
+					const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+					return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+				}
+
+				/// <summary>
+				/// Reads the header of a frame.
+				/// </summary>
+				/// <param name="data">
+				/// Points to at least FrameHeaderLength bytes.
+				/// </param>
+				/// <returns>
+				/// The frame header.
+				/// </returns>
+				const FrameHeader ReadFrameHeader(const char* data);
+
+				/// <summary>
+				/// Appends the header of a frame to the supplied buffer.
+				/// </summary>
+				void AppendFrameHeader(std::string& out, const uint32_t length, const FrameType type, const uint8_t flags, const uint32_t streamId);
+
+				/// <summary>
+				/// Appends a SETTINGS frame holding the supplied settings to the supplied buffer.
+				/// </summary>
+				void AppendSettings(std::string& out, const std::vector<std::pair<SettingsId, uint32_t>>& settings);
+
+				/// <summary>
+				/// Appends a SETTINGS frame with the ACK flag to the supplied buffer.
+				/// </summary>
+				void AppendSettingsAck(std::string& out);
+
+				/// <summary>
+				/// Appends the answer to a PING frame to the supplied buffer.
+				/// </summary>
+				/// <param name="opaque">
+				/// The eight bytes of the PING being answered.
+				/// </param>
+				void AppendPingAck(std::string& out, const char* opaque);
+
+				/// <summary>
+				/// Appends a GOAWAY frame to the supplied buffer.
+				/// </summary>
+				/// <param name="lastStreamId">
+				/// The highest numbered stream that was or may still be processed. Every stream
+				/// above it may safely be retried by the client on a new connection.
+				/// </param>
+				void AppendGoAway(std::string& out, const uint32_t lastStreamId, const ErrorCode error);
+
+				/// <summary>
+				/// Appends a RST_STREAM frame to the supplied buffer.
+				/// </summary>
+				void AppendRstStream(std::string& out, const uint32_t streamId, const ErrorCode error);
+
+				/// <summary>
+				/// Appends a WINDOW_UPDATE frame to the supplied buffer.
+				/// </summary>
+				/// <param name="increment">
+				/// The number of bytes the window grows by. Must be between 1 and MaxWindowSize.
+				/// </param>
+				void AppendWindowUpdate(std::string& out, const uint32_t streamId, const uint32_t increment);
+
+				/// <summary>
+				/// Appends a single DATA frame to the supplied buffer. The caller is responsible for
+				/// keeping the length within both the frame size and the flow control windows.
+				/// </summary>
+				void AppendData(std::string& out, const uint32_t streamId, const char* data, const size_t length, const bool endStream);
+
+				/// <summary>
+				/// Appends a header block to the supplied buffer, as a HEADERS frame followed by as
+				/// many CONTINUATION frames as it takes to keep every frame within the supplied
+				/// maximum frame size.
+				/// </summary>
+				void AppendHeaders(std::string& out, const uint32_t streamId, const std::string& block, const bool endStream, const uint32_t maxFrameSize);
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,1560 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "Http2Session.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				namespace
+				{
+					inline const char ToLower(const char c)
+					{
+						return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+					}
+
+					inline const bool EqualsIgnoreCase(const std::string& a, const std::string& b)
+					{
+						if (a.size() != b.size())
+						{
+							return false;
+						}
+
+						for (size_t i = 0; i < a.size(); ++i)
+						{
+							if (ToLower(a[i]) != ToLower(b[i]))
+							{
+								return false;
+							}
+						}
+
+						return true;
+					}
+
+					/// <summary>
+					/// Whether the supplied character may be in a header name or method, as per
+					/// RFC 7230 section 3.2.6. Upper case letters are left out, because header
+					/// names must be lower case in HTTP/2.
+					/// </summary>
+					inline const bool IsTokenChar(const char c, const bool allowUpper)
+					{
+						if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+						{
+							return true;
+						}
+
+						if (c >= 'A' && c <= 'Z')
+						{
+							return allowUpper;
+						}
+
+						return std::strchr("!#$%&'*+-.^_`|~", c) != nullptr && c != '\0';
+					}
+
+					inline const bool IsToken(const std::string& value, const bool allowUpper)
+					{
+						if (value.empty())
+						{
+							return false;
+						}
+
+						for (const char c : value)
+						{
+							if (!IsTokenChar(c, allowUpper))
+							{
+								return false;
+							}
+						}
+
+						return true;
+					}
+
+					/// <summary>
+					/// Whether the supplied header value can go into an HTTP/1.1 request as it is.
+					/// Anything that could end the header early is refused.
+					/// </summary>
+					inline const bool IsFieldValue(const std::string& value)
+					{
+						for (const char c : value)
+						{
+							if (c == '\r' || c == '\n' || c == '\0')
+							{
+								return false;
+							}
+						}
+
+						return true;
+					}
+
+					/// <summary>
+					/// Whether the supplied value can go into an HTTP/1.1 request line or Host
+					/// header as it is, which leaves no room for white space or control
+					/// characters.
+					/// </summary>
+					inline const bool IsVisible(const std::string& value)
+					{
+						for (const char c : value)
+						{
+							const unsigned char u = static_cast<unsigned char>(c);
+
+							if (u <= 0x20 || u == 0x7f)
+							{
+								return false;
+							}
+						}
+
+						return true;
+					}
+
+					inline const bool ParseContentLength(const std::string& value, uint64_t& length)
+					{
+						if (value.empty() || value.size() > 18)
+						{
+							return false;
+						}
+
+						length = 0;
+
+						for (const char c : value)
+						{
+							if (c < '0' || c > '9')
+							{
+								return false;
+							}
+
+							length = (length * 10) + static_cast<uint64_t>(c - '0');
+						}
+
+						return true;
+					}
+
+					/// <summary>
+					/// Whether the supplied, lower case header is specific to the connection it
+					/// was sent over, and so has no place in HTTP/2, as per RFC 7540 section
+					/// 8.1.2.2.
+					/// </summary>
+					inline const bool IsConnectionSpecific(const std::string& name)
+					{
+						return name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" || name == "upgrade";
+					}
+
+					/// <summary>
+					/// Whether the supplied, lower case header is named in the supplied value of a
+					/// Connection header.
+					/// </summary>
+					inline const bool IsConnectionToken(const std::string& name, const std::string& connection)
+					{
+						size_t position = 0;
+
+						while (position < connection.size())
+						{
+							size_t end = connection.find(',', position);
+
+							if (end == std::string::npos)
+							{
+								end = connection.size();
+							}
+
+							size_t first = position;
+							size_t last = end;
+
+							while (first < last && (connection[first] == ' ' || connection[first] == '\t'))
+							{
+								++first;
+							}
+
+							while (last > first && (connection[last - 1] == ' ' || connection[last - 1] == '\t'))
+							{
+								--last;
+							}
+
+							if (EqualsIgnoreCase(name, connection.substr(first, last - first)))
+							{
+								return true;
+							}
+
+							position = end + 1;
+						}
+
+						return false;
+					}
+				}
+
+				struct Http2Session::Stream
+				{
+					uint32_t Id = 0;
+
+					/// <summary>
+					/// The part of the HTTP/1.1 request that has yet to be read.
+					/// </summary>
+					std::string Request;
+
+					/// <summary>
+					/// Whether the client is done sending the request.
+					/// </summary>
+					bool RequestComplete = false;
+
+					/// <summary>
+					/// Whether the body is passed on chunked, because the client didn't say how
+					/// long it is.
+					/// </summary>
+					bool Chunked = false;
+
+					bool HasContentLength = false;
+
+					uint64_t ContentLength = 0;
+
+					uint64_t BodyReceived = 0;
+
+					/// <summary>
+					/// Whether the request is a HEAD request, the response to which has no
+					/// body, whatever its headers say.
+					/// </summary>
+					bool Head = false;
+
+					/// <summary>
+					/// Whether the stream has been reset, by either end, after the bridge had
+					/// started reading it.
+					/// </summary>
+					bool Reset = false;
+
+					/// <summary>
+					/// Whether the request was reset before all of it was read.
+					/// </summary>
+					bool Aborted = false;
+
+					int64_t SendWindow = DefaultWindowSize;
+
+					int64_t ReceiveWindow = DefaultWindowSize;
+
+					/// <summary>
+					/// How much has been received on the stream without the window being opened
+					/// up for it again. The window is opened once the bridge has read it all,
+					/// so a client can't have more than a window of a request buffered with us.
+					/// </summary>
+					uint32_t ReceivedUnacknowledged = 0;
+				};
+
+				Http2Session::Http2Session(const std::string& host)
+					:
+					m_host(host),
+					m_decoder(DefaultHeaderTableSize, MaxHeaderListSize)
+				{
+					std::memset(&m_responseParserSettings, 0, sizeof(m_responseParserSettings));
+
+					m_responseParserSettings.on_header_field = &OnResponseHeaderField;
+					m_responseParserSettings.on_header_value = &OnResponseHeaderValue;
+					m_responseParserSettings.on_headers_complete = &OnResponseHeadersComplete;
+					m_responseParserSettings.on_body = &OnResponseBody;
+					m_responseParserSettings.on_message_complete = &OnResponseMessageComplete;
+
+					http_parser_init(&m_responseParser, HTTP_RESPONSE);
+					m_responseParser.data = this;
+
+					AppendSettings(m_output, {
+						{ SettingsId::MaxConcurrentStreams, MaxConcurrentStreams },
+						{ SettingsId::MaxHeaderListSize, MaxHeaderListSize }
+					});
+				}
+
+				Http2Session::~Http2Session()
+				{
+
+				}
+
+				const bool Http2Session::Receive(const char* data, const size_t length)
+				{
+					if (m_closed)
+					{
+						return false;
+					}
+
+					m_input.append(data, length);
+
+					size_t position = 0;
+
+					if (!m_prefaceReceived)
+					{
+						const size_t compared = (std::min)(m_input.size(), ConnectionPrefaceLength);
+
+						if (std::memcmp(m_input.data(), ConnectionPreface, compared) != 0)
+						{
+							m_input.clear();
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::Receive(const char*, const size_t) - Client did not send the connection preface.");
+						}
+
+						if (m_input.size() < ConnectionPrefaceLength)
+						{
+							return true;
+						}
+
+						position = ConnectionPrefaceLength;
+						m_prefaceReceived = true;
+					}
+
+					while (m_input.size() - position >= FrameHeaderLength)
+					{
+						const FrameHeader header = ReadFrameHeader(m_input.data() + position);
+
+						if (header.Length > DefaultMaxFrameSize)
+						{
+							m_input.clear();
+							return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::Receive(const char*, const size_t) - Client sent a frame larger than we allow.");
+						}
+
+						if (m_input.size() - position - FrameHeaderLength < header.Length)
+						{
+							break;
+						}
+
+						if (!OnFrame(header, m_input.data() + position + FrameHeaderLength))
+						{
+							m_input.clear();
+							return false;
+						}
+
+						position += FrameHeaderLength + header.Length;
+					}
+
+					m_input.erase(0, position);
+
+					return true;
+				}
+
+				void Http2Session::TakeOutput(std::string& out)
+				{
+					if (out.empty())
+					{
+						out.swap(m_output);
+					}
+					else
+					{
+						out.append(m_output);
+					}
+
+					m_output.clear();
+				}
+
+				const size_t Http2Session::ReadRequest(char* out, const size_t length)
+				{
+					if (m_streams.empty())
+					{
+						return 0;
+					}
+
+					Stream& stream = *m_streams.front();
+
+					if (stream.Aborted)
+					{
+						return 0;
+					}
+
+					const size_t read = (std::min)(length, stream.Request.size());
+
+					if (read == 0)
+					{
+						return 0;
+					}
+
+					std::memcpy(out, stream.Request.data(), read);
+					stream.Request.erase(0, read);
+
+					m_reading = true;
+
+					if (stream.Request.empty() && !stream.RequestComplete && stream.ReceivedUnacknowledged > 0)
+					{
+						// Everything the client sent has been picked up, so it may send more.
+						AppendWindowUpdate(m_output, stream.Id, stream.ReceivedUnacknowledged);
+						stream.ReceiveWindow += stream.ReceivedUnacknowledged;
+						stream.ReceivedUnacknowledged = 0;
+					}
+
+					return read;
+				}
+
+				const bool Http2Session::IsRequestAborted() const
+				{
+					return m_reading && !m_streams.empty() && m_streams.front()->Aborted;
+				}
+
+				const bool Http2Session::WriteResponse(const char* data, const size_t length)
+				{
+					if (!m_reading || m_streams.empty() || m_streams.front()->Reset || m_responseFailed)
+					{
+						return false;
+					}
+
+					if (m_responseComplete || length == 0)
+					{
+						// Whatever follows the end of the response isn't ours to pass on.
+						return true;
+					}
+
+					http_parser_execute(&m_responseParser, &m_responseParserSettings, data, length);
+
+					const auto parseError = HTTP_PARSER_ERRNO(&m_responseParser);
+
+					if (parseError != HPE_OK && parseError != HPE_PAUSED)
+					{
+						ResetResponse(ErrorCode::InternalError);
+						return false;
+					}
+
+					if (m_responseHeadersPending)
+					{
+						// There's no telling yet whether a body follows, but the headers
+						// shouldn't wait for it.
+						SendResponseHeaders(false);
+					}
+
+					Pump();
+
+					return true;
+				}
+
+				const bool Http2Session::IsResponseDrained() const
+				{
+					return m_responseBacklog.empty();
+				}
+
+				void Http2Session::EndResponse()
+				{
+					if (!m_reading || m_streams.empty())
+					{
+						return;
+					}
+
+					Stream& stream = *m_streams.front();
+
+					if (!stream.Reset && !m_responseFailed)
+					{
+						if (!m_responseComplete)
+						{
+							// The end of the data is the end of a response that has no length.
+							http_parser_execute(&m_responseParser, &m_responseParserSettings, nullptr, 0);
+
+							Pump();
+						}
+
+						if (!m_responseComplete || !m_responseBacklog.empty())
+						{
+							ResetResponse(ErrorCode::InternalError);
+						}
+						else if (!stream.RequestComplete)
+						{
+							// The response is all there is, so the rest of the request isn't
+							// wanted, as per RFC 7540 section 8.1.
+							AppendRstStream(m_output, stream.Id, ErrorCode::NoError);
+						}
+					}
+
+					m_streams.pop_front();
+					m_reading = false;
+
+					http_parser_init(&m_responseParser, HTTP_RESPONSE);
+					m_responseParser.data = this;
+
+					m_responseHeaders.clear();
+					m_responseHeaderName.clear();
+					m_responseHeaderValue.clear();
+					m_responseBlock.clear();
+					m_responseBacklog.clear();
+					m_responseInValue = false;
+					m_responseHeadersPending = false;
+					m_responseComplete = false;
+					m_responseFailed = false;
+					m_responseEndPending = false;
+				}
+
+				const bool Http2Session::OnFrame(const FrameHeader& header, const char* payload)
+				{
+					if (!m_settingsReceived && (header.Type != static_cast<uint8_t>(FrameType::Settings) || (header.Flags & FrameFlags::Ack) != 0))
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnFrame(const FrameHeader&, const char*) - Client preface was not followed by SETTINGS.");
+					}
+
+					if (m_headerBlockStreamId != 0 && (header.Type != static_cast<uint8_t>(FrameType::Continuation) || header.StreamId != m_headerBlockStreamId))
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnFrame(const FrameHeader&, const char*) - Header block was interrupted.");
+					}
+
+					switch (static_cast<FrameType>(header.Type))
+					{
+						case FrameType::Data:
+							return OnData(header, payload);
+
+						case FrameType::Headers:
+							return OnHeaders(header, payload);
+
+						case FrameType::Priority:
+							return OnPriority(header, payload);
+
+						case FrameType::RstStream:
+							return OnRstStream(header, payload);
+
+						case FrameType::Settings:
+							return OnSettings(header, payload);
+
+						case FrameType::PushPromise:
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnFrame(const FrameHeader&, const char*) - Client sent PUSH_PROMISE.");
+
+						case FrameType::Ping:
+							return OnPing(header, payload);
+
+						case FrameType::GoAway:
+							return OnGoAway(header, payload);
+
+						case FrameType::WindowUpdate:
+							return OnWindowUpdate(header, payload);
+
+						case FrameType::Continuation:
+							return OnContinuation(header, payload);
+					}
+
+					// Frames of unknown types must be ignored, as per RFC 7540 section 4.1.
+					return true;
+				}
+
+				const bool Http2Session::OnData(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId == 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnData(const FrameHeader&, const char*) - DATA on stream zero.");
+					}
+
+					size_t offset = 0;
+					size_t length = header.Length;
+
+					if ((header.Flags & FrameFlags::Padded) != 0)
+					{
+						const size_t padding = length > 0 ? static_cast<unsigned char>(payload[0]) : 0;
+
+						if (length == 0 || padding >= length)
+						{
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnData(const FrameHeader&, const char*) - Padding exceeds the frame.");
+						}
+
+						offset = 1;
+						length -= 1 + padding;
+					}
+
+					// The whole frame counts against the connection window, and the connection
+					// never holds on to anything, so it's opened right back up.
+					m_connectionReceiveWindow -= header.Length;
+
+					if (m_connectionReceiveWindow < 0)
+					{
+						return Fail(ErrorCode::FlowControlError, u8"In Http2Session::OnData(const FrameHeader&, const char*) - Client overran the connection window.");
+					}
+
+					if (header.Length > 0)
+					{
+						AppendWindowUpdate(m_output, 0, header.Length);
+						m_connectionReceiveWindow += header.Length;
+					}
+
+					Stream* stream = FindStream(header.StreamId);
+
+					if (stream == nullptr || stream->RequestComplete || stream->Aborted)
+					{
+						if (header.StreamId > m_lastStreamId)
+						{
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnData(const FrameHeader&, const char*) - DATA on an idle stream.");
+						}
+
+						// A stream we've already answered or reset. Nothing left to do with it.
+						return true;
+					}
+
+					stream->ReceiveWindow -= header.Length;
+
+					if (stream->ReceiveWindow < 0)
+					{
+						AbortStream(*stream, ErrorCode::FlowControlError, true);
+						return true;
+					}
+
+					stream->ReceivedUnacknowledged += header.Length;
+					stream->BodyReceived += length;
+
+					if (stream->HasContentLength && stream->BodyReceived > stream->ContentLength)
+					{
+						AbortStream(*stream, ErrorCode::ProtocolError, true);
+						return true;
+					}
+
+					if (length > 0)
+					{
+						if (stream->Chunked)
+						{
+							char chunkSize[24];
+							const int chunkSizeLength = std::snprintf(chunkSize, sizeof(chunkSize), "%zx\r\n", length);
+
+							stream->Request.append(chunkSize, static_cast<size_t>(chunkSizeLength));
+							stream->Request.append(payload + offset, length);
+							stream->Request.append("\r\n", 2);
+						}
+						else
+						{
+							stream->Request.append(payload + offset, length);
+						}
+					}
+
+					if ((header.Flags & FrameFlags::EndStream) != 0)
+					{
+						FinishRequest(*stream);
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::OnHeaders(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId == 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnHeaders(const FrameHeader&, const char*) - HEADERS on stream zero.");
+					}
+
+					size_t offset = 0;
+					size_t padding = 0;
+
+					if ((header.Flags & FrameFlags::Padded) != 0)
+					{
+						if (header.Length < 1)
+						{
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnHeaders(const FrameHeader&, const char*) - Padded HEADERS without padding.");
+						}
+
+						padding = static_cast<unsigned char>(payload[0]);
+						offset = 1;
+					}
+
+					if ((header.Flags & FrameFlags::Priority) != 0)
+					{
+						// Only one stream is ever served at a time, so priorities mean nothing to us.
+						offset += 5;
+					}
+
+					if (offset + padding > header.Length)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnHeaders(const FrameHeader&, const char*) - Padding exceeds the frame.");
+					}
+
+					m_headerBlock.assign(payload + offset, header.Length - offset - padding);
+					m_headerBlockEndStream = (header.Flags & FrameFlags::EndStream) != 0;
+
+					if ((header.Flags & FrameFlags::EndHeaders) != 0)
+					{
+						return OnHeaderBlock(header.StreamId, m_headerBlockEndStream);
+					}
+
+					m_headerBlockStreamId = header.StreamId;
+
+					return true;
+				}
+
+				const bool Http2Session::OnContinuation(const FrameHeader& header, const char* payload)
+				{
+					if (m_headerBlockStreamId == 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnContinuation(const FrameHeader&, const char*) - CONTINUATION without a header block.");
+					}
+
+					if (m_headerBlock.size() + header.Length > 4 * static_cast<size_t>(MaxHeaderListSize))
+					{
+						// Even Huffman coded at its worst, a block this large holds more than we'd
+						// ever accept.
+						return Fail(ErrorCode::EnhanceYourCalm, u8"In Http2Session::OnContinuation(const FrameHeader&, const char*) - Header block is too large.");
+					}
+
+					m_headerBlock.append(payload, header.Length);
+
+					if ((header.Flags & FrameFlags::EndHeaders) != 0)
+					{
+						const uint32_t streamId = m_headerBlockStreamId;
+
+						m_headerBlockStreamId = 0;
+
+						return OnHeaderBlock(streamId, m_headerBlockEndStream);
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::OnPriority(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId == 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnPriority(const FrameHeader&, const char*) - PRIORITY on stream zero.");
+					}
+
+					ErrorCode error = ErrorCode::NoError;
+
+					if (header.Length != 5)
+					{
+						error = ErrorCode::FrameSizeError;
+					}
+					else if ((ReadUInt32(payload) & 0x7FFFFFFF) == header.StreamId)
+					{
+						// We don't prioritize, but a stream that depends on itself is a stream
+						// error all the same, as per RFC 7540 section 5.3.1.
+						error = ErrorCode::ProtocolError;
+					}
+
+					if (error != ErrorCode::NoError)
+					{
+						Stream* stream = FindStream(header.StreamId);
+
+						if (stream != nullptr)
+						{
+							AbortStream(*stream, error, true);
+						}
+						else
+						{
+							AppendRstStream(m_output, header.StreamId, error);
+						}
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::OnRstStream(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId == 0 || header.StreamId > m_lastStreamId)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnRstStream(const FrameHeader&, const char*) - RST_STREAM on an idle stream.");
+					}
+
+					if (header.Length != 4)
+					{
+						return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnRstStream(const FrameHeader&, const char*) - RST_STREAM of the wrong size.");
+					}
+
+					Stream* stream = FindStream(header.StreamId);
+
+					if (stream != nullptr)
+					{
+						AbortStream(*stream, static_cast<ErrorCode>(ReadUInt32(payload)), false);
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::OnSettings(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId != 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - SETTINGS on a stream.");
+					}
+
+					if ((header.Flags & FrameFlags::Ack) != 0)
+					{
+						if (header.Length != 0)
+						{
+							return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - SETTINGS ACK with a payload.");
+						}
+
+						return true;
+					}
+
+					if (header.Length % 6 != 0)
+					{
+						return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - SETTINGS of the wrong size.");
+					}
+
+					for (size_t position = 0; position < header.Length; position += 6)
+					{
+						const unsigned char* setting = reinterpret_cast<const unsigned char*>(payload + position);
+						const uint16_t id = static_cast<uint16_t>((setting[0] << 8) | setting[1]);
+						const uint32_t value = ReadUInt32(payload + position + 2);
+
+						switch (static_cast<SettingsId>(id))
+						{
+							case SettingsId::EnablePush:
+							{
+								if (value > 1)
+								{
+									return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - Invalid SETTINGS_ENABLE_PUSH.");
+								}
+							}
+							break;
+
+							case SettingsId::InitialWindowSize:
+							{
+								if (value > MaxWindowSize)
+								{
+									return Fail(ErrorCode::FlowControlError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - Invalid SETTINGS_INITIAL_WINDOW_SIZE.");
+								}
+
+								// Applies to streams that are already open as well, as per RFC 7540
+								// section 6.9.2.
+								const int64_t delta = static_cast<int64_t>(value) - m_initialStreamSendWindow;
+
+								for (auto& stream : m_streams)
+								{
+									stream->SendWindow += delta;
+
+									if (stream->SendWindow > MaxWindowSize)
+									{
+										return Fail(ErrorCode::FlowControlError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - SETTINGS_INITIAL_WINDOW_SIZE overflows a stream window.");
+									}
+								}
+
+								m_initialStreamSendWindow = value;
+							}
+							break;
+
+							case SettingsId::MaxFrameSize:
+							{
+								if (value < DefaultMaxFrameSize || value > MaxAllowedFrameSize)
+								{
+									return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnSettings(const FrameHeader&, const char*) - Invalid SETTINGS_MAX_FRAME_SIZE.");
+								}
+
+								m_peerMaxFrameSize = value;
+							}
+							break;
+
+							default:
+							{
+								// The table size is for an encoder that never indexes anything, and
+								// the rest only limit what a client is sent, which is already only
+								// ever one stream at a time.
+							}
+							break;
+						}
+					}
+
+					m_settingsReceived = true;
+
+					AppendSettingsAck(m_output);
+
+					Pump();
+
+					return true;
+				}
+
+				const bool Http2Session::OnPing(const FrameHeader& header, const char* payload)
+				{
+					if (header.StreamId != 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnPing(const FrameHeader&, const char*) - PING on a stream.");
+					}
+
+					if (header.Length != 8)
+					{
+						return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnPing(const FrameHeader&, const char*) - PING of the wrong size.");
+					}
+
+					if ((header.Flags & FrameFlags::Ack) == 0)
+					{
+						AppendPingAck(m_output, payload);
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::OnGoAway(const FrameHeader& header, const char*)
+				{
+					if (header.StreamId != 0)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnGoAway(const FrameHeader&, const char*) - GOAWAY on a stream.");
+					}
+
+					if (header.Length < 8)
+					{
+						return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnGoAway(const FrameHeader&, const char*) - GOAWAY of the wrong size.");
+					}
+
+					// Whatever the client has open still gets answered. It just won't open any more.
+					// The last stream it names is of those we'd have pushed, and we push nothing.
+					m_goAwayReceived = true;
+
+					return true;
+				}
+
+				const bool Http2Session::OnWindowUpdate(const FrameHeader& header, const char* payload)
+				{
+					if (header.Length != 4)
+					{
+						return Fail(ErrorCode::FrameSizeError, u8"In Http2Session::OnWindowUpdate(const FrameHeader&, const char*) - WINDOW_UPDATE of the wrong size.");
+					}
+
+					const uint32_t increment = ReadUInt32(payload) & 0x7fffffff;
+
+					if (header.StreamId == 0)
+					{
+						if (increment == 0)
+						{
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnWindowUpdate(const FrameHeader&, const char*) - WINDOW_UPDATE of zero.");
+						}
+
+						m_connectionSendWindow += increment;
+
+						if (m_connectionSendWindow > MaxWindowSize)
+						{
+							return Fail(ErrorCode::FlowControlError, u8"In Http2Session::OnWindowUpdate(const FrameHeader&, const char*) - WINDOW_UPDATE overflows the connection window.");
+						}
+
+						Pump();
+
+						return true;
+					}
+
+					if (header.StreamId > m_lastStreamId)
+					{
+						return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnWindowUpdate(const FrameHeader&, const char*) - WINDOW_UPDATE on an idle stream.");
+					}
+
+					Stream* stream = FindStream(header.StreamId);
+
+					if (stream == nullptr)
+					{
+						return true;
+					}
+
+					if (increment == 0)
+					{
+						AbortStream(*stream, ErrorCode::ProtocolError, true);
+						return true;
+					}
+
+					stream->SendWindow += increment;
+
+					if (stream->SendWindow > MaxWindowSize)
+					{
+						AbortStream(*stream, ErrorCode::FlowControlError, true);
+						return true;
+					}
+
+					Pump();
+
+					return true;
+				}
+
+				const bool Http2Session::OnHeaderBlock(const uint32_t streamId, const bool endStream)
+				{
+					HeaderList headers;
+
+					// Decoded no matter what becomes of the stream, so that the dynamic table
+					// stays in step with that of the client.
+					if (!m_decoder.Decode(m_headerBlock.data(), m_headerBlock.size(), headers))
+					{
+						return Fail(ErrorCode::CompressionError, u8"In Http2Session::OnHeaderBlock(const uint32_t, const bool) - Failed to decode header block.");
+					}
+
+					m_headerBlock.clear();
+
+					if (streamId > m_lastStreamId)
+					{
+						if ((streamId & 1) == 0)
+						{
+							return Fail(ErrorCode::ProtocolError, u8"In Http2Session::OnHeaderBlock(const uint32_t, const bool) - Client opened an even numbered stream.");
+						}
+
+						m_lastStreamId = streamId;
+
+						if (m_goAwayReceived)
+						{
+							return true;
+						}
+
+						if (m_streams.size() >= MaxConcurrentStreams)
+						{
+							AppendRstStream(m_output, streamId, ErrorCode::RefusedStream);
+							return true;
+						}
+
+						std::unique_ptr<Stream> stream(new Stream());
+
+						stream->Id = streamId;
+						stream->SendWindow = m_initialStreamSendWindow;
+
+						const char* status = nullptr;
+
+						if (!BuildRequest(*stream, headers, endStream, status))
+						{
+							AppendRstStream(m_output, streamId, ErrorCode::ProtocolError);
+							return true;
+						}
+
+						if (status != nullptr)
+						{
+							Respond(streamId, status, endStream);
+							return true;
+						}
+
+						m_streams.push_back(std::move(stream));
+
+						return true;
+					}
+
+					Stream* stream = FindStream(streamId);
+
+					if (stream != nullptr && !stream->RequestComplete && !stream->Aborted)
+					{
+						// Trailers. HTTP/1.1 could carry them at the end of a chunked body, but
+						// nothing we'd pass them on to would look at them, so they're dropped.
+						if (!endStream)
+						{
+							AbortStream(*stream, ErrorCode::ProtocolError, true);
+							return true;
+						}
+
+						FinishRequest(*stream);
+					}
+
+					return true;
+				}
+
+				const bool Http2Session::BuildRequest(Stream& stream, const HeaderList& headers, const bool endStream, const char*& status)
+				{
+					std::string method;
+					std::string scheme;
+					std::string authority;
+					std::string path;
+
+					bool hasMethod = false;
+					bool hasScheme = false;
+					bool hasAuthority = false;
+					bool hasPath = false;
+					bool regularSeen = false;
+					bool expectContinue = false;
+
+					std::string host;
+					std::string cookies;
+					std::string fields;
+
+					for (const auto& header : headers)
+					{
+						const std::string& name = header.first;
+						const std::string& value = header.second;
+
+						if (!name.empty() && name[0] == ':')
+						{
+							// Pseudo-headers come first, once each, as per RFC 7540 section 8.1.2.1.
+							if (regularSeen)
+							{
+								return false;
+							}
+
+							std::string* target = nullptr;
+							bool* seen = nullptr;
+
+							if (name == ":method")
+							{
+								target = &method;
+								seen = &hasMethod;
+							}
+							else if (name == ":scheme")
+							{
+								target = &scheme;
+								seen = &hasScheme;
+							}
+							else if (name == ":authority")
+							{
+								target = &authority;
+								seen = &hasAuthority;
+							}
+							else if (name == ":path")
+							{
+								target = &path;
+								seen = &hasPath;
+							}
+
+							if (target == nullptr || *seen)
+							{
+								return false;
+							}
+
+							*target = value;
+							*seen = true;
+
+							continue;
+						}
+
+						regularSeen = true;
+
+						if (!IsToken(name, false) || !IsFieldValue(value) || IsConnectionSpecific(name))
+						{
+							return false;
+						}
+
+						if (name == "te")
+						{
+							if (value != "trailers")
+							{
+								return false;
+							}
+
+							// Trailers don't make it through us either way.
+							continue;
+						}
+
+						if (name == "host")
+						{
+							host = value;
+							continue;
+						}
+
+						if (name == "cookie")
+						{
+							// Cookies may be split up, but HTTP/1.1 wants them in one header, as per
+							// RFC 7540 section 8.1.2.5.
+							if (!cookies.empty())
+							{
+								cookies.append("; ");
+							}
+
+							cookies.append(value);
+							continue;
+						}
+
+						if (name == "content-length")
+						{
+							uint64_t contentLength = 0;
+
+							if (!ParseContentLength(value, contentLength) || (stream.HasContentLength && stream.ContentLength != contentLength))
+							{
+								return false;
+							}
+
+							stream.HasContentLength = true;
+							stream.ContentLength = contentLength;
+							continue;
+						}
+
+						if (name == "expect" && EqualsIgnoreCase(value, "100-continue"))
+						{
+							// Answered right here instead. Upstream, the bridge doesn't read
+							// anything before the whole request is written.
+							expectContinue = true;
+							continue;
+						}
+
+						fields.append(name);
+						fields.append(": ");
+						fields.append(value);
+						fields.append("\r\n");
+					}
+
+					if (!hasMethod || !IsToken(method, true))
+					{
+						return false;
+					}
+
+					if (method == "CONNECT")
+					{
+						// Tunnels are for proxies, which we don't pretend to clients to be.
+						status = "501";
+						return true;
+					}
+
+					if (!hasScheme || !hasPath || path.empty() || !IsVisible(path))
+					{
+						return false;
+					}
+
+					if (!hasAuthority || authority.empty())
+					{
+						authority = host;
+					}
+
+					if (authority.empty() || !IsVisible(authority))
+					{
+						return false;
+					}
+
+					size_t portIndex = authority[0] == '[' ? authority.find(']') : authority.find(':');
+
+					if (portIndex != std::string::npos && authority[0] == '[')
+					{
+						portIndex = authority.find(':', portIndex);
+					}
+
+					const std::string authorityHost = authority.substr(0, portIndex);
+					const std::string authorityPort = portIndex == std::string::npos ? std::string() : authority.substr(portIndex);
+
+					if (!EqualsIgnoreCase(authorityHost, m_host))
+					{
+						// The one upstream connection we have is to the SNI host, the same as it
+						// is for HTTP/1.1, only here the client can just try elsewhere, as per
+						// RFC 7540 section 9.1.2.
+						status = "421";
+						return true;
+					}
+
+					stream.Head = method == "HEAD";
+
+					std::string& request = stream.Request;
+
+					request.reserve(method.size() + path.size() + m_host.size() + authorityPort.size() + cookies.size() + fields.size() + 96);
+
+					request.append(method);
+					request.append(" ");
+					request.append(path);
+					request.append(" HTTP/1.1\r\nHost: ");
+					request.append(m_host);
+					request.append(authorityPort);
+					request.append("\r\n");
+
+					if (!cookies.empty())
+					{
+						request.append("Cookie: ");
+						request.append(cookies);
+						request.append("\r\n");
+					}
+
+					request.append(fields);
+
+					if (stream.HasContentLength)
+					{
+						request.append("Content-Length: ");
+						request.append(std::to_string(stream.ContentLength));
+						request.append("\r\n");
+					}
+					else if (!endStream)
+					{
+						// The length of the body is only known once the client ends the stream.
+						stream.Chunked = true;
+						request.append("Transfer-Encoding: chunked\r\n");
+					}
+					else if (method == "POST" || method == "PUT" || method == "PATCH")
+					{
+						// Some servers won't take a request like this without a length.
+						request.append("Content-Length: 0\r\n");
+					}
+
+					request.append("\r\n");
+
+					if (endStream)
+					{
+						if (stream.HasContentLength && stream.ContentLength != 0)
+						{
+							return false;
+						}
+
+						stream.RequestComplete = true;
+					}
+					else if (expectContinue)
+					{
+						std::string block;
+
+						HpackEncoder::Encode(":status", "100", block);
+						AppendHeaders(m_output, stream.Id, block, false, m_peerMaxFrameSize);
+					}
+
+					return true;
+				}
+
+				void Http2Session::Respond(const uint32_t streamId, const char* status, const bool requestComplete)
+				{
+					std::string block;
+
+					HpackEncoder::Encode(":status", status, block);
+					HpackEncoder::Encode("content-length", "0", block);
+
+					AppendHeaders(m_output, streamId, block, true, m_peerMaxFrameSize);
+
+					if (!requestComplete)
+					{
+						AppendRstStream(m_output, streamId, ErrorCode::NoError);
+					}
+				}
+
+				void Http2Session::FinishRequest(Stream& stream)
+				{
+					if (stream.HasContentLength && stream.BodyReceived != stream.ContentLength)
+					{
+						AbortStream(stream, ErrorCode::ProtocolError, true);
+						return;
+					}
+
+					if (stream.Chunked)
+					{
+						stream.Request.append("0\r\n\r\n", 5);
+					}
+
+					stream.RequestComplete = true;
+				}
+
+				void Http2Session::AbortStream(Stream& stream, const ErrorCode error, const bool sendReset)
+				{
+					if (sendReset)
+					{
+						AppendRstStream(m_output, stream.Id, error);
+					}
+
+					if (!m_reading || m_streams.front().get() != &stream)
+					{
+						// Not started yet, so the bridge never needs to learn of it.
+						RemoveStream(stream.Id);
+						return;
+					}
+
+					stream.Reset = true;
+
+					if (!stream.RequestComplete || !stream.Request.empty())
+					{
+						stream.Aborted = true;
+					}
+
+					// Nothing more goes out on this stream.
+					m_responseFailed = true;
+					m_responseBacklog.clear();
+					m_responseEndPending = false;
+					m_responseHeadersPending = false;
+				}
+
+				Http2Session::Stream* Http2Session::FindStream(const uint32_t streamId)
+				{
+					for (auto& stream : m_streams)
+					{
+						if (stream->Id == streamId)
+						{
+							return stream.get();
+						}
+					}
+
+					return nullptr;
+				}
+
+				void Http2Session::RemoveStream(const uint32_t streamId)
+				{
+					for (auto it = m_streams.begin(); it != m_streams.end(); ++it)
+					{
+						if ((*it)->Id == streamId)
+						{
+							m_streams.erase(it);
+							return;
+						}
+					}
+				}
+
+				void Http2Session::Pump()
+				{
+					if (!m_reading || m_streams.empty() || m_responseFailed)
+					{
+						return;
+					}
+
+					Stream& stream = *m_streams.front();
+
+					size_t sent = 0;
+
+					while (sent < m_responseBacklog.size())
+					{
+						const int64_t window = (std::min)(m_connectionSendWindow, stream.SendWindow);
+
+						if (window <= 0)
+						{
+							break;
+						}
+
+						const size_t length = static_cast<size_t>((std::min)(static_cast<int64_t>((std::min)(m_responseBacklog.size() - sent, static_cast<size_t>(m_peerMaxFrameSize))), window));
+						const bool last = m_responseEndPending && sent + length == m_responseBacklog.size();
+
+						AppendData(m_output, stream.Id, m_responseBacklog.data() + sent, length, last);
+
+						m_connectionSendWindow -= length;
+						stream.SendWindow -= length;
+						sent += length;
+
+						if (last)
+						{
+							m_responseEndPending = false;
+						}
+					}
+
+					m_responseBacklog.erase(0, sent);
+
+					if (m_responseBacklog.empty() && m_responseEndPending)
+					{
+						// An empty DATA frame takes nothing from either window.
+						AppendData(m_output, stream.Id, nullptr, 0, true);
+						m_responseEndPending = false;
+					}
+				}
+
+				void Http2Session::SendResponseHeaders(const bool endStream)
+				{
+					AppendHeaders(m_output, m_streams.front()->Id, m_responseBlock, endStream, m_peerMaxFrameSize);
+
+					m_responseBlock.clear();
+					m_responseHeadersPending = false;
+				}
+
+				void Http2Session::ResetResponse(const ErrorCode error)
+				{
+					AppendRstStream(m_output, m_streams.front()->Id, error);
+
+					m_responseFailed = true;
+					m_responseBacklog.clear();
+					m_responseEndPending = false;
+					m_responseHeadersPending = false;
+				}
+
+				const bool Http2Session::Fail(const ErrorCode error, const char* reason)
+				{
+					if (!m_closed)
+					{
+						AppendGoAway(m_output, m_lastStreamId, error);
+						m_closed = true;
+						m_error = reason;
+					}
+
+					return false;
+				}
+
+				void Http2Session::FlushResponseHeader()
+				{
+					if (m_responseHeaderName.empty())
+					{
+						return;
+					}
+
+					for (auto& c : m_responseHeaderName)
+					{
+						c = ToLower(c);
+					}
+
+					m_responseHeaders.emplace_back(std::move(m_responseHeaderName), std::move(m_responseHeaderValue));
+
+					m_responseHeaderName.clear();
+					m_responseHeaderValue.clear();
+					m_responseInValue = false;
+				}
+
+				int Http2Session::OnResponseHeaderField(http_parser* parser, const char* at, size_t length)
+				{
+					auto* session = static_cast<Http2Session*>(parser->data);
+
+					if (session->m_responseInValue)
+					{
+						session->FlushResponseHeader();
+					}
+
+					session->m_responseHeaderName.append(at, length);
+
+					return 0;
+				}
+
+				int Http2Session::OnResponseHeaderValue(http_parser* parser, const char* at, size_t length)
+				{
+					auto* session = static_cast<Http2Session*>(parser->data);
+
+					session->m_responseInValue = true;
+					session->m_responseHeaderValue.append(at, length);
+
+					return 0;
+				}
+
+				int Http2Session::OnResponseHeadersComplete(http_parser* parser)
+				{
+					auto* session = static_cast<Http2Session*>(parser->data);
+
+					session->FlushResponseHeader();
+
+					if (parser->status_code / 100 == 1)
+					{
+						// Interim responses are of no use to the client, which never sees the
+						// request the way the server did.
+						return 0;
+					}
+
+					std::string connection;
+
+					for (const auto& header : session->m_responseHeaders)
+					{
+						if (header.first == "connection")
+						{
+							if (!connection.empty())
+							{
+								connection.append(",");
+							}
+
+							connection.append(header.second);
+						}
+					}
+
+					std::string& block = session->m_responseBlock;
+
+					HpackEncoder::Encode(":status", std::to_string(parser->status_code), block);
+
+					for (const auto& header : session->m_responseHeaders)
+					{
+						if (IsConnectionSpecific(header.first) || (!connection.empty() && IsConnectionToken(header.first, connection)))
+						{
+							continue;
+						}
+
+						HpackEncoder::Encode(header.first, header.second, block);
+					}
+
+					session->m_responseHeaders.clear();
+					session->m_responseHeadersPending = true;
+
+					// The response to a HEAD request has no body, whatever its headers say.
+					return session->m_streams.front()->Head ? 1 : 0;
+				}
+
+				int Http2Session::OnResponseBody(http_parser* parser, const char* at, size_t length)
+				{
+					auto* session = static_cast<Http2Session*>(parser->data);
+
+					if (session->m_responseHeadersPending)
+					{
+						session->SendResponseHeaders(false);
+					}
+
+					session->m_responseBacklog.append(at, length);
+
+					return 0;
+				}
+
+				int Http2Session::OnResponseMessageComplete(http_parser* parser)
+				{
+					auto* session = static_cast<Http2Session*>(parser->data);
+
+					if (parser->status_code / 100 == 1)
+					{
+						// The real response follows.
+						session->m_responseHeaders.clear();
+						return 0;
+					}
+
+					session->m_responseComplete = true;
+
+					if (session->m_responseHeadersPending)
+					{
+						session->SendResponseHeaders(true);
+					}
+					else
+					{
+						session->m_responseEndPending = true;
+					}
+
+					// Anything after this isn't part of the response.
+					http_parser_pause(parser, 1);
+
+					return 0;
+				}
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
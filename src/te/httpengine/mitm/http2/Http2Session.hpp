@@ -0,0 +1,414 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "Http2Frame.hpp"
+#include "Hpack.hpp"
+#include "http_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http2
+			{
+
+				/// <summary>
+				/// The Http2Session is the server side of a single HTTP/2 connection with a
+				/// client, as per RFC 7540, minus everything to do with sockets. Whatever the
+				/// client sends is handed to ::Receive(...), and whatever is to be sent back is
+				/// taken with ::TakeOutput(...).
+				///
+				/// The bridge only knows how to handle one HTTP/1.1 transaction at a time, so the
+				/// session turns the streams of the client into exactly that. Every stream the
+				/// client opens is queued, and the requests are handed out one after the other,
+				/// each as the bytes of the HTTP/1.1 request it amounts to, through
+				/// ::ReadRequest(...). Whatever HTTP/1.1 response is written back through
+				/// ::WriteResponse(...) is parsed and sent to the client as the response of the
+				/// stream that was read last, until ::EndResponse() moves on to the next stream.
+				/// Streams are therefore answered in order, and only one is ever in flight
+				/// upstream, but the client can still open as many of them as it likes over the
+				/// one connection.
+				///
+				/// Not thread safe. The owner must serialize every call.
+				/// </summary>
+				class Http2Session
+				{
+
+				public:
+
+					/// <summary>
+					/// The most streams the client may have queued with us at once.
+					/// </summary>
+					static constexpr uint32_t MaxConcurrentStreams = 100;
+
+					/// <summary>
+					/// The largest header list we accept from the client, as advertised with
+					/// SETTINGS_MAX_HEADER_LIST_SIZE.
+					/// </summary>
+					static constexpr uint32_t MaxHeaderListSize = 65536;
+
+					/// <summary>
+					/// Constructs a new Http2Session and queues our SETTINGS, which is the server
+					/// connection preface, as per RFC 7540 section 3.5.
+					/// </summary>
+					/// <param name="host">
+					/// The host the connection was made for, which is the SNI host of the TLS
+					/// handshake. A stream for any other authority is answered with 421 right
+					/// away, since the bridge only ever speaks to the one host.
+					/// </param>
+					Http2Session(const std::string& host);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					Http2Session(const Http2Session&) = delete;
+					Http2Session(Http2Session&&) = delete;
+					Http2Session& operator=(const Http2Session&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~Http2Session();
+
+					/// <summary>
+					/// Processes data received from the client, which need not start or end on a
+					/// frame boundary.
+					/// </summary>
+					/// <returns>
+					/// False if the data was a connection error. A GOAWAY is then queued, and the
+					/// session is closed.
+					/// </returns>
+					const bool Receive(const char* data, const size_t length);
+
+					/// <summary>
+					/// Moves whatever is waiting to be sent to the client to the end of the
+					/// supplied buffer.
+					/// </summary>
+					void TakeOutput(std::string& out);
+
+					/// <summary>
+					/// Gets how much is waiting to be sent to the client.
+					/// </summary>
+					const size_t GetOutputSize() const
+					{
+						return m_output.size();
+					}
+
+					/// <summary>
+					/// Reads as much of the next request as there is and fits. The first read
+					/// after ::EndResponse() starts the next queued stream.
+					/// </summary>
+					/// <returns>
+					/// The number of bytes read. Zero if there is nothing to read yet.
+					/// </returns>
+					const size_t ReadRequest(char* out, const size_t length);
+
+					/// <summary>
+					/// Gets whether the request being read was cut short, because the client
+					/// reset its stream, or sent a body that didn't add up. Whatever was read of
+					/// it is then all there will ever be.
+					/// </summary>
+					const bool IsRequestAborted() const;
+
+					/// <summary>
+					/// Hands over part of the HTTP/1.1 response to the request read last.
+					/// </summary>
+					/// <returns>
+					/// False if the stream can't take a response anymore, because the client
+					/// reset it, or because the data isn't a response we can make sense of, in
+					/// which case we've reset it. Whatever else is written for it is discarded.
+					/// </returns>
+					const bool WriteResponse(const char* data, const size_t length);
+
+					/// <summary>
+					/// Gets whether every byte written with ::WriteResponse(...) so far has been
+					/// framed and moved to the output. Anything that isn't is waiting for the
+					/// client to open its flow control windows.
+					/// </summary>
+					const bool IsResponseDrained() const;
+
+					/// <summary>
+					/// Ends the response to the request read last, and with it the stream. A
+					/// response that isn't complete by then, even taking the end of the data as
+					/// its end, has its stream reset instead.
+					/// </summary>
+					void EndResponse();
+
+					/// <summary>
+					/// Gets whether the session is over, having sent a GOAWAY, which leaves
+					/// nothing to be done but to send the output and close the connection.
+					/// </summary>
+					const bool IsClosed() const
+					{
+						return m_closed;
+					}
+
+					/// <summary>
+					/// Gets the reason the session was closed, if it was for an error.
+					/// </summary>
+					const std::string& GetError() const
+					{
+						return m_error;
+					}
+
+				private:
+
+					struct Stream;
+
+					/// <summary>
+					/// Processes a single, complete frame.
+					/// </summary>
+					const bool OnFrame(const FrameHeader& header, const char* payload);
+
+					const bool OnData(const FrameHeader& header, const char* payload);
+
+					const bool OnHeaders(const FrameHeader& header, const char* payload);
+
+					const bool OnContinuation(const FrameHeader& header, const char* payload);
+
+					const bool OnPriority(const FrameHeader& header, const char* payload);
+
+					const bool OnRstStream(const FrameHeader& header, const char* payload);
+
+					const bool OnSettings(const FrameHeader& header, const char* payload);
+
+					const bool OnPing(const FrameHeader& header, const char* payload);
+
+					const bool OnGoAway(const FrameHeader& header, const char* payload);
+
+					const bool OnWindowUpdate(const FrameHeader& header, const char* payload);
+
+					/// <summary>
+					/// Decodes the header block gathered for a stream, and either queues the
+					/// request it holds, or takes it as the trailers of one that's queued.
+					/// </summary>
+					const bool OnHeaderBlock(const uint32_t streamId, const bool endStream);
+
+					/// <summary>
+					/// Turns a decoded header list into the HTTP/1.1 request it amounts to.
+					/// </summary>
+					/// <param name="status">
+					/// Set to the status to answer the stream with ourselves, if it's not one the
+					/// bridge can serve.
+					/// </param>
+					/// <returns>
+					/// False if the header list is malformed, as per RFC 7540 section 8.1.2.6.
+					/// </returns>
+					const bool BuildRequest(Stream& stream, const HeaderList& headers, const bool endStream, const char*& status);
+
+					/// <summary>
+					/// Answers a stream with a response of our own, without the bridge ever seeing
+					/// it.
+					/// </summary>
+					void Respond(const uint32_t streamId, const char* status, const bool requestComplete);
+
+					/// <summary>
+					/// Ends the request body of a stream.
+					/// </summary>
+					void FinishRequest(Stream& stream);
+
+					/// <summary>
+					/// Gives up on a stream, dropping it from the queue if the bridge hasn't
+					/// started reading it, and cutting off both its request and response if it
+					/// has.
+					/// </summary>
+					/// <param name="sendReset">
+					/// Whether to tell the client with a RST_STREAM, which it doesn't need if it
+					/// reset the stream itself.
+					/// </param>
+					void AbortStream(Stream& stream, const ErrorCode error, const bool sendReset);
+
+					/// <summary>
+					/// Finds a queued stream.
+					/// </summary>
+					Stream* FindStream(const uint32_t streamId);
+
+					/// <summary>
+					/// Drops a stream that the bridge hasn't started reading yet from the queue.
+					/// </summary>
+					void RemoveStream(const uint32_t streamId);
+
+					/// <summary>
+					/// Moves as much of the pending response data as the flow control windows
+					/// allow to the output.
+					/// </summary>
+					void Pump();
+
+					/// <summary>
+					/// Frames the response headers parsed so far, and moves them to the output.
+					/// </summary>
+					void SendResponseHeaders(const bool endStream);
+
+					/// <summary>
+					/// Resets the stream of the response being written, discarding whatever of it
+					/// wasn't sent.
+					/// </summary>
+					void ResetResponse(const ErrorCode error);
+
+					/// <summary>
+					/// Queues a GOAWAY and closes the session.
+					/// </summary>
+					/// <returns>
+					/// Always false, for the convenience of the frame handlers.
+					/// </returns>
+					const bool Fail(const ErrorCode error, const char* reason);
+
+					/// <summary>
+					/// Adds the response header parsed last to the list.
+					/// </summary>
+					void FlushResponseHeader();
+
+					static int OnResponseHeaderField(http_parser* parser, const char* at, size_t length);
+
+					static int OnResponseHeaderValue(http_parser* parser, const char* at, size_t length);
+
+					static int OnResponseHeadersComplete(http_parser* parser);
+
+					static int OnResponseBody(http_parser* parser, const char* at, size_t length);
+
+					static int OnResponseMessageComplete(http_parser* parser);
+
+					std::string m_host;
+
+					HpackDecoder m_decoder;
+
+					/// <summary>
+					/// Received data that doesn't make up a complete frame yet.
+					/// </summary>
+					std::string m_input;
+
+					/// <summary>
+					/// Framed data waiting to be sent to the client.
+					/// </summary>
+					std::string m_output;
+
+					/// <summary>
+					/// Whether the client has sent its connection preface yet, and with it, the
+					/// SETTINGS frame that has to follow it.
+					/// </summary>
+					bool m_prefaceReceived = false;
+
+					bool m_settingsReceived = false;
+
+					bool m_closed = false;
+
+					/// <summary>
+					/// Whether the client sent a GOAWAY, after which it opens no more streams.
+					/// </summary>
+					bool m_goAwayReceived = false;
+
+					std::string m_error;
+
+					/// <summary>
+					/// The stream whose header block is being gathered from HEADERS and
+					/// CONTINUATION frames, or zero. Nothing but a CONTINUATION of that stream may
+					/// come in while there is one.
+					/// </summary>
+					uint32_t m_headerBlockStreamId = 0;
+
+					bool m_headerBlockEndStream = false;
+
+					std::string m_headerBlock;
+
+					/// <summary>
+					/// The highest stream the client has opened.
+					/// </summary>
+					uint32_t m_lastStreamId = 0;
+
+					/// <summary>
+					/// The streams the client has opened that we've yet to finish answering, in
+					/// the order they were opened. The bridge is working on the first one if
+					/// m_reading is set.
+					/// </summary>
+					std::deque<std::unique_ptr<Stream>> m_streams;
+
+					/// <summary>
+					/// Whether the first queued stream has been started by ::ReadRequest(...).
+					/// </summary>
+					bool m_reading = false;
+
+					/// <summary>
+					/// The send window of the connection, and the window every stream starts
+					/// with, as set by the client.
+					/// </summary>
+					int64_t m_connectionSendWindow = DefaultWindowSize;
+
+					int64_t m_initialStreamSendWindow = DefaultWindowSize;
+
+					/// <summary>
+					/// How much the client may still send us on the connection. It's opened up
+					/// again as soon as anything is received, so it's only ever checked.
+					/// </summary>
+					int64_t m_connectionReceiveWindow = DefaultWindowSize;
+
+					/// <summary>
+					/// The largest frame the client accepts.
+					/// </summary>
+					uint32_t m_peerMaxFrameSize = DefaultMaxFrameSize;
+
+					/// <summary>
+					/// The parser the response being written is read with.
+					/// </summary>
+					http_parser m_responseParser;
+
+					http_parser_settings m_responseParserSettings;
+
+					/// <summary>
+					/// The response headers parsed so far, and the state of the header being
+					/// parsed, which http_parser may hand over in pieces. They're only encoded
+					/// once they're all in, as the Connection header may name any of them.
+					/// </summary>
+					HeaderList m_responseHeaders;
+
+					std::string m_responseHeaderName;
+
+					std::string m_responseHeaderValue;
+
+					bool m_responseInValue = false;
+
+					/// <summary>
+					/// The encoded response headers, held until it's known if they end the
+					/// stream.
+					/// </summary>
+					std::string m_responseBlock;
+
+					bool m_responseHeadersPending = false;
+
+					bool m_responseComplete = false;
+
+					/// <summary>
+					/// Set when the response can't go on, whatever else is written for it is
+					/// then discarded.
+					/// </summary>
+					bool m_responseFailed = false;
+
+					/// <summary>
+					/// Response body waiting for the flow control windows to open.
+					/// </summary>
+					std::string m_responseBacklog;
+
+					/// <summary>
+					/// Whether END_STREAM is owed once the backlog has been sent.
+					/// </summary>
+					bool m_responseEndPending = false;
+
+				};
+
+			} /* namespace http2 */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,182 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "ApplicationProtocols.hpp"
+
+#include <cstring>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace secure
+			{
+
+				namespace
+				{
+					static const unsigned char Http11[] = { 'h', 't', 't', 'p', '/', '1', '.', '1' };
+
+					static const unsigned char Http2[] = { 'h', '2' };
+
+					/// <summary>
+					/// What the client offers upstream, in wire format. Each protocol is
+					/// prefixed with its length.
+					/// </summary>
+					static const unsigned char ClientProtocols[] = { 8, 'h', 't', 't', 'p', '/', '1', '.', '1' };
+
+					inline const bool IsProtocol(const unsigned char* name, const size_t nameLength, const unsigned char* protocol, const size_t protocolLength)
+					{
+						return nameLength == protocolLength && std::memcmp(name, protocol, protocolLength) == 0;
+					}
+				}
+
+				std::atomic_bool ApplicationProtocols::s_http2Enabled{ false };
+
+				std::atomic<uint64_t> ApplicationProtocols::s_http11Selected{ 0 };
+
+				std::atomic<uint64_t> ApplicationProtocols::s_http2Selected{ 0 };
+
+				std::atomic<uint64_t> ApplicationProtocols::s_http2Offered{ 0 };
+
+				std::atomic<uint64_t> ApplicationProtocols::s_noOverlap{ 0 };
+
+				bool ApplicationProtocols::ConfigureServerContext(SSL_CTX* serverContext)
+				{
+					if (serverContext == nullptr)
+					{
+						return false;
+					}
+
+					SSL_CTX_set_alpn_select_cb(serverContext, &ApplicationProtocols::OnSelect, nullptr);
+
+					return true;
+				}
+
+				bool ApplicationProtocols::OfferClientProtocols(SSL* ssl)
+				{
+					if (ssl == nullptr)
+					{
+						return false;
+					}
+
+					// Unlike nearly everything else in OpenSSL, this returns zero on success.
+					return SSL_set_alpn_protos(ssl, ClientProtocols, sizeof(ClientProtocols)) == 0;
+				}
+
+				void ApplicationProtocols::SetHttp2Enabled(const bool enabled)
+				{
+					s_http2Enabled = enabled;
+				}
+
+				const bool ApplicationProtocols::IsHttp2Enabled()
+				{
+					return s_http2Enabled;
+				}
+
+				const bool ApplicationProtocols::IsHttp2Selected(const SSL* ssl)
+				{
+					if (ssl == nullptr)
+					{
+						return false;
+					}
+
+					const unsigned char* selected = nullptr;
+					unsigned int selectedLength = 0;
+
+					SSL_get0_alpn_selected(ssl, &selected, &selectedLength);
+
+					return selected != nullptr && IsProtocol(selected, selectedLength, Http2, sizeof(Http2));
+				}
+
+				ApplicationProtocolStats ApplicationProtocols::GetStats()
+				{
+					ApplicationProtocolStats stats;
+
+					stats.Http11Selected = s_http11Selected;
+					stats.Http2Selected = s_http2Selected;
+					stats.Http2Offered = s_http2Offered;
+					stats.NoOverlap = s_noOverlap;
+
+					return stats;
+				}
+
+				int ApplicationProtocols::OnSelect(SSL* ssl, const unsigned char** out, unsigned char* outLength, const unsigned char* in, unsigned int inLength, void* arg)
+				{
+					const unsigned char* selected = nullptr;
+					unsigned char selectedLength = 0;
+					const unsigned char* http2 = nullptr;
+
+					unsigned int position = 0;
+
+					while (position < inLength)
+					{
+						const unsigned char nameLength = in[position];
+
+						position += 1;
+
+						if (nameLength == 0 || position + nameLength > inLength)
+						{
+							// OpenSSL checks the list before calling, so this would only ever be
+							// a list we couldn't make sense of anyway.
+							break;
+						}
+
+						const unsigned char* name = in + position;
+
+						if (selected == nullptr && IsProtocol(name, nameLength, Http11, sizeof(Http11)))
+						{
+							selected = name;
+							selectedLength = nameLength;
+						}
+						else if (http2 == nullptr && IsProtocol(name, nameLength, Http2, sizeof(Http2)))
+						{
+							http2 = name;
+						}
+
+						position += nameLength;
+					}
+
+					if (http2 != nullptr)
+					{
+						++s_http2Offered;
+
+						if (s_http2Enabled)
+						{
+							// Preferred whenever enabled, whatever order the client listed it in, as
+							// it lets the client send all its requests for the host down this one
+							// connection.
+							*out = http2;
+							*outLength = sizeof(Http2);
+
+							++s_http2Selected;
+
+							return SSL_TLSEXT_ERR_OK;
+						}
+					}
+
+					if (selected == nullptr)
+					{
+						// There's no fatal alert for this. A client that can't do without one of
+						// the protocols it offered is left to give up on its own.
+						++s_noOverlap;
+						return SSL_TLSEXT_ERR_NOACK;
+					}
+
+					*out = selected;
+					*outLength = selectedLength;
+
+					++s_http11Selected;
+
+					return SSL_TLSEXT_ERR_OK;
+				}
+
+			} /* namespace secure */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
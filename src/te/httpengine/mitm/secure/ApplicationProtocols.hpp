@@ -0,0 +1,172 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <openssl/ssl.h>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace secure
+			{
+
+				/// <summary>
+				/// Point in time snapshot of what downstream clients have offered over ALPN.
+				/// </summary>
+				struct ApplicationProtocolStats
+				{
+					/// <summary>
+					/// Total number of downstream handshakes where HTTP/1.1 was selected.
+					/// </summary>
+					uint64_t Http11Selected = 0;
+
+					/// <summary>
+					/// Total number of downstream handshakes where HTTP/2 was selected, which
+					/// only ever happens while it's enabled.
+					/// </summary>
+					uint64_t Http2Selected = 0;
+
+					/// <summary>
+					/// Total number of downstream handshakes where the client offered HTTP/2,
+					/// whether or not it was selected. Each one is a candidate for carrying the
+					/// client's other connections to the same host.
+					/// </summary>
+					uint64_t Http2Offered = 0;
+
+					/// <summary>
+					/// Total number of downstream handshakes where the client offered protocols,
+					/// none of them one that we speak, and so got no ALPN answer.
+					/// </summary>
+					uint64_t NoOverlap = 0;
+				};
+
+				/// <summary>
+				/// ApplicationProtocols decides what is negotiated over ALPN, as per RFC 7301, on
+				/// both legs of a bridged TLS connection. Bridges handle one HTTP/1.x transaction
+				/// at a time, so HTTP/1.1 is all that is offered upstream, and by default all
+				/// that is selected downstream. Answering explicitly, rather than ignoring the
+				/// extension, keeps a client from ever believing that something else was agreed
+				/// on, and keeps upstream servers that pick a protocol from ALPN from picking
+				/// HTTP/2.
+				///
+				/// HTTP/2 can be enabled for downstream clients, in which case it's selected
+				/// whenever offered, and the bridge serves the streams of the client one after
+				/// the other over a single upstream HTTP/1.1 connection. See
+				/// http2::Http2Session.
+				///
+				/// Downstream streams are created with the acceptor's default server context,
+				/// then switched to a spoofed context before the handshake. Depending on the
+				/// OpenSSL version, ALPN is answered from one or the other, so both must be
+				/// configured.
+				/// </summary>
+				class ApplicationProtocols
+				{
+
+				public:
+
+					/// <summary>
+					/// Has the supplied server context answer ALPN with HTTP/1.1 whenever the
+					/// client offers it, and with nothing otherwise.
+					/// </summary>
+					/// <param name="serverContext">
+					/// The default server context, or a spoofed context.
+					/// </param>
+					/// <returns>
+					/// True if the context was configured, false otherwise.
+					/// </returns>
+					static bool ConfigureServerContext(SSL_CTX* serverContext);
+
+					/// <summary>
+					/// Has the supplied upstream stream offer HTTP/1.1 over ALPN. Must be called
+					/// before the handshake is initiated. The offer is set on the stream itself,
+					/// since it isn't carried over when a stream is switched to another context.
+					/// </summary>
+					/// <param name="ssl">
+					/// The upstream stream.
+					/// </param>
+					/// <returns>
+					/// True if the offer was set, false otherwise.
+					/// </returns>
+					static bool OfferClientProtocols(SSL* ssl);
+
+					/// <summary>
+					/// Sets whether HTTP/2 is selected for downstream clients that offer it.
+					/// Disabled by default. Only applies to handshakes from then on.
+					/// </summary>
+					/// <param name="enabled">
+					/// True to select HTTP/2 whenever offered, false to only ever select
+					/// HTTP/1.1.
+					/// </param>
+					static void SetHttp2Enabled(const bool enabled);
+
+					/// <summary>
+					/// Gets whether HTTP/2 is selected for downstream clients that offer it.
+					/// </summary>
+					static const bool IsHttp2Enabled();
+
+					/// <summary>
+					/// Gets whether HTTP/2 was agreed on in the completed handshake of the
+					/// supplied downstream stream.
+					/// </summary>
+					/// <param name="ssl">
+					/// The downstream stream.
+					/// </param>
+					/// <returns>
+					/// True if HTTP/2 was selected, false otherwise.
+					/// </returns>
+					static const bool IsHttp2Selected(const SSL* ssl);
+
+					/// <summary>
+					/// Gets what downstream clients have offered so far.
+					/// </summary>
+					static ApplicationProtocolStats GetStats();
+
+				private:
+
+					/// <summary>
+					/// The ALPN select callback for server contexts.
+					/// </summary>
+					/// <param name="out">
+					/// Set to the selected protocol, which must point into the client's list.
+					/// </param>
+					/// <param name="outLength">
+					/// Set to the length of the selected protocol.
+					/// </param>
+					/// <param name="in">
+					/// The protocols offered by the client, in wire format.
+					/// </param>
+					/// <param name="inLength">
+					/// The length of the offered protocols.
+					/// </param>
+					/// <returns>
+					/// SSL_TLSEXT_ERR_OK if a protocol was selected, SSL_TLSEXT_ERR_NOACK if the
+					/// handshake is to proceed without one.
+					/// </returns>
+					static int OnSelect(SSL* ssl, const unsigned char** out, unsigned char* outLength, const unsigned char* in, unsigned int inLength, void* arg);
+
+					static std::atomic_bool s_http2Enabled;
+
+					static std::atomic<uint64_t> s_http11Selected;
+
+					static std::atomic<uint64_t> s_http2Selected;
+
+					static std::atomic<uint64_t> s_http2Offered;
+
+					static std::atomic<uint64_t> s_noOverlap;
+
+				};
+
+			} /* namespace secure */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -6,11 +6,19 @@
 */
 
 #include "BaseInMemoryCertificateStore.hpp"
+#include "ApplicationProtocols.hpp"
+#include "../../util/metrics/EngineMetrics.hpp"
 
 #include <random>
 #include <limits>
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <chrono>
+
+#if BOOST_OS_WINDOWS
+#include <windows.h>
+#endif
 
 namespace te
 {
@@ -41,43 +49,203 @@ namespace te
 					// Generate self signed CA cert.
 					m_thisCaKeyPair = GenerateEcKey();
 					m_thisCa = GenerateSelfSignedCert(m_thisCaKeyPair, m_caCountryCode, m_caOrgName, m_caCommonName);
+
+					m_keyPoolHits = 0;
+					m_keyPoolStalls = 0;
+					m_contextClock = 0;
+					m_contextEvictions = 0;
+
+					m_keyPoolRunning = true;
+					m_keyPoolThread = std::thread{ std::bind(&BaseInMemoryCertificateStore::RunKeyPool, this) };
 				}
 
 				BaseInMemoryCertificateStore::~BaseInMemoryCertificateStore()
 				{
-					// XXX TODO - What about the temp EC key? Does it simply die as part of the
-					// context? Why is there no method to fetch it later? If it doesn't die with
-					// the context, then we need to store it separately. :(
-					for (const auto& pair : m_hostContexts)
 					{
-						auto* nativeHandle = pair.second->native_handle();
-						auto* contextCert = SSL_CTX_get0_certificate(nativeHandle);
-						auto* privkey = SSL_CTX_get0_privatekey(nativeHandle);
+						std::lock_guard<std::mutex> lock(m_keyPoolMutex);
+						m_keyPoolRunning = false;
+					}
 
-						EVP_PKEY_free(privkey);
-						X509_free(contextCert);
+					m_keyPoolCv.notify_all();
 
-						delete pair.second;
+					if (m_keyPoolThread.joinable())
+					{
+						m_keyPoolThread.join();
 					}
 
+					for (auto* key : m_keyPool)
+					{
+						EVP_PKEY_free(key);
+					}
+
+					m_keyPool.clear();
+
+					// Contexts are freed by their deleter once the last reference is gone, which
+					// may well be a bridge that outlives us. SAN aliases all share the one entry,
+					// so nothing is freed twice.
 					m_hostContexts.clear();
+					m_contextEntries.clear();
 				}
 
-				boost::asio::ssl::context* BaseInMemoryCertificateStore::GetServerContext(const std::string& hostname, X509* originalCertificate)
+				std::shared_ptr<boost::asio::ssl::context> BaseInMemoryCertificateStore::GetServerContext(const std::string& hostname, X509* originalCertificate)
 				{
-					ScopedLock lock(m_spoofMutex);
-
 					std::string host = hostname;
 
 					std::transform(host.begin(), host.end(), host.begin(), ::tolower);
 
-					const auto& result = m_hostContexts.find(host);
+					// The overwhelmingly common case is a host we've already spoofed. That only
+					// needs a shared lock, so handshakes for known hosts never wait on each
+					// other, or on a certificate being generated for some other host. Recency
+					// for eviction is tracked with an atomic stamp for the same reason.
+					{
+						SharedLock lock(m_contextsMutex);
+
+						const auto& result = m_hostContexts.find(host);
+
+						if (result != m_hostContexts.end())
+						{
+							result->second->lastUsed.store(NextContextTick(), std::memory_order_relaxed);
+							util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::CertificateCacheHits);
+							return result->second->context;
+						}
+					}
+
+					std::promise<std::shared_ptr<boost::asio::ssl::context>> flight;
+					std::shared_future<std::shared_ptr<boost::asio::ssl::context>> inFlight;
+					bool isFlightOwner = false;
+
+					{
+						ScopedLock lock(m_spoofMutex);
+
+						// Check again, because whoever was generating this host may have
+						// finished between our lookup and getting this lock.
+						{
+							SharedLock contextsLock(m_contextsMutex);
+
+							const auto& result = m_hostContexts.find(host);
+
+							if (result != m_hostContexts.end())
+							{
+								result->second->lastUsed.store(NextContextTick(), std::memory_order_relaxed);
+								util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::CertificateCacheHits);
+								return result->second->context;
+							}
+						}
+
+						const auto& pending = m_pendingContexts.find(host);
+
+						if (pending != m_pendingContexts.end())
+						{
+							inFlight = pending->second;
+						}
+						else
+						{
+							inFlight = flight.get_future().share();
+							m_pendingContexts.insert({ host, inFlight });
+							isFlightOwner = true;
+						}
+					}
+
+					util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::CertificateCacheMisses);
+
+					if (!isFlightOwner)
+					{
+						// Someone else is already generating a context for this host, so share
+						// their result. If they failed, this rethrows their exception.
+						return inFlight.get();
+					}
+
+					std::vector<std::string> sanDomains;
+					std::shared_ptr<boost::asio::ssl::context> ctx;
+					size_t contextBytes = 0;
+
+					try
+					{
+						// No locks held here. This is the expensive part.
+						util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::CertificateMint);
 
-					if (result != m_hostContexts.end())
+						boost::asio::ssl::context* generated = GenerateServerContext(originalCertificate, sanDomains);
+						contextBytes = ApproximateContextSize(generated);
+						ctx.reset(generated, &BaseInMemoryCertificateStore::FreeServerContext);
+					}
+					catch (...)
 					{
-						return result->second;
-					}										
+						{
+							ScopedLock lock(m_spoofMutex);
+							m_pendingContexts.erase(host);
+						}
 
+						flight.set_exception(std::current_exception());
+						throw;
+					}
+
+					{
+						UniqueLock lock(m_contextsMutex);
+
+						auto entry = std::make_shared<ContextEntry>();
+						entry->context = ctx;
+						entry->lastUsed = NextContextTick();
+
+						for (const auto& domain : sanDomains)
+						{
+							if (m_hostContexts.find(domain) == m_hostContexts.end())
+							{
+								m_hostContexts.insert({ domain, entry });
+								entry->names.push_back(domain);
+							}
+						}
+
+						if (m_hostContexts.find(host) == m_hostContexts.end())
+						{
+							m_hostContexts.insert({ host, entry });
+							entry->names.push_back(host);
+						}
+
+						if (entry->names.size() == 0)
+						{
+							// Another host covered by the same certificate was generated at the same
+							// time, and it beat us to every one of these names, including ours. Use
+							// theirs. Ours is freed as soon as we let go of it.
+							ctx = m_hostContexts.find(host)->second->context;
+						}
+						else
+						{
+							entry->approximateBytes = contextBytes;
+
+							for (const auto& name : entry->names)
+							{
+								entry->approximateBytes += name.size();
+							}
+
+							m_contextBytes += entry->approximateBytes;
+							m_contextEntries.push_back(entry);
+
+							EvictOverLimit(entry.get());
+						}
+					}
+
+					{
+						ScopedLock lock(m_spoofMutex);
+						m_pendingContexts.erase(host);
+					}
+
+					flight.set_value(ctx);
+
+					return ctx;
+				}
+
+				void BaseInMemoryCertificateStore::SetContextCacheLimits(const uint32_t maxContexts, const uint64_t maxBytes)
+				{
+					UniqueLock lock(m_contextsMutex);
+
+					m_maxContexts = maxContexts;
+					m_maxContextBytes = maxBytes;
+
+					EvictOverLimit(nullptr);
+				}
+
+				boost::asio::ssl::context* BaseInMemoryCertificateStore::GenerateServerContext(X509* originalCertificate, std::vector<std::string>& sanDomains)
+				{
 					if (m_thisCa != nullptr && m_thisCaKeyPair != nullptr && originalCertificate != nullptr)
 					{
 						char countryBuff[1024];
@@ -92,7 +260,7 @@ namespace te
 
 						if (certToSpoofName == nullptr)
 						{
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to load remote certificate X509_NAME data.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to load remote certificate X509_NAME data.");
 						}
 
 						cnLen = X509_NAME_get_text_by_NID(certToSpoofName, NID_commonName, cnBuff, 1024);
@@ -118,11 +286,11 @@ namespace te
 						std::string organizationName(orgBuff, orgLen);
 						std::string commonName(cnBuff, cnLen);
 
-						EVP_PKEY* spoofedCertKeypair = GenerateEcKey();
+						EVP_PKEY* spoofedCertKeypair = AcquireEcKey();
 
 						if (spoofedCertKeypair == nullptr)
 						{
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to generate EC key for spoofed certificate.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to generate EC key for spoofed certificate.");
 						}
 
 						// We pass nullptr as the issuer keypair, because we don't want it to be signed yet. We
@@ -133,7 +301,7 @@ namespace te
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to generate X509 structure.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to generate X509 structure.");
 						}
 
 						// We need to get all the SAN, or Subject Alternative Names out of the certificate
@@ -156,7 +324,6 @@ namespace te
 						//
 						// The SAN string we're going to copy directly into our spoofed certificate is generated
 						// along side this vector, but stored entirely in the sanDnsString variable.
-						std::vector<std::string> sanDomains;
 						std::string sanDnsString;
 
 						for (i = 0; i < sanNamesCount; i++)
@@ -220,7 +387,7 @@ namespace te
 							{
 								EVP_PKEY_free(spoofedCertKeypair);
 								X509_free(spoofedCert);
-								throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to set SAN's for spoofed certificate.");
+								throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to set SAN's for spoofed certificate.");
 							}
 						}
 
@@ -229,7 +396,7 @@ namespace te
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to sign certificate.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to sign certificate.");
 						}
 
 						// Now we can create our server context.
@@ -239,7 +406,7 @@ namespace te
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to allocate new server context for spoofed certificate.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to allocate new server context for spoofed certificate.");
 						}
 
 						ctx->set_options(
@@ -255,7 +422,7 @@ namespace te
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to set context cipher list.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to set context cipher list.");
 						}
 						*/
 
@@ -263,56 +430,43 @@ namespace te
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to set server context certificate.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to set server context certificate.");
 						}
 
 						if (SSL_CTX_use_PrivateKey(ctx->native_handle(), spoofedCertKeypair) != 1)
 						{
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Failed to set server context private key.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to set server context private key.");
 						}
 
 						SSL_CTX_set_options(ctx->native_handle(), SSL_OP_CIPHER_SERVER_PREFERENCE);
 
 						SSL_CTX_set_ecdh_auto(ctx->native_handle(), 1);
 
-						bool atLeastOneInsert = false;
+						ApplicationProtocols::ConfigureServerContext(ctx->native_handle());
 
-						if (sanDomains.size() > 0)
-						{
-							for (const auto& domain : sanDomains)
-							{
-								if (m_hostContexts.find(domain) == m_hostContexts.end())
-								{
-									m_hostContexts.insert({ domain, ctx });
-									atLeastOneInsert = true;
-								}
-							}
-						}
-
-						if (m_hostContexts.find(host) == m_hostContexts.end())
-						{
-							m_hostContexts.insert({ host, ctx });
-							atLeastOneInsert = true;
-						}
+						// Downstream sessions all live in the default server context's cache, no
+						// matter which spoofed context served them. Binding each session to the
+						// certificate it was issued under is what stops a client from resuming a
+						// session for one host on a connection to another.
+						unsigned char sessionIdContext[EVP_MAX_MD_SIZE];
+						unsigned int sessionIdContextLength = 0;
 
-						if (!atLeastOneInsert)
+						if (X509_digest(spoofedCert, EVP_sha256(), sessionIdContext, &sessionIdContextLength) != 1 ||
+							SSL_CTX_set_session_id_context(ctx->native_handle(), sessionIdContext, std::min(sessionIdContextLength, static_cast<unsigned int>(SSL_MAX_SID_CTX_LENGTH))) != 1)
 						{
-							// In this case, either the user has made an error and is duplicating data, or perhaps
-							// something more dirty is going on, where we have spoofed a certificate that is lying
-							// about its SN and or SAN's.							
 							EVP_PKEY_free(spoofedCertKeypair);
 							X509_free(spoofedCert);
 							delete ctx;
-							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Context already exists for specified host.");
+							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Failed to set server context session ID context.");
 						}
 
 						return ctx;
 					}
 					else
 					{
-						throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GetServerContext(std::string, X509*) - Cannot spoof certificate. Either member CA , member CA keypair or certificate to spoof is nullptr.");
+						throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateServerContext(X509*, std::vector<std::string>&) - Cannot spoof certificate. Either member CA , member CA keypair or certificate to spoof is nullptr.");
 					}
 				}
 
@@ -352,12 +506,236 @@ namespace te
 					return {};
 				}
 
+				void BaseInMemoryCertificateStore::SetKeyPoolDepth(const uint32_t depth)
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_keyPoolMutex);
+
+						m_keyPoolDepth = depth;
+
+						while (m_keyPool.size() > m_keyPoolDepth)
+						{
+							EVP_PKEY_free(m_keyPool.back());
+							m_keyPool.pop_back();
+						}
+					}
+
+					m_keyPoolCv.notify_all();
+				}
+
+				CertificateStoreStats BaseInMemoryCertificateStore::GetStats()
+				{
+					CertificateStoreStats stats;
+
+					{
+						std::lock_guard<std::mutex> lock(m_keyPoolMutex);
+
+						stats.KeyPoolDepth = m_keyPoolDepth;
+						stats.KeyPoolAvailable = static_cast<uint32_t>(m_keyPool.size());
+					}
+
+					stats.KeyPoolHits = m_keyPoolHits;
+					stats.KeyPoolStalls = m_keyPoolStalls;
+
+					{
+						SharedLock lock(m_contextsMutex);
+
+						stats.ContextEntries = static_cast<uint32_t>(m_contextEntries.size());
+						stats.ContextNames = static_cast<uint32_t>(m_hostContexts.size());
+						stats.ContextBytes = m_contextBytes;
+					}
+
+					stats.ContextEvictions = m_contextEvictions;
+
+					return stats;
+				}
+
+				void BaseInMemoryCertificateStore::RunKeyPool()
+				{
+					#if BOOST_OS_WINDOWS
+					// Filling the pool is never urgent. Whatever the proxy threads are doing is.
+					SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+					#endif
+
+					std::unique_lock<std::mutex> lock(m_keyPoolMutex);
+
+					while (m_keyPoolRunning)
+					{
+						m_keyPoolCv.wait(lock, [this]()
+						{
+							return !m_keyPoolRunning || m_keyPool.size() < m_keyPoolDepth;
+						});
+
+						if (!m_keyPoolRunning)
+						{
+							break;
+						}
+
+						lock.unlock();
+
+						EVP_PKEY* key = nullptr;
+
+						try
+						{
+							key = GenerateEcKey();
+						}
+						catch (std::exception&)
+						{
+							key = nullptr;
+						}
+
+						lock.lock();
+
+						if (key == nullptr)
+						{
+							// Nowhere to report this from here, and AcquireEcKey() will hit the
+							// same error and throw it on the request path anyway. Back off rather
+							// than spin on it.
+							m_keyPoolCv.wait_for(lock, std::chrono::seconds(1), [this]() { return !m_keyPoolRunning; });
+							continue;
+						}
+
+						if (m_keyPoolRunning && m_keyPool.size() < m_keyPoolDepth)
+						{
+							m_keyPool.push_back(key);
+						}
+						else
+						{
+							EVP_PKEY_free(key);
+						}
+					}
+				}
+
+				EVP_PKEY* BaseInMemoryCertificateStore::AcquireEcKey()
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_keyPoolMutex);
+
+						if (m_keyPool.size() > 0)
+						{
+							EVP_PKEY* key = m_keyPool.front();
+							m_keyPool.pop_front();
+
+							++m_keyPoolHits;
+
+							m_keyPoolCv.notify_all();
+
+							return key;
+						}
+					}
+
+					++m_keyPoolStalls;
+
+					return GenerateEcKey();
+				}
+
+				void BaseInMemoryCertificateStore::EvictOverLimit(const ContextEntry* keep)
+				{
+					auto overLimit = [this]()
+					{
+						return (m_maxContexts > 0 && m_contextEntries.size() > m_maxContexts) ||
+							(m_maxContextBytes > 0 && m_contextBytes > m_maxContextBytes);
+					};
+
+					while (overLimit())
+					{
+						// This only ever runs when inserting a freshly generated certificate or
+						// when the limits change, so a scan for the oldest stamp is no cost at
+						// all next to what we just did, and it keeps lookups free of any list
+						// maintenance.
+						size_t victim = m_contextEntries.size();
+						uint64_t oldest = (std::numeric_limits<uint64_t>::max)();
+
+						for (size_t i = 0; i < m_contextEntries.size(); ++i)
+						{
+							if (m_contextEntries[i].get() == keep)
+							{
+								continue;
+							}
+
+							const uint64_t lastUsed = m_contextEntries[i]->lastUsed.load(std::memory_order_relaxed);
+
+							if (lastUsed < oldest)
+							{
+								oldest = lastUsed;
+								victim = i;
+							}
+						}
+
+						if (victim == m_contextEntries.size())
+						{
+							break;
+						}
+
+						const auto& evicted = m_contextEntries[victim];
+
+						for (const auto& name : evicted->names)
+						{
+							m_hostContexts.erase(name);
+						}
+
+						m_contextBytes -= evicted->approximateBytes;
+
+						// Bridges still holding this context keep it alive until they're done.
+						std::swap(m_contextEntries[victim], m_contextEntries.back());
+						m_contextEntries.pop_back();
+
+						++m_contextEvictions;
+					}
+				}
+
+				size_t BaseInMemoryCertificateStore::ApproximateContextSize(boost::asio::ssl::context* ctx)
+				{
+					size_t total = ApproximateContextOverhead;
+
+					auto* nativeHandle = ctx->native_handle();
+					auto* contextCert = SSL_CTX_get0_certificate(nativeHandle);
+					auto* privkey = SSL_CTX_get0_privatekey(nativeHandle);
+
+					// DER sizes are a fair stand-in for what the parsed structures hold.
+					if (contextCert != nullptr)
+					{
+						int len = i2d_X509(contextCert, nullptr);
+						total += len > 0 ? static_cast<size_t>(len) : 0;
+					}
+
+					if (privkey != nullptr)
+					{
+						int len = i2d_PrivateKey(privkey, nullptr);
+						total += len > 0 ? static_cast<size_t>(len) : 0;
+					}
+
+					return total;
+				}
+
+				void BaseInMemoryCertificateStore::FreeServerContext(boost::asio::ssl::context* ctx)
+				{
+					if (ctx == nullptr)
+					{
+						return;
+					}
+
+					auto* nativeHandle = ctx->native_handle();
+					auto* contextCert = SSL_CTX_get0_certificate(nativeHandle);
+					auto* privkey = SSL_CTX_get0_privatekey(nativeHandle);
+
+					EVP_PKEY_free(privkey);
+					X509_free(contextCert);
+
+					delete ctx;
+				}
+
 				EVP_PKEY* BaseInMemoryCertificateStore::GenerateEcKey(const int namedCurveId) const
 				{
 					EC_KEY *eckey = nullptr;
 
 					if ((eckey = EC_KEY_new_by_curve_name(namedCurveId)) == nullptr || EC_KEY_generate_key(eckey) != 1)
 					{
+						if (eckey != nullptr)
+						{
+							EC_KEY_free(eckey);
+						}
+
 						throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateEcKey(const int) - Failed to allocate EC_KEY structure.");
 					}
 
@@ -369,6 +747,8 @@ namespace te
 
 					if (pkey == nullptr)
 					{
+						EC_KEY_free(eckey);
+
 						throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateEcKey(const int) - Failed to allocate EVP_PKEY structure.");
 					}
 					else
@@ -376,11 +756,15 @@ namespace te
 						if (EVP_PKEY_set1_EC_KEY(pkey, eckey) != 1)
 						{
 							EVP_PKEY_free(pkey);
+							EC_KEY_free(eckey);
 
 							throw std::runtime_error(u8"In BaseInMemoryCertificateStore::GenerateEcKey(const int) - Failed to assign EC_KEY to EVP_PKEY structure.");
 						}
 					}
 
+					// The set1 above took its own reference.
+					EC_KEY_free(eckey);
+
 					return pkey;
 				}
 
@@ -8,12 +8,19 @@
 #pragma once
 
 #include <string>
+#include <memory>
 #include <unordered_map>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
 #include <openssl/obj_mac.h>
 #include <boost/predef.h>
 #include "../../network/SocketTypes.hpp"
 #include <mutex>
+#include <shared_mutex>
+#include <future>
 #include <thread>
+#include <vector>
 
 namespace te
 {
@@ -24,6 +31,56 @@ namespace te
 			namespace secure
 			{
 
+				/// <summary>
+				/// Point in time snapshot of the counters kept by a certificate store.
+				/// </summary>
+				struct CertificateStoreStats
+				{
+					/// <summary>
+					/// The number of pre-generated keypairs the pool tries to keep available.
+					/// </summary>
+					uint32_t KeyPoolDepth = 0;
+
+					/// <summary>
+					/// The number of pre-generated keypairs presently available.
+					/// </summary>
+					uint32_t KeyPoolAvailable = 0;
+
+					/// <summary>
+					/// Total number of keypairs handed out from the pool.
+					/// </summary>
+					uint64_t KeyPoolHits = 0;
+
+					/// <summary>
+					/// Total number of times a keypair was needed while the pool was empty,
+					/// forcing one to be generated on the request path. If this keeps growing,
+					/// the pool depth is too small for the rate of new hosts.
+					/// </summary>
+					uint64_t KeyPoolStalls = 0;
+
+					/// <summary>
+					/// The number of spoofed server contexts presently cached.
+					/// </summary>
+					uint32_t ContextEntries = 0;
+
+					/// <summary>
+					/// The number of host names, including subject alt names, presently mapped to
+					/// the cached contexts.
+					/// </summary>
+					uint32_t ContextNames = 0;
+
+					/// <summary>
+					/// Approximate number of bytes held by the cached contexts. This is a rough
+					/// figure meant for sizing the cache limits, not exact accounting.
+					/// </summary>
+					uint64_t ContextBytes = 0;
+
+					/// <summary>
+					/// Total number of contexts evicted to stay within the cache limits.
+					/// </summary>
+					uint64_t ContextEvictions = 0;
+				};
+
 				/// <summary>
 				/// The BaseInMemoryCertificateStore class serves as a mechanism by which proxy
 				/// client handlers can retrieve spoofed versions of validated upstream certificates
@@ -81,10 +138,9 @@ namespace te
 						);
 
 					/// <summary>
-					/// Destructor iterates over all generated boost::asio::ssl::context pointers
-					/// stored in the m_hostContexts member and attempts to correctly free the X509
-					/// structure, the temporary negotiation EC key, and the EVP_PKEY structure for
-					/// each context, finally calling delete on the parent boost::asio::ssl::context structure.
+					/// Destructor stops the key pool thread and releases all cached contexts.
+					/// Contexts still held elsewhere, such as by a live bridge, are freed when the
+					/// last holder lets go of them.
 					/// </summary>
 					virtual ~BaseInMemoryCertificateStore();
 
@@ -105,6 +161,16 @@ namespace te
 					/// Every generated boost::asio::ssl::context is set to be a TLS1.2 server
 					/// context.
 					/// 
+					/// The cache is bounded by the limits set with ::SetContextCacheLimits(...).
+					/// When inserting a new context takes the cache over a limit, the least
+					/// recently used contexts are evicted. Callers share ownership of the returned
+					/// context, so an evicted context remains valid for as long as it's held.
+					/// 
+					/// Safe to call concurrently. Lookups for hosts that have already been
+					/// spoofed only take a shared lock. Concurrent first requests for the same
+					/// host share a single generation, and generation for one host never blocks
+					/// requests for any other host.
+					/// 
 					/// As with basically every other method in this class, this can throw
 					/// runtime_error in the event that even a single openSSL operation does not
 					/// return a value indicating a successful operation. The ::what() member of the
@@ -130,11 +196,11 @@ namespace te
 					/// certificates once issued from here.
 					/// </param>
 					/// <returns>
-					/// A pointer to the generated boost::asio::ssl::context object that been
-					/// configured to utilize the successfully spoofed certificate, keypair and
-					/// temporary negotiation EC key in a server context.
+					/// A shared pointer to the generated boost::asio::ssl::context object that
+					/// been configured to utilize the successfully spoofed certificate, keypair
+					/// and temporary negotiation EC key in a server context.
 					/// </returns>
-					boost::asio::ssl::context* GetServerContext(const std::string& hostname, X509* certificate);
+					std::shared_ptr<boost::asio::ssl::context> GetServerContext(const std::string& hostname, X509* certificate);
 
 					/// <summary>
 					/// Attempts to install the current temporary root CA certificate for
@@ -175,18 +241,112 @@ namespace te
 					/// </returns>
 					std::vector<char> GetRootCertificatePEM() const;
 
+					/// <summary>
+					/// Sets the number of EC keypairs that the background thread tries to keep
+					/// generated ahead of time, so that spoofing a certificate for a host we have
+					/// never seen before doesn't have to generate one on the request path. Can
+					/// be called at any time. A depth of zero disables the pool.
+					/// </summary>
+					/// <param name="depth">
+					/// The number of keypairs to keep available.
+					/// </param>
+					void SetKeyPoolDepth(const uint32_t depth);
+
+					/// <summary>
+					/// Gets a snapshot of the counters kept by this store.
+					/// </summary>
+					/// <returns>
+					/// A snapshot of the current counters.
+					/// </returns>
+					CertificateStoreStats GetStats();
+
+					/// <summary>
+					/// Sets the limits for the spoofed context cache. If the cache is presently
+					/// over either new limit, the least recently used contexts are evicted
+					/// immediately.
+					/// </summary>
+					/// <param name="maxContexts">
+					/// The maximum number of contexts to cache. Zero for no limit.
+					/// </param>
+					/// <param name="maxBytes">
+					/// The maximum approximate number of bytes the cached contexts may hold. Zero
+					/// for no limit.
+					/// </param>
+					void SetContextCacheLimits(const uint32_t maxContexts, const uint64_t maxBytes);
+
 				protected:
 
+					/// <summary>
+					/// The default number of keypairs kept in the pool.
+					/// </summary>
+					static constexpr uint32_t DefaultKeyPoolDepth = 8;
+
+					/// <summary>
+					/// The default maximum number of cached contexts.
+					/// </summary>
+					static constexpr uint32_t DefaultMaxContexts = 2048;
+
+					/// <summary>
+					/// The default maximum approximate bytes held by cached contexts.
+					/// </summary>
+					static constexpr uint64_t DefaultMaxContextBytes = 64 * 1024 * 1024;
+
+					/// <summary>
+					/// Rough allowance for everything a server context holds besides its
+					/// certificate and key, such as the SSL_CTX itself and its session cache.
+					/// </summary>
+					static constexpr size_t ApproximateContextOverhead = 8192;
+
+					/// <summary>
+					/// A cached server context, along with every name that maps to it.
+					/// </summary>
+					struct ContextEntry
+					{
+						std::shared_ptr<boost::asio::ssl::context> context;
+
+						/// <summary>
+						/// Every key in m_hostContexts that points to this entry.
+						/// </summary>
+						std::vector<std::string> names;
+
+						size_t approximateBytes = 0;
+
+						/// <summary>
+						/// Stamp from m_contextClock at the last lookup. Atomic so that lookups can
+						/// refresh it while only holding a shared lock.
+						/// </summary>
+						std::atomic_uint64_t lastUsed;
+					};
+
 					/// <summary>
 					/// Lock for spoofing.
 					/// </summary>
 					using ScopedLock = std::lock_guard<std::mutex>;
 
 					/// <summary>
-					/// For synchronizing local storage of generated keys, certificates and contexts.
+					/// Shared lock for reading m_hostContexts.
+					/// </summary>
+					using SharedLock = std::shared_lock<std::shared_timed_mutex>;
+
+					/// <summary>
+					/// Exclusive lock for writing m_hostContexts.
+					/// </summary>
+					using UniqueLock = std::unique_lock<std::shared_timed_mutex>;
+
+					/// <summary>
+					/// For synchronizing access to m_pendingContexts. When both this and
+					/// m_contextsMutex are needed, this must be acquired first.
 					/// </summary>
 					std::mutex m_spoofMutex;
 
+					/// <summary>
+					/// For synchronizing access to m_hostContexts. Lookups take this shared, so
+					/// that handshakes for hosts that have already been spoofed never contend
+					/// with one another. It is only taken exclusively to insert a finished
+					/// context, never while a certificate is being generated.
+					/// </summary>
+					std::shared_timed_mutex m_contextsMutex;
+
 					/// <summary>
 					/// Stores either the provided or default country code information to use for
 					/// the self signed CA certificate.
@@ -219,9 +379,154 @@ namespace te
 					/// <summary>
 					/// Stores generated contexts using the host name as the lookup key. Due to the
 					/// existence of SAN's or Subject Alternative Names, it's possible to have
-					/// multiple keys pointing to the same structure. This makes cleanup a little tricky.
+					/// multiple keys pointing to the same entry.
+					/// </summary>
+					std::unordered_map<std::string, std::shared_ptr<ContextEntry>> m_hostContexts;
+
+					/// <summary>
+					/// Every cached entry exactly once, regardless of how many names it has. Used for
+					/// eviction.
+					/// </summary>
+					std::vector<std::shared_ptr<ContextEntry>> m_contextEntries;
+
+					/// <summary>
+					/// Sum of the approximate bytes of every entry in m_contextEntries.
+					/// </summary>
+					uint64_t m_contextBytes = 0;
+
+					uint32_t m_maxContexts = DefaultMaxContexts;
+
+					uint64_t m_maxContextBytes = DefaultMaxContextBytes;
+
+					/// <summary>
+					/// Logical clock used to stamp ContextEntry::lastUsed.
+					/// </summary>
+					std::atomic_uint64_t m_contextClock;
+
+					std::atomic_uint64_t m_contextEvictions;
+
+					/// <summary>
+					/// Stores the result, once available, of every context currently being
+					/// generated, using the requested host name as the lookup key. When several
+					/// handshakes for a host we have never seen arrive at once, the first one
+					/// generates the context and the rest wait on its result here, rather than
+					/// each generating their own.
+					/// </summary>
+					std::unordered_map<std::string, std::shared_future<std::shared_ptr<boost::asio::ssl::context>>> m_pendingContexts;
+
+					/// <summary>
+					/// Keypairs generated ahead of time by the key pool thread.
+					/// </summary>
+					std::deque<EVP_PKEY*> m_keyPool;
+
+					/// <summary>
+					/// For synchronizing access to m_keyPool and m_keyPoolDepth.
+					/// </summary>
+					std::mutex m_keyPoolMutex;
+
+					/// <summary>
+					/// Signalled whenever a keypair is taken from the pool, the depth changes, or
+					/// the pool is shutting down.
+					/// </summary>
+					std::condition_variable m_keyPoolCv;
+
+					/// <summary>
+					/// The number of keypairs the key pool thread tries to keep in m_keyPool.
+					/// </summary>
+					uint32_t m_keyPoolDepth = DefaultKeyPoolDepth;
+
+					/// <summary>
+					/// Keeps the key pool thread alive.
+					/// </summary>
+					bool m_keyPoolRunning = false;
+
+					/// <summary>
+					/// The thread that keeps m_keyPool filled. Runs at a reduced priority so that it
+					/// never competes with the proxy itself.
+					/// </summary>
+					std::thread m_keyPoolThread;
+
+					std::atomic_uint64_t m_keyPoolHits;
+
+					std::atomic_uint64_t m_keyPoolStalls;
+
+					/// <summary>
+					/// Runs on m_keyPoolThread, generating keypairs whenever m_keyPool has fewer
+					/// than m_keyPoolDepth available.
+					/// </summary>
+					void RunKeyPool();
+
+					/// <summary>
+					/// Takes a keypair from the pool if one is available. Otherwise counts a stall
+					/// and generates one on the spot with ::GenerateEcKey(). Can throw the same
+					/// as ::GenerateEcKey().
+					/// </summary>
+					/// <returns>
+					/// A pointer to an EVP_PKEY structure containing a NID_X9_62_prime256v1 EC
+					/// key, owned by the caller.
+					/// </returns>
+					EVP_PKEY* AcquireEcKey();
+
+					/// <summary>
+					/// Clones the supplied certificate insofar as is necessary to pass inspection
+					/// once signed with our CA, then allocates and configures a new
+					/// boost::asio::ssl::context to serve it. Does not touch m_hostContexts and
+					/// requires no locks to be held, as the CA members are never modified after
+					/// construction. The keypair for the new certificate is taken from the key
+					/// pool.
+					/// 
+					/// Throws runtime_error on any failure, same as ::GetServerContext(...).
+					/// </summary>
+					/// <param name="originalCertificate">
+					/// A valid pointer to the received, already validated upstream certificate to
+					/// spoof.
+					/// </param>
+					/// <param name="sanDomains">
+					/// Populated with every DNS subject alt name that was copied from the original
+					/// certificate, lower cased.
+					/// </param>
+					/// <returns>
+					/// A pointer to the newly allocated server context.
+					/// </returns>
+					boost::asio::ssl::context* GenerateServerContext(X509* originalCertificate, std::vector<std::string>& sanDomains);
+
+					/// <summary>
+					/// Frees the certificate and keypair owned by the supplied context, generated
+					/// by ::GenerateServerContext(...), then the context itself.
+					/// </summary>
+					/// <param name="ctx">
+					/// The context to free.
+					/// </param>
+					static void FreeServerContext(boost::asio::ssl::context* ctx);
+
+					/// <summary>
+					/// Evicts least recently used entries until the cache is within its limits.
+					/// Caller must hold m_contextsMutex exclusively.
+					/// </summary>
+					/// <param name="keep">
+					/// An entry that must not be evicted, typically the one just inserted. May be
+					/// nullptr.
+					/// </param>
+					void EvictOverLimit(const ContextEntry* keep);
+
+					/// <summary>
+					/// Estimates the number of bytes held by the supplied server context.
+					/// </summary>
+					/// <param name="ctx">
+					/// The context, generated by ::GenerateServerContext(...).
+					/// </param>
+					/// <returns>
+					/// The approximate size in bytes.
+					/// </returns>
+					static size_t ApproximateContextSize(boost::asio::ssl::context* ctx);
+
+					/// <summary>
+					/// Gets the next stamp for ContextEntry::lastUsed.
 					/// </summary>
-					std::unordered_map<std::string, boost::asio::ssl::context*> m_hostContexts;								
+					inline uint64_t NextContextTick()
+					{
+						return m_contextClock.fetch_add(1, std::memory_order_relaxed) + 1;
+					}
 
 					/// <summary>
 					/// Generates an EC key with the given named curve. As with basically every
@@ -8,11 +8,14 @@
 #pragma once
 
 #include "TlsCapableHttpBridge.hpp"
+#include "TlsSessionCache.hpp"
+#include "UpstreamConnectionPool.hpp"
 #include "../../util/cb/EventReporter.hpp"
 
 #include <boost/asio.hpp>
 #include <type_traits>
 #include <memory>
+#include <vector>
 #include <boost/predef/os.h>
 #include <stdexcept>
 
@@ -97,6 +100,27 @@ namespace te
 					/// 
 					/// This parameter is only required when AcceptorType is network::TlsSocket.
 					/// </param>
+					/// <param name="dnsCache">
+					/// An optional pointer to the cache of resolved upstream hosts, supplied to
+					/// every bridge. Must outlive the acceptor.
+					/// </param>
+					/// <param name="deferredVerdicts">
+					/// An optional pointer to the registry of verdicts deferred by the callbacks,
+					/// supplied to every bridge. Must outlive the acceptor.
+					/// </param>
+					/// <param name="verdictCache">
+					/// An optional pointer to the cache of begin callback verdicts, supplied to
+					/// every bridge. Must outlive the acceptor.
+					/// </param>
+					/// <param name="rules">
+					/// An optional pointer to the table of rules checked ahead of the begin
+					/// callback, supplied to every bridge. Must outlive the acceptor.
+					/// </param>
+					/// <param name="timerWheel">
+					/// An optional pointer to the timer wheel driven by the supplied service, which
+					/// keeps the stream timeouts of the bridges it drives. Must outlive the
+					/// acceptor.
+					/// </param>
 					/// <param name="onInfoCb">
 					/// An optional callback for general information about non-critical events.
 					/// </param>
@@ -112,8 +136,14 @@ namespace te
 						uint16_t port = 0,
 						const std::string& caBundleAbsPath = std::string(u8"none"),
 						BaseInMemoryCertificateStore* store = nullptr,
+						network::DnsCache* dnsCache = nullptr,
+						util::cb::DeferredVerdictRegistry* deferredVerdicts = nullptr,
+						util::cb::VerdictCache* verdictCache = nullptr,
+						util::cb::RuleTable* rules = nullptr,
+						network::TimerWheel* timerWheel = nullptr,
 						util::cb::HttpMessageBeginCheckFunction onMessageBegin = nullptr,
 						util::cb::HttpMessageEndCheckFunction onMessageEnd = nullptr,
+						util::cb::HttpMessageChunkCheckFunction onMessageChunk = nullptr,
 						util::cb::MessageFunction onInfoCb = nullptr,
 						util::cb::MessageFunction onWarnCb = nullptr,
 						util::cb::MessageFunction onErrorCb = nullptr
@@ -123,11 +153,17 @@ namespace te
 						m_service(service),
 						m_caBundleAbsolutePath(caBundleAbsPath),
 						m_store(store),
+						m_dnsCache(dnsCache),
+						m_deferredVerdicts(deferredVerdicts),
+						m_verdictCache(verdictCache),
+						m_rules(rules),
+						m_timerWheel(timerWheel),
 						m_acceptor(*service), // Don't use a ctor here that auto opens and binds the listener!
 						m_clientContext(*service, boost::asio::ssl::context::sslv23_client),
 						m_defaultServerContext(*service, boost::asio::ssl::context::tlsv12_server),
 						m_onMessageBegin(onMessageBegin),
-						m_onMessageEnd(onMessageEnd)
+						m_onMessageEnd(onMessageEnd),
+						m_onMessageChunk(onMessageChunk)
 					{	
 						bool isTls = std::is_same<AcceptorType, network::TlsSocket>::value;
 						#ifndef NDEBUG
@@ -216,7 +252,19 @@ namespace te
 						{
 							try
 							{
-								SharedBridge session = std::make_shared<TlsCapableHttpBridge<AcceptorType>>(m_service, m_store, &m_defaultServerContext, &m_clientContext, m_onMessageBegin, m_onMessageEnd, m_onInfo, m_onWarning, m_onError);
+								// With bridge services, each bridge lives on the single thread running
+								// the one it's handed, so it has no need for strands.
+								boost::asio::io_service* bridgeService = m_service;
+								network::TimerWheel* bridgeTimerWheel = m_timerWheel;
+
+								if (m_bridgeServices.size() > 0)
+								{
+									bridgeService = m_bridgeServices[m_nextBridgeService];
+									bridgeTimerWheel = m_bridgeTimerWheels[m_nextBridgeService];
+									m_nextBridgeService = (m_nextBridgeService + 1) % m_bridgeServices.size();
+								}
+
+								SharedBridge session = std::make_shared<TlsCapableHttpBridge<AcceptorType>>(bridgeService, m_store, &m_defaultServerContext, &m_clientContext, &m_sessionCache, &m_upstreamPool, m_dnsCache, m_deferredVerdicts, m_verdictCache, m_rules, bridgeTimerWheel, m_onMessageBegin, m_onMessageEnd, m_onMessageChunk, m_onInfo, m_onWarning, m_onError, m_bridgeServices.size() == 0);
 
 								if (session == nullptr)
 								{
@@ -238,6 +286,74 @@ namespace te
 						return false;
 					}
 
+					/// <summary>
+					/// Gets a snapshot of the TLS handshake and resumption counters for bridges
+					/// created by this acceptor. Always zeroed when AcceptorType is
+					/// network::TcpSocket.
+					/// </summary>
+					/// <returns>
+					/// The current TLS handshake counters.
+					/// </returns>
+					TlsSessionStats GetSessionStats() const
+					{
+						return m_sessionCache.GetStats();
+					}
+
+					/// <summary>
+					/// Gets a snapshot of the counters of the pool of idle upstream connections
+					/// shared by bridges created by this acceptor.
+					/// </summary>
+					/// <returns>
+					/// The current upstream connection pool counters.
+					/// </returns>
+					UpstreamPoolStats GetUpstreamPoolStats() const
+					{
+						return m_upstreamPool.GetStats();
+					}
+
+					/// <summary>
+					/// Sets the limits of the pool of idle upstream connections. Can be called at
+					/// any time.
+					/// </summary>
+					/// <param name="maxIdlePerHost">
+					/// The maximum number of idle connections kept per host. Zero disables
+					/// pooling.
+					/// </param>
+					/// <param name="maxIdle">
+					/// The maximum number of idle connections kept in total. Zero disables
+					/// pooling.
+					/// </param>
+					/// <param name="idleTimeoutSeconds">
+					/// The number of seconds an idle connection is kept.
+					/// </param>
+					void SetUpstreamPoolLimits(const uint32_t maxIdlePerHost, const uint32_t maxIdle, const uint32_t idleTimeoutSeconds)
+					{
+						m_upstreamPool.SetLimits(maxIdlePerHost, maxIdle, idleTimeoutSeconds);
+					}
+
+					/// <summary>
+					/// Sets the io_services that newly accepted bridges are handed to, in turn,
+					/// instead of the one driving the acceptor. Each of them must be run by exactly
+					/// one thread, since bridges handed to them don't serialize their handlers.
+					/// Must be called before ::AcceptConnections().
+					/// </summary>
+					/// <param name="services">
+					/// The io_services to hand bridges to. If empty, bridges are driven by the
+					/// io_service driving the acceptor, which may be run by any number of threads.
+					/// </param>
+					/// <param name="timerWheels">
+					/// The timer wheel driven by each of the supplied io_services, in the same
+					/// order. Entries may be nullptr.
+					/// </param>
+					void SetBridgeServices(std::vector<boost::asio::io_service*> services, std::vector<network::TimerWheel*> timerWheels)
+					{
+						timerWheels.resize(services.size(), nullptr);
+
+						m_bridgeServices = std::move(services);
+						m_bridgeTimerWheels = std::move(timerWheels);
+						m_nextBridgeService = 0;
+					}
+
 					/// <summary>
 					/// Cancels any pending async_accept calls, breaking the accept loop and thus
 					/// stopping the acceptor from accepting any new client connections.
@@ -259,6 +375,7 @@ namespace te
 
 					util::cb::HttpMessageBeginCheckFunction m_onMessageBegin;
 					util::cb::HttpMessageEndCheckFunction m_onMessageEnd;
+					util::cb::HttpMessageChunkCheckFunction m_onMessageChunk;
 
 					/// <summary>
 					/// Initializes the default server and the client contexts, which are to be used
@@ -287,6 +404,16 @@ namespace te
                         SSL_CTX_set_ecdh_auto(m_defaultServerContext.native_handle(), 1);
                         SSL_CTX_set_ecdh_auto(m_clientContext.native_handle(), 1);
 
+						if (!TlsSessionCache::ConfigureServerContext(m_defaultServerContext.native_handle()))
+						{
+							ReportWarning(u8"In TlsCapableHttpAcceptor::InitContexts() - Failed to configure session resumption on the default server context.");
+						}
+
+						if (!ApplicationProtocols::ConfigureServerContext(m_defaultServerContext.native_handle()))
+						{
+							ReportWarning(u8"In TlsCapableHttpAcceptor::InitContexts() - Failed to configure ALPN on the default server context.");
+						}
+
 						//m_defaultServerContext.set_verify_mode(boost::asio::ssl::context::verify_peer | boost::asio::ssl::context::verify_fail_if_no_peer_cert);
 
 						if (m_caBundleAbsolutePath.compare(u8"none") != 0)
@@ -346,7 +473,16 @@ namespace te
 					{
 						if (!error && session.get() != nullptr)
 						{
-							session->Start();
+							if (m_bridgeServices.size() > 0)
+							{
+								// Started on the thread of its own io_service, which from here on is
+								// the only one to ever touch it.
+								session->DownstreamSocket().get_io_service().post(std::bind(&TlsCapableHttpBridge<AcceptorType>::Start, session));
+							}
+							else
+							{
+								session->Start();
+							}
 
 							if (!AcceptConnections())
 							{
@@ -371,6 +507,23 @@ namespace te
 					/// Pointer to the io_service driving the acceptor.
 					/// </summary>
 					boost::asio::io_service* m_service = nullptr;
+
+					/// <summary>
+					/// The io_services bridges are handed to, in turn. Empty when bridges are driven
+					/// by m_service.
+					/// </summary>
+					std::vector<boost::asio::io_service*> m_bridgeServices;
+
+					/// <summary>
+					/// The timer wheel driven by each of m_bridgeServices.
+					/// </summary>
+					std::vector<network::TimerWheel*> m_bridgeTimerWheels;
+
+					/// <summary>
+					/// Index of the io_service in m_bridgeServices the next bridge is handed to.
+					/// Only touched by the accept loop, which never runs concurrently with itself.
+					/// </summary>
+					size_t m_nextBridgeService = 0;
 					
 					/// <summary>
 					/// Absolute path to a CA bundle to be loaded by the client context, in the
@@ -389,6 +542,36 @@ namespace te
 					/// </summary>
 					BaseInMemoryCertificateStore* m_store = nullptr;
 
+					/// <summary>
+					/// Pointer to the cache of resolved upstream hosts to be supplied to each
+					/// bridge. May be nullptr.
+					/// </summary>
+					network::DnsCache* m_dnsCache = nullptr;
+
+					/// <summary>
+					/// Pointer to the registry of deferred verdicts to be supplied to each bridge.
+					/// May be nullptr.
+					/// </summary>
+					util::cb::DeferredVerdictRegistry* m_deferredVerdicts = nullptr;
+
+					/// <summary>
+					/// Pointer to the cache of begin callback verdicts to be supplied to each
+					/// bridge. May be nullptr.
+					/// </summary>
+					util::cb::VerdictCache* m_verdictCache = nullptr;
+
+					/// <summary>
+					/// Pointer to the table of rules to be supplied to each bridge. May be
+					/// nullptr.
+					/// </summary>
+					util::cb::RuleTable* m_rules = nullptr;
+
+					/// <summary>
+					/// Pointer to the timer wheel driven by m_service, to be supplied to each
+					/// bridge driven by it. May be nullptr.
+					/// </summary>
+					network::TimerWheel* m_timerWheel = nullptr;
+
 					/// <summary>
 					/// The underlying TCP acceptor itself.
 					/// </summary>
@@ -406,7 +589,19 @@ namespace te
 					/// for anything, except to construct a ::asio::ssl_stream object within Tls
 					/// client bridges.
 					/// </summary>
-					boost::asio::ssl::context m_defaultServerContext;				
+					boost::asio::ssl::context m_defaultServerContext;
+
+					/// <summary>
+					/// Upstream sessions and handshake counters shared by every Tls client bridge.
+					/// Only used when AcceptorType is network::TlsSocket.
+					/// </summary>
+					TlsSessionCache m_sessionCache;
+
+					/// <summary>
+					/// Idle keep-alive upstream connections shared by every bridge created by this
+					/// acceptor.
+					/// </summary>
+					UpstreamConnectionPool<AcceptorType> m_upstreamPool;
 
 				};
 
@@ -23,42 +23,58 @@ namespace te
 				template <typename T>
 				std::atomic_flag TlsCapableHttpBridge<T>::s_clientContextLock = ATOMIC_FLAG_INIT;
 
-                template <typename T>
-                constexpr uint32_t TlsCapableHttpBridge<T>::s_streamChannelMultiplier = 10;
-
-                template <typename T>
-                util::cb::CStreamCopyUtilContainer<std::is_same<T, network::TlsSocket>::value, TlsCapableHttpBridge<T>::s_streamChannelMultiplier> TlsCapableHttpBridge<T>::s_streamCopyContainer;
-
 				TlsCapableHttpBridge<network::TcpSocket>::TlsCapableHttpBridge(
 					boost::asio::io_service* service,
 					BaseInMemoryCertificateStore* certStore,
 					boost::asio::ssl::context* defaultServerContext,
 					boost::asio::ssl::context* clientContext,
+					TlsSessionCache* sessionCache,
+					UpstreamConnectionPool<network::TcpSocket>* upstreamPool,
+					network::DnsCache* dnsCache,
+					util::cb::DeferredVerdictRegistry* deferredVerdicts,
+					util::cb::VerdictCache* verdictCache,
+					util::cb::RuleTable* rules,
+					network::TimerWheel* timerWheel,
 					util::cb::HttpMessageBeginCheckFunction onMessageBegin,
 					util::cb::HttpMessageEndCheckFunction onMessageEnd,
+					util::cb::HttpMessageChunkCheckFunction onMessageChunk,
 					util::cb::MessageFunction onInfoCb,
 					util::cb::MessageFunction onWarnCb,
-					util::cb::MessageFunction onErrorCb
+					util::cb::MessageFunction onErrorCb,
+					const bool serializeHandlers
 					) :
 					util::cb::EventReporter(
 						onInfoCb, 
 						onWarnCb, 
 						onErrorCb
 						),
-					m_upstreamSocket(*service), 
+					m_upstreamSocket(std::make_shared<network::TcpSocket>(*service)),
 					m_downstreamSocket(*service),
-					m_upstreamStrand(*service),
-					m_downstreamStrand(*service),
+					m_upstreamStrand(*service, serializeHandlers),
+					m_downstreamStrand(*service, serializeHandlers),
 					m_resolver(*service),
-					m_streamTimer(*service),
+					m_verdictTimer(*service),
 					m_certStore(certStore),
+					m_sessionCache(sessionCache),
+					m_upstreamPool(upstreamPool),
+					m_dnsCache(dnsCache),
+					m_deferredVerdicts(deferredVerdicts),
+					m_verdictCache(verdictCache),
+					m_rules(rules),
+					m_timerWheel(timerWheel),
+					m_service(service),
+					m_clientContext(clientContext),
 					m_onMessageBegin(onMessageBegin),
-					m_onMessageEnd(onMessageEnd)
+					m_onMessageEnd(onMessageEnd),
+					m_onMessageChunk(onMessageChunk)
 				{	
 
 					// We purposely don't catch here. We want the acceptor to catch.
-					m_request.reset(new http::HttpRequest());
-					m_response.reset(new http::HttpResponse());
+					// Each transaction gets an arena of its own, which it resets between
+					// exchanges, so a long lived connection doesn't allocate for its headers
+					// beyond the first block.
+					m_request.reset(new http::HttpRequest(std::make_shared<util::mem::Arena>()));
+					m_response.reset(new http::HttpResponse(std::make_shared<util::mem::Arena>()));
 					
 					// XXX TODO - This is ugly, our bad design is showing. See notes in the
 					// EventReporter class header.
@@ -68,6 +84,8 @@ namespace te
 					m_response->SetOnInfo(m_onInfo);
 					m_response->SetOnWarning(m_onWarning);
 					m_response->SetOnError(m_onError);
+
+					util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::BridgesOpened);
 				}
 				
 				TlsCapableHttpBridge<network::TlsSocket>::TlsCapableHttpBridge(
@@ -75,11 +93,20 @@ namespace te
 					BaseInMemoryCertificateStore* certStore,
 					boost::asio::ssl::context* defaultServerContext,
 					boost::asio::ssl::context* clientContext,
+					TlsSessionCache* sessionCache,
+					UpstreamConnectionPool<network::TlsSocket>* upstreamPool,
+					network::DnsCache* dnsCache,
+					util::cb::DeferredVerdictRegistry* deferredVerdicts,
+					util::cb::VerdictCache* verdictCache,
+					util::cb::RuleTable* rules,
+					network::TimerWheel* timerWheel,
 					util::cb::HttpMessageBeginCheckFunction onMessageBegin,
 					util::cb::HttpMessageEndCheckFunction onMessageEnd,
+					util::cb::HttpMessageChunkCheckFunction onMessageChunk,
 					util::cb::MessageFunction onInfoCb,
 					util::cb::MessageFunction onWarnCb,
-					util::cb::MessageFunction onErrorCb
+					util::cb::MessageFunction onErrorCb,
+					const bool serializeHandlers
 					)
 					:
 					util::cb::EventReporter(
@@ -87,15 +114,25 @@ namespace te
 						onWarnCb,
 						onErrorCb
 						),
-					m_upstreamSocket(*service, *clientContext),
+					m_upstreamSocket(std::make_shared<network::TlsSocket>(*service, *clientContext)),
 					m_downstreamSocket(*service, *defaultServerContext),
-					m_upstreamStrand(*service),
-					m_downstreamStrand(*service),
+					m_upstreamStrand(*service, serializeHandlers),
+					m_downstreamStrand(*service, serializeHandlers),
 					m_resolver(*service),
-					m_streamTimer(*service),
+					m_verdictTimer(*service),
 					m_certStore(certStore),
+					m_sessionCache(sessionCache),
+					m_upstreamPool(upstreamPool),
+					m_dnsCache(dnsCache),
+					m_deferredVerdicts(deferredVerdicts),
+					m_verdictCache(verdictCache),
+					m_rules(rules),
+					m_timerWheel(timerWheel),
+					m_service(service),
+					m_clientContext(clientContext),
 					m_onMessageBegin(onMessageBegin),
-					m_onMessageEnd(onMessageEnd)
+					m_onMessageEnd(onMessageEnd),
+					m_onMessageChunk(onMessageChunk)
 				{
 					#ifndef NDEBUG
 						assert(m_certStore != nullptr && u8"In TlsCapableHttpBridge<network::TlsSocket>::TlsCapableHttpBridge(... args) - Supplied certificate store is nullptr!");						
@@ -109,11 +146,11 @@ namespace te
 
 					// We purposely don't catch here. We want the acceptor to catch
 					// this.
-					m_request.reset(new http::HttpRequest());
-					m_response.reset(new http::HttpResponse());
-
-					// Init TLS peek buffer.
-					m_tlsPeekBuffer.reset(new std::array<char, TlsPeekBufferSize>());	
+					// Each transaction gets an arena of its own, which it resets between
+					// exchanges, so a long lived connection doesn't allocate for its headers
+					// beyond the first block.
+					m_request.reset(new http::HttpRequest(std::make_shared<util::mem::Arena>()));
+					m_response.reset(new http::HttpResponse(std::make_shared<util::mem::Arena>()));
 
 					// XXX TODO - This is ugly, our bad design is showing. See notes in the
 					// EventReporter class header.
@@ -125,6 +162,20 @@ namespace te
 					m_response->SetOnWarning(m_onWarning);
 					m_response->SetOnError(m_onError);
 
+					util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::BridgesOpened);
+
+				}
+
+				template<>
+				std::shared_ptr<network::TcpSocket> TlsCapableHttpBridge<network::TcpSocket>::NewUpstreamSocket()
+				{
+					return std::make_shared<network::TcpSocket>(*m_service);
+				}
+
+				template<>
+				std::shared_ptr<network::TlsSocket> TlsCapableHttpBridge<network::TlsSocket>::NewUpstreamSocket()
+				{
+					return std::make_shared<network::TlsSocket>(*m_service, *m_clientContext);
 				}
 
 				template<>
@@ -154,10 +205,12 @@ namespace te
 					{
 						SetStreamTimeout(boost::posix_time::minutes(5));
 
+						m_tlsPeekBuffer = util::mem::BufferPool::Shared().Acquire(TlsPeekBufferSize);
+
 						// Start a peek read on the connected secure client, so we can attempt to extract the
 						// SNI hostname in the handler without screwing up the pending handshake.
 						m_downstreamSocket.next_layer().async_receive(
-							boost::asio::buffer(*m_tlsPeekBuffer.get(), m_tlsPeekBuffer->size()), 
+							boost::asio::buffer(m_tlsPeekBuffer->data(), m_tlsPeekBuffer->size()), 
 							boost::asio::ip::tcp::socket::message_peek,
 							m_downstreamStrand.wrap(
 								std::bind(&TlsCapableHttpBridge::OnTlsPeek, 
@@ -262,13 +315,13 @@ namespace te
 				template<>
 				boost::asio::ip::tcp::socket& TlsCapableHttpBridge<network::TcpSocket>::UpstreamSocket()
 				{
-					return m_upstreamSocket;
+					return *m_upstreamSocket;
 				}
 
 				template<>
 				boost::asio::ip::tcp::socket& TlsCapableHttpBridge<network::TlsSocket>::UpstreamSocket()
 				{
-					return m_upstreamSocket.next_layer();
+					return m_upstreamSocket->next_layer();
 				}
 
 				template<>
@@ -280,7 +333,9 @@ namespace te
 					#endif // !NDEBUG
 
 					if (!error)
-					{					
+					{
+						FinishStage(util::metrics::Stage::UpstreamConnect);
+					
 						if (m_request->IsPayloadComplete() == false && m_request->GetConsumeAllBeforeSending() == true)
 						{
 							// Means that there is a request payload, it's not complete, and it's been flagged
@@ -292,7 +347,7 @@ namespace te
 								auto requestReadBuffer = m_request->GetReadBuffer();
 
 								boost::asio::async_read(
-									m_downstreamSocket,
+									m_downstream,
 									requestReadBuffer,
 									boost::asio::transfer_at_least(1),
 									m_downstreamStrand.wrap(
@@ -322,7 +377,7 @@ namespace te
 						auto writeBuffer = m_request->GetWriteBuffer();
 						
 						boost::asio::async_write(
-							m_upstreamSocket, 
+							*m_upstreamSocket, 
 							writeBuffer, 
 							boost::asio::transfer_all(), 
 							m_upstreamStrand.wrap(
@@ -341,6 +396,12 @@ namespace te
 						std::string errMsg(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamConnect(const boost::system::error_code&) - Got error:\t");
 						errMsg.append(error.message());
 						ReportError(errMsg);
+
+						if (m_dnsCache != nullptr)
+						{
+							// Whatever address we used may be stale. Make the next bridge resolve again.
+							m_dnsCache->Remove(m_upstreamHost);
+						}
 					}
 					
 					Kill();
@@ -355,12 +416,14 @@ namespace te
 					#endif // !NDEBUG
 
 					if (!error)
-					{						
+					{
+						FinishStage(util::metrics::Stage::UpstreamConnect);
+						
 						SetStreamTimeout(boost::posix_time::minutes(5));
 
 						boost::system::error_code scerr;
 
-						m_upstreamSocket.set_verify_callback(
+						m_upstreamSocket->set_verify_callback(
 							std::bind(
 								&TlsCapableHttpBridge::VerifyServerCertificateCallback, 
 								shared_from_this(),
@@ -372,7 +435,9 @@ namespace te
 
 						if (!scerr)
 						{	
-							m_upstreamSocket.async_handshake(
+							StartStage();
+
+							m_upstreamSocket->async_handshake(
 								network::TlsSocket::client, 
 								m_upstreamStrand.wrap(
 									std::bind(
@@ -397,6 +462,11 @@ namespace te
 						std::string errMsg(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamConnect(const boost::system::error_code&) - Got error:\t");
 						errMsg.append(error.message());
 						ReportError(errMsg);
+
+						if (m_dnsCache != nullptr)
+						{
+							m_dnsCache->Remove(m_upstreamHost);
+						}
 					}
 
 					Kill();
@@ -412,6 +482,8 @@ namespace te
 
 					if (!error)
 					{
+						FinishStage(util::metrics::Stage::UpstreamResolve);
+
 						SetStreamTimeout(boost::posix_time::minutes(5));
 
 						//auto ep = *endpointIterator;
@@ -445,8 +517,10 @@ namespace te
 						// only take a crack at connecting to the first A record entry resolved, then
 						// quit if that first record does not work.
 
+						StartStage();
+
 						boost::asio::async_connect(
-							m_upstreamSocket,
+							*m_upstreamSocket,
 							endpointIterator,
 							std::bind(
 								&TlsCapableHttpBridge::OnUpstreamConnect,
@@ -454,7 +528,7 @@ namespace te
 								std::placeholders::_1
 							));
 						/*
-						m_upstreamSocket.async_connect(
+						m_upstreamSocket->async_connect(
 							ep, 
 							m_upstreamStrand.wrap(
 								std::bind(
@@ -486,12 +560,28 @@ namespace te
 
 					if (!error)
 					{
+						FinishStage(util::metrics::Stage::UpstreamResolve);
+
 						// Set up our host specific client context.
-						//InitClientContext(this, m_upstreamSocket, m_upstreamHost);
+						//InitClientContext(this, *m_upstreamSocket, m_upstreamHost);
 
 						SetStreamTimeout(boost::posix_time::minutes(5));
 
-						SSL_set_tlsext_host_name(m_upstreamSocket.native_handle(), m_upstreamHost.c_str());
+						SSL_set_tlsext_host_name(m_upstreamSocket->native_handle(), m_upstreamHost.c_str());
+
+						// We can only speak HTTP/1.1 on either side, so it's all we offer. Without
+						// this, a server picking its protocol from ALPN is left to guess.
+						if (!ApplicationProtocols::OfferClientProtocols(m_upstreamSocket->native_handle()))
+						{
+							ReportWarning(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnResolve(const boost::system::error_code&, boost::asio::ip::tcp::resolver::iterator) - Failed to set upstream ALPN protocols.");
+						}
+
+						if (m_sessionCache != nullptr)
+						{
+							// Offer the last session we had with this host, if any. If the server
+							// accepts it, the handshake skips the key exchange and verification.
+							m_sessionCache->OfferClientSession(m_upstreamSocket->native_handle(), m_upstreamHost, GetUpstreamPort());
+						}
 
 						// XXX TODO. The correct thing to do here is keep the iterator somehow, then in
 						// the completion handler, in the event of a connection related error, keep
@@ -500,15 +590,11 @@ namespace te
 						// only take a crack at connecting to the first A record entry resolved, then
 						// quit if that first record does not work.
 
-						// Note also that unlike the TCP version of this handler, we do not check the
-						// upstream host member for a port number. This is because, AFAIK, there is no
-						// such data in the SNI extension, the place where we get the hostname from.
-						//
-						// This could become a problem only depending on our implementation in the 
-						// packet diversion system. If we intercept TLS packets that are not destined
-						// for 443 and send them to this proxy, then we'll break the connection entirely.
-						// Care therefore needs to be taken, or a more robust system needs to be put in
-						// place starting at the diversion level.
+						// Note also that unlike the TCP version of this handler, the port doesn't come
+						// from the upstream host. There is no such data in the SNI extension, the place
+						// where we get the hostname from. It's the port the diverter recorded for our
+						// client instead, which ::OnTlsPeek(...) put in m_upstreamHostPort, so TLS
+						// diverted from ports other than 443 goes back to the port it came from.
 
 						if (m_upstreamHostPort != 0)
 						{
@@ -552,8 +638,10 @@ namespace te
 
 						boost::asio::ip::tcp::endpoint requestedEndpoint = *endpointIterator;
 
+						StartStage();
+
 						boost::asio::async_connect(
-							m_upstreamSocket.lowest_layer(),
+							m_upstreamSocket->lowest_layer(),
 							endpointIterator,
 							std::bind(
 								&TlsCapableHttpBridge::OnUpstreamConnect,
@@ -562,7 +650,7 @@ namespace te
 							));
 
 						/*
-						m_upstreamSocket.lowest_layer().async_connect(
+						m_upstreamSocket->lowest_layer().async_connect(
 							boost::asio::ip::tcp::endpoint(requestedEndpoint.address(), m_upstreamHostPort),
 							m_upstreamStrand.wrap(
 								std::bind(
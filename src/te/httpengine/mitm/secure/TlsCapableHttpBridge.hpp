@@ -12,16 +12,32 @@
 #include <boost/predef/compiler.h>
 #include <boost/algorithm/string.hpp>
 #include "../../network/SocketTypes.hpp"
+#include "../../network/DnsCache.hpp"
+#include "../../network/OptionalStrand.hpp"
+#include "../../network/TimerWheel.hpp"
+#include "../../network/OriginalPortTable.hpp"
 #include "BaseInMemoryCertificateStore.hpp"
+#include "ApplicationProtocols.hpp"
+#include "TlsSessionCache.hpp"
+#include "UpstreamConnectionPool.hpp"
 #include "../http/HttpRequest.hpp"
 #include "../http/HttpResponse.hpp"
+#include "../http2/Http2Connection.hpp"
 #include "../../util/cb/EventReporter.hpp"
-#include "../../util/cb/StreamCopyUtils.hpp"
+#include "../../util/cb/TransactionContext.hpp"
+#include "../../util/cb/DeferredVerdictRegistry.hpp"
+#include "../../util/cb/VerdictCache.hpp"
+#include "../../util/cb/RuleTable.hpp"
+#include "../../util/mem/Arena.hpp"
+#include "../../util/mem/BufferPool.hpp"
+#include "../../util/metrics/EngineMetrics.hpp"
+#include "../../util/tls/ClientHello.hpp"
 #include "../../../util/http/KnownHttpHeaders.hpp"
 #include "../../util/hash/StringHashUtils.hpp"
 
 #include <memory>
 #include <atomic>
+#include <functional>
 #include <type_traits>
 
 #if BOOST_OS_WINDOWS
@@ -178,7 +194,7 @@ namespace te
 					/// </summary>
 					/// <param name="service">
 					/// A valid pointer to the boost::asio::io_service that will drive the member
-					/// sockets, resolver, strands and timer.
+					/// sockets, resolver, strands and verdict timer.
 					/// </param>
 					/// <param name="certStore">
 					/// A pointer to the in-memory certificate store responsible for spoofing
@@ -200,7 +216,9 @@ namespace te
 					/// certificate store is consulted to either provide an existing context for the
 					/// host the client requested, or, once the real certificate has been fetched
 					/// upstream, spoof the certificate and return a server context built with the
-					/// spoofed certificate to serve the client.
+					/// spoofed certificate to serve the client. The one thing configured on it is
+					/// the downstream session cache, since OpenSSL keeps using the session cache of
+					/// the context a stream was created with.
 					/// </param>
 					/// <param name="clientContext">
 					/// A pointer to the default client context. Not required or used when
@@ -212,6 +230,38 @@ namespace te
 					/// uses this for verifying server certificates. In this context, the "client"
 					/// is the proxy.
 					/// </param>
+					/// <param name="sessionCache">
+					/// A pointer to the cache of upstream TLS sessions, which also keeps the
+					/// resumption counters for both legs. Not used when BridgeSocketType is
+					/// network::TcpSocket. Optional otherwise, if nullptr, every handshake is a
+					/// full handshake.
+					/// </param>
+					/// <param name="upstreamPool">
+					/// A pointer to the pool of idle upstream connections. Optional, if nullptr,
+					/// every bridge makes its own upstream connection and closes it when done.
+					/// </param>
+					/// <param name="dnsCache">
+					/// A pointer to the shared cache of resolved upstream hosts, consulted whenever
+					/// the original destination of the client can't be used. Optional, if nullptr,
+					/// every such connection resolves its host.
+					/// </param>
+					/// <param name="deferredVerdicts">
+					/// A pointer to the shared registry of verdicts deferred by the callbacks.
+					/// Optional, if nullptr, the callbacks must always answer right away.
+					/// </param>
+					/// <param name="verdictCache">
+					/// A pointer to the shared cache of begin callback verdicts, consulted before
+					/// the begin callback is invoked for a request. Optional, if nullptr, the
+					/// callback is invoked for every request.
+					/// </param>
+					/// <param name="rules">
+					/// A pointer to the shared table of rules, checked before the begin callback is
+					/// invoked. Optional, if nullptr, the callback is invoked for every message.
+					/// </param>
+					/// <param name="timerWheel">
+					/// A pointer to the timer wheel that keeps the stream timeout, driven by the
+					/// same io_service as the bridge. Optional, if nullptr, streams never time out.
+					/// </param>
 					/// <param name="onInfoCb">
 					/// A callback to receive generated information about general events. Data that
 					/// may be sent through this callback, if provided, is simply "verbose" output
@@ -237,16 +287,30 @@ namespace te
 					/// 
 					/// Consumers can inspect or log such events. Must be thread safe.
 					/// </param>
+					/// <param name="serializeHandlers">
+					/// Whether the handlers of the bridge need to be serialized through strands.
+					/// Only ever false when the supplied service is run by a single thread, in
+					/// which case handlers can't run concurrently to begin with.
+					/// </param>
 					TlsCapableHttpBridge(
 						boost::asio::io_service* service,						
 						BaseInMemoryCertificateStore* certStore = nullptr,
 						boost::asio::ssl::context* defaultServerContext = nullptr,
 						boost::asio::ssl::context* clientContext = nullptr,
+						TlsSessionCache* sessionCache = nullptr,
+						UpstreamConnectionPool<BridgeSocketType>* upstreamPool = nullptr,
+						network::DnsCache* dnsCache = nullptr,
+						util::cb::DeferredVerdictRegistry* deferredVerdicts = nullptr,
+						util::cb::VerdictCache* verdictCache = nullptr,
+						util::cb::RuleTable* rules = nullptr,
+						network::TimerWheel* timerWheel = nullptr,
 						util::cb::HttpMessageBeginCheckFunction onMessageBegin = nullptr,
 						util::cb::HttpMessageEndCheckFunction onMessageEnd = nullptr,
+						util::cb::HttpMessageChunkCheckFunction onMessageChunk = nullptr,
 						util::cb::MessageFunction onInfoCb = nullptr,
 						util::cb::MessageFunction onWarnCb = nullptr,
-						util::cb::MessageFunction onErrorCb = nullptr
+						util::cb::MessageFunction onErrorCb = nullptr,
+						const bool serializeHandlers = true
 						);
 
 					/// <summary>
@@ -261,11 +325,22 @@ namespace te
 					/// </summary>
 					~TlsCapableHttpBridge()
 					{
+						if (m_streamTimeout != nullptr)
+						{
+							m_streamTimeout->Cancel();
+						}
 
+						util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::BridgesClosed);
 					}
 
 				private:
 
+					/// <summary>
+					/// Picks a transaction up again once its deferred verdict is delivered, with
+					/// whether it should be blocked.
+					/// </summary>
+					using VerdictContinuation = std::function<void(const bool shouldBlock)>;
+
 					bool m_shouldTerminate = false;
 
 					/// <summary>
@@ -283,24 +358,88 @@ namespace te
 					/// <summary>
 					/// Socket used to connect to the client's desired host.
 					/// </summary>
-					BridgeSocketType m_upstreamSocket;
+					std::shared_ptr<BridgeSocketType> m_upstreamSocket;
 
 					/// <summary>
 					/// Socket used for connecting to the client.
 					/// </summary>
 					BridgeSocketType m_downstreamSocket;
 
+					/// <summary>
+					/// Set once HTTP/2 has been agreed on with the client, in which case the HTTP
+					/// transactions of the bridge are carried over it rather than straight over
+					/// m_downstreamSocket. Only ever set for network::TlsSocket.
+					/// </summary>
+					std::shared_ptr<http2::Http2Connection<BridgeSocketType>> m_http2;
+
+					/// <summary>
+					/// What the HTTP transactions of the bridge read requests from and write
+					/// responses to. That is m_downstreamSocket, unless HTTP/2 has been agreed on,
+					/// in which case it is m_http2. Either way, the same asio composed operations
+					/// work on it.
+					/// </summary>
+					class DownstreamStream
+					{
+
+					public:
+
+						DownstreamStream(TlsCapableHttpBridge& bridge)
+							:
+							m_bridge(bridge)
+						{
+
+						}
+
+						template<typename MutableBufferSequence, typename ReadHandler>
+						void async_read_some(const MutableBufferSequence& buffers, ReadHandler handler)
+						{
+							if (m_bridge.m_http2 != nullptr)
+							{
+								m_bridge.m_http2->async_read_some(buffers, handler);
+								return;
+							}
+
+							m_bridge.m_downstreamSocket.async_read_some(buffers, handler);
+						}
+
+						template<typename ConstBufferSequence, typename WriteHandler>
+						void async_write_some(const ConstBufferSequence& buffers, WriteHandler handler)
+						{
+							if (m_bridge.m_http2 != nullptr)
+							{
+								m_bridge.m_http2->async_write_some(buffers, handler);
+								return;
+							}
+
+							m_bridge.m_downstreamSocket.async_write_some(buffers, handler);
+						}
+
+						boost::asio::io_service& get_io_service()
+						{
+							return m_bridge.m_downstreamSocket.get_io_service();
+						}
+
+					private:
+
+						TlsCapableHttpBridge& m_bridge;
+
+					};
+
+					DownstreamStream m_downstream{ *this };
+
 					/// <summary>
 					/// For ensuring that asynchronous operation callback handlers involving the
-					/// upstream server connection are not concurrently executed.
+					/// upstream server connection are not concurrently executed. A pass through when
+					/// the bridge is driven by a single thread.
 					/// </summary>
-					boost::asio::strand m_upstreamStrand;
+					network::OptionalStrand m_upstreamStrand;
 
 					/// <summary>
 					/// For ensuring that asynchronous operation callback handlers involving the
-					/// downstream client connection are not concurrently executed.
+					/// downstream client connection are not concurrently executed. A pass through when
+					/// the bridge is driven by a single thread.
 					/// </summary>
-					boost::asio::strand m_downstreamStrand;
+					network::OptionalStrand m_downstreamStrand;
 
 					/// <summary>
 					/// Used for resolving the target upstream server after it has been discovered
@@ -309,14 +448,11 @@ namespace te
 					boost::asio::ip::tcp::resolver m_resolver;					
 
 					/// <summary>
-					/// To prevent asynchronous operations from hanging forever. This should be
-					/// reset with a specific timeout every time a new asynchrous operation is
-					/// initiated, and also when completed. The idea is that you must keep the timer
-					/// spinning beyond the previously set timeout, because once the timeout is
-					/// reached, the completion handler for the timeout will be invoked which will
-					/// cause the bridge to be terminated.
+					/// Limits how long the bridge stays parked waiting for a deferred verdict. Kept
+					/// apart from the stream timeout, so that whatever timeout was set for the
+					/// stream still holds once the verdict has been delivered.
 					/// </summary>
-					boost::asio::deadline_timer m_streamTimer;					
+					boost::asio::deadline_timer m_verdictTimer;
 
 					/// <summary>
 					/// Pointer to the in memory certificate store that is required for TLS
@@ -325,8 +461,86 @@ namespace te
 					/// </summary>
 					BaseInMemoryCertificateStore* m_certStore;
 
+					/// <summary>
+					/// Pointer to the shared cache of upstream TLS sessions. May be nullptr.
+					/// </summary>
+					TlsSessionCache* m_sessionCache;
+
+					/// <summary>
+					/// Pointer to the shared pool of idle upstream connections. May be nullptr.
+					/// </summary>
+					UpstreamConnectionPool<BridgeSocketType>* m_upstreamPool;
+
+					/// <summary>
+					/// Pointer to the shared cache of resolved upstream hosts. May be nullptr.
+					/// </summary>
+					network::DnsCache* m_dnsCache;
+
+					/// <summary>
+					/// Pointer to the shared registry of deferred verdicts. May be nullptr, in
+					/// which case the callbacks can't defer their verdict.
+					/// </summary>
+					util::cb::DeferredVerdictRegistry* m_deferredVerdicts;
+
+					/// <summary>
+					/// Pointer to the shared cache of begin callback verdicts. May be nullptr.
+					/// </summary>
+					util::cb::VerdictCache* m_verdictCache;
+
+					/// <summary>
+					/// Pointer to the shared table of rules. May be nullptr.
+					/// </summary>
+					util::cb::RuleTable* m_rules;
+
+					/// <summary>
+					/// Pointer to the timer wheel keeping the stream timeout. May be nullptr.
+					/// </summary>
+					network::TimerWheel* m_timerWheel;
+
+					/// <summary>
+					/// To prevent asynchronous operations from hanging forever. This should be
+					/// reset with a specific timeout every time a new asynchrous operation is
+					/// initiated, and also when completed. The idea is that you must keep the timer
+					/// spinning beyond the previously set timeout, because once the timeout is
+					/// reached, ::OnStreamTimeout() is invoked which will cause the bridge to be
+					/// terminated. Made on the first ::SetStreamTimeout(...), as it needs a weak
+					/// reference to the bridge.
+					/// </summary>
+					std::shared_ptr<network::TimerWheel::Timer> m_streamTimeout;
+
+					/// <summary>
+					/// When the resolve, connect or handshake presently underway started, for the
+					/// stage histograms. Default when none is, such as when a pooled connection is
+					/// picked up instead of connecting.
+					/// </summary>
+					util::metrics::EngineMetrics::Clock::time_point m_stageStarted;
+
+					/// <summary>
+					/// Kept so that a fresh upstream socket can be created after the connected one
+					/// has been handed to the pool.
+					/// </summary>
+					boost::asio::io_service* m_service;
+
+					/// <summary>
+					/// The client context upstream TLS streams are created with. Not used when
+					/// BridgeSocketType is network::TcpSocket.
+					/// </summary>
+					boost::asio::ssl::context* m_clientContext;
+
+					/// <summary>
+					/// Indicates that the upstream connection is connected and idle, because the
+					/// last transaction completed cleanly with keep-alive and no new request has
+					/// been written to it yet. Only in this state may ::Kill() hand the connection
+					/// to the pool rather than close it. Set from the strands, and read by ::Kill()
+					/// from wherever it's called. Only ever cleared by ::Kill() or through
+					/// ::ClaimUpstream(), both under m_killLock, so that the connection can't be
+					/// both used again and pooled.
+					/// </summary>
+					std::atomic_bool m_upstreamIdle{ false };
+
 					util::cb::HttpMessageBeginCheckFunction m_onMessageBegin;
 					util::cb::HttpMessageEndCheckFunction m_onMessageEnd;
+					util::cb::HttpMessageChunkCheckFunction m_onMessageChunk;
 
 					/// <summary>
 					/// Member that is to be set whenever the upstream certificate verification
@@ -336,6 +550,13 @@ namespace te
 					/// </summary>
 					X509* m_upstreamCert = nullptr;
 
+					/// <summary>
+					/// The spoofed server context the downstream connection was switched to. Held
+					/// for the lifetime of the bridge, so that the context stays valid even if the
+					/// certificate store evicts it in the meantime.
+					/// </summary>
+					std::shared_ptr<boost::asio::ssl::context> m_serverContext;
+
 					/// <summary>
 					/// Stores the current host whenever a new request is processed by the bridge.
 					/// For every subsequent request, the host information in the request headers is
@@ -396,10 +617,23 @@ namespace te
 					/// implementation here.
 					/// 
 					/// This of course is only ever used in the case that BridgeSocketType is
-					/// network::TlsSocket, hence the unique_ptr so it's not wastefully allocated on
-					/// non-tls bridges.
+					/// network::TlsSocket. It's taken from the buffer pool when the bridge starts,
+					/// and given back as soon as the SNI host has been extracted.
+					/// </summary>
+					util::mem::SharedBuffer m_tlsPeekBuffer = nullptr;
+
+					/// <summary>
+					/// The size of the buffers each direction of a passthrough volley starts with.
+					/// Most passthrough flows are long lived and mostly idle, so they shouldn't
+					/// pin much memory. A flow that's actually moving data fills its buffer and
+					/// has it grown, up to PassthroughMaxBufferSize.
+					/// </summary>
+					static constexpr size_t PassthroughInitialBufferSize = 16384;
+
+					/// <summary>
+					/// The largest size the passthrough buffers will grow to.
 					/// </summary>
-					std::unique_ptr< std::array<char, TlsPeekBufferSize> > m_tlsPeekBuffer = nullptr;
+					static constexpr size_t PassthroughMaxBufferSize = 262144;
 
 					std::atomic_uint32_t m_thisTransactionId;
 
@@ -413,21 +647,6 @@ namespace te
 					/// </summary>
 					static std::atomic_flag s_clientContextLock;
 
-                    /// <summary>
-                    /// The multiplier that determines the total number of stream channels that can be used concurrently. The
-                    /// actual number of channels will be 1000 * s_streamChannelMultiplier.
-                    /// At this value, 20K channels will be created. 10K for the TLS template, 10K for the non-TLS.
-                    /// Due to implementation constraints, this means that we are guaranteed to have 7294 channels
-                    /// between the oldest acquired and newest acquired channels.
-                    /// </summary>
-                    static constexpr size_t s_streamChannelMultiplier = 10;
-
-                    /// <summary>
-                    /// This holds a global set of stream channels that enable library users to stream blocked data
-                    /// back into responses rather than pinning pointers and passing them around.
-                    /// </summary>
-                    static util::cb::CStreamCopyUtilContainer<std::is_same<BridgeSocketType, network::TlsSocket>::value, s_streamChannelMultiplier> s_streamCopyContainer;
-
 					/// <summary>
 					/// Called once we discover the SNI hostname for a TLS connection. This will
 					/// either retrieve an existing context, or create and retrieve a context,
@@ -441,12 +660,6 @@ namespace te
 					/// </param>
 					static const void InitClientContext(TlsCapableHttpBridge<BridgeSocketType>* bridgeCtx, boost::asio::ssl::stream<boost::asio::ip::tcp::socket>& sslStream, const std::string& hostname);
 
-					/// <summary>
-					/// Tells the minimum length that a peek read must be in order to even reach
-					/// the extensions area of a potentially accurate TLS client hello.
-					/// </summary>
-					static constexpr size_t MinTlsHelloLength = 43;
-
 					/// <summary>
 					/// Indicates whether or not ::Kill() has already successfully run and initiated the shutdown.
 					/// </summary>
@@ -491,6 +704,20 @@ namespace te
 					/// </returns>
 					boost::asio::ip::tcp::socket& UpstreamSocket();
 
+				private:
+
+					/// <summary>
+					/// Creates a new, unconnected upstream socket of the bridge's socket type. This
+					/// method uses template specialization in the source, as constructing the
+					/// socket varies between socket types.
+					/// </summary>
+					/// <returns>
+					/// The new socket.
+					/// </returns>
+					std::shared_ptr<BridgeSocketType> NewUpstreamSocket();
+
+				public:
+
 					/// <summary>
 					/// Initiates the process of reading and writing between client and server.
 					/// After this call, the bridge maintains its own lifecycle via shared_from_this
@@ -695,6 +922,36 @@ namespace te
 							}							
 					};
 
+					/// <summary>
+					/// Takes the upstream connection out of the idle state before it is used again,
+					/// so that ::Kill() can no longer hand it to the pool. Holds the same lock that
+					/// ::Kill() swaps the upstream socket under, so either the claim comes first and
+					/// the connection stays with this bridge, or ::Kill() does and the socket
+					/// this bridge holds is no longer the one it was using.
+					/// </summary>
+					/// <returns>
+					/// True if the upstream connection is still this bridge's to use, false if the
+					/// bridge has been killed, in which case the caller must just return.
+					/// </returns>
+					const bool ClaimUpstream()
+					{
+						while (m_killLock.test_and_set(std::memory_order_acquire))
+						{
+							cpu_relax();
+						}
+
+						const bool claimed = !m_killed;
+
+						if (claimed)
+						{
+							m_upstreamIdle = false;
+						}
+
+						m_killLock.clear(std::memory_order_release);
+
+						return claimed;
+					}
+
 					/// <summary>
 					/// Initiates shutdown of all pending asynchronous operations, which will
 					/// eventually lead to the destruction of this object once all pending handlers
@@ -740,6 +997,32 @@ namespace te
 							this->DownstreamSocket().shutdown(boost::asio::socket_base::shutdown_both, downstreamShutdownErr);
 							this->DownstreamSocket().close(downstreamCloseErr);
 
+							if (m_upstreamIdle.exchange(false) && m_upstreamPool != nullptr && m_upstreamHost.size() > 0)
+							{
+								// The upstream connection finished its last transaction cleanly and has
+								// nothing pending, so rather than close it, hand it to whichever bridge
+								// needs this host next. A fresh socket is swapped in first, so nothing
+								// left running on this bridge can ever touch the pooled one. The close
+								// calls below then just fail quietly on the fresh socket.
+								std::shared_ptr<BridgeSocketType> replacement;
+
+								try
+								{
+									replacement = NewUpstreamSocket();
+								}
+								catch (...)
+								{
+									replacement = nullptr;
+								}
+
+								if (replacement != nullptr)
+								{
+									std::shared_ptr<BridgeSocketType> idle = std::move(m_upstreamSocket);
+									m_upstreamSocket = std::move(replacement);
+									m_upstreamPool->Release(m_upstreamHost, GetUpstreamPort(), std::move(idle));
+								}
+							}
+
 							this->UpstreamSocket().cancel(upstreamCancelErr);
 							this->UpstreamSocket().shutdown(boost::asio::socket_base::shutdown_both, upstreamShutdownErr);
 							this->UpstreamSocket().close(upstreamCloseErr);
@@ -846,28 +1129,17 @@ namespace te
 					void OnUpstreamConnect(const boost::system::error_code& error);
 
 					/// <summary>
-					/// Completion handler for when the initial asynchronous read from the upstream
-					/// server is complete. The initial read specifies a condition that indicates
-					/// that reading into the buffer should be paused, and this handler should be
-					/// called with the data that has been written to the buffer up until the
-					/// discovery of the completion condition parameters. In our case, the condition
-					/// is that the header terminating CRLF has been discovered in the supplied read buffer.
+					/// Completion handler for when an asynchronous read of the response headers from
+					/// the upstream server is complete. Reads are done straight into the buffer of
+					/// the response, and complete as soon as any data has arrived, so the headers
+					/// may take more than one read, and the last one will usually contain the start
+					/// of the response body as well, if there is one.
 					/// 
-					/// Note that such async_read_until methods can and usually do read data beyond
-					/// the specified completion condition. In our case, this means that the read
-					/// buffer will most likely not just contain HTTP headers, but will also contain
-					/// a small portion of the response body as well, if there is one. The
-					/// bytesTransferred member **will not** accurately reflect this information.
-					/// Instead, it will return how many bytes were read before and including the
-					/// bytes that make up the completion condition.
-					/// 
-					/// So again, in our case, the bytesTransferred member will be set to the total
-					/// size of the response headers, plus the terminating CRLF. Interally, the
-					/// ::Parse() method(s) of the HttpResponse and HttpRequest classes will take
-					/// the bytesTransferred as an argument, and then do a comparison of this
-					/// number against the true size of the variable-length streambuf read buffer,
-					/// and separate the header and payload data correctly. It is therefore of the
-					/// utmost importance to handle this parameter value correctly.
+					/// The bytesTransferred member is handed as is to the ::Parse() method of the
+					/// HttpResponse, which finds the end of the headers and separates the header and
+					/// payload data correctly. It is therefore of the utmost importance to handle
+					/// this parameter value correctly. Until the headers are complete, this handler
+					/// issues another read.
 					/// 
 					/// In the event that this operation was a failure, meaning that the supplied
 					/// error parameter was set and the code was one unexpected, the bridge will be 
@@ -878,10 +1150,7 @@ namespace te
 					/// operation, providing details if an error did occur and was handled.
 					/// </param>
 					/// <param name="bytesTransferred">
-					/// The amount of data read into the buffer up until the discovery of the
-					/// specified completion condition, plus the size of the bytes that make up the
-					/// completion condition. Does not accurately represent the total data read from
-					/// the remote peer.
+					/// The amount of data read into the buffer.
 					/// </param>
 					void OnUpstreamHeaders(const boost::system::error_code& error, const size_t bytesTransferred)
 					{
@@ -942,7 +1211,7 @@ namespace te
 								if (!closeAfter && !m_response->HeadersComplete())
 								{
 									boost::asio::async_read(
-										m_upstreamSocket,
+										*m_upstreamSocket,
 										m_response->GetReadBuffer(),
 										boost::asio::transfer_at_least(1),
 										m_upstreamStrand.wrap(
@@ -960,132 +1229,29 @@ namespace te
 
 								// We only bother to check if the response should be blocked
 								// if the request has not been whitelisted.
+								bool shouldBlockResponse = false;
+
 								if (m_request->GetShouldBlock() > -1)
 								{
-									auto shouldBlockResponse = ShouldBlockTransaction(m_request.get(), m_response.get());
-
-									if (shouldBlockResponse)
-									{
-										m_request->SetShouldBlock(1);
-										auto responseBuffer = m_request->GetWriteBuffer();
-
-										boost::asio::async_write(
-											m_downstreamSocket,
-											responseBuffer,
-											boost::asio::transfer_all(),
-											m_downstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnDownstreamWrite,
-													shared_from_this(),
-													std::placeholders::_1
-												)
-											)
+									bool deferred = false;
+
+									shouldBlockResponse = ShouldBlockTransaction(
+										m_request.get(),
+										m_response.get(),
+										m_upstreamStrand,
+										std::bind(&TlsCapableHttpBridge::OnResponseHeadersVerdict, shared_from_this(), closeAfter, std::placeholders::_1),
+										deferred
 										);
 
-										return;
-									}
-								}
-
-								// We want to remove any header that has to do with Google's SDHC
-								// compression method. We don't want it, because we don't support it
-								// so we'd have no way to handle content compressed with this method.
-								m_response->RemoveHeader(util::http::headers::GetDictionary);
-
-								// Ensure that nobody is advertising for QUIC support.
-								m_response->RemoveHeader(util::http::headers::AlternateProtocol);
-
-								// Sigh, also remove declaration of any alternative protocol
-								m_response->RemoveHeader(util::http::headers::AltSvc);
-
-								// Firefox developers are bunch of double talking liars, and claim that you
-								// can disable public key pinning. However, for their buddies who must
-								// pay them off or something, this isn't true. It's enforced no matter
-								// what do you. So what's the solution? We strip the headers from
-								// the client altogether.
-								m_response->RemoveHeader(util::http::headers::PublicKeyPins);
-								m_response->RemoveHeader(util::http::headers::PublicKeyPinsReportOnly);
-
-								// Set m_keepAlive to what the server has specified. The client may have requested it, but
-								// ultimately it's up to the server how it's going to serve us.
-								auto connectionHeader = m_response->GetHeader(util::http::headers::Connection);
-
-								bool keepAlive = false;
-
-								if (m_request->GetHttpVersion() != http::HttpProtocolVersion::HTTP1)
-								{
-									keepAlive = true;
-								}								
-
-								while (connectionHeader.first != connectionHeader.second)
-								{
-									if (connectionHeader.first->second.compare(u8"close") == 0)
-									{
-										keepAlive = false;										
-									}
-									++connectionHeader.first;
-								}
-
-								m_keepAlive = keepAlive;								
-
-								if (!closeAfter && m_response->IsPayloadComplete() == false && m_response->GetConsumeAllBeforeSending() == true)
-								{
-									// We need to reinitiate sequential reads of the response
-									// payload until we have all of the response body, as it has
-									// been marked for inspection.
-
-									// We do this in a try/catch because getting the read buffer for the payload
-									// can throw if the maximum payload size has been reached. This is defined as
-									// a constexpr in BaseHttpTransaction. 
-									try
+									if (deferred)
 									{
-										auto readBuffer = m_response->GetReadBuffer();
-
-										SetStreamTimeout(boost::posix_time::minutes(5));
-
-										boost::asio::async_read(
-											m_upstreamSocket,
-											readBuffer,
-											boost::asio::transfer_at_least(1),
-											m_upstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnUpstreamRead,
-													shared_from_this(),
-													std::placeholders::_1,
-													std::placeholders::_2
-													)
-												)
-											);
-
+										// Parked until the verdict is delivered.
 										return;
 									}
-									catch (std::exception& e)
-									{
-										ReportError(e.what());
-									}									
 								}
-								else
-								{
-									// We need to write what we have to the client.
-
-									SetStreamTimeout(boost::posix_time::minutes(5));
-
-									auto writeBuffer = m_response->GetWriteBuffer();
-
-									boost::asio::async_write(
-										m_downstreamSocket,
-										writeBuffer,
-										boost::asio::transfer_all(),
-										m_downstreamStrand.wrap(
-											std::bind(
-												&TlsCapableHttpBridge::OnDownstreamWrite,
-												shared_from_this(),
-												std::placeholders::_1
-												)
-											)
-										);
 
-									return;
-								}								
+								OnResponseHeadersVerdict(closeAfter, shouldBlockResponse);
+								return;
 							}
 							else
 							{
@@ -1104,54 +1270,217 @@ namespace te
 					}
 
 					/// <summary>
-					/// Completion handler for when an asynchronous read of the response payload
-					/// from the upstream server completes. Requests the response payload to be
-					/// parsed and, depending on configured options, may write the data to the
-					/// client, or resize the read buffer and continue reading the response payload
-					/// until completion.
-					/// 
-					/// In the event that this operation was a failure, meaning that the supplied
-					/// error parameter was set and the code was one unexpected, the bridge will be 
-					/// terminated.
+					/// Picks up where ::OnUpstreamHeaders(...) left off once the response headers
+					/// have been judged, either right away or once a deferred verdict has been
+					/// delivered. Writes the block response if the response was blocked, carries on
+					/// serving it otherwise.
 					/// </summary>
-					/// <param name="error">
-					/// Error code that will indicate if any errors were handled during the async
-					/// operation, providing details if an error did occur and was handled.
+					/// <param name="closeAfter">
+					/// Whether the upstream server closed the connection with the last read.
 					/// </param>
-					/// <param name="bytesTransferred">
-					/// The number of bytes read from the remote upstream server.
+					/// <param name="shouldBlock">
+					/// Whether the response was blocked.
 					/// </param>
-					void OnUpstreamRead(const boost::system::error_code& error, const size_t bytesTransferred)
+					void OnResponseHeadersVerdict(const bool closeAfter, const bool shouldBlock)
 					{
-						#ifndef NDEBUG
-						ReportInfo(u8"TlsCapableHttpBridge::OnUpstreamRead");
-						#endif // !NDEBUG
-
-						/*
-						if (m_shouldTerminate)
+						if (shouldBlock)
 						{
-							// The session was flagged to be killed AFTER this write completes.
-							// Exit. This only happens when one end of the connection closed
-							// during a read, but we got data to send to the other end before
-							// this happened.
-							Kill();
+							m_request->SetShouldBlock(1);
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
+
 							return;
 						}
-						*/
 
-						// EOF doesn't necessarily mean something critical happened. Could simply be
-						// that we got the entire valid response, and the server closed the connection
-						// after.
-						if ((!error || (error == boost::asio::error::eof || (error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ))))
+						// If the response was flagged for streaming inspection, whatever of
+						// the payload came in with the headers has to be looked at before
+						// anything goes to the client. Nothing has been sent yet, so a block
+						// can still be answered properly.
+						if (ShouldBlockPayloadChunk(m_request.get(), m_response.get()))
 						{
-							bool closeAfter = (error == boost::asio::error::eof) || ((error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ));
-							bool wasSslShortRead = ((error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ));
-
-							if (closeAfter && !wasSslShortRead && bytesTransferred <= 0)
-							{
-								Kill();
-								return;
-							}
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
+
+							return;
+						}
+
+						// We want to remove any header that has to do with Google's SDHC
+						// compression method. We don't want it, because we don't support it
+						// so we'd have no way to handle content compressed with this method.
+						m_response->RemoveHeader(util::http::headers::GetDictionary);
+
+						// Ensure that nobody is advertising for QUIC support.
+						m_response->RemoveHeader(util::http::headers::AlternateProtocol);
+
+						// Sigh, also remove declaration of any alternative protocol
+						m_response->RemoveHeader(util::http::headers::AltSvc);
+
+						// Firefox developers are bunch of double talking liars, and claim that you
+						// can disable public key pinning. However, for their buddies who must
+						// pay them off or something, this isn't true. It's enforced no matter
+						// what do you. So what's the solution? We strip the headers from
+						// the client altogether.
+						m_response->RemoveHeader(util::http::headers::PublicKeyPins);
+						m_response->RemoveHeader(util::http::headers::PublicKeyPinsReportOnly);
+
+						// Set m_keepAlive to what the server has specified. The client may have requested it, but
+						// ultimately it's up to the server how it's going to serve us.
+						auto connectionHeader = m_response->GetHeader(util::http::headers::Connection);
+
+						bool keepAlive = false;
+
+						if (m_request->GetHttpVersion() != http::HttpProtocolVersion::HTTP1)
+						{
+							keepAlive = true;
+						}								
+
+						while (connectionHeader.first != connectionHeader.second)
+						{
+							if (connectionHeader.first->second.compare(u8"close") == 0)
+							{
+								keepAlive = false;										
+							}
+							++connectionHeader.first;
+						}
+
+						m_keepAlive = keepAlive;								
+
+						if (!closeAfter && m_response->IsPayloadComplete() == false && m_response->GetConsumeAllBeforeSending() == true)
+						{
+							// We need to reinitiate sequential reads of the response
+							// payload until we have all of the response body, as it has
+							// been marked for inspection.
+
+							// We do this in a try/catch because getting the read buffer for the payload
+							// can throw if the maximum payload size has been reached. This is defined as
+							// a constexpr in BaseHttpTransaction. 
+							try
+							{
+								auto readBuffer = m_response->GetReadBuffer();
+
+								SetStreamTimeout(boost::posix_time::minutes(5));
+
+								boost::asio::async_read(
+									*m_upstreamSocket,
+									readBuffer,
+									boost::asio::transfer_at_least(1),
+									m_upstreamStrand.wrap(
+										std::bind(
+											&TlsCapableHttpBridge::OnUpstreamRead,
+											shared_from_this(),
+											std::placeholders::_1,
+											std::placeholders::_2
+											)
+										)
+									);
+
+								return;
+							}
+							catch (std::exception& e)
+							{
+								ReportError(e.what());
+							}									
+						}
+						else
+						{
+							// We need to write what we have to the client.
+
+							SetStreamTimeout(boost::posix_time::minutes(5));
+
+							auto writeBuffer = m_response->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								writeBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+										)
+									)
+								);
+
+							return;
+						}								
+
+						Kill();
+					}
+
+					/// <summary>
+					/// Completion handler for when an asynchronous read of the response payload
+					/// from the upstream server completes. Requests the response payload to be
+					/// parsed and, depending on configured options, may write the data to the
+					/// client, or resize the read buffer and continue reading the response payload
+					/// until completion.
+					/// 
+					/// In the event that this operation was a failure, meaning that the supplied
+					/// error parameter was set and the code was one unexpected, the bridge will be 
+					/// terminated.
+					/// </summary>
+					/// <param name="error">
+					/// Error code that will indicate if any errors were handled during the async
+					/// operation, providing details if an error did occur and was handled.
+					/// </param>
+					/// <param name="bytesTransferred">
+					/// The number of bytes read from the remote upstream server.
+					/// </param>
+					void OnUpstreamRead(const boost::system::error_code& error, const size_t bytesTransferred)
+					{
+						#ifndef NDEBUG
+						ReportInfo(u8"TlsCapableHttpBridge::OnUpstreamRead");
+						#endif // !NDEBUG
+
+						/*
+						if (m_shouldTerminate)
+						{
+							// The session was flagged to be killed AFTER this write completes.
+							// Exit. This only happens when one end of the connection closed
+							// during a read, but we got data to send to the other end before
+							// this happened.
+							Kill();
+							return;
+						}
+						*/
+
+						// EOF doesn't necessarily mean something critical happened. Could simply be
+						// that we got the entire valid response, and the server closed the connection
+						// after.
+						if ((!error || (error == boost::asio::error::eof || (error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ))))
+						{
+							bool closeAfter = (error == boost::asio::error::eof) || ((error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ));
+							bool wasSslShortRead = ((error.category() == boost::asio::error::get_ssl_category()) && (ERR_GET_REASON(error.value()) == SSL_R_SHORT_READ));
+
+							if (closeAfter && !wasSslShortRead && bytesTransferred <= 0)
+							{
+								Kill();
+								return;
+							}
 
 							if (closeAfter)
 							{
@@ -1176,83 +1505,29 @@ namespace te
 									ReportWarning(u8"In TlsCapableHttpBridge::OnUpstreamRead(const boost::system::error_code&, const size_t) - Got TLS short read, but payload is complete. The naughty remote server did not do a proper TLS shutdown.");
 								}
 
+								bool shouldBlock = false;
+
 								if (m_request->GetShouldBlock() > -1 && m_response->IsPayloadComplete() && m_response->GetConsumeAllBeforeSending())
 								{
 									// Response was flagged for further inspection. Supply to ShouldBlock...
-									auto shouldBlock = ShouldBlockTransaction(m_request.get(), m_response.get());
-
-									if (shouldBlock)
-									{	
-										m_request->SetShouldBlock(1);
-										auto responseBuffer = m_request->GetWriteBuffer();
-
-										boost::asio::async_write(
-											m_downstreamSocket,
-											responseBuffer,
-											boost::asio::transfer_all(),
-											m_downstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnDownstreamWrite,
-													shared_from_this(),
-													std::placeholders::_1
-												)
-											)
+									bool deferred = false;
+
+									shouldBlock = ShouldBlockTransaction(
+										m_request.get(),
+										m_response.get(),
+										m_upstreamStrand,
+										std::bind(&TlsCapableHttpBridge::OnResponsePayloadVerdict, shared_from_this(), closeAfter, std::placeholders::_1),
+										deferred
 										);
 
-										return;
-									}
-								}
-								
-								if (!closeAfter && m_response->IsPayloadComplete() == false && m_response->GetConsumeAllBeforeSending() == true)
-								{
-									SetStreamTimeout(boost::posix_time::minutes(5));
-
-									try
-									{
-										auto readBuffer = m_response->GetReadBuffer();
-
-										boost::asio::async_read(
-											m_upstreamSocket,
-											readBuffer,
-											boost::asio::transfer_at_least(1),
-											m_upstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnUpstreamRead,
-													shared_from_this(),
-													std::placeholders::_1,
-													std::placeholders::_2
-													)
-												)
-											);
-
-										return;
-									}
-									catch (std::exception& e)
+									if (deferred)
 									{
-										std::string errMsg(u8"In TlsCapableHttpBridge::OnUpstreamRead(const boost::system::error_code&, const size_t) - Got error:\t");
-										errMsg.append(e.what());
-										ReportError(errMsg);
-										Kill();
+										// Parked until the verdict is delivered.
 										return;
 									}
 								}
-								
-								// Simply write what we've got to the client.
-								auto writeBuffer = m_response->GetWriteBuffer();
-
-								boost::asio::async_write(
-									m_downstreamSocket,
-									writeBuffer,
-									boost::asio::transfer_all(),
-									m_downstreamStrand.wrap(
-										std::bind(
-											&TlsCapableHttpBridge::OnDownstreamWrite,
-											shared_from_this(),
-											std::placeholders::_1
-											)
-										)
-									);
 
+								OnResponsePayloadVerdict(closeAfter, shouldBlock);
 								return;
 							}
 							else
@@ -1283,6 +1558,122 @@ namespace te
 						Kill();
 					}
 
+					/// <summary>
+					/// Picks up where ::OnUpstreamRead(...) left off once a response that was held
+					/// back in full has been judged, either right away or once a deferred verdict
+					/// has been delivered. Writes the block response if the response was blocked,
+					/// carries on serving it otherwise.
+					/// </summary>
+					/// <param name="closeAfter">
+					/// Whether the upstream server closed the connection with the last read.
+					/// </param>
+					/// <param name="shouldBlock">
+					/// Whether the response was blocked.
+					/// </param>
+					void OnResponsePayloadVerdict(const bool closeAfter, const bool shouldBlock)
+					{
+						if (shouldBlock)
+						{	
+							m_request->SetShouldBlock(1);
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
+
+							return;
+						}
+						
+						if (!closeAfter && m_response->IsPayloadComplete() == false && m_response->GetConsumeAllBeforeSending() == true)
+						{
+							SetStreamTimeout(boost::posix_time::minutes(5));
+
+							try
+							{
+								auto readBuffer = m_response->GetReadBuffer();
+
+								boost::asio::async_read(
+									*m_upstreamSocket,
+									readBuffer,
+									boost::asio::transfer_at_least(1),
+									m_upstreamStrand.wrap(
+										std::bind(
+											&TlsCapableHttpBridge::OnUpstreamRead,
+											shared_from_this(),
+											std::placeholders::_1,
+											std::placeholders::_2
+											)
+										)
+									);
+
+								return;
+							}
+							catch (std::exception& e)
+							{
+								std::string errMsg(u8"In TlsCapableHttpBridge::OnResponsePayloadVerdict(const bool, const bool) - Got error:\t");
+								errMsg.append(e.what());
+								ReportError(errMsg);
+								Kill();
+								return;
+							}
+						}
+						
+						if (ShouldBlockPayloadChunk(m_request.get(), m_response.get()))
+						{
+							if (m_response->HeadersSent())
+							{
+								// Part of the response has already reached the client, so
+								// there's no way left to answer it. Cut it off.
+								Kill();
+								return;
+							}
+
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
+
+							return;
+						}
+
+						// Simply write what we've got to the client.
+						auto writeBuffer = m_response->GetWriteBuffer();
+
+						boost::asio::async_write(
+							m_downstream,
+							writeBuffer,
+							boost::asio::transfer_all(),
+							m_downstreamStrand.wrap(
+								std::bind(
+									&TlsCapableHttpBridge::OnDownstreamWrite,
+									shared_from_this(),
+									std::placeholders::_1
+									)
+								)
+							);
+
+						return;
+					}
+
 					/// <summary>
 					/// Completion handler for when an asynchronous write of either headers or
 					/// request payload data has finished being written to the upstream server.
@@ -1325,7 +1716,7 @@ namespace te
 									auto readBuffer = m_request->GetReadBuffer();
 
 									boost::asio::async_read(
-										m_downstreamSocket,
+										m_downstream,
 										readBuffer,
 										boost::asio::transfer_at_least(1),
 										m_downstreamStrand.wrap(
@@ -1354,7 +1745,7 @@ namespace te
 								SetStreamTimeout(boost::posix_time::minutes(5));
 
 								boost::asio::async_read(
-									m_upstreamSocket,
+									*m_upstreamSocket,
 									m_response->GetReadBuffer(), 
 									boost::asio::transfer_at_least(1),
 									m_upstreamStrand.wrap(
@@ -1381,28 +1772,17 @@ namespace te
 					}
 
 					/// <summary>
-					/// Completion handler for when the initial asynchronous read from the connected
-					/// client is complete. The initial read specifies a condition that indicates
-					/// that reading into the buffer should be paused, and this handler should be
-					/// called with the data that has been written to the buffer up until the
-					/// discovery of the completion condition parameters. In our case, the condition
-					/// is that the header terminating CRLF has been discovered in the supplied read buffer.
-					/// 
-					/// Note that such async_read_until methods can and usually do read data beyond
-					/// the specified completion condition. In our case, this means that the read
-					/// buffer will most likely not just contain HTTP headers, but will also contain
-					/// a small portion of the request body as well, if there is one. The
-					/// bytesTransferred member **will not** accurately reflect this information.
-					/// Instead, it will return how many bytes were read before and including the
-					/// bytes that make up the completion condition.
+					/// Completion handler for when an asynchronous read of the request headers from
+					/// the connected client is complete. Reads are done straight into the buffer of
+					/// the request, and complete as soon as any data has arrived, so the headers
+					/// may take more than one read, and the last one will usually contain the start
+					/// of the request body as well, if there is one.
 					/// 
-					/// So again, in our case, the bytesTransferred member will be set to the total
-					/// size of the request headers, plus the terminating CRLF. Interally, the
-					/// ::Parse() method(s) of the HttpResponse and HttpRequest classes will take
-					/// the bytesTransferred as an argument, and then do a comparison of this
-					/// number against the true size of the variable-length streambuf read buffer,
-					/// and separate the header and payload data correctly. It is therefore of the
-					/// utmost importance to handle this parameter value correctly.
+					/// The bytesTransferred member is handed as is to the ::Parse() method of the
+					/// HttpRequest, which finds the end of the headers and separates the header and
+					/// payload data correctly. It is therefore of the utmost importance to handle
+					/// this parameter value correctly. Until the headers are complete, this handler
+					/// issues another read.
 					/// 
 					/// In the event that this operation was a failure, meaning that the supplied
 					/// error parameter was set and the code was one unexpected, the bridge will be 
@@ -1413,10 +1793,7 @@ namespace te
 					/// operation, providing details if an error did occur and was handled.
 					/// </param>
 					/// <param name="bytesTransferred">
-					/// The amount of data read into the buffer up until the discovery of the
-					/// specified completion condition, plus the size of the bytes that make up the
-					/// completion condition. Does not accurately represent the total data read from
-					/// the remote peer.
+					/// The amount of data read into the buffer.
 					/// </param>
 					void OnDownstreamHeaders(const boost::system::error_code& error, const size_t bytesTransferred)
 					{
@@ -1477,7 +1854,7 @@ namespace te
 								if (!closeAfter && !m_request->HeadersComplete())
 								{
 									boost::asio::async_read(
-										m_downstreamSocket,
+										m_downstream,
 										m_request->GetReadBuffer(),
 										boost::asio::transfer_at_least(1),
 										m_downstreamStrand.wrap(
@@ -1494,209 +1871,274 @@ namespace te
 								}
 
 								
-								auto shouldBlockRequest = ShouldBlockTransaction(m_request.get());
+								bool deferred = false;
+
+								auto shouldBlockRequest = ShouldBlockTransaction(
+									m_request.get(),
+									nullptr,
+									m_downstreamStrand,
+									std::bind(&TlsCapableHttpBridge::OnRequestHeadersVerdict, shared_from_this(), closeAfter, std::placeholders::_1),
+									deferred
+									);
 
-								if (shouldBlockRequest)
+								if (deferred)
 								{
-									// If should-block was set here, then that means the request 
-									// has already been set externally with a response buffer for
-									// the request, because it was blocked immediately. Just go
-									// ahead and write this back down to the client and then exit.
-									auto responseBuffer = m_request->GetWriteBuffer();
-
-									boost::asio::async_write(
-										m_downstreamSocket,
-										responseBuffer,
-										boost::asio::transfer_all(),
-										m_downstreamStrand.wrap(
-											std::bind(
-												&TlsCapableHttpBridge::OnDownstreamWrite,
-												shared_from_this(),
-												std::placeholders::_1
-											)
-										)
-									);
+									// Parked until the verdict is delivered.
 									return;
 								}
 
-								// This little business is for dealing with browsers like Chrome, who just have
-								// to use their own "I'm too cool for skool" compression methods like SDHC. We
-								// want to be sure that we get normal, non-hipster encoded, non-organic smoothie
-								// encoded reponses that sane people can decompress. So we just always replace
-								// the Accept-Encoding header with this.
-								std::string standardEncoding(u8"gzip");
-								m_request->AddHeader(util::http::headers::AcceptEncoding, standardEncoding);
-
-								// Modifying content-encoding isn't enough for that sweet organic spraytanned
-								// browser Chrome and its server cartel buddies. If these special headers make
-								// it through, even though we've explicitly defined our accepted encoding,
-								// you're still going to get SDHC encoded data.
-								m_request->RemoveHeader(util::http::headers::XSDHC);
-								m_request->RemoveHeader(util::http::headers::AvailDictionary);
-								
-								// Ensure that nobody is advertising for QUIC support.
-								m_request->RemoveHeader(util::http::headers::AlternateProtocol);
-
-								// Sigh, also remove declaration of any alternative protocol.
-								m_request->RemoveHeader(util::http::headers::AltSvc);
-
-								// Firefox developers are bunch of double talking liars, and claim that you
-								// can disable public key pinning. However, for their buddies who must
-								// pay them off or something, this isn't true. It's enforced no matter
-								// what do you. So what's the solution? We strip the headers from
-								// the client altogether.
-								m_request->RemoveHeader(util::http::headers::PublicKeyPins);
-								m_request->RemoveHeader(util::http::headers::PublicKeyPinsReportOnly);
-
-								auto hostHeader = m_request->GetHeader(util::http::headers::Host);
-
-								if (hostHeader.first != hostHeader.second)
-								{
-									auto hostWithoutPort = hostHeader.first->second;
+								OnRequestHeadersVerdict(closeAfter, shouldBlockRequest);
+								return;
+							}
+							else
+							{
+								ReportError(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Failed to parse request.");
+							}
+						}
 
-									boost::trim(hostWithoutPort);
+						if (error)
+						{
+							std::string errMsg(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Got error:\t");
+							errMsg.append(error.message());
+							ReportError(errMsg);
+						}
 
-									auto portInd = hostWithoutPort.find(':');
+						Kill();
+					}
 
-									if (portInd != std::string::npos && portInd < hostWithoutPort.size())
-									{
-										auto portString = hostWithoutPort.substr(portInd + 1);
+					/// <summary>
+					/// Picks up where ::OnDownstreamHeaders(...) left off once the request headers
+					/// have been judged, either right away or once a deferred verdict has been
+					/// delivered. Writes the block response if the request was blocked, carries on
+					/// sending it upstream otherwise.
+					/// </summary>
+					/// <param name="closeAfter">
+					/// Whether the client closed the connection with the last read.
+					/// </param>
+					/// <param name="shouldBlock">
+					/// Whether the request was blocked.
+					/// </param>
+					void OnRequestHeadersVerdict(const bool closeAfter, const bool shouldBlock)
+					{
+						if (shouldBlock)
+						{
+							// If should-block was set here, then that means the request 
+							// has already been set externally with a response buffer for
+							// the request, because it was blocked immediately. Just go
+							// ahead and write this back down to the client and then exit.
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
+							return;
+						}
 
-										hostWithoutPort = hostWithoutPort.substr(0, portInd);
+						if (ShouldBlockPayloadChunk(m_request.get()))
+						{
+							// Same as above, the request was given a block response when
+							// the payload that came in with its headers was rejected.
+							auto responseBuffer = m_request->GetWriteBuffer();
+
+							boost::asio::async_write(
+								m_downstream,
+								responseBuffer,
+								boost::asio::transfer_all(),
+								m_downstreamStrand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnDownstreamWrite,
+										shared_from_this(),
+										std::placeholders::_1
+									)
+								)
+							);
 
-										try
-										{
-											m_upstreamHostPort = static_cast<uint16_t>(std::stoi(portString));
-										}
-										catch (...)
-										{
-											// We don't really care what went wrong. We failed to parse the port in the host. We'll
-											// simply issue a warning, and assume port 80.
-											ReportWarning(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Failed to parse port in host entry. Assuming port 80.");
-										}										
-									}
+							return;
+						}
 
-									// If the we're already connected to a host and it's not the same, just quit.
-									bool needsResolve = true;
-									if (m_upstreamHost.size() > 0)
-									{
-										auto hostComparison = hostWithoutPort.compare(m_upstreamHost);
-										
-										if (hostComparison != 0)
-										{
-											Kill();
-											return;
-										}
+						// This little business is for dealing with browsers like Chrome, who just have
+						// to use their own "I'm too cool for skool" compression methods like SDHC. We
+						// want to be sure that we get normal, non-hipster encoded, non-organic smoothie
+						// encoded reponses that sane people can decompress. So we just always replace
+						// the Accept-Encoding header with this.
+						std::string standardEncoding(u8"gzip");
+						m_request->AddHeader(util::http::headers::AcceptEncoding, standardEncoding);
+
+						// Modifying content-encoding isn't enough for that sweet organic spraytanned
+						// browser Chrome and its server cartel buddies. If these special headers make
+						// it through, even though we've explicitly defined our accepted encoding,
+						// you're still going to get SDHC encoded data.
+						m_request->RemoveHeader(util::http::headers::XSDHC);
+						m_request->RemoveHeader(util::http::headers::AvailDictionary);
+						
+						// Ensure that nobody is advertising for QUIC support.
+						m_request->RemoveHeader(util::http::headers::AlternateProtocol);
 
-										needsResolve = false;
-									}
+						// Sigh, also remove declaration of any alternative protocol.
+						m_request->RemoveHeader(util::http::headers::AltSvc);
 
-									if (needsResolve)
-									{
-										// If we're not already connected to a host, then we need to resolve it and
-										// connect to it. This **should** only ever be true in the event that its a 
-										// non-TLS (plain HTTP) connection.
-										SetStreamTimeout(boost::posix_time::minutes(5));
+						// Firefox developers are bunch of double talking liars, and claim that you
+						// can disable public key pinning. However, for their buddies who must
+						// pay them off or something, this isn't true. It's enforced no matter
+						// what do you. So what's the solution? We strip the headers from
+						// the client altogether.
+						m_request->RemoveHeader(util::http::headers::PublicKeyPins);
+						m_request->RemoveHeader(util::http::headers::PublicKeyPinsReportOnly);
 
-										m_upstreamHost = hostWithoutPort;
-										boost::asio::ip::tcp::resolver::query query(m_upstreamHost, std::is_same<BridgeSocketType, network::TlsSocket>::value ? "https" : "http");
+						auto hostHeader = m_request->GetHeader(util::http::headers::Host);
 
-										m_resolver.async_resolve(
-											query,
-											m_upstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnResolve,
-													shared_from_this(),
-													std::placeholders::_1,
-													std::placeholders::_2
-													)
-												)
-											);
+						if (hostHeader.first != hostHeader.second)
+						{
+							auto hostWithoutPort = hostHeader.first->second.to_string();
 
-										return;
-									}
-									
-									if (!closeAfter && m_request->IsPayloadComplete() == false && m_request->GetConsumeAllBeforeSending() == true)
-									{
-										// We need to reinitiate sequential reads of the request
-										// payload until we have all of the request body, as it has
-										// been marked for inspection.
-
-										// We do this in a try/catch because getting the read buffer for the payload
-										// can throw if the maximum payload size has been reached. This is defined as
-										// a constexpr in BaseHttpTransaction. 
-										try
-										{
-											auto readBuffer = m_request->GetReadBuffer();
+							boost::trim(hostWithoutPort);
 
-											SetStreamTimeout(boost::posix_time::minutes(5));
+							auto portInd = hostWithoutPort.find(':');
 
-											boost::asio::async_read(
-												m_downstreamSocket,
-												readBuffer,
-												boost::asio::transfer_at_least(1),
-												m_upstreamStrand.wrap(
-													std::bind(
-														&TlsCapableHttpBridge::OnDownstreamRead,
-														shared_from_this(),
-														std::placeholders::_1,
-														std::placeholders::_2
-													)
-												)
-											);
+							if (portInd != std::string::npos && portInd < hostWithoutPort.size())
+							{
+								auto portString = hostWithoutPort.substr(portInd + 1);
 
-											return;
-										}
-										catch (std::exception& e)
-										{
-											ReportError(e.what());
-										}
-									}
-									else
-									{
-										// Just write to the server that we're apparently already connected to. We
-										// don't concern ourselves with the ShouldBlock value here on the request.
-										// Once we get the upstream response headers, which gives us data about the
-										// size of a yet-to-be-completed request, we will block if the value was set
-										// here, but not before the http filtering engine reports this data to
-										// any observer(s).
+								hostWithoutPort = hostWithoutPort.substr(0, portInd);
 
-										SetStreamTimeout(boost::posix_time::minutes(5));
+								try
+								{
+									m_upstreamHostPort = static_cast<uint16_t>(std::stoi(portString));
+								}
+								catch (...)
+								{
+									// We don't really care what went wrong. We failed to parse the port in the host. We'll
+									// simply issue a warning, and assume port 80.
+									ReportWarning(u8"In TlsCapableHttpBridge::OnRequestHeadersVerdict(const bool, const bool) - Failed to parse port in host entry. Assuming port 80.");
+								}										
+							}
 
-										auto writeBuffer = m_request->GetWriteBuffer();
+							// If the we're already connected to a host and it's not the same, just quit.
+							bool needsResolve = true;
+							if (m_upstreamHost.size() > 0)
+							{
+								auto hostComparison = hostWithoutPort.compare(m_upstreamHost);
+								
+								if (hostComparison != 0)
+								{
+									Kill();
+									return;
+								}
 
-										boost::asio::async_write(
-											m_upstreamSocket,
-											writeBuffer,
-											boost::asio::transfer_all(),
-											m_upstreamStrand.wrap(
-												std::bind(
-													&TlsCapableHttpBridge::OnUpstreamWrite,
-													shared_from_this(),
-													std::placeholders::_1
-												)
-											)
-										);
+								needsResolve = false;
+
+								// Whatever happens next, this request is going to the
+								// upstream connection, so it isn't idle anymore.
+								if (!ClaimUpstream())
+								{
+									return;
+								}
+							}
+
+							if (needsResolve)
+							{
+								// If we're not already connected to a host, then we need to resolve it and
+								// connect to it. This **should** only ever be true in the event that its a 
+								// non-TLS (plain HTTP) connection.
+								SetStreamTimeout(boost::posix_time::minutes(5));
 
+								m_upstreamHost = hostWithoutPort;
+
+								if (std::is_same<BridgeSocketType, network::TcpSocket>::value && m_upstreamPool != nullptr)
+								{
+									auto pooled = m_upstreamPool->Acquire(m_upstreamHost, GetUpstreamPort(), PooledAddress(), *m_service);
+
+									if (pooled != nullptr)
+									{
+										// Some other bridge left a live connection to this host behind, so
+										// skip the resolve and connect and go straight to writing the request.
+										m_upstreamSocket = std::move(pooled);
+										OnUpstreamConnect(boost::system::error_code());
 										return;
 									}
 								}
-								else
+
+								ResolveUpstream();
+								return;
+							}
+							
+							if (!closeAfter && m_request->IsPayloadComplete() == false && m_request->GetConsumeAllBeforeSending() == true)
+							{
+								// We need to reinitiate sequential reads of the request
+								// payload until we have all of the request body, as it has
+								// been marked for inspection.
+
+								// We do this in a try/catch because getting the read buffer for the payload
+								// can throw if the maximum payload size has been reached. This is defined as
+								// a constexpr in BaseHttpTransaction. 
+								try
+								{
+									auto readBuffer = m_request->GetReadBuffer();
+
+									SetStreamTimeout(boost::posix_time::minutes(5));
+
+									boost::asio::async_read(
+										m_downstream,
+										readBuffer,
+										boost::asio::transfer_at_least(1),
+										m_upstreamStrand.wrap(
+											std::bind(
+												&TlsCapableHttpBridge::OnDownstreamRead,
+												shared_from_this(),
+												std::placeholders::_1,
+												std::placeholders::_2
+											)
+										)
+									);
+
+									return;
+								}
+								catch (std::exception& e)
 								{
-									ReportError(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Failed to read Host header from request.");
+									ReportError(e.what());
 								}
 							}
 							else
 							{
-								ReportError(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Failed to parse request.");
+								// Just write to the server that we're apparently already connected to. We
+								// don't concern ourselves with the ShouldBlock value here on the request.
+								// Once we get the upstream response headers, which gives us data about the
+								// size of a yet-to-be-completed request, we will block if the value was set
+								// here, but not before the http filtering engine reports this data to
+								// any observer(s).
+
+								SetStreamTimeout(boost::posix_time::minutes(5));
+
+								auto writeBuffer = m_request->GetWriteBuffer();
+
+								boost::asio::async_write(
+									*m_upstreamSocket,
+									writeBuffer,
+									boost::asio::transfer_all(),
+									m_upstreamStrand.wrap(
+										std::bind(
+											&TlsCapableHttpBridge::OnUpstreamWrite,
+											shared_from_this(),
+											std::placeholders::_1
+										)
+									)
+								);
+
+								return;
 							}
 						}
-
-						if (error)
+						else
 						{
-							std::string errMsg(u8"In TlsCapableHttpBridge::OnDownstreamHeaders(const boost::system::error_code&, const size_t) - Got error:\t");
-							errMsg.append(error.message());
-							ReportError(errMsg);
+							ReportError(u8"In TlsCapableHttpBridge::OnRequestHeadersVerdict(const bool, const bool) - Failed to read Host header from request.");
 						}
 
 						Kill();
@@ -1787,7 +2229,7 @@ namespace te
 										auto readBuffer = m_request->GetReadBuffer();
 
 										boost::asio::async_read(
-											m_downstreamSocket,
+											m_downstream,
 											readBuffer,
 											boost::asio::transfer_at_least(1),
 											m_downstreamStrand.wrap(
@@ -1810,13 +2252,36 @@ namespace te
 									}
 								}
 
+								if (ShouldBlockPayloadChunk(m_request.get()))
+								{
+									// The server is left with a partial request, but the client
+									// hasn't seen any of the response yet, so it still gets a
+									// proper answer.
+									auto responseBuffer = m_request->GetWriteBuffer();
+
+									boost::asio::async_write(
+										m_downstream,
+										responseBuffer,
+										boost::asio::transfer_all(),
+										m_downstreamStrand.wrap(
+											std::bind(
+												&TlsCapableHttpBridge::OnDownstreamWrite,
+												shared_from_this(),
+												std::placeholders::_1
+											)
+										)
+									);
+
+									return;
+								}
+
 								SetStreamTimeout(boost::posix_time::minutes(5));
 
 								// Just write whatever we've got to the server.
 								auto writeBuffer = m_request->GetWriteBuffer();
 
 								boost::asio::async_write(
-									m_upstreamSocket, 
+									*m_upstreamSocket, 
 									writeBuffer, 
 									boost::asio::transfer_all(), 
 									m_upstreamStrand.wrap(
@@ -1864,6 +2329,19 @@ namespace te
 						ReportInfo(u8"TlsCapableHttpBridge::OnDownstreamWrite");
 						#endif // !NDEBUG
 
+						if (m_http2 != nullptr)
+						{
+							// Everything that would end the bridge for an HTTP/1.x client only ends
+							// the stream of an HTTP/2 client, whose other streams are still waiting.
+							const bool blocked = (m_request && m_request->GetShouldBlock() > 0) || (m_response && m_response->GetShouldBlock() > 0);
+
+							if (error || m_shouldTerminate || blocked || !m_response || m_response->IsPayloadComplete())
+							{
+								FinishHttp2Transaction(error);
+								return;
+							}
+						}
+
 						if (m_shouldTerminate)
 						{
 							// The session was flagged to be killed AFTER this write completes.
@@ -1903,7 +2381,7 @@ namespace te
 									auto readBuffer = m_response->GetReadBuffer();
 
 									boost::asio::async_read(
-										m_upstreamSocket,
+										*m_upstreamSocket,
 										readBuffer,
 										boost::asio::transfer_at_least(1),
 										m_upstreamStrand.wrap(
@@ -1953,8 +2431,10 @@ namespace te
 
 									try
 									{
-										m_request.reset(new http::HttpRequest());
-										m_response.reset(new http::HttpResponse());
+										// Recycled rather than replaced, keeping their buffers and
+										// whatever the client sent behind the last request.
+										m_request->Reset();
+										m_response->Reset();
 									}
 									catch (std::exception& e)
 									{
@@ -1965,14 +2445,22 @@ namespace te
 
 									m_shouldTerminate = false;
 
-									// XXX TODO - This is ugly, our bad design is showing. See notes in the
-									// EventReporter class header.
-									m_request->SetOnInfo(m_onInfo);
-									m_request->SetOnWarning(m_onWarning);
-									m_request->SetOnError(m_onError);
-									m_response->SetOnInfo(m_onInfo);
-									m_response->SetOnWarning(m_onWarning);
-									m_response->SetOnError(m_onError);
+									// The upstream connection is now clean and waiting for the next
+									// request. If the client goes away instead of sending one, it can be
+									// pooled.
+									m_upstreamIdle = true;
+
+									const size_t pipelined = m_request->GetPipelinedLength();
+
+									if (pipelined > 0)
+									{
+										// The client didn't wait for the response before sending
+										// its next request, and we already read it. Parse it right
+										// where it is, instead of waiting on a read that may never
+										// come.
+										OnDownstreamHeaders(boost::system::error_code(), pipelined);
+										return;
+									}
 
 									TryInitiateHttpTransaction();
 									return;
@@ -1990,115 +2478,244 @@ namespace te
 					}
 
 					/// <summary>
-					/// Completion handler for when the asynchrous wait operation on the stream
-					/// timer is finished, meaning that the timeout period has been reached, or that
-					/// the operation was cancelled. If the timeout has been reached, then the
-					/// bridge should be terminated. If the operation was aborted, then the function
-					/// will return without calling for a termination of the bridge.
-					/// 
-					/// In the event that this operation was a failure, meaning that the supplied
-					/// error parameter was set and the code was one unexpected, the bridge will be 
-					/// terminated.
+					/// Ends the transaction with an HTTP/2 client once its response has been
+					/// written, or has failed, and moves on to the next stream. The upstream
+					/// connection is kept for the next stream if it was left clean, by the same
+					/// terms as keep-alive is for an HTTP/1.x client, and replaced otherwise. The
+					/// bridge is only terminated if the client connection itself is done.
 					/// </summary>
 					/// <param name="error">
-					/// Error code that will indicate if any errors were handled during the async
-					/// operation, providing details if an error did occur and was handled.
+					/// The error of the last write to the client, if any.
 					/// </param>
-					void OnStreamTimeout(const boost::system::error_code& error)
+					void FinishHttp2Transaction(const boost::system::error_code& error)
 					{
+						m_http2->EndResponse();
 
-						#ifndef NDEBUG
-							ReportInfo(u8"TlsCapableHttpBridge<network::TlsSocket>::OnStreamTimeout");
-						#endif // !NDEBUG
+						if (!m_http2->IsOpen())
+						{
+							Kill();
+							return;
+						}
 
-						if (error)
+						const bool clean = !error && !m_shouldTerminate && m_keepAlive &&
+							m_request && m_request->GetShouldBlock() <= 0 && m_request->IsPayloadComplete() &&
+							m_response && m_response->GetShouldBlock() <= 0 && m_response->IsPayloadComplete();
+
+						if (!clean)
 						{
-							if (error == boost::asio::error::operation_aborted)
-							{
-								// Aborts are normal, as pending async_waits are cancelled every time that
-								// the timeout is reset. Therefore, we safely ignore them.
-								return;
-							}
-							else
-							{
-								// XXX TODO - Perhaps in the event of an error, we should return and avoid
-								// calling ::Kill()?
-								std::string errMessage(u8"In TlsCapableHttpBridge<BridgeSocketType>::OnStreamTimeout(const boost::system::error_code&) - Got error:\t");
-								errMessage.append(error.message());
-								ReportError(errMessage);
-							}
+							ReconnectUpstream();
+							return;
 						}
 
-						Kill();
-					}					
+						SetStreamTimeout(boost::posix_time::minutes(5));
+
+						try
+						{
+							m_request->Reset();
+							m_response->Reset();
+						}
+						catch (std::exception& e)
+						{
+							ReportError(e.what());
+							Kill();
+							return;
+						}
+
+						m_shouldTerminate = false;
+
+						m_upstreamIdle = true;
+
+						TryInitiateHttpTransaction();
+					}
 
 					/// <summary>
-					/// Completion handler for when the asynchrous handshake operation with the
-					/// remote upstream host has finished. If the operation was a success, then a
-					/// context by which to serve the connected client will either be retrieved, or
-					/// created, stored and then retrieved.
-					/// 
-					/// In the event that this operation was a failure, meaning that the supplied
-					/// error parameter was set and the code was one unexpected, the bridge will be 
-					/// terminated.
+					/// Replaces an upstream connection that was left in no state to be used again
+					/// with a pooled or fresh one, then carries on with the next stream of the
+					/// HTTP/2 client. Only ever called between transactions, when nothing is
+					/// pending on the upstream connection.
 					/// </summary>
-					/// <param name="error">
-					/// Error code that will indicate if any errors were handled during the async
-					/// operation, providing details if an error did occur and was handled.
-					/// </param>
-					void OnUpstreamHandshake(const boost::system::error_code& error)
+					void ReconnectUpstream()
 					{
+						std::shared_ptr<BridgeSocketType> replacement;
+						bool pooled = false;
 
-						#ifndef NDEBUG
-						ReportInfo(u8"TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamHandshake");
-						#endif // !NDEBUG
-
-						if (!error && m_upstreamCert != nullptr)
+						try
 						{
-							boost::asio::ssl::context* serverCtx = nullptr;
-
-							try
-							{
-								serverCtx = m_certStore->GetServerContext(m_upstreamHost, m_upstreamCert);
-							}
-							catch (std::exception& e)
+							if (m_upstreamPool != nullptr)
 							{
-								serverCtx = nullptr;
-								std::string errMessage(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamHandshake(const boost::system::error_code&) - While spoofing, got error:\t");
-								errMessage.append(e.what());
-								ReportError(errMessage);
+								replacement = m_upstreamPool->Acquire(m_upstreamHost, GetUpstreamPort(), PooledAddress(), *m_service);
+								pooled = replacement != nullptr;
 							}
 
-							if (serverCtx != nullptr)
+							if (replacement == nullptr)
 							{
-								if (SSL_set_SSL_CTX(m_downstreamSocket.native_handle(), serverCtx->native_handle()) == serverCtx->native_handle())
-								{
-									// Set timeouts
-									SetStreamTimeout(boost::posix_time::minutes(5));
-									//
-									
-									m_downstreamSocket.async_handshake(
-										network::TlsSocket::server, 
-										m_downstreamStrand.wrap(
-											std::bind(
-												&TlsCapableHttpBridge::OnDownstreamHandshake, 
-												shared_from_this(), 
-												std::placeholders::_1
-												)
-											)
-										);
+								replacement = NewUpstreamSocket();
+							}
+						}
+						catch (std::exception& e)
+						{
+							std::string errMsg(u8"In TlsCapableHttpBridge::ReconnectUpstream() - Got error:\t");
+							errMsg.append(e.what());
+							ReportError(errMsg);
+							Kill();
+							return;
+						}
 
-									return;
-								}
-								else
-								{
-									ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamHandshake(const boost::system::error_code&) - Failed to correctly set context.");
-								}
+						// Swapped under the same lock as ::Kill() pools and closes the upstream
+						// connection under, so it's either the old socket or the new one that
+						// ::Kill() sees, never something in between.
+						while (m_killLock.test_and_set(std::memory_order_acquire))
+						{
+							cpu_relax();
+						}
+
+						const bool alive = !m_killed;
+
+						std::shared_ptr<BridgeSocketType> previous;
+
+						if (alive)
+						{
+							previous = std::move(m_upstreamSocket);
+							m_upstreamSocket = std::move(replacement);
+							m_upstreamIdle = false;
+						}
+
+						m_killLock.clear(std::memory_order_release);
+
+						if (!alive)
+						{
+							if (pooled)
+							{
+								// Never used, so still as good as it was.
+								m_upstreamPool->Release(m_upstreamHost, GetUpstreamPort(), std::move(replacement));
 							}
-							else
+
+							return;
+						}
+
+						if (previous != nullptr)
+						{
+							boost::system::error_code closeErr;
+							previous->lowest_layer().close(closeErr);
+						}
+
+						// A fresh connection has its certificate verified again, and this must not
+						// pass for it.
+						m_upstreamCert = nullptr;
+
+						try
+						{
+							m_request->Reset();
+							m_response->Reset();
+						}
+						catch (std::exception& e)
+						{
+							ReportError(e.what());
+							Kill();
+							return;
+						}
+
+						m_keepAlive = true;
+						m_shouldTerminate = false;
+
+						SetStreamTimeout(boost::posix_time::minutes(5));
+
+						if (pooled)
+						{
+							m_upstreamIdle = true;
+							TryInitiateHttpTransaction();
+							return;
+						}
+
+						try
+						{
+							ResolveUpstream();
+							return;
+						}
+						catch (std::exception& e)
+						{
+							std::string errMsg(u8"In TlsCapableHttpBridge::ReconnectUpstream() - Got error:\t");
+							errMsg.append(e.what());
+							ReportError(errMsg);
+						}
+
+						Kill();
+					}
+
+					/// <summary>
+					/// Called by the timer wheel when the stream timeout has been reached, meaning
+					/// that the bridge should be terminated. Timeouts that are reset or cancelled
+					/// never get here, so there is nothing to ignore.
+					/// </summary>
+					void OnStreamTimeout()
+					{
+
+						#ifndef NDEBUG
+							ReportInfo(u8"TlsCapableHttpBridge<network::TlsSocket>::OnStreamTimeout");
+						#endif // !NDEBUG
+
+						Kill();
+					}					
+
+					/// <summary>
+					/// Completion handler for when the asynchrous handshake operation with the
+					/// remote upstream host has finished. If the operation was a success, then a
+					/// context by which to serve the connected client will either be retrieved, or
+					/// created, stored and then retrieved.
+					/// 
+					/// In the event that this operation was a failure, meaning that the supplied
+					/// error parameter was set and the code was one unexpected, the bridge will be 
+					/// terminated.
+					/// </summary>
+					/// <param name="error">
+					/// Error code that will indicate if any errors were handled during the async
+					/// operation, providing details if an error did occur and was handled.
+					/// </param>
+					void OnUpstreamHandshake(const boost::system::error_code& error)
+					{
+
+						#ifndef NDEBUG
+						ReportInfo(u8"TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamHandshake");
+						#endif // !NDEBUG
+
+						if (!error)
+						{
+							FinishStage(util::metrics::Stage::UpstreamHandshake);
+
+							const bool resumed = SSL_session_reused(m_upstreamSocket->native_handle()) != 0;
+
+							if (resumed && m_upstreamCert == nullptr)
+							{
+								// Resumed handshakes don't verify the chain again, so the verification
+								// callback never ran. The session still holds the certificate that was
+								// verified when it was established.
+								TakeUpstreamCertFromSession();
+							}
+
+							if (m_sessionCache != nullptr)
+							{
+								m_sessionCache->RecordClientHandshake(resumed);
+								m_sessionCache->StoreClientSession(m_upstreamSocket->native_handle(), m_upstreamHost, GetUpstreamPort());
+							}
+						}
+						else if (m_sessionCache != nullptr)
+						{
+							m_sessionCache->RemoveClientSession(m_upstreamHost, GetUpstreamPort());
+						}
+
+						if (!error && m_upstreamCert != nullptr)
+						{
+							if (m_http2 != nullptr)
 							{
-								ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnUpstreamHandshake(const boost::system::error_code&) - Failed to fetch spoofed context.");
+								// This is a reconnect, made for the next stream of an HTTP/2 client,
+								// whose own handshake is long done.
+								m_upstreamIdle = true;
+								TryInitiateHttpTransaction();
+								return;
 							}
+
+							SpoofDownstreamContext();
+							return;
 						}
 						else
 						{
@@ -2125,6 +2742,84 @@ namespace te
 						Kill();
 					}
 
+					/// <summary>
+					/// Called once the upstream connection is established and m_upstreamCert is
+					/// set, either by a completed handshake or by picking up a pooled connection.
+					/// Fetches the spoofed context for the upstream certificate, switches the
+					/// downstream stream over to it and initiates the downstream handshake. If any
+					/// of this fails, the bridge is terminated.
+					/// </summary>
+					void SpoofDownstreamContext()
+					{
+						std::shared_ptr<boost::asio::ssl::context> serverCtx;
+
+						try
+						{
+							serverCtx = m_certStore->GetServerContext(m_upstreamHost, m_upstreamCert);
+						}
+						catch (std::exception& e)
+						{
+							serverCtx = nullptr;
+							std::string errMessage(u8"In TlsCapableHttpBridge<network::TlsSocket>::SpoofDownstreamContext() - While spoofing, got error:\t");
+							errMessage.append(e.what());
+							ReportError(errMessage);
+						}
+
+						if (serverCtx != nullptr)
+						{
+							if (SSL_set_SSL_CTX(m_downstreamSocket.native_handle(), serverCtx->native_handle()) == serverCtx->native_handle())
+							{
+								m_serverContext = serverCtx;
+
+								// Set timeouts
+								SetStreamTimeout(boost::posix_time::minutes(5));
+								//
+
+								StartStage();
+								
+								m_downstreamSocket.async_handshake(
+									network::TlsSocket::server, 
+									m_downstreamStrand.wrap(
+										std::bind(
+											&TlsCapableHttpBridge::OnDownstreamHandshake, 
+											shared_from_this(), 
+											std::placeholders::_1
+											)
+										)
+									);
+
+								return;
+							}
+							else
+							{
+								ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::SpoofDownstreamContext() - Failed to correctly set context.");
+							}
+						}
+						else
+						{
+							ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::SpoofDownstreamContext() - Failed to fetch spoofed context.");
+						}
+
+						Kill();
+					}
+
+					/// <summary>
+					/// Sets m_upstreamCert from the session of the upstream stream, for the cases
+					/// where the verification callback didn't run because the connection was
+					/// resumed or pooled. Just like the cert handed to the verification callback,
+					/// the session owns it, so we don't keep the reference.
+					/// </summary>
+					void TakeUpstreamCertFromSession()
+					{
+						X509* peerCert = SSL_get_peer_certificate(m_upstreamSocket->native_handle());
+
+						if (peerCert != nullptr)
+						{
+							m_upstreamCert = peerCert;
+							X509_free(peerCert);
+						}
+					}
+
 					/// <summary>
 					/// Completion handler for when the asynchrous handshake operation with the
 					/// connected client has finished. If the operation was a success, then the
@@ -2147,9 +2842,33 @@ namespace te
 
 						if (!error)
 						{
+							FinishStage(util::metrics::Stage::DownstreamHandshake);
+
+							if (m_sessionCache != nullptr)
+							{
+								m_sessionCache->RecordServerHandshake(SSL_session_reused(m_downstreamSocket.native_handle()) != 0);
+							}
+
 							SetNoDelay(UpstreamSocket(), true);
 							SetNoDelay(DownstreamSocket(), true);
 
+							if (ApplicationProtocols::IsHttp2Selected(m_downstreamSocket.native_handle()))
+							{
+								// From here on, requests are read from and responses written to the
+								// streams of the client.
+								m_http2 = std::make_shared<http2::Http2Connection<BridgeSocketType>>(
+									m_downstreamSocket,
+									m_downstreamStrand,
+									std::weak_ptr<void>(shared_from_this()),
+									m_upstreamHost,
+									m_onInfo,
+									m_onWarning,
+									m_onError
+									);
+
+								m_http2->Start();
+							}
+
 							TryInitiateHttpTransaction();
 							return;
 						}
@@ -2164,8 +2883,8 @@ namespace te
 					/// <summary>
 					/// Handler for the peek read operation on newly connected TLS clients. Only
 					/// ever used in the case that BridgeSocketType is network::TlsSocket. In this
-					/// handler, we manually parse the TLS client hello message, search for the SNI
-					/// extension and attempt to extract the value. If we succeed, then the
+					/// handler, the TLS client hello message is handed to util::tls::FindServerName(...),
+					/// which searches it for the SNI extension and its value. If we succeed, then the
 					/// extracted host will be resolved with "https" as the service, so that we get
 					/// endpoints already configured to connect to port 443. The OnResolve handlers
 					/// are specialized, so the correct functionality and order of operations will
@@ -2192,212 +2911,85 @@ namespace te
 						ReportInfo(u8"TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek");
 						#endif // !NDEBUG
 
-						// Parsing Numbers
-						//
-						// https://www.ietf.org/rfc/rfc5246.txt Sections 4.1, 4.4:
-						// Data is stored is big-endian. Basic storage unit is uint8_t (one byte, 8 bits). Multibyte data sequences are
-						// concatenated left to right. Example code given is:
-						// value = (byte[0] << 8*(n-1)) | (byte[1] << 8*(n-2)) ... | byte[n - 1];
-						//
-						//
-						// Parsing Strings
-						//
-						// https://www.ietf.org/rfc/rfc4366.txt Section 3.1, page 9:
-						// "The hostname is represented as a byte string using UTF - 8 encoding[UTF8], without a trailing dot."
-						// If hostname only contains US-ASCII chars, labels must be separated using 0x2E byte, representing
-						// the U+002E char.
-
 						if (m_tlsPeekBuffer != nullptr && !error && bytesTransferred > 0)
-						{						
-							if (bytesTransferred > MinTlsHelloLength)
+						{
+							boost::string_ref hostName;
+
+							switch (util::tls::FindServerName(m_tlsPeekBuffer->data(), (std::min)(bytesTransferred, m_tlsPeekBuffer->size()), hostName))
 							{
-								auto sharedThis = shared_from_this();
-								auto WithinBounds = [sharedThis, this]
-									(const std::unique_ptr< std::array<char, TlsPeekBufferSize> >& arr, const size_t position, const size_t validDataLength, int crumb = 0)->bool
+								case util::tls::ClientHelloStatus::ServerNameFound:
 								{
-									// Crumb param helps identify which point the check was done and failed. Not really
-									// sure if I should take this out after I finish sorting this parsing method, as it
-									// may assist in the future.
-									if (position >= arr->size() || position > validDataLength)
-									{
-										#ifndef NDEBUG
-											std::string errMessage(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - ");
-											errMessage.append(u8"Index in buffer is out of bounds at position ").append(std::to_string(position)).append(u8".\n\n");
-											errMessage.append(u8"Went out of bounds at check ").append(std::to_string(crumb)).append(u8".");
-											ReportError(errMessage);
-										#endif
-										
-										return false;
-									}
+									m_upstreamHost = hostName.to_string();
 
-									return true;
-								};
+									// Done with the hello. No reason to hang onto the buffer for the
+									// life of the connection.
+									m_tlsPeekBuffer.reset();
 
-								auto contentType = (*m_tlsPeekBuffer)[0];
-								auto versionMajor = (*m_tlsPeekBuffer)[1];
-								auto versionMinor = (*m_tlsPeekBuffer)[2];
-								auto handshakeType = (*m_tlsPeekBuffer)[5];
+									// See notes in the version of ::OnResolve(...), specialized for TLS clients.
+									m_upstreamHostPort = GetUpstreamPort();
 
-								if ((versionMajor == 3 && versionMinor > 0) || (versionMinor > 3))
-								{
-									if (contentType == 22 && handshakeType == 1)
+									if (m_upstreamPool != nullptr)
 									{
-										boost::string_ref hostName(m_tlsPeekBuffer->data(), bytesTransferred);
-										size_t hostnameLength = 0;
-
-										size_t position = MinTlsHelloLength;
-
-										// Get session ID length.
-										size_t sessionIdLength = reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position]);
-
-										// Now skip past session ID.
-										position += sessionIdLength + 1;
+										auto pooled = m_upstreamPool->Acquire(m_upstreamHost, GetUpstreamPort(), PooledAddress(), *m_service);
 
-										if (!WithinBounds(m_tlsPeekBuffer, position + 1, bytesTransferred))
+										if (pooled != nullptr)
 										{
-											Kill();
-											return;
-										}
-
-										// Get cipher suites length.
-										size_t cipherSuitesLength = ((reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position])) << 8) | reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 1]);
-
-										// Now skip past cipher suites.
-										position += cipherSuitesLength + 2;
-
-										if (!WithinBounds(m_tlsPeekBuffer, position, bytesTransferred, 1))
-										{
-											Kill();
-											return;
-										}
-
-										// Get compression methods length.
-										size_t compressionMethodsLength = reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position]);
-
-										// Now skip past compression methods.
-										position += compressionMethodsLength + 1;
-
-										if (!WithinBounds(m_tlsPeekBuffer, position + 1, bytesTransferred, 2))
-										{
-											Kill();
-											return;
-										}
-
-										// Get extensions length.
-										size_t extensionsLength = ((reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position])) << 8) | reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 1]);
-
-										// Now skip past just the extensions length bytes.
-										position += 2;
-
-										if (!WithinBounds(m_tlsPeekBuffer, position, bytesTransferred, 3))
-										{
-											Kill();
-											return;
-										}
+											// A live connection to this host that was verified when it was
+											// established. Its certificate is what we spoof for the client.
+											m_upstreamSocket = std::move(pooled);
+											TakeUpstreamCertFromSession();
 
-										// Parse each extension till we hopefully find SNI
-										bool notDone = true;
-										while (position < bytesTransferred && notDone)
-										{
-											if (!WithinBounds(m_tlsPeekBuffer, position + 4, bytesTransferred, 4))
+											if (m_upstreamCert != nullptr)
 											{
-												Kill();
+												SpoofDownstreamContext();
 												return;
 											}
 
-											// Get the extension type.
-											size_t extensionType = ((reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position])) << 8) | reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 1]);
-
-											// Get the length of this extension.
-											size_t extensionLength = ((reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 2])) << 8) | reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 3]);
-												
-											// Skip beyond extension type and extension length.
-											position += 4;
-
-											// Check if it's SNI
-											if (extensionType == 0)
-											{
-												// Skip Server Name Indication Length.
-												position += 2;
-
-												if (!WithinBounds(m_tlsPeekBuffer, position + 4, bytesTransferred, 5))
-												{
-													Kill();
-													return;
-												}
+											// Without the certificate the connection is no use to us. Start
+											// over with a fresh one.
+											m_upstreamSocket = NewUpstreamSocket();
+										}
+									}
 
-												while (position < bytesTransferred && notDone)
-												{
-													if (!WithinBounds(m_tlsPeekBuffer, position + 3, bytesTransferred, 6))
-													{
-														Kill();
-														return;
-													}
+									try
+									{	
+										ResolveUpstream();
+										return;
+									}
+									catch (std::exception& e)
+									{
+										std::string errorMessage(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Got Error:\t");
+										errorMessage.append(e.what());
+										ReportError(errorMessage);
+									}
+								}
+								break;
 
-													// Get SNI part length.
-													size_t sniPartLength = ((reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 1])) << 8) | reinterpret_cast<const char&>((*m_tlsPeekBuffer)[position + 2]);
-																									
-													if ((*m_tlsPeekBuffer)[position] == 0)
-													{
-														hostnameLength = sniPartLength;
-														hostName = hostName.substr(position + 3, sniPartLength);
-														notDone = false;
-														break;
-													}
+								case util::tls::ClientHelloStatus::NotTls:
+								{
+									ReportWarning(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Not a TLS client.");
+								}
+								break;
 
-													position += 3 + sniPartLength;
-												}
-											}
+								case util::tls::ClientHelloStatus::NotClientHello:
+								{
+									ReportWarning(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Not a TLS client hello.");
+								}
+								break;
 
-											position += extensionLength;
-										}
+								case util::tls::ClientHelloStatus::NoServerName:
+								{
+									ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Failed to extract hostname from SNI extension.");
+								}
+								break;
 
-										if (hostnameLength > 0)
-										{
-											m_upstreamHost = hostName.to_string();
-
-											// XXX TODO - See notes in the version of ::OnResolve(...), specialized for TLS clients.
-											m_upstreamHostPort = 443;
-
-											try
-											{	
-												boost::asio::ip::tcp::resolver::query query(m_upstreamHost, "https");
-												
-												m_resolver.async_resolve(
-													query, 
-													m_upstreamStrand.wrap(
-														std::bind(
-															&TlsCapableHttpBridge::OnResolve, 
-															shared_from_this(), 
-															std::placeholders::_1, 
-															std::placeholders::_2
-															)
-														)
-													);
-
-												return;
-											}
-											catch (std::exception& e)
-											{
-												std::string errorMessage(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Got Error:\t");
-												errorMessage.append(e.what());
-												ReportError(errorMessage);
-											}
-										}
-										else
-										{
-											ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Failed to extract hostname from SNI extension.");
-										}
-									}
-									else
-									{
-										ReportWarning(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Not a TLS client hello.");
-									}
-								}
-								else
+								case util::tls::ClientHelloStatus::Truncated:
 								{
-									ReportWarning(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Not a TLS client.");
+									#ifndef NDEBUG
+									ReportError(u8"In TlsCapableHttpBridge<network::TlsSocket>::OnTlsPeek(const boost::system::error_code&, const size_t) - Client hello is cut short, or malformed.");
+									#endif
 								}
+								break;
 							}
 						}
 						else
@@ -2446,7 +3038,7 @@ namespace te
 					/// </returns>
 					bool VerifyServerCertificateCallback(bool preverified, boost::asio::ssl::verify_context& ctx);
 
-					void HandleDownstreamPassthrough(std::shared_ptr<std::array<char, 1638400>> buff, const boost::system::error_code& ec, const size_t bytesTransferred)
+					void HandleDownstreamPassthrough(util::mem::SharedBuffer buff, const boost::system::error_code& ec, const size_t bytesTransferred)
 					{
 						//ReportInfo(u8"HandleDownstreamPassthrough");
 
@@ -2462,11 +3054,11 @@ namespace te
 								auto self(shared_from_this());
 
 								boost::asio::async_write(
-									m_upstreamSocket,
+									*m_upstreamSocket,
 									boost::asio::buffer(buff->data(), bytesTransferred),
 									boost::asio::transfer_exactly(bytesTransferred),
 									m_upstreamStrand.wrap(
-										[this, self, buff, closeAfter](const boost::system::error_code& err, const size_t bytesSent)
+										[this, self, buff, closeAfter, bytesTransferred](const boost::system::error_code& err, const size_t bytesSent)
 										{
 											if (closeAfter)
 											{
@@ -2477,14 +3069,18 @@ namespace te
 
 											if (!err)
 											{
+												// If the last read filled the buffer, there's probably more where
+												// that came from, so read in bigger pieces.
+												auto nextBuff = util::mem::BufferPool::Shared().Grow(buff, bytesTransferred, PassthroughMaxBufferSize);
+
 												boost::asio::async_read(
 													m_downstreamSocket,
-													boost::asio::buffer(buff->data(), buff->size()),
+													boost::asio::buffer(nextBuff->data(), nextBuff->size()),
 													boost::asio::transfer_at_least(1),
 													std::bind(
 														&TlsCapableHttpBridge::HandleDownstreamPassthrough,
 														shared_from_this(),
-														buff,
+														nextBuff,
 														std::placeholders::_1,
 														std::placeholders::_2
 													)
@@ -2532,7 +3128,7 @@ namespace te
 						Kill();
 					}
 
-					void HandleUpstreamPassthrough(std::shared_ptr<std::array<char, 1638400>> buff, const boost::system::error_code& ec, const size_t bytesTransferred)
+					void HandleUpstreamPassthrough(util::mem::SharedBuffer buff, const boost::system::error_code& ec, const size_t bytesTransferred)
 					{
 						//ReportInfo(u8"HandleUpstreamPassthrough");
 
@@ -2552,7 +3148,7 @@ namespace te
 									boost::asio::buffer(buff->data(), bytesTransferred),
 									boost::asio::transfer_exactly(bytesTransferred),
 									m_downstreamStrand.wrap(
-										[this, self, buff, closeAfter](const boost::system::error_code& err, const size_t bytesSent)
+										[this, self, buff, closeAfter, bytesTransferred](const boost::system::error_code& err, const size_t bytesSent)
 										{
 											if (closeAfter)
 											{
@@ -2563,14 +3159,18 @@ namespace te
 
 											if (!err)
 											{
+												// If the last read filled the buffer, there's probably more where
+												// that came from, so read in bigger pieces.
+												auto nextBuff = util::mem::BufferPool::Shared().Grow(buff, bytesTransferred, PassthroughMaxBufferSize);
+
 												boost::asio::async_read(
-													m_upstreamSocket,
-													boost::asio::buffer(buff->data(), buff->size()),
+													*m_upstreamSocket,
+													boost::asio::buffer(nextBuff->data(), nextBuff->size()),
 													boost::asio::transfer_at_least(1),
 													std::bind(
 														&TlsCapableHttpBridge::HandleUpstreamPassthrough,
 														shared_from_this(),
-														buff,
+														nextBuff,
 														std::placeholders::_1,
 														std::placeholders::_2
 													)
@@ -2591,7 +3191,7 @@ namespace te
 							}
 
 							boost::asio::async_read(
-								m_upstreamSocket,
+								*m_upstreamSocket,
 								boost::asio::buffer(buff->data(), buff->size()),
 								boost::asio::transfer_at_least(1),
 								std::bind(
@@ -2618,8 +3218,15 @@ namespace te
 						Kill();
 					}
 
-					void StartPassthroughVolley(std::shared_ptr<std::array<char, TlsPeekBufferSize>> downstreamBuff, const size_t initialBytes)
+					void StartPassthroughVolley(util::mem::SharedBuffer downstreamBuff, const size_t initialBytes)
 					{	
+						// Once we're just shoveling bytes, there is no telling what state the
+						// upstream connection is left in.
+						if (!ClaimUpstream())
+						{
+							return;
+						}
+
 						ReportInfo(u8"Starting passthrough.");
 						SetStreamTimeout(boost::posix_time::minutes(5));
 
@@ -2631,26 +3238,26 @@ namespace te
 
 						try
 						{
-							boost::asio::write(m_upstreamSocket, boost::asio::buffer(downstreamBuff->data(), initialBytes), boost::asio::transfer_exactly(initialBytes), iwe);
+							boost::asio::write(*m_upstreamSocket, boost::asio::buffer(downstreamBuff->data(), initialBytes), boost::asio::transfer_exactly(initialBytes), iwe);
 						}
 						catch (std::exception& e)
 						{
-							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(std::shared_ptr<std::array<char, TlsPeekBufferSize>>, const size_t) - Got error while writing initial payload:\t");
+							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(util::mem::SharedBuffer, const size_t) - Got error while writing initial payload:\t");
 							errMsg.append(e.what());
 							ReportError(errMsg);
 						}
 
 						if (iwe)
 						{
-							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(std::shared_ptr<std::array<char, TlsPeekBufferSize>>, const size_t) - Got error while writing initial payload:\t");
+							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(util::mem::SharedBuffer, const size_t) - Got error while writing initial payload:\t");
 							errMsg.append(iwe.message());
 							ReportError(errMsg);
 						}
 
 						try
 						{
-							std::shared_ptr<std::array<char, 1638400>> dsb = std::make_shared< std::array<char, 1638400> >();
-							std::shared_ptr<std::array<char, 1638400>> usb = std::make_shared< std::array<char, 1638400> >();
+							auto dsb = util::mem::BufferPool::Shared().Acquire(PassthroughInitialBufferSize);
+							auto usb = util::mem::BufferPool::Shared().Acquire(PassthroughInitialBufferSize);
 
 							HandleDownstreamPassthrough(dsb, err, 0);
 							HandleUpstreamPassthrough(usb, err, 0);
@@ -2658,7 +3265,7 @@ namespace te
 						}
 						catch (std::exception& e)
 						{
-							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(std::shared_ptr<std::array<char, TlsPeekBufferSize>>, const size_t) - Got errorsss while writing initial payload:\t");
+							std::string errMsg(u8"In TlsCapableHttpBridge::StartPassthroughVolley(util::mem::SharedBuffer, const size_t) - Got errorsss while writing initial payload:\t");
 							errMsg.append(e.what());
 							ReportError(errMsg);
 						}
@@ -2682,10 +3289,10 @@ namespace te
 							// Allow 5 seconds for a peek read.
 							SetStreamTimeout(boost::posix_time::minutes(5));
 
-							std::shared_ptr<std::array<char, TlsPeekBufferSize>> httpPeekBuffer = std::make_shared< std::array<char, TlsPeekBufferSize> >();
+							auto httpPeekBuffer = util::mem::BufferPool::Shared().Acquire(TlsPeekBufferSize);
 
 							boost::asio::async_read(
-								m_downstreamSocket,
+								m_downstream,
 								boost::asio::buffer(httpPeekBuffer->data(), httpPeekBuffer->size()),
 								boost::asio::transfer_at_least(18),
 								m_downstreamStrand.wrap(
@@ -2706,7 +3313,7 @@ namespace te
 					}
 					
 
-					void OnInitialPeek(const boost::system::error_code& error, const size_t bytesTransferred, std::shared_ptr<std::array<char, TlsPeekBufferSize>> httpPeekBuffer)
+					void OnInitialPeek(const boost::system::error_code& error, const size_t bytesTransferred, util::mem::SharedBuffer httpPeekBuffer)
 					{
 						if (!error && httpPeekBuffer && httpPeekBuffer.get() && httpPeekBuffer->data() && bytesTransferred > 0)
 						{
@@ -2719,6 +3326,15 @@ namespace te
 							std::string parsedHost;
 							auto parseResult = p.Parse(httpPeekBuffer->data(), bytesTransferred, parsedHost);
 
+							if (m_http2 != nullptr && parseResult != PreviewParser::ParseResult::IsHttp)
+							{
+								// The session only ever hands out plain HTTP/1.1 requests, and there's
+								// no passing an HTTP/2 stream through.
+								ReportError(u8"In TlsCapableHttpBridge::OnInitialPeek(const boost::system::error_code&, const size_t, util::mem::SharedBuffer) - Got a request from an HTTP/2 stream that isn't plain HTTP.");
+								Kill();
+								return;
+							}
+
 							switch (parseResult)
 							{
 								case PreviewParser::ParseResult::Failure:
@@ -2736,10 +3352,10 @@ namespace te
 									// Set the timeout to something reasonable.
 									SetStreamTimeout(boost::posix_time::minutes(5));
 
-									// Create a new request for this data and just jump to OnDownstreamHeaders.
+									// Hand what we peeked to the request and just jump to OnDownstreamHeaders.
 									try
 									{
-										m_request.reset(new http::HttpRequest(httpPeekBuffer->data(), bytesTransferred));
+										m_request->AdoptReadBuffer(httpPeekBuffer);
 										m_shouldTerminate = false;
 									}
 									catch (std::exception& e)
@@ -2936,22 +3552,66 @@ namespace te
 					/// </param>
 					void SetStreamTimeout(const boost::posix_time::time_duration& expiry)
 					{
-						m_streamTimer.cancel();
+						if (m_timerWheel == nullptr)
+						{
+							return;
+						}
+
+						if (m_streamTimeout == nullptr)
+						{
+							// Weak, so that the wheel never keeps a bridge alive that nothing else
+							// is waiting on.
+							std::weak_ptr<TlsCapableHttpBridge> weakSelf = shared_from_this();
+
+							m_streamTimeout = m_timerWheel->MakeTimer([weakSelf]()
+							{
+								auto self = weakSelf.lock();
 
-						m_streamTimer.expires_from_now(expiry);
+								if (self != nullptr)
+								{
+									self->OnStreamTimeout();
+								}
+							});
+						}
 
-						m_streamTimer.async_wait(std::bind(&TlsCapableHttpBridge::OnStreamTimeout, shared_from_this(), std::placeholders::_1));
+						// Costs next to nothing within the same tick of the wheel, which is where
+						// nearly every reset on a busy stream lands.
+						m_timerWheel->Arm(m_streamTimeout, expiry);
 					}
 
 					/// <summary>
-					/// Cancels the current stream timer and then sets it to positive infinity.
+					/// Cancels the current stream timeout, so that the stream never times out.
 					/// </summary>
 					void SetInfiniteStreamTimeout()
 					{
-						m_streamTimer.cancel();
+						if (m_streamTimeout != nullptr)
+						{
+							m_streamTimeout->Cancel();
+						}
+					}
 
-						m_streamTimer.expires_at(boost::posix_time::pos_infin);
-						return;
+					/// <summary>
+					/// Marks the start of the resolve, connect or handshake about to be initiated.
+					/// </summary>
+					void StartStage()
+					{
+						m_stageStarted = util::metrics::EngineMetrics::Clock::now();
+					}
+
+					/// <summary>
+					/// Records the time since ::StartStage() against the supplied stage, if a stage
+					/// was started.
+					/// </summary>
+					/// <param name="stage">
+					/// The stage that has just completed.
+					/// </param>
+					void FinishStage(const util::metrics::Stage stage)
+					{
+						if (m_stageStarted != util::metrics::EngineMetrics::Clock::time_point())
+						{
+							util::metrics::EngineMetrics::Shared().RecordSince(stage, m_stageStarted);
+							m_stageStarted = util::metrics::EngineMetrics::Clock::time_point();
+						}
 					}
 
 					/// <summary>
@@ -3003,6 +3663,199 @@ namespace te
 						}
 					}
 
+					/// <summary>
+					/// Gets the port the upstream connection is made to, for keying the upstream
+					/// session cache and connection pool.
+					/// </summary>
+					/// <returns>
+					/// The upstream port.
+					/// </returns>
+					const uint16_t GetUpstreamPort() const
+					{
+						if (m_upstreamHostPort != 0)
+						{
+							return m_upstreamHostPort;
+						}
+
+						const uint16_t originalPort = GetOriginalPort();
+
+						if (originalPort != 0)
+						{
+							return originalPort;
+						}
+
+						return std::is_same<BridgeSocketType, network::TlsSocket>::value ? 443 : 80;
+					}
+
+					/// <summary>
+					/// Gets the port the client was originally trying to reach, as recorded by the
+					/// diverter. All the downstream connection shows us is the port of our listener.
+					/// </summary>
+					/// <returns>
+					/// The original port, or zero if none was recorded.
+					/// </returns>
+					const uint16_t GetOriginalPort() const
+					{
+						boost::system::error_code ec;
+						auto remote = m_downstreamSocket.lowest_layer().remote_endpoint(ec);
+
+						if (ec)
+						{
+							return 0;
+						}
+
+						// Our listeners are dual mode, so v4 clients show up as mapped addresses.
+						const auto address = remote.address();
+						const bool v6 = address.is_v6() && !address.to_v6().is_v4_mapped();
+
+						return network::OriginalPortTable::Shared().Get(v6, remote.port());
+					}
+
+					/// <summary>
+					/// Gets the address the client was originally trying to reach. The diverter
+					/// sends a client's packets to us with the source and destination addresses
+					/// swapped, so the remote address of the downstream connection is the address
+					/// the client resolved and connected to. Connecting straight to it spares us a
+					/// resolve, and also means we end up at whatever server the client chose.
+					/// </summary>
+					/// <param name="address">
+					/// Receives the original destination address, if usable.
+					/// </param>
+					/// <returns>
+					/// True if the address is usable. False if the downstream connection isn't
+					/// diverted, as is the case for loopback and private addresses, which the
+					/// diverter never sends to us.
+					/// </returns>
+					bool GetOriginalDestination(boost::asio::ip::address& address)
+					{
+						boost::system::error_code ec;
+						auto remote = m_downstreamSocket.lowest_layer().remote_endpoint(ec);
+
+						if (ec)
+						{
+							return false;
+						}
+
+						address = remote.address();
+
+						// Our listeners are dual mode, so v4 clients show up as mapped addresses.
+						if (address.is_v6() && address.to_v6().is_v4_mapped())
+						{
+							address = address.to_v6().to_v4();
+						}
+
+						if (address.is_unspecified() || address.is_loopback() || address.is_multicast())
+						{
+							return false;
+						}
+
+						if (address.is_v4())
+						{
+							auto bytes = address.to_v4().to_bytes();
+
+							return !(bytes[0] == 10 ||
+								(bytes[0] == 172 && (bytes[1] & 0xF0) == 16) ||
+								(bytes[0] == 192 && bytes[1] == 168) ||
+								(bytes[0] == 169 && bytes[1] == 254));
+						}
+
+						auto v6 = address.to_v6();
+
+						return !(v6.is_link_local() || v6.is_site_local() || (v6.to_bytes()[0] & 0xFE) == 0xFC);
+					}
+
+					/// <summary>
+					/// Gets the address we'd connect to for m_upstreamHost without a resolve. That's
+					/// the original destination of the client if we have one, and a cached resolve of
+					/// the host if not. Pooled connections are only taken if they're connected to
+					/// this very address, since the host is only ever what the client claims.
+					/// </summary>
+					/// <param name="address">
+					/// Receives the address, if there is one.
+					/// </param>
+					/// <returns>
+					/// True if there is an address, false if only the resolver can tell.
+					/// </returns>
+					bool GetUpstreamAddress(boost::asio::ip::address& address)
+					{
+						return GetOriginalDestination(address) || (m_dnsCache != nullptr && m_dnsCache->Lookup(m_upstreamHost, address));
+					}
+
+					/// <summary>
+					/// Gets the address to take a pooled connection for, which is unspecified, and
+					/// so never matches, if ::GetUpstreamAddress(...) has none.
+					/// </summary>
+					boost::asio::ip::address PooledAddress()
+					{
+						boost::asio::ip::address address;
+
+						if (!GetUpstreamAddress(address))
+						{
+							return boost::asio::ip::address();
+						}
+
+						return address;
+					}
+
+					/// <summary>
+					/// Finds the endpoint for m_upstreamHost and hands it to ::OnResolve(...) on the
+					/// upstream strand. The original destination of the client is used if we have
+					/// one, a cached resolve of the host if not, and the resolver only as a last
+					/// resort. Results from the resolver are cached for the next bridge. Can throw.
+					/// </summary>
+					void ResolveUpstream()
+					{
+						const char* service = std::is_same<BridgeSocketType, network::TlsSocket>::value ? "https" : "http";
+
+						if (m_upstreamHostPort == 0)
+						{
+							// A client diverted from a port other than the standard one, without
+							// saying so in its host header, still has to go back to that port.
+							m_upstreamHostPort = GetOriginalPort();
+						}
+
+						StartStage();
+
+						boost::asio::ip::address address;
+
+						if (GetUpstreamAddress(address))
+						{
+							// ::OnResolve(...) applies m_upstreamHostPort if it's set, the same as it
+							// would for a real resolve, so the service default is all we need here.
+							boost::asio::ip::tcp::endpoint endpoint(address, std::is_same<BridgeSocketType, network::TlsSocket>::value ? 443 : 80);
+
+							m_upstreamStrand.post(
+								std::bind(
+									&TlsCapableHttpBridge::OnResolve,
+									shared_from_this(),
+									boost::system::error_code(),
+									boost::asio::ip::tcp::resolver::iterator::create(endpoint, m_upstreamHost, service)
+									)
+								);
+
+							return;
+						}
+
+						boost::asio::ip::tcp::resolver::query query(m_upstreamHost, service);
+
+						auto self(shared_from_this());
+
+						m_resolver.async_resolve(
+							query,
+							m_upstreamStrand.wrap(
+								[this, self](const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator endpointIterator)
+								{
+									if (!error && m_dnsCache != nullptr && endpointIterator != boost::asio::ip::tcp::resolver::iterator())
+									{
+										m_dnsCache->Store(m_upstreamHost, endpointIterator->endpoint().address());
+									}
+
+									OnResolve(error, endpointIterator);
+								}
+								)
+							);
+					}
+
 					/// <summary>
 					/// Determines if the supplied socket has data waiting to be read off the buffer.
 					/// This is used to attempt to determine if a transaction is complete whenever we
@@ -3023,144 +3876,600 @@ namespace te
 						return bytes_readable > 0;
 					}
 
-					const bool ShouldBlockTransaction(http::BaseHttpTransaction* request, http::BaseHttpTransaction* response = nullptr)
+					/// <summary>
+					/// Asks the callbacks whether the transaction should be blocked. Once the
+					/// request or response has been held back in full, that's the end callback,
+					/// otherwise it's the begin callback, whose answer also decides how the rest of
+					/// the transaction is inspected.
+					///
+					/// A message matched by a rule of the rule table is answered by the rule, and a
+					/// request whose verdict was cached by an earlier begin callback for the same
+					/// URL is answered from the cache, both without a callback.
+					///
+					/// Either callback may defer its verdict instead of answering. The bridge is
+					/// then parked, without holding a thread, until the verdict is delivered or
+					/// the wait times out, at which point the supplied continuation is posted to
+					/// the supplied strand with the verdict applied.
+					/// </summary>
+					/// <param name="request">
+					/// The request.
+					/// </param>
+					/// <param name="response">
+					/// The response, if one has been read.
+					/// </param>
+					/// <param name="strand">
+					/// The strand the caller is running on, and the continuation is posted to.
+					/// </param>
+					/// <param name="onDeferredVerdict">
+					/// Called with whether the transaction should be blocked, only in the event
+					/// that the verdict was deferred.
+					/// </param>
+					/// <param name="deferred">
+					/// Set to true if the verdict was deferred. The return value is meaningless
+					/// then, and the caller must return without doing anything more.
+					/// </param>
+					/// <returns>
+					/// True if the transaction should be blocked, false otherwise.
+					/// </returns>
+					const bool ShouldBlockTransaction(
+						http::HttpRequest* request,
+						http::HttpResponse* response,
+						network::OptionalStrand& strand,
+						VerdictContinuation onDeferredVerdict,
+						bool& deferred
+						)
 					{
-						auto requestHeaders = request->HeadersToString();
-						auto responseHeaders = response != nullptr ? response->HeadersToString() : std::string();
-						
-						const char* requestPayload = nullptr;
-						uint32_t requestPayloadSize = 0;
-
-						const char* responsePayload = nullptr;
-						uint32_t responsePayloadSize = 0;
-
-
 						uint32_t nextAction = 0;						
 						bool shouldBlock = false;
 
-						std::vector<char> customBlockResponse;
-						
-                        const auto myStreamChannel = s_streamCopyContainer.ClaimNextChannel(&customBlockResponse);                        
+						deferred = false;
+
+						// The callbacks read whatever they need through the context, so
+						// nothing is formatted or copied up front.
+						util::cb::TransactionContext context(request, response);
 
 						bool inspectRequest = request->GetConsumeAllBeforeSending() && request->IsPayloadComplete();
 						bool inspectResponse = (response != nullptr && response->GetConsumeAllBeforeSending() && response->IsPayloadComplete());
 
-						if ((inspectRequest && !inspectResponse) || (inspectRequest && inspectResponse))
+						const bool isEnd = (inspectRequest && !inspectResponse) || (inspectRequest && inspectResponse);
+
+						// Only the verdict on the request headers is cached, as that's all the
+						// key says anything about.
+						const bool cacheable = !isEnd && response == nullptr && m_verdictCache != nullptr;
+
+						if (!isEnd && m_rules != nullptr && m_rules->GetRuleCount() > 0 && ApplyRules(request, response, context, nextAction))
 						{
-							requestPayload = inspectRequest ? request->GetPayload().data() : nullptr;
-							requestPayloadSize = inspectRequest ? request->GetPayload().size() : 0;
+							return ApplyBeginVerdict(request, response, nextAction, nullptr, 0);
+						}
 
-							responsePayload = inspectResponse ? response->GetPayload().data() : nullptr;
-							responsePayloadSize = inspectResponse ? response->GetPayload().size() : 0;
+						if (cacheable)
+						{
+							std::shared_ptr<const char> cachedResponse;
+							size_t cachedResponseLength = 0;
 
-							m_onMessageEnd(
-								requestHeaders.c_str(), requestHeaders.size(),
-								requestPayload, requestPayloadSize,
-								responseHeaders.c_str(), responseHeaders.size(),
-								responsePayload, responsePayloadSize,
-								&shouldBlock, myStreamChannel.GetWriter()
-                            );
+							if (m_verdictCache->Lookup(context.GetHost(), context.GetMethod(), context.GetPath(), nextAction, cachedResponse, cachedResponseLength))
+							{
+								return ApplyBeginVerdict(request, response, nextAction, std::move(cachedResponse), cachedResponseLength);
+							}
+						}
+
+						uint64_t token = 0;
 
-							if (shouldBlock)
+						if (m_deferredVerdicts != nullptr)
+						{
+							context.AllowDeferral([this, &token, request, response, &strand, &onDeferredVerdict, isEnd]()
 							{
-								if (customBlockResponse.size() > 0)
-								{									
-									request->SetPayload(std::move(customBlockResponse), true);
-									return true;
-								}
-								else
-								{	
-									request->Make204();
+								if (token == 0)
+								{
+									token = DeferVerdict(request, response, strand, onDeferredVerdict, isEnd);
 								}
 
-								request->SetShouldBlock(1);
-								
-								return true;
-							}
+								return token;
+							});
+						}
+
+						if (isEnd)
+						{
+							util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::MessageEndCallback);
+							m_onMessageEnd(&context, &shouldBlock);
 						}
 						else
 						{
-							m_onMessageBegin(
-								requestHeaders.c_str(), requestHeaders.size(),
-								nullptr, 0, 
-								responseHeaders.c_str(), responseHeaders.size(),
-								nullptr, 0,
-								&nextAction, myStreamChannel.GetWriter()
+							util::metrics::EngineMetrics::ScopedTimer timer(util::metrics::Stage::MessageBeginCallback);
+							m_onMessageBegin(&context, &nextAction);
+						}
+
+						if (context.IsDeferred())
+						{
+							// The handler posted on delivery keeps us alive, so there's nothing
+							// to hold on to while parked, other than the timer.
+							m_verdictTimer.expires_from_now(boost::posix_time::milliseconds(m_deferredVerdicts->GetTimeoutMilliseconds()));
+
+							m_verdictTimer.async_wait(
+								strand.wrap(
+									std::bind(
+										&TlsCapableHttpBridge::OnVerdictTimeout,
+										shared_from_this(),
+										std::placeholders::_1,
+										token
+									)
+								)
 							);
 
-							switch (nextAction)
+							deferred = true;
+							return false;
+						}
+
+						size_t blockResponseLength = 0;
+						auto blockResponse = context.TakeBlockResponse(blockResponseLength);
+
+						if (isEnd)
+						{
+							return ApplyEndVerdict(request, shouldBlock, std::move(blockResponse), blockResponseLength);
+						}
+
+						uint32_t ttlMilliseconds = 0;
+
+						if (cacheable && context.ShouldCacheVerdict(ttlMilliseconds))
+						{
+							// The cached block response is shared by every request it answers,
+							// which is fine, as it's only ever read from.
+							m_verdictCache->Store(context.GetHost(), context.GetMethod(), context.GetPath(), nextAction, nextAction == 2 ? blockResponse : nullptr, nextAction == 2 ? blockResponseLength : 0, ttlMilliseconds);
+						}
+
+						return ApplyBeginVerdict(request, response, nextAction, std::move(blockResponse), blockResponseLength);
+					}
+
+					/// <summary>
+					/// Checks the message against the rule table, ahead of the begin callback.
+					/// </summary>
+					/// <param name="request">
+					/// The request.
+					/// </param>
+					/// <param name="response">
+					/// The response, if one has been read.
+					/// </param>
+					/// <param name="context">
+					/// The context the callback would be given.
+					/// </param>
+					/// <param name="nextAction">
+					/// Receives the next action the matching rule stands for, if any.
+					/// </param>
+					/// <returns>
+					/// True if a rule decided for the message, false if it's up to the callback.
+					/// </returns>
+					const bool ApplyRules(http::HttpRequest* request, http::HttpResponse* response, util::cb::TransactionContext& context, uint32_t& nextAction)
+					{
+						const http::BaseHttpTransaction* transaction = response;
+
+						if (transaction == nullptr)
+						{
+							transaction = request;
+						}
+
+						uint64_t contentLength = 0;
+						const bool hasContentLength = context.GetContentLength(contentLength);
+
+						util::cb::RuleAction action = util::cb::RuleAction::CallBack;
+
+						if (!m_rules->Match(context.GetHost(), context.GetMethod(), transaction->GetMediaKinds(), hasContentLength, contentLength, action))
+						{
+							return false;
+						}
+
+						switch (action)
+						{
+							case util::cb::RuleAction::Pass:
+								nextAction = 0;
+							break;
+
+							case util::cb::RuleAction::PassWithoutInspect:
+								nextAction = 3;
+							break;
+
+							case util::cb::RuleAction::Block204:
+								nextAction = 2;
+							break;
+
+							default:
+								return false;
+						}
+
+						util::metrics::EngineMetrics::Shared().Increment(util::metrics::Counter::RuleVerdicts);
+
+						return true;
+					}
+
+					/// <summary>
+					/// Registers a deferred verdict for the transaction. When it's delivered, the
+					/// verdict is applied on the supplied strand and the continuation is invoked
+					/// with the result.
+					/// </summary>
+					/// <returns>
+					/// The token the verdict is to be delivered with, or zero if no more verdicts
+					/// may be deferred right now.
+					/// </returns>
+					const uint64_t DeferVerdict(
+						http::HttpRequest* request,
+						http::HttpResponse* response,
+						network::OptionalStrand& strand,
+						VerdictContinuation onVerdict,
+						const bool isEnd
+						)
+					{
+						auto self = shared_from_this();
+						auto verdictStrand = &strand;
+
+						return m_deferredVerdicts->Defer(
+							[self, request, response, verdictStrand, onVerdict, isEnd](const uint32_t verdict, std::shared_ptr<const char> blockResponse, const size_t blockResponseLength)
 							{
-								case 0:
+								// Delivered on whatever thread the host pleases, so everything
+								// that touches the transaction happens back on the strand.
+								verdictStrand->post([self, request, response, onVerdict, isEnd, verdict, blockResponse, blockResponseLength]()
 								{
-									// Allow without inspection, but if a response
-									// comes, it is still wanted.
-									request->SetShouldBlock(0);
-									request->SetConsumeAllBeforeSending(false);
+									boost::system::error_code ignored;
+									self->m_verdictTimer.cancel(ignored);
+
+									bool shouldBlock = false;
 
-									if (response)
+									if (isEnd)
+									{
+										shouldBlock = self->ApplyEndVerdict(request, verdict != 0, blockResponse, blockResponseLength);
+									}
+									else
 									{
-										response->SetShouldBlock(0);
-										response->SetConsumeAllBeforeSending(false);
+										shouldBlock = self->ApplyBeginVerdict(request, response, verdict, blockResponse, blockResponseLength);
 									}
 
-									return false;
-								}
-								break;
+									onVerdict(shouldBlock);
+								});
+							}
+						);
+					}
 
-								case 1:
+					/// <summary>
+					/// Completion handler for when the wait for a deferred verdict has timed out.
+					/// Delivers the verdict on behalf of the host, as though the transaction was
+					/// allowed, unless the host beat us to it.
+					/// </summary>
+					/// <param name="error">
+					/// Error code that will indicate if any errors were handled during the async
+					/// operation, providing details if an error did occur and was handled.
+					/// </param>
+					/// <param name="token">
+					/// The token of the verdict being waited for.
+					/// </param>
+					void OnVerdictTimeout(const boost::system::error_code& error, const uint64_t token)
+					{
+						if (error == boost::asio::error::operation_aborted)
+						{
+							// The verdict was delivered.
+							return;
+						}
+
+						if (m_deferredVerdicts->Complete(token, 0, nullptr, 0))
+						{
+							ReportWarning(u8"In TlsCapableHttpBridge::OnVerdictTimeout(const boost::system::error_code&, const uint64_t) - Deferred verdict was not delivered in time. Allowing the transaction.");
+						}
+					}
+
+					/// <summary>
+					/// Applies the verdict of the end callback.
+					/// </summary>
+					/// <param name="request">
+					/// The request.
+					/// </param>
+					/// <param name="shouldBlock">
+					/// Whether the transaction should be blocked.
+					/// </param>
+					/// <param name="blockResponse">
+					/// The custom block response, or nullptr to send a 204 instead.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// The length of the block response.
+					/// </param>
+					/// <returns>
+					/// True if the transaction should be blocked, false otherwise.
+					/// </returns>
+					const bool ApplyEndVerdict(http::HttpRequest* request, const bool shouldBlock, std::shared_ptr<const char> blockResponse, const size_t blockResponseLength)
+					{
+						if (shouldBlock)
+						{
+							if (blockResponse != nullptr)
+							{
+								SetBlockResponse(request, std::move(blockResponse), blockResponseLength);
+								return true;
+							}
+							else
+							{
+								request->Make204();
+							}
+
+							request->SetShouldBlock(1);
+							
+							return true;
+						}
+
+						return false;
+					}
+
+					/// <summary>
+					/// Applies the verdict of the begin callback, which also decides how the rest of
+					/// the transaction is inspected.
+					/// </summary>
+					/// <param name="request">
+					/// The request.
+					/// </param>
+					/// <param name="response">
+					/// The response, if one has been read.
+					/// </param>
+					/// <param name="nextAction">
+					/// What the callback asked for.
+					/// </param>
+					/// <param name="blockResponse">
+					/// The custom block response, or nullptr to send a 204 instead.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// The length of the block response.
+					/// </param>
+					/// <returns>
+					/// True if the transaction should be blocked, false otherwise.
+					/// </returns>
+					const bool ApplyBeginVerdict(http::HttpRequest* request, http::HttpResponse* response, const uint32_t nextAction, std::shared_ptr<const char> blockResponse, const size_t blockResponseLength)
+					{
+						switch (nextAction)
+						{
+							case 0:
+							{
+								// Allow without inspection, but if a response
+								// comes, it is still wanted.
+								request->SetShouldBlock(0);
+								request->SetConsumeAllBeforeSending(false);
+
+								if (response)
 								{
-									// Allow but want to inspect payload.
-									request->SetShouldBlock(0);
-									request->SetConsumeAllBeforeSending(true);
+									response->SetShouldBlock(0);
+									response->SetConsumeAllBeforeSending(false);
+								}
 
-									if (response)
-									{
-										response->SetShouldBlock(0);
-										response->SetConsumeAllBeforeSending(true);
-									}
-									return false;
+								return false;
+							}
+							break;
+
+							case 1:
+							{
+								// Allow but want to inspect payload.
+								request->SetShouldBlock(0);
+								request->SetConsumeAllBeforeSending(true);
+
+								if (response)
+								{
+									response->SetShouldBlock(0);
+									response->SetConsumeAllBeforeSending(true);
 								}
-								break;
+								return false;
+							}
+							break;
+
+							case 2:
+							{
+								// Block.
+								SetBlockResponse(request, std::move(blockResponse), blockResponseLength);
 
-								case 2:
+								request->SetShouldBlock(1);
+
+								if (response)
 								{
-									// Block.
-									if (customBlockResponse.size() > 0)
-									{	
-										request->SetPayload(std::move(customBlockResponse), true);										
-									}
-									else
-									{	
-										request->Make204();
-									}
+									response->SetShouldBlock(1);										
+								}
+								return true;
+							}
+							break;
 
-									request->SetShouldBlock(1);
+							case 3:
+							{
+								// Allow without inspection, for both request and a response.									
+								// Setting to -1 will whitelist the rest of this transaction, 
+								// including the response.
+								request->SetShouldBlock(-1);
+								request->SetConsumeAllBeforeSending(false);
 
-									if (response)
-									{
-										response->SetShouldBlock(1);										
-									}
-									return true;
+								if (response)
+								{
+									response->SetShouldBlock(-1);
+									response->SetConsumeAllBeforeSending(false);
 								}
-								break;
+								return false;
+							}
+							break;
 
-								case 3:
+							case 4:
+							{
+								// Allow, but want to inspect the payload piece by piece as it 
+								// passes through, rather than holding it all back.
+								request->SetShouldBlock(0);
+								request->SetConsumeAllBeforeSending(false);
+								request->SetInspectPayloadChunks(true);
+
+								if (response)
 								{
-									// Allow without inspection, for both request and a response.									
-									// Setting to -1 will whitelist the rest of this transaction, 
-									// including the response.
-									request->SetShouldBlock(-1);
-									request->SetConsumeAllBeforeSending(false);
+									response->SetShouldBlock(0);
+									response->SetConsumeAllBeforeSending(false);
+									response->SetInspectPayloadChunks(true);
+								}
+								return false;
+							}
+							break;
+						}
 
-									if (response)
-									{
-										response->SetShouldBlock(-1);
-										response->SetConsumeAllBeforeSending(false);
-									}
-									return false;
+						return false;
+					}
+
+					/// <summary>
+					/// Gives the request the supplied custom block response, or turns it into a 204
+					/// if there is none. The response is not copied.
+					/// </summary>
+					/// <param name="request">
+					/// The request to be replaced by the block response.
+					/// </param>
+					/// <param name="blockResponse">
+					/// The block response, or nullptr.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// The length of the block response.
+					/// </param>
+					void SetBlockResponse(http::BaseHttpTransaction* request, std::shared_ptr<const char> blockResponse, const size_t blockResponseLength)
+					{
+						if (blockResponse == nullptr || blockResponseLength == 0)
+						{
+							request->Make204();
+							return;
+						}
+
+						request->SetRawMessage(std::move(blockResponse), blockResponseLength);
+					}
+
+					/// <summary>
+					/// Gives the request the custom block response that the callbacks wrote to
+					/// the supplied context, or turns it into a 204 if they didn't write one. The
+					/// response is not copied, whether it was written or handed over.
+					/// </summary>
+					/// <param name="request">
+					/// The request to be replaced by the block response.
+					/// </param>
+					/// <param name="context">
+					/// The context that was supplied to the callbacks.
+					/// </param>
+					void SetBlockResponse(http::BaseHttpTransaction* request, util::cb::TransactionContext& context)
+					{
+						size_t length = 0;
+						auto blockResponse = context.TakeBlockResponse(length);
+
+						SetBlockResponse(request, std::move(blockResponse), length);
+					}
+
+					/// <summary>
+					/// Hands the pieces of payload parsed by the last read of a transaction that was
+					/// flagged for streaming inspection to the chunk callback, before they are
+					/// forwarded. Does nothing for any other transaction.
+					///
+					/// When the callback blocks, the request is given the block response, the same
+					/// as in ::ShouldBlockTransaction(...). It's up to the caller to decide whether
+					/// that response can still be sent.
+					/// </summary>
+					/// <param name="request">
+					/// The request. The transaction inspected when no response is supplied.
+					/// </param>
+					/// <param name="response">
+					/// The response. The transaction inspected if supplied.
+					/// </param>
+					/// <returns>
+					/// True if the transaction should be blocked, false otherwise.
+					/// </returns>
+					const bool ShouldBlockPayloadChunk(http::HttpRequest* request, http::HttpResponse* response = nullptr)
+					{
+						http::BaseHttpTransaction* transaction = request;
+
+						if (response != nullptr)
+						{
+							transaction = response;
+						}
+
+						if (!transaction->GetInspectPayloadChunks() || transaction->GetConsumeAllBeforeSending() || !transaction->HeadersComplete())
+						{
+							return false;
+						}
+
+						if (!m_onMessageChunk)
+						{
+							transaction->SetInspectPayloadChunks(false);
+							return false;
+						}
+
+						const bool payloadComplete = transaction->IsPayloadComplete();
+
+						// When the payload is being decompressed as it comes in, what this read
+						// decompressed is handed over as one piece, instead of the compressed
+						// pieces the parser saw.
+						http::BaseHttpTransaction::PayloadChunkList decodedChunk;
+
+						const char* payload = transaction->GetPayload().data();
+
+						if (transaction->IsPayloadDecoding())
+						{
+							auto decoded = transaction->GetDecodedPayload();
+
+							if (decoded.size() > 0)
+							{
+								decodedChunk.emplace_back(0, decoded.size());
+							}
+
+							payload = decoded.data();
+						}
+
+						const auto& chunks = transaction->IsPayloadDecoding() ? decodedChunk : transaction->GetPayloadChunks();
+
+						if (chunks.size() == 0 && !payloadComplete)
+						{
+							return false;
+						}
+
+						uint32_t nextAction = 0;
+
+						util::cb::TransactionContext context(request, response);
+
+						// One call per piece, so the callback sees exactly what the parser saw. When
+						// the payload ended without any new data, there's still one last call so that
+						// the callback knows it's over.
+						size_t next = 0;
+
+						do
+						{
+							const char* chunk = nullptr;
+							uint32_t chunkLength = 0;
+
+							if (next < chunks.size())
+							{
+								chunk = payload + chunks[next].first;
+								chunkLength = static_cast<uint32_t>(chunks[next].second);
+							}
+
+							++next;
+
+							m_onMessageChunk(
+								&context,
+								chunk, chunkLength, payloadComplete && next >= chunks.size(),
+								&nextAction
+							);
+						} 
+						while (nextAction == 0 && next < chunks.size());
+
+						switch (nextAction)
+						{
+							case 1:
+							{
+								// Pass the rest without asking.
+								transaction->SetInspectPayloadChunks(false);
+								return false;
+							}
+							break;
+
+							case 2:
+							{
+								// Block.
+								transaction->SetInspectPayloadChunks(false);
+
+								SetBlockResponse(request, context);
+
+								request->SetShouldBlock(1);
+
+								if (response)
+								{
+									response->SetShouldBlock(1);
 								}
-								break;
+								return true;
 							}
+							break;
 						}
 
 						return false;
@@ -0,0 +1,226 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "TlsSessionCache.hpp"
+
+#include <ctime>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace secure
+			{
+
+				TlsSessionCache::TlsSessionCache(const size_t maxClientSessions)
+					:
+					m_maxClientSessions(maxClientSessions > 0 ? maxClientSessions : 1)
+				{
+					m_serverHandshakes = 0;
+					m_serverResumptions = 0;
+					m_clientHandshakes = 0;
+					m_clientResumptions = 0;
+				}
+
+				TlsSessionCache::~TlsSessionCache()
+				{
+					std::lock_guard<std::mutex> lock(m_sessionsMutex);
+
+					for (auto& entry : m_sessions)
+					{
+						SSL_SESSION_free(entry.second);
+					}
+
+					m_sessions.clear();
+				}
+
+				bool TlsSessionCache::ConfigureServerContext(SSL_CTX* defaultServerContext)
+				{
+					if (defaultServerContext == nullptr)
+					{
+						return false;
+					}
+
+					// Tickets are on by default, so long as SSL_OP_NO_TICKET is never set. Clients
+					// that don't do tickets get the session ID cache.
+					SSL_CTX_set_session_cache_mode(defaultServerContext, SSL_SESS_CACHE_SERVER);
+					SSL_CTX_set_timeout(defaultServerContext, ServerSessionTimeout);
+
+					// This is replaced by the spoofed context's own ID context when the stream is
+					// switched over. It only needs to be set so that there is something to replace.
+					static const unsigned char defaultSessionIdContext[] = u8"HttpFilteringEngine";
+
+					return SSL_CTX_set_session_id_context(defaultServerContext, defaultSessionIdContext, sizeof(defaultSessionIdContext) - 1) == 1;
+				}
+
+				bool TlsSessionCache::OfferClientSession(SSL* ssl, const std::string& host, const uint16_t port)
+				{
+					if (ssl == nullptr || host.size() == 0)
+					{
+						return false;
+					}
+
+					std::lock_guard<std::mutex> lock(m_sessionsMutex);
+
+					auto it = m_sessions.find(MakeKey(host, port));
+					if (it == m_sessions.end())
+					{
+						return false;
+					}
+
+					if (IsExpired(it->second, static_cast<long>(std::time(nullptr))))
+					{
+						SSL_SESSION_free(it->second);
+						m_sessions.erase(it);
+						return false;
+					}
+
+					// Takes its own reference, so the session outlives us dropping it.
+					return SSL_set_session(ssl, it->second) == 1;
+				}
+
+				void TlsSessionCache::StoreClientSession(SSL* ssl, const std::string& host, const uint16_t port)
+				{
+					if (ssl == nullptr || host.size() == 0)
+					{
+						return;
+					}
+
+					SSL_SESSION* session = SSL_get1_session(ssl);
+
+					if (session == nullptr)
+					{
+						return;
+					}
+
+					std::lock_guard<std::mutex> lock(m_sessionsMutex);
+
+					auto key = MakeKey(host, port);
+
+					auto it = m_sessions.find(key);
+					if (it != m_sessions.end())
+					{
+						// On a resumed handshake this is the very session we offered.
+						SSL_SESSION_free(it->second);
+						it->second = session;
+						return;
+					}
+
+					if (m_sessions.size() >= m_maxClientSessions)
+					{
+						SweepExpired();
+
+						if (m_sessions.size() >= m_maxClientSessions)
+						{
+							// Nothing has expired. Dropping an arbitrary entry costs that host one
+							// full handshake, which isn't worth tracking recency for.
+							auto victim = m_sessions.begin();
+							SSL_SESSION_free(victim->second);
+							m_sessions.erase(victim);
+						}
+					}
+
+					m_sessions.emplace(std::move(key), session);
+				}
+
+				void TlsSessionCache::RemoveClientSession(const std::string& host, const uint16_t port)
+				{
+					std::lock_guard<std::mutex> lock(m_sessionsMutex);
+
+					auto it = m_sessions.find(MakeKey(host, port));
+					if (it != m_sessions.end())
+					{
+						SSL_SESSION_free(it->second);
+						m_sessions.erase(it);
+					}
+				}
+
+				void TlsSessionCache::RecordServerHandshake(const bool resumed)
+				{
+					++m_serverHandshakes;
+
+					if (resumed)
+					{
+						++m_serverResumptions;
+					}
+				}
+
+				void TlsSessionCache::RecordClientHandshake(const bool resumed)
+				{
+					++m_clientHandshakes;
+
+					if (resumed)
+					{
+						++m_clientResumptions;
+					}
+				}
+
+				TlsSessionStats TlsSessionCache::GetStats() const
+				{
+					TlsSessionStats stats;
+
+					stats.ServerHandshakes = m_serverHandshakes;
+					stats.ServerResumptions = m_serverResumptions;
+					stats.ClientHandshakes = m_clientHandshakes;
+					stats.ClientResumptions = m_clientResumptions;
+
+					if (stats.ServerHandshakes > 0)
+					{
+						stats.ServerResumptionRate = static_cast<double>(stats.ServerResumptions) / static_cast<double>(stats.ServerHandshakes);
+					}
+
+					if (stats.ClientHandshakes > 0)
+					{
+						stats.ClientResumptionRate = static_cast<double>(stats.ClientResumptions) / static_cast<double>(stats.ClientHandshakes);
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_sessionsMutex);
+						stats.ClientSessionsCached = static_cast<uint32_t>(m_sessions.size());
+					}
+
+					return stats;
+				}
+
+				std::string TlsSessionCache::MakeKey(const std::string& host, const uint16_t port)
+				{
+					std::string key(host);
+					key.append(u8":").append(std::to_string(port));
+					return key;
+				}
+
+				bool TlsSessionCache::IsExpired(const SSL_SESSION* session, const long now)
+				{
+					// The getters aren't const correct in every OpenSSL version we build against.
+					SSL_SESSION* s = const_cast<SSL_SESSION*>(session);
+					return (SSL_SESSION_get_time(s) + SSL_SESSION_get_timeout(s)) <= now;
+				}
+
+				void TlsSessionCache::SweepExpired()
+				{
+					const long now = static_cast<long>(std::time(nullptr));
+
+					for (auto it = m_sessions.begin(); it != m_sessions.end();)
+					{
+						if (IsExpired(it->second, now))
+						{
+							SSL_SESSION_free(it->second);
+							it = m_sessions.erase(it);
+						}
+						else
+						{
+							++it;
+						}
+					}
+				}
+
+			} /* namespace secure */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
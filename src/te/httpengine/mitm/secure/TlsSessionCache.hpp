@@ -0,0 +1,251 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <openssl/ssl.h>
+#include "../../util/hash/StringHashUtils.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace secure
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the TLS handshake counters for both legs of the
+				/// bridged connections. The server leg is the handshake with the downstream
+				/// client, served with a spoofed context. The client leg is the handshake with
+				/// the upstream server.
+				/// </summary>
+				struct TlsSessionStats
+				{
+					/// <summary>
+					/// Total number of completed downstream handshakes.
+					/// </summary>
+					uint64_t ServerHandshakes = 0;
+
+					/// <summary>
+					/// Total number of completed downstream handshakes that resumed a previous
+					/// session, by either session ID or session ticket.
+					/// </summary>
+					uint64_t ServerResumptions = 0;
+
+					/// <summary>
+					/// ServerResumptions divided by ServerHandshakes. Zero if there have been no
+					/// handshakes.
+					/// </summary>
+					double ServerResumptionRate = 0.0;
+
+					/// <summary>
+					/// Total number of completed upstream handshakes.
+					/// </summary>
+					uint64_t ClientHandshakes = 0;
+
+					/// <summary>
+					/// Total number of completed upstream handshakes that resumed a cached
+					/// session.
+					/// </summary>
+					uint64_t ClientResumptions = 0;
+
+					/// <summary>
+					/// ClientResumptions divided by ClientHandshakes. Zero if there have been no
+					/// handshakes.
+					/// </summary>
+					double ClientResumptionRate = 0.0;
+
+					/// <summary>
+					/// The number of upstream sessions presently cached.
+					/// </summary>
+					uint32_t ClientSessionsCached = 0;
+				};
+
+				/// <summary>
+				/// The TlsSessionCache holds upstream TLS sessions, keyed by host and port, so
+				/// that a new bridge to a host we've recently spoken to can offer the previous
+				/// session and skip the full handshake. It also keeps the resumption counters
+				/// for both legs.
+				///
+				/// Resumption on the downstream leg is handled by OpenSSL itself. Every
+				/// downstream stream is created from the acceptor's default server context and
+				/// only switched to a spoofed context once the upstream certificate is known.
+				/// OpenSSL keeps the session cache and ticket keys of the context the stream was
+				/// created with, so a single cache on the default context serves every spoofed
+				/// host. Each spoofed context carries its own session ID context, which is what
+				/// keeps a session established for one host from being resumed for another.
+				/// </summary>
+				class TlsSessionCache
+				{
+
+				public:
+
+					/// <summary>
+					/// Default number of upstream sessions to keep.
+					/// </summary>
+					static constexpr size_t DefaultMaxClientSessions = 4096;
+
+					/// <summary>
+					/// Lifetime given to sessions issued to downstream clients, in seconds.
+					/// Browsers generally won't try to resume anything older than this anyway.
+					/// </summary>
+					static constexpr long ServerSessionTimeout = 7200;
+
+					/// <summary>
+					/// Constructs a new, empty TlsSessionCache.
+					/// </summary>
+					/// <param name="maxClientSessions">
+					/// The maximum number of upstream sessions to keep.
+					/// </param>
+					TlsSessionCache(const size_t maxClientSessions = DefaultMaxClientSessions);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					TlsSessionCache(const TlsSessionCache&) = delete;
+					TlsSessionCache(TlsSessionCache&&) = delete;
+					TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+					/// <summary>
+					/// Default destructor. Frees all held sessions.
+					/// </summary>
+					~TlsSessionCache();
+
+					/// <summary>
+					/// Enables server side session caching and tickets on the supplied context,
+					/// which must be the context downstream streams are constructed with.
+					/// </summary>
+					/// <param name="defaultServerContext">
+					/// The default server context.
+					/// </param>
+					/// <returns>
+					/// True if the context was configured, false otherwise.
+					/// </returns>
+					static bool ConfigureServerContext(SSL_CTX* defaultServerContext);
+
+					/// <summary>
+					/// If a session for the supplied host and port is cached and has not expired,
+					/// sets it on the supplied stream so that it is offered in the client hello.
+					/// Must be called before the handshake is initiated.
+					/// </summary>
+					/// <param name="ssl">
+					/// The upstream stream.
+					/// </param>
+					/// <param name="host">
+					/// The upstream host name.
+					/// </param>
+					/// <param name="port">
+					/// The upstream port.
+					/// </param>
+					/// <returns>
+					/// True if a session was set on the stream, false otherwise.
+					/// </returns>
+					bool OfferClientSession(SSL* ssl, const std::string& host, const uint16_t port);
+
+					/// <summary>
+					/// Stores the session negotiated on the supplied stream for the supplied host
+					/// and port, replacing any existing session. Must be called after a
+					/// successful handshake.
+					/// </summary>
+					/// <param name="ssl">
+					/// The upstream stream.
+					/// </param>
+					/// <param name="host">
+					/// The upstream host name.
+					/// </param>
+					/// <param name="port">
+					/// The upstream port.
+					/// </param>
+					void StoreClientSession(SSL* ssl, const std::string& host, const uint16_t port);
+
+					/// <summary>
+					/// Drops any session cached for the supplied host and port. Should be called
+					/// when a handshake fails, so that a session the server no longer likes isn't
+					/// offered again.
+					/// </summary>
+					/// <param name="host">
+					/// The upstream host name.
+					/// </param>
+					/// <param name="port">
+					/// The upstream port.
+					/// </param>
+					void RemoveClientSession(const std::string& host, const uint16_t port);
+
+					/// <summary>
+					/// Records a completed downstream handshake.
+					/// </summary>
+					/// <param name="resumed">
+					/// Whether or not the handshake resumed a previous session.
+					/// </param>
+					void RecordServerHandshake(const bool resumed);
+
+					/// <summary>
+					/// Records a completed upstream handshake.
+					/// </summary>
+					/// <param name="resumed">
+					/// Whether or not the handshake resumed a previous session.
+					/// </param>
+					void RecordClientHandshake(const bool resumed);
+
+					/// <summary>
+					/// Gets a snapshot of the handshake counters.
+					/// </summary>
+					/// <returns>
+					/// The current handshake counters.
+					/// </returns>
+					TlsSessionStats GetStats() const;
+
+				private:
+
+					/// <summary>
+					/// Builds the cache key from the supplied host and port.
+					/// </summary>
+					static std::string MakeKey(const std::string& host, const uint16_t port);
+
+					/// <summary>
+					/// Determines if the supplied session has outlived its timeout.
+					/// </summary>
+					static bool IsExpired(const SSL_SESSION* session, const long now);
+
+					/// <summary>
+					/// Frees every expired session. Caller must hold m_sessionsMutex.
+					/// </summary>
+					void SweepExpired();
+
+					const size_t m_maxClientSessions;
+
+					/// <summary>
+					/// Guards m_sessions.
+					/// </summary>
+					mutable std::mutex m_sessionsMutex;
+
+					/// <summary>
+					/// Cached upstream sessions. We hold one reference to each.
+					/// </summary>
+					std::unordered_map<std::string, SSL_SESSION*, util::hash::ICaseStringHash, util::hash::ICaseStringEquality> m_sessions;
+
+					std::atomic_uint64_t m_serverHandshakes;
+
+					std::atomic_uint64_t m_serverResumptions;
+
+					std::atomic_uint64_t m_clientHandshakes;
+
+					std::atomic_uint64_t m_clientResumptions;
+
+				};
+
+			} /* namespace secure */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,541 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include "../../network/SocketTypes.hpp"
+#include "../../util/hash/StringHashUtils.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace secure
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the counters kept by an upstream connection pool.
+				/// </summary>
+				struct UpstreamPoolStats
+				{
+					/// <summary>
+					/// Total number of times a bridge picked up an idle upstream connection
+					/// instead of resolving and connecting, and for TLS, handshaking.
+					/// </summary>
+					uint64_t Reused = 0;
+
+					/// <summary>
+					/// Total number of times a bridge asked for an upstream connection and none
+					/// was available.
+					/// </summary>
+					uint64_t Misses = 0;
+
+					/// <summary>
+					/// Total number of connections handed back to the pool after a completed
+					/// keep-alive transaction.
+					/// </summary>
+					uint64_t Released = 0;
+
+					/// <summary>
+					/// Total number of idle connections that were closed instead of reused,
+					/// because they expired, were closed by the server, or the pool was full.
+					/// </summary>
+					uint64_t Discarded = 0;
+
+					/// <summary>
+					/// The number of idle connections presently held.
+					/// </summary>
+					uint32_t Idle = 0;
+				};
+
+				/// <summary>
+				/// The UpstreamConnectionPool holds idle keep-alive connections to upstream
+				/// servers, keyed by host, port and the address they are connected to, so that they
+				/// can be handed to the next bridge that needs a connection to the same origin. Browsers open several parallel
+				/// connections to the same origin and close and reopen them constantly, and
+				/// without this, each one pays for its own resolve, connect and, for TLS,
+				/// handshake, even if another bridge just finished with a perfectly good
+				/// connection to the same place.
+				///
+				/// One pool is owned by each acceptor, so the TLS parameters are implied by the
+				/// pool itself. Every TLS stream in a pool was created from the same client
+				/// context and verified against the host it is keyed by.
+				///
+				/// The address is part of the key because a bridge connects to whatever address the
+				/// client originally connected to, while the host is only ever what the client
+				/// claims. Without it, a plain HTTP connection that some local process opened to an
+				/// address of its choosing, claiming to be for another host, would be handed to the
+				/// next bridge that wants that host, from any process. TLS connections are verified
+				/// against their host, but are keyed the same way, since a bridge should end up at
+				/// the server its client chose either way.
+				///
+				/// Connections are also keyed by the io_service that drives them, since a socket
+				/// must only ever be used by the threads of its own io_service. When every bridge
+				/// shares one io_service, that's the same for every connection.
+				///
+				/// Only connections with no pending operations may ever be released to the pool.
+				/// There are no timers here. Expired connections are swept out whenever the pool
+				/// is used, and anything the server closed while idle is detected and discarded
+				/// when it is acquired.
+				/// </summary>
+				template<class SocketType>
+				class UpstreamConnectionPool
+				{
+
+					/// <summary>
+					/// Enforce use of this class to the only two types of sockets it is intended to be
+					/// used with.
+					/// </summary>
+					static_assert((std::is_same<SocketType, network::TcpSocket> ::value || std::is_same<SocketType, network::TlsSocket>::value), "UpstreamConnectionPool can only accept boost::asio::ip::tcp::socket or boost::asio::ssl::stream<boost::asio::ip::tcp::socket> as valid template parameters.");
+
+				public:
+
+					using SharedSocket = std::shared_ptr<SocketType>;
+
+					/// <summary>
+					/// Default number of idle connections kept per host. Matches the parallel
+					/// connection limit browsers use per host.
+					/// </summary>
+					static constexpr size_t DefaultMaxIdlePerHost = 6;
+
+					/// <summary>
+					/// Default number of idle connections kept in total.
+					/// </summary>
+					static constexpr size_t DefaultMaxIdle = 256;
+
+					/// <summary>
+					/// Default number of seconds a connection may sit idle before it is closed.
+					/// Kept below the keep-alive timeout of most servers, so that we rarely pick up
+					/// one the server is just about to close.
+					/// </summary>
+					static constexpr uint32_t DefaultIdleTimeoutSeconds = 30;
+
+					/// <summary>
+					/// Constructs a new, empty UpstreamConnectionPool.
+					/// </summary>
+					UpstreamConnectionPool()
+					{
+						m_reused = 0;
+						m_misses = 0;
+						m_released = 0;
+						m_discarded = 0;
+					}
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					UpstreamConnectionPool(const UpstreamConnectionPool&) = delete;
+					UpstreamConnectionPool(UpstreamConnectionPool&&) = delete;
+					UpstreamConnectionPool& operator=(const UpstreamConnectionPool&) = delete;
+
+					/// <summary>
+					/// Default destructor. Closes all idle connections.
+					/// </summary>
+					~UpstreamConnectionPool()
+					{
+						std::lock_guard<std::mutex> lock(m_idleMutex);
+
+						for (auto& host : m_idle)
+						{
+							for (auto& connection : host.second)
+							{
+								Close(*connection.socket);
+							}
+						}
+
+						m_idle.clear();
+						m_idleCount = 0;
+					}
+
+					/// <summary>
+					/// Takes an idle connection to the supplied host and port, at the supplied
+					/// address, out of the pool, if there is a live one.
+					/// </summary>
+					/// <param name="host">
+					/// The upstream host name.
+					/// </param>
+					/// <param name="port">
+					/// The upstream port.
+					/// </param>
+					/// <param name="address">
+					/// The address the bridge would connect to if it had to. If it doesn't know
+					/// yet, which leaves this unspecified, nothing is handed out.
+					/// </param>
+					/// <param name="service">
+					/// The io_service driving the bridge that is to use the connection. Only
+					/// connections driven by the same io_service are handed out.
+					/// </param>
+					/// <returns>
+					/// A connected socket, ready for the next request, or nullptr if the
+					/// pool has no live connection to the supplied host, port and address.
+					/// </returns>
+					SharedSocket Acquire(const std::string& host, const uint16_t port, const boost::asio::ip::address& address, boost::asio::io_service& service)
+					{
+						if (address.is_unspecified())
+						{
+							++m_misses;
+							return nullptr;
+						}
+
+						const std::string key = MakeKey(host, port, address, service);
+
+						std::lock_guard<std::mutex> lock(m_idleMutex);
+
+						SweepExpired();
+
+						auto it = m_idle.find(key);
+						if (it != m_idle.end())
+						{
+							auto& connections = it->second;
+
+							// Most recently released first. That's the one least likely to have been
+							// closed by the server.
+							while (!connections.empty())
+							{
+								SharedSocket socket = std::move(connections.back().socket);
+								connections.pop_back();
+								--m_idleCount;
+
+								if (IsUsable(*socket))
+								{
+									if (connections.empty())
+									{
+										m_idle.erase(it);
+									}
+
+									++m_reused;
+									return socket;
+								}
+
+								Close(*socket);
+								++m_discarded;
+							}
+
+							m_idle.erase(it);
+						}
+
+						++m_misses;
+						return nullptr;
+					}
+
+					/// <summary>
+					/// Hands an idle connection to the pool. The connection must have no pending
+					/// operations, and the last transaction on it must have completed cleanly
+					/// with keep-alive. The connection is kept under the address it is connected
+					/// to. If the pool is full for the host, or in total, or that address can't be
+					/// had, the connection is closed instead.
+					/// </summary>
+					/// <param name="host">
+					/// The upstream host name the connection was made to.
+					/// </param>
+					/// <param name="port">
+					/// The upstream port the connection was made to.
+					/// </param>
+					/// <param name="socket">
+					/// The connection.
+					/// </param>
+					/// <returns>
+					/// True if the pool kept the connection, false if it was closed.
+					/// </returns>
+					bool Release(const std::string& host, const uint16_t port, SharedSocket socket)
+					{
+						if (socket == nullptr || host.size() == 0)
+						{
+							return false;
+						}
+
+						if (!socket->lowest_layer().is_open())
+						{
+							return false;
+						}
+
+						boost::system::error_code endpointErr;
+						const auto remote = socket->lowest_layer().remote_endpoint(endpointErr);
+
+						if (endpointErr)
+						{
+							Close(*socket);
+							++m_discarded;
+							return false;
+						}
+
+						PrepareForIdle(*socket);
+
+						const std::string key = MakeKey(host, port, remote.address(), socket->lowest_layer().get_io_service());
+
+						std::lock_guard<std::mutex> lock(m_idleMutex);
+
+						SweepExpired();
+
+						if (m_maxIdlePerHost == 0 || m_maxIdle == 0)
+						{
+							Close(*socket);
+							++m_discarded;
+							return false;
+						}
+
+						auto& connections = m_idle[key];
+
+						if (connections.size() >= m_maxIdlePerHost || m_idleCount >= m_maxIdle)
+						{
+							if (connections.empty())
+							{
+								// Full in total, and this host has nothing to give up. Don't leave
+								// the empty entry behind.
+								m_idle.erase(key);
+								Close(*socket);
+								++m_discarded;
+								return false;
+							}
+
+							// Give up this host's oldest idle connection for the new one.
+							Close(*connections.front().socket);
+							connections.pop_front();
+							--m_idleCount;
+							++m_discarded;
+						}
+
+						IdleConnection connection;
+						connection.socket = std::move(socket);
+						connection.idleSince = std::chrono::steady_clock::now();
+						connections.push_back(std::move(connection));
+						++m_idleCount;
+
+						++m_released;
+						return true;
+					}
+
+					/// <summary>
+					/// Sets the pool limits. Can be called at any time. Connections beyond the
+					/// new limits are closed as they are released, or as they expire.
+					/// </summary>
+					/// <param name="maxIdlePerHost">
+					/// The maximum number of idle connections kept per host. Zero disables
+					/// pooling.
+					/// </param>
+					/// <param name="maxIdle">
+					/// The maximum number of idle connections kept in total. Zero disables
+					/// pooling.
+					/// </param>
+					/// <param name="idleTimeoutSeconds">
+					/// The number of seconds an idle connection is kept.
+					/// </param>
+					void SetLimits(const size_t maxIdlePerHost, const size_t maxIdle, const uint32_t idleTimeoutSeconds)
+					{
+						std::lock_guard<std::mutex> lock(m_idleMutex);
+
+						m_maxIdlePerHost = maxIdlePerHost;
+						m_maxIdle = maxIdle;
+						m_idleTimeout = std::chrono::seconds(idleTimeoutSeconds);
+
+						SweepExpired();
+					}
+
+					/// <summary>
+					/// Gets a snapshot of the pool counters.
+					/// </summary>
+					/// <returns>
+					/// The current pool counters.
+					/// </returns>
+					UpstreamPoolStats GetStats() const
+					{
+						UpstreamPoolStats stats;
+
+						stats.Reused = m_reused;
+						stats.Misses = m_misses;
+						stats.Released = m_released;
+						stats.Discarded = m_discarded;
+
+						std::lock_guard<std::mutex> lock(m_idleMutex);
+						stats.Idle = static_cast<uint32_t>(m_idleCount);
+
+						return stats;
+					}
+
+				private:
+
+					/// <summary>
+					/// An idle connection and the time it was released.
+					/// </summary>
+					struct IdleConnection
+					{
+						SharedSocket socket;
+						std::chrono::steady_clock::time_point idleSince;
+					};
+
+					/// <summary>
+					/// Builds the pool key from the supplied host, port, address and io_service.
+					/// </summary>
+					static std::string MakeKey(const std::string& host, const uint16_t port, const boost::asio::ip::address& address, const boost::asio::io_service& service)
+					{
+						std::string key(host);
+						key.append(u8":").append(std::to_string(port));
+						key.append(u8"/").append(address.to_string());
+						key.append(u8"@").append(std::to_string(reinterpret_cast<uintptr_t>(&service)));
+						return key;
+					}
+
+					/// <summary>
+					/// Determines if the supplied idle connection can still carry a request. An
+					/// idle connection must be open and quiet. If the server sent anything while
+					/// we weren't looking, be that a FIN, a TLS close notify, or junk, the
+					/// connection is not safe to send a new request on.
+					/// </summary>
+					static bool IsUsable(SocketType& socket)
+					{
+						// The lowest layer is a basic_socket, which can't receive, so go through the
+						// stream socket itself.
+						network::TcpSocket& lowest = Transport(socket);
+
+						if (!lowest.is_open() || HasBufferedData(socket))
+						{
+							return false;
+						}
+
+						boost::system::error_code ec;
+						lowest.non_blocking(true, ec);
+
+						if (ec)
+						{
+							return false;
+						}
+
+						char probe;
+						lowest.receive(boost::asio::buffer(&probe, 1), boost::asio::socket_base::message_peek, ec);
+
+						boost::system::error_code restoreEc;
+						lowest.non_blocking(false, restoreEc);
+
+						return ec == boost::asio::error::would_block && !restoreEc;
+					}
+
+					/// <summary>
+					/// Gets the underlying TCP stream of the supplied socket.
+					/// </summary>
+					static network::TcpSocket& Transport(network::TcpSocket& socket)
+					{
+						return socket;
+					}
+
+					static network::TcpSocket& Transport(network::TlsSocket& socket)
+					{
+						return socket.next_layer();
+					}
+
+					/// <summary>
+					/// Determines if the TLS layer has already decrypted data that no one has
+					/// read. Plain sockets have no such layer.
+					/// </summary>
+					static bool HasBufferedData(network::TcpSocket& socket)
+					{
+						return false;
+					}
+
+					static bool HasBufferedData(network::TlsSocket& socket)
+					{
+						return SSL_pending(socket.native_handle()) > 0;
+					}
+
+					/// <summary>
+					/// Readies a connection for sitting in the pool. The verification callback
+					/// set on a TLS stream is bound to the bridge that created it, and would keep
+					/// that bridge alive for as long as the connection sits here. The connection
+					/// was verified long ago, and there is no renegotiation to verify, so the
+					/// callback is replaced with one that refuses everything.
+					/// </summary>
+					static void PrepareForIdle(network::TcpSocket& socket)
+					{
+					}
+
+					static void PrepareForIdle(network::TlsSocket& socket)
+					{
+						boost::system::error_code ec;
+						socket.set_verify_callback([](bool, boost::asio::ssl::verify_context&) { return false; }, ec);
+					}
+
+					/// <summary>
+					/// Closes the supplied connection, ignoring any errors.
+					/// </summary>
+					static void Close(SocketType& socket)
+					{
+						boost::system::error_code ec;
+						socket.lowest_layer().shutdown(boost::asio::socket_base::shutdown_both, ec);
+						socket.lowest_layer().close(ec);
+					}
+
+					/// <summary>
+					/// Closes every connection that has been idle for longer than the idle
+					/// timeout. Caller must hold m_idleMutex.
+					/// </summary>
+					void SweepExpired()
+					{
+						const auto expiredBefore = std::chrono::steady_clock::now() - m_idleTimeout;
+
+						for (auto host = m_idle.begin(); host != m_idle.end();)
+						{
+							auto& connections = host->second;
+
+							// Released in order, so the oldest are always at the front.
+							while (!connections.empty() && connections.front().idleSince <= expiredBefore)
+							{
+								Close(*connections.front().socket);
+								connections.pop_front();
+								--m_idleCount;
+								++m_discarded;
+							}
+
+							if (connections.empty())
+							{
+								host = m_idle.erase(host);
+							}
+							else
+							{
+								++host;
+							}
+						}
+					}
+
+					/// <summary>
+					/// Guards m_idle, m_idleCount and the limits.
+					/// </summary>
+					mutable std::mutex m_idleMutex;
+
+					std::unordered_map<std::string, std::deque<IdleConnection>, util::hash::ICaseStringHash, util::hash::ICaseStringEquality> m_idle;
+
+					size_t m_idleCount = 0;
+
+					size_t m_maxIdlePerHost = DefaultMaxIdlePerHost;
+
+					size_t m_maxIdle = DefaultMaxIdle;
+
+					std::chrono::steady_clock::duration m_idleTimeout = std::chrono::seconds(DefaultIdleTimeoutSeconds);
+
+					std::atomic_uint64_t m_reused;
+
+					std::atomic_uint64_t m_misses;
+
+					std::atomic_uint64_t m_released;
+
+					std::atomic_uint64_t m_discarded;
+
+				};
+
+			} /* namespace secure */
+		} /* namespace mitm */
+	} /* namespace httpengine */
+} /* namespace te */
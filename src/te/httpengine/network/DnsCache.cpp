@@ -0,0 +1,127 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "DnsCache.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			DnsCache::DnsCache(const size_t maxEntries, const uint32_t ttlSeconds)
+				:
+				m_maxEntries(maxEntries > 0 ? maxEntries : 1),
+				m_ttl(std::chrono::seconds(ttlSeconds))
+			{
+				m_hits = 0;
+				m_misses = 0;
+			}
+
+			DnsCache::~DnsCache()
+			{
+
+			}
+
+			bool DnsCache::Lookup(const std::string& host, boost::asio::ip::address& address)
+			{
+				if (host.size() > 0)
+				{
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+					auto it = m_entries.find(host);
+					if (it != m_entries.end())
+					{
+						if (it->second.expires > std::chrono::steady_clock::now())
+						{
+							address = it->second.address;
+							++m_hits;
+							return true;
+						}
+
+						m_entries.erase(it);
+					}
+				}
+
+				++m_misses;
+				return false;
+			}
+
+			void DnsCache::Store(const std::string& host, const boost::asio::ip::address& address)
+			{
+				if (host.size() == 0 || address.is_unspecified())
+				{
+					return;
+				}
+
+				const auto now = std::chrono::steady_clock::now();
+
+				std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+				auto it = m_entries.find(host);
+				if (it != m_entries.end())
+				{
+					it->second.address = address;
+					it->second.expires = now + m_ttl;
+					return;
+				}
+
+				if (m_entries.size() >= m_maxEntries)
+				{
+					SweepExpired(now);
+
+					if (m_entries.size() >= m_maxEntries)
+					{
+						// Nothing has expired. Dropping an arbitrary entry costs that host one
+						// resolve, which isn't worth tracking recency for.
+						m_entries.erase(m_entries.begin());
+					}
+				}
+
+				m_entries.emplace(host, Entry{ address, now + m_ttl });
+			}
+
+			void DnsCache::Remove(const std::string& host)
+			{
+				std::lock_guard<std::mutex> lock(m_entriesMutex);
+				m_entries.erase(host);
+			}
+
+			DnsCacheStats DnsCache::GetStats() const
+			{
+				DnsCacheStats stats;
+
+				stats.Hits = m_hits;
+				stats.Misses = m_misses;
+
+				{
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+					stats.Entries = static_cast<uint32_t>(m_entries.size());
+				}
+
+				return stats;
+			}
+
+			void DnsCache::SweepExpired(const std::chrono::steady_clock::time_point now)
+			{
+				for (auto it = m_entries.begin(); it != m_entries.end();)
+				{
+					if (it->second.expires <= now)
+					{
+						it = m_entries.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,169 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/asio.hpp>
+#include "../util/hash/StringHashUtils.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			/// <summary>
+			/// Point in time snapshot of the DNS cache counters.
+			/// </summary>
+			struct DnsCacheStats
+			{
+				/// <summary>
+				/// Total number of lookups answered from the cache.
+				/// </summary>
+				uint64_t Hits = 0;
+
+				/// <summary>
+				/// Total number of lookups that had to go to the resolver.
+				/// </summary>
+				uint64_t Misses = 0;
+
+				/// <summary>
+				/// The number of hosts presently cached.
+				/// </summary>
+				uint32_t Entries = 0;
+			};
+
+			/// <summary>
+			/// The DnsCache holds the address that a recent resolve returned for each host, so
+			/// that bridges which can't connect straight to the original destination of their
+			/// client don't each pay for a full resolve of the same host. It is shared by every
+			/// bridge, regardless of protocol, and is safe to use from any thread.
+			///
+			/// The resolver doesn't tell us the TTL of the records it returns, so every entry
+			/// is given the same, deliberately short, lifetime.
+			/// </summary>
+			class DnsCache
+			{
+
+			public:
+
+				/// <summary>
+				/// Default number of hosts to keep.
+				/// </summary>
+				static constexpr size_t DefaultMaxEntries = 1024;
+
+				/// <summary>
+				/// Default number of seconds an entry is kept.
+				/// </summary>
+				static constexpr uint32_t DefaultTtlSeconds = 60;
+
+				/// <summary>
+				/// Constructs a new, empty DnsCache.
+				/// </summary>
+				/// <param name="maxEntries">
+				/// The maximum number of hosts to keep.
+				/// </param>
+				/// <param name="ttlSeconds">
+				/// The number of seconds each entry is kept.
+				/// </param>
+				DnsCache(const size_t maxEntries = DefaultMaxEntries, const uint32_t ttlSeconds = DefaultTtlSeconds);
+
+				/// <summary>
+				/// No copy no move no thx.
+				/// </summary>
+				DnsCache(const DnsCache&) = delete;
+				DnsCache(DnsCache&&) = delete;
+				DnsCache& operator=(const DnsCache&) = delete;
+
+				/// <summary>
+				/// Default destructor.
+				/// </summary>
+				~DnsCache();
+
+				/// <summary>
+				/// Looks up the cached address for the supplied host.
+				/// </summary>
+				/// <param name="host">
+				/// The host name.
+				/// </param>
+				/// <param name="address">
+				/// Receives the cached address, if any.
+				/// </param>
+				/// <returns>
+				/// True if an unexpired address was found, false otherwise.
+				/// </returns>
+				bool Lookup(const std::string& host, boost::asio::ip::address& address);
+
+				/// <summary>
+				/// Stores the supplied address for the supplied host, replacing any existing
+				/// entry and restarting its lifetime.
+				/// </summary>
+				/// <param name="host">
+				/// The host name.
+				/// </param>
+				/// <param name="address">
+				/// The address the host resolved to.
+				/// </param>
+				void Store(const std::string& host, const boost::asio::ip::address& address);
+
+				/// <summary>
+				/// Drops any entry for the supplied host. Should be called when connecting to the
+				/// cached address fails, so that the next connection resolves again.
+				/// </summary>
+				/// <param name="host">
+				/// The host name.
+				/// </param>
+				void Remove(const std::string& host);
+
+				/// <summary>
+				/// Gets a snapshot of the cache counters.
+				/// </summary>
+				/// <returns>
+				/// The current cache counters.
+				/// </returns>
+				DnsCacheStats GetStats() const;
+
+			private:
+
+				struct Entry
+				{
+					boost::asio::ip::address address;
+					std::chrono::steady_clock::time_point expires;
+				};
+
+				/// <summary>
+				/// Drops every expired entry. Caller must hold m_entriesMutex.
+				/// </summary>
+				void SweepExpired(const std::chrono::steady_clock::time_point now);
+
+				const size_t m_maxEntries;
+
+				const std::chrono::steady_clock::duration m_ttl;
+
+				/// <summary>
+				/// Guards m_entries.
+				/// </summary>
+				mutable std::mutex m_entriesMutex;
+
+				std::unordered_map<std::string, Entry, util::hash::ICaseStringHash, util::hash::ICaseStringEquality> m_entries;
+
+				std::atomic_uint64_t m_hits;
+
+				std::atomic_uint64_t m_misses;
+
+			};
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,222 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <boost/asio.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			/// <summary>
+			/// The handler returned by OptionalStrand::wrap(...). Dispatches the wrapped handler
+			/// through the strand when there is one, otherwise invokes it directly.
+			/// </summary>
+			template<typename Handler>
+			class OptionalStrandHandler
+			{
+
+			public:
+
+				OptionalStrandHandler(boost::asio::strand* strand, Handler handler)
+					:
+					m_strand(strand),
+					m_handler(std::move(handler))
+				{
+
+				}
+
+				template<typename... Args>
+				void operator()(Args&&... args)
+				{
+					if (m_strand != nullptr)
+					{
+						m_strand->dispatch(std::bind(m_handler, std::forward<Args>(args)...));
+						return;
+					}
+
+					m_handler(std::forward<Args>(args)...);
+				}
+
+				boost::asio::strand* m_strand;
+
+				Handler m_handler;
+
+			};
+
+			/// <summary>
+			/// Handler hooks, so that composed operations such as asio::async_read(...) and the
+			/// TLS stream ones run their intermediate handlers in the strand, the very same way
+			/// as they would through boost::asio::strand::wrap(...).
+			///
+			/// Whatever is dispatched through the strand is rewrapped with the wrapped handler
+			/// as its context, again just like strand::wrap(...) does. The function is usually
+			/// an intermediate handler whose own hooks lead right back here, so dispatching it
+			/// as is would have the strand invoke it through this very hook, over and over.
+			/// </summary>
+			template<typename Handler>
+			inline void* asio_handler_allocate(std::size_t size, OptionalStrandHandler<Handler>* thisHandler)
+			{
+				return boost_asio_handler_alloc_helpers::allocate(size, thisHandler->m_handler);
+			}
+
+			template<typename Handler>
+			inline void asio_handler_deallocate(void* pointer, std::size_t size, OptionalStrandHandler<Handler>* thisHandler)
+			{
+				boost_asio_handler_alloc_helpers::deallocate(pointer, size, thisHandler->m_handler);
+			}
+
+			template<typename Handler>
+			inline bool asio_handler_is_continuation(OptionalStrandHandler<Handler>* thisHandler)
+			{
+				if (thisHandler->m_strand != nullptr)
+				{
+					return thisHandler->m_strand->running_in_this_thread();
+				}
+
+				return boost_asio_handler_cont_helpers::is_continuation(thisHandler->m_handler);
+			}
+
+			template<typename Function, typename Handler>
+			inline void asio_handler_invoke(Function& function, OptionalStrandHandler<Handler>* thisHandler)
+			{
+				if (thisHandler->m_strand != nullptr)
+				{
+					thisHandler->m_strand->dispatch(boost::asio::detail::rewrapped_handler<Function, Handler>(function, thisHandler->m_handler));
+					return;
+				}
+
+				boost_asio_handler_invoke_helpers::invoke(function, thisHandler->m_handler);
+			}
+
+			template<typename Function, typename Handler>
+			inline void asio_handler_invoke(const Function& function, OptionalStrandHandler<Handler>* thisHandler)
+			{
+				if (thisHandler->m_strand != nullptr)
+				{
+					thisHandler->m_strand->dispatch(boost::asio::detail::rewrapped_handler<Function, Handler>(function, thisHandler->m_handler));
+					return;
+				}
+
+				boost_asio_handler_invoke_helpers::invoke(function, thisHandler->m_handler);
+			}
+
+			/// <summary>
+			/// The OptionalStrand is a drop in for boost::asio::strand for objects that are
+			/// driven by an io_service which may or may not be run by more than one thread.
+			/// When it is, handlers are serialized through a real strand. When the io_service
+			/// is run by a single thread, handlers can't run concurrently to begin with, so
+			/// they're posted, dispatched and invoked directly, sparing the strand's locking
+			/// and queueing on every completion.
+			/// </summary>
+			class OptionalStrand
+			{
+
+			public:
+
+				/// <summary>
+				/// Constructs a new OptionalStrand.
+				/// </summary>
+				/// <param name="service">
+				/// The io_service that handlers are posted to.
+				/// </param>
+				/// <param name="serialize">
+				/// Whether handlers need to be serialized, which is the case whenever more than
+				/// one thread runs the supplied io_service.
+				/// </param>
+				OptionalStrand(boost::asio::io_service& service, const bool serialize)
+					:
+					m_service(service),
+					m_strand(serialize ? new boost::asio::strand(service) : nullptr)
+				{
+
+				}
+
+				/// <summary>
+				/// No copy no move no thx.
+				/// </summary>
+				OptionalStrand(const OptionalStrand&) = delete;
+				OptionalStrand(OptionalStrand&&) = delete;
+				OptionalStrand& operator=(const OptionalStrand&) = delete;
+
+				/// <summary>
+				/// Default destructor.
+				/// </summary>
+				~OptionalStrand()
+				{
+
+				}
+
+				/// <summary>
+				/// Requests the io_service to invoke the supplied handler, and returns without
+				/// invoking it.
+				/// </summary>
+				template<typename Handler>
+				void post(Handler&& handler)
+				{
+					if (m_strand != nullptr)
+					{
+						m_strand->post(std::forward<Handler>(handler));
+						return;
+					}
+
+					m_service.post(std::forward<Handler>(handler));
+				}
+
+				/// <summary>
+				/// Requests the io_service to invoke the supplied handler, which may happen
+				/// before returning.
+				/// </summary>
+				template<typename Handler>
+				void dispatch(Handler&& handler)
+				{
+					if (m_strand != nullptr)
+					{
+						m_strand->dispatch(std::forward<Handler>(handler));
+						return;
+					}
+
+					m_service.dispatch(std::forward<Handler>(handler));
+				}
+
+				/// <summary>
+				/// Wraps the supplied handler, so that it's invoked in the strand when there
+				/// is one.
+				/// </summary>
+				template<typename Handler>
+				OptionalStrandHandler<typename std::decay<Handler>::type> wrap(Handler&& handler)
+				{
+					return OptionalStrandHandler<typename std::decay<Handler>::type>(m_strand.get(), std::forward<Handler>(handler));
+				}
+
+				/// <summary>
+				/// Gets the io_service that handlers are posted to.
+				/// </summary>
+				boost::asio::io_service& get_io_service()
+				{
+					return m_service;
+				}
+
+			private:
+
+				boost::asio::io_service& m_service;
+
+				std::unique_ptr<boost::asio::strand> m_strand;
+
+			};
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,41 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "OriginalPortTable.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			OriginalPortTable& OriginalPortTable::Shared()
+			{
+				static OriginalPortTable table;
+				return table;
+			}
+
+			OriginalPortTable::OriginalPortTable()
+			{
+				// Arrays of atomics aren't reliably zeroed by value initialization on every
+				// compiler we build with.
+				for (size_t i = 0; i < m_v4Ports.size(); ++i)
+				{
+					m_v4Ports[i] = 0;
+					m_v6Ports[i] = 0;
+				}
+			}
+
+			OriginalPortTable::~OriginalPortTable()
+			{
+
+			}
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,106 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			/// <summary>
+			/// The OriginalPortTable remembers the port each diverted client was originally
+			/// connecting to, by the local port of the client. The diverter records it when it
+			/// sends a new flow to a listener, and needs it again for every packet it sends
+			/// back, so that the client sees replies from the port it connected to. Bridges
+			/// need it to connect upstream to that same port, since all they see locally is
+			/// the port of the listener.
+			///
+			/// Ports are in host order. Zero means nothing was recorded, in which case the
+			/// standard port of the listener is what the client was connecting to. Lookups
+			/// and updates are single atomic loads and stores, so the table is safe to use
+			/// from any thread, including the diversion threads, packet by packet.
+			/// </summary>
+			class OriginalPortTable
+			{
+
+			public:
+
+				/// <summary>
+				/// Gets the table shared by the diverter and every bridge.
+				/// </summary>
+				static OriginalPortTable& Shared();
+
+				/// <summary>
+				/// No copy no move no thx.
+				/// </summary>
+				OriginalPortTable(const OriginalPortTable&) = delete;
+				OriginalPortTable(OriginalPortTable&&) = delete;
+				OriginalPortTable& operator=(const OriginalPortTable&) = delete;
+
+				/// <summary>
+				/// Default destructor.
+				/// </summary>
+				~OriginalPortTable();
+
+				/// <summary>
+				/// Records the port the client on the supplied local port is connecting to.
+				/// </summary>
+				/// <param name="v6">
+				/// Whether the client connects over IPV6. Clients over IPV4 and IPV6 may share
+				/// local port numbers, so each has a table of its own.
+				/// </param>
+				/// <param name="clientPort">
+				/// The local port of the client.
+				/// </param>
+				/// <param name="originalPort">
+				/// The port the client is connecting to. Zero to forget.
+				/// </param>
+				void Set(const bool v6, const uint16_t clientPort, const uint16_t originalPort)
+				{
+					(v6 ? m_v6Ports : m_v4Ports)[clientPort].store(originalPort, std::memory_order_relaxed);
+				}
+
+				/// <summary>
+				/// Gets the port the client on the supplied local port is connecting to.
+				/// </summary>
+				/// <param name="v6">
+				/// Whether the client connects over IPV6.
+				/// </param>
+				/// <param name="clientPort">
+				/// The local port of the client.
+				/// </param>
+				/// <returns>
+				/// The port the client is connecting to, or zero if none was recorded.
+				/// </returns>
+				const uint16_t Get(const bool v6, const uint16_t clientPort) const
+				{
+					return (v6 ? m_v6Ports : m_v4Ports)[clientPort].load(std::memory_order_relaxed);
+				}
+
+			private:
+
+				/// <summary>
+				/// Private, use ::Shared().
+				/// </summary>
+				OriginalPortTable();
+
+				std::array<std::atomic<uint16_t>, 65536> m_v4Ports;
+
+				std::array<std::atomic<uint16_t>, 65536> m_v6Ports;
+
+			};
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,215 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "TimerWheel.hpp"
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			TimerWheel::Timer::Timer(ExpiryHandler onExpired)
+				:
+				m_slotTick(Never),
+				m_onExpired(std::move(onExpired))
+			{
+				m_expiryTick = Never;
+			}
+
+			TimerWheel::Timer::~Timer()
+			{
+
+			}
+
+			void TimerWheel::Timer::Cancel()
+			{
+				m_expiryTick = Never;
+			}
+
+			TimerWheel::TimerWheel(boost::asio::io_service& service, const uint32_t tickMilliseconds)
+				:
+				m_tickTimer(service),
+				m_tickMilliseconds(tickMilliseconds > 0 ? tickMilliseconds : DefaultTickMilliseconds),
+				m_epoch(std::chrono::steady_clock::now()),
+				m_slots(SlotCount)
+			{
+				m_ticking = false;
+			}
+
+			TimerWheel::~TimerWheel()
+			{
+
+			}
+
+			void TimerWheel::Start()
+			{
+				if (!m_ticking.exchange(true))
+				{
+					ScheduleTick();
+				}
+			}
+
+			std::shared_ptr<TimerWheel::Timer> TimerWheel::MakeTimer(ExpiryHandler onExpired)
+			{
+				return std::make_shared<Timer>(std::move(onExpired));
+			}
+
+			void TimerWheel::Arm(const std::shared_ptr<Timer>& timer, const boost::posix_time::time_duration& expiry)
+			{
+				if (timer == nullptr)
+				{
+					return;
+				}
+
+				const int64_t milliseconds = expiry.total_milliseconds() > 0 ? expiry.total_milliseconds() : 0;
+				const uint64_t ticks = std::max<uint64_t>((static_cast<uint64_t>(milliseconds) + m_tickMilliseconds - 1) / m_tickMilliseconds, 1);
+
+				// The present tick is already partly gone, so one more is added to never expire
+				// early.
+				const uint64_t expiryTick = GetCurrentTick() + ticks + 1;
+
+				if (timer->m_expiryTick.load() == expiryTick)
+				{
+					return;
+				}
+
+				const uint64_t previousTick = timer->m_expiryTick.exchange(expiryTick);
+
+				if (previousTick != Never && expiryTick >= previousTick)
+				{
+					// Pushed back. The slot it's in comes around first, and moves it along then.
+					return;
+				}
+
+				std::lock_guard<std::mutex> lock(m_slotsMutex);
+
+				// Should a tick have gone through the slot it belongs in while we waited for the
+				// lock, the next one to be gone through expires it instead.
+				const uint64_t slotTick = std::max(expiryTick, m_lastTick + 1);
+
+				if (slotTick < timer->m_slotTick)
+				{
+					timer->m_slotTick = slotTick;
+					m_slots[slotTick % SlotCount].push_back(timer);
+				}
+			}
+
+			const uint64_t TimerWheel::GetCurrentTick() const
+			{
+				const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch);
+
+				return static_cast<uint64_t>(elapsed.count()) / m_tickMilliseconds;
+			}
+
+			void TimerWheel::ScheduleTick()
+			{
+				m_tickTimer.expires_from_now(boost::posix_time::milliseconds(m_tickMilliseconds));
+
+				m_tickTimer.async_wait(std::bind(&TimerWheel::OnTick, this, std::placeholders::_1));
+			}
+
+			void TimerWheel::OnTick(const boost::system::error_code& error)
+			{
+				if (error)
+				{
+					m_ticking = false;
+					return;
+				}
+
+				std::vector<std::shared_ptr<Timer>> expired;
+
+				{
+					std::lock_guard<std::mutex> lock(m_slotsMutex);
+
+					const uint64_t nowTick = GetCurrentTick();
+
+					// If the io_service was held up for more than a whole turn, every slot is
+					// gone through once, which is all there is.
+					uint64_t slotTick = m_lastTick + 1;
+
+					if (nowTick >= SlotCount && slotTick < nowTick - SlotCount + 1)
+					{
+						slotTick = nowTick - SlotCount + 1;
+					}
+
+					for (; slotTick <= nowTick; ++slotTick)
+					{
+						auto& slot = m_slots[slotTick % SlotCount];
+
+						if (slot.empty())
+						{
+							continue;
+						}
+
+						m_due.swap(slot);
+
+						for (auto& timer : m_due)
+						{
+							Reschedule(std::move(timer), slotTick, nowTick, expired);
+						}
+
+						m_due.clear();
+					}
+
+					m_lastTick = nowTick;
+				}
+
+				for (auto& timer : expired)
+				{
+					if (timer->m_onExpired)
+					{
+						timer->m_onExpired();
+					}
+				}
+
+				ScheduleTick();
+			}
+
+			void TimerWheel::Reschedule(std::shared_ptr<Timer> timer, const uint64_t slotTick, const uint64_t nowTick, std::vector<std::shared_ptr<Timer>>& expired)
+			{
+				if (timer->m_slotTick > slotTick)
+				{
+					// Left behind when the timer was re-armed to expire sooner, or already
+					// dropped. Its slot is elsewhere.
+					return;
+				}
+
+				for (;;)
+				{
+					uint64_t expiryTick = timer->m_expiryTick.load();
+
+					if (expiryTick == Never)
+					{
+						// Cancelled. If it's armed again, it finds it isn't in the wheel and puts
+						// itself back.
+						timer->m_slotTick = Never;
+						return;
+					}
+
+					if (expiryTick > nowTick)
+					{
+						timer->m_slotTick = expiryTick;
+						m_slots[expiryTick % SlotCount].push_back(std::move(timer));
+						return;
+					}
+
+					// Fails if it was re-armed just now, in which case it goes around again.
+					if (timer->m_expiryTick.compare_exchange_strong(expiryTick, Never))
+					{
+						timer->m_slotTick = Never;
+						expired.push_back(std::move(timer));
+						return;
+					}
+				}
+			}
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
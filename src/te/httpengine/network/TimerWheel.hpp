@@ -0,0 +1,240 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/asio.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace network
+		{
+
+			/// <summary>
+			/// The TimerWheel keeps coarse timeouts for many objects driven by one io_service,
+			/// such as the stream timeouts of bridges, with a single asio timer ticking at a
+			/// fixed rate. Timeouts that are re-armed constantly, on every read and write, cost
+			/// an atomic store rather than a cancel, a heap update and an aborted handler each
+			/// time, and every timeout that falls in the same tick expires in one batch.
+			///
+			/// Timers are hashed into slots by the tick they expire at. A timer that has been
+			/// re-armed since it was put in its slot is only moved to its new slot once the old
+			/// one comes around, and a timer further out than one turn of the wheel simply sits
+			/// through another turn of it. Expiry is only ever as precise as the tick, and never
+			/// early.
+			///
+			/// Arming and cancelling are safe from any thread. Expiry handlers are called on a
+			/// thread running the io_service, outside of any lock.
+			/// </summary>
+			class TimerWheel
+			{
+
+			public:
+
+				/// <summary>
+				/// Called once a timer expires.
+				/// </summary>
+				using ExpiryHandler = std::function<void()>;
+
+				/// <summary>
+				/// Default number of milliseconds between ticks.
+				/// </summary>
+				static constexpr uint32_t DefaultTickMilliseconds = 1000;
+
+				/// <summary>
+				/// Number of slots in the wheel. At the default tick, one turn is a little over
+				/// eight and a half minutes, beyond the longest timeout bridges set.
+				/// </summary>
+				static constexpr size_t SlotCount = 512;
+
+				/// <summary>
+				/// A timeout kept by the wheel. Made by ::MakeTimer(...), owned by whatever it
+				/// times out, and shared with the wheel only for as long as it is armed.
+				/// </summary>
+				class Timer
+				{
+
+				public:
+
+					/// <summary>
+					/// Constructs a new, unarmed timer. Use TimerWheel::MakeTimer(...).
+					/// </summary>
+					/// <param name="onExpired">
+					/// Called if the timer expires.
+					/// </param>
+					Timer(ExpiryHandler onExpired);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					Timer(const Timer&) = delete;
+					Timer(Timer&&) = delete;
+					Timer& operator=(const Timer&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~Timer();
+
+					/// <summary>
+					/// Disarms the timer. The wheel lets go of it the next time its slot comes
+					/// around. An expiry that is already being handled can't be called back.
+					/// </summary>
+					void Cancel();
+
+				private:
+
+					friend class TimerWheel;
+
+					/// <summary>
+					/// The tick the timer expires at, or Never if it isn't armed.
+					/// </summary>
+					std::atomic_uint64_t m_expiryTick;
+
+					/// <summary>
+					/// The tick of the slot the timer was last put in, or Never if it isn't in
+					/// the wheel. A timer re-armed to expire sooner is put in a second slot, and
+					/// whichever slot doesn't match this is left to drop it. Guarded by the lock
+					/// of the wheel.
+					/// </summary>
+					uint64_t m_slotTick;
+
+					ExpiryHandler m_onExpired;
+
+				};
+
+				/// <summary>
+				/// Constructs a new TimerWheel. The wheel doesn't tick until ::Start() is
+				/// called.
+				/// </summary>
+				/// <param name="service">
+				/// The io_service that drives the tick, and calls expiry handlers.
+				/// </param>
+				/// <param name="tickMilliseconds">
+				/// The number of milliseconds between ticks, which is also the precision of
+				/// every timeout.
+				/// </param>
+				TimerWheel(boost::asio::io_service& service, const uint32_t tickMilliseconds = DefaultTickMilliseconds);
+
+				/// <summary>
+				/// No copy no move no thx.
+				/// </summary>
+				TimerWheel(const TimerWheel&) = delete;
+				TimerWheel(TimerWheel&&) = delete;
+				TimerWheel& operator=(const TimerWheel&) = delete;
+
+				/// <summary>
+				/// Default destructor.
+				/// </summary>
+				~TimerWheel();
+
+				/// <summary>
+				/// Starts the tick, if it isn't already running. Must be called again after the
+				/// io_service is reset, but never more than one tick is ever running.
+				/// </summary>
+				void Start();
+
+				/// <summary>
+				/// Makes a new, unarmed timer for this wheel.
+				/// </summary>
+				/// <param name="onExpired">
+				/// Called if the timer expires. Should not hold on to whatever owns the timer,
+				/// since the wheel holds on to the timer while it's armed.
+				/// </param>
+				/// <returns>
+				/// The new timer.
+				/// </returns>
+				std::shared_ptr<Timer> MakeTimer(ExpiryHandler onExpired);
+
+				/// <summary>
+				/// Arms or re-arms the supplied timer to expire after the supplied duration,
+				/// replacing whatever expiry it had. Re-arming within the same tick does
+				/// nothing at all.
+				/// </summary>
+				/// <param name="timer">
+				/// A timer made by this wheel.
+				/// </param>
+				/// <param name="expiry">
+				/// The duration from now after which the timer expires.
+				/// </param>
+				void Arm(const std::shared_ptr<Timer>& timer, const boost::posix_time::time_duration& expiry);
+
+			private:
+
+				/// <summary>
+				/// The expiry tick of an unarmed timer.
+				/// </summary>
+				static constexpr uint64_t Never = UINT64_MAX;
+
+				/// <summary>
+				/// Gets the number of whole ticks since the wheel was constructed.
+				/// </summary>
+				const uint64_t GetCurrentTick() const;
+
+				/// <summary>
+				/// Arms the tick timer for the next tick.
+				/// </summary>
+				void ScheduleTick();
+
+				/// <summary>
+				/// Completion handler for the tick timer. Goes through every slot whose tick
+				/// has passed since the last one, expires the timers that are due, moves those
+				/// that were re-armed, and drops those that were cancelled.
+				/// </summary>
+				void OnTick(const boost::system::error_code& error);
+
+				/// <summary>
+				/// Goes through the supplied timer, found in the slot of the supplied tick. Puts it
+				/// into the slot for its present expiry, or, if it has expired by the supplied
+				/// present tick, takes it out of the wheel and adds it to the supplied list.
+				/// Caller must hold m_slotsMutex.
+				/// </summary>
+				void Reschedule(std::shared_ptr<Timer> timer, const uint64_t slotTick, const uint64_t nowTick, std::vector<std::shared_ptr<Timer>>& expired);
+
+				boost::asio::deadline_timer m_tickTimer;
+
+				const uint32_t m_tickMilliseconds;
+
+				const std::chrono::steady_clock::time_point m_epoch;
+
+				/// <summary>
+				/// The last tick whose slot has been gone through.
+				/// </summary>
+				uint64_t m_lastTick = 0;
+
+				/// <summary>
+				/// Whether a tick is pending on the io_service.
+				/// </summary>
+				std::atomic_bool m_ticking;
+
+				/// <summary>
+				/// Guards m_slots and m_due.
+				/// </summary>
+				std::mutex m_slotsMutex;
+
+				std::vector<std::vector<std::shared_ptr<Timer>>> m_slots;
+
+				/// <summary>
+				/// Reused to take the timers of a slot out into while going through them, so
+				/// that a tick doesn't allocate once it has grown.
+				/// </summary>
+				std::vector<std::shared_ptr<Timer>> m_due;
+
+			};
+
+		} /* namespace network */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,122 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "DeferredVerdictRegistry.hpp"
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				DeferredVerdictRegistry::DeferredVerdictRegistry()
+				{
+					m_lastToken = 0;
+					m_maxPending = DefaultMaxPending;
+					m_timeoutMilliseconds = DefaultTimeoutMilliseconds;
+				}
+
+				DeferredVerdictRegistry::~DeferredVerdictRegistry()
+				{
+
+				}
+
+				const uint64_t DeferredVerdictRegistry::Defer(CompletionHandler handler)
+				{
+					if (!handler)
+					{
+						return 0;
+					}
+
+					std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+					if (m_pending.size() >= m_maxPending)
+					{
+						return 0;
+					}
+
+					const uint64_t token = ++m_lastToken;
+
+					m_pending.emplace(token, std::move(handler));
+
+					return token;
+				}
+
+				const bool DeferredVerdictRegistry::Complete(const uint64_t token, const uint32_t verdict, const char* blockResponse, const uint32_t blockResponseLength)
+				{
+					CompletionHandler handler;
+
+					{
+						std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+						auto it = m_pending.find(token);
+
+						if (it == m_pending.end())
+						{
+							return false;
+						}
+
+						handler = std::move(it->second);
+						m_pending.erase(it);
+					}
+
+					std::shared_ptr<const char> response;
+					size_t responseLength = 0;
+
+					if (blockResponse != nullptr && blockResponseLength > 0)
+					{
+						// The host is free to reuse its buffer as soon as we return.
+						auto copy = std::make_shared<std::vector<char>>(blockResponse, blockResponse + blockResponseLength);
+						response = std::shared_ptr<const char>(copy, copy->data());
+						responseLength = copy->size();
+					}
+
+					// Called outside of the lock, as handlers are free to defer again.
+					handler(verdict, std::move(response), responseLength);
+
+					return true;
+				}
+
+				void DeferredVerdictRegistry::Clear()
+				{
+					std::unordered_map<uint64_t, CompletionHandler> pending;
+
+					{
+						std::lock_guard<std::mutex> lock(m_pendingMutex);
+						pending.swap(m_pending);
+					}
+
+					// Destroyed here, outside of the lock, since whatever the handlers hold on to
+					// goes with them.
+				}
+
+				void DeferredVerdictRegistry::SetLimits(const uint32_t maxPending, const uint32_t timeoutMilliseconds)
+				{
+					m_maxPending = maxPending;
+					m_timeoutMilliseconds = timeoutMilliseconds;
+				}
+
+				const uint32_t DeferredVerdictRegistry::GetTimeoutMilliseconds() const
+				{
+					return m_timeoutMilliseconds;
+				}
+
+				const uint32_t DeferredVerdictRegistry::GetPendingCount() const
+				{
+					std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+					return static_cast<uint32_t>(m_pending.size());
+				}
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
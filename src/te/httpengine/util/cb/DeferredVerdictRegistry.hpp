@@ -0,0 +1,165 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				/// <summary>
+				/// The DeferredVerdictRegistry keeps track of the transactions whose verdict a
+				/// callback has deferred, so that the host can deliver it later from any thread
+				/// without the bridge holding one while it waits. Each deferred verdict is known
+				/// by a token handed to the host, and is completed by it exactly once, either by
+				/// the host or by the bridge giving up on it. It is shared by every bridge and is
+				/// safe to use from any thread.
+				/// </summary>
+				class DeferredVerdictRegistry
+				{
+
+				public:
+
+					/// <summary>
+					/// Called with the verdict once it's delivered. The verdict means the same as
+					/// what the callback that deferred it would have set. The block response, if
+					/// any, is owned by the handler.
+					/// </summary>
+					using CompletionHandler = std::function<void(const uint32_t verdict, std::shared_ptr<const char> blockResponse, const size_t blockResponseLength)>;
+
+					/// <summary>
+					/// Default number of verdicts that may be pending at once.
+					/// </summary>
+					static constexpr uint32_t DefaultMaxPending = 256;
+
+					/// <summary>
+					/// Default number of milliseconds a bridge waits for a verdict.
+					/// </summary>
+					static constexpr uint32_t DefaultTimeoutMilliseconds = 30000;
+
+					/// <summary>
+					/// Constructs a new, empty DeferredVerdictRegistry.
+					/// </summary>
+					DeferredVerdictRegistry();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					DeferredVerdictRegistry(const DeferredVerdictRegistry&) = delete;
+					DeferredVerdictRegistry(DeferredVerdictRegistry&&) = delete;
+					DeferredVerdictRegistry& operator=(const DeferredVerdictRegistry&) = delete;
+
+					/// <summary>
+					/// Default destructor. Pending handlers are dropped without being called.
+					/// </summary>
+					~DeferredVerdictRegistry();
+
+					/// <summary>
+					/// Registers a pending verdict.
+					/// </summary>
+					/// <param name="handler">
+					/// Called once the verdict is delivered, on the thread that delivers it.
+					/// </param>
+					/// <returns>
+					/// The token the verdict is to be delivered with, or zero if as many verdicts
+					/// as allowed are already pending.
+					/// </returns>
+					const uint64_t Defer(CompletionHandler handler);
+
+					/// <summary>
+					/// Delivers a pending verdict. Only the first delivery for a token does
+					/// anything.
+					/// </summary>
+					/// <param name="token">
+					/// The token returned when the verdict was deferred.
+					/// </param>
+					/// <param name="verdict">
+					/// The verdict.
+					/// </param>
+					/// <param name="blockResponse">
+					/// A complete custom block response, headers included. Copied. May be nullptr.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// The length of the block response.
+					/// </param>
+					/// <returns>
+					/// True if the verdict was pending, false if the token is unknown or the
+					/// verdict was already delivered.
+					/// </returns>
+					const bool Complete(const uint64_t token, const uint32_t verdict, const char* blockResponse, const uint32_t blockResponseLength);
+
+					/// <summary>
+					/// Drops every pending verdict without calling their handlers. Used when the
+					/// Engine stops, so that parked bridges are released.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Sets the limits of deferral. Verdicts already pending keep the timeout they
+					/// were deferred with.
+					/// </summary>
+					/// <param name="maxPending">
+					/// The maximum number of verdicts pending at once. Zero disables deferral.
+					/// </param>
+					/// <param name="timeoutMilliseconds">
+					/// The number of milliseconds a bridge waits for a verdict before it carries on
+					/// as if the transaction was allowed.
+					/// </param>
+					void SetLimits(const uint32_t maxPending, const uint32_t timeoutMilliseconds);
+
+					/// <summary>
+					/// Gets the number of milliseconds a bridge waits for a verdict.
+					/// </summary>
+					/// <returns>
+					/// The verdict timeout.
+					/// </returns>
+					const uint32_t GetTimeoutMilliseconds() const;
+
+					/// <summary>
+					/// Gets the number of verdicts presently pending.
+					/// </summary>
+					/// <returns>
+					/// The number of pending verdicts.
+					/// </returns>
+					const uint32_t GetPendingCount() const;
+
+				private:
+
+					/// <summary>
+					/// Guards m_pending.
+					/// </summary>
+					mutable std::mutex m_pendingMutex;
+
+					std::unordered_map<uint64_t, CompletionHandler> m_pending;
+
+					/// <summary>
+					/// The last token handed out. Tokens start at one, so zero is never valid.
+					/// </summary>
+					std::atomic_uint64_t m_lastToken;
+
+					std::atomic_uint32_t m_maxPending;
+
+					std::atomic_uint32_t m_timeoutMilliseconds;
+
+				};
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
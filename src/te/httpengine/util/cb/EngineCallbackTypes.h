@@ -50,6 +50,111 @@ typedef void(*HttpMessageEndCallback)(
 	bool* shouldBlock, const CustomResponseStreamWriter customBlockResponseStreamWriter
 	);
 
+/// <summary>
+/// Called with each piece of payload (body) of a transaction that was given a nextAction of 4 by
+/// the HttpMessageBeginCallback, as the piece is read, before it is forwarded. Pieces are what the
+/// peer sent, minus any chunked transfer framing, and decompressed when the payload is gzip or
+/// deflate encoded. Should decompression fail, the rest is handed over as it was received. The
+/// response headers are empty when the payload being inspected is that of the request. The final
+/// call for a transaction has isFinalChunk set, and may have no data.
+///
+/// The callback sets nextAction to 0 to keep inspecting, 1 to pass the rest of the payload
+/// without further calls, or 2 to block. Blocking aborts the transaction. A custom block response
+/// written through the supplied writer is only sent if nothing of the response has reached the
+/// client yet, otherwise the connection is simply closed.
+/// </summary>
+typedef void(*HttpMessageChunkCallback)(
+	const char* requestHeaders, const uint32_t requestHeadersLength,
+	const char* responseHeaders, const uint32_t responseHeadersLength,
+	const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+	uint32_t* nextAction, const CustomResponseStreamWriter customBlockResponseStreamWriter
+	);
+
+/// <summary>
+/// Opaque handle to the transaction that a v2 callback is being invoked for. Everything about the
+/// transaction is fetched through the fe_ctx_* functions, and only what is asked for is ever
+/// formatted, so a callback that looks only at the host and path costs no copies at all. Custom
+/// block responses are also written through the fe_ctx_* functions. Only valid for the duration
+/// of the callback it was given to, as is everything fetched through it.
+/// </summary>
+typedef void* HttpTransactionContext;
+
+/// <summary>
+/// Called once the Engine is done with a buffer that was handed over to it with
+/// fe_ctx_give_block_response(...), with the same data and length that were handed over. May be
+/// called from any of the Engine's threads.
+/// </summary>
+typedef void(*CustomResponseBufferRelease)(const char* data, const uint32_t dataLength);
+
+/// <summary>
+/// Same as HttpMessageBeginCallback, except that the transaction is only supplied as a context.
+/// </summary>
+typedef void(*HttpMessageBeginCallbackV2)(HttpTransactionContext context, uint32_t* nextAction);
+
+/// <summary>
+/// Same as HttpMessageEndCallback, except that the transaction is only supplied as a context.
+/// The payloads that were held back for inspection are fetched with
+/// fe_ctx_get_request_payload(...) and fe_ctx_get_response_payload(...).
+/// </summary>
+typedef void(*HttpMessageEndCallbackV2)(HttpTransactionContext context, bool* shouldBlock);
+
+/// <summary>
+/// Same as HttpMessageChunkCallback, except that the transaction is only supplied as a context.
+/// The same context is supplied to every call made for the pieces of a single read.
+/// </summary>
+typedef void(*HttpMessageChunkCallbackV2)(
+	HttpTransactionContext context,
+	const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+	uint32_t* nextAction
+	);
+
+/// <summary>
+/// A rule for fe_ctl_load_rules(...), deciding natively what happens to the messages it matches,
+/// so that no callback is invoked for them. Every criterion left zero, or null, matches anything,
+/// and a rule matches a message when all of its criteria do.
+/// </summary>
+typedef struct HttpFilteringRule
+{
+	/// <summary>
+	/// 0 to pass the message without inspection, while still checking whatever follows in the
+	/// same transaction, such as the response. 1 to pass the rest of the transaction without
+	/// inspection. 2 to block the transaction with a 204 No Content. 3 to hand the message to the
+	/// callbacks, as though no rule matched, which lets a narrow rule carve an exception out of a
+	/// broader one after it.
+	/// </summary>
+	uint32_t action;
+
+	/// <summary>
+	/// Matches the host itself and any host under it, label by label, without regard to case.
+	/// "example.com" matches "cdn.example.com", but not "badexample.com".
+	/// </summary>
+	const char* hostSuffix;
+	uint32_t hostSuffixLength;
+
+	/// <summary>
+	/// Matches the method of the request, without regard to case.
+	/// </summary>
+	const char* method;
+	uint32_t methodLength;
+
+	/// <summary>
+	/// Matches a message of any one of these kinds, in the same mask as returned by
+	/// fe_ctx_get_media_kinds(...). That's the response once there is one, the request before.
+	/// </summary>
+	uint32_t mediaKinds;
+
+	/// <summary>
+	/// Matches a message declaring a Content-Length of at least this. A message that doesn't
+	/// declare its length never matches a rule with a size.
+	/// </summary>
+	uint64_t minContentLength;
+
+	/// <summary>
+	/// Matches a message declaring a Content-Length of at most this. Zero for no limit.
+	/// </summary>
+	uint64_t maxContentLength;
+} HttpFilteringRule;
+
 #ifdef __cplusplus
 namespace te
 {
@@ -63,16 +168,18 @@ namespace te
 				using FirewallCheckFunction = std::function<bool(const char* binaryAbsolutePath, const size_t binaryAbsolutePathLength)>;
 				using MessageFunction = std::function<void(const char* message, const size_t messageLength)>;
 
-				using HttpMessageBeginCheckFunction = std::function<void(
-					const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-					const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-					uint32_t* nextAction, const CustomResponseStreamWriter customBlockResponseStreamWriter
-					)>;
+				/// <summary>
+				/// The callbacks as the Engine invokes them, which is the shape of the v2 callbacks.
+				/// Callbacks supplied through the original API are adapted to this at creation.
+				/// </summary>
+				using HttpMessageBeginCheckFunction = std::function<void(HttpTransactionContext context, uint32_t* nextAction)>;
+
+				using HttpMessageEndCheckFunction = std::function<void(HttpTransactionContext context, bool* shouldBlock)>;
 
-				using HttpMessageEndCheckFunction = std::function<void(
-					const char* requestHeaders, const uint32_t requestHeadersLength, const char* requestBody, const uint32_t requestBodyLength,
-					const char* responseHeaders, const uint32_t responseHeadersLength, const char* responseBody, const uint32_t responseBodyLength,
-					bool* shouldBlock, const CustomResponseStreamWriter customBlockResponseStreamWriter
+				using HttpMessageChunkCheckFunction = std::function<void(
+					HttpTransactionContext context,
+					const char* chunk, const uint32_t chunkLength, const bool isFinalChunk,
+					uint32_t* nextAction
 					)>;
 
 			} /* namespace cb */
@@ -0,0 +1,295 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "EventPipeline.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				EventPipeline::EventPipeline(
+					MessageFunction onInfo,
+					MessageFunction onWarning,
+					MessageFunction onError,
+					const size_t capacity
+					)
+					:
+					m_onInfo(onInfo),
+					m_onWarning(onWarning),
+					m_onError(onError)
+				{
+					size_t roundedCapacity = 2;
+
+					while (roundedCapacity < capacity)
+					{
+						roundedCapacity <<= 1;
+					}
+
+					m_cells.reset(new Cell[roundedCapacity]);
+					m_mask = roundedCapacity - 1;
+
+					for (size_t i = 0; i < roundedCapacity; ++i)
+					{
+						m_cells[i].sequence.store(i, std::memory_order_relaxed);
+					}
+
+					m_enqueuePosition = 0;
+					m_minimumSeverity = static_cast<uint32_t>(Severity::Info);
+					m_delivered = 0;
+					m_dropped = 0;
+					m_truncated = 0;
+					m_idle = false;
+					m_running = true;
+
+					// Last, once everything it touches is in place.
+					m_thread = std::thread(&EventPipeline::Deliver, this);
+				}
+
+				EventPipeline::~EventPipeline()
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_wakeMutex);
+						m_running = false;
+					}
+
+					m_wake.notify_one();
+
+					if (m_thread.joinable())
+					{
+						m_thread.join();
+					}
+				}
+
+				MessageFunction EventPipeline::MakeReporter(const Severity severity)
+				{
+					const bool hasCallback =
+						(severity == Severity::Info && m_onInfo) ||
+						(severity == Severity::Warning && m_onWarning) ||
+						(severity == Severity::Error && m_onError);
+
+					if (!hasCallback)
+					{
+						return nullptr;
+					}
+
+					return [this, severity](const char* message, const size_t messageLength)
+					{
+						Post(severity, message, messageLength);
+					};
+				}
+
+				const bool EventPipeline::Post(const Severity severity, const char* message, const size_t messageLength)
+				{
+					if (static_cast<uint32_t>(severity) < m_minimumSeverity.load(std::memory_order_relaxed) || message == nullptr)
+					{
+						return false;
+					}
+
+					Cell* cell = nullptr;
+					size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+
+					for (;;)
+					{
+						cell = &m_cells[position & m_mask];
+
+						const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+						const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+						if (difference == 0)
+						{
+							if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+							{
+								break;
+							}
+						}
+						else if (difference < 0)
+						{
+							// Full. The delivery thread hasn't caught up, and we don't wait for it.
+							++m_dropped;
+							return false;
+						}
+						else
+						{
+							position = m_enqueuePosition.load(std::memory_order_relaxed);
+						}
+					}
+
+					size_t length = messageLength;
+
+					if (length > MaxMessageLength)
+					{
+						length = MaxMessageLength;
+						++m_truncated;
+					}
+
+					cell->record.severity = severity;
+					cell->record.length = static_cast<uint32_t>(length);
+					cell->record.thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+					std::memcpy(cell->record.message, message, length);
+
+					cell->sequence.store(position + 1, std::memory_order_release);
+
+					if (m_idle.load())
+					{
+						m_wake.notify_one();
+					}
+
+					return true;
+				}
+
+				void EventPipeline::SetMinimumSeverity(const uint32_t minimumSeverity)
+				{
+					m_minimumSeverity = minimumSeverity;
+				}
+
+				EventPipelineStats EventPipeline::GetStats() const
+				{
+					EventPipelineStats stats;
+
+					stats.Delivered = m_delivered;
+					stats.Dropped = m_dropped;
+					stats.Truncated = m_truncated;
+
+					return stats;
+				}
+
+				void EventPipeline::Deliver()
+				{
+					for (;;)
+					{
+						if (DeliverBatch() > 0)
+						{
+							continue;
+						}
+
+						std::unique_lock<std::mutex> lock(m_wakeMutex);
+
+						if (!m_running)
+						{
+							break;
+						}
+
+						m_idle = true;
+
+						// Producers don't take the lock to signal, so a wake up can slip past
+						// between the last look at the ring and the wait. The timeout bounds how
+						// late that leaves a message.
+						if (DeliverBatch() == 0)
+						{
+							m_wake.wait_for(lock, std::chrono::milliseconds(50));
+						}
+
+						m_idle = false;
+					}
+
+					// Whatever was posted while we were stopping.
+					DeliverBatch();
+				}
+
+				const size_t EventPipeline::DeliverBatch()
+				{
+					size_t delivered = 0;
+
+					for (;;)
+					{
+						Cell& cell = m_cells[m_dequeuePosition & m_mask];
+
+						if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+						{
+							break;
+						}
+
+						const Record& record = cell.record;
+
+						#ifndef NDEBUG
+							char tagged[MaxMessageLength + 48];
+							const int tagLength = std::snprintf(tagged, sizeof(tagged), u8"From Thread %zu: ", record.thread);
+
+							if (tagLength > 0 && static_cast<size_t>(tagLength) + record.length <= sizeof(tagged))
+							{
+								std::memcpy(tagged + tagLength, record.message, record.length);
+								Invoke(record.severity, tagged, tagLength + record.length);
+							}
+							else
+							{
+								Invoke(record.severity, record.message, record.length);
+							}
+						#else
+							Invoke(record.severity, record.message, record.length);
+						#endif
+
+						cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+						++m_dequeuePosition;
+						++delivered;
+					}
+
+					m_delivered += delivered;
+
+					const uint64_t dropped = m_dropped;
+
+					if (dropped != m_droppedReported)
+					{
+						char notice[96];
+						const int noticeLength = std::snprintf(notice, sizeof(notice), u8"Event pipeline dropped %llu messages.", static_cast<unsigned long long>(dropped - m_droppedReported));
+
+						m_droppedReported = dropped;
+
+						if (noticeLength > 0)
+						{
+							Invoke(Severity::Warning, notice, static_cast<size_t>(noticeLength));
+						}
+					}
+
+					return delivered;
+				}
+
+				void EventPipeline::Invoke(const Severity severity, const char* message, const size_t messageLength) const
+				{
+					switch (severity)
+					{
+						case Severity::Info:
+						{
+							if (m_onInfo)
+							{
+								m_onInfo(message, messageLength);
+							}
+						}
+						break;
+
+						case Severity::Warning:
+						{
+							if (m_onWarning)
+							{
+								m_onWarning(message, messageLength);
+							}
+						}
+						break;
+
+						case Severity::Error:
+						{
+							if (m_onError)
+							{
+								m_onError(message, messageLength);
+							}
+						}
+						break;
+					}
+				}
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,260 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "EngineCallbackTypes.h"
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the event pipeline counters.
+				/// </summary>
+				struct EventPipelineStats
+				{
+					/// <summary>
+					/// Total number of messages delivered to the host.
+					/// </summary>
+					uint64_t Delivered = 0;
+
+					/// <summary>
+					/// Total number of messages dropped because the ring was full.
+					/// </summary>
+					uint64_t Dropped = 0;
+
+					/// <summary>
+					/// Total number of messages that were longer than a record holds, and were
+					/// delivered cut short.
+					/// </summary>
+					uint64_t Truncated = 0;
+				};
+
+				/// <summary>
+				/// The EventPipeline stands between everything that reports events and the
+				/// callbacks of the host. Reporting a message copies it into a fixed size record
+				/// in a bounded ring, without locking or allocating, and returns. A thread of the
+				/// pipeline's own delivers the records to the host callbacks in batches. Should
+				/// the host be slower than the Engine is noisy, messages are dropped and counted
+				/// rather than the reporting threads being held up, and the host is told how many
+				/// were lost.
+				///
+				/// Any number of threads may report at once. Messages below the minimum severity
+				/// are dropped before they're copied, and the minimum can be changed at any time.
+				/// </summary>
+				class EventPipeline
+				{
+
+				public:
+
+					/// <summary>
+					/// Severity of a message, lowest first.
+					/// </summary>
+					enum class Severity : uint32_t
+					{
+						Info = 0,
+						Warning = 1,
+						Error = 2
+					};
+
+					/// <summary>
+					/// Default number of records in the ring. Must be a power of two.
+					/// </summary>
+					static constexpr size_t DefaultCapacity = 4096;
+
+					/// <summary>
+					/// The longest message a record holds. Longer ones are cut short.
+					/// </summary>
+					static constexpr size_t MaxMessageLength = 240;
+
+					/// <summary>
+					/// Constructs a new EventPipeline and starts its delivery thread.
+					/// </summary>
+					/// <param name="onInfo">
+					/// The host callback for informational messages. May be nullptr.
+					/// </param>
+					/// <param name="onWarning">
+					/// The host callback for warnings. May be nullptr.
+					/// </param>
+					/// <param name="onError">
+					/// The host callback for errors. May be nullptr.
+					/// </param>
+					/// <param name="capacity">
+					/// The number of records in the ring, rounded up to a power of two.
+					/// </param>
+					EventPipeline(
+						MessageFunction onInfo,
+						MessageFunction onWarning,
+						MessageFunction onError,
+						const size_t capacity = DefaultCapacity
+						);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					EventPipeline(const EventPipeline&) = delete;
+					EventPipeline(EventPipeline&&) = delete;
+					EventPipeline& operator=(const EventPipeline&) = delete;
+
+					/// <summary>
+					/// Delivers whatever is left in the ring, then stops the delivery thread.
+					/// </summary>
+					~EventPipeline();
+
+					/// <summary>
+					/// Gets a callback that reports messages of the supplied severity through the
+					/// pipeline, to be handed to whatever reports events in place of the host
+					/// callback. The pipeline must outlive it.
+					/// </summary>
+					/// <param name="severity">
+					/// The severity of the messages the callback reports.
+					/// </param>
+					/// <returns>
+					/// The reporting callback, or nullptr if the host gave no callback for the
+					/// supplied severity, so that reporters skip the message altogether.
+					/// </returns>
+					MessageFunction MakeReporter(const Severity severity);
+
+					/// <summary>
+					/// Copies the supplied message into the ring. Never blocks, and never
+					/// allocates.
+					/// </summary>
+					/// <param name="severity">
+					/// The severity of the message.
+					/// </param>
+					/// <param name="message">
+					/// The message.
+					/// </param>
+					/// <param name="messageLength">
+					/// The length of the message.
+					/// </param>
+					/// <returns>
+					/// True if the message was queued for delivery, false if it was below the
+					/// minimum severity, or dropped because the ring was full.
+					/// </returns>
+					const bool Post(const Severity severity, const char* message, const size_t messageLength);
+
+					/// <summary>
+					/// Sets the minimum severity of messages that are delivered. Can be called at
+					/// any time.
+					/// </summary>
+					/// <param name="minimumSeverity">
+					/// The minimum severity, as the value of a Severity. Anything greater than the
+					/// highest severity silences the pipeline.
+					/// </param>
+					void SetMinimumSeverity(const uint32_t minimumSeverity);
+
+					/// <summary>
+					/// Gets a snapshot of the pipeline counters.
+					/// </summary>
+					/// <returns>
+					/// The current pipeline counters.
+					/// </returns>
+					EventPipelineStats GetStats() const;
+
+				private:
+
+					struct Record
+					{
+						Severity severity;
+						uint32_t length;
+						size_t thread;
+						char message[MaxMessageLength];
+					};
+
+					/// <summary>
+					/// A slot of the ring. The sequence tells producers and the consumer whose turn
+					/// it is, as in Dmitry Vyukov's bounded queue. A record already spans a good
+					/// few cache lines, so neighbouring cells barely share any.
+					/// </summary>
+					struct Cell
+					{
+						std::atomic_size_t sequence;
+						Record record;
+					};
+
+					/// <summary>
+					/// Runs on the delivery thread until the pipeline is destroyed.
+					/// </summary>
+					void Deliver();
+
+					/// <summary>
+					/// Delivers every record presently in the ring.
+					/// </summary>
+					/// <returns>
+					/// The number of records delivered.
+					/// </returns>
+					const size_t DeliverBatch();
+
+					/// <summary>
+					/// Hands a single message to the host callback for the supplied severity.
+					/// </summary>
+					void Invoke(const Severity severity, const char* message, const size_t messageLength) const;
+
+					MessageFunction m_onInfo;
+
+					MessageFunction m_onWarning;
+
+					MessageFunction m_onError;
+
+					std::unique_ptr<Cell[]> m_cells;
+
+					size_t m_mask;
+
+					std::atomic_size_t m_enqueuePosition;
+
+					/// <summary>
+					/// Only ever touched by the delivery thread.
+					/// </summary>
+					size_t m_dequeuePosition = 0;
+
+					std::atomic_uint32_t m_minimumSeverity;
+
+					std::atomic_uint64_t m_delivered;
+
+					std::atomic_uint64_t m_dropped;
+
+					std::atomic_uint64_t m_truncated;
+
+					/// <summary>
+					/// The number of drops the host has been told about. Only ever touched by the
+					/// delivery thread.
+					/// </summary>
+					uint64_t m_droppedReported = 0;
+
+					std::atomic_bool m_running;
+
+					/// <summary>
+					/// Set while the delivery thread waits for messages, so that producers only
+					/// ever signal when there's someone to wake.
+					/// </summary>
+					std::atomic_bool m_idle;
+
+					std::mutex m_wakeMutex;
+
+					std::condition_variable m_wake;
+
+					std::thread m_thread;
+
+				};
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -10,7 +10,6 @@
 
 #include "EngineCallbackTypes.h"
 #include <boost/utility/string_ref.hpp>
-#include <thread>
 
 namespace te
 {
@@ -32,6 +31,10 @@ namespace te
 				/// the possibility of implementations where these methods are given thread safety
 				/// and such, while keeping this basic class basic and free of any such additional 
 				/// overhead.
+				///
+				/// Messages are handed to the callbacks as they are. Within the Engine, the
+				/// callbacks are those of an EventPipeline, which tags messages with the thread
+				/// that reported them in debug builds and delivers them off of it.
 				/// </summary>
 				class EventReporter
 				{
@@ -114,13 +117,7 @@ namespace te
 					{
 						if (m_onInfo && infoMessage.data())
 						{
-							#ifndef NDEBUG
-								std::string m = u8"From Thread " + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
-								m.append(": ").append(infoMessage.to_string());
-								m_onInfo(m.c_str(), m.size());
-							#else
-								m_onInfo(infoMessage.begin(), infoMessage.size());
-							#endif
+							m_onInfo(infoMessage.begin(), infoMessage.size());
 						}
 					}
 
@@ -135,13 +132,7 @@ namespace te
 					{
 						if (m_onWarning && warningMessage.data())
 						{
-							#ifndef NDEBUG
-								std::string m = u8"From Thread " + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
-								m.append(": ").append(warningMessage.to_string());
-								m_onWarning(m.c_str(), m.size());
-							#else
-								m_onWarning(warningMessage.begin(), warningMessage.size());
-							#endif							
+							m_onWarning(warningMessage.begin(), warningMessage.size());
 						}
 					}
 
@@ -156,13 +147,7 @@ namespace te
 					{
 						if (m_onError && errorMessage.data())
 						{
-							#ifndef NDEBUG
-								std::string m = u8"From Thread " + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
-								m.append(": ").append(errorMessage.to_string());
-								m_onError(m.c_str(), m.size());
-							#else
-								m_onError(errorMessage.begin(), errorMessage.size());
-							#endif
+							m_onError(errorMessage.begin(), errorMessage.size());
 						}
 					}
 
@@ -0,0 +1,252 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "RuleTable.hpp"
+#include <algorithm>
+#include <limits>
+#include <boost/algorithm/string.hpp>
+#include "../hash/StringHashUtils.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				RuleTable::RuleTable()
+				{
+					m_ruleCount = 0;
+				}
+
+				RuleTable::~RuleTable()
+				{
+
+				}
+
+				void RuleTable::Load(const std::vector<Rule>& rules)
+				{
+					auto matcher = rules.size() > 0 ? Compile(rules) : nullptr;
+
+					std::lock_guard<std::mutex> lock(m_matcherMutex);
+
+					m_matcher = std::move(matcher);
+					m_ruleCount = rules.size();
+				}
+
+				void RuleTable::Clear()
+				{
+					std::lock_guard<std::mutex> lock(m_matcherMutex);
+
+					m_matcher.reset();
+					m_ruleCount = 0;
+				}
+
+				const bool RuleTable::Match(
+					boost::string_ref host,
+					boost::string_ref method,
+					const util::http::MediaKindSet mediaKinds,
+					const bool hasContentLength,
+					const uint64_t contentLength,
+					RuleAction& action
+					) const
+				{
+					if (m_ruleCount == 0)
+					{
+						return false;
+					}
+
+					std::shared_ptr<const Matcher> matcher;
+
+					{
+						std::lock_guard<std::mutex> lock(m_matcherMutex);
+						matcher = m_matcher;
+					}
+
+					if (matcher == nullptr)
+					{
+						return false;
+					}
+
+					// Rules are checked in order, so the first rule to match at any node along
+					// the way is only of interest if it comes before the best found so far.
+					uint32_t best = (std::numeric_limits<uint32_t>::max)();
+
+					auto consider = [&](const Node& node)
+					{
+						for (const auto index : node.rules)
+						{
+							if (index >= best)
+							{
+								break;
+							}
+
+							if (MatchesMessage(matcher->rules[index], method, mediaKinds, hasContentLength, contentLength))
+							{
+								best = index;
+								break;
+							}
+						}
+					};
+
+					consider(matcher->nodes.front());
+
+					if (host.size() > 0 && host.back() == '.')
+					{
+						host.remove_suffix(1);
+					}
+
+					// Walk the labels of the host from the last one to the first.
+					uint32_t node = 0;
+					size_t end = host.size();
+
+					while (end > 0)
+					{
+						size_t start = end;
+
+						while (start > 0 && host[start - 1] != '.')
+						{
+							--start;
+						}
+
+						node = FindChild(*matcher, node, host.substr(start, end - start));
+
+						if (node == 0)
+						{
+							break;
+						}
+
+						consider(matcher->nodes[node]);
+
+						if (start == 0)
+						{
+							break;
+						}
+
+						end = start - 1;
+					}
+
+					if (best == (std::numeric_limits<uint32_t>::max)())
+					{
+						return false;
+					}
+
+					action = matcher->rules[best].Action;
+
+					return true;
+				}
+
+				std::shared_ptr<const RuleTable::Matcher> RuleTable::Compile(const std::vector<Rule>& rules)
+				{
+					auto matcher = std::make_shared<Matcher>();
+
+					matcher->rules = rules;
+					matcher->nodes.emplace_back();
+
+					for (uint32_t index = 0; index < static_cast<uint32_t>(matcher->rules.size()); ++index)
+					{
+						auto& suffix = matcher->rules[index].HostSuffix;
+
+						boost::algorithm::to_lower(suffix);
+
+						if (boost::algorithm::starts_with(suffix, u8"*."))
+						{
+							suffix.erase(0, 2);
+						}
+
+						boost::algorithm::trim_if(suffix, boost::algorithm::is_any_of(u8"."));
+
+						boost::string_ref remaining(suffix);
+						uint32_t node = 0;
+
+						while (remaining.size() > 0)
+						{
+							auto dot = remaining.find_last_of('.');
+							auto label = dot == boost::string_ref::npos ? remaining : remaining.substr(dot + 1);
+
+							auto child = FindChild(*matcher, node, label);
+
+							if (child == 0)
+							{
+								child = static_cast<uint32_t>(matcher->nodes.size());
+
+								matcher->nodes.emplace_back();
+								matcher->nodes.back().label = label.to_string();
+								matcher->nodes[node].children.emplace(util::hash::ICaseHash(label.data(), label.size()), child);
+							}
+
+							node = child;
+							remaining = dot == boost::string_ref::npos ? boost::string_ref() : remaining.substr(0, dot);
+						}
+
+						// Indices go in ascending, as rules are taken in order.
+						matcher->nodes[node].rules.push_back(index);
+					}
+
+					return matcher;
+				}
+
+				const uint32_t RuleTable::FindChild(const Matcher& matcher, const uint32_t node, boost::string_ref label)
+				{
+					if (label.size() == 0)
+					{
+						return 0;
+					}
+
+					auto range = matcher.nodes[node].children.equal_range(util::hash::ICaseHash(label.data(), label.size()));
+
+					for (auto it = range.first; it != range.second; ++it)
+					{
+						if (util::hash::ICaseEquals(matcher.nodes[it->second].label, label))
+						{
+							return it->second;
+						}
+					}
+
+					return 0;
+				}
+
+				const bool RuleTable::MatchesMessage(
+					const Rule& rule,
+					boost::string_ref method,
+					const util::http::MediaKindSet mediaKinds,
+					const bool hasContentLength,
+					const uint64_t contentLength
+					)
+				{
+					if (rule.Method.size() > 0 && !util::hash::ICaseEquals(rule.Method, method))
+					{
+						return false;
+					}
+
+					if (rule.MediaKinds.any() && (rule.MediaKinds & mediaKinds).none())
+					{
+						return false;
+					}
+
+					if (rule.MinContentLength > 0 || rule.MaxContentLength > 0)
+					{
+						if (!hasContentLength || contentLength < rule.MinContentLength)
+						{
+							return false;
+						}
+
+						if (rule.MaxContentLength > 0 && contentLength > rule.MaxContentLength)
+						{
+							return false;
+						}
+					}
+
+					return true;
+				}
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,276 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "../http/MediaTypes.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				/// <summary>
+				/// What happens to a message matched by a rule.
+				/// </summary>
+				enum class RuleAction : uint32_t
+				{
+					/// <summary>
+					/// The message passes without inspection. Whatever follows in the same
+					/// transaction, such as the response to a request, is still checked. The same
+					/// as a begin callback next action of 0.
+					/// </summary>
+					Pass = 0,
+
+					/// <summary>
+					/// The message and the rest of its transaction pass without inspection. The
+					/// same as a begin callback next action of 3.
+					/// </summary>
+					PassWithoutInspect = 1,
+
+					/// <summary>
+					/// The transaction is blocked with a 204 No Content.
+					/// </summary>
+					Block204 = 2,
+
+					/// <summary>
+					/// The message goes to the callbacks, just as though no rule matched. Lets a
+					/// narrow rule carve an exception out of a broader one after it.
+					/// </summary>
+					CallBack = 3
+				};
+
+				/// <summary>
+				/// A single rule of the RuleTable. Every criterion left at its default matches
+				/// anything, and a rule matches a message when all of its criteria do.
+				/// </summary>
+				struct Rule
+				{
+					/// <summary>
+					/// What happens to the messages the rule matches.
+					/// </summary>
+					RuleAction Action = RuleAction::CallBack;
+
+					/// <summary>
+					/// Matches the host itself and any host under it, label by label, without
+					/// regard to case. "example.com" matches "example.com" and
+					/// "cdn.example.com", but not "badexample.com". A leading "*." or "." is
+					/// ignored.
+					/// </summary>
+					std::string HostSuffix;
+
+					/// <summary>
+					/// Matches the method of the request, without regard to case.
+					/// </summary>
+					std::string Method;
+
+					/// <summary>
+					/// Matches a message of any one of these kinds, as classified from its
+					/// content type. That's the response once there is one, the request before.
+					/// </summary>
+					util::http::MediaKindSet MediaKinds;
+
+					/// <summary>
+					/// Matches a message declaring a Content-Length of at least this. A message
+					/// that doesn't declare its length never matches a rule with a size.
+					/// </summary>
+					uint64_t MinContentLength = 0;
+
+					/// <summary>
+					/// Matches a message declaring a Content-Length of at most this. Zero for no
+					/// limit.
+					/// </summary>
+					uint64_t MaxContentLength = 0;
+				};
+
+				/// <summary>
+				/// The RuleTable answers, natively, for the traffic that the host always treats
+				/// the same way, so that the bridge doesn't have to call across the C API for it.
+				/// It is checked by every bridge ahead of the begin callback, for both the
+				/// request and the response headers. It is shared by every bridge, regardless of
+				/// protocol, and is safe to use from any thread.
+				///
+				/// Rules are checked in the order they were loaded, and the first one to match
+				/// decides. They are compiled on load into a trie of host labels, walked from the
+				/// top level domain down, so that a lookup only ever considers the rules for the
+				/// host's own suffixes, along with the rules for any host.
+				/// </summary>
+				class RuleTable
+				{
+
+				public:
+
+					/// <summary>
+					/// Constructs a new, empty RuleTable, which matches nothing.
+					/// </summary>
+					RuleTable();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					RuleTable(const RuleTable&) = delete;
+					RuleTable(RuleTable&&) = delete;
+					RuleTable& operator=(const RuleTable&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~RuleTable();
+
+					/// <summary>
+					/// Replaces every rule with the supplied rules. Lookups already under way
+					/// finish against the rules they started with.
+					/// </summary>
+					/// <param name="rules">
+					/// The rules, in the order they are to be checked.
+					/// </param>
+					void Load(const std::vector<Rule>& rules);
+
+					/// <summary>
+					/// Drops every rule.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Finds the first rule matching the supplied message.
+					/// </summary>
+					/// <param name="host">
+					/// The host of the request, without the port.
+					/// </param>
+					/// <param name="method">
+					/// The method of the request.
+					/// </param>
+					/// <param name="mediaKinds">
+					/// The kinds of media the message is.
+					/// </param>
+					/// <param name="hasContentLength">
+					/// Whether the message declares its length.
+					/// </param>
+					/// <param name="contentLength">
+					/// The length the message declares, if any.
+					/// </param>
+					/// <param name="action">
+					/// Receives the action of the rule, if one matched.
+					/// </param>
+					/// <returns>
+					/// True if a rule matched, false otherwise.
+					/// </returns>
+					const bool Match(
+						boost::string_ref host,
+						boost::string_ref method,
+						const util::http::MediaKindSet mediaKinds,
+						const bool hasContentLength,
+						const uint64_t contentLength,
+						RuleAction& action
+						) const;
+
+					/// <summary>
+					/// Gets the number of rules presently loaded.
+					/// </summary>
+					const size_t GetRuleCount() const
+					{
+						return m_ruleCount;
+					}
+
+				private:
+
+					/// <summary>
+					/// A node of the trie of host labels.
+					/// </summary>
+					struct Node
+					{
+						/// <summary>
+						/// The lower cased label leading to this node from its parent.
+						/// </summary>
+						std::string label;
+
+						/// <summary>
+						/// The children of this node, keyed by the case insensitive hash of their
+						/// label. Labels that collide are told apart by comparing them.
+						/// </summary>
+						std::unordered_multimap<uint32_t, uint32_t> children;
+
+						/// <summary>
+						/// The indices of the rules whose host suffix ends at this node, in
+						/// ascending order. At the root, the rules for any host.
+						/// </summary>
+						std::vector<uint32_t> rules;
+					};
+
+					/// <summary>
+					/// The compiled rules. Never modified once built, so that lookups can go on
+					/// without a lock while the rules are replaced.
+					/// </summary>
+					struct Matcher
+					{
+						std::vector<Rule> rules;
+
+						/// <summary>
+						/// The trie of host labels. The root is the first node.
+						/// </summary>
+						std::vector<Node> nodes;
+					};
+
+					/// <summary>
+					/// Compiles the supplied rules.
+					/// </summary>
+					static std::shared_ptr<const Matcher> Compile(const std::vector<Rule>& rules);
+
+					/// <summary>
+					/// Finds the child of the supplied node for the supplied label.
+					/// </summary>
+					/// <returns>
+					/// The index of the child, or zero if there is none, since the root is never
+					/// anyone's child.
+					/// </returns>
+					static const uint32_t FindChild(const Matcher& matcher, const uint32_t node, boost::string_ref label);
+
+					/// <summary>
+					/// Whether the supplied rule matches on everything but the host.
+					/// </summary>
+					static const bool MatchesMessage(
+						const Rule& rule,
+						boost::string_ref method,
+						const util::http::MediaKindSet mediaKinds,
+						const bool hasContentLength,
+						const uint64_t contentLength
+						);
+
+					/// <summary>
+					/// Guards m_matcher.
+					/// </summary>
+					mutable std::mutex m_matcherMutex;
+
+					/// <summary>
+					/// The compiled rules. Null when there are none.
+					/// </summary>
+					std::shared_ptr<const Matcher> m_matcher;
+
+					/// <summary>
+					/// Lets a lookup skip the lock entirely while there are no rules, which is
+					/// the case unless the host loads any.
+					/// </summary>
+					std::atomic<size_t> m_ruleCount;
+
+				};
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
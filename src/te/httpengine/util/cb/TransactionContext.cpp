@@ -0,0 +1,394 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "TransactionContext.hpp"
+#include <cassert>
+#include "../../mitm/http/HttpRequest.hpp"
+#include "../../mitm/http/HttpResponse.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				thread_local TransactionContext* TransactionContext::s_current = nullptr;
+
+				TransactionContext::CurrentScope::CurrentScope(TransactionContext* context)
+				{
+					m_previous = s_current;
+					s_current = context;
+				}
+
+				TransactionContext::CurrentScope::~CurrentScope()
+				{
+					s_current = m_previous;
+				}
+
+				namespace
+				{
+					/// <summary>
+					/// Gets the payload of the supplied transaction if it was held back in full.
+					/// </summary>
+					boost::string_ref InspectablePayload(const mitm::http::BaseHttpTransaction* transaction)
+					{
+						if (transaction == nullptr || !transaction->GetConsumeAllBeforeSending() || !transaction->IsPayloadComplete())
+						{
+							return boost::string_ref();
+						}
+
+						const auto& payload = transaction->GetPayload();
+
+						return boost::string_ref(payload.data(), payload.size());
+					}
+
+					const bool FirstValue(const mitm::http::HttpHeaderRangeMatch& header, boost::string_ref& value)
+					{
+						if (header.first == header.second)
+						{
+							return false;
+						}
+
+						value = header.first->second;
+
+						return true;
+					}
+
+					const bool FindHeader(const mitm::http::BaseHttpTransaction* transaction, boost::string_ref name, boost::string_ref& value)
+					{
+						return transaction != nullptr && FirstValue(transaction->GetHeader(name), value);
+					}
+
+					/// <summary>
+					/// Same as FindHeader(const mitm::http::BaseHttpTransaction*, boost::string_ref,
+					/// boost::string_ref&), for well known headers, which don't need their name
+					/// hashed.
+					/// </summary>
+					const bool FindHeader(const mitm::http::BaseHttpTransaction* transaction, const util::http::headers::KnownHeader& name, boost::string_ref& value)
+					{
+						return transaction != nullptr && FirstValue(transaction->GetHeader(name), value);
+					}
+				}
+
+				TransactionContext::TransactionContext(mitm::http::HttpRequest* request, mitm::http::HttpResponse* response)
+					:
+					m_request(request),
+					m_response(response)
+				{
+					#ifndef NDEBUG
+					assert(m_request != nullptr && u8"In TransactionContext::TransactionContext(mitm::http::HttpRequest*, mitm::http::HttpResponse*) - Supplied request is nullptr!");
+					#endif
+				}
+
+				TransactionContext::~TransactionContext()
+				{
+
+				}
+
+				boost::string_ref TransactionContext::GetMethod() const
+				{
+					return boost::string_ref(http_method_str(m_request->Method()));
+				}
+
+				boost::string_ref TransactionContext::GetHost() const
+				{
+					boost::string_ref host;
+
+					if (!FindHeader(m_request, util::http::headers::Host, host))
+					{
+						return boost::string_ref();
+					}
+
+					while (host.size() > 0 && (host.front() == ' ' || host.front() == '\t'))
+					{
+						host.remove_prefix(1);
+					}
+
+					while (host.size() > 0 && (host.back() == ' ' || host.back() == '\t'))
+					{
+						host.remove_suffix(1);
+					}
+
+					// An IPv6 literal carries colons of its own, so its port comes after the
+					// closing bracket.
+					auto portStart = host.size() > 0 && host.front() == '[' ? host.find(']') : 0;
+
+					if (portStart == boost::string_ref::npos)
+					{
+						return host;
+					}
+
+					auto portInd = host.substr(portStart).find(':');
+
+					if (portInd != boost::string_ref::npos)
+					{
+						host = host.substr(0, portStart + portInd);
+					}
+
+					return host;
+				}
+
+				boost::string_ref TransactionContext::GetPath() const
+				{
+					boost::string_ref uri(m_request->RequestURI());
+
+					// An absolute URI, as sent to proxies. The path begins at the first slash
+					// after the authority.
+					auto schemeEnd = uri.find(u8"://");
+
+					if (schemeEnd != boost::string_ref::npos && uri.find('/') > schemeEnd)
+					{
+						auto authority = uri.substr(schemeEnd + 3);
+						auto pathStart = authority.find('/');
+
+						return pathStart != boost::string_ref::npos ? authority.substr(pathStart) : boost::string_ref(u8"/");
+					}
+
+					return uri;
+				}
+
+				const bool TransactionContext::GetRequestHeader(boost::string_ref name, boost::string_ref& value) const
+				{
+					return FindHeader(m_request, name, value);
+				}
+
+				const bool TransactionContext::GetResponseHeader(boost::string_ref name, boost::string_ref& value) const
+				{
+					return FindHeader(m_response, name, value);
+				}
+
+				const uint32_t TransactionContext::GetMediaKinds() const
+				{
+					const mitm::http::BaseHttpTransaction* transaction = m_response;
+
+					if (transaction == nullptr)
+					{
+						transaction = m_request;
+					}
+
+					return static_cast<uint32_t>(transaction->GetMediaKinds().to_ulong());
+				}
+
+				const bool TransactionContext::GetContentLength(uint64_t& length) const
+				{
+					const mitm::http::BaseHttpTransaction* transaction = m_response;
+
+					if (transaction == nullptr)
+					{
+						transaction = m_request;
+					}
+
+					auto header = transaction->GetHeader(util::http::headers::ContentLength);
+
+					if (header.first == header.second)
+					{
+						return false;
+					}
+
+					boost::string_ref value(header.first->second);
+
+					while (value.size() > 0 && (value.front() == ' ' || value.front() == '\t'))
+					{
+						value.remove_prefix(1);
+					}
+
+					while (value.size() > 0 && (value.back() == ' ' || value.back() == '\t'))
+					{
+						value.remove_suffix(1);
+					}
+
+					// Twenty digits may already overflow, so anything longer is no length.
+					if (value.size() == 0 || value.size() > 19)
+					{
+						return false;
+					}
+
+					uint64_t parsed = 0;
+
+					for (const char c : value)
+					{
+						if (c < '0' || c > '9')
+						{
+							return false;
+						}
+
+						parsed = (parsed * 10) + static_cast<uint64_t>(c - '0');
+					}
+
+					length = parsed;
+
+					return true;
+				}
+
+				boost::string_ref TransactionContext::GetRequestPayload() const
+				{
+					return InspectablePayload(m_request);
+				}
+
+				boost::string_ref TransactionContext::GetResponsePayload() const
+				{
+					return InspectablePayload(m_response);
+				}
+
+				const std::string& TransactionContext::GetRequestHeaders()
+				{
+					if (!m_requestHeadersFormatted)
+					{
+						m_requestHeaders = m_request->HeadersToString();
+						m_requestHeadersFormatted = true;
+					}
+
+					return m_requestHeaders;
+				}
+
+				const std::string& TransactionContext::GetResponseHeaders()
+				{
+					if (!m_responseHeadersFormatted)
+					{
+						if (m_response != nullptr)
+						{
+							m_responseHeaders = m_response->HeadersToString();
+						}
+
+						m_responseHeadersFormatted = true;
+					}
+
+					return m_responseHeaders;
+				}
+
+				void TransactionContext::Write(const char* data, const uint32_t dataLength)
+				{
+					if (data == nullptr || dataLength == 0)
+					{
+						return;
+					}
+
+					TakeOwnershipOfGiven();
+
+					m_written.insert(m_written.end(), data, data + dataLength);
+				}
+
+				void TransactionContext::Reserve(const uint32_t capacity)
+				{
+					m_written.reserve(m_written.size() + m_givenLength + capacity);
+				}
+
+				void TransactionContext::Give(const char* data, const uint32_t dataLength, CustomResponseBufferRelease release)
+				{
+					if (data == nullptr)
+					{
+						return;
+					}
+
+					// Whatever happens, the caller has let go of the buffer, so it has to
+					// come back to them through the release callback.
+					std::shared_ptr<const char> given(data, [release, dataLength](const char* released)
+					{
+						if (release != nullptr)
+						{
+							release(released, dataLength);
+						}
+					});
+
+					if (dataLength == 0)
+					{
+						return;
+					}
+
+					m_written.clear();
+					m_given = std::move(given);
+					m_givenLength = dataLength;
+				}
+
+				const bool TransactionContext::HasBlockResponse() const
+				{
+					return m_given != nullptr || m_written.size() > 0;
+				}
+
+				std::shared_ptr<const char> TransactionContext::TakeBlockResponse(size_t& length)
+				{
+					length = 0;
+
+					if (m_given != nullptr)
+					{
+						length = m_givenLength;
+						m_givenLength = 0;
+						return std::move(m_given);
+					}
+
+					if (m_written.size() == 0)
+					{
+						return nullptr;
+					}
+
+					length = m_written.size();
+
+					auto owned = std::make_shared<std::vector<char>>(std::move(m_written));
+					m_written.clear();
+
+					return std::shared_ptr<const char>(owned, owned->data());
+				}
+
+				void TransactionContext::WriteToCurrent(const char* data, const uint32_t dataLength)
+				{
+					if (s_current != nullptr)
+					{
+						s_current->Write(data, dataLength);
+					}
+				}
+
+				void TransactionContext::AllowDeferral(DeferralFunction defer)
+				{
+					m_defer = std::move(defer);
+				}
+
+				const uint64_t TransactionContext::Defer()
+				{
+					if (m_deferredToken == 0 && m_defer)
+					{
+						m_deferredToken = m_defer();
+					}
+
+					return m_deferredToken;
+				}
+
+				const bool TransactionContext::IsDeferred() const
+				{
+					return m_deferredToken != 0;
+				}
+
+				void TransactionContext::CacheVerdict(const uint32_t ttlMilliseconds)
+				{
+					m_cacheVerdict = true;
+					m_cacheTtlMilliseconds = ttlMilliseconds;
+				}
+
+				const bool TransactionContext::ShouldCacheVerdict(uint32_t& ttlMilliseconds) const
+				{
+					ttlMilliseconds = m_cacheTtlMilliseconds;
+					return m_cacheVerdict;
+				}
+
+				void TransactionContext::TakeOwnershipOfGiven()
+				{
+					if (m_given == nullptr)
+					{
+						return;
+					}
+
+					m_written.assign(m_given.get(), m_given.get() + m_givenLength);
+					m_given.reset();
+					m_givenLength = 0;
+				}
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
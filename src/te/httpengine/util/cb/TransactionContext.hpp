@@ -0,0 +1,402 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+
+#include "EngineCallbackTypes.h"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace mitm
+		{
+			namespace http
+			{
+				class HttpRequest;
+				class HttpResponse;
+			} /* namespace http */
+		} /* namespace mitm */
+
+		namespace util
+		{
+			namespace cb
+			{
+
+				/// <summary>
+				/// What an HttpTransactionContext handed to the callbacks points to. Gives the
+				/// callbacks access to a single transaction, and collects the custom block response
+				/// that they write for it.
+				///
+				/// Everything is read straight from the request and response, so nothing is
+				/// copied or formatted unless a callback asks for the headers as a whole. Those
+				/// are formatted on first use and kept for the lifetime of the context.
+				///
+				/// The bridge keeps one on its stack for each round of callbacks it makes, so
+				/// there is nothing to claim and nothing shared between transactions. The block
+				/// response is either written into storage owned by the context, optionally
+				/// reserved up front, or is a buffer owned by the caller that is handed over
+				/// whole and sent without being copied.
+				///
+				/// When the bridge allows it, a callback may defer its verdict rather than
+				/// answer, in which case whatever it sets or writes is ignored, and the verdict
+				/// is delivered later through the engine with the token it was given.
+				/// </summary>
+				class TransactionContext
+				{
+
+				public:
+
+					/// <summary>
+					/// Registers a deferred verdict for the transaction, returning its token, or
+					/// zero if the verdict can't be deferred.
+					/// </summary>
+					using DeferralFunction = std::function<uint64_t()>;
+
+					/// <summary>
+					/// Makes the supplied context the one that ::WriteToCurrent(...) writes to on
+					/// the calling thread, for as long as this object lives. This is how the writer
+					/// given to the original callbacks, which don't take a context, finds where to
+					/// write.
+					/// </summary>
+					class CurrentScope
+					{
+
+					public:
+
+						explicit CurrentScope(TransactionContext* context);
+
+						/// <summary>
+						/// No copy no move no thx.
+						/// </summary>
+						CurrentScope(const CurrentScope&) = delete;
+						CurrentScope(CurrentScope&&) = delete;
+						CurrentScope& operator=(const CurrentScope&) = delete;
+
+						~CurrentScope();
+
+					private:
+
+						TransactionContext* m_previous;
+
+					};
+
+					/// <summary>
+					/// Constructs a context for the supplied transaction.
+					/// </summary>
+					/// <param name="request">
+					/// The request. Required.
+					/// </param>
+					/// <param name="response">
+					/// The response, if one has been read.
+					/// </param>
+					TransactionContext(mitm::http::HttpRequest* request, mitm::http::HttpResponse* response = nullptr);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					TransactionContext(const TransactionContext&) = delete;
+					TransactionContext(TransactionContext&&) = delete;
+					TransactionContext& operator=(const TransactionContext&) = delete;
+
+					/// <summary>
+					/// Default destructor. Releases a handed over buffer that was never taken.
+					/// </summary>
+					~TransactionContext();
+
+					/// <summary>
+					/// Gets the method of the request.
+					/// </summary>
+					/// <returns>
+					/// The method, as it appears in a request line.
+					/// </returns>
+					boost::string_ref GetMethod() const;
+
+					/// <summary>
+					/// Gets the host the request is for, from its host header, without the port.
+					/// </summary>
+					/// <returns>
+					/// The host, or an empty string if the request has no host header.
+					/// </returns>
+					boost::string_ref GetHost() const;
+
+					/// <summary>
+					/// Gets the path of the request, query included. When the request line has
+					/// an absolute URI, the scheme and authority are skipped.
+					/// </summary>
+					/// <returns>
+					/// The path of the request.
+					/// </returns>
+					boost::string_ref GetPath() const;
+
+					/// <summary>
+					/// Gets the value of the first request header with the supplied name.
+					/// </summary>
+					/// <param name="name">
+					/// The name of the header. Case insensitive.
+					/// </param>
+					/// <param name="value">
+					/// Set to the value of the header, if found.
+					/// </param>
+					/// <returns>
+					/// True if the header was found, false otherwise.
+					/// </returns>
+					const bool GetRequestHeader(boost::string_ref name, boost::string_ref& value) const;
+
+					/// <summary>
+					/// Same as ::GetRequestHeader(...), for the response. Never finds anything when
+					/// there is no response.
+					/// </summary>
+					const bool GetResponseHeader(boost::string_ref name, boost::string_ref& value) const;
+
+					/// <summary>
+					/// Gets the kinds of media the payload is, as classified from its content
+					/// type. That's the response payload when there is a response, the request
+					/// payload otherwise.
+					/// </summary>
+					/// <returns>
+					/// A mask with bit N set for each util::http::MediaKind of value N.
+					/// </returns>
+					const uint32_t GetMediaKinds() const;
+
+					/// <summary>
+					/// Gets the length the payload declares in its Content-Length header. That's
+					/// the response payload when there is a response, the request payload
+					/// otherwise.
+					/// </summary>
+					/// <param name="length">
+					/// Receives the declared length, if any.
+					/// </param>
+					/// <returns>
+					/// True if the payload declares a valid length, false otherwise.
+					/// </returns>
+					const bool GetContentLength(uint64_t& length) const;
+
+					/// <summary>
+					/// Gets the request payload, when it was held back in full for inspection.
+					/// </summary>
+					/// <returns>
+					/// The payload, or an empty string if it isn't available.
+					/// </returns>
+					boost::string_ref GetRequestPayload() const;
+
+					/// <summary>
+					/// Same as ::GetRequestPayload(), for the response.
+					/// </summary>
+					boost::string_ref GetResponsePayload() const;
+
+					/// <summary>
+					/// Gets the request headers, start line included, formatted on first use.
+					/// </summary>
+					/// <returns>
+					/// The formatted request headers.
+					/// </returns>
+					const std::string& GetRequestHeaders();
+
+					/// <summary>
+					/// Same as ::GetRequestHeaders(), for the response. Empty when there is no
+					/// response.
+					/// </summary>
+					const std::string& GetResponseHeaders();
+
+					/// <summary>
+					/// Appends the supplied data to the block response. If a buffer was handed
+					/// over, it's copied in first and released, so that the data is appended to
+					/// it.
+					/// </summary>
+					/// <param name="data">
+					/// The data to append.
+					/// </param>
+					/// <param name="dataLength">
+					/// The length of the data to append.
+					/// </param>
+					void Write(const char* data, const uint32_t dataLength);
+
+					/// <summary>
+					/// Makes room for the supplied number of bytes beyond what the block response
+					/// already holds, so that writing them later takes a single allocation.
+					/// </summary>
+					/// <param name="capacity">
+					/// The number of bytes about to be written.
+					/// </param>
+					void Reserve(const uint32_t capacity);
+
+					/// <summary>
+					/// Makes the supplied buffer the block response, replacing anything written
+					/// so far. The buffer is not copied. It must stay valid and unchanged until
+					/// the release callback is invoked with it or, if no release callback is
+					/// supplied, for as long as the Engine runs.
+					/// </summary>
+					/// <param name="data">
+					/// The complete block response, headers included.
+					/// </param>
+					/// <param name="dataLength">
+					/// The length of the block response.
+					/// </param>
+					/// <param name="release">
+					/// Called once the buffer is no longer needed. May be nullptr, for buffers
+					/// that are never freed, such as a constant block page.
+					/// </param>
+					void Give(const char* data, const uint32_t dataLength, CustomResponseBufferRelease release);
+
+					/// <summary>
+					/// Checks whether a block response was written or handed over.
+					/// </summary>
+					/// <returns>
+					/// True if there is a block response, false otherwise.
+					/// </returns>
+					const bool HasBlockResponse() const;
+
+					/// <summary>
+					/// Hands the block response over to the caller, leaving this context empty.
+					/// Whatever was written is moved, not copied, and a handed over buffer is
+					/// released once the last copy of the returned pointer is destroyed.
+					/// </summary>
+					/// <param name="length">
+					/// Set to the length of the block response.
+					/// </param>
+					/// <returns>
+					/// The block response, or nullptr if there is none.
+					/// </returns>
+					std::shared_ptr<const char> TakeBlockResponse(size_t& length);
+
+					/// <summary>
+					/// Writes to the context made current on the calling thread by a
+					/// CurrentScope. Does nothing if there is none. Has the signature of a
+					/// CustomResponseStreamWriter, and is the one given to the original
+					/// callbacks.
+					/// </summary>
+					/// <param name="data">
+					/// The data to append.
+					/// </param>
+					/// <param name="dataLength">
+					/// The length of the data to append.
+					/// </param>
+					static void WriteToCurrent(const char* data, const uint32_t dataLength);
+
+					/// <summary>
+					/// Lets the callbacks defer their verdict, through the supplied function.
+					/// Until this is called, ::Defer() always fails.
+					/// </summary>
+					/// <param name="defer">
+					/// Registers the deferred verdict.
+					/// </param>
+					void AllowDeferral(DeferralFunction defer);
+
+					/// <summary>
+					/// Defers the verdict for the transaction. Calling this again returns the
+					/// same token.
+					/// </summary>
+					/// <returns>
+					/// The token to deliver the verdict with, or zero if the verdict can't be
+					/// deferred, in which case the callback must answer as usual.
+					/// </returns>
+					const uint64_t Defer();
+
+					/// <summary>
+					/// Checks whether the verdict was deferred.
+					/// </summary>
+					/// <returns>
+					/// True if ::Defer() succeeded, false otherwise.
+					/// </returns>
+					const bool IsDeferred() const;
+
+					/// <summary>
+					/// Asks for the verdict that the begin callback sets for the request to be
+					/// cached, so that later requests for the same URL get it without a callback.
+					/// Only the begin callback for the request headers can cache its verdict, and
+					/// only when it doesn't defer it. Anywhere else this is ignored.
+					/// </summary>
+					/// <param name="ttlMilliseconds">
+					/// The number of milliseconds to keep the verdict. Zero for the default.
+					/// </param>
+					void CacheVerdict(const uint32_t ttlMilliseconds);
+
+					/// <summary>
+					/// Checks whether the callback asked for its verdict to be cached.
+					/// </summary>
+					/// <param name="ttlMilliseconds">
+					/// Set to the number of milliseconds the verdict is to be kept, if so.
+					/// </param>
+					/// <returns>
+					/// True if the verdict is to be cached, false otherwise.
+					/// </returns>
+					const bool ShouldCacheVerdict(uint32_t& ttlMilliseconds) const;
+
+				private:
+
+					/// <summary>
+					/// The context that ::WriteToCurrent(...) writes to on each thread.
+					/// </summary>
+					static thread_local TransactionContext* s_current;
+
+					/// <summary>
+					/// Copies a handed over buffer into m_written and releases it, so that it can
+					/// be appended to.
+					/// </summary>
+					void TakeOwnershipOfGiven();
+
+					mitm::http::HttpRequest* m_request;
+
+					mitm::http::HttpResponse* m_response;
+
+					/// <summary>
+					/// The formatted request headers, once formatted.
+					/// </summary>
+					std::string m_requestHeaders;
+
+					/// <summary>
+					/// The formatted response headers, once formatted.
+					/// </summary>
+					std::string m_responseHeaders;
+
+					bool m_requestHeadersFormatted = false;
+
+					bool m_responseHeadersFormatted = false;
+
+					/// <summary>
+					/// What was written through ::Write(...).
+					/// </summary>
+					std::vector<char> m_written;
+
+					/// <summary>
+					/// What was handed over through ::Give(...), releasing it when destroyed.
+					/// </summary>
+					std::shared_ptr<const char> m_given;
+
+					/// <summary>
+					/// The length of m_given.
+					/// </summary>
+					size_t m_givenLength = 0;
+
+					/// <summary>
+					/// What ::Defer() defers through, if allowed.
+					/// </summary>
+					DeferralFunction m_defer;
+
+					/// <summary>
+					/// The token of the deferred verdict, or zero.
+					/// </summary>
+					uint64_t m_deferredToken = 0;
+
+					bool m_cacheVerdict = false;
+
+					uint32_t m_cacheTtlMilliseconds = 0;
+
+				};
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
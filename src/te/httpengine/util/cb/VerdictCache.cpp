@@ -0,0 +1,225 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "VerdictCache.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				VerdictCache::VerdictCache(const size_t maxEntries, const bool keyByMethod)
+					:
+					m_maxEntries(maxEntries),
+					m_keyByMethod(keyByMethod)
+				{
+					m_hits = 0;
+					m_misses = 0;
+				}
+
+				VerdictCache::~VerdictCache()
+				{
+
+				}
+
+				bool VerdictCache::Lookup(
+					boost::string_ref host,
+					boost::string_ref method,
+					boost::string_ref path,
+					uint32_t& nextAction,
+					std::shared_ptr<const char>& blockResponse,
+					size_t& blockResponseLength
+					)
+				{
+					if (host.size() > 0)
+					{
+						std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+						if (m_entries.size() > 0)
+						{
+							BuildKey(host, method, path);
+
+							auto it = m_entries.find(m_key);
+							if (it != m_entries.end())
+							{
+								if (it->second.expires > std::chrono::steady_clock::now())
+								{
+									nextAction = it->second.nextAction;
+									blockResponse = it->second.blockResponse;
+									blockResponseLength = it->second.blockResponseLength;
+									++m_hits;
+									return true;
+								}
+
+								m_entries.erase(it);
+							}
+						}
+					}
+
+					++m_misses;
+					return false;
+				}
+
+				void VerdictCache::Store(
+					boost::string_ref host,
+					boost::string_ref method,
+					boost::string_ref path,
+					const uint32_t nextAction,
+					std::shared_ptr<const char> blockResponse,
+					const size_t blockResponseLength,
+					const uint32_t ttlMilliseconds
+					)
+				{
+					if (host.size() == 0)
+					{
+						return;
+					}
+
+					const auto now = std::chrono::steady_clock::now();
+					const auto expires = now + std::chrono::milliseconds(ttlMilliseconds > 0 ? ttlMilliseconds : DefaultTtlMilliseconds);
+
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+					if (m_maxEntries == 0)
+					{
+						return;
+					}
+
+					BuildKey(host, method, path);
+
+					auto it = m_entries.find(m_key);
+					if (it != m_entries.end())
+					{
+						it->second = Entry{ nextAction, std::move(blockResponse), blockResponseLength, expires };
+						return;
+					}
+
+					if (m_entries.size() >= m_maxEntries)
+					{
+						SweepExpired(now);
+
+						if (m_entries.size() >= m_maxEntries)
+						{
+							// Nothing has expired. Dropping an arbitrary entry costs that URL one
+							// trip to the callback, which isn't worth tracking recency for.
+							m_entries.erase(m_entries.begin());
+						}
+					}
+
+					m_entries.emplace(m_key, Entry{ nextAction, std::move(blockResponse), blockResponseLength, expires });
+				}
+
+				void VerdictCache::Invalidate(boost::string_ref host)
+				{
+					if (host.size() == 0)
+					{
+						return;
+					}
+
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+					BuildKey(host, boost::string_ref(), boost::string_ref());
+
+					// Every key for the host starts with the host and the separator that
+					// BuildKey(...) just put after it.
+					const size_t prefixLength = host.size() + 1;
+
+					for (auto it = m_entries.begin(); it != m_entries.end();)
+					{
+						if (it->first.compare(0, prefixLength, m_key, 0, prefixLength) == 0)
+						{
+							it = m_entries.erase(it);
+						}
+						else
+						{
+							++it;
+						}
+					}
+				}
+
+				void VerdictCache::Clear()
+				{
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+					m_entries.clear();
+				}
+
+				void VerdictCache::SetLimits(const size_t maxEntries, const bool keyByMethod)
+				{
+					std::lock_guard<std::mutex> lock(m_entriesMutex);
+
+					if (keyByMethod != m_keyByMethod || maxEntries == 0)
+					{
+						m_entries.clear();
+					}
+
+					while (m_entries.size() > maxEntries)
+					{
+						m_entries.erase(m_entries.begin());
+					}
+
+					m_maxEntries = maxEntries;
+					m_keyByMethod = keyByMethod;
+				}
+
+				VerdictCacheStats VerdictCache::GetStats() const
+				{
+					VerdictCacheStats stats;
+
+					stats.Hits = m_hits;
+					stats.Misses = m_misses;
+
+					{
+						std::lock_guard<std::mutex> lock(m_entriesMutex);
+						stats.Entries = static_cast<uint32_t>(m_entries.size());
+					}
+
+					return stats;
+				}
+
+				void VerdictCache::BuildKey(boost::string_ref host, boost::string_ref method, boost::string_ref path)
+				{
+					m_key.clear();
+
+					for (auto c : host)
+					{
+						m_key.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c);
+					}
+
+					m_key.push_back(' ');
+
+					if (m_keyByMethod && method.size() > 0)
+					{
+						m_key.append(method.data(), method.size());
+						m_key.push_back(' ');
+					}
+
+					m_key.append(path.data(), path.size());
+				}
+
+				void VerdictCache::SweepExpired(const std::chrono::steady_clock::time_point now)
+				{
+					for (auto it = m_entries.begin(); it != m_entries.end();)
+					{
+						if (it->second.expires <= now)
+						{
+							it = m_entries.erase(it);
+						}
+						else
+						{
+							++it;
+						}
+					}
+				}
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
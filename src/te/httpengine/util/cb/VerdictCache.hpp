@@ -0,0 +1,251 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/utility/string_ref.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace cb
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the verdict cache counters.
+				/// </summary>
+				struct VerdictCacheStats
+				{
+					/// <summary>
+					/// Total number of requests answered from the cache.
+					/// </summary>
+					uint64_t Hits = 0;
+
+					/// <summary>
+					/// Total number of requests that had to go to the begin callback.
+					/// </summary>
+					uint64_t Misses = 0;
+
+					/// <summary>
+					/// The number of verdicts presently cached.
+					/// </summary>
+					uint32_t Entries = 0;
+				};
+
+				/// <summary>
+				/// The VerdictCache remembers the begin callback verdicts that the host asked to
+				/// have cached, so that requests for the same URL are answered without calling
+				/// back into the host. It is shared by every bridge, regardless of protocol, and is
+				/// safe to use from any thread.
+				///
+				/// Verdicts are keyed by host, compared without regard to case and without the
+				/// port, and by path, query included, since a verdict may well depend on it.
+				/// Optionally, the method is part of the key as well. Each verdict lives for as
+				/// long as the host asked when it was cached.
+				/// </summary>
+				class VerdictCache
+				{
+
+				public:
+
+					/// <summary>
+					/// Default number of verdicts to keep.
+					/// </summary>
+					static constexpr size_t DefaultMaxEntries = 4096;
+
+					/// <summary>
+					/// Number of milliseconds a verdict is kept when the host doesn't say.
+					/// </summary>
+					static constexpr uint32_t DefaultTtlMilliseconds = 60000;
+
+					/// <summary>
+					/// Constructs a new, empty VerdictCache.
+					/// </summary>
+					/// <param name="maxEntries">
+					/// The maximum number of verdicts to keep. Zero disables the cache.
+					/// </param>
+					/// <param name="keyByMethod">
+					/// Whether the method of the request is part of the key.
+					/// </param>
+					VerdictCache(const size_t maxEntries = DefaultMaxEntries, const bool keyByMethod = false);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					VerdictCache(const VerdictCache&) = delete;
+					VerdictCache(VerdictCache&&) = delete;
+					VerdictCache& operator=(const VerdictCache&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~VerdictCache();
+
+					/// <summary>
+					/// Looks up the cached verdict for the supplied request.
+					/// </summary>
+					/// <param name="host">
+					/// The host of the request, without the port.
+					/// </param>
+					/// <param name="method">
+					/// The method of the request.
+					/// </param>
+					/// <param name="path">
+					/// The path of the request, query included.
+					/// </param>
+					/// <param name="nextAction">
+					/// Receives the cached next action, if any.
+					/// </param>
+					/// <param name="blockResponse">
+					/// Receives the cached custom block response, if any. Shared by every request
+					/// it answers, and never to be modified.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// Receives the length of the block response.
+					/// </param>
+					/// <returns>
+					/// True if an unexpired verdict was found, false otherwise.
+					/// </returns>
+					bool Lookup(
+						boost::string_ref host,
+						boost::string_ref method,
+						boost::string_ref path,
+						uint32_t& nextAction,
+						std::shared_ptr<const char>& blockResponse,
+						size_t& blockResponseLength
+						);
+
+					/// <summary>
+					/// Stores the supplied verdict for the supplied request, replacing any existing
+					/// entry.
+					/// </summary>
+					/// <param name="host">
+					/// The host of the request, without the port. Nothing is stored if empty.
+					/// </param>
+					/// <param name="method">
+					/// The method of the request.
+					/// </param>
+					/// <param name="path">
+					/// The path of the request, query included.
+					/// </param>
+					/// <param name="nextAction">
+					/// The next action the begin callback set.
+					/// </param>
+					/// <param name="blockResponse">
+					/// The custom block response, if any.
+					/// </param>
+					/// <param name="blockResponseLength">
+					/// The length of the block response.
+					/// </param>
+					/// <param name="ttlMilliseconds">
+					/// The number of milliseconds the verdict is kept. Zero for the default.
+					/// </param>
+					void Store(
+						boost::string_ref host,
+						boost::string_ref method,
+						boost::string_ref path,
+						const uint32_t nextAction,
+						std::shared_ptr<const char> blockResponse,
+						const size_t blockResponseLength,
+						const uint32_t ttlMilliseconds
+						);
+
+					/// <summary>
+					/// Drops every verdict cached for the supplied host.
+					/// </summary>
+					/// <param name="host">
+					/// The host, without the port.
+					/// </param>
+					void Invalidate(boost::string_ref host);
+
+					/// <summary>
+					/// Drops every cached verdict. Should be called whenever the rules behind the
+					/// begin callback change.
+					/// </summary>
+					void Clear();
+
+					/// <summary>
+					/// Sets the limits of the cache. Changing whether the method is part of the
+					/// key drops every cached verdict.
+					/// </summary>
+					/// <param name="maxEntries">
+					/// The maximum number of verdicts to keep. Zero disables the cache.
+					/// </param>
+					/// <param name="keyByMethod">
+					/// Whether the method of the request is part of the key.
+					/// </param>
+					void SetLimits(const size_t maxEntries, const bool keyByMethod);
+
+					/// <summary>
+					/// Gets a snapshot of the cache counters.
+					/// </summary>
+					/// <returns>
+					/// The current cache counters.
+					/// </returns>
+					VerdictCacheStats GetStats() const;
+
+				private:
+
+					struct Entry
+					{
+						uint32_t nextAction;
+						std::shared_ptr<const char> blockResponse;
+						size_t blockResponseLength;
+						std::chrono::steady_clock::time_point expires;
+					};
+
+					/// <summary>
+					/// Builds the key for the supplied request into m_key. Caller must hold
+					/// m_entriesMutex.
+					/// </summary>
+					void BuildKey(boost::string_ref host, boost::string_ref method, boost::string_ref path);
+
+					/// <summary>
+					/// Drops every expired entry. Caller must hold m_entriesMutex.
+					/// </summary>
+					void SweepExpired(const std::chrono::steady_clock::time_point now);
+
+					size_t m_maxEntries;
+
+					bool m_keyByMethod;
+
+					/// <summary>
+					/// Guards m_entries and m_key.
+					/// </summary>
+					mutable std::mutex m_entriesMutex;
+
+					/// <summary>
+					/// Keyed by the lower cased host, then the method when keyed by method, then
+					/// the path, separated by spaces, which none of them can contain.
+					/// </summary>
+					std::unordered_map<std::string, Entry> m_entries;
+
+					/// <summary>
+					/// Reused to build keys in, so that lookups don't allocate once it has grown.
+					/// </summary>
+					std::string m_key;
+
+					std::atomic_uint64_t m_hits;
+
+					std::atomic_uint64_t m_misses;
+
+				};
+
+			} /* namespace cb */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
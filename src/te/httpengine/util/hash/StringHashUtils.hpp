@@ -7,12 +7,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <cctype>
-#include <algorithm>
-#include <locale>
-#include <boost/algorithm/string.hpp>
-#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
 
 namespace te
 {
@@ -21,46 +19,130 @@ namespace te
 		namespace util
 		{
 			namespace hash
-			{				
-				struct ICaseStringHash
+			{
+
+				/// <summary>
+				/// Folds an ASCII upper case letter to lower case, leaving every other byte as
+				/// is. Everything we compare case insensitively, header names, host names,
+				/// media types, is ASCII, so there's no need to consult a locale.
+				/// </summary>
+				constexpr char FoldAscii(const char c)
 				{
-					size_t operator()(const std::string& str) const
-					{
-						std::size_t seed = 0;
-						std::locale locale;
+					return static_cast<char>(c | (static_cast<unsigned char>(c - 'A') < 26 ? 0x20 : 0));
+				}
 
-						for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
-						{
-							boost::hash_combine(seed, std::toupper(*it, locale));
-						}
+				/// <summary>
+				/// Case insensitive hash of an ASCII string. This is FNV-1a over the folded
+				/// bytes. Usable at compile time, so the hashes of well known strings can be
+				/// case labels or constants.
+				/// </summary>
+				/// <param name="data">
+				/// The string to hash.
+				/// </param>
+				/// <param name="length">
+				/// The length of the string.
+				/// </param>
+				/// <returns>
+				/// The hash of the string, the same for any casing of it.
+				/// </returns>
+				constexpr uint32_t ICaseHash(const char* data, const size_t length)
+				{
+					uint32_t hash = 2166136261u;
 
-						return seed;
+					for (size_t i = 0; i < length; ++i)
+					{
+						hash ^= static_cast<uint8_t>(FoldAscii(data[i]));
+						hash *= 16777619u;
 					}
-				};
 
-				struct ICaseStringEquality
+					return hash;
+				}
+
+				/// <summary>
+				/// Same as ::ICaseHash(const char*, const size_t), for a string literal.
+				/// </summary>
+				template<size_t N>
+				constexpr uint32_t ICaseHash(const char(&literal)[N])
 				{
-					bool operator()(const std::string& str1, const std::string& str2) const
+					return ICaseHash(literal, N - 1);
+				}
+
+				/// <summary>
+				/// Folds every ASCII upper case letter in the eight bytes of the supplied word to
+				/// lower case, all at once.
+				/// </summary>
+				inline uint64_t FoldAsciiWord(const uint64_t word)
+				{
+					const uint64_t ones = 0x0101010101010101ull;
+					const uint64_t highBits = 0x8080808080808080ull;
+
+					// For each byte below 0x80, the high bit of aboveA is set if it's 'A' or
+					// more, and the high bit of aboveZ is set if it's more than 'Z'.
+					const uint64_t low = word & ~highBits;
+					const uint64_t aboveA = low + (0x80 - 'A') * ones;
+					const uint64_t aboveZ = low + (0x80 - 'Z' - 1) * ones;
+					const uint64_t upper = (aboveA ^ aboveZ) & ~word & highBits;
+
+					return word | (upper >> 2);
+				}
+
+				/// <summary>
+				/// Case insensitive equality of two ASCII strings of the same length. Compares
+				/// eight bytes at a time.
+				/// </summary>
+				inline bool ICaseEquals(const char* one, const char* two, const size_t length)
+				{
+					size_t i = 0;
+
+					for (; i + 8 <= length; i += 8)
 					{
-						auto oneSize = str1.size();
-						auto twoSize = str2.size();
+						uint64_t a;
+						uint64_t b;
+						std::memcpy(&a, one + i, 8);
+						std::memcpy(&b, two + i, 8);
 
-						if (oneSize != twoSize)
+						if (FoldAsciiWord(a) != FoldAsciiWord(b))
 						{
 							return false;
 						}
+					}
 
-						std::locale locale;
-
-						if (std::toupper(str1[0], locale) != std::toupper(str2[0], locale))
+					for (; i < length; ++i)
+					{
+						if (FoldAscii(one[i]) != FoldAscii(two[i]))
 						{
 							return false;
 						}
+					}
+
+					return true;
+				}
 
-						return boost::algorithm::iequals(str1, str2, locale);
+				/// <summary>
+				/// Case insensitive equality of two ASCII strings.
+				/// </summary>
+				inline bool ICaseEquals(const boost::string_ref one, const boost::string_ref two)
+				{
+					return one.size() == two.size() && ICaseEquals(one.data(), two.data(), one.size());
+				}
+
+				struct ICaseStringHash
+				{
+					size_t operator()(const std::string& str) const
+					{
+						return ICaseHash(str.data(), str.size());
 					}
 				};
-			}
-		}
-	}
-}
\ No newline at end of file
+
+				struct ICaseStringEquality
+				{
+					bool operator()(const std::string& str1, const std::string& str2) const
+					{
+						return str1.size() == str2.size() && ICaseEquals(str1.data(), str2.data(), str1.size());
+					}
+				};
+
+			} /* namespace hash */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,225 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "HeaderTerminator.hpp"
+
+#include <cstdint>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define TE_HEADER_TERMINATOR_SSE2
+	#include <emmintrin.h>
+
+	#if defined(_MSC_VER)
+		#define TE_HEADER_TERMINATOR_AVX2
+		#include <intrin.h>
+		#include <immintrin.h>
+		#define TE_HEADER_TERMINATOR_AVX2_TARGET
+	#elif defined(__GNUC__)
+		#define TE_HEADER_TERMINATOR_AVX2
+		#include <immintrin.h>
+		#define TE_HEADER_TERMINATOR_AVX2_TARGET __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace http
+			{
+
+				namespace
+				{
+					/// <summary>
+					/// Given that data[i] is a line feed, gets the end of the blank line that
+					/// follows it, or zero if it isn't followed by one.
+					/// </summary>
+					inline size_t EndAt(const char* data, const size_t length, const size_t i)
+					{
+						if (i + 1 < length && data[i + 1] == '\n')
+						{
+							return i + 2;
+						}
+
+						if (i + 2 < length && data[i + 1] == '\r' && data[i + 2] == '\n')
+						{
+							return i + 3;
+						}
+
+						return 0;
+					}
+
+					inline uint32_t LowestSetBit(const uint32_t mask)
+					{
+						#if defined(_MSC_VER)
+						unsigned long index = 0;
+						_BitScanForward(&index, mask);
+						return static_cast<uint32_t>(index);
+						#else
+						return static_cast<uint32_t>(__builtin_ctz(mask));
+						#endif
+					}
+
+					size_t FindFrom(const char* data, const size_t length, size_t i)
+					{
+						for (; i < length; ++i)
+						{
+							if (data[i] == '\n')
+							{
+								auto end = EndAt(data, length, i);
+
+								if (end > 0)
+								{
+									return end;
+								}
+							}
+						}
+
+						return 0;
+					}
+
+					#ifdef TE_HEADER_TERMINATOR_SSE2
+					size_t FindHeadersEndSse2(const char* data, const size_t length)
+					{
+						const __m128i lf = _mm_set1_epi8('\n');
+						const __m128i cr = _mm_set1_epi8('\r');
+
+						size_t i = 0;
+
+						// Every lane looks two bytes ahead of itself, so stop while there are
+						// still two bytes past the vector to load.
+						for (; i + 16 + 2 <= length; i += 16)
+						{
+							const __m128i here = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+							const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+							const __m128i after = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+
+							const __m128i lfHere = _mm_cmpeq_epi8(here, lf);
+							const __m128i lfNext = _mm_cmpeq_epi8(next, lf);
+							const __m128i crlfNext = _mm_and_si128(_mm_cmpeq_epi8(next, cr), _mm_cmpeq_epi8(after, lf));
+
+							const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(lfHere, _mm_or_si128(lfNext, crlfNext))));
+
+							if (mask != 0)
+							{
+								return EndAt(data, length, i + LowestSetBit(mask));
+							}
+						}
+
+						return FindFrom(data, length, i);
+					}
+					#endif // TE_HEADER_TERMINATOR_SSE2
+
+					#ifdef TE_HEADER_TERMINATOR_AVX2
+					TE_HEADER_TERMINATOR_AVX2_TARGET
+					size_t FindHeadersEndAvx2(const char* data, const size_t length)
+					{
+						const __m256i lf = _mm256_set1_epi8('\n');
+						const __m256i cr = _mm256_set1_epi8('\r');
+
+						size_t i = 0;
+
+						for (; i + 32 + 2 <= length; i += 32)
+						{
+							const __m256i here = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+							const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+							const __m256i after = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+
+							const __m256i lfHere = _mm256_cmpeq_epi8(here, lf);
+							const __m256i lfNext = _mm256_cmpeq_epi8(next, lf);
+							const __m256i crlfNext = _mm256_and_si256(_mm256_cmpeq_epi8(next, cr), _mm256_cmpeq_epi8(after, lf));
+
+							const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(lfHere, _mm256_or_si256(lfNext, crlfNext))));
+
+							if (mask != 0)
+							{
+								return EndAt(data, length, i + LowestSetBit(mask));
+							}
+						}
+
+						return FindFrom(data, length, i);
+					}
+
+					bool HasAvx2()
+					{
+						#if defined(_MSC_VER)
+						int info[4] = { 0 };
+
+						__cpuid(info, 0);
+
+						if (info[0] < 7)
+						{
+							return false;
+						}
+
+						__cpuid(info, 1);
+
+						// AVX, and the OS saving the YMM registers for us.
+						const bool osxsave = (info[2] & (1 << 27)) != 0;
+						const bool avx = (info[2] & (1 << 28)) != 0;
+
+						if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+						{
+							return false;
+						}
+
+						__cpuidex(info, 7, 0);
+
+						return (info[1] & (1 << 5)) != 0;
+						#else
+						return __builtin_cpu_supports("avx2") != 0;
+						#endif
+					}
+					#endif // TE_HEADER_TERMINATOR_AVX2
+
+					typedef size_t (*FindHeadersEndFunction)(const char*, const size_t);
+
+					FindHeadersEndFunction SelectFindHeadersEnd()
+					{
+						#ifdef TE_HEADER_TERMINATOR_AVX2
+						if (HasAvx2())
+						{
+							return &FindHeadersEndAvx2;
+						}
+						#endif
+
+						#ifdef TE_HEADER_TERMINATOR_SSE2
+						return &FindHeadersEndSse2;
+						#else
+						return &FindHeadersEndScalar;
+						#endif
+					}
+				}
+
+				size_t FindHeadersEnd(const char* data, const size_t length)
+				{
+					static const FindHeadersEndFunction find = SelectFindHeadersEnd();
+
+					if (data == nullptr)
+					{
+						return 0;
+					}
+
+					return find(data, length);
+				}
+
+				size_t FindHeadersEndScalar(const char* data, const size_t length)
+				{
+					if (data == nullptr)
+					{
+						return 0;
+					}
+
+					return FindFrom(data, length, 0);
+				}
+
+			} /* namespace http */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
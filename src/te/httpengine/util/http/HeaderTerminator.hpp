@@ -0,0 +1,50 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace http
+			{
+
+				/// <summary>
+				/// Finds the blank line that ends a block of HTTP headers. Accepts the same line
+				/// endings http_parser does, so "\r\n\r\n", "\n\n" and "\n\r\n" all count.
+				///
+				/// Uses AVX2 when the processor has it, SSE2 otherwise, falling back to a plain
+				/// loop on targets that have neither. The choice is made once, on first use.
+				/// </summary>
+				/// <param name="data">
+				/// The bytes to search.
+				/// </param>
+				/// <param name="length">
+				/// The number of bytes to search.
+				/// </param>
+				/// <returns>
+				/// The number of bytes up to and including the end of the blank line, or zero if
+				/// there is no blank line in the supplied bytes.
+				/// </returns>
+				size_t FindHeadersEnd(const char* data, const size_t length);
+
+				/// <summary>
+				/// Same as ::FindHeadersEnd(const char*, const size_t), without any vector
+				/// instructions. Always available, and what the others defer to for the few
+				/// bytes at the end that don't fill a vector.
+				/// </summary>
+				size_t FindHeadersEndScalar(const char* data, const size_t length);
+
+			} /* namespace http */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,144 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "MediaTypes.hpp"
+#include "../hash/StringHashUtils.hpp"
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace http
+			{
+
+				namespace
+				{
+					MediaKindSet Kinds(const MediaKind kind)
+					{
+						return MediaKindSet().set(static_cast<size_t>(kind));
+					}
+
+					MediaKindSet Kinds(const MediaKind one, const MediaKind two)
+					{
+						return Kinds(one) | Kinds(two);
+					}
+
+					/// <summary>
+					/// Case insensitive substring search, for the handful of short needles we
+					/// fall back to.
+					/// </summary>
+					bool Contains(const boost::string_ref haystack, const boost::string_ref needle)
+					{
+						if (needle.size() > haystack.size())
+						{
+							return false;
+						}
+
+						for (size_t i = 0; i + needle.size() <= haystack.size(); ++i)
+						{
+							if (hash::FoldAscii(haystack[i]) == hash::FoldAscii(needle[0]) && hash::ICaseEquals(haystack.data() + i, needle.data(), needle.size()))
+							{
+								return true;
+							}
+						}
+
+						return false;
+					}
+
+					MediaKindSet ClassifyBySubstring(const boost::string_ref contentType)
+					{
+						MediaKindSet kinds;
+
+						kinds.set(static_cast<size_t>(MediaKind::Text), Contains(contentType, u8"text/"));
+						kinds.set(static_cast<size_t>(MediaKind::Html), Contains(contentType, u8"html"));
+						kinds.set(static_cast<size_t>(MediaKind::Json), Contains(contentType, u8"json"));
+						kinds.set(static_cast<size_t>(MediaKind::Image), Contains(contentType, u8"image/"));
+						kinds.set(static_cast<size_t>(MediaKind::Css), Contains(contentType, u8"css"));
+						kinds.set(static_cast<size_t>(MediaKind::Javascript), Contains(contentType, u8"javascript"));
+
+						return kinds;
+					}
+
+					/// <summary>
+					/// Cuts a Content-Type value down to the media type, without parameters or
+					/// surrounding whitespace.
+					/// </summary>
+					boost::string_ref MediaTypeOf(boost::string_ref contentType)
+					{
+						auto parameters = contentType.find(';');
+
+						if (parameters != boost::string_ref::npos)
+						{
+							contentType = contentType.substr(0, parameters);
+						}
+
+						while (contentType.size() > 0 && (contentType.front() == ' ' || contentType.front() == '\t'))
+						{
+							contentType.remove_prefix(1);
+						}
+
+						while (contentType.size() > 0 && (contentType.back() == ' ' || contentType.back() == '\t'))
+						{
+							contentType.remove_suffix(1);
+						}
+
+						return contentType;
+					}
+				}
+
+				MediaKindSet ClassifyContentType(const boost::string_ref contentType)
+				{
+					const auto mediaType = MediaTypeOf(contentType);
+
+					// The case labels are hashes computed at compile time, so a collision
+					// between any two of them is a duplicate case label, and won't build. A
+					// match still has to be confirmed, since an unknown type may share a hash.
+					#define TE_MEDIA_TYPE(literal, kinds) \
+						case hash::ICaseHash(literal): \
+							if (hash::ICaseEquals(mediaType, boost::string_ref(literal, sizeof(literal) - 1))) \
+							{ \
+								return kinds; \
+							} \
+							break;
+
+					switch (hash::ICaseHash(mediaType.data(), mediaType.size()))
+					{
+						TE_MEDIA_TYPE(u8"text/html", Kinds(MediaKind::Text, MediaKind::Html))
+						TE_MEDIA_TYPE(u8"text/plain", Kinds(MediaKind::Text))
+						TE_MEDIA_TYPE(u8"text/css", Kinds(MediaKind::Text, MediaKind::Css))
+						TE_MEDIA_TYPE(u8"text/javascript", Kinds(MediaKind::Text, MediaKind::Javascript))
+						TE_MEDIA_TYPE(u8"text/xml", Kinds(MediaKind::Text))
+						TE_MEDIA_TYPE(u8"text/csv", Kinds(MediaKind::Text))
+						TE_MEDIA_TYPE(u8"application/javascript", Kinds(MediaKind::Javascript))
+						TE_MEDIA_TYPE(u8"application/x-javascript", Kinds(MediaKind::Javascript))
+						TE_MEDIA_TYPE(u8"application/json", Kinds(MediaKind::Json))
+						TE_MEDIA_TYPE(u8"application/xhtml+xml", Kinds(MediaKind::Html))
+						TE_MEDIA_TYPE(u8"application/xml", MediaKindSet())
+						TE_MEDIA_TYPE(u8"application/octet-stream", MediaKindSet())
+						TE_MEDIA_TYPE(u8"application/x-www-form-urlencoded", MediaKindSet())
+						TE_MEDIA_TYPE(u8"image/png", Kinds(MediaKind::Image))
+						TE_MEDIA_TYPE(u8"image/jpeg", Kinds(MediaKind::Image))
+						TE_MEDIA_TYPE(u8"image/gif", Kinds(MediaKind::Image))
+						TE_MEDIA_TYPE(u8"image/webp", Kinds(MediaKind::Image))
+						TE_MEDIA_TYPE(u8"image/x-icon", Kinds(MediaKind::Image))
+						TE_MEDIA_TYPE(u8"image/svg+xml", Kinds(MediaKind::Image))
+
+						default:
+						break;
+					}
+
+					#undef TE_MEDIA_TYPE
+
+					return ClassifyBySubstring(contentType);
+				}
+
+			} /* namespace http */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
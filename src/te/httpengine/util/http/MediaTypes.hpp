@@ -0,0 +1,60 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <boost/utility/string_ref.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace http
+			{
+
+				/// <summary>
+				/// The broad kinds of payload the engine tells apart by Content-Type. A media type
+				/// may be more than one kind, for example "text/html" is both Text and Html.
+				/// </summary>
+				enum class MediaKind : size_t
+				{
+					Text,
+					Html,
+					Json,
+					Image,
+					Css,
+					Javascript,
+					Count
+				};
+
+				/// <summary>
+				/// A set of media kinds, indexed by MediaKind.
+				/// </summary>
+				typedef std::bitset<static_cast<size_t>(MediaKind::Count)> MediaKindSet;
+
+				/// <summary>
+				/// Classifies a Content-Type header value. Common media types are recognized
+				/// by a single hash lookup. Anything else is classified by the same substring
+				/// rules as before: "text/", "html", "json", "image/", "css" and "javascript"
+				/// anywhere in the value, matched case insensitively.
+				/// </summary>
+				/// <param name="contentType">
+				/// The Content-Type header value, parameters and all.
+				/// </param>
+				/// <returns>
+				/// The kinds the value names.
+				/// </returns>
+				MediaKindSet ClassifyContentType(const boost::string_ref contentType);
+
+			} /* namespace http */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,111 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "Arena.hpp"
+
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				Arena::Arena(const size_t blockSize)
+					:
+					m_blockSize((std::max)(blockSize, static_cast<size_t>(BufferPool::MinClassSize)))
+				{
+
+				}
+
+				Arena::~Arena()
+				{
+
+				}
+
+				void* Arena::Allocate(const size_t size, const size_t alignment)
+				{
+					const size_t required = (std::max)(size, static_cast<size_t>(1));
+
+					if (m_cursor != nullptr)
+					{
+						char* start = Align(m_cursor, alignment);
+
+						if (start <= m_end && static_cast<size_t>(m_end - start) >= required)
+						{
+							m_cursor = start + required;
+							m_bytesAllocated += required;
+							return start;
+						}
+					}
+
+					if (required > m_blockSize / 4)
+					{
+						// Big enough that starting a fresh block for it would mostly throw away
+						// what's left of the current one. It gets a block of its own, and the
+						// current block keeps serving small allocations.
+						auto& block = AddBlock(required + alignment);
+
+						m_bytesAllocated += required;
+						return Align(block->data(), alignment);
+					}
+
+					auto& block = AddBlock(m_blockSize);
+
+					m_cursor = block->data();
+					m_end = block->data() + block->size();
+
+					char* start = Align(m_cursor, alignment);
+					m_cursor = start + required;
+					m_bytesAllocated += required;
+
+					return start;
+				}
+
+				void Arena::Reset()
+				{
+					if (m_blocks.size() > 0 && m_blocks.front()->size() >= m_blockSize && m_blocks.front()->size() < m_blockSize * 2)
+					{
+						m_blocks.resize(1);
+						m_cursor = m_blocks.front()->data();
+						m_end = m_cursor + m_blocks.front()->size();
+					}
+					else
+					{
+						m_blocks.clear();
+						m_cursor = nullptr;
+						m_end = nullptr;
+					}
+
+					m_bytesAllocated = 0;
+				}
+
+				const size_t Arena::GetBytesReserved() const
+				{
+					size_t reserved = 0;
+
+					for (const auto& block : m_blocks)
+					{
+						reserved += block->size();
+					}
+
+					return reserved;
+				}
+
+				SharedBuffer& Arena::AddBlock(const size_t size)
+				{
+					m_blocks.push_back(BufferPool::Shared().Acquire(size));
+					return m_blocks.back();
+				}
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
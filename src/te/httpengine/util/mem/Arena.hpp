@@ -0,0 +1,235 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "BufferPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				/// <summary>
+				/// The Arena is a monotonic allocator for memory that all dies at once, such as
+				/// the parse state of a transaction. Allocations are carved out of blocks taken
+				/// from the BufferPool by bumping a cursor, and are never freed individually.
+				/// Everything is given back in one shot, either by ::Reset() or by destroying the
+				/// arena.
+				///
+				/// An arena is not thread safe. It's meant to belong to a single transaction,
+				/// which resets it between messages, and whose bridge never runs its handlers
+				/// concurrently.
+				/// </summary>
+				class Arena
+				{
+
+				public:
+
+					/// <summary>
+					/// Default size of the blocks the arena carves allocations from. Enough for
+					/// the headers of the vast majority of requests and responses.
+					/// </summary>
+					static constexpr size_t DefaultBlockSize = BufferPool::MinClassSize * 2;
+
+					/// <summary>
+					/// Constructs a new arena. No block is taken from the pool until the first
+					/// allocation.
+					/// </summary>
+					/// <param name="blockSize">
+					/// The size of the blocks to carve allocations from. Allocations larger than
+					/// a quarter of this get a block of their own.
+					/// </param>
+					Arena(const size_t blockSize = DefaultBlockSize);
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					Arena(const Arena&) = delete;
+					Arena(Arena&&) = delete;
+					Arena& operator=(const Arena&) = delete;
+
+					/// <summary>
+					/// Default destructor. Gives every block back to the pool.
+					/// </summary>
+					~Arena();
+
+					/// <summary>
+					/// Allocates memory from the arena.
+					/// </summary>
+					/// <param name="size">
+					/// The number of bytes required.
+					/// </param>
+					/// <param name="alignment">
+					/// The alignment required. Must be a power of two.
+					/// </param>
+					/// <returns>
+					/// The memory, valid until the arena is reset or destroyed.
+					/// </returns>
+					void* Allocate(const size_t size, const size_t alignment);
+
+					/// <summary>
+					/// Releases everything allocated so far. The first block is kept for the
+					/// allocations that follow, and all others go back to the pool. Anything
+					/// still pointing into the arena is invalid afterwards.
+					/// </summary>
+					void Reset();
+
+					/// <summary>
+					/// Gets the number of bytes handed out since the last reset.
+					/// </summary>
+					const size_t GetBytesAllocated() const
+					{
+						return m_bytesAllocated;
+					}
+
+					/// <summary>
+					/// Gets the number of bytes held in blocks taken from the pool.
+					/// </summary>
+					const size_t GetBytesReserved() const;
+
+				private:
+
+					/// <summary>
+					/// Takes a block of at least the supplied size from the pool.
+					/// </summary>
+					SharedBuffer& AddBlock(const size_t size);
+
+					/// <summary>
+					/// Aligns the supplied address up to the supplied alignment.
+					/// </summary>
+					static char* Align(char* address, const size_t alignment)
+					{
+						const uintptr_t value = reinterpret_cast<uintptr_t>(address);
+						return reinterpret_cast<char*>((value + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+					}
+
+					const size_t m_blockSize;
+
+					/// <summary>
+					/// Every block taken from the pool, the one being carved from included.
+					/// </summary>
+					std::vector<SharedBuffer> m_blocks;
+
+					/// <summary>
+					/// Where the next allocation from the current block starts.
+					/// </summary>
+					char* m_cursor = nullptr;
+
+					/// <summary>
+					/// The end of the current block.
+					/// </summary>
+					char* m_end = nullptr;
+
+					size_t m_bytesAllocated = 0;
+
+				};
+
+				/// <summary>
+				/// Standard allocator drawing from an Arena, so that containers can live in one.
+				/// Deallocation does nothing, since the arena frees everything at once. An
+				/// allocator without an arena falls back to the general heap, which keeps
+				/// containers default constructible.
+				/// </summary>
+				template<typename T>
+				class ArenaAllocator
+				{
+
+				public:
+
+					using value_type = T;
+
+					using propagate_on_container_copy_assignment = std::true_type;
+					using propagate_on_container_move_assignment = std::true_type;
+					using propagate_on_container_swap = std::true_type;
+
+					template<typename U>
+					struct rebind
+					{
+						using other = ArenaAllocator<U>;
+					};
+
+					ArenaAllocator() noexcept
+					{
+
+					}
+
+					ArenaAllocator(Arena* arena) noexcept
+						:
+						m_arena(arena)
+					{
+
+					}
+
+					template<typename U>
+					ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+						:
+						m_arena(other.GetArena())
+					{
+
+					}
+
+					T* allocate(const size_t n)
+					{
+						if (m_arena == nullptr)
+						{
+							return static_cast<T*>(::operator new(n * sizeof(T)));
+						}
+
+						return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+					}
+
+					void deallocate(T* p, const size_t) noexcept
+					{
+						if (m_arena == nullptr)
+						{
+							::operator delete(p);
+						}
+					}
+
+					Arena* GetArena() const noexcept
+					{
+						return m_arena;
+					}
+
+				private:
+
+					Arena* m_arena = nullptr;
+
+				};
+
+				template<typename T, typename U>
+				inline bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+				{
+					return lhs.GetArena() == rhs.GetArena();
+				}
+
+				template<typename T, typename U>
+				inline bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+				{
+					return lhs.GetArena() != rhs.GetArena();
+				}
+
+				/// <summary>
+				/// A vector whose storage lives in an Arena.
+				/// </summary>
+				template<typename T>
+				using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
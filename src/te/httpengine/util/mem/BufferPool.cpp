@@ -0,0 +1,228 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "BufferPool.hpp"
+
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				BufferPool& BufferPool::Shared()
+				{
+					static BufferPool pool;
+					return pool;
+				}
+
+				BufferPool::BufferPool()
+				{
+					m_maxPooledBytes = DefaultMaxPooledBytes;
+					m_acquired = 0;
+					m_reused = 0;
+					m_buffersInUse = 0;
+					m_bytesInUse = 0;
+					m_buffersPooled = 0;
+					m_bytesPooled = 0;
+				}
+
+				BufferPool::~BufferPool()
+				{
+					std::lock_guard<std::mutex> lock(m_freeMutex);
+
+					for (auto& list : m_free)
+					{
+						for (auto buffer : list)
+						{
+							delete buffer;
+						}
+
+						list.clear();
+					}
+				}
+
+				BufferPool::ThreadCache::~ThreadCache()
+				{
+					auto& pool = BufferPool::Shared();
+
+					for (auto& list : free)
+					{
+						for (auto buffer : list)
+						{
+							--pool.m_buffersPooled;
+							pool.m_bytesPooled -= buffer->size();
+							delete buffer;
+						}
+
+						list.clear();
+					}
+				}
+
+				BufferPool::ThreadCache& BufferPool::LocalCache()
+				{
+					static thread_local ThreadCache cache;
+					return cache;
+				}
+
+				size_t BufferPool::ClassOf(const size_t size)
+				{
+					size_t classIndex = 0;
+
+					while (classIndex < NumClasses && ClassSize(classIndex) < size)
+					{
+						++classIndex;
+					}
+
+					return classIndex;
+				}
+
+				size_t BufferPool::ClassSize(const size_t classIndex)
+				{
+					return MinClassSize << classIndex;
+				}
+
+				BufferPool::SharedBuffer BufferPool::Acquire(const size_t minSize)
+				{
+					++m_acquired;
+
+					const size_t classIndex = ClassOf(minSize);
+
+					if (classIndex >= NumClasses)
+					{
+						// Too big to pool. ::Release(...) will see that and just free it.
+						return Wrap(new Buffer(minSize));
+					}
+
+					Buffer* buffer = nullptr;
+
+					auto& local = LocalCache().free[classIndex];
+
+					if (local.size() > 0)
+					{
+						buffer = local.back();
+						local.pop_back();
+					}
+					else
+					{
+						std::lock_guard<std::mutex> lock(m_freeMutex);
+
+						auto& shared = m_free[classIndex];
+
+						if (shared.size() > 0)
+						{
+							buffer = shared.back();
+							shared.pop_back();
+							m_sharedBytes -= buffer->size();
+						}
+					}
+
+					if (buffer != nullptr)
+					{
+						++m_reused;
+						--m_buffersPooled;
+						m_bytesPooled -= buffer->size();
+						return Wrap(buffer);
+					}
+
+					return Wrap(new Buffer(ClassSize(classIndex)));
+				}
+
+				BufferPool::SharedBuffer BufferPool::Grow(const SharedBuffer& buffer, const size_t bytesUsed, const size_t maxSize)
+				{
+					if (buffer == nullptr || bytesUsed < buffer->size() || buffer->size() >= maxSize)
+					{
+						return buffer;
+					}
+
+					return Acquire((std::min)(buffer->size() * 2, maxSize));
+				}
+
+				void BufferPool::SetMaxPooledBytes(const uint64_t maxPooledBytes)
+				{
+					m_maxPooledBytes = maxPooledBytes;
+				}
+
+				BufferPoolStats BufferPool::GetStats() const
+				{
+					BufferPoolStats stats;
+
+					stats.Acquired = m_acquired;
+					stats.Reused = m_reused;
+					stats.BuffersInUse = m_buffersInUse;
+					stats.BytesInUse = m_bytesInUse;
+					stats.BuffersPooled = m_buffersPooled;
+					stats.BytesPooled = m_bytesPooled;
+
+					return stats;
+				}
+
+				BufferPool::SharedBuffer BufferPool::Wrap(Buffer* buffer)
+				{
+					++m_buffersInUse;
+					m_bytesInUse += buffer->size();
+
+					return SharedBuffer(buffer, [](Buffer* released)
+					{
+						BufferPool::Shared().Release(released);
+					});
+				}
+
+				void BufferPool::Release(Buffer* buffer)
+				{
+					if (buffer == nullptr)
+					{
+						return;
+					}
+
+					const size_t size = buffer->size();
+
+					--m_buffersInUse;
+					m_bytesInUse -= size;
+
+					const size_t classIndex = ClassOf(size);
+
+					if (classIndex >= NumClasses || ClassSize(classIndex) != size)
+					{
+						delete buffer;
+						return;
+					}
+
+					auto& local = LocalCache().free[classIndex];
+
+					if (local.size() < ThreadCacheDepth)
+					{
+						local.push_back(buffer);
+						++m_buffersPooled;
+						m_bytesPooled += size;
+						return;
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(m_freeMutex);
+
+						if (m_sharedBytes + size <= m_maxPooledBytes)
+						{
+							m_free[classIndex].push_back(buffer);
+							m_sharedBytes += size;
+							++m_buffersPooled;
+							m_bytesPooled += size;
+							return;
+						}
+					}
+
+					delete buffer;
+				}
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
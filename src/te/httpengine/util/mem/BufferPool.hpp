@@ -0,0 +1,263 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the occupancy of the buffer pool.
+				/// </summary>
+				struct BufferPoolStats
+				{
+					/// <summary>
+					/// Total number of buffers handed out.
+					/// </summary>
+					uint64_t Acquired = 0;
+
+					/// <summary>
+					/// Total number of buffers handed out that were recycled rather than
+					/// freshly allocated.
+					/// </summary>
+					uint64_t Reused = 0;
+
+					/// <summary>
+					/// The number of buffers presently held by bridges and transactions.
+					/// </summary>
+					uint32_t BuffersInUse = 0;
+
+					/// <summary>
+					/// The number of bytes presently held by bridges and transactions.
+					/// </summary>
+					uint64_t BytesInUse = 0;
+
+					/// <summary>
+					/// The number of idle buffers presently kept for reuse, including those in
+					/// the per thread caches.
+					/// </summary>
+					uint32_t BuffersPooled = 0;
+
+					/// <summary>
+					/// The number of bytes presently kept for reuse, including those in the per
+					/// thread caches.
+					/// </summary>
+					uint64_t BytesPooled = 0;
+				};
+
+				/// <summary>
+				/// The BufferPool recycles the I/O buffers used by bridges and transactions, so
+				/// that a flow only holds as much memory as its traffic actually needs. Buffers
+				/// come in power of two size classes. Callers start with a small buffer and move
+				/// up a class each time a read fills the buffer they have, so bulk transfers
+				/// still get large reads while idle flows stay cheap.
+				///
+				/// Released buffers are first kept in a small cache local to the releasing
+				/// thread, which serves the next acquire on that thread without locking. Only
+				/// when that cache is full do they go to the shared lists, which are capped by
+				/// total size.
+				///
+				/// There is a single pool for the process, since buffers are released wherever
+				/// the last handler holding them happens to run.
+				/// </summary>
+				class BufferPool
+				{
+
+				public:
+
+					using Buffer = std::vector<char>;
+
+					/// <summary>
+					/// A pooled buffer. The buffer goes back to the pool when the last copy is
+					/// destroyed. Its size is the size of its class, which is at least the size
+					/// requested.
+					/// </summary>
+					using SharedBuffer = std::shared_ptr<Buffer>;
+
+					/// <summary>
+					/// The size of the smallest class.
+					/// </summary>
+					static constexpr size_t MinClassSize = 4096;
+
+					/// <summary>
+					/// The number of size classes. The largest is MinClassSize << (NumClasses -
+					/// 1), aka 1MB. Larger requests are served, but not pooled.
+					/// </summary>
+					static constexpr size_t NumClasses = 9;
+
+					/// <summary>
+					/// The number of buffers of each class kept in the cache of each thread.
+					/// </summary>
+					static constexpr size_t ThreadCacheDepth = 4;
+
+					/// <summary>
+					/// Default limit on the total size of the buffers kept in the shared lists.
+					/// </summary>
+					static constexpr uint64_t DefaultMaxPooledBytes = 33554432;
+
+					/// <summary>
+					/// Gets the pool for the process.
+					/// </summary>
+					/// <returns>
+					/// The pool.
+					/// </returns>
+					static BufferPool& Shared();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					BufferPool(const BufferPool&) = delete;
+					BufferPool(BufferPool&&) = delete;
+					BufferPool& operator=(const BufferPool&) = delete;
+
+					/// <summary>
+					/// Default destructor. Frees all pooled buffers.
+					/// </summary>
+					~BufferPool();
+
+					/// <summary>
+					/// Gets a buffer of at least the supplied size.
+					/// </summary>
+					/// <param name="minSize">
+					/// The minimum size of the buffer.
+					/// </param>
+					/// <returns>
+					/// The buffer. Its contents are unspecified.
+					/// </returns>
+					SharedBuffer Acquire(const size_t minSize);
+
+					/// <summary>
+					/// Moves the supplied buffer up a size class if the last read filled it.
+					/// </summary>
+					/// <param name="buffer">
+					/// The buffer that was read into.
+					/// </param>
+					/// <param name="bytesUsed">
+					/// The number of bytes the last read put in the buffer.
+					/// </param>
+					/// <param name="maxSize">
+					/// The size beyond which the buffer should not grow.
+					/// </param>
+					/// <returns>
+					/// A larger buffer if the supplied one was filled and is smaller than
+					/// maxSize, the supplied buffer otherwise. The contents of a larger buffer
+					/// are unspecified.
+					/// </returns>
+					SharedBuffer Grow(const SharedBuffer& buffer, const size_t bytesUsed, const size_t maxSize);
+
+					/// <summary>
+					/// Sets the limit on the total size of the buffers kept in the shared lists.
+					/// Buffers already pooled beyond the new limit are freed as they're reused.
+					/// </summary>
+					/// <param name="maxPooledBytes">
+					/// The limit, in bytes.
+					/// </param>
+					void SetMaxPooledBytes(const uint64_t maxPooledBytes);
+
+					/// <summary>
+					/// Gets a snapshot of the occupancy of the pool.
+					/// </summary>
+					/// <returns>
+					/// The current occupancy of the pool.
+					/// </returns>
+					BufferPoolStats GetStats() const;
+
+				private:
+
+					using FreeLists = std::array<std::vector<Buffer*>, NumClasses>;
+
+					/// <summary>
+					/// Buffers cached by a single thread. Frees them when the thread ends.
+					/// </summary>
+					struct ThreadCache
+					{
+						FreeLists free;
+
+						~ThreadCache();
+					};
+
+					/// <summary>
+					/// Private, use ::Shared().
+					/// </summary>
+					BufferPool();
+
+					/// <summary>
+					/// Gets the cache of the calling thread.
+					/// </summary>
+					static ThreadCache& LocalCache();
+
+					/// <summary>
+					/// Gets the index of the smallest class that holds the supplied size, or
+					/// NumClasses if no class does.
+					/// </summary>
+					static size_t ClassOf(const size_t size);
+
+					/// <summary>
+					/// Gets the size of the buffers in the supplied class.
+					/// </summary>
+					static size_t ClassSize(const size_t classIndex);
+
+					/// <summary>
+					/// Takes back a buffer whose last holder has let go of it.
+					/// </summary>
+					void Release(Buffer* buffer);
+
+					/// <summary>
+					/// Wraps the supplied buffer so that it comes back to us when released.
+					/// </summary>
+					SharedBuffer Wrap(Buffer* buffer);
+
+					/// <summary>
+					/// Guards m_free.
+					/// </summary>
+					std::mutex m_freeMutex;
+
+					/// <summary>
+					/// Shared lists of idle buffers, one per class.
+					/// </summary>
+					FreeLists m_free;
+
+					/// <summary>
+					/// Total size of the buffers in m_free. Guarded by m_freeMutex.
+					/// </summary>
+					uint64_t m_sharedBytes = 0;
+
+					std::atomic_uint64_t m_maxPooledBytes;
+
+					std::atomic_uint64_t m_acquired;
+
+					std::atomic_uint64_t m_reused;
+
+					std::atomic_uint32_t m_buffersInUse;
+
+					std::atomic_uint64_t m_bytesInUse;
+
+					std::atomic_uint32_t m_buffersPooled;
+
+					std::atomic_uint64_t m_bytesPooled;
+
+				};
+
+				using SharedBuffer = BufferPool::SharedBuffer;
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
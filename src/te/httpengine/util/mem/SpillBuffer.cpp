@@ -0,0 +1,384 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "SpillBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if BOOST_OS_WINDOWS
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				namespace
+				{
+					/// <summary>
+					/// Temp files grow in steps of this, which is the allocation granularity of
+					/// views on Windows.
+					/// </summary>
+					static constexpr size_t FileGranularity = 65536;
+
+					inline size_t RoundToGranularity(const size_t size)
+					{
+						return ((size + FileGranularity - 1) / FileGranularity) * FileGranularity;
+					}
+				}
+
+				std::atomic<size_t> SpillBuffer::s_spillThreshold{ SpillBuffer::DefaultSpillThreshold };
+
+				std::atomic<uint64_t> SpillBuffer::s_maxBytesInMemory{ SpillBuffer::DefaultMaxBytesInMemory };
+
+				std::atomic<uint64_t> SpillBuffer::s_bytesInMemory{ 0 };
+
+				std::atomic<uint64_t> SpillBuffer::s_bytesOnDisk{ 0 };
+
+				std::atomic<uint64_t> SpillBuffer::s_spills{ 0 };
+
+				std::atomic<uint64_t> SpillBuffer::s_spillFailures{ 0 };
+
+				void SpillBuffer::SetLimits(const size_t spillThreshold, const uint64_t maxBytesInMemory)
+				{
+					s_spillThreshold = spillThreshold;
+					s_maxBytesInMemory = maxBytesInMemory;
+				}
+
+				SpillBufferStats SpillBuffer::GetStats()
+				{
+					SpillBufferStats stats;
+
+					stats.BytesInMemory = s_bytesInMemory;
+					stats.BytesOnDisk = s_bytesOnDisk;
+					stats.Spills = s_spills;
+					stats.SpillFailures = s_spillFailures;
+
+					return stats;
+				}
+
+				SpillBuffer::SpillBuffer()
+				{
+
+				}
+
+				SpillBuffer::~SpillBuffer()
+				{
+					CloseFile();
+
+					m_memory.clear();
+					m_memory.shrink_to_fit();
+					AccountMemory();
+				}
+
+				SpillBuffer& SpillBuffer::operator=(std::vector<char>&& other)
+				{
+					CloseFile();
+
+					if (ShouldSpill(other.size()))
+					{
+						m_memory.clear();
+
+						if (Spill(other.size()))
+						{
+							std::memcpy(m_view, other.data(), other.size());
+							m_size = other.size();
+
+							std::vector<char>().swap(other);
+							return *this;
+						}
+					}
+
+					m_memory = std::move(other);
+					AccountMemory();
+
+					return *this;
+				}
+
+				void SpillBuffer::reserve(const size_t required)
+				{
+					if (required <= capacity())
+					{
+						return;
+					}
+
+					const size_t grown = (std::max)(required, capacity() * 2);
+
+					if (m_view != nullptr)
+					{
+						if (!Map(grown))
+						{
+							// The mapping is gone, and with it any way to get at the contents.
+							CloseFile();
+							throw std::runtime_error(u8"In SpillBuffer::reserve(const size_t) - Failed to grow the mapped payload file.");
+						}
+
+						return;
+					}
+
+					if (ShouldSpill(grown) && Spill(grown))
+					{
+						return;
+					}
+
+					m_memory.reserve(grown);
+					AccountMemory();
+				}
+
+				void SpillBuffer::clear()
+				{
+					if (m_view != nullptr)
+					{
+						CloseFile();
+						return;
+					}
+
+					m_memory.clear();
+				}
+
+				void SpillBuffer::append(const char* data, const size_t length)
+				{
+					if (length == 0)
+					{
+						return;
+					}
+
+					reserve(size() + length);
+
+					if (m_view != nullptr)
+					{
+						std::memcpy(m_view + m_size, data, length);
+						m_size += length;
+						return;
+					}
+
+					m_memory.insert(m_memory.end(), data, data + length);
+				}
+
+				void SpillBuffer::assign(const char* first, const char* last)
+				{
+					clear();
+					append(first, static_cast<size_t>(last - first));
+				}
+
+				void SpillBuffer::swap(SpillBuffer& other)
+				{
+					// What each buffer has counted in the totals moves along with what it holds,
+					// so the totals stay as they are.
+					m_memory.swap(other.m_memory);
+					std::swap(m_accounted, other.m_accounted);
+					std::swap(m_view, other.m_view);
+					std::swap(m_viewCapacity, other.m_viewCapacity);
+					std::swap(m_size, other.m_size);
+					std::swap(m_file, other.m_file);
+
+					#if BOOST_OS_WINDOWS
+						std::swap(m_mapping, other.m_mapping);
+					#endif
+				}
+
+				const bool SpillBuffer::ShouldSpill(const size_t capacity) const
+				{
+					const size_t threshold = s_spillThreshold;
+
+					if (threshold == 0)
+					{
+						return false;
+					}
+
+					if (capacity >= threshold)
+					{
+						return true;
+					}
+
+					const uint64_t growth = capacity > m_memory.capacity() ? capacity - m_memory.capacity() : 0;
+
+					return capacity >= MinSpillSize && s_bytesInMemory + growth > s_maxBytesInMemory;
+				}
+
+				const bool SpillBuffer::Spill(const size_t capacity)
+				{
+					#if BOOST_OS_WINDOWS
+						wchar_t directory[MAX_PATH + 1];
+						wchar_t path[MAX_PATH + 1];
+
+						const DWORD directoryLength = GetTempPathW(MAX_PATH + 1, directory);
+
+						if (directoryLength > 0 && directoryLength <= MAX_PATH && GetTempFileNameW(directory, L"hfe", 0, path) != 0)
+						{
+							// The name was only needed to create the file. With delete on close, it
+							// goes away with the last handle, however the process ends.
+							HANDLE file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+
+							if (file != INVALID_HANDLE_VALUE)
+							{
+								m_file = file;
+							}
+							else
+							{
+								DeleteFileW(path);
+							}
+						}
+					#else
+						char path[] = u8"/tmp/hfe-payload-XXXXXX";
+
+						const int file = mkstemp(path);
+
+						if (file != -1)
+						{
+							// Unlinked right away, so it goes away with the descriptor.
+							unlink(path);
+							m_file = file;
+						}
+					#endif
+
+					if (!IsFileOpen() || !Map(capacity))
+					{
+						CloseFile();
+						++s_spillFailures;
+						return false;
+					}
+
+					m_size = m_memory.size();
+
+					if (m_size > 0)
+					{
+						std::memcpy(m_view, m_memory.data(), m_size);
+					}
+
+					std::vector<char>().swap(m_memory);
+					AccountMemory();
+
+					++s_spills;
+
+					return true;
+				}
+
+				const bool SpillBuffer::IsFileOpen() const
+				{
+					#if BOOST_OS_WINDOWS
+						return m_file != nullptr;
+					#else
+						return m_file != -1;
+					#endif
+				}
+
+				const bool SpillBuffer::Map(const size_t capacity)
+				{
+					const size_t mapped = RoundToGranularity(capacity);
+
+					Unmap();
+
+					#if BOOST_OS_WINDOWS
+						const uint64_t mappedSize = static_cast<uint64_t>(mapped);
+
+						// Mapping more than the file holds grows the file to match.
+						m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappedSize >> 32), static_cast<DWORD>(mappedSize & 0xFFFFFFFF), nullptr);
+
+						if (m_mapping == nullptr)
+						{
+							return false;
+						}
+
+						m_view = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, mapped));
+					#else
+						if (ftruncate(m_file, static_cast<off_t>(mapped)) != 0)
+						{
+							return false;
+						}
+
+						void* view = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+
+						m_view = view != MAP_FAILED ? static_cast<char*>(view) : nullptr;
+					#endif
+
+					if (m_view == nullptr)
+					{
+						return false;
+					}
+
+					m_viewCapacity = mapped;
+					s_bytesOnDisk += mapped;
+
+					return true;
+				}
+
+				void SpillBuffer::Unmap()
+				{
+					if (m_view != nullptr)
+					{
+						#if BOOST_OS_WINDOWS
+							UnmapViewOfFile(m_view);
+						#else
+							munmap(m_view, m_viewCapacity);
+						#endif
+
+						s_bytesOnDisk -= m_viewCapacity;
+
+						m_view = nullptr;
+						m_viewCapacity = 0;
+					}
+
+					#if BOOST_OS_WINDOWS
+						if (m_mapping != nullptr)
+						{
+							CloseHandle(m_mapping);
+							m_mapping = nullptr;
+						}
+					#endif
+				}
+
+				void SpillBuffer::CloseFile()
+				{
+					Unmap();
+
+					if (IsFileOpen())
+					{
+						#if BOOST_OS_WINDOWS
+							CloseHandle(m_file);
+							m_file = nullptr;
+						#else
+							close(m_file);
+							m_file = -1;
+						#endif
+					}
+
+					m_size = 0;
+				}
+
+				void SpillBuffer::AccountMemory()
+				{
+					const size_t held = m_memory.capacity();
+
+					if (held > m_accounted)
+					{
+						s_bytesInMemory += held - m_accounted;
+					}
+					else
+					{
+						s_bytesInMemory -= m_accounted - held;
+					}
+
+					m_accounted = held;
+				}
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
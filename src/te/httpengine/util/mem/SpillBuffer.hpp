@@ -0,0 +1,268 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <boost/predef/os.h>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace mem
+			{
+
+				/// <summary>
+				/// Point in time snapshot of the payload bytes held by every spill buffer.
+				/// </summary>
+				struct SpillBufferStats
+				{
+					/// <summary>
+					/// The number of bytes presently reserved in memory.
+					/// </summary>
+					uint64_t BytesInMemory = 0;
+
+					/// <summary>
+					/// The number of bytes presently reserved in mapped temp files.
+					/// </summary>
+					uint64_t BytesOnDisk = 0;
+
+					/// <summary>
+					/// Total number of buffers moved to a mapped temp file.
+					/// </summary>
+					uint64_t Spills = 0;
+
+					/// <summary>
+					/// Total number of times a buffer should have moved to a mapped temp file,
+					/// but couldn't, and stayed in memory instead.
+					/// </summary>
+					uint64_t SpillFailures = 0;
+				};
+
+				/// <summary>
+				/// The SpillBuffer holds a payload that may grow large. It starts out in memory,
+				/// and moves to a memory mapped temp file once it grows past the spill threshold,
+				/// or once the total held in memory by every spill buffer would pass the memory
+				/// limit. Either way, the contents stay contiguous and addressable through
+				/// ::data(), so code written against a vector keeps working.
+				///
+				/// Methods use container style names, so that the buffer can stand in for the
+				/// vector it replaces. Like with a vector, growing the buffer may move its
+				/// contents, invalidating earlier pointers into it.
+				///
+				/// Temp files are deleted as soon as they're closed, which the OS also does for
+				/// a process that dies, so nothing is left behind on disk.
+				/// </summary>
+				class SpillBuffer
+				{
+
+				public:
+
+					/// <summary>
+					/// Default size past which a buffer moves to disk.
+					/// </summary>
+					static constexpr size_t DefaultSpillThreshold = 4194304;
+
+					/// <summary>
+					/// Default limit on the bytes held in memory by every buffer together.
+					/// </summary>
+					static constexpr uint64_t DefaultMaxBytesInMemory = 268435456;
+
+					/// <summary>
+					/// Buffers smaller than this stay in memory even past the memory limit,
+					/// since mapping them would cost more than they weigh.
+					/// </summary>
+					static constexpr size_t MinSpillSize = 65536;
+
+					/// <summary>
+					/// Sets the limits that decide when buffers move to disk. Applies to every
+					/// buffer from its next growth on.
+					/// </summary>
+					/// <param name="spillThreshold">
+					/// The size past which a buffer moves to disk. Zero to keep every buffer in
+					/// memory.
+					/// </param>
+					/// <param name="maxBytesInMemory">
+					/// The limit on the bytes held in memory by every buffer together. Past it,
+					/// any buffer of at least MinSpillSize that grows moves to disk.
+					/// </param>
+					static void SetLimits(const size_t spillThreshold, const uint64_t maxBytesInMemory);
+
+					/// <summary>
+					/// Gets the payload bytes held by every spill buffer.
+					/// </summary>
+					static SpillBufferStats GetStats();
+
+					SpillBuffer();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					SpillBuffer(const SpillBuffer&) = delete;
+					SpillBuffer(SpillBuffer&&) = delete;
+					SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+					/// <summary>
+					/// Default destructor. Closes, and so removes, the temp file if any.
+					/// </summary>
+					~SpillBuffer();
+
+					/// <summary>
+					/// Replaces the contents with the supplied vector. The vector's storage is
+					/// taken as is, unless it's large enough to belong on disk.
+					/// </summary>
+					SpillBuffer& operator=(std::vector<char>&& other);
+
+					char* data()
+					{
+						return m_view != nullptr ? m_view : m_memory.data();
+					}
+
+					const char* data() const
+					{
+						return m_view != nullptr ? m_view : m_memory.data();
+					}
+
+					const size_t size() const
+					{
+						return m_view != nullptr ? m_size : m_memory.size();
+					}
+
+					const bool empty() const
+					{
+						return size() == 0;
+					}
+
+					const size_t capacity() const
+					{
+						return m_view != nullptr ? m_viewCapacity : m_memory.capacity();
+					}
+
+					const char* begin() const
+					{
+						return data();
+					}
+
+					const char* end() const
+					{
+						return data() + size();
+					}
+
+					/// <summary>
+					/// Whether the contents are presently in a mapped temp file.
+					/// </summary>
+					const bool IsSpilled() const
+					{
+						return m_view != nullptr;
+					}
+
+					/// <summary>
+					/// Makes room for at least the supplied number of bytes. Grows geometrically,
+					/// so appending piece by piece costs amortized constant time per byte.
+					/// </summary>
+					void reserve(const size_t required);
+
+					/// <summary>
+					/// Empties the buffer. A buffer in memory keeps its capacity, a buffer on
+					/// disk closes its temp file and goes back to memory.
+					/// </summary>
+					void clear();
+
+					void push_back(const char value)
+					{
+						append(&value, 1);
+					}
+
+					void append(const char* data, const size_t length);
+
+					void assign(const char* first, const char* last);
+
+					/// <summary>
+					/// Exchanges contents with the supplied buffer, wherever either one is held.
+					/// </summary>
+					void swap(SpillBuffer& other);
+
+				private:
+
+					/// <summary>
+					/// Whether growing to the supplied capacity should move the contents to disk.
+					/// </summary>
+					const bool ShouldSpill(const size_t capacity) const;
+
+					/// <summary>
+					/// Moves the contents to a new temp file of the supplied capacity. Leaves
+					/// them where they are when that fails.
+					/// </summary>
+					const bool Spill(const size_t capacity);
+
+					/// <summary>
+					/// Sizes the temp file to the supplied capacity and maps all of it.
+					/// </summary>
+					const bool Map(const size_t capacity);
+
+					const bool IsFileOpen() const;
+
+					void Unmap();
+
+					void CloseFile();
+
+					/// <summary>
+					/// Brings the memory total in line with what m_memory holds now.
+					/// </summary>
+					void AccountMemory();
+
+					static std::atomic<size_t> s_spillThreshold;
+
+					static std::atomic<uint64_t> s_maxBytesInMemory;
+
+					static std::atomic<uint64_t> s_bytesInMemory;
+
+					static std::atomic<uint64_t> s_bytesOnDisk;
+
+					static std::atomic<uint64_t> s_spills;
+
+					static std::atomic<uint64_t> s_spillFailures;
+
+					/// <summary>
+					/// The contents, while not on disk.
+					/// </summary>
+					std::vector<char> m_memory;
+
+					/// <summary>
+					/// How much of m_memory is counted in s_bytesInMemory.
+					/// </summary>
+					size_t m_accounted = 0;
+
+					/// <summary>
+					/// The mapped view of the temp file. Null while the contents are in memory.
+					/// </summary>
+					char* m_view = nullptr;
+
+					size_t m_viewCapacity = 0;
+
+					size_t m_size = 0;
+
+					#if BOOST_OS_WINDOWS
+					void* m_file = nullptr;
+
+					void* m_mapping = nullptr;
+					#else
+					int m_file = -1;
+					#endif
+
+				};
+
+			} /* namespace mem */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
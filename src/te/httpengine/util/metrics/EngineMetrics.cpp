@@ -0,0 +1,261 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "EngineMetrics.hpp"
+
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace metrics
+			{
+
+				const uint64_t HistogramSnapshot::GetPercentile(const double percentile) const
+				{
+					if (Count == 0)
+					{
+						return 0;
+					}
+
+					const double clamped = (std::min)((std::max)(percentile, 0.0), 100.0);
+					const uint64_t rank = (std::max)(static_cast<uint64_t>(static_cast<double>(Count) * clamped / 100.0 + 0.5), static_cast<uint64_t>(1));
+
+					uint64_t seen = 0;
+
+					for (size_t i = 0; i < HistogramBucketCount; ++i)
+					{
+						seen += Buckets[i];
+
+						if (seen >= rank)
+						{
+							const uint64_t upperBound = i == 0 ? 0 : (static_cast<uint64_t>(1) << i) - 1;
+							return (std::min)(upperBound, MaxMicroseconds);
+						}
+					}
+
+					return MaxMicroseconds;
+				}
+
+				EngineMetrics& EngineMetrics::Shared()
+				{
+					static EngineMetrics metrics;
+					return metrics;
+				}
+
+				EngineMetrics::EngineMetrics()
+				{
+
+				}
+
+				EngineMetrics::~EngineMetrics()
+				{
+
+				}
+
+				EngineMetrics::Shard::Shard()
+				{
+					for (size_t stage = 0; stage < StageCount; ++stage)
+					{
+						for (size_t bucket = 0; bucket < HistogramBucketCount; ++bucket)
+						{
+							buckets[stage][bucket].store(0, std::memory_order_relaxed);
+						}
+
+						totals[stage].store(0, std::memory_order_relaxed);
+						maxima[stage].store(0, std::memory_order_relaxed);
+					}
+
+					for (size_t counter = 0; counter < CounterCount; ++counter)
+					{
+						counters[counter].store(0, std::memory_order_relaxed);
+					}
+				}
+
+				EngineMetrics::ThreadShard::ThreadShard()
+					:
+					shard(new Shard())
+				{
+					// Getting the shared instance here makes sure it's built before, and so
+					// destroyed after, this thread_local.
+					auto& metrics = EngineMetrics::Shared();
+
+					std::lock_guard<std::mutex> lock(metrics.m_shardsMutex);
+					metrics.m_shards.push_back(shard);
+				}
+
+				EngineMetrics::ThreadShard::~ThreadShard()
+				{
+					auto& metrics = EngineMetrics::Shared();
+
+					{
+						std::lock_guard<std::mutex> lock(metrics.m_shardsMutex);
+
+						Accumulate(*shard, metrics.m_retired);
+
+						metrics.m_shards.erase(std::remove(metrics.m_shards.begin(), metrics.m_shards.end(), shard), metrics.m_shards.end());
+					}
+
+					delete shard;
+				}
+
+				EngineMetrics::Shard& EngineMetrics::LocalShard()
+				{
+					static thread_local ThreadShard local;
+					return *local.shard;
+				}
+
+				const size_t EngineMetrics::BucketOf(const uint64_t microseconds)
+				{
+					size_t bucket = 0;
+					uint64_t remaining = microseconds;
+
+					while (remaining != 0 && bucket < HistogramBucketCount - 1)
+					{
+						remaining >>= 1;
+						++bucket;
+					}
+
+					return bucket;
+				}
+
+				void EngineMetrics::Record(const Stage stage, const Clock::duration elapsed)
+				{
+					const size_t stageIndex = static_cast<size_t>(stage);
+
+					if (stageIndex >= StageCount)
+					{
+						return;
+					}
+
+					const int64_t elapsedMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+					const uint64_t microseconds = elapsedMicroseconds > 0 ? static_cast<uint64_t>(elapsedMicroseconds) : 0;
+
+					auto& shard = LocalShard();
+
+					// Only this thread ever writes to its shard, so there's no need to pay for
+					// atomic increments.
+					auto& bucket = shard.buckets[stageIndex][BucketOf(microseconds)];
+					bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+					auto& total = shard.totals[stageIndex];
+					total.store(total.load(std::memory_order_relaxed) + microseconds, std::memory_order_relaxed);
+
+					auto& maximum = shard.maxima[stageIndex];
+
+					if (microseconds > maximum.load(std::memory_order_relaxed))
+					{
+						maximum.store(microseconds, std::memory_order_relaxed);
+					}
+				}
+
+				void EngineMetrics::Increment(const Counter counter, const uint64_t amount)
+				{
+					const size_t counterIndex = static_cast<size_t>(counter);
+
+					if (counterIndex >= CounterCount)
+					{
+						return;
+					}
+
+					auto& value = LocalShard().counters[counterIndex];
+					value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+				}
+
+				MetricsSnapshot EngineMetrics::GetSnapshot() const
+				{
+					std::lock_guard<std::mutex> lock(m_shardsMutex);
+
+					MetricsSnapshot snapshot = m_retired;
+
+					for (const auto shard : m_shards)
+					{
+						Accumulate(*shard, snapshot);
+					}
+
+					return snapshot;
+				}
+
+				const char* EngineMetrics::GetStageName(const Stage stage)
+				{
+					switch (stage)
+					{
+						case Stage::CertificateMint:
+							return u8"certificate_mint";
+						case Stage::UpstreamResolve:
+							return u8"upstream_resolve";
+						case Stage::UpstreamConnect:
+							return u8"upstream_connect";
+						case Stage::UpstreamHandshake:
+							return u8"upstream_handshake";
+						case Stage::DownstreamHandshake:
+							return u8"downstream_handshake";
+						case Stage::MessageBeginCallback:
+							return u8"message_begin_callback";
+						case Stage::MessageEndCallback:
+							return u8"message_end_callback";
+						case Stage::PayloadBuffering:
+							return u8"payload_buffering";
+						case Stage::PayloadDecompression:
+							return u8"payload_decompression";
+						default:
+							return u8"unknown";
+					}
+				}
+
+				const char* EngineMetrics::GetCounterName(const Counter counter)
+				{
+					switch (counter)
+					{
+						case Counter::CertificateCacheHits:
+							return u8"certificate_cache_hits";
+						case Counter::CertificateCacheMisses:
+							return u8"certificate_cache_misses";
+						case Counter::BridgesOpened:
+							return u8"bridges_opened";
+						case Counter::BridgesClosed:
+							return u8"bridges_closed";
+						case Counter::EncodedPayloadsForwarded:
+							return u8"encoded_payloads_forwarded";
+						case Counter::RuleVerdicts:
+							return u8"rule_verdicts";
+						default:
+							return u8"unknown";
+					}
+				}
+
+				void EngineMetrics::Accumulate(const Shard& shard, MetricsSnapshot& snapshot)
+				{
+					for (size_t stage = 0; stage < StageCount; ++stage)
+					{
+						auto& histogram = snapshot.Stages[stage];
+
+						for (size_t bucket = 0; bucket < HistogramBucketCount; ++bucket)
+						{
+							const uint64_t count = shard.buckets[stage][bucket].load(std::memory_order_relaxed);
+
+							histogram.Buckets[bucket] += count;
+							histogram.Count += count;
+						}
+
+						histogram.TotalMicroseconds += shard.totals[stage].load(std::memory_order_relaxed);
+						histogram.MaxMicroseconds = (std::max)(histogram.MaxMicroseconds, shard.maxima[stage].load(std::memory_order_relaxed));
+					}
+
+					for (size_t counter = 0; counter < CounterCount; ++counter)
+					{
+						snapshot.Counters[counter] += shard.counters[counter].load(std::memory_order_relaxed);
+					}
+				}
+
+			} /* namespace metrics */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
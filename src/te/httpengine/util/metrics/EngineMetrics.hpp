@@ -0,0 +1,381 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace metrics
+			{
+
+				/// <summary>
+				/// The stages of the Engine whose durations are kept in histograms.
+				/// </summary>
+				enum class Stage : uint32_t
+				{
+					/// <summary>
+					/// Generating a spoofed certificate and server context for a host.
+					/// </summary>
+					CertificateMint = 0,
+
+					/// <summary>
+					/// Finding the endpoint of an upstream host, whether through the resolver or
+					/// not.
+					/// </summary>
+					UpstreamResolve,
+
+					/// <summary>
+					/// Connecting to an upstream host.
+					/// </summary>
+					UpstreamConnect,
+
+					/// <summary>
+					/// The TLS handshake with an upstream host.
+					/// </summary>
+					UpstreamHandshake,
+
+					/// <summary>
+					/// The TLS handshake with a client.
+					/// </summary>
+					DownstreamHandshake,
+
+					/// <summary>
+					/// Time spent inside the host's message begin callback.
+					/// </summary>
+					MessageBeginCallback,
+
+					/// <summary>
+					/// Time spent inside the host's message end callback.
+					/// </summary>
+					MessageEndCallback,
+
+					/// <summary>
+					/// From the end of the headers of a message, up to the end of its payload,
+					/// for messages whose payload is held back until it's complete.
+					/// </summary>
+					PayloadBuffering,
+
+					/// <summary>
+					/// Decompressing a payload, or a part of one.
+					/// </summary>
+					PayloadDecompression,
+
+					Count
+				};
+
+				/// <summary>
+				/// The plain counters of the Engine.
+				/// </summary>
+				enum class Counter : uint32_t
+				{
+					/// <summary>
+					/// Server contexts found already spoofed for the host.
+					/// </summary>
+					CertificateCacheHits = 0,
+
+					/// <summary>
+					/// Server contexts that had to be generated, or waited on while another
+					/// handshake generated them.
+					/// </summary>
+					CertificateCacheMisses,
+
+					/// <summary>
+					/// Bridges constructed.
+					/// </summary>
+					BridgesOpened,
+
+					/// <summary>
+					/// Bridges destroyed.
+					/// </summary>
+					BridgesClosed,
+
+					/// <summary>
+					/// Payloads decoded for inspection, then written as they were received since
+					/// nothing about them changed.
+					/// </summary>
+					EncodedPayloadsForwarded,
+
+					/// <summary>
+					/// Messages decided by the rule table, without a callback.
+					/// </summary>
+					RuleVerdicts,
+
+					Count
+				};
+
+				static constexpr size_t StageCount = static_cast<size_t>(Stage::Count);
+
+				static constexpr size_t CounterCount = static_cast<size_t>(Counter::Count);
+
+				/// <summary>
+				/// Number of buckets in every histogram. The first holds samples of zero
+				/// microseconds, and every one after it holds samples of at least 2^(i-1) and
+				/// under 2^i microseconds. The last also holds everything longer.
+				/// </summary>
+				static constexpr size_t HistogramBucketCount = 32;
+
+				/// <summary>
+				/// Point in time snapshot of the histogram of a single stage.
+				/// </summary>
+				struct HistogramSnapshot
+				{
+					/// <summary>
+					/// Total number of samples.
+					/// </summary>
+					uint64_t Count = 0;
+
+					/// <summary>
+					/// Sum of every sample, in microseconds.
+					/// </summary>
+					uint64_t TotalMicroseconds = 0;
+
+					/// <summary>
+					/// The longest sample, in microseconds.
+					/// </summary>
+					uint64_t MaxMicroseconds = 0;
+
+					/// <summary>
+					/// Number of samples in each bucket.
+					/// </summary>
+					std::array<uint64_t, HistogramBucketCount> Buckets{};
+
+					/// <summary>
+					/// Estimates the supplied percentile from the buckets.
+					/// </summary>
+					/// <param name="percentile">
+					/// The percentile, from 0 to 100.
+					/// </param>
+					/// <returns>
+					/// The upper bound of the bucket the percentile falls in, in microseconds,
+					/// and never more than the longest sample. Zero when there are no samples.
+					/// </returns>
+					const uint64_t GetPercentile(const double percentile) const;
+				};
+
+				/// <summary>
+				/// Point in time snapshot of every histogram and counter.
+				/// </summary>
+				struct MetricsSnapshot
+				{
+					/// <summary>
+					/// The histogram of each Stage, by its value.
+					/// </summary>
+					std::array<HistogramSnapshot, StageCount> Stages;
+
+					/// <summary>
+					/// The value of each Counter, by its value.
+					/// </summary>
+					std::array<uint64_t, CounterCount> Counters{};
+				};
+
+				/// <summary>
+				/// The EngineMetrics keep latency histograms and counters for the whole
+				/// process. Every thread records into a shard of its own, which it alone writes,
+				/// so recording is a few relaxed loads and stores on memory no other thread is
+				/// writing, without any locks or read-modify-write instructions. Shards are only
+				/// summed when a snapshot is taken. When a thread exits, its shard is folded into
+				/// the totals so that nothing it recorded is lost.
+				/// </summary>
+				class EngineMetrics
+				{
+
+				public:
+
+					using Clock = std::chrono::steady_clock;
+
+					/// <summary>
+					/// Records the time from its construction to its destruction against the
+					/// supplied stage.
+					/// </summary>
+					class ScopedTimer
+					{
+
+					public:
+
+						ScopedTimer(const Stage stage)
+							:
+							m_stage(stage),
+							m_started(Clock::now())
+						{
+
+						}
+
+						/// <summary>
+						/// No copy no move no thx.
+						/// </summary>
+						ScopedTimer(const ScopedTimer&) = delete;
+						ScopedTimer(ScopedTimer&&) = delete;
+						ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+						~ScopedTimer()
+						{
+							EngineMetrics::Shared().RecordSince(m_stage, m_started);
+						}
+
+					private:
+
+						const Stage m_stage;
+
+						const Clock::time_point m_started;
+
+					};
+
+					/// <summary>
+					/// The one instance, shared by the whole process.
+					/// </summary>
+					static EngineMetrics& Shared();
+
+					/// <summary>
+					/// No copy no move no thx.
+					/// </summary>
+					EngineMetrics(const EngineMetrics&) = delete;
+					EngineMetrics(EngineMetrics&&) = delete;
+					EngineMetrics& operator=(const EngineMetrics&) = delete;
+
+					/// <summary>
+					/// Default destructor.
+					/// </summary>
+					~EngineMetrics();
+
+					/// <summary>
+					/// Records the supplied duration against the supplied stage.
+					/// </summary>
+					/// <param name="stage">
+					/// The stage that took the supplied time.
+					/// </param>
+					/// <param name="elapsed">
+					/// The time it took.
+					/// </param>
+					void Record(const Stage stage, const Clock::duration elapsed);
+
+					/// <summary>
+					/// Records the time since the supplied point against the supplied stage.
+					/// </summary>
+					/// <param name="stage">
+					/// The stage that started at the supplied point, and has just finished.
+					/// </param>
+					/// <param name="started">
+					/// When the stage started.
+					/// </param>
+					void RecordSince(const Stage stage, const Clock::time_point started)
+					{
+						Record(stage, Clock::now() - started);
+					}
+
+					/// <summary>
+					/// Adds the supplied amount to the supplied counter.
+					/// </summary>
+					/// <param name="counter">
+					/// The counter to add to.
+					/// </param>
+					/// <param name="amount">
+					/// The amount to add.
+					/// </param>
+					void Increment(const Counter counter, const uint64_t amount = 1);
+
+					/// <summary>
+					/// Sums the shards of every thread into a snapshot.
+					/// </summary>
+					/// <returns>
+					/// The current histograms and counters.
+					/// </returns>
+					MetricsSnapshot GetSnapshot() const;
+
+					/// <summary>
+					/// Gets the name under which the supplied stage is exported.
+					/// </summary>
+					static const char* GetStageName(const Stage stage);
+
+					/// <summary>
+					/// Gets the name under which the supplied counter is exported.
+					/// </summary>
+					static const char* GetCounterName(const Counter counter);
+
+				private:
+
+					/// <summary>
+					/// The histograms and counters of one thread. Atomic only so that snapshots
+					/// can read them while the thread writes.
+					/// </summary>
+					struct Shard
+					{
+						std::atomic_uint64_t buckets[StageCount][HistogramBucketCount];
+
+						std::atomic_uint64_t totals[StageCount];
+
+						std::atomic_uint64_t maxima[StageCount];
+
+						std::atomic_uint64_t counters[CounterCount];
+
+						Shard();
+					};
+
+					/// <summary>
+					/// Registers the shard of a thread when the thread first records something,
+					/// and folds it into the retired totals when the thread exits.
+					/// </summary>
+					struct ThreadShard
+					{
+						Shard* shard;
+
+						ThreadShard();
+
+						~ThreadShard();
+					};
+
+					/// <summary>
+					/// Private, use ::Shared().
+					/// </summary>
+					EngineMetrics();
+
+					/// <summary>
+					/// Gets the shard of the calling thread.
+					/// </summary>
+					static Shard& LocalShard();
+
+					/// <summary>
+					/// Gets the bucket that the supplied sample falls in.
+					/// </summary>
+					static const size_t BucketOf(const uint64_t microseconds);
+
+					/// <summary>
+					/// Adds the supplied shard to the supplied snapshot.
+					/// </summary>
+					static void Accumulate(const Shard& shard, MetricsSnapshot& snapshot);
+
+					/// <summary>
+					/// Guards m_shards and m_retired.
+					/// </summary>
+					mutable std::mutex m_shardsMutex;
+
+					/// <summary>
+					/// The shards of every live thread that has recorded something.
+					/// </summary>
+					std::vector<Shard*> m_shards;
+
+					/// <summary>
+					/// Everything recorded by threads that have since exited.
+					/// </summary>
+					MetricsSnapshot m_retired;
+
+				};
+
+			} /* namespace metrics */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
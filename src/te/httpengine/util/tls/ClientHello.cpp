@@ -0,0 +1,289 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "ClientHello.hpp"
+
+#include <algorithm>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace tls
+			{
+
+				namespace
+				{
+					static constexpr uint8_t HandshakeContentType = 22;
+
+					static constexpr uint8_t ClientHelloHandshakeType = 1;
+
+					static constexpr uint16_t ServerNameExtensionType = 0;
+
+					static constexpr uint16_t AlpnExtensionType = 16;
+
+					static constexpr uint8_t HostNameType = 0;
+
+					/// <summary>
+					/// Reads a single byte as unsigned. The peek buffer is char, which is signed
+					/// on the compilers we build with.
+					/// </summary>
+					inline const uint8_t ReadUint8(const char* data, const size_t position)
+					{
+						return static_cast<uint8_t>(data[position]);
+					}
+
+					inline const uint16_t ReadUint16(const char* data, const size_t position)
+					{
+						return static_cast<uint16_t>((ReadUint8(data, position) << 8) | ReadUint8(data, position + 1));
+					}
+
+					/// <summary>
+					/// Finds where the extensions of a client hello start and end. The end is
+					/// where the hello declares it, which may be past the supplied bytes.
+					/// </summary>
+					/// <returns>
+					/// True if the hello has extensions. Otherwise, status is set to why not, with
+					/// a hello that has none at all reported as NoServerName.
+					/// </returns>
+					const bool FindExtensions(const char* data, const size_t length, size_t& position, size_t& extensionsEnd, ClientHelloStatus& status)
+					{
+						if (data == nullptr || length <= MinClientHelloLength)
+						{
+							status = ClientHelloStatus::Truncated;
+							return false;
+						}
+
+						const uint8_t contentType = ReadUint8(data, 0);
+						const uint8_t versionMajor = ReadUint8(data, 1);
+						const uint8_t versionMinor = ReadUint8(data, 2);
+						const uint8_t handshakeType = ReadUint8(data, 5);
+
+						if (versionMajor != 3 || versionMinor == 0)
+						{
+							status = ClientHelloStatus::NotTls;
+							return false;
+						}
+
+						if (contentType != HandshakeContentType || handshakeType != ClientHelloHandshakeType)
+						{
+							status = ClientHelloStatus::NotClientHello;
+							return false;
+						}
+
+						position = MinClientHelloLength;
+
+						// Session ID.
+						position += 1 + ReadUint8(data, position);
+
+						if (position + 2 > length)
+						{
+							status = ClientHelloStatus::Truncated;
+							return false;
+						}
+
+						// Cipher suites.
+						position += 2 + ReadUint16(data, position);
+
+						if (position + 1 > length)
+						{
+							status = ClientHelloStatus::Truncated;
+							return false;
+						}
+
+						// Compression methods.
+						position += 1 + ReadUint8(data, position);
+
+						if (position == length)
+						{
+							// A hello is allowed to end here, without any extensions at all.
+							status = ClientHelloStatus::NoServerName;
+							return false;
+						}
+
+						if (position + 2 > length)
+						{
+							status = ClientHelloStatus::Truncated;
+							return false;
+						}
+
+						extensionsEnd = position + 2 + ReadUint16(data, position);
+						position += 2;
+
+						return true;
+					}
+
+					/// <summary>
+					/// Walks the protocols offered in the ALPN extension of a client hello, looking
+					/// for the supplied one.
+					/// </summary>
+					/// <param name="offered">
+					/// Set to whether the protocol is among those offered.
+					/// </param>
+					/// <param name="count">
+					/// Set to the number of protocols walked.
+					/// </param>
+					/// <returns>
+					/// True if the whole list was within the supplied bytes, so that what was
+					/// found is all that the client offers. False otherwise, or if there's no list.
+					/// </returns>
+					const bool ScanProtocols(const char* data, const size_t length, boost::string_ref protocol, bool& offered, size_t& count)
+					{
+						offered = false;
+						count = 0;
+
+						size_t position = 0;
+						size_t extensionsEnd = 0;
+						ClientHelloStatus status = ClientHelloStatus::Truncated;
+
+						if (!FindExtensions(data, length, position, extensionsEnd, status))
+						{
+							return false;
+						}
+
+						const size_t end = (std::min)(extensionsEnd, length);
+
+						while (position + 4 <= end)
+						{
+							const uint16_t extensionType = ReadUint16(data, position);
+							const size_t extensionLength = ReadUint16(data, position + 2);
+
+							position += 4;
+
+							if (extensionType != AlpnExtensionType)
+							{
+								position += extensionLength;
+								continue;
+							}
+
+							if (position + 2 > end)
+							{
+								return false;
+							}
+
+							const size_t declaredListEnd = position + 2 + ReadUint16(data, position);
+							const size_t listEnd = (std::min)(declaredListEnd, end);
+							position += 2;
+
+							while (position + 1 <= listEnd)
+							{
+								const size_t nameLength = ReadUint8(data, position);
+
+								position += 1;
+
+								if (position + nameLength > listEnd)
+								{
+									return false;
+								}
+
+								++count;
+
+								if (boost::string_ref(data + position, nameLength) == protocol)
+								{
+									offered = true;
+								}
+
+								position += nameLength;
+							}
+
+							// There's only ever one ALPN extension.
+							return declaredListEnd <= end;
+						}
+
+						return false;
+					}
+				}
+
+				const ClientHelloStatus FindServerName(const char* data, const size_t length, boost::string_ref& serverName)
+				{
+					size_t position = 0;
+					size_t extensionsEnd = 0;
+					ClientHelloStatus status = ClientHelloStatus::Truncated;
+
+					if (!FindExtensions(data, length, position, extensionsEnd, status))
+					{
+						return status;
+					}
+
+					// The peek may not have caught every extension. Whatever did make it in is
+					// still worth looking through.
+					const size_t end = (std::min)(extensionsEnd, length);
+
+					while (position + 4 <= end)
+					{
+						const uint16_t extensionType = ReadUint16(data, position);
+						const size_t extensionLength = ReadUint16(data, position + 2);
+
+						position += 4;
+
+						if (extensionType != ServerNameExtensionType)
+						{
+							position += extensionLength;
+							continue;
+						}
+
+						if (position + 2 > end)
+						{
+							return ClientHelloStatus::Truncated;
+						}
+
+						const size_t declaredListEnd = position + 2 + ReadUint16(data, position);
+						const size_t listEnd = (std::min)(declaredListEnd, end);
+						position += 2;
+
+						while (position + 3 <= listEnd)
+						{
+							const uint8_t nameType = ReadUint8(data, position);
+							const size_t nameLength = ReadUint16(data, position + 1);
+
+							position += 3;
+
+							if (position + nameLength > listEnd)
+							{
+								return ClientHelloStatus::Truncated;
+							}
+
+							if (nameType == HostNameType && nameLength > 0)
+							{
+								serverName = boost::string_ref(data + position, nameLength);
+								return ClientHelloStatus::ServerNameFound;
+							}
+
+							position += nameLength;
+						}
+
+						// There's only ever one SNI extension.
+						return declaredListEnd > end ? ClientHelloStatus::Truncated : ClientHelloStatus::NoServerName;
+					}
+
+					return extensionsEnd > length ? ClientHelloStatus::Truncated : ClientHelloStatus::NoServerName;
+				}
+
+				const bool OffersProtocol(const char* data, const size_t length, boost::string_ref protocol)
+				{
+					bool offered = false;
+					size_t count = 0;
+
+					ScanProtocols(data, length, protocol, offered, count);
+
+					return offered;
+				}
+
+				const bool OffersOtherProtocolsOnly(const char* data, const size_t length, boost::string_ref protocol)
+				{
+					bool offered = false;
+					size_t count = 0;
+
+					return ScanProtocols(data, length, protocol, offered, count) && !offered && count > 0;
+				}
+
+			} /* namespace tls */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -0,0 +1,129 @@
+/*
+* Copyright  2017 Jesse Nicholson
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/utility/string_ref.hpp>
+
+namespace te
+{
+	namespace httpengine
+	{
+		namespace util
+		{
+			namespace tls
+			{
+
+				/// <summary>
+				/// The number of bytes from the start of a TLS record holding a client hello up to
+				/// its session ID length. That's the record header, the handshake header, the
+				/// client version and the client random. Anything shorter can't be a client hello
+				/// we could do anything with.
+				/// </summary>
+				static constexpr size_t MinClientHelloLength = 43;
+
+				/// <summary>
+				/// The outcome of looking for the server name in a client hello.
+				/// </summary>
+				enum class ClientHelloStatus : uint32_t
+				{
+					/// <summary>
+					/// The hello carries a host name in its SNI extension.
+					/// </summary>
+					ServerNameFound = 0,
+
+					/// <summary>
+					/// The bytes aren't the start of a TLS record.
+					/// </summary>
+					NotTls,
+
+					/// <summary>
+					/// The record isn't a handshake record holding a client hello.
+					/// </summary>
+					NotClientHello,
+
+					/// <summary>
+					/// The hello is complete up to its extensions, but none of them is a host
+					/// name.
+					/// </summary>
+					NoServerName,
+
+					/// <summary>
+					/// The hello is cut short, or some length in it points past the supplied
+					/// bytes.
+					/// </summary>
+					Truncated
+				};
+
+				/// <summary>
+				/// Finds the host name a client asks for in the SNI extension of its hello, so
+				/// that it can be connected to before handshaking with the client. Only ever
+				/// reads within the supplied bytes.
+				///
+				/// Multibyte numbers are big-endian, as per RFC 5246 section 4.4. The host name is
+				/// a UTF-8 byte string without a trailing dot, as per RFC 6066 section 3.
+				/// </summary>
+				/// <param name="data">
+				/// The bytes peeked from the client, starting at the TLS record header.
+				/// </param>
+				/// <param name="length">
+				/// The number of bytes peeked.
+				/// </param>
+				/// <param name="serverName">
+				/// Set to the host name within the supplied bytes, if found.
+				/// </param>
+				/// <returns>
+				/// What was found.
+				/// </returns>
+				const ClientHelloStatus FindServerName(const char* data, const size_t length, boost::string_ref& serverName);
+
+				/// <summary>
+				/// Finds whether a client offers the supplied protocol in the ALPN extension of
+				/// its hello, as per RFC 7301. Only ever reads within the supplied bytes, so a
+				/// hello cut short may offer more than it is found to.
+				/// </summary>
+				/// <param name="data">
+				/// The bytes peeked from the client, starting at the TLS record header.
+				/// </param>
+				/// <param name="length">
+				/// The number of bytes peeked.
+				/// </param>
+				/// <param name="protocol">
+				/// The protocol identifier, such as "http/1.1".
+				/// </param>
+				/// <returns>
+				/// True if the protocol is among those offered, false otherwise.
+				/// </returns>
+				const bool OffersProtocol(const char* data, const size_t length, boost::string_ref protocol);
+
+				/// <summary>
+				/// Finds whether a client offers protocols in the ALPN extension of its hello,
+				/// none of them the supplied one. Only ever true for a list that is wholly within
+				/// the supplied bytes, so a hello cut short can't be mistaken for one that
+				/// leaves the protocol out.
+				/// </summary>
+				/// <param name="data">
+				/// The bytes peeked from the client, starting at the TLS record header.
+				/// </param>
+				/// <param name="length">
+				/// The number of bytes peeked.
+				/// </param>
+				/// <param name="protocol">
+				/// The protocol identifier, such as "http/1.1".
+				/// </param>
+				/// <returns>
+				/// True if protocols are offered and the supplied one isn't among them, false
+				/// otherwise.
+				/// </returns>
+				const bool OffersOtherProtocolsOnly(const char* data, const size_t length, boost::string_ref protocol);
+
+			} /* namespace tls */
+		} /* namespace util */
+	} /* namespace httpengine */
+} /* namespace te */
@@ -26,7 +26,10 @@
 * summaries and definitions.
 */
 
+#include <cstdint>
 #include <string>
+#include <boost/utility/string_ref.hpp>
+#include "../../httpengine/util/hash/StringHashUtils.hpp"
 
 namespace te
 {
@@ -39,13 +42,82 @@ namespace te
 				namespace headers
 				{
 
+					/// <summary>
+					/// Case insensitive hash of a header name. Header names are ASCII tokens, so
+					/// only ASCII letters are folded. See util::hash::ICaseHash(...).
+					/// </summary>
+					/// <param name="name">
+					/// The header name.
+					/// </param>
+					/// <param name="length">
+					/// The length of the header name.
+					/// </param>
+					/// <returns>
+					/// The hash of the name, the same for any casing of it.
+					/// </returns>
+					constexpr uint32_t HashName(const char* name, const size_t length)
+					{
+						return hash::ICaseHash(name, length);
+					}
+
+					/// <summary>
+					/// The name of a well known header, along with its hash, which is computed at
+					/// compile time, so that looking up a known header in a transaction doesn't
+					/// have to hash the name every time. Converts to the plain name wherever a
+					/// string is wanted.
+					/// </summary>
+					class KnownHeader
+					{
+
+					public:
+
+						template<size_t N>
+						constexpr KnownHeader(const char(&name)[N])
+							:
+							m_name(name),
+							m_length(N - 1),
+							m_hash(HashName(name, N - 1))
+						{
+
+						}
+
+						operator std::string() const
+						{
+							return std::string(m_name, m_length);
+						}
+
+						operator boost::string_ref() const
+						{
+							return Name();
+						}
+
+						boost::string_ref Name() const
+						{
+							return boost::string_ref(m_name, m_length);
+						}
+
+						constexpr uint32_t Hash() const
+						{
+							return m_hash;
+						}
+
+					private:
+
+						const char* m_name;
+
+						size_t m_length;
+
+						uint32_t m_hash;
+
+					};
+
 					/// <summary>
 					/// Header Name: A-IM
 					/// Protocol: HTTP
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>					
-					const std::string AIM{ u8"A-IM" };
+					constexpr KnownHeader AIM{ u8"A-IM" };
 
 					/// <summary>
 					/// Header Name: Accept
@@ -53,7 +125,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.3.2]
 					/// </summary>
-					const std::string Accept{ u8"Accept" };
+					constexpr KnownHeader Accept{ u8"Accept" };
 
 					/// <summary>
 					/// Header Name: Accept-Additions
@@ -61,7 +133,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string AcceptAdditions{ u8"Accept-Additions" };
+					constexpr KnownHeader AcceptAdditions{ u8"Accept-Additions" };
 
 					/// <summary>
 					/// Header Name: Accept-Charset
@@ -69,7 +141,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.3.3]
 					/// </summary>
-					const std::string AcceptCharset{ u8"Accept-Charset" };
+					constexpr KnownHeader AcceptCharset{ u8"Accept-Charset" };
 
 					/// <summary>
 					/// Header Name: Accept-Datetime
@@ -77,7 +149,7 @@ namespace te
 					/// Status: Informational
 					/// Defined In: [RFC7089]
 					/// </summary>
-					const std::string AcceptDatetime{ u8"Accept-Datetime" };
+					constexpr KnownHeader AcceptDatetime{ u8"Accept-Datetime" };
 
 					/// <summary>
 					/// Header Name: Accept-Encoding
@@ -85,7 +157,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.3.4][RFC-ietf-httpbis-cice-03, Section 3]
 					/// </summary>
-					const std::string AcceptEncoding{ u8"Accept-Encoding" };
+					constexpr KnownHeader AcceptEncoding{ u8"Accept-Encoding" };
 
 					/// <summary>
 					/// Header Name: Accept-Features
@@ -93,7 +165,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string AcceptFeatures{ u8"Accept-Features" };
+					constexpr KnownHeader AcceptFeatures{ u8"Accept-Features" };
 
 					/// <summary>
 					/// Header Name: Accept-Language
@@ -101,7 +173,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.3.5]
 					/// </summary>
-					const std::string AcceptLanguage{ u8"Accept-Language" };
+					constexpr KnownHeader AcceptLanguage{ u8"Accept-Language" };
 
 					/// <summary>
 					/// Header Name: Accept-Patch
@@ -109,7 +181,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC5789]
 					/// </summary>
-					const std::string AcceptPatch{ u8"Accept-Patch" };
+					constexpr KnownHeader AcceptPatch{ u8"Accept-Patch" };
 
 					/// <summary>
 					/// Header Name: Accept-Ranges
@@ -117,7 +189,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7233, Section 2.3]
 					/// </summary>
-					const std::string AcceptRanges{ u8"Accept-Ranges" };
+					constexpr KnownHeader AcceptRanges{ u8"Accept-Ranges" };
 
 					/// <summary>
 					/// Header Name: Access-Control
@@ -125,7 +197,7 @@ namespace te
 					/// Status: deprecated
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControl{ u8"Access-Control" };
+					constexpr KnownHeader AccessControl{ u8"Access-Control" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Allow-Credentials
@@ -133,7 +205,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlAllowCredentials{ u8"Access-Control-Allow-Credentials" };
+					constexpr KnownHeader AccessControlAllowCredentials{ u8"Access-Control-Allow-Credentials" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Allow-Headers
@@ -141,7 +213,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlAllowHeaders{ u8"Access-Control-Allow-Headers" };
+					constexpr KnownHeader AccessControlAllowHeaders{ u8"Access-Control-Allow-Headers" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Allow-Methods
@@ -149,7 +221,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlAllowMethods{ u8"Access-Control-Allow-Methods" };
+					constexpr KnownHeader AccessControlAllowMethods{ u8"Access-Control-Allow-Methods" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Allow-Origin
@@ -157,7 +229,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlAllowOrigin{ u8"Access-Control-Allow-Origin" };
+					constexpr KnownHeader AccessControlAllowOrigin{ u8"Access-Control-Allow-Origin" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Max-Age
@@ -165,7 +237,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlMaxAge{ u8"Access-Control-Max-Age" };
+					constexpr KnownHeader AccessControlMaxAge{ u8"Access-Control-Max-Age" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Request-Headers
@@ -173,7 +245,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlRequestHeaders{ u8"Access-Control-Request-Headers" };
+					constexpr KnownHeader AccessControlRequestHeaders{ u8"Access-Control-Request-Headers" };
 
 					/// <summary>
 					/// Header Name: Access-Control-Request-Method
@@ -181,7 +253,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string AccessControlRequestMethod{ u8"Access-Control-Request-Method" };
+					constexpr KnownHeader AccessControlRequestMethod{ u8"Access-Control-Request-Method" };
 
 					/// <summary>
 					/// Header Name: Age
@@ -189,7 +261,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7234, Section 5.1]
 					/// </summary>
-					const std::string Age{ u8"Age" };
+					constexpr KnownHeader Age{ u8"Age" };
 
 					/// <summary>
 					/// Header Name: Allow
@@ -197,7 +269,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.4.1]
 					/// </summary>
-					const std::string Allow{ u8"Allow" };
+					constexpr KnownHeader Allow{ u8"Allow" };
 
 					/// <summary>
 					/// Header Name: ALPN
@@ -205,7 +277,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7639, Section 2]
 					/// </summary>
-					const std::string ALPN{ u8"ALPN" };
+					constexpr KnownHeader ALPN{ u8"ALPN" };
 
 					/// <summary>
 					/// Header Name: Alternates
@@ -213,7 +285,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Alternates{ u8"Alternates" };
+					constexpr KnownHeader Alternates{ u8"Alternates" };
 
 					/// <summary>
 					/// Header Name: Apply-To-Redirect-Ref
@@ -221,7 +293,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4437]
 					/// </summary>
-					const std::string ApplyToRedirectRef{ u8"Apply-To-Redirect-Ref" };
+					constexpr KnownHeader ApplyToRedirectRef{ u8"Apply-To-Redirect-Ref" };
 
 					/// <summary>
 					/// Header Name: Authentication-Info
@@ -229,7 +301,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7615, Section 3]
 					/// </summary>
-					const std::string AuthenticationInfo{ u8"Authentication-Info" };
+					constexpr KnownHeader AuthenticationInfo{ u8"Authentication-Info" };
 
 					/// <summary>
 					/// Header Name: Authorization
@@ -237,7 +309,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7235, Section 4.2]
 					/// </summary>
-					const std::string Authorization{ u8"Authorization" };
+					constexpr KnownHeader Authorization{ u8"Authorization" };
 
 					/// <summary>
 					/// Header Name: Base
@@ -245,7 +317,7 @@ namespace te
 					/// Status: obsoleted
 					/// Defined In: [RFC1808][RFC2068 Section 14.11]
 					/// </summary>
-					const std::string Base{ u8"Base" };
+					constexpr KnownHeader Base{ u8"Base" };
 
 					/// <summary>
 					/// Header Name: Body
@@ -253,7 +325,7 @@ namespace te
 					/// Status: reserved
 					/// Defined In: [RFC6068]
 					/// </summary>
-					const std::string Body{ u8"Body" };
+					constexpr KnownHeader Body{ u8"Body" };
 
 					/// <summary>
 					/// Header Name: C-Ext
@@ -261,7 +333,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string CExt{ u8"C-Ext" };
+					constexpr KnownHeader CExt{ u8"C-Ext" };
 
 					/// <summary>
 					/// Header Name: C-Man
@@ -269,7 +341,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string CMan{ u8"C-Man" };
+					constexpr KnownHeader CMan{ u8"C-Man" };
 
 					/// <summary>
 					/// Header Name: C-Opt
@@ -277,7 +349,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string COpt{ u8"C-Opt" };
+					constexpr KnownHeader COpt{ u8"C-Opt" };
 
 					/// <summary>
 					/// Header Name: C-PEP
@@ -285,7 +357,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string CPEP{ u8"C-PEP" };
+					constexpr KnownHeader CPEP{ u8"C-PEP" };
 
 					/// <summary>
 					/// Header Name: C-PEP-Info
@@ -293,7 +365,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string CPEPInfo{ u8"C-PEP-Info" };
+					constexpr KnownHeader CPEPInfo{ u8"C-PEP-Info" };
 
 					/// <summary>
 					/// Header Name: Cache-Control
@@ -301,7 +373,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7234, Section 5.2]
 					/// </summary>
-					const std::string CacheControl{ u8"Cache-Control" };
+					constexpr KnownHeader CacheControl{ u8"Cache-Control" };
 
 					/// <summary>
 					/// Header Name: CalDAV-Timezones
@@ -309,7 +381,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC-ietf-tzdist-caldav-timezone-ref-05, Section 7.1]
 					/// </summary>
-					const std::string CalDAVTimezones{ u8"CalDAV-Timezones" };
+					constexpr KnownHeader CalDAVTimezones{ u8"CalDAV-Timezones" };
 
 					/// <summary>
 					/// Header Name: Close
@@ -317,7 +389,7 @@ namespace te
 					/// Status: reserved
 					/// Defined In: [RFC7230, Section 8.1]
 					/// </summary>
-					const std::string Close{ u8"Close" };
+					constexpr KnownHeader Close{ u8"Close" };
 
 					/// <summary>
 					/// Header Name: Compliance
@@ -325,7 +397,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Compliance{ u8"Compliance" };
+					constexpr KnownHeader Compliance{ u8"Compliance" };
 
 					/// <summary>
 					/// Header Name: Connection
@@ -333,7 +405,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 6.1]
 					/// </summary>
-					const std::string Connection{ u8"Connection" };
+					constexpr KnownHeader Connection{ u8"Connection" };
 
 					/// <summary>
 					/// Header Name: Content-Alternative
@@ -341,7 +413,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4021]
 					/// </summary>
-					const std::string ContentAlternative{ u8"Content-Alternative" };
+					constexpr KnownHeader ContentAlternative{ u8"Content-Alternative" };
 
 					/// <summary>
 					/// Header Name: Content-Base
@@ -349,7 +421,7 @@ namespace te
 					/// Status: obsoleted
 					/// Defined In: [RFC2068][RFC2616]
 					/// </summary>
-					const std::string ContentBase{ u8"Content-Base" };
+					constexpr KnownHeader ContentBase{ u8"Content-Base" };
 
 					/// <summary>
 					/// Header Name: Content-Description
@@ -357,7 +429,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4021]
 					/// </summary>
-					const std::string ContentDescription{ u8"Content-Description" };
+					constexpr KnownHeader ContentDescription{ u8"Content-Description" };
 
 					/// <summary>
 					/// Header Name: Content-Disposition
@@ -365,7 +437,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6266]
 					/// </summary>
-					const std::string ContentDisposition{ u8"Content-Disposition" };
+					constexpr KnownHeader ContentDisposition{ u8"Content-Disposition" };
 
 					/// <summary>
 					/// Header Name: Content-Duration
@@ -373,7 +445,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4021]
 					/// </summary>
-					const std::string ContentDuration{ u8"Content-Duration" };
+					constexpr KnownHeader ContentDuration{ u8"Content-Duration" };
 
 					/// <summary>
 					/// Header Name: Content-Encoding
@@ -381,7 +453,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 3.1.2.2]
 					/// </summary>
-					const std::string ContentEncoding{ u8"Content-Encoding" };
+					constexpr KnownHeader ContentEncoding{ u8"Content-Encoding" };
 
 					/// <summary>
 					/// Header Name: Content-features
@@ -389,7 +461,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4021]
 					/// </summary>
-					const std::string Contentfeatures{ u8"Content-features" };
+					constexpr KnownHeader Contentfeatures{ u8"Content-features" };
 
 					/// <summary>
 					/// Header Name: Content-ID
@@ -397,7 +469,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentID{ u8"Content-ID" };
+					constexpr KnownHeader ContentID{ u8"Content-ID" };
 
 					/// <summary>
 					/// Header Name: Content-Language
@@ -405,7 +477,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 3.1.3.2]
 					/// </summary>
-					const std::string ContentLanguage{ u8"Content-Language" };
+					constexpr KnownHeader ContentLanguage{ u8"Content-Language" };
 
 					/// <summary>
 					/// Header Name: Content-Length
@@ -413,7 +485,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 3.3.2]
 					/// </summary>
-					const std::string ContentLength{ u8"Content-Length" };
+					constexpr KnownHeader ContentLength{ u8"Content-Length" };
 
 					/// <summary>
 					/// Header Name: Content-Location
@@ -421,7 +493,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 3.1.4.2]
 					/// </summary>
-					const std::string ContentLocation{ u8"Content-Location" };
+					constexpr KnownHeader ContentLocation{ u8"Content-Location" };
 
 					/// <summary>
 					/// Header Name: Content-MD5
@@ -429,7 +501,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentMD5{ u8"Content-MD5" };
+					constexpr KnownHeader ContentMD5{ u8"Content-MD5" };
 
 					/// <summary>
 					/// Header Name: Content-Range
@@ -437,7 +509,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7233, Section 4.2]
 					/// </summary>
-					const std::string ContentRange{ u8"Content-Range" };
+					constexpr KnownHeader ContentRange{ u8"Content-Range" };
 
 					/// <summary>
 					/// Header Name: Content-Script-Type
@@ -445,7 +517,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentScriptType{ u8"Content-Script-Type" };
+					constexpr KnownHeader ContentScriptType{ u8"Content-Script-Type" };
 
 					/// <summary>
 					/// Header Name: Content-Style-Type
@@ -453,7 +525,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentStyleType{ u8"Content-Style-Type" };
+					constexpr KnownHeader ContentStyleType{ u8"Content-Style-Type" };
 
 					/// <summary>
 					/// Header Name: Content-Transfer-Encoding
@@ -461,7 +533,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentTransferEncoding{ u8"Content-Transfer-Encoding" };
+					constexpr KnownHeader ContentTransferEncoding{ u8"Content-Transfer-Encoding" };
 
 					/// <summary>
 					/// Header Name: Content-Type
@@ -469,7 +541,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 3.1.1.5]
 					/// </summary>
-					const std::string ContentType{ u8"Content-Type" };
+					constexpr KnownHeader ContentType{ u8"Content-Type" };
 
 					/// <summary>
 					/// Header Name: Content-Version
@@ -477,7 +549,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ContentVersion{ u8"Content-Version" };
+					constexpr KnownHeader ContentVersion{ u8"Content-Version" };
 
 					/// <summary>
 					/// Header Name: Cookie
@@ -485,7 +557,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6265]
 					/// </summary>
-					const std::string Cookie{ u8"Cookie" };
+					constexpr KnownHeader Cookie{ u8"Cookie" };
 
 					/// <summary>
 					/// Header Name: Cookie2
@@ -493,7 +565,7 @@ namespace te
 					/// Status: obsoleted
 					/// Defined In: [RFC2965][RFC6265]
 					/// </summary>
-					const std::string Cookie2{ u8"Cookie2" };
+					constexpr KnownHeader Cookie2{ u8"Cookie2" };
 
 					/// <summary>
 					/// Header Name: Cost
@@ -501,7 +573,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Cost{ u8"Cost" };
+					constexpr KnownHeader Cost{ u8"Cost" };
 
 					/// <summary>
 					/// Header Name: DASL
@@ -509,7 +581,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC5323]
 					/// </summary>
-					const std::string DASL{ u8"DASL" };
+					constexpr KnownHeader DASL{ u8"DASL" };
 
 					/// <summary>
 					/// Header Name: Date
@@ -517,7 +589,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.1.1.2]
 					/// </summary>
-					const std::string Date{ u8"Date" };
+					constexpr KnownHeader Date{ u8"Date" };
 
 					/// <summary>
 					/// Header Name: DAV
@@ -525,7 +597,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string DAV{ u8"DAV" };
+					constexpr KnownHeader DAV{ u8"DAV" };
 
 					/// <summary>
 					/// Header Name: Default-Style
@@ -533,7 +605,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string DefaultStyle{ u8"Default-Style" };
+					constexpr KnownHeader DefaultStyle{ u8"Default-Style" };
 
 					/// <summary>
 					/// Header Name: Delta-Base
@@ -541,7 +613,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string DeltaBase{ u8"Delta-Base" };
+					constexpr KnownHeader DeltaBase{ u8"Delta-Base" };
 
 					/// <summary>
 					/// Header Name: Depth
@@ -549,7 +621,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string Depth{ u8"Depth" };
+					constexpr KnownHeader Depth{ u8"Depth" };
 
 					/// <summary>
 					/// Header Name: Derived-From
@@ -557,7 +629,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string DerivedFrom{ u8"Derived-From" };
+					constexpr KnownHeader DerivedFrom{ u8"Derived-From" };
 
 					/// <summary>
 					/// Header Name: Destination
@@ -565,7 +637,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string Destination{ u8"Destination" };
+					constexpr KnownHeader Destination{ u8"Destination" };
 
 					/// <summary>
 					/// Header Name: Differential-ID
@@ -573,7 +645,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string DifferentialID{ u8"Differential-ID" };
+					constexpr KnownHeader DifferentialID{ u8"Differential-ID" };
 
 					/// <summary>
 					/// Header Name: Digest
@@ -581,7 +653,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Digest{ u8"Digest" };
+					constexpr KnownHeader Digest{ u8"Digest" };
 
 					/// <summary>
 					/// Header Name: EDIINT-Features
@@ -589,7 +661,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC6017]
 					/// </summary>
-					const std::string EDIINTFeatures{ u8"EDIINT-Features" };
+					constexpr KnownHeader EDIINTFeatures{ u8"EDIINT-Features" };
 
 					/// <summary>
 					/// Header Name: ETag
@@ -597,7 +669,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 2.3]
 					/// </summary>
-					const std::string ETag{ u8"ETag" };
+					constexpr KnownHeader ETag{ u8"ETag" };
 
 					/// <summary>
 					/// Header Name: Expect
@@ -605,7 +677,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.1.1]
 					/// </summary>
-					const std::string Expect{ u8"Expect" };
+					constexpr KnownHeader Expect{ u8"Expect" };
 
 					/// <summary>
 					/// Header Name: Expires
@@ -613,7 +685,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7234, Section 5.3]
 					/// </summary>
-					const std::string Expires{ u8"Expires" };
+					constexpr KnownHeader Expires{ u8"Expires" };
 
 					/// <summary>
 					/// Header Name: Ext
@@ -621,7 +693,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Ext{ u8"Ext" };
+					constexpr KnownHeader Ext{ u8"Ext" };
 
 					/// <summary>
 					/// Header Name: Forwarded
@@ -629,7 +701,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7239]
 					/// </summary>
-					const std::string Forwarded{ u8"Forwarded" };
+					constexpr KnownHeader Forwarded{ u8"Forwarded" };
 
 					/// <summary>
 					/// Header Name: From
@@ -637,7 +709,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.5.1]
 					/// </summary>
-					const std::string From{ u8"From" };
+					constexpr KnownHeader From{ u8"From" };
 
 					/// <summary>
 					/// Header Name: GetProfile
@@ -645,7 +717,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string GetProfile{ u8"GetProfile" };
+					constexpr KnownHeader GetProfile{ u8"GetProfile" };
 
 					/// <summary>
 					/// Header Name: Hobareg
@@ -653,7 +725,7 @@ namespace te
 					/// Status: experimental
 					/// Defined In: [RFC7486, Section 6.1.1]
 					/// </summary>
-					const std::string Hobareg{ u8"Hobareg" };
+					constexpr KnownHeader Hobareg{ u8"Hobareg" };
 
 					/// <summary>
 					/// Header Name: Host
@@ -661,7 +733,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 5.4]
 					/// </summary>
-					const std::string Host{ u8"Host" };
+					constexpr KnownHeader Host{ u8"Host" };
 
 					/// <summary>
 					/// Header Name: HTTP2-Settings
@@ -669,7 +741,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7540, Section 3.2.1]
 					/// </summary>
-					const std::string HTTP2Settings{ u8"HTTP2-Settings" };
+					constexpr KnownHeader HTTP2Settings{ u8"HTTP2-Settings" };
 
 					/// <summary>
 					/// Header Name: If
@@ -677,7 +749,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string If{ u8"If" };
+					constexpr KnownHeader If{ u8"If" };
 
 					/// <summary>
 					/// Header Name: If-Match
@@ -685,7 +757,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 3.1]
 					/// </summary>
-					const std::string IfMatch{ u8"If-Match" };
+					constexpr KnownHeader IfMatch{ u8"If-Match" };
 
 					/// <summary>
 					/// Header Name: If-Modified-Since
@@ -693,7 +765,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 3.3]
 					/// </summary>
-					const std::string IfModifiedSince{ u8"If-Modified-Since" };
+					constexpr KnownHeader IfModifiedSince{ u8"If-Modified-Since" };
 
 					/// <summary>
 					/// Header Name: If-None-Match
@@ -701,7 +773,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 3.2]
 					/// </summary>
-					const std::string IfNoneMatch{ u8"If-None-Match" };
+					constexpr KnownHeader IfNoneMatch{ u8"If-None-Match" };
 
 					/// <summary>
 					/// Header Name: If-Range
@@ -709,7 +781,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7233, Section 3.2]
 					/// </summary>
-					const std::string IfRange{ u8"If-Range" };
+					constexpr KnownHeader IfRange{ u8"If-Range" };
 
 					/// <summary>
 					/// Header Name: If-Schedule-Tag-Match
@@ -717,7 +789,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6638]
 					/// </summary>
-					const std::string IfScheduleTagMatch{ u8"If-Schedule-Tag-Match" };
+					constexpr KnownHeader IfScheduleTagMatch{ u8"If-Schedule-Tag-Match" };
 
 					/// <summary>
 					/// Header Name: If-Unmodified-Since
@@ -725,7 +797,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 3.4]
 					/// </summary>
-					const std::string IfUnmodifiedSince{ u8"If-Unmodified-Since" };
+					constexpr KnownHeader IfUnmodifiedSince{ u8"If-Unmodified-Since" };
 
 					/// <summary>
 					/// Header Name: IM
@@ -733,7 +805,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string IM{ u8"IM" };
+					constexpr KnownHeader IM{ u8"IM" };
 
 					/// <summary>
 					/// Header Name: Keep-Alive
@@ -741,7 +813,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string KeepAlive{ u8"Keep-Alive" };
+					constexpr KnownHeader KeepAlive{ u8"Keep-Alive" };
 
 					/// <summary>
 					/// Header Name: Label
@@ -749,7 +821,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Label{ u8"Label" };
+					constexpr KnownHeader Label{ u8"Label" };
 
 					/// <summary>
 					/// Header Name: Last-Modified
@@ -757,7 +829,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7232, Section 2.2]
 					/// </summary>
-					const std::string LastModified{ u8"Last-Modified" };
+					constexpr KnownHeader LastModified{ u8"Last-Modified" };
 
 					/// <summary>
 					/// Header Name: Link
@@ -765,7 +837,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC5988]
 					/// </summary>
-					const std::string Link{ u8"Link" };
+					constexpr KnownHeader Link{ u8"Link" };
 
 					/// <summary>
 					/// Header Name: Location
@@ -773,7 +845,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.1.2]
 					/// </summary>
-					const std::string Location{ u8"Location" };
+					constexpr KnownHeader Location{ u8"Location" };
 
 					/// <summary>
 					/// Header Name: Lock-Token
@@ -781,7 +853,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string LockToken{ u8"Lock-Token" };
+					constexpr KnownHeader LockToken{ u8"Lock-Token" };
 
 					/// <summary>
 					/// Header Name: Man
@@ -789,7 +861,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Man{ u8"Man" };
+					constexpr KnownHeader Man{ u8"Man" };
 
 					/// <summary>
 					/// Header Name: Max-Forwards
@@ -797,7 +869,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.1.2]
 					/// </summary>
-					const std::string MaxForwards{ u8"Max-Forwards" };
+					constexpr KnownHeader MaxForwards{ u8"Max-Forwards" };
 
 					/// <summary>
 					/// Header Name: Memento-Datetime
@@ -805,7 +877,7 @@ namespace te
 					/// Status: Informational
 					/// Defined In: [RFC7089]
 					/// </summary>
-					const std::string MementoDatetime{ u8"Memento-Datetime" };
+					constexpr KnownHeader MementoDatetime{ u8"Memento-Datetime" };
 
 					/// <summary>
 					/// Header Name: Message-ID
@@ -813,7 +885,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string MessageID{ u8"Message-ID" };
+					constexpr KnownHeader MessageID{ u8"Message-ID" };
 
 					/// <summary>
 					/// Header Name: Meter
@@ -821,7 +893,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Meter{ u8"Meter" };
+					constexpr KnownHeader Meter{ u8"Meter" };
 
 					/// <summary>
 					/// Header Name: Method-Check
@@ -829,7 +901,7 @@ namespace te
 					/// Status: deprecated
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string MethodCheck{ u8"Method-Check" };
+					constexpr KnownHeader MethodCheck{ u8"Method-Check" };
 
 					/// <summary>
 					/// Header Name: Method-Check-Expires
@@ -837,7 +909,7 @@ namespace te
 					/// Status: deprecated
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string MethodCheckExpires{ u8"Method-Check-Expires" };
+					constexpr KnownHeader MethodCheckExpires{ u8"Method-Check-Expires" };
 
 					/// <summary>
 					/// Header Name: MIME-Version
@@ -845,7 +917,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Appendix A.1]
 					/// </summary>
-					const std::string MIMEVersion{ u8"MIME-Version" };
+					constexpr KnownHeader MIMEVersion{ u8"MIME-Version" };
 
 					/// <summary>
 					/// Header Name: Negotiate
@@ -853,7 +925,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Negotiate{ u8"Negotiate" };
+					constexpr KnownHeader Negotiate{ u8"Negotiate" };
 
 					/// <summary>
 					/// Header Name: Non-Compliance
@@ -861,7 +933,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string NonCompliance{ u8"Non-Compliance" };
+					constexpr KnownHeader NonCompliance{ u8"Non-Compliance" };
 
 					/// <summary>
 					/// Header Name: Opt
@@ -869,7 +941,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Opt{ u8"Opt" };
+					constexpr KnownHeader Opt{ u8"Opt" };
 
 					/// <summary>
 					/// Header Name: Optional
@@ -877,7 +949,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Optional{ u8"Optional" };
+					constexpr KnownHeader Optional{ u8"Optional" };
 
 					/// <summary>
 					/// Header Name: Ordering-Type
@@ -885,7 +957,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string OrderingType{ u8"Ordering-Type" };
+					constexpr KnownHeader OrderingType{ u8"Ordering-Type" };
 
 					/// <summary>
 					/// Header Name: Origin
@@ -893,7 +965,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6454]
 					/// </summary>
-					const std::string Origin{ u8"Origin" };
+					constexpr KnownHeader Origin{ u8"Origin" };
 
 					/// <summary>
 					/// Header Name: Overwrite
@@ -901,7 +973,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string Overwrite{ u8"Overwrite" };
+					constexpr KnownHeader Overwrite{ u8"Overwrite" };
 
 					/// <summary>
 					/// Header Name: P3P
@@ -909,7 +981,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string P3P{ u8"P3P" };
+					constexpr KnownHeader P3P{ u8"P3P" };
 
 					/// <summary>
 					/// Header Name: PEP
@@ -917,7 +989,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string PEP{ u8"PEP" };
+					constexpr KnownHeader PEP{ u8"PEP" };
 
 					/// <summary>
 					/// Header Name: Pep-Info
@@ -925,7 +997,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string PepInfo{ u8"Pep-Info" };
+					constexpr KnownHeader PepInfo{ u8"Pep-Info" };
 
 					/// <summary>
 					/// Header Name: PICS-Label
@@ -933,7 +1005,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string PICSLabel{ u8"PICS-Label" };
+					constexpr KnownHeader PICSLabel{ u8"PICS-Label" };
 
 					/// <summary>
 					/// Header Name: Position
@@ -941,7 +1013,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Position{ u8"Position" };
+					constexpr KnownHeader Position{ u8"Position" };
 
 					/// <summary>
 					/// Header Name: Pragma
@@ -949,7 +1021,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7234, Section 5.4]
 					/// </summary>
-					const std::string Pragma{ u8"Pragma" };
+					constexpr KnownHeader Pragma{ u8"Pragma" };
 
 					/// <summary>
 					/// Header Name: Prefer
@@ -957,7 +1029,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7240]
 					/// </summary>
-					const std::string Prefer{ u8"Prefer" };
+					constexpr KnownHeader Prefer{ u8"Prefer" };
 
 					/// <summary>
 					/// Header Name: Preference-Applied
@@ -965,7 +1037,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7240]
 					/// </summary>
-					const std::string PreferenceApplied{ u8"Preference-Applied" };
+					constexpr KnownHeader PreferenceApplied{ u8"Preference-Applied" };
 
 					/// <summary>
 					/// Header Name: ProfileObject
@@ -973,7 +1045,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProfileObject{ u8"ProfileObject" };
+					constexpr KnownHeader ProfileObject{ u8"ProfileObject" };
 
 					/// <summary>
 					/// Header Name: Protocol
@@ -981,7 +1053,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Protocol{ u8"Protocol" };
+					constexpr KnownHeader Protocol{ u8"Protocol" };
 
 					/// <summary>
 					/// Header Name: Protocol-Info
@@ -989,7 +1061,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProtocolInfo{ u8"Protocol-Info" };
+					constexpr KnownHeader ProtocolInfo{ u8"Protocol-Info" };
 
 					/// <summary>
 					/// Header Name: Protocol-Query
@@ -997,7 +1069,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProtocolQuery{ u8"Protocol-Query" };
+					constexpr KnownHeader ProtocolQuery{ u8"Protocol-Query" };
 
 					/// <summary>
 					/// Header Name: Protocol-Request
@@ -1005,7 +1077,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProtocolRequest{ u8"Protocol-Request" };
+					constexpr KnownHeader ProtocolRequest{ u8"Protocol-Request" };
 
 					/// <summary>
 					/// Header Name: Proxy-Authenticate
@@ -1013,7 +1085,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7235, Section 4.3]
 					/// </summary>
-					const std::string ProxyAuthenticate{ u8"Proxy-Authenticate" };
+					constexpr KnownHeader ProxyAuthenticate{ u8"Proxy-Authenticate" };
 
 					/// <summary>
 					/// Header Name: Proxy-Authentication-Info
@@ -1021,7 +1093,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7615, Section 4]
 					/// </summary>
-					const std::string ProxyAuthenticationInfo{ u8"Proxy-Authentication-Info" };
+					constexpr KnownHeader ProxyAuthenticationInfo{ u8"Proxy-Authentication-Info" };
 
 					/// <summary>
 					/// Header Name: Proxy-Authorization
@@ -1029,7 +1101,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7235, Section 4.4]
 					/// </summary>
-					const std::string ProxyAuthorization{ u8"Proxy-Authorization" };
+					constexpr KnownHeader ProxyAuthorization{ u8"Proxy-Authorization" };
 
 					/// <summary>
 					/// Header Name: Proxy-Features
@@ -1037,7 +1109,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProxyFeatures{ u8"Proxy-Features" };
+					constexpr KnownHeader ProxyFeatures{ u8"Proxy-Features" };
 
 					/// <summary>
 					/// Header Name: Proxy-Instruction
@@ -1045,7 +1117,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ProxyInstruction{ u8"Proxy-Instruction" };
+					constexpr KnownHeader ProxyInstruction{ u8"Proxy-Instruction" };
 
 					/// <summary>
 					/// Header Name: Public
@@ -1053,7 +1125,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Public{ u8"Public" };
+					constexpr KnownHeader Public{ u8"Public" };
 
 					/// <summary>
 					/// Header Name: Public-Key-Pins
@@ -1061,7 +1133,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7469]
 					/// </summary>
-					const std::string PublicKeyPins{ u8"Public-Key-Pins" };
+					constexpr KnownHeader PublicKeyPins{ u8"Public-Key-Pins" };
 
 					/// <summary>
 					/// Header Name: Public-Key-Pins-Report-Only
@@ -1069,7 +1141,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7469]
 					/// </summary>
-					const std::string PublicKeyPinsReportOnly{ u8"Public-Key-Pins-Report-Only" };
+					constexpr KnownHeader PublicKeyPinsReportOnly{ u8"Public-Key-Pins-Report-Only" };
 
 					/// <summary>
 					/// Header Name: Range
@@ -1077,7 +1149,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7233, Section 3.1]
 					/// </summary>
-					const std::string Range{ u8"Range" };
+					constexpr KnownHeader Range{ u8"Range" };
 
 					/// <summary>
 					/// Header Name: Redirect-Ref
@@ -1085,7 +1157,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4437]
 					/// </summary>
-					const std::string RedirectRef{ u8"Redirect-Ref" };
+					constexpr KnownHeader RedirectRef{ u8"Redirect-Ref" };
 
 					/// <summary>
 					/// Header Name: Referer
@@ -1093,7 +1165,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.5.2]
 					/// </summary>
-					const std::string Referer{ u8"Referer" };
+					constexpr KnownHeader Referer{ u8"Referer" };
 
 					/// <summary>
 					/// Header Name: Referer-Root
@@ -1101,7 +1173,7 @@ namespace te
 					/// Status: deprecated
 					/// Defined In: [W3C Web Application Formats Working Group]
 					/// </summary>
-					const std::string RefererRoot{ u8"Referer-Root" };
+					constexpr KnownHeader RefererRoot{ u8"Referer-Root" };
 
 					/// <summary>
 					/// Header Name: Resolution-Hint
@@ -1109,7 +1181,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ResolutionHint{ u8"Resolution-Hint" };
+					constexpr KnownHeader ResolutionHint{ u8"Resolution-Hint" };
 
 					/// <summary>
 					/// Header Name: Resolver-Location
@@ -1117,7 +1189,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string ResolverLocation{ u8"Resolver-Location" };
+					constexpr KnownHeader ResolverLocation{ u8"Resolver-Location" };
 
 					/// <summary>
 					/// Header Name: Retry-After
@@ -1125,7 +1197,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.1.3]
 					/// </summary>
-					const std::string RetryAfter{ u8"Retry-After" };
+					constexpr KnownHeader RetryAfter{ u8"Retry-After" };
 
 					/// <summary>
 					/// Header Name: Safe
@@ -1133,7 +1205,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Safe{ u8"Safe" };
+					constexpr KnownHeader Safe{ u8"Safe" };
 
 					/// <summary>
 					/// Header Name: Schedule-Reply
@@ -1141,7 +1213,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6638]
 					/// </summary>
-					const std::string ScheduleReply{ u8"Schedule-Reply" };
+					constexpr KnownHeader ScheduleReply{ u8"Schedule-Reply" };
 
 					/// <summary>
 					/// Header Name: Schedule-Tag
@@ -1149,7 +1221,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6638]
 					/// </summary>
-					const std::string ScheduleTag{ u8"Schedule-Tag" };
+					constexpr KnownHeader ScheduleTag{ u8"Schedule-Tag" };
 
 					/// <summary>
 					/// Header Name: Sec-WebSocket-Accept
@@ -1157,7 +1229,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6455]
 					/// </summary>
-					const std::string SecWebSocketAccept{ u8"Sec-WebSocket-Accept" };
+					constexpr KnownHeader SecWebSocketAccept{ u8"Sec-WebSocket-Accept" };
 
 					/// <summary>
 					/// Header Name: Sec-WebSocket-Extensions
@@ -1165,7 +1237,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6455]
 					/// </summary>
-					const std::string SecWebSocketExtensions{ u8"Sec-WebSocket-Extensions" };
+					constexpr KnownHeader SecWebSocketExtensions{ u8"Sec-WebSocket-Extensions" };
 
 					/// <summary>
 					/// Header Name: Sec-WebSocket-Key
@@ -1173,7 +1245,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6455]
 					/// </summary>
-					const std::string SecWebSocketKey{ u8"Sec-WebSocket-Key" };
+					constexpr KnownHeader SecWebSocketKey{ u8"Sec-WebSocket-Key" };
 
 					/// <summary>
 					/// Header Name: Sec-WebSocket-Protocol
@@ -1181,7 +1253,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6455]
 					/// </summary>
-					const std::string SecWebSocketProtocol{ u8"Sec-WebSocket-Protocol" };
+					constexpr KnownHeader SecWebSocketProtocol{ u8"Sec-WebSocket-Protocol" };
 
 					/// <summary>
 					/// Header Name: Sec-WebSocket-Version
@@ -1189,7 +1261,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6455]
 					/// </summary>
-					const std::string SecWebSocketVersion{ u8"Sec-WebSocket-Version" };
+					constexpr KnownHeader SecWebSocketVersion{ u8"Sec-WebSocket-Version" };
 
 					/// <summary>
 					/// Header Name: Security-Scheme
@@ -1197,7 +1269,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SecurityScheme{ u8"Security-Scheme" };
+					constexpr KnownHeader SecurityScheme{ u8"Security-Scheme" };
 
 					/// <summary>
 					/// Header Name: Server
@@ -1205,7 +1277,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.4.2]
 					/// </summary>
-					const std::string Server{ u8"Server" };
+					constexpr KnownHeader Server{ u8"Server" };
 
 					/// <summary>
 					/// Header Name: Set-Cookie
@@ -1213,7 +1285,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6265]
 					/// </summary>
-					const std::string SetCookie{ u8"Set-Cookie" };
+					constexpr KnownHeader SetCookie{ u8"Set-Cookie" };
 
 					/// <summary>
 					/// Header Name: Set-Cookie2
@@ -1221,7 +1293,7 @@ namespace te
 					/// Status: obsoleted
 					/// Defined In: [RFC2965][RFC6265]
 					/// </summary>
-					const std::string SetCookie2{ u8"Set-Cookie2" };
+					constexpr KnownHeader SetCookie2{ u8"Set-Cookie2" };
 
 					/// <summary>
 					/// Header Name: SetProfile
@@ -1229,7 +1301,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SetProfile{ u8"SetProfile" };
+					constexpr KnownHeader SetProfile{ u8"SetProfile" };
 
 					/// <summary>
 					/// Header Name: SLUG
@@ -1237,7 +1309,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC5023]
 					/// </summary>
-					const std::string SLUG{ u8"SLUG" };
+					constexpr KnownHeader SLUG{ u8"SLUG" };
 
 					/// <summary>
 					/// Header Name: SoapAction
@@ -1245,7 +1317,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SoapAction{ u8"SoapAction" };
+					constexpr KnownHeader SoapAction{ u8"SoapAction" };
 
 					/// <summary>
 					/// Header Name: Status-URI
@@ -1253,7 +1325,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string StatusURI{ u8"Status-URI" };
+					constexpr KnownHeader StatusURI{ u8"Status-URI" };
 
 					/// <summary>
 					/// Header Name: Strict-Transport-Security
@@ -1261,7 +1333,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC6797]
 					/// </summary>
-					const std::string StrictTransportSecurity{ u8"Strict-Transport-Security" };
+					constexpr KnownHeader StrictTransportSecurity{ u8"Strict-Transport-Security" };
 
 					/// <summary>
 					/// Header Name: SubOK
@@ -1269,7 +1341,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SubOK{ u8"SubOK" };
+					constexpr KnownHeader SubOK{ u8"SubOK" };
 
 					/// <summary>
 					/// Header Name: Subst
@@ -1277,7 +1349,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Subst{ u8"Subst" };
+					constexpr KnownHeader Subst{ u8"Subst" };
 
 					/// <summary>
 					/// Header Name: Surrogate-Capability
@@ -1285,7 +1357,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SurrogateCapability{ u8"Surrogate-Capability" };
+					constexpr KnownHeader SurrogateCapability{ u8"Surrogate-Capability" };
 
 					/// <summary>
 					/// Header Name: Surrogate-Control
@@ -1293,7 +1365,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string SurrogateControl{ u8"Surrogate-Control" };
+					constexpr KnownHeader SurrogateControl{ u8"Surrogate-Control" };
 
 					/// <summary>
 					/// Header Name: TCN
@@ -1301,7 +1373,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string TCN{ u8"TCN" };
+					constexpr KnownHeader TCN{ u8"TCN" };
 
 					/// <summary>
 					/// Header Name: TE
@@ -1309,7 +1381,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 4.3]
 					/// </summary>
-					const std::string TE{ u8"TE" };
+					constexpr KnownHeader TE{ u8"TE" };
 
 					/// <summary>
 					/// Header Name: Timeout
@@ -1317,7 +1389,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC4918]
 					/// </summary>
-					const std::string Timeout{ u8"Timeout" };
+					constexpr KnownHeader Timeout{ u8"Timeout" };
 
 					/// <summary>
 					/// Header Name: Title
@@ -1325,7 +1397,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Title{ u8"Title" };
+					constexpr KnownHeader Title{ u8"Title" };
 
 					/// <summary>
 					/// Header Name: Trailer
@@ -1333,7 +1405,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 4.4]
 					/// </summary>
-					const std::string Trailer{ u8"Trailer" };
+					constexpr KnownHeader Trailer{ u8"Trailer" };
 
 					/// <summary>
 					/// Header Name: Transfer-Encoding
@@ -1341,7 +1413,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 3.3.1]
 					/// </summary>
-					const std::string TransferEncoding{ u8"Transfer-Encoding" };
+					constexpr KnownHeader TransferEncoding{ u8"Transfer-Encoding" };
 
 					/// <summary>
 					/// Header Name: UA-Color
@@ -1349,7 +1421,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string UAColor{ u8"UA-Color" };
+					constexpr KnownHeader UAColor{ u8"UA-Color" };
 
 					/// <summary>
 					/// Header Name: UA-Media
@@ -1357,7 +1429,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string UAMedia{ u8"UA-Media" };
+					constexpr KnownHeader UAMedia{ u8"UA-Media" };
 
 					/// <summary>
 					/// Header Name: UA-Pixels
@@ -1365,7 +1437,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string UAPixels{ u8"UA-Pixels" };
+					constexpr KnownHeader UAPixels{ u8"UA-Pixels" };
 
 					/// <summary>
 					/// Header Name: UA-Resolution
@@ -1373,7 +1445,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string UAResolution{ u8"UA-Resolution" };
+					constexpr KnownHeader UAResolution{ u8"UA-Resolution" };
 
 					/// <summary>
 					/// Header Name: UA-Windowpixels
@@ -1381,7 +1453,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string UAWindowpixels{ u8"UA-Windowpixels" };
+					constexpr KnownHeader UAWindowpixels{ u8"UA-Windowpixels" };
 
 					/// <summary>
 					/// Header Name: Upgrade
@@ -1389,7 +1461,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 6.7]
 					/// </summary>
-					const std::string Upgrade{ u8"Upgrade" };
+					constexpr KnownHeader Upgrade{ u8"Upgrade" };
 
 					/// <summary>
 					/// Header Name: URI
@@ -1397,7 +1469,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string URI{ u8"URI" };
+					constexpr KnownHeader URI{ u8"URI" };
 
 					/// <summary>
 					/// Header Name: User-Agent
@@ -1405,7 +1477,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 5.5.3]
 					/// </summary>
-					const std::string UserAgent{ u8"User-Agent" };
+					constexpr KnownHeader UserAgent{ u8"User-Agent" };
 
 					/// <summary>
 					/// Header Name: Variant-Vary
@@ -1413,7 +1485,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string VariantVary{ u8"Variant-Vary" };
+					constexpr KnownHeader VariantVary{ u8"Variant-Vary" };
 
 					/// <summary>
 					/// Header Name: Vary
@@ -1421,7 +1493,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7231, Section 7.1.4]
 					/// </summary>
-					const std::string Vary{ u8"Vary" };
+					constexpr KnownHeader Vary{ u8"Vary" };
 
 					/// <summary>
 					/// Header Name: Version
@@ -1429,7 +1501,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string Version{ u8"Version" };
+					constexpr KnownHeader Version{ u8"Version" };
 
 					/// <summary>
 					/// Header Name: Via
@@ -1437,7 +1509,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7230, Section 5.7.1]
 					/// </summary>
-					const std::string Via{ u8"Via" };
+					constexpr KnownHeader Via{ u8"Via" };
 
 					/// <summary>
 					/// Header Name: Want-Digest
@@ -1445,7 +1517,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [RFC4229]
 					/// </summary>
-					const std::string WantDigest{ u8"Want-Digest" };
+					constexpr KnownHeader WantDigest{ u8"Want-Digest" };
 
 					/// <summary>
 					/// Header Name: Warning
@@ -1453,7 +1525,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7234, Section 5.5]
 					/// </summary>
-					const std::string Warning{ u8"Warning" };
+					constexpr KnownHeader Warning{ u8"Warning" };
 
 					/// <summary>
 					/// Header Name: WWW-Authenticate
@@ -1461,7 +1533,7 @@ namespace te
 					/// Status: Standard
 					/// Defined In: [RFC7235, Section 4.1]
 					/// </summary>
-					const std::string WWWAuthenticate{ u8"WWW-Authenticate" };
+					constexpr KnownHeader WWWAuthenticate{ u8"WWW-Authenticate" };
 
 					/// <summary>
 					/// Header Name: X-Device-Accept
@@ -1469,7 +1541,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Mobile Web Best Practices Working Group]
 					/// </summary>
-					const std::string XDeviceAccept{ u8"X-Device-Accept" };
+					constexpr KnownHeader XDeviceAccept{ u8"X-Device-Accept" };
 
 					/// <summary>
 					/// Header Name: X-Device-Accept-Charset
@@ -1477,7 +1549,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Mobile Web Best Practices Working Group]
 					/// </summary>
-					const std::string XDeviceAcceptCharset{ u8"X-Device-Accept-Charset" };
+					constexpr KnownHeader XDeviceAcceptCharset{ u8"X-Device-Accept-Charset" };
 
 					/// <summary>
 					/// Header Name: X-Device-Accept-Encoding
@@ -1485,7 +1557,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Mobile Web Best Practices Working Group]
 					/// </summary>
-					const std::string XDeviceAcceptEncoding{ u8"X-Device-Accept-Encoding" };
+					constexpr KnownHeader XDeviceAcceptEncoding{ u8"X-Device-Accept-Encoding" };
 
 					/// <summary>
 					/// Header Name: X-Device-Accept-Language
@@ -1493,7 +1565,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Mobile Web Best Practices Working Group]
 					/// </summary>
-					const std::string XDeviceAcceptLanguage{ u8"X-Device-Accept-Language" };
+					constexpr KnownHeader XDeviceAcceptLanguage{ u8"X-Device-Accept-Language" };
 
 					/// <summary>
 					/// Header Name: X-Device-User-Agent
@@ -1501,7 +1573,7 @@ namespace te
 					/// Status: Proposed
 					/// Defined In: [W3C Mobile Web Best Practices Working Group]
 					/// </summary>
-					const std::string XDeviceUserAgent{ u8"X-Device-User-Agent" };
+					constexpr KnownHeader XDeviceUserAgent{ u8"X-Device-User-Agent" };
 
 					/// <summary>
 					/// Header Name: X-Frame-Options
@@ -1509,7 +1581,7 @@ namespace te
 					/// Status: Informational
 					/// Defined In: [RFC7034]
 					/// </summary>
-					const std::string XFrameOptions{ u8"X-Frame-Options" };
+					constexpr KnownHeader XFrameOptions{ u8"X-Frame-Options" };
 					// Common but non-standard request headers
 
 					/// <summary>
@@ -1518,7 +1590,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XRequestedWith{ u8"X-Requested-With" };
+					constexpr KnownHeader XRequestedWith{ u8"X-Requested-With" };
 
 					/// <summary>
 					/// Header Name: DNT
@@ -1526,7 +1598,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string DNT{ u8"DNT" };
+					constexpr KnownHeader DNT{ u8"DNT" };
 
 					/// <summary>
 					/// Header Name: X-Forwarded-For
@@ -1534,7 +1606,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XForwardedFor{ u8"X-Forwarded-For" };
+					constexpr KnownHeader XForwardedFor{ u8"X-Forwarded-For" };
 
 					/// <summary>
 					/// Header Name: X-Forwarded-Host
@@ -1542,7 +1614,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XForwardedHost{ u8"X-Forwarded-Host" };
+					constexpr KnownHeader XForwardedHost{ u8"X-Forwarded-Host" };
 
 					/// <summary>
 					/// Header Name: X-Forwarded-Proto
@@ -1550,7 +1622,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XForwardedProto{ u8"X-Forwarded-Proto" };
+					constexpr KnownHeader XForwardedProto{ u8"X-Forwarded-Proto" };
 
 					/// <summary>
 					/// Header Name: Front-End-Https
@@ -1558,7 +1630,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string FrontEndHttps{ u8"Front-End-Https" };
+					constexpr KnownHeader FrontEndHttps{ u8"Front-End-Https" };
 
 					/// <summary>
 					/// Header Name: X-Http-Method-Override
@@ -1566,7 +1638,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XHttpMethodOverride{ u8"X-Http-Method-Override" };
+					constexpr KnownHeader XHttpMethodOverride{ u8"X-Http-Method-Override" };
 
 					/// <summary>
 					/// Header Name: X-ATT-DeviceId
@@ -1574,7 +1646,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XATTDeviceId{ u8"X-ATT-DeviceId" };
+					constexpr KnownHeader XATTDeviceId{ u8"X-ATT-DeviceId" };
 
 					/// <summary>
 					/// Header Name: X-Wap-Profile
@@ -1582,7 +1654,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XWapProfile{ u8"X-Wap-Profile" };
+					constexpr KnownHeader XWapProfile{ u8"X-Wap-Profile" };
 
 					/// <summary>
 					/// Header Name: Proxy-Connection
@@ -1590,7 +1662,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string ProxyConnection{ u8"Proxy-Connection" };
+					constexpr KnownHeader ProxyConnection{ u8"Proxy-Connection" };
 
 					/// <summary>
 					/// Header Name: X-UIDH
@@ -1598,7 +1670,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XUIDH{ u8"X-UIDH" };
+					constexpr KnownHeader XUIDH{ u8"X-UIDH" };
 
 					/// <summary>
 					/// Header Name: X-Csrf-Token
@@ -1606,7 +1678,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XCsrfToken{ u8"X-Csrf-Token" };
+					constexpr KnownHeader XCsrfToken{ u8"X-Csrf-Token" };
 					// Common but non-standard response headers
 
 					/// <summary>
@@ -1615,7 +1687,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XXSSProtection{ u8"X-XSS-Protection" };
+					constexpr KnownHeader XXSSProtection{ u8"X-XSS-Protection" };
 
 					/// <summary>
 					/// Header Name: Content-Security-Policy
@@ -1623,7 +1695,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string ContentSecurityPolicy{ u8"Content-Security-Policy" };
+					constexpr KnownHeader ContentSecurityPolicy{ u8"Content-Security-Policy" };
 
 					/// <summary>
 					/// Header Name: X-Content-Security-Policy
@@ -1631,7 +1703,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XContentSecurityPolicy{ u8"X-Content-Security-Policy" };
+					constexpr KnownHeader XContentSecurityPolicy{ u8"X-Content-Security-Policy" };
 
 					/// <summary>
 					/// Header Name: X-WebKit-CSP
@@ -1639,7 +1711,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XWebKitCSP{ u8"X-WebKit-CSP" };
+					constexpr KnownHeader XWebKitCSP{ u8"X-WebKit-CSP" };
 
 					/// <summary>
 					/// Header Name: X-Content-Type-Options
@@ -1647,7 +1719,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XContentTypeOptions{ u8"X-Content-Type-Options" };
+					constexpr KnownHeader XContentTypeOptions{ u8"X-Content-Type-Options" };
 
 					/// <summary>
 					/// Header Name: X-Powered-By
@@ -1655,7 +1727,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XPoweredBy{ u8"X-Powered-By" };
+					constexpr KnownHeader XPoweredBy{ u8"X-Powered-By" };
 
 					/// <summary>
 					/// Header Name: X-UA-Compatible
@@ -1663,7 +1735,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XUACompatible{ u8"X-UA-Compatible" };
+					constexpr KnownHeader XUACompatible{ u8"X-UA-Compatible" };
 
 					/// <summary>
 					/// Header Name: X-Content-Duration
@@ -1671,7 +1743,7 @@ namespace te
 					/// Status: Non-Standard Common
 					/// Defined In: Nowhereville
 					/// </summary>
-					const std::string XContentDuration{ u8"X-Content-Duration" };
+					constexpr KnownHeader XContentDuration{ u8"X-Content-Duration" };
 
 					/// <summary>
 					/// Header Name: Get-Dictionary
@@ -1679,7 +1751,7 @@ namespace te
 					/// Status: Non-Standard
 					/// Defined In: Made up by Google to support SDHC compression.
 					/// </summary>
-					const std::string GetDictionary{ u8"Get-Dictionary" };
+					constexpr KnownHeader GetDictionary{ u8"Get-Dictionary" };
 
 					/// <summary>
 					/// Header Name: X-SDHC
@@ -1687,7 +1759,7 @@ namespace te
 					/// Status: Non-Standard
 					/// Defined In: Made up by Google to support SDHC compression.
 					/// </summary>
-					const std::string XSDHC{ u8"X-SDHC" };
+					constexpr KnownHeader XSDHC{ u8"X-SDHC" };
 
 					/// <summary>
 					/// Header Name: Avail-Dictionary
@@ -1695,7 +1767,7 @@ namespace te
 					/// Status: Non-Standard
 					/// Defined In: Made up by Google to support SDHC compression.
 					/// </summary>
-					const std::string AvailDictionary{ u8"Avail-Dictionary" };
+					constexpr KnownHeader AvailDictionary{ u8"Avail-Dictionary" };
 
 					/// <summary>
 					/// Header Name: Alternate-Protocol
@@ -1703,7 +1775,7 @@ namespace te
 					/// Status: Non-Standard
 					/// Defined In: Made up by Google to hint to use QUIC over HTTP.
 					/// </summary>
-					const std::string AlternateProtocol{ u8"Alternate-Protocol" };
+					constexpr KnownHeader AlternateProtocol{ u8"Alternate-Protocol" };
 
 					/// <summary>
 					/// Header Name: Alternate-Protocol
@@ -1711,7 +1783,7 @@ namespace te
 					/// Status: Unknown
 					/// Defined In: http://httpwg.org/http-extensions/alt-svc.html
 					/// </summary>
-					const std::string AltSvc{ u8"Alt-Svc" };
+					constexpr KnownHeader AltSvc{ u8"Alt-Svc" };
 
 				} /* namespace headers */
 			} /* namespace http */
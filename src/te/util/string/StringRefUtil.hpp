@@ -14,6 +14,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/utility/string_ref.hpp>
 #include <boost/functional/hash.hpp>
+#include "../../httpengine/util/hash/StringHashUtils.hpp"
 
 namespace te
 {
@@ -123,34 +124,26 @@ namespace te
 				}
 
 				/// <summary>
-				/// Case-insensitive hash implementation for string_ref. Taken from boost docs here:
-				/// http://www.boost.org/doc/libs/1_62_0/doc/html/unordered/hash_equality.html
+				/// Case-insensitive hash implementation for string_ref. ASCII only, see
+				/// util::hash::ICaseHash(...).
 				/// </summary>
 				struct StringRefICaseHash : std::unary_function<boost::string_ref, std::size_t>
 				{
 					size_t operator()(const boost::string_ref strRef) const
 					{
-						std::size_t seed = 0;
-						std::locale locale;
-
-						for (boost::string_ref::const_iterator it = strRef.begin(); it != strRef.end(); ++it)
-						{	
-							boost::hash_combine(seed, std::toupper((*it), locale)); //locale
-						}
-
-						return seed;
+						return hash::ICaseHash(strRef.data(), strRef.size());
 					}
 				};
 
 				/// <summary>
-				/// Case-insensitive equality predicate for string_ref. Taken from boost docs here:
-				/// http://www.boost.org/doc/libs/1_62_0/doc/html/unordered/hash_equality.html
+				/// Case-insensitive equality predicate for string_ref. ASCII only, see
+				/// util::hash::ICaseEquals(...).
 				/// </summary>
 				struct StringRefIEquals : std::binary_function<boost::string_ref, boost::string_ref, bool>
 				{
 					bool operator()(const boost::string_ref lhs, const boost::string_ref rhs) const
 					{
-						return boost::algorithm::iequals(lhs, rhs); //std::locale()
+						return hash::ICaseEquals(lhs, rhs);
 					}
 				};
 